@@ -0,0 +1,90 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "BenchSupport.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+/**
+ * Replaces the global allocation functions so the benchmarks can count heap allocations. Only
+ * the plain and aligned forms are replaced: the array and nothrow forms forward to them. The C
+ * functions are not replaced, only wrapped, for the libraries that let themselves be handed them.
+ */
+
+static std::atomic<uint64_t> allocation_count{0};
+
+uint64_t allocationCount() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+void *operator new(const std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (auto *pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    const auto rounded = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+    if (auto *pointer = std::aligned_alloc(align, rounded)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+
+void *countedMalloc(const std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+
+void *countedCalloc(const std::size_t count, const std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return std::calloc(count, size);
+}
+
+void *countedRealloc(void *pointer, const std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return std::realloc(pointer, size);
+}
+
+void countedFree(void *pointer) {
+    std::free(pointer);
+}
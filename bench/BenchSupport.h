@@ -0,0 +1,310 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BENCH_SUPPORT_H
+#define BENCH_SUPPORT_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Shared plumbing of the benchmark targets: timing, allocation counting, JSON output and
+ * the baseline comparison.
+ *
+ * The JSON is written one result per line, and readResults reads back exactly that layout. That
+ * is enough to diff two runs of the same target without pulling a JSON library into the build.
+ */
+
+/** @brief Measurement of one operation under one pattern at one buffer size. */
+struct BenchResult final {
+    std::string name;       ///< Operation and pattern, e.g. "insert/typing".
+    uint64_t lines;         ///< Line count of the buffer the operation ran on.
+    uint64_t iterations;    ///< Number of operations timed.
+    double ns_per_op;       ///< Mean wall time of one operation, in nanoseconds.
+    double allocs_per_op;   ///< Mean number of heap allocations of one operation.
+};
+
+/** @brief Options shared by every benchmark target. */
+struct BenchOptions final {
+    uint64_t max_lines = 1'000'000;          ///< Largest buffer size measured.
+    std::optional<std::string> output;       ///< File receiving the JSON; stdout when absent.
+    std::optional<std::string> baseline;     ///< Earlier JSON output to compare against.
+    double threshold = 0.10;                 ///< Relative slowdown past which a result is flagged.
+};
+
+/**
+ * @brief Returns the number of heap allocations made by the process so far.
+ *
+ * Implemented by bench/AllocationCounter.cpp, which replaces the global operator new; sample it
+ * around a measured loop.
+ */
+[[nodiscard]] uint64_t allocationCount();
+
+/**
+ * @brief The C allocation functions, counted like operator new.
+ *
+ * Also implemented by bench/AllocationCounter.cpp, for the C libraries that take their allocator
+ * as function pointers, like tree-sitter through ts_set_allocator. A realloc counts as one
+ * allocation, as the vector growth it stands for would.
+ */
+[[nodiscard]] void *countedMalloc(std::size_t size);
+[[nodiscard]] void *countedCalloc(std::size_t count, std::size_t size);
+[[nodiscard]] void *countedRealloc(void *pointer, std::size_t size);
+void countedFree(void *pointer);
+
+/**
+ * @brief Parses the options common to the benchmark targets.
+ *
+ * Recognized: --max-lines N, --output FILE, --compare BASELINE.json and --threshold FRACTION.
+ * Exits with a usage message on anything else.
+ *
+ * @param argc Program argument count, as received by main().
+ * @param argv Program argument values, as received by main().
+ * @param defaultMaxLines Largest buffer size measured when --max-lines is not given.
+ * @return The parsed options.
+ */
+[[nodiscard]] inline BenchOptions parseBenchOptions(const int argc, const char *argv[], const uint64_t defaultMaxLines = 1'000'000) {
+    auto options = BenchOptions{};
+    options.max_lines = defaultMaxLines;
+    for (auto index = 1; index < argc; ++index) {
+        const auto argument = std::string_view(argv[index]);
+        const auto has_value = index + 1 < argc;
+        if (argument == "--max-lines" && has_value) {
+            options.max_lines = std::strtoull(argv[++index], nullptr, 10);
+        } else if (argument == "--output" && has_value) {
+            options.output = argv[++index];
+        } else if (argument == "--compare" && has_value) {
+            options.baseline = argv[++index];
+        } else if (argument == "--threshold" && has_value) {
+            options.threshold = std::strtod(argv[++index], nullptr);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--max-lines N] [--output FILE] [--compare BASELINE.json] [--threshold FRACTION]\n";
+            std::exit(2);
+        }
+    }
+    return options;
+}
+
+/** Number of batches a measured loop is split into; the median batch is reported, which keeps a stray hiccup out. */
+static constexpr uint64_t BENCH_BATCH_COUNT = 9;
+
+/**
+ * @brief Times a loop of operations and counts the allocations it makes.
+ *
+ * The loop is split into up to BENCH_BATCH_COUNT consecutive batches timed separately; the time
+ * reported is the median batch, per operation. Allocations are averaged over the whole loop.
+ *
+ * @tparam TOperation Callable taking the iteration index.
+ * @param name Operation and pattern name.
+ * @param lines Line count of the buffer the operation runs on.
+ * @param iterations Number of times the operation runs.
+ * @param operation The operation to measure; setup belongs outside of it.
+ * @return The measurement.
+ */
+template<typename TOperation>
+[[nodiscard]] BenchResult measure(std::string name, const uint64_t lines, const uint64_t iterations, TOperation &&operation) {
+    const auto batch_count = std::clamp<uint64_t>(iterations, 1, BENCH_BATCH_COUNT);
+    auto batch_times = std::vector<double>{};
+    batch_times.reserve(batch_count);
+
+    const auto allocations_before = allocationCount();
+    auto iteration = uint64_t{0};
+    for (uint64_t batch = 0; batch < batch_count; ++batch) {
+        // Spread the remainder over the first batches
+        const auto batch_size = iterations / batch_count + (batch < iterations % batch_count ? 1 : 0);
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto batch_end = iteration + batch_size; iteration < batch_end; ++iteration) {
+            operation(iteration);
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        batch_times.push_back(static_cast<double>(elapsed) / static_cast<double>(std::max<uint64_t>(batch_size, 1)));
+    }
+    const auto allocations = allocationCount() - allocations_before;
+
+    std::nth_element(batch_times.begin(), batch_times.begin() + static_cast<std::ptrdiff_t>(batch_times.size() / 2), batch_times.end());
+    return {
+        .name = std::move(name),
+        .lines = lines,
+        .iterations = iterations,
+        .ns_per_op = batch_times[batch_times.size() / 2],
+        .allocs_per_op = static_cast<double>(allocations) / static_cast<double>(std::max<uint64_t>(iterations, 1))
+    };
+}
+
+/**
+ * @brief Writes results as JSON, one result object per line.
+ *
+ * @param stream The stream receiving the JSON.
+ * @param benchmark Name of the benchmark target.
+ * @param results The results to write.
+ */
+inline void writeResults(std::ostream &stream, const std::string_view benchmark, const std::vector<BenchResult> &results) {
+    stream << "{\n  \"benchmark\": \"" << benchmark << "\",\n  \"results\": [\n";
+    for (size_t index = 0; index < results.size(); ++index) {
+        const auto &result = results[index];
+        stream << "    {\"name\": \"" << result.name << "\", \"lines\": " << result.lines
+               << ", \"iterations\": " << result.iterations
+               << ", \"ns_per_op\": " << std::fixed << std::setprecision(1) << result.ns_per_op
+               << ", \"allocs_per_op\": " << std::setprecision(3) << result.allocs_per_op << "}"
+               << (index + 1 < results.size() ? ",\n" : "\n");
+    }
+    stream << "  ]\n}\n";
+}
+
+/**
+ * @brief Reads back the value of a key from one result line written by writeResults.
+ *
+ * @param line The result line.
+ * @param key The key, without quotes.
+ * @return The raw value text (quotes stripped for strings), or std::nullopt when absent.
+ */
+[[nodiscard]] inline std::optional<std::string> readField(const std::string_view line, const std::string_view key) {
+    const auto pattern = std::string("\"").append(key).append("\": ");
+    const auto start = line.find(pattern);
+    if (start == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    auto value = line.substr(start + pattern.size());
+    if (value.starts_with('"')) {
+        value.remove_prefix(1);
+        return std::string(value.substr(0, value.find('"')));
+    }
+    return std::string(value.substr(0, value.find_first_of(",}")));
+}
+
+/**
+ * @brief Reads the results of an earlier run.
+ *
+ * @param path Path of a JSON file written by writeResults.
+ * @return The results, or std::nullopt when the file cannot be read.
+ */
+[[nodiscard]] inline std::optional<std::vector<BenchResult>> readResults(const std::string &path) {
+    auto stream = std::ifstream(path);
+    if (!stream) {
+        return std::nullopt;
+    }
+
+    auto results = std::vector<BenchResult>{};
+    auto line = std::string{};
+    while (std::getline(stream, line)) {
+        const auto name = readField(line, "name");
+        const auto lines = readField(line, "lines");
+        const auto ns_per_op = readField(line, "ns_per_op");
+        if (!name || !lines || !ns_per_op) {
+            continue;
+        }
+
+        const auto iterations = readField(line, "iterations");
+        const auto allocs_per_op = readField(line, "allocs_per_op");
+        results.push_back({
+            .name = *name,
+            .lines = std::strtoull(lines->c_str(), nullptr, 10),
+            .iterations = iterations ? std::strtoull(iterations->c_str(), nullptr, 10) : 0,
+            .ns_per_op = std::strtod(ns_per_op->c_str(), nullptr),
+            .allocs_per_op = allocs_per_op ? std::strtod(allocs_per_op->c_str(), nullptr) : 0.0
+        });
+    }
+    return results;
+}
+
+/**
+ * @brief Compares results against a baseline and reports the ones slower past the threshold.
+ *
+ * Results are matched by name and line count; the ones missing on either side are skipped. The
+ * report goes to stderr so it never mixes with JSON written to stdout.
+ *
+ * @param baseline The results of the earlier run.
+ * @param results The results of this run.
+ * @param threshold Relative slowdown past which a result is a regression (0.10 is 10%).
+ * @return The number of regressions.
+ */
+inline uint32_t compareResults(const std::vector<BenchResult> &baseline, const std::vector<BenchResult> &results, const double threshold) {
+    auto regressions = 0u;
+    for (const auto &result : results) {
+        for (const auto &reference : baseline) {
+            if (reference.name != result.name || reference.lines != result.lines || reference.ns_per_op <= 0.0) {
+                continue;
+            }
+
+            const auto ratio = result.ns_per_op / reference.ns_per_op;
+            const auto is_regression = ratio > 1.0 + threshold;
+            if (is_regression) {
+                ++regressions;
+            }
+
+            std::cerr << (is_regression ? "REGRESSION " : "           ")
+                      << std::left << std::setw(36) << result.name << std::right << std::setw(10) << result.lines
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(14) << reference.ns_per_op << " ns -> " << std::setw(14) << result.ns_per_op << " ns"
+                      << std::setprecision(2) << "  x" << ratio << "\n";
+            break;
+        }
+    }
+    return regressions;
+}
+
+/**
+ * @brief Writes the results where the options say, then runs the baseline comparison if any.
+ *
+ * @param benchmark Name of the benchmark target.
+ * @param options The parsed options.
+ * @param results The results of this run.
+ * @return The process exit code: 0, or 1 when a regression was found or a file could not be used.
+ */
+[[nodiscard]] inline int finishBench(const std::string_view benchmark, const BenchOptions &options, const std::vector<BenchResult> &results) {
+    if (options.output) {
+        auto stream = std::ofstream(*options.output);
+        if (!stream) {
+            std::cerr << "Cannot write " << *options.output << "\n";
+            return 1;
+        }
+        writeResults(stream, benchmark, results);
+    } else {
+        writeResults(std::cout, benchmark, results);
+    }
+
+    if (!options.baseline) {
+        return 0;
+    }
+
+    const auto baseline = readResults(*options.baseline);
+    if (!baseline) {
+        std::cerr << "Cannot read " << *options.baseline << "\n";
+        return 1;
+    }
+
+    const auto regressions = compareResults(*baseline, results, options.threshold);
+    std::cerr << regressions << " regression(s) beyond " << std::setprecision(0) << options.threshold * 100.0 << "%\n";
+    return regressions == 0 ? 0 : 1;
+}
+
+
+#endif //BENCH_SUPPORT_H
@@ -0,0 +1,484 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BenchSupport.h"
+
+#include "core/base/LineScanner.h"
+#include "core/base/Regex.h"
+#include "core/cursor/Cursor.h"
+#include "core/cursor/LineTransform.h"
+#include "core/cursor/MatchReplacer.h"
+#include "core/cursor/SwapJournal.h"
+#include "core/cursor/buffer/LineBuffer.h"
+#include "core/cvar/CVarInt.h"
+
+
+/** Number of times the content is loaded; a load replaces the whole buffer, so each one costs the same. */
+static constexpr uint64_t LOAD_ITERATIONS = 5;
+
+/** Number of operations timed by every edit benchmark. */
+static constexpr uint64_t EDIT_ITERATIONS = 2000;
+
+/** Number of steps undone, then redone, by the history benchmarks; within the deepest history allowed. */
+static constexpr uint64_t HISTORY_ITERATIONS = 1000;
+
+/** Number of round trips across the whole history timed by the undo_to benchmark. */
+static constexpr uint64_t JUMP_ITERATIONS = 5;
+
+/** Lines the search benchmarks scan per size, in total: small buffers are scanned more times. */
+static constexpr uint64_t SEARCH_LINE_BUDGET = 10'000'000;
+
+/** Lines std::regex scans per size, in total; it is too slow for SEARCH_LINE_BUDGET. */
+static constexpr uint64_t STD_REGEX_LINE_BUDGET = 1'000'000;
+
+/** Number of replace_all and batch passes timed per size; each one rewrites about one match per line. */
+static constexpr uint64_t REPLACE_ITERATIONS = 4;
+
+/** Most carets the multi-caret benchmark types with: one per line, on the first lines. */
+static constexpr uint32_t MAX_CARETS = 10'000;
+
+/** Number of passes of the 20-step macro timed by the replay benchmark, each one on the next line. */
+static constexpr uint64_t MACRO_ITERATIONS = 50'000;
+
+/** Seed of the position generator, fixed so two runs edit the same places. */
+static constexpr uint32_t RANDOM_SEED = 0x62626c6f;
+
+/** Block inserted by the paste pattern: several lines, as a clipboard paste usually is. */
+static constexpr auto PASTE_BLOCK = std::u16string_view(
+    u"for (auto index = 0u; index < count; ++index) {\n"
+    u"    total += values[index] * weights[index];\n"
+    u"}\n"
+    u"return total;\n");
+
+/** Number of lines spanned by PASTE_BLOCK, which the paste erase removes again. */
+static constexpr uint32_t PASTE_LINE_COUNT = 4;
+
+/** Term the search benchmarks look for; one generated line in a hundred holds it. */
+static constexpr auto SEARCH_TERM = std::u16string_view(u"needle");
+
+/** Patterns of the regex benchmarks: one with a literal prefix for the vector kernels, one without. */
+static constexpr auto SEARCH_PATTERNS = std::array<std::pair<const char *, std::u16string_view>, 2> {
+    std::pair { "prefix", std::u16string_view(u"find\\(N[a-z]+, [a-z]+\\)") },
+    std::pair { "no_prefix", std::u16string_view(u"[A-Z][a-z]+, [a-z]+\\)") }
+};
+
+/** Pattern of the long run benchmark: every 'a' of a run starts a candidate failing at its end. */
+static constexpr auto LONG_RUN_PATTERN = std::u16string_view(u"a+b|c");
+
+/** Length of the runs of the long run benchmark, each one ended by the 'c' the pattern matches. */
+static constexpr uint32_t LONG_RUN_LENGTH = 256;
+
+
+/**
+ * @brief Generates a buffer content of the given line count.
+ *
+ * Lines look like source code of a plausible width; one in a hundred holds SEARCH_TERM with an
+ * upper-case first letter, so the two case-sensitivity modes find different counts.
+ */
+static std::u16string generateContent(const uint64_t lineCount) {
+    static constexpr auto fillers = std::array<std::u16string_view, 4> {
+        u"    const auto value = compute(left, right);",
+        u"    if (value > threshold) { return value; }",
+        u"\t// keep the buffer from being too uniform",
+        u"    result.push_back(value * 2 + offset);"
+    };
+
+    auto content = std::u16string{};
+    content.reserve(lineCount * 48);
+    for (uint64_t line = 0; line < lineCount; ++line) {
+        if (line % 100 == 42) {
+            content.append(u"    find(Needle, haystack);");
+        } else {
+            content.append(fillers[line % fillers.size()]);
+        }
+        if (line + 1 < lineCount) {
+            content.push_back(u'\n');
+        }
+    }
+    return content;
+}
+
+/** @brief Builds a cursor over the content, with the deepest history the editor allows. */
+static std::unique_ptr<Cursor> makeCursor(const std::u16string &content) {
+    auto cursor = std::make_unique<Cursor>(std::make_unique<LineBuffer>());
+    cursor->shareMaxHistoryDepth(std::make_shared<CVarInt>(4096));
+    (void) cursor->loadContent(content);
+    return cursor;
+}
+
+/** @brief Returns a random line of the cursor's buffer. */
+static uint32_t randomLine(const Cursor &cursor, std::mt19937 &random) {
+    return static_cast<uint32_t>(random() % cursor.getLineCount());
+}
+
+/**
+ * @brief Runs every benchmark at one buffer size.
+ *
+ * Each benchmark starts from a freshly loaded buffer, so one does not inherit the edits (or the
+ * history) of the previous one.
+ */
+static void runSize(const uint64_t lineCount, std::vector<BenchResult> &results) {
+    const auto content = generateContent(lineCount);
+    auto random = std::mt19937(RANDOM_SEED);
+
+    {
+        auto cursor = std::make_unique<Cursor>(std::make_unique<LineBuffer>());
+        results.push_back(measure("load/content", lineCount, LOAD_ITERATIONS, [&](uint64_t) {
+            (void) cursor->loadContent(content);
+        }));
+    }
+
+    // Insert: one character at the caret, pastes of a block, and one character at random lines
+    {
+        auto cursor = makeCursor(content);
+        cursor->setPosition(static_cast<uint32_t>(lineCount / 2), 0);
+        results.push_back(measure("insert/typing", lineCount, EDIT_ITERATIONS, [&](uint64_t) {
+            (void) cursor->insert(u"x");
+        }));
+    }
+    {
+        // The same typing, journaled to a swap file: the journal must not show up in the latency
+        auto cursor = makeCursor(content);
+        cursor->attachSwap(std::make_unique<SwapJournal>(SwapJournal::pathFor((std::filesystem::temp_directory_path() / "bbloc_bench.txt").string())));
+        cursor->setPosition(static_cast<uint32_t>(lineCount / 2), 0);
+        results.push_back(measure("insert/typing_swap", lineCount, EDIT_ITERATIONS, [&](uint64_t) {
+            (void) cursor->insert(u"x");
+        }));
+    }
+    {
+        auto cursor = makeCursor(content);
+        results.push_back(measure("insert/paste", lineCount, EDIT_ITERATIONS, [&](uint64_t) {
+            cursor->setPosition(randomLine(*cursor, random), 0);
+            (void) cursor->insert(PASTE_BLOCK);
+        }));
+    }
+    {
+        auto cursor = makeCursor(content);
+        results.push_back(measure("insert/random_jump", lineCount, EDIT_ITERATIONS, [&](uint64_t) {
+            cursor->setPosition(randomLine(*cursor, random), 0);
+            (void) cursor->insert(u"x");
+        }));
+    }
+
+    // Erase: a backspace run, single characters at random lines, and whole pasted blocks
+    {
+        auto cursor = makeCursor(content);
+        cursor->setPosition(static_cast<uint32_t>(lineCount / 2), 0);
+        (void) cursor->insert(std::u16string(EDIT_ITERATIONS, u'x'));
+        results.push_back(measure("erase/typing", lineCount, EDIT_ITERATIONS, [&](uint64_t) {
+            (void) cursor->eraseLeft();
+        }));
+    }
+    {
+        auto cursor = makeCursor(content);
+        results.push_back(measure("erase/random_jump", lineCount, EDIT_ITERATIONS, [&](uint64_t) {
+            const auto line = randomLine(*cursor, random);
+            cursor->setPosition(line, cursor->getString(line).empty() ? 0 : 1);
+            (void) cursor->eraseLeft();
+        }));
+    }
+    {
+        auto cursor = makeCursor(content);
+        const auto iterations = std::min<uint64_t>(EDIT_ITERATIONS, lineCount / (PASTE_LINE_COUNT * 2));
+        results.push_back(measure("erase/paste", lineCount, iterations, [&](uint64_t) {
+            const auto line = randomLine(*cursor, random) % (cursor->getLineCount() - PASTE_LINE_COUNT);
+            cursor->setPosition(line, 0);
+            cursor->activateSelection(true);
+            cursor->setPosition(line + PASTE_LINE_COUNT, 0);
+            (void) cursor->eraseSelection();
+            cursor->activateSelection(false);
+        }));
+    }
+
+    // Select all and delete, then undo: the history has to keep the whole buffer's text
+    {
+        auto cursor = makeCursor(content);
+        results.push_back(measure("erase/select_all", lineCount, JUMP_ITERATIONS, [&](uint64_t) {
+            cursor->moveToStartOfFile();
+            cursor->activateSelection(true);
+            cursor->moveToEndOfFile();
+            (void) cursor->eraseSelection();
+            (void) cursor->undo();
+        }));
+    }
+
+    // Newline split: a run of Enter presses, and splits in the middle of random lines
+    {
+        auto cursor = makeCursor(content);
+        cursor->setPosition(static_cast<uint32_t>(lineCount / 2), 4);
+        results.push_back(measure("newline/typing", lineCount, EDIT_ITERATIONS, [&](uint64_t) {
+            (void) cursor->newLine();
+        }));
+    }
+    {
+        auto cursor = makeCursor(content);
+        results.push_back(measure("newline/random_jump", lineCount, EDIT_ITERATIONS, [&](uint64_t) {
+            const auto line = randomLine(*cursor, random);
+            cursor->setPosition(line, static_cast<uint32_t>(cursor->getString(line).size() / 2));
+            (void) cursor->newLine();
+        }));
+    }
+
+    // Cross-line commit: alternating between the first and the last line, so every edit commits
+    // the other end of the buffer back
+    {
+        auto cursor = makeCursor(content);
+        results.push_back(measure("commit/alternate", lineCount, EDIT_ITERATIONS, [&](const uint64_t iteration) {
+            cursor->setPosition(iteration % 2 == 0 ? 0 : cursor->getLineCount() - 1, 0);
+            (void) cursor->insert(u"x");
+        }));
+    }
+
+    // Undo/redo: a history of single-character edits at random lines, then of pasted blocks
+    for (const auto &[pattern, text] : { std::pair { "random_jump", std::u16string_view(u"x") }, std::pair { "paste", PASTE_BLOCK } }) {
+        auto cursor = makeCursor(content);
+        for (uint64_t iteration = 0; iteration < HISTORY_ITERATIONS; ++iteration) {
+            // setPosition alone keeps the group open; a caret move closes it, one step per edit
+            cursor->setPosition(randomLine(*cursor, random), 0);
+            cursor->moveToStartOfLine();
+            (void) cursor->insert(text);
+        }
+
+        results.push_back(measure(std::string("undo/").append(pattern), lineCount, HISTORY_ITERATIONS, [&](uint64_t) {
+            (void) cursor->undo();
+        }));
+        results.push_back(measure(std::string("redo/").append(pattern), lineCount, HISTORY_ITERATIONS, [&](uint64_t) {
+            (void) cursor->redo();
+        }));
+    }
+
+    // Jumps across the whole history of random edits, back to its start then forward to the saved
+    // state at its end, with the checkpoints the main loop takes as the edits come
+    {
+        auto cursor = makeCursor(content);
+        for (uint64_t iteration = 0; iteration < HISTORY_ITERATIONS; ++iteration) {
+            cursor->setPosition(randomLine(*cursor, random), 0);
+            cursor->moveToStartOfLine();
+            (void) cursor->insert(u"x");
+            cursor->checkpointHistory();
+        }
+        cursor->setModified(false);
+
+        results.push_back(measure("undo_to/round_trip", lineCount, JUMP_ITERATIONS, [&](uint64_t) {
+            (void) cursor->undoSteps(HISTORY_ITERATIONS);
+            (void) cursor->undoToSaved();
+        }));
+    }
+
+    // Search: every occurrence over the whole buffer, as the match counter does
+    {
+        const auto cursor = makeCursor(content);
+        const auto iterations = std::max<uint64_t>(1, SEARCH_LINE_BUDGET / lineCount);
+        for (const auto case_sensitive : { true, false }) {
+            auto match_count = uint64_t{0};
+            results.push_back(measure(case_sensitive ? "search/case_sensitive" : "search/case_insensitive", lineCount, iterations, [&](uint64_t) {
+                const auto scanner = LineScanner(SEARCH_TERM, case_sensitive);
+                scanner.forEachMatch(*cursor, 0, 0, [&](uint32_t, uint32_t) {
+                    ++match_count;
+                    return true;
+                });
+            }));
+
+            // Keep the scan observable, so it cannot be optimized away
+            if (match_count == UINT64_MAX) {
+                std::cerr << match_count;
+            }
+        }
+    }
+
+    // Replace all: about one match per generated line ("value"), so the 10^6-line size rewrites a
+    // million matches in one splice. Passes alternate between the two terms, so each one has the
+    // same work to do; the pattern pass expands a group reference on every match.
+    {
+        auto cursor = makeCursor(content);
+        const auto forward = LineScanner(u"value", true);
+        const auto backward = LineScanner(u"amount", true);
+        results.push_back(measure("replace_all/literal", lineCount, REPLACE_ITERATIONS, [&](const uint64_t iteration) {
+            const auto &[scanner, replacement] = iteration % 2 == 0
+                ? std::pair { &forward, std::u16string_view(u"amount") }
+                : std::pair { &backward, std::u16string_view(u"value") };
+            (void) MatchReplacer::replaceAll(*cursor, *scanner, replacement);
+        }));
+    }
+    {
+        auto cursor = makeCursor(content);
+        const auto forward = LineScanner(std::make_shared<Regex>(u"val(ue)", true));
+        const auto backward = LineScanner(std::make_shared<Regex>(u"amo(ue)", true));
+        results.push_back(measure("replace_all/regex", lineCount, REPLACE_ITERATIONS, [&](const uint64_t iteration) {
+            const auto &[scanner, replacement] = iteration % 2 == 0
+                ? std::pair { &forward, std::u16string_view(u"amo\\1") }
+                : std::pair { &backward, std::u16string_view(u"val\\1") };
+            (void) MatchReplacer::replaceAll(*cursor, *scanner, replacement);
+        }));
+    }
+
+    // Batch: indent every line in one transaction, then take the indent back out in another, as a
+    // block indent and unindent over the whole buffer would
+    {
+        auto cursor = makeCursor(content);
+        results.push_back(measure("batch/indent", lineCount, REPLACE_ITERATIONS, [&](const uint64_t iteration) {
+            const auto indent = iteration % 2 == 0;
+            cursor->beginBatch();
+            for (uint32_t line = 0; line < cursor->getLineCount(); ++line) {
+                cursor->batchReplace(TextRange{.line_start = line, .column_start = 0, .line_end = line, .column_end = indent ? 0u : 1u}, indent ? u"\t" : u"");
+            }
+            (void) cursor->commitBatch();
+        }));
+    }
+
+    // Lines: sort the whole buffer on every core, then reverse it, so each pass moves every line
+    // and lands as one splice
+    {
+        auto cursor = makeCursor(content);
+        const auto thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+        results.push_back(measure("lines/sort", lineCount, REPLACE_ITERATIONS, [&](const uint64_t iteration) {
+            const auto kind = iteration % 2 == 0 ? LineTransform::Kind::Sort : LineTransform::Kind::Reverse;
+            (void) LineTransform::apply(*cursor, 0, cursor->getLineCount() - 1, kind, thread_count);
+        }));
+    }
+
+    // Carets: one at the end of each of the first lines, typing a character then erasing it, each
+    // keystroke applied at every caret at once
+    {
+        auto cursor = makeCursor(content);
+        const auto caret_count = std::min(MAX_CARETS, cursor->getLineCount() - 1);
+        cursor->activateSelection(true);
+        cursor->setPosition(caret_count, 0);
+        (void) cursor->addCaretsOnSelectedLines();
+        results.push_back(measure("carets/type", lineCount, EDIT_ITERATIONS, [&](const uint64_t iteration) {
+            (void) (iteration % 2 == 0 ? cursor->insertAtCarets(u"x") : cursor->eraseAtCarets(false));
+        }));
+    }
+
+    // Macro: the buffer side of a 20-step macro reworking a line then moving down, replayed within
+    // one held undo group as the macro command plays it; the dispatch of the steps is not timed
+    {
+        auto cursor = makeCursor(content);
+        cursor->holdUndoGroup(true);
+        results.push_back(measure("macro/replay", lineCount, MACRO_ITERATIONS, [&](uint64_t) {
+            cursor->moveToStartOfLine();
+            (void) cursor->insert(u"[");
+            cursor->moveRight();
+            cursor->moveRight();
+            cursor->moveRight();
+            (void) cursor->insert(u"]");
+            (void) cursor->insert(u" ");
+            cursor->moveToEndOfLine();
+            (void) cursor->eraseLeft();
+            (void) cursor->insert(u";");
+            cursor->moveLeft();
+            cursor->moveLeft();
+            (void) cursor->eraseRight();
+            cursor->moveToStartOfLine();
+            (void) cursor->eraseRight();
+            (void) cursor->insert(u"#");
+            cursor->moveToEndOfLine();
+            (void) cursor->insert(u" // ok");
+            if (cursor->getLine() + 1 == cursor->getLineCount()) {
+                cursor->moveToStartOfFile();
+            }
+            cursor->moveDown();
+            cursor->moveToStartOfLine();
+        }));
+        cursor->holdUndoGroup(false);
+    }
+
+    // Regex search: the built-in engine over the buffer, then std::regex over the same lines held
+    // as std::string (the generated content is ASCII), on fewer passes
+    {
+        const auto cursor = makeCursor(content);
+        auto lines = std::vector<std::string>{};
+        lines.reserve(cursor->getLineCount());
+        for (uint32_t line = 0; line < cursor->getLineCount(); ++line) {
+            const auto text = cursor->getString(line);
+            lines.emplace_back(text.begin(), text.end());
+        }
+
+        for (const auto &[name, pattern] : SEARCH_PATTERNS) {
+            auto match_count = uint64_t{0};
+            const auto iterations = std::max<uint64_t>(1, SEARCH_LINE_BUDGET / lineCount);
+            results.push_back(measure(std::string("regex/").append(name), lineCount, iterations, [&](uint64_t) {
+                const auto scanner = LineScanner(std::make_shared<Regex>(pattern, true));
+                scanner.forEachMatch(*cursor, 0, 0, [&](uint32_t, uint32_t) {
+                    ++match_count;
+                    return true;
+                });
+            }));
+
+            const auto std_pattern = std::regex(std::string(pattern.begin(), pattern.end()));
+            const auto std_iterations = std::max<uint64_t>(1, STD_REGEX_LINE_BUDGET / lineCount);
+            results.push_back(measure(std::string("std_regex/").append(name), lineCount, std_iterations, [&](uint64_t) {
+                for (const auto &line : lines) {
+                    match_count += static_cast<uint64_t>(std::distance(std::sregex_iterator(line.begin(), line.end(), std_pattern), std::sregex_iterator()));
+                }
+            }));
+
+            if (match_count == UINT64_MAX) {
+                std::cerr << match_count;
+            }
+        }
+    }
+
+    // Regex search over lines whose only match ends them: the search must not retry each start of
+    // the run, which would be quadratic in the line length
+    {
+        auto run_content = std::u16string{};
+        run_content.reserve(lineCount * (LONG_RUN_LENGTH + 2));
+        for (uint64_t line = 0; line < lineCount; ++line) {
+            run_content.append(LONG_RUN_LENGTH, u'a').append(u"c\n");
+        }
+        const auto cursor = makeCursor(run_content);
+
+        auto match_count = uint64_t{0};
+        const auto iterations = std::max<uint64_t>(1, SEARCH_LINE_BUDGET / lineCount / 10);
+        results.push_back(measure("regex/long_run", lineCount, iterations, [&](uint64_t) {
+            const auto scanner = LineScanner(std::make_shared<Regex>(LONG_RUN_PATTERN, true));
+            scanner.forEachMatch(*cursor, 0, 0, [&](uint32_t, uint32_t) {
+                ++match_count;
+                return true;
+            });
+        }));
+        if (match_count == UINT64_MAX) {
+            std::cerr << match_count;
+        }
+    }
+}
+
+int main(const int argc, const char *argv[]) {
+    const auto options = parseBenchOptions(argc, argv);
+
+    auto results = std::vector<BenchResult>{};
+    for (uint64_t line_count = 1000; line_count <= options.max_lines; line_count *= 10) {
+        std::cerr << "measuring " << line_count << " lines\n";
+        runSize(line_count, results);
+    }
+
+    return finishBench("bbloc_bench", options, results);
+}
@@ -0,0 +1,237 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <tree_sitter/api.h>
+#include <utf8.h>
+
+#include "BenchSupport.h"
+
+#include "core/cursor/Cursor.h"
+#include "core/cursor/buffer/LineBuffer.h"
+#include "core/cvar/CVarInt.h"
+#include "core/highlighter/HighLighter.h"
+#include "core/highlighter/ParserCatalog.h"
+
+
+/** Largest generated corpus measured by default; a full parse of 10^6 lines takes seconds per language. */
+static constexpr uint64_t DEFAULT_MAX_LINES = 100'000;
+
+/** Lines the initial parse benchmark parses per corpus, in total: small corpora are parsed more times. */
+static constexpr uint64_t PARSE_LINE_BUDGET = 2'000'000;
+
+/** Bounds of the initial parse iteration count, whatever the corpus size. */
+static constexpr uint64_t MIN_PARSE_ITERATIONS = 3;
+static constexpr uint64_t MAX_PARSE_ITERATIONS = 200;
+
+/** Number of edits reparsed by the incremental benchmarks; even, so the buffer ends as it started. */
+static constexpr uint64_t EDIT_ITERATIONS = 200;
+
+/** Number of cold cache windows painted by the cache benchmark. */
+static constexpr uint64_t WINDOW_ITERATIONS = 200;
+
+/** Half the span of lines the incremental benchmarks edit, around the middle of the corpus; within one cache window. */
+static constexpr uint32_t EDIT_HALF_SPAN = 128;
+
+/** Seed of the position generator, fixed so two runs edit the same places. */
+static constexpr uint32_t RANDOM_SEED = 0x62626c6f;
+
+
+/** @brief A corpus of one language, read from the checked-in sample. */
+struct Corpus final {
+    HighLightId mode;        ///< Highlighting mode the corpus is parsed with.
+    std::string language;    ///< Prompt argument of the language, used in the result names.
+    std::u16string sample;   ///< Content of the checked-in sample.
+};
+
+/**
+ * @brief Reads the checked-in sample of every language of the catalog.
+ *
+ * The sample of a language is the file named "sample" followed by one of its extensions. A
+ * language without a sample is reported and skipped, so a new grammar does not break the target
+ * before it gets one.
+ */
+static std::vector<Corpus> readCorpora(const std::filesystem::path &directory) {
+    auto corpora = std::vector<Corpus>{};
+    for (const auto &[mode, descriptor] : ParserCatalog::getDescriptors()) {
+        auto found = std::optional<std::filesystem::path>{};
+        for (const auto &extension : descriptor.files_format) {
+            const auto path = directory / ("sample" + extension);
+            if (std::filesystem::exists(path)) {
+                found = path;
+                break;
+            }
+        }
+
+        if (!found) {
+            std::cerr << "no sample for " << descriptor.argument_value << " in " << directory.string() << ", skipped\n";
+            continue;
+        }
+
+        auto stream = std::ifstream(*found, std::ios::binary);
+        const auto bytes = std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        corpora.push_back({ mode, descriptor.argument_value, utf8::utf8to16(bytes) });
+    }
+
+    // The catalog is unordered; sort so the output is stable from one run to the next
+    std::ranges::sort(corpora, {}, &Corpus::language);
+    return corpora;
+}
+
+/**
+ * @brief Generates a corpus of at least the given line count by tiling the sample.
+ *
+ * Whole copies only, so the generated text parses exactly like the sample does; the measured
+ * line count is the buffer's, slightly past the requested one.
+ */
+static std::u16string tileSample(const std::u16string &sample, const uint64_t lineCount) {
+    const auto sample_lines = static_cast<uint64_t>(std::ranges::count(sample, u'\n')) + (sample.ends_with(u'\n') ? 0 : 1);
+    const auto copies = std::max<uint64_t>(1, (lineCount + sample_lines - 1) / sample_lines);
+
+    auto content = std::u16string{};
+    content.reserve(sample.size() * copies + copies);
+    for (uint64_t copy = 0; copy < copies; ++copy) {
+        content.append(sample);
+        if (!sample.ends_with(u'\n')) {
+            content.push_back(u'\n');
+        }
+    }
+    return content;
+}
+
+/** @brief Builds a cursor over the content, with the deepest history the editor allows. */
+static std::unique_ptr<Cursor> makeCursor(const std::u16string &content) {
+    auto cursor = std::make_unique<Cursor>(std::make_unique<LineBuffer>());
+    cursor->shareMaxHistoryDepth(std::make_shared<CVarInt>(4096));
+    (void) cursor->loadContent(content);
+    return cursor;
+}
+
+/**
+ * @brief Types then erases a space at the end of a line, and reparses after each edit.
+ *
+ * A trailing space changes no token in any of the grammars, so every reparse does the same work
+ * and the buffer ends as it started. Even iterations pick a new line near the middle of the
+ * buffer; odd ones erase what the previous one typed.
+ */
+static void editAndReparse(Cursor &cursor, HighLighter &highLighter, std::mt19937 &random, const uint64_t iteration) {
+    if (iteration % 2 == 0) {
+        const auto middle = cursor.getLineCount() / 2;
+        const auto first = middle > EDIT_HALF_SPAN ? middle - EDIT_HALF_SPAN : 0;
+        const auto line = first + static_cast<uint32_t>(random() % std::min(cursor.getLineCount() - first, EDIT_HALF_SPAN * 2));
+        cursor.setPosition(line, static_cast<uint32_t>(cursor.getString(line).size()));
+        highLighter.edit(cursor.insert(u" "));
+    } else if (const auto edit = cursor.eraseLeft()) {
+        highLighter.edit(*edit);
+    }
+    highLighter.parse();
+}
+
+/**
+ * @brief Runs every benchmark on one corpus.
+ *
+ * The incremental benchmarks are run twice: once with no cache window, where parse() only
+ * reparses, and once with a window around the edited lines, where parse() also repaints them.
+ * The difference between the two is the cost of the repaint.
+ */
+static void runCorpus(const Corpus &corpus, const std::string &pattern, const std::u16string &content, std::vector<BenchResult> &results) {
+    auto random = std::mt19937(RANDOM_SEED);
+    const auto cursor = makeCursor(content);
+    const auto line_count = cursor->getLineCount();
+    const auto suffix = "/" + corpus.language + pattern;
+
+    // Initial parse: a fresh highlighter each time, as opening a file creates one
+    {
+        const auto iterations = std::clamp<uint64_t>(PARSE_LINE_BUDGET / line_count, MIN_PARSE_ITERATIONS, MAX_PARSE_ITERATIONS);
+        results.push_back(measure("parse/initial" + suffix, line_count, iterations, [&](uint64_t) {
+            auto high_lighter = HighLighter(*cursor);
+            high_lighter.setMode(corpus.mode);
+            high_lighter.parse();
+        }));
+    }
+
+    // Incremental reparse, without then with a cache window to repaint
+    {
+        auto high_lighter = HighLighter(*cursor);
+        high_lighter.setMode(corpus.mode);
+        high_lighter.parse();
+        results.push_back(measure("reparse/char_edit" + suffix, line_count, EDIT_ITERATIONS, [&](const uint64_t iteration) {
+            editAndReparse(*cursor, high_lighter, random, iteration);
+        }));
+
+        // Paint the window around the edited lines once; in-line edits keep it, so every parse repaints
+        (void) high_lighter.getHighLightLine(line_count / 2);
+        results.push_back(measure("reparse_repaint/char_edit" + suffix, line_count, EDIT_ITERATIONS, [&](const uint64_t iteration) {
+            editAndReparse(*cursor, high_lighter, random, iteration);
+        }));
+    }
+
+    // Cold windows: every lookup lands outside the current window, so each one repaints a full window
+    {
+        auto high_lighter = HighLighter(*cursor);
+        high_lighter.setMode(corpus.mode);
+        high_lighter.parse();
+        (void) high_lighter.getHighLightLine(0);
+        if (high_lighter.getCacheLineCount() >= line_count) {
+            // The window covers the whole corpus; no lookup can miss
+            return;
+        }
+
+        auto painted = uint64_t{0};
+        results.push_back(measure("cache/cold_window" + suffix, line_count, WINDOW_ITERATIONS, [&](uint64_t) {
+            const auto window_end = high_lighter.getCacheStartLine() + high_lighter.getCacheLineCount();
+            const auto outside = window_end + static_cast<uint32_t>(random() % (line_count - high_lighter.getCacheLineCount()));
+            painted += high_lighter.getHighLightLine(outside % line_count).size();
+        }));
+
+        // Keep the lookups observable, so they cannot be optimized away
+        if (painted == UINT64_MAX) {
+            std::cerr << painted;
+        }
+    }
+}
+
+int main(const int argc, const char *argv[]) {
+    const auto options = parseBenchOptions(argc, argv, DEFAULT_MAX_LINES);
+
+    // The parsers allocate with malloc, which operator new does not see: before any of them
+    // exists, tree-sitter is handed the counted C functions so allocs_per_op includes its trees
+    ts_set_allocator(countedMalloc, countedCalloc, countedRealloc, countedFree);
+
+    auto results = std::vector<BenchResult>{};
+    for (const auto &corpus : readCorpora(BBLOC_BENCH_CORPUS_DIR)) {
+        std::cerr << "measuring " << corpus.language << "\n";
+        runCorpus(corpus, "_sample", corpus.sample, results);
+        for (uint64_t line_count = 1000; line_count <= options.max_lines; line_count *= 10) {
+            runCorpus(corpus, "", tileSample(corpus.sample, line_count), results);
+        }
+    }
+
+    return finishBench("bbloc_hl_bench", options, results);
+}
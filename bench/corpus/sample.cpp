@@ -0,0 +1,121 @@
+// Highlighter benchmark corpus: a plausible C++ translation unit, tiled by bbloc_hl_bench to
+// reach the generated sizes. Keep it self-contained: every construct here should parse without
+// errors, so the timings measure the grammar rather than the error recovery.
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define SAMPLE_ASSERT(condition) do { if (!(condition)) { throw std::logic_error(#condition); } } while (false)
+
+namespace sample {
+
+/** @brief A rectangle in pixels. */
+struct Rect final {
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+
+    [[nodiscard]] constexpr bool contains(const int32_t px, const int32_t py) const {
+        return px >= x && py >= y && px < x + width && py < y + height;
+    }
+};
+
+enum class Shape : uint8_t {
+    Square,
+    Circle,
+    Triangle
+};
+
+template<typename TValue>
+class RingBuffer final {
+    std::vector<TValue> m_values;
+    size_t m_head = 0;
+    size_t m_size = 0;
+
+public:
+    explicit RingBuffer(const size_t capacity) : m_values(capacity) {}
+
+    void push(TValue value) {
+        m_values[(m_head + m_size) % m_values.size()] = std::move(value);
+        if (m_size < m_values.size()) {
+            ++m_size;
+        } else {
+            m_head = (m_head + 1) % m_values.size();
+        }
+    }
+
+    [[nodiscard]] std::optional<TValue> pop() {
+        if (m_size == 0) {
+            return std::nullopt;
+        }
+
+        auto value = std::move(m_values[m_head]);
+        m_head = (m_head + 1) % m_values.size();
+        --m_size;
+        return value;
+    }
+
+    [[nodiscard]] size_t size() const { return m_size; }
+};
+
+static double area(const Shape shape, const double side) {
+    switch (shape) {
+        case Shape::Square:
+            return side * side;
+        case Shape::Circle:
+            return 3.14159265358979 * side * side / 4.0;
+        case Shape::Triangle:
+            return side * side * 0.4330127018922193;
+    }
+    return 0.0;
+}
+
+/*
+ * Counts the words of a text, ignoring the case of ASCII letters.
+ * A word is a run of letters, digits or underscores.
+ */
+std::map<std::string, uint32_t> countWords(const std::string_view text) {
+    auto counts = std::map<std::string, uint32_t>{};
+    auto word = std::string{};
+    for (const auto character : text) {
+        if (std::isalnum(static_cast<unsigned char>(character)) || character == '_') {
+            word.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(character))));
+        } else if (!word.empty()) {
+            ++counts[word];
+            word.clear();
+        }
+    }
+    if (!word.empty()) {
+        ++counts[word];
+    }
+    return counts;
+}
+
+int32_t clampToRect(const Rect &rect, int32_t value) {
+    SAMPLE_ASSERT(rect.width >= 0);
+    value = std::max(value, rect.x);
+    value = std::min(value, rect.x + rect.width - 1);
+    return value;
+}
+
+void fill(std::vector<float> &values, const float start, const float step) {
+    auto current = start;
+    for (auto &value : values) {
+        value = current;
+        current += step;
+    }
+
+    const auto total = std::accumulate(values.begin(), values.end(), 0.0f);
+    const char *label = total > 1e6f ? "large" : "small";
+    const auto message = std::string("total is ") + label + '\n';
+    (void) message;
+}
+
+} // namespace sample
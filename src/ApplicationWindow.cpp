@@ -38,12 +38,19 @@
 #include "command/AutoCompleteCommand.h"
 #include "command/BindCommand.h"
 #include "command/BufferCommand.h"
+#include "command/CancelCommand.h"
+#include "command/CaretCommand.h"
 #include "command/CopyTextCommand.h"
 #include "command/CutTextCommand.h"
 #include "command/ExecCommand.h"
+#include "command/FilterCommand.h"
 #include "command/FontSizeCommand.h"
 #include "command/GotoLineCommand.h"
+#include "command/GrepCommand.h"
 #include "command/HelpCommand.h"
+#include "command/LinesCommand.h"
+#include "command/MacroCommand.h"
+#include "command/MemCommand.h"
 #include "command/MoveCursorCommand.h"
 #include "command/OpenFileCommand.h"
 #include "command/OskCommand.h"
@@ -53,9 +60,11 @@
 #include "command/RedoCommand.h"
 #include "command/ResetCVarFloatCommand.h"
 #include "command/SaveFileCommand.h"
+#include "command/SearchAllCommand.h"
 #include "command/SearchCommand.h"
 #include "command/SetHighLightCommand.h"
 #include "command/UndoCommand.h"
+#include "command/UndoToCommand.h"
 #include "core/base/CommandLine.h"
 #include "core/theme/DimensionId.h"
 #include "core/FocusTarget.h"
@@ -141,17 +150,38 @@ ApplicationWindow::ApplicationWindow()
       m_editor(m_command_manager, m_theme, m_quad_program),
       m_prompt(m_command_manager, m_theme, m_quad_program),
       m_osk(m_command_manager, m_theme, m_quad_program),
+      m_perf_hud(m_command_manager, m_theme, m_quad_program),
       m_prompt_state(m_command_manager),
       m_command_time(std::make_shared<CVarFloat>(0.0f, true)),
       m_draw_time(std::make_shared<CVarFloat>(0.0f, true)),
+      m_info_bar_gpu_time(std::make_shared<CVarFloat>(0.0f, true)),
+      m_editor_gpu_time(std::make_shared<CVarFloat>(0.0f, true)),
+      m_prompt_gpu_time(std::make_shared<CVarFloat>(0.0f, true)),
+      m_osk_gpu_time(std::make_shared<CVarFloat>(0.0f, true)),
+      m_show_perf_hud(std::make_shared<CVarBool>(false)),
       m_search_case_sensitive(std::make_shared<CVarBool>(false)),
       m_open_size_limit(std::make_shared<CVarInt>(10)),
+      m_grep_job(std::make_shared<GrepJob>()),
+      m_search_all_job(std::make_shared<SearchAllJob>()),
+      m_filter_job(std::make_shared<FilterJob>()),
+      m_macro_recorder(std::make_shared<MacroRecorder>()),
       m_bind_command(std::make_shared<BindCommand>(m_command_manager)),
       m_orthogonal(),
-      m_keyboard_input(*this, m_context_manager, m_editor, m_editor_state, m_prompt, m_prompt_state),
+      m_keyboard_input(*this, m_context_manager, m_editor, m_editor_state, m_prompt, m_prompt_state, *m_macro_recorder),
       m_pointer_input(m_context_manager, m_theme, m_info_bar, m_info_bar_state, m_editor, m_editor_state, m_prompt, m_prompt_state, m_osk, m_osk_state),
       m_controller_input(*this, m_context_manager, m_osk, m_osk_state) {}
 
+ApplicationWindow::~ApplicationWindow() {
+    // The command manager shares the filter job and outlives the buffers: kill its command while
+    // the buffer it reads is still there
+    m_filter_job->cancel();
+}
+
+bool ApplicationWindow::holdsFilteredTyping() {
+    const auto &active = m_context_manager.active();
+    return m_filter_job->getCursor() == &active.cursor && active.focus_target == FocusTarget::Editor;
+}
+
 bool ApplicationWindow::runBoundCommand(const SDL_Keycode keycode, const uint16_t modifiers) {
     if (const auto command = m_bind_command->getBinding(keycode, modifiers)) {
         const auto current_time = SDL_GetPerformanceCounter();
@@ -254,15 +284,30 @@ void ApplicationWindow::create(const std::string &title, const int32_t width, co
     m_quad_program.bindVertexBuffer(m_quad_buffer.getBuffer());
     m_quad_program.setMatrix(m_orthogonal.data());
 
+    // Create the GPU timers; they stay inert when the context has no timer queries
+    m_info_bar_gpu_timer.create();
+    m_editor_gpu_timer.create();
+    m_prompt_gpu_timer.create();
+    m_osk_gpu_timer.create();
+
     // Create the views
     m_info_bar.resizeWindow(width, height);
     m_editor.resizeWindow(width, height);
     m_prompt.resizeWindow(width, height);
     m_osk.resizeWindow(width, height);
+    m_perf_hud.resizeWindow(width, height);
 
     // Register cvars and commands then run autoexec
     m_command_manager.registerCvar(u"inf_draw_time", m_draw_time, nullptr);
     m_command_manager.registerCvar(u"inf_command_time", m_command_time, nullptr);
+    m_command_manager.registerCvar(u"inf_gpu_info_bar", m_info_bar_gpu_time, nullptr);
+    m_command_manager.registerCvar(u"inf_gpu_editor", m_editor_gpu_time, nullptr);
+    m_command_manager.registerCvar(u"inf_gpu_prompt", m_prompt_gpu_time, nullptr);
+    m_command_manager.registerCvar(u"inf_gpu_osk", m_osk_gpu_time, nullptr);
+    m_command_manager.registerCvar(u"show_perf_hud", m_show_perf_hud, [this] {
+        // Show or hide the overlay right away rather than on the next input.
+        m_context_manager.active().wants_redraw = true;
+    });
     m_command_manager.registerCvar(u"dim_max_undo", m_max_undo, [this] {
         // Clamp the depth so the user cannot exhaust memory or disable history entirely.
         m_max_undo->m_value = std::clamp(m_max_undo->m_value, 1, 4096);
@@ -295,6 +340,10 @@ void ApplicationWindow::create(const std::string &title, const int32_t width, co
     m_command_manager.registerCommand(u"cut", std::make_shared<CutTextCommand>(), false, false);
     m_command_manager.registerCommand(u"undo", std::make_shared<UndoCommand>(), false, false);
     m_command_manager.registerCommand(u"redo", std::make_shared<RedoCommand>(), false, false);
+    m_command_manager.registerCommand(u"undo_to", std::make_shared<UndoToCommand>(), false, false);
+    m_command_manager.registerCommand(u"caret", std::make_shared<CaretCommand>(), false, false);
+    m_command_manager.registerCommand(u"lines", std::make_shared<LinesCommand>(), false, false);
+    m_command_manager.registerCommand(u"macro", std::make_shared<MacroCommand>(m_macro_recorder), false, false);
     m_command_manager.registerCommand(u"move", std::make_shared<MoveCursorCommand>(m_prompt_state), false, true);
     m_command_manager.registerCommand(u"goto_line", std::make_shared<GotoLineCommand>(), false, false);
     m_command_manager.registerCommand(u"search", std::make_shared<SearchCommand>(SearchCommand::Action::Search, m_search_case_sensitive), false, false);
@@ -302,10 +351,16 @@ void ApplicationWindow::create(const std::string &title, const int32_t width, co
     m_command_manager.registerCommand(u"find_prev", std::make_shared<SearchCommand>(SearchCommand::Action::FindPrev, m_search_case_sensitive), false, false);
     m_command_manager.registerCommand(u"replace", std::make_shared<SearchCommand>(SearchCommand::Action::Replace, m_search_case_sensitive), false, false);
     m_command_manager.registerCommand(u"replace_all", std::make_shared<SearchCommand>(SearchCommand::Action::ReplaceAll, m_search_case_sensitive), false, false);
+    m_command_manager.registerCommand(u"search_all", std::make_shared<SearchAllCommand>(m_context_manager, m_search_case_sensitive, m_search_all_job), false, false);
+    m_command_manager.registerCommand(u"grep", std::make_shared<GrepCommand>(GrepCommand::Action::Grep, m_context_manager, m_search_case_sensitive, m_grep_job), false, false);
+    m_command_manager.registerCommand(u"grep_cancel", std::make_shared<GrepCommand>(GrepCommand::Action::Cancel, m_context_manager, m_search_case_sensitive, m_grep_job), false, false);
+    m_command_manager.registerCommand(u"cancel", std::make_shared<CancelCommand>(m_context_manager, m_grep_job, m_search_all_job), false, false);
+    m_command_manager.registerCommand(u"filter", std::make_shared<FilterCommand>(m_filter_job, m_grep_job, m_search_all_job), false, false);
     m_command_manager.registerCommand(u"exec", std::make_shared<ExecCommand>(), false, false);
     m_command_manager.registerCommand(u"auto_complete", std::make_shared<AutoCompleteCommand>(m_prompt_state), true, true);
     m_command_manager.registerCommand(u"osk", std::make_shared<OskCommand>(m_osk_state), false, true);
     m_command_manager.registerCommand(u"help", std::make_shared<HelpCommand>(m_context_manager), false, false);
+    m_command_manager.registerCommand(u"mem", std::make_shared<MemCommand>(m_context_manager, m_theme, m_quad_buffer), false, false);
 
     // Follow the system color scheme where the platform exposes one (Switch console color set);
     // runs before autoexec so the colors set there win, the system scheme being just the default
@@ -360,8 +415,13 @@ void ApplicationWindow::mainLoop() {
 
     SDL_Event event;
     while (is_running) {
-        // Wait events from SDL; with a repeat armed (controller input, held OSK key), wake at
-        // the earliest deadline instead of blocking indefinitely (clamped to at least 1 ms)
+        // Wait events from SDL; with a repeat armed (controller input, held OSK key), a grep or a
+        // filter running, wake at the earliest deadline instead of blocking indefinitely (clamped to at
+        // least 1 ms).
+        // While the search matches are being counted, or a macro plays, only poll, so they keep going;
+        // a macro waiting for its filter waits like the rest.
+        const auto is_filtering = m_filter_job->isStarted();
+        const auto is_counting = m_context_manager.active().search.index.isCounting() || (m_macro_recorder->isPlaying() && !is_filtering);
         auto repeat_deadline = std::numeric_limits<uint64_t>::max();
         if (m_controller_input.isRepeatArmed()) {
             repeat_deadline = m_controller_input.getRepeatDeadline();
@@ -371,7 +431,19 @@ void ApplicationWindow::mainLoop() {
             repeat_deadline = std::min(repeat_deadline, m_osk_state.getRepeater().getDeadline());
         }
 
-        if (repeat_deadline != std::numeric_limits<uint64_t>::max()) {
+        if (m_grep_job->isStarted() || m_search_all_job->isStarted()) {
+            // Wake up to stream the new search entries even without input
+            repeat_deadline = std::min(repeat_deadline, SDL_GetTicks64() + GREP_PUMP_INTERVAL_MS);
+        }
+
+        if (is_filtering) {
+            // Wake up to show the progress of the filter, and land its result once it is over
+            repeat_deadline = std::min(repeat_deadline, SDL_GetTicks64() + FILTER_PUMP_INTERVAL_MS);
+        }
+
+        if (is_counting) {
+            // No wait: SDL_PollEvent below pumps the pending events
+        } else if (repeat_deadline != std::numeric_limits<uint64_t>::max()) {
             const auto remaining = static_cast<int64_t>(repeat_deadline) - static_cast<int64_t>(SDL_GetTicks64());
             SDL_WaitEventTimeout(nullptr, static_cast<int32_t>(std::max<int64_t>(remaining, 1)));
         } else {
@@ -387,11 +459,49 @@ void ApplicationWindow::mainLoop() {
                 text_event.timestamp = event.user.timestamp;
                 SDL_strlcpy(text_event.text, static_cast<char *>(event.user.data1), sizeof(text_event.text));
                 SDL_free(event.user.data1);
-                dismissMessage();
-                m_keyboard_input.onTextInput(text_event);
+                if (!m_macro_recorder->isPlaying() && !holdsFilteredTyping()) {
+                    dismissMessage();
+                    m_keyboard_input.onTextInput(text_event);
+                }
                 continue;
             }
 
+            // A playing macro owns the input: Escape stops it, whatever else is pressed meanwhile
+            // would land between its steps, and is dropped. A running filter only holds the typing
+            // into the buffer it is about to replace: Escape there kills its command, and the macro
+            // that ran it. Chords, pads and clicks still go through, to reach the other buffers
+            const auto is_playing = m_macro_recorder->isPlaying();
+            const auto holds_typing = !is_playing && holdsFilteredTyping();
+            if (is_playing || holds_typing) {
+                if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) {
+                    m_filter_job->cancel();
+                    if (is_playing) {
+                        m_macro_recorder->stopPlayback();
+                        endMacroPlayback(true);
+                    }
+                    continue;
+                }
+
+                const auto is_chord = event.type == SDL_KEYDOWN && (event.key.keysym.mod & (KMOD_CTRL | KMOD_LALT));
+                switch (event.type) {
+                    case SDL_KEYDOWN:
+                    case SDL_TEXTINPUT:
+                        if (is_playing || !is_chord) {
+                            continue;
+                        }
+                    break;
+                    case SDL_MOUSEBUTTONDOWN:
+                    case SDL_FINGERDOWN:
+                    case SDL_CONTROLLERBUTTONDOWN:
+                        if (is_playing) {
+                            continue;
+                        }
+                    break;
+                    default:
+                    break;
+                }
+            }
+
             switch (event.type) {
                 case SDL_QUIT:
                     is_running = false;
@@ -424,6 +534,7 @@ void ApplicationWindow::mainLoop() {
                             m_editor.resizeWindow(window_width, window_height);
                             m_prompt.resizeWindow(window_width, window_height);
                             m_osk.resizeWindow(window_width, window_height);
+                            m_perf_hud.resizeWindow(window_width, window_height);
                             m_context_manager.active().wants_redraw = true;
                         break;
                         default:
@@ -470,6 +581,40 @@ void ApplicationWindow::mainLoop() {
         // press) disarm or replace them first
         m_controller_input.tickRepeat();
         m_osk.tickRepeat(m_context_manager.active(), m_osk_state);
+        previewFeedbackInput();
+
+        // Land the output of the filter once its command is over, inside the undo group of the
+        // macro that ran it, if any; the macro resumes after it. Its progress and its summary
+        // show unless the prompt is busy with something else
+        if (const auto status = FilterCommand::pump(m_context_manager, *m_filter_job)) {
+            const auto &active = m_context_manager.active();
+            if (active.focus_target == FocusTarget::Editor && !active.command_feedback) {
+                m_prompt_state.setRunningState(PromptState::RunningState::Message);
+                resetPrompt(*status);
+            }
+        }
+
+        if (m_macro_recorder->isPlaying() && !m_filter_job->isStarted()) {
+            playMacro();
+        }
+
+        // Stream the grep and search_all entries found since the last frame; each summary shows once
+        // its search is over, unless the prompt is busy with something else
+        if (const auto summary = GrepCommand::pump(m_context_manager, *m_grep_job)) {
+            const auto &active = m_context_manager.active();
+            if (active.focus_target == FocusTarget::Editor && !active.command_feedback) {
+                m_prompt_state.setRunningState(PromptState::RunningState::Message);
+                resetPrompt(*summary);
+            }
+        }
+
+        if (const auto summary = SearchAllCommand::pump(m_context_manager, *m_search_all_job)) {
+            const auto &active = m_context_manager.active();
+            if (active.focus_target == FocusTarget::Editor && !active.command_feedback) {
+                m_prompt_state.setRunningState(PromptState::RunningState::Message);
+                resetPrompt(*summary);
+            }
+        }
 
         // Calculate dt time
         const auto current_time = SDL_GetPerformanceCounter();
@@ -477,6 +622,18 @@ void ApplicationWindow::mainLoop() {
         last_time = current_time;
         // The views always render the active context; fetch it after the events, which may have switched it.
         auto &context = m_context_manager.active();
+
+        // Count the search matches a slice at a time, so the prompt counter fills in between frames
+        if (context.search.index.isCounting()) {
+            const auto slice_deadline = SDL_GetTicks64() + MATCH_COUNT_SLICE_MS;
+            while (SearchCommand::advanceMatchCount(context, MATCH_COUNT_STEP_LINES) && SDL_GetTicks64() < slice_deadline) {}
+        }
+
+        // Only the active buffer takes edits: compact its swap journal once it outgrew the text, and
+        // checkpoint its history every few groups, off the typing path, which only ever appends
+        context.cursor.compactSwap(false);
+        context.cursor.checkpointHistory();
+
         if (context.wants_redraw) {
             // Need to redraw the whole views. A visible on-screen keyboard takes a bottom
             // strip; the prompt sits above it and the editor shrinks — the same path a
@@ -505,23 +662,71 @@ void ApplicationWindow::mainLoop() {
             glClear(GL_COLOR_BUFFER_BIT);
 
             // Render everything on screen.
-            context.highlighter.parse();
+            const auto parse_start_time = SDL_GetPerformanceCounter();
+            if (!m_macro_recorder->isPlaying()) {
+                // The frames showing the progress of a macro draw the tree as it was edited, unparsed
+                context.highlighter.parse();
+            }
+            const auto parse_time_elapsed = static_cast<float>(SDL_GetPerformanceCounter() - parse_start_time) / performance_query;
+            const auto cache_miss_count = context.highlighter.getCacheMissCount();
             m_quad_buffer.resetFrame();
+            m_quad_program.resetDrawCount();
+            m_info_bar_gpu_timer.begin();
             m_info_bar.render(context, m_info_bar_state, m_quad_buffer, dt);
+            m_info_bar_gpu_timer.end();
+            m_editor_gpu_timer.begin();
             m_editor.render(context, m_editor_state, m_quad_buffer, dt);
+            m_editor_gpu_timer.end();
+            m_prompt_gpu_timer.begin();
             m_prompt.render(context, m_prompt_state, m_quad_buffer, dt);
+            m_prompt_gpu_timer.end();
+            m_osk_gpu_timer.begin();
             m_osk.render(context, m_osk_state, m_quad_buffer, dt);
+            m_osk_gpu_timer.end();
+
+            // Fold in whatever the GPU finished so far (earlier frames, most likely); nothing waits here
+            m_info_bar_gpu_timer.collect();
+            m_editor_gpu_timer.collect();
+            m_prompt_gpu_timer.collect();
+            m_osk_gpu_timer.collect();
+            m_info_bar_gpu_time->m_value = m_info_bar_gpu_timer.getMilliseconds();
+            m_editor_gpu_time->m_value = m_editor_gpu_timer.getMilliseconds();
+            m_prompt_gpu_time->m_value = m_prompt_gpu_timer.getMilliseconds();
+            m_osk_gpu_time->m_value = m_osk_gpu_timer.getMilliseconds();
 
             // todo: Uncomment for debug purpose.
             // std::cout << "view updated " << std::endl;
             context.wants_redraw = false;
 
-            // Update max_render_time metrics before the swap, which blocks on vsync
+            // Update max_render_time metrics before the swap, which blocks on vsync. Measured
+            // before the overlay renders, so showing it never changes the number it reports.
             const auto frame_time_elapsed = static_cast<float>(SDL_GetPerformanceCounter() - current_time) / performance_query;
             if (frame_time_elapsed > m_draw_time->m_value) {
                 m_draw_time->m_value = frame_time_elapsed;
             }
 
+            if (m_show_perf_hud->m_value) {
+                // Snapshot the frame first: the overlay's own quads and draw call stay out of it.
+                const auto &atlas_array = m_theme.getAtlasArray();
+                m_perf_hud_state.setStats(PerfHudState::FrameStats{
+                    .quad_count = m_quad_buffer.getFrameCount(),
+                    .draw_count = m_quad_program.getDrawCount(),
+                    .frame_time = frame_time_elapsed,
+                    .parse_time = parse_time_elapsed,
+                    .cache_start_line = context.highlighter.getCacheStartLine(),
+                    .cache_line_count = context.highlighter.getCacheLineCount(),
+                    .cache_miss_count = context.highlighter.getCacheMissCount() - cache_miss_count,
+                    .atlas_layer = atlas_array.getCurrentLayer(),
+                    .atlas_layer_count = atlas_array.getLayerCount(),
+                    .undo_characters = context.cursor.getHistoryCharacters()
+                });
+
+                // The overlay floats over the editor area, whatever the other views took
+                m_perf_hud_state.setPosition(m_editor_state.getPositionX(), m_editor_state.getPositionY());
+                m_perf_hud_state.setSize(m_editor_state.getWidth(), m_editor_state.getHeight());
+                m_perf_hud.render(context, m_perf_hud_state, m_quad_buffer, dt);
+            }
+
             SDL_GL_SwapWindow(p_sdl_window);
         }
 
@@ -540,6 +745,10 @@ void ApplicationWindow::getArgumentsCompletions(const std::u16string_view comman
 
 void ApplicationWindow::destroy() {
     // Destroy renderer objects
+    m_info_bar_gpu_timer.destroy();
+    m_editor_gpu_timer.destroy();
+    m_prompt_gpu_timer.destroy();
+    m_osk_gpu_timer.destroy();
     m_quad_program.destroy();
     m_quad_buffer.destroy();
     m_theme.destroy();
@@ -565,6 +774,23 @@ void ApplicationWindow::dismissMessage() {
     }
 }
 
+void ApplicationWindow::previewFeedbackInput() {
+    auto &context = m_context_manager.active();
+    if (!context.command_feedback || !context.command_feedback->on_input_callback || context.focus_target != FocusTarget::Prompt) {
+        m_previewed_feedback_id = 0;
+        return;
+    }
+
+    const auto input = m_prompt_cursor.getString();
+    if (context.command_feedback->id == m_previewed_feedback_id && input == m_previewed_input) {
+        return;
+    }
+
+    m_previewed_feedback_id = context.command_feedback->id;
+    m_previewed_input = input;
+    context.command_feedback->on_input_callback(input);
+}
+
 void ApplicationWindow::resetPrompt(const std::u16string_view promptText) {
     m_prompt_state.setPromptText(promptText);
     m_prompt_state.clearCompletions();
@@ -581,6 +807,9 @@ bool ApplicationWindow::runCommand(const std::u16string_view command, const bool
     // feedback with its own must still refresh the prompt, and identity is the only way to see it.
     const auto pending_feedback_id = context.command_feedback ? context.command_feedback->id : 0;
     const auto feedback_was_pending = pending_feedback_id != 0;
+    // Only the outermost command can be a step of the macro being recorded: the nested ones (the
+    // lines of an exec, the follow-ups of a feedback) run again when it replays
+    auto may_record = m_command_depth == 0 && m_macro_recorder->isRecording();
     if (fromPrompt && feedback_was_pending) {
         // The prompt input answers the pending feedback instead of being a command.
         // Copy the feedback object so the string is still valid after reset is called.
@@ -590,7 +819,9 @@ bool ApplicationWindow::runCommand(const std::u16string_view command, const bool
 
         // Forward the raw answer so terms containing spaces survive (e.g. search feedback).
         // An empty answer flows to the command too, so it can report its usage.
+        ++m_command_depth;
         result = feedback.on_validate_callback(feedback_answer, feedback.command_string);
+        --m_command_depth;
     } else {
         // Take the scratch by move so a nested runCommand (e.g. exec running script lines) sees an
         // empty member and allocates its own vector, keeping this command's args span valid.
@@ -613,7 +844,11 @@ bool ApplicationWindow::runCommand(const std::u16string_view command, const bool
             return false;
         }
 
-        if (fromPrompt) {
+        // The macro command drives the recorder: it is never a step of a macro. Neither is a bound
+        // command run while the prompt is active, which only ever drives the prompt itself.
+        may_record = may_record && tokens[0] != u"macro" && (fromPrompt || !prompt_is_active);
+
+        if (fromPrompt && !m_macro_recorder->isPlaying()) {
             m_prompt_state.addHistory(command);
 
             // Move focus to the editor if we run this command from the prompt,
@@ -622,7 +857,9 @@ bool ApplicationWindow::runCommand(const std::u16string_view command, const bool
         }
 
         context.from_prompt = fromPrompt;
+        ++m_command_depth;
         result = m_command_manager.run(context, tokens);
+        --m_command_depth;
 
         // The command is done with its args span: give the capacity back for the next call.
         m_token_scratch = std::move(tokens);
@@ -664,5 +901,84 @@ bool ApplicationWindow::runCommand(const std::u16string_view command, const bool
         }
     }
 
+    // A step is recorded once it ran, so the command that started the recording is not one. A bound
+    // command that only opened the prompt for typing is not one either: the line typed there is.
+    if (may_record && m_macro_recorder->isRecording()) {
+        if (fromPrompt) {
+            m_macro_recorder->recordLine(command);
+        } else if (active_context.focus_target != FocusTarget::Prompt || active_context.command_feedback) {
+            m_macro_recorder->recordCommand(command);
+        }
+    }
+
     return true;
 }
+
+void ApplicationWindow::playMacro() {
+    // The whole playback undoes as one step, in every buffer it goes through
+    if (m_macro_recorder->getPlayedStepCount() == 0) {
+        m_context_manager.holdUndoGroups(true);
+    }
+
+    const auto slice_deadline = SDL_GetTicks64() + MACRO_SLICE_MS;
+    while (const auto *const step = m_macro_recorder->nextStep()) {
+        switch (step->type) {
+            case MacroRecorder::StepType::Key:
+                m_keyboard_input.playKey(step->keycode, step->modifiers);
+            break;
+            case MacroRecorder::StepType::Text:
+                m_keyboard_input.playText(step->input.c_str());
+            break;
+            case MacroRecorder::StepType::Command:
+                runCommand(step->text, false);
+            break;
+            case MacroRecorder::StepType::Line:
+                // Confirm the line the way Prompt::confirm does: runCommand reads a pending
+                // feedback answer out of the prompt cursor
+                m_prompt_state.setRunningState(PromptState::RunningState::Idle);
+                m_prompt_state.clearCompletions();
+                m_prompt_state.clearHistoryIndex();
+                m_prompt_cursor.clear();
+                m_prompt_cursor.insert(step->text);
+                runCommand(step->text, true);
+                m_prompt_cursor.clear();
+            break;
+        }
+
+        if (m_filter_job->isStarted()) {
+            // The next steps wait for the filter this one started: they could edit what it reads
+            return;
+        }
+
+        if (SDL_GetTicks64() >= slice_deadline) {
+            auto progress = std::u16string(u"Playing the macro: ");
+            progress.append(utf8::utf8to16(std::to_string(m_macro_recorder->getPlayedCount())));
+            progress.append(u"/").append(utf8::utf8to16(std::to_string(m_macro_recorder->getPlayCount())));
+            progress.append(u" (Escape stops it)");
+            m_prompt_state.setRunningState(PromptState::RunningState::Message);
+            resetPrompt(progress);
+            return;
+        }
+    }
+
+    endMacroPlayback(false);
+}
+
+void ApplicationWindow::endMacroPlayback(const bool stopped) {
+    m_context_manager.holdUndoGroups(false);
+
+    const auto played_count = utf8::utf8to16(std::to_string(m_macro_recorder->getPlayedCount()));
+    const auto play_count = utf8::utf8to16(std::to_string(m_macro_recorder->getPlayCount()));
+    auto message = stopped
+        ? std::u16string(u"Macro stopped after ").append(played_count).append(u" of ").append(play_count)
+        : std::u16string(u"Macro played ").append(played_count);
+    message.append(m_macro_recorder->getPlayCount() == 1 ? u" time." : u" times.");
+
+    // The steps leave the prompt in whatever state the last one did: a message replaces it
+    auto &context = m_context_manager.active();
+    context.command_feedback.reset();
+    context.focus_target = FocusTarget::Editor;
+    context.scroll.follow_indicator = true;
+    m_prompt_state.setRunningState(PromptState::RunningState::Message);
+    resetPrompt(message);
+}
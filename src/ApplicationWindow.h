@@ -32,12 +32,19 @@
 #include "core/cvar/CVarInt.h"
 #include "core/CommandManager.h"
 #include "core/cursor/PromptCursor.h"
+#include "core/renderer/GpuTimer.h"
 #include "core/renderer/QuadBuffer.h"
 #include "core/renderer/QuadProgram.h"
 #include "core/theme/Theme.h"
 #include "core/CursorContextManager.h"
+#include "core/FilterJob.h"
+#include "core/GrepJob.h"
+#include "core/MacroRecorder.h"
+#include "core/SearchAllJob.h"
 #include "command/BindCommand.h"
 #include "editor/Editor.h"
+#include "hud/PerfHud.h"
+#include "hud/PerfHudState.h"
 #include "infobar/InfoBar.h"
 #include "input/ControllerInput.h"
 #include "input/KeyboardInput.h"
@@ -59,6 +66,21 @@ public:
     /** Initial capacity of m_quad_buffer in quads; the buffer regrows on demand. */
     static constexpr uint32_t DEFAULT_QUAD_CAPACITY = 8192;
 
+    /** Number of lines the search match count advances by per step. */
+    static constexpr uint32_t MATCH_COUNT_STEP_LINES = 65536;
+
+    /** Time the search match count may take per loop iteration, in milliseconds, before the frame is drawn. */
+    static constexpr uint64_t MATCH_COUNT_SLICE_MS = 8;
+
+    /** Interval at which a running grep or search_all streams its new entries into the results buffer, in milliseconds. */
+    static constexpr uint64_t GREP_PUMP_INTERVAL_MS = 50;
+
+    /** Interval at which a running filter refreshes its progress, in milliseconds. */
+    static constexpr uint64_t FILTER_PUMP_INTERVAL_MS = 100;
+
+    /** Time a playing macro may take per loop iteration, in milliseconds, before its progress is drawn. */
+    static constexpr uint64_t MACRO_SLICE_MS = 200;
+
 private:
     /** SDL window handle. */
     SDL_Window *p_sdl_window;
@@ -99,6 +121,9 @@ private:
     /** On-screen keyboard view, drawn under the prompt while visible. */
     Osk m_osk;
 
+    /** Performance overlay view, drawn last over the editor while show_perf_hud is set. */
+    PerfHud m_perf_hud;
+
     /** State tracking the info bar. */
     ViewState m_info_bar_state;
 
@@ -111,18 +136,60 @@ private:
     /** State object tracking the on-screen keyboard. */
     OskState m_osk_state;
 
+    /** State object holding the measurements displayed by the performance overlay. */
+    PerfHudState m_perf_hud_state;
+
     /** CVar tracking the maximum command execution time. */
     std::shared_ptr<CVarFloat> m_command_time;
 
     /** CVar tracking the maximum frame time (to render, before swapping). */
     std::shared_ptr<CVarFloat> m_draw_time;
 
+    /** GPU timer measuring the info bar draw. */
+    GpuTimer m_info_bar_gpu_timer;
+
+    /** GPU timer measuring the editor draw. */
+    GpuTimer m_editor_gpu_timer;
+
+    /** GPU timer measuring the prompt draw. */
+    GpuTimer m_prompt_gpu_timer;
+
+    /** GPU timer measuring the on-screen keyboard draw. */
+    GpuTimer m_osk_gpu_timer;
+
+    /** CVar publishing the smoothed GPU time of the info bar, in milliseconds. */
+    std::shared_ptr<CVarFloat> m_info_bar_gpu_time;
+
+    /** CVar publishing the smoothed GPU time of the editor, in milliseconds. */
+    std::shared_ptr<CVarFloat> m_editor_gpu_time;
+
+    /** CVar publishing the smoothed GPU time of the prompt, in milliseconds. */
+    std::shared_ptr<CVarFloat> m_prompt_gpu_time;
+
+    /** CVar publishing the smoothed GPU time of the on-screen keyboard, in milliseconds. */
+    std::shared_ptr<CVarFloat> m_osk_gpu_time;
+
+    /** CVar toggling the performance overlay. */
+    std::shared_ptr<CVarBool> m_show_perf_hud;
+
     /** CVar tracking whether searches match case. */
     std::shared_ptr<CVarBool> m_search_case_sensitive;
 
     /** CVar tracking the size in megabytes past which the open command asks for confirmation; 0 disables it. */
     std::shared_ptr<CVarInt> m_open_size_limit;
 
+    /** The background search of the grep commands, drained into its results buffer between frames. */
+    std::shared_ptr<GrepJob> m_grep_job;
+
+    /** The background search of the search_all command, drained into its results buffer between frames. */
+    std::shared_ptr<SearchAllJob> m_search_all_job;
+
+    /** The shell command the filter command pipes a buffer through, landed between frames. */
+    std::shared_ptr<FilterJob> m_filter_job;
+
+    /** The macro recorder, fed by runCommand and the keyboard input, and played back between frames. */
+    std::shared_ptr<MacroRecorder> m_macro_recorder;
+
     /** The bind command. */
     std::shared_ptr<BindCommand> m_bind_command;
 
@@ -141,6 +208,15 @@ private:
     /** Scratch vector whose capacity is reused by runCommand to tokenize command strings. */
     std::vector<std::u16string_view> m_token_scratch;
 
+    /** Identity of the feedback whose input was last handed to its input callback; 0 for none. */
+    uint64_t m_previewed_feedback_id = 0;
+
+    /** The input last handed to the input callback of that feedback. */
+    std::u16string m_previewed_input;
+
+    /** Number of runCommand calls in progress; only the outermost one can be a step of a macro. */
+    uint32_t m_command_depth = 0;
+
     /**
      * @brief Recomputes the orthogonal projection matrix.
      *
@@ -158,6 +234,30 @@ private:
      */
     void resetPrompt(std::u16string_view promptText);
 
+    /**
+     * @brief Hands the prompt input to the input callback of the pending feedback, when it changed.
+     *
+     * Called once per loop iteration, after the events, so every way of editing the prompt (typing,
+     * the on-screen keyboard, the history) is followed without each of them reporting it.
+     */
+    void previewFeedbackInput();
+
+    /**
+     * @brief Plays the steps of the macro until MACRO_SLICE_MS elapsed, then shows the progress.
+     *
+     * The first slice holds an undo group in every open context, so the whole playback undoes as
+     * one step. Nothing is drawn between the steps, and the frames drawn between the slices skip
+     * the highlighter parse: the tree is reparsed once, after the last step.
+     */
+    void playMacro();
+
+    /**
+     * @brief Ends a macro playback: releases the undo groups and reports how far it went.
+     *
+     * @param stopped Whether the playback was stopped before its end.
+     */
+    void endMacroPlayback(bool stopped);
+
     /**
      * @brief Run the said command.
      *
@@ -230,6 +330,9 @@ private:
      */
     void dismissMessage() override;
 
+    /** @return true while the editor of the buffer a running filter reads has the keyboard focus: its typing is held. */
+    [[nodiscard]] bool holdsFilteredTyping();
+
 public:
     /** @brief Deleted copy constructor. */
     ApplicationWindow(const ApplicationWindow &) = delete;
@@ -237,8 +340,8 @@ public:
     /** @brief Deleted copy assignment operator. */
     ApplicationWindow &operator=(const ApplicationWindow &) = delete;
 
-    /** @brief Release resources helds by ApplicationWindow. */
-    ~ApplicationWindow() override = default;
+    /** @brief Release resources helds by ApplicationWindow, killing the command of a running filter first. */
+    ~ApplicationWindow() override;
 
     /** @brief Constructs the ApplicationWindow with default values. */
     explicit ApplicationWindow();
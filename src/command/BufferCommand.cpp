@@ -99,7 +99,8 @@ std::optional<std::u16string> BufferCommand::run(CursorContext &payload, const s
                         return std::nullopt;
                     }
                     return std::nullopt;
-                }
+                },
+                .on_input_callback = {}
             };
 
             return std::nullopt;
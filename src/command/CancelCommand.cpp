@@ -0,0 +1,50 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "CancelCommand.h"
+
+#include "GrepCommand.h"
+#include "SearchAllCommand.h"
+
+
+CancelCommand::CancelCommand(CursorContextManager &contextManager, std::shared_ptr<GrepJob> grepJob, std::shared_ptr<SearchAllJob> searchAllJob)
+    : m_context_manager(contextManager),
+      m_grep_job(std::move(grepJob)),
+      m_search_all_job(std::move(searchAllJob)) {}
+
+void CancelCommand::provideAutoComplete(const std::span<const std::u16string_view> previousArgs, const int32_t argumentIndex, const std::u16string_view input, const AutoCompleteCallback &itemCallback) const {
+    (void) previousArgs;
+    (void) argumentIndex;
+    (void) input;
+    (void) itemCallback;
+    // No-op
+}
+
+std::optional<std::u16string> CancelCommand::run(CursorContext &payload, const std::span<const std::u16string_view> args) {
+    (void) payload;
+    (void) args;
+
+    const auto grep_summary = GrepCommand::cancel(m_context_manager, *m_grep_job);
+    const auto search_all_summary = SearchAllCommand::cancel(m_context_manager, *m_search_all_job);
+    if (grep_summary && search_all_summary) {
+        return std::u16string(*grep_summary).append(u"; ").append(*search_all_summary);
+    }
+
+    // Nothing to stop: stay silent, the key is also a plain Escape
+    return grep_summary ? grep_summary : search_all_summary;
+}
@@ -0,0 +1,83 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CANCEL_COMMAND_H
+#define CANCEL_COMMAND_H
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../core/base/AutoCompleteCallback.h"
+#include "../core/CursorContext.h"
+#include "../core/CursorContextManager.h"
+#include "../core/base/Command.h"
+#include "../core/GrepJob.h"
+#include "../core/SearchAllJob.h"
+
+
+/**
+ * @brief Command stopping the background searches, grep and search_all, at once.
+ *
+ * Each keeps the entries it listed so far. Bound to Escape, so it stays silent when nothing runs.
+ */
+class CancelCommand final : public Command<CursorContext> {
+private:
+    /** Reference to the manager owning the results buffers. */
+    CursorContextManager &m_context_manager;
+
+    /** The search of the grep commands. */
+    const std::shared_ptr<GrepJob> m_grep_job;
+
+    /** The search of the search_all command. */
+    const std::shared_ptr<SearchAllJob> m_search_all_job;
+
+public:
+    /**
+     * @brief Constructs a CancelCommand.
+     * @param contextManager Reference to the manager owning the results buffers.
+     * @param grepJob The search of the grep commands.
+     * @param searchAllJob The search of the search_all command.
+     */
+    explicit CancelCommand(CursorContextManager &contextManager, std::shared_ptr<GrepJob> grepJob, std::shared_ptr<SearchAllJob> searchAllJob);
+
+    /**
+     * @brief Provides auto-completion suggestions for command arguments.
+     *
+     * This command does not auto-complete.
+     *
+     * @param previousArgs The arguments typed before the one being completed, excluding the command name.
+     * @param argumentIndex The index of the argument currently being completed.
+     * @param input The current partial input from the user for this argument.
+     * @param itemCallback A callback to be invoked with each completion suggestion.
+     */
+    void provideAutoComplete(std::span<const std::u16string_view> previousArgs, int32_t argumentIndex, std::u16string_view input, const AutoCompleteCallback &itemCallback) const override;
+
+    /**
+     * @brief Stops whichever searches run.
+     * @param payload The cursor context that was active when the command was invoked.
+     * @param args Command arguments; none are expected.
+     * @return The summaries of the stopped searches, std::nullopt when none was running.
+     */
+    [[nodiscard]] std::optional<std::u16string> run(CursorContext &payload, std::span<const std::u16string_view> args) override;
+};
+
+
+#endif //CANCEL_COMMAND_H
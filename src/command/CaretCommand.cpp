@@ -0,0 +1,65 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "CaretCommand.h"
+
+#include <array>
+
+
+void CaretCommand::provideAutoComplete(const std::span<const std::u16string_view> previousArgs, const int32_t argumentIndex, const std::u16string_view input, const AutoCompleteCallback &itemCallback) const {
+    (void) previousArgs;
+    if (argumentIndex != 0) {
+        return;
+    }
+
+    static constexpr auto actions = std::array<std::u16string_view, 3> { u"next", u"lines", u"clear" };
+    for (const auto &action : actions) {
+        if (action.starts_with(input)) {
+            itemCallback(action);
+        }
+    }
+}
+
+std::optional<std::u16string> CaretCommand::run(CursorContext &payload, const std::span<const std::u16string_view> args) {
+    if (args.size() != 1) {
+        return u"Usage: caret next|lines|clear";
+    }
+
+    if (args[0] == u"next") {
+        const auto &range = payload.cursor.getSelectedRange();
+        if (!range || range->line_start != range->line_end) {
+            return u"Select text on one line first.";
+        }
+        if (!payload.cursor.addCaretAtNextMatch()) {
+            return u"No other occurrence.";
+        }
+    } else if (args[0] == u"lines") {
+        if (!payload.cursor.addCaretsOnSelectedLines()) {
+            return u"Select more than one line first.";
+        }
+    } else if (args[0] == u"clear") {
+        payload.cursor.clearCarets();
+    } else {
+        return std::u16string(u"Unknown action: ").append(args[0]);
+    }
+
+    payload.stick.index = payload.cursor.getColumn();
+    payload.wants_redraw = true;
+    payload.scroll.follow_indicator = true;
+    return std::nullopt;
+}
@@ -0,0 +1,67 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CARET_COMMAND_H
+#define CARET_COMMAND_H
+
+#include <span>
+#include <string>
+
+#include "../core/base/AutoCompleteCallback.h"
+#include "../core/CursorContext.h"
+#include "../core/base/Command.h"
+
+
+/**
+ * @brief Command for adding carets beside the main one.
+ *
+ * Adds a caret on the next occurrence of the selected text ("next"), or one on each line of the
+ * selection ("lines"), and drops them again ("clear"). Typing, erasing and pasting then apply at
+ * every caret at once.
+ */
+class CaretCommand final : public Command<CursorContext> {
+public:
+    /** @brief Constructs a CaretCommand with default initialization. */
+    explicit CaretCommand() = default;
+
+    /**
+      * @brief Provides auto-completion suggestions for command arguments.
+      *
+      * This command auto-completes argument 0 with "next", "lines" and "clear".
+      *
+      * @param previousArgs The arguments typed before the one being completed, excluding the command name.
+      * @param argumentIndex The index of the argument currently being completed.
+      * @param input The current partial input from the user for this argument.
+      * @param itemCallback A callback to be invoked with each completion suggestion.
+      */
+    void provideAutoComplete(std::span<const std::u16string_view> previousArgs, int32_t argumentIndex, std::u16string_view input, const AutoCompleteCallback &itemCallback) const override;
+
+    /**
+     * @brief Adds or drops the carets.
+     *
+     * This command expects 1 argument: "next", "lines" or "clear".
+     *
+     * @param payload The cursor context holding the carets.
+     * @param args Command arguments.
+     * @return An optional message indicating the result of the operation.
+     */
+    [[nodiscard]] std::optional<std::u16string> run(CursorContext &payload, std::span<const std::u16string_view> args) override;
+};
+
+
+#endif //CARET_COMMAND_H
@@ -0,0 +1,165 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "FilterCommand.h"
+
+#include <algorithm>
+
+#include <utf8.h>
+
+#include "../core/base/ByteSize.h"
+#include "../core/base/NumberText.h"
+
+
+/**
+ * @brief Counts the lines of a text, the last one counting even without a line end.
+ * @param text The text to measure.
+ * @return The number of lines; 0 for an empty text.
+ */
+static uint64_t countLines(const std::u16string_view text) {
+    const auto line_ends = static_cast<uint64_t>(std::ranges::count(text, u'\n'));
+    return text.empty() || text.ends_with(u'\n') ? line_ends : line_ends + 1;
+}
+
+FilterCommand::FilterCommand(std::shared_ptr<FilterJob> job, std::shared_ptr<GrepJob> grepJob, std::shared_ptr<SearchAllJob> searchAllJob)
+    : m_job(std::move(job)),
+      m_grep_job(std::move(grepJob)),
+      m_search_all_job(std::move(searchAllJob)) {}
+
+void FilterCommand::provideAutoComplete(const std::span<const std::u16string_view> previousArgs, const int32_t argumentIndex, const std::u16string_view input, const AutoCompleteCallback &itemCallback) const {
+    (void) previousArgs;
+    (void) argumentIndex;
+    (void) input;
+    (void) itemCallback;
+    // No-op
+}
+
+std::optional<std::u16string> FilterCommand::run(CursorContext &payload, const std::span<const std::u16string_view> args) {
+    if (args.empty()) {
+        // From the prompt the command is mandatory; from the editor, ask for it interactively.
+        if (payload.from_prompt) {
+            return u"Usage: filter <shell command>";
+        }
+
+        payload.command_feedback = requestArgument(u"filter ", u"filter", payload.command_runner);
+        return std::nullopt;
+    }
+
+    if (m_job->isStarted()) {
+        return u"A filter is already running.";
+    }
+
+    if (m_grep_job->isStarted()) {
+        // The search appends to its results buffer between frames, while the filter would read it
+        return u"Wait for grep to finish, or cancel it.";
+    }
+
+    if (m_search_all_job->isStarted()) {
+        return u"Wait for search_all to finish, or cancel it.";
+    }
+
+    // The tokenizer took the quotes off the arguments holding spaces: put them back
+    auto command = std::u16string{};
+    for (const auto &arg : args) {
+        if (!command.empty()) {
+            command.push_back(u' ');
+        }
+        command.append(quoteArgument(arg));
+    }
+
+    const auto &cursor = payload.cursor;
+    const auto last_line = cursor.getLineCount() - 1;
+    const auto range = cursor.getSelectedRange().value_or(TextRange{
+        .line_start = 0,
+        .column_start = 0,
+        .line_end = last_line,
+        .column_end = static_cast<uint32_t>(cursor.getString(last_line).length())
+    });
+
+    if (!m_job->start(cursor, range, utf8::utf16to8(command))) {
+        return std::u16string(u"Could not run: ").append(command);
+    }
+
+    payload.wants_redraw = true;
+    return std::u16string(u"filter: running ").append(command).append(u"...");
+}
+
+std::optional<std::u16string> FilterCommand::pump(CursorContextManager &contextManager, FilterJob &job) {
+    if (!job.isStarted()) {
+        return std::nullopt;
+    }
+
+    if (job.isRunning()) {
+        const auto stats = job.getStats();
+        auto progress = std::u16string(u"Filtering: ");
+        progress.append(utf8::utf8to16(formatByteSize(stats.bytes_written))).append(u" sent, ");
+        progress.append(utf8::utf8to16(formatByteSize(stats.bytes_read))).append(u" received (Escape stops it)");
+        return progress;
+    }
+
+    const auto *const filtered = job.getCursor();
+    const auto range = job.getRange();
+    const auto result = job.takeResult();
+    if (result.cancelled) {
+        return u"filter cancelled";
+    }
+
+    if (result.edited) {
+        // The cursor may be gone too: it is not looked up
+        return u"filter: the buffer changed meanwhile, its output was dropped";
+    }
+
+    if (result.exit_code != 0) {
+        auto message = std::u16string(u"filter failed");
+        if (result.exit_code > 0) {
+            message.append(u" (exit ");
+            appendNumber(message, static_cast<uint64_t>(result.exit_code));
+            message.append(u")");
+        }
+
+        // The first line of the error stream usually says what went wrong
+        const auto error = std::string_view(result.error).substr(0, result.error.find('\n'));
+        if (!error.empty()) {
+            message.append(u": ").append(utf8::utf8to16(utf8::replace_invalid(error)));
+        }
+        return message;
+    }
+
+    for (auto index = size_t{0}; index < contextManager.getCount(); ++index) {
+        auto &context = contextManager.get(index);
+        if (&context.cursor != filtered) {
+            continue;
+        }
+
+        context.notifyEdit(context.cursor.replace(range, result.output));
+        context.stick.index = context.cursor.getColumn();
+        context.search.resetMatches();
+        context.scroll.follow_indicator = true;
+        context.wants_redraw = true;
+
+        auto message = std::u16string(u"filter: replaced ");
+        const auto line_count = range.line_end - range.line_start + (range.column_end > 0 ? 1u : 0u);
+        appendNumber(message, line_count);
+        message.append(u" line(s) with ");
+        appendNumber(message, countLines(result.output));
+        message.append(u" line(s)");
+        return message;
+    }
+
+    return u"filter: the buffer was closed";
+}
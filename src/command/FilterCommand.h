@@ -0,0 +1,103 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILTER_COMMAND_H
+#define FILTER_COMMAND_H
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../core/base/AutoCompleteCallback.h"
+#include "../core/CursorContext.h"
+#include "../core/CursorContextManager.h"
+#include "../core/base/Command.h"
+#include "../core/FilterJob.h"
+#include "../core/GrepJob.h"
+#include "../core/SearchAllJob.h"
+
+
+/**
+ * @brief Command piping the selection, or the whole buffer, through a shell command.
+ *
+ * The text goes to the command's input and its output replaces it, in one undo step, once the
+ * command exited with code 0; otherwise the buffer is left as it was and the start of the error
+ * stream is reported. The command runs in the background (see FilterJob): the filtered buffer
+ * takes no input meanwhile, the others do, and Escape in it kills the command. An edit reaching
+ * the buffer anyway drops the output. pump lands the result between frames.
+ */
+class FilterCommand final : public Command<CursorContext> {
+private:
+    /** The running filter, polled by the main loop. */
+    const std::shared_ptr<FilterJob> m_job;
+
+    /** The background search, which must not append to a buffer while the filter reads it. */
+    const std::shared_ptr<GrepJob> m_grep_job;
+
+    /** The search of search_all, which must not append to its results buffer while the filter reads it either. */
+    const std::shared_ptr<SearchAllJob> m_search_all_job;
+
+public:
+    /**
+     * @brief Constructs a FilterCommand.
+     * @param job The filter polled by the main loop.
+     * @param grepJob The background search of the grep commands.
+     * @param searchAllJob The background search of the search_all command.
+     */
+    explicit FilterCommand(std::shared_ptr<FilterJob> job, std::shared_ptr<GrepJob> grepJob, std::shared_ptr<SearchAllJob> searchAllJob);
+
+    /**
+     * @brief Provides auto-completion suggestions for command arguments.
+     *
+     * The shell command does not auto-complete.
+     *
+     * @param previousArgs The arguments typed before the one being completed, excluding the command name.
+     * @param argumentIndex The index of the argument currently being completed.
+     * @param input The current partial input from the user for this argument.
+     * @param itemCallback A callback to be invoked with each completion suggestion.
+     */
+    void provideAutoComplete(std::span<const std::u16string_view> previousArgs, int32_t argumentIndex, std::u16string_view input, const AutoCompleteCallback &itemCallback) const override;
+
+    /**
+     * @brief Starts piping the selection, or the whole buffer, through a shell command.
+     *
+     * The arguments are joined back into the command line, an argument holding a space being
+     * quoted again. Without arguments, the command line is asked for.
+     *
+     * @param payload The cursor context holding the text.
+     * @param args The words of the shell command.
+     * @return A status or error message.
+     */
+    [[nodiscard]] std::optional<std::u16string> run(CursorContext &payload, std::span<const std::u16string_view> args) override;
+
+    /**
+     * @brief Lands the result of the filter once it is over.
+     *
+     * Meant to be called between frames while the job is started.
+     *
+     * @param contextManager The manager owning the filtered buffer.
+     * @param job The filter to poll.
+     * @return The progress while the filter runs, then its summary.
+     */
+    [[nodiscard]] static std::optional<std::u16string> pump(CursorContextManager &contextManager, FilterJob &job);
+};
+
+
+#endif //FILTER_COMMAND_H
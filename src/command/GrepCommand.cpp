@@ -0,0 +1,193 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "GrepCommand.h"
+
+#include <filesystem>
+
+#include <utf8.h>
+
+#include "../core/CommandManager.h"
+#include "../core/base/NumberText.h"
+#include "../core/base/Regex.h"
+#include "../core/cursor/ParallelSearch.h"
+
+
+/**
+ * @brief Moves the pending entries of a job to the end of the results buffer.
+ * @param contextManager The manager owning the results buffer.
+ * @param job The search to drain.
+ * @return false when the results buffer was closed.
+ */
+static bool appendOutput(CursorContextManager &contextManager, GrepJob &job) {
+    const auto results_index = contextManager.indexOf(GrepCommand::RESULTS_NAME);
+    if (!results_index) {
+        return false;
+    }
+
+    auto output = std::u16string{};
+    if (!job.takeOutput(output)) {
+        return true;
+    }
+
+    auto &results = contextManager.get(*results_index);
+    results.notifyEdit(results.cursor.appendContent(output));
+    if (*results_index == contextManager.getActiveIndex()) {
+        results.wants_redraw = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Describes what a search went through.
+ * @param stats The counters of the search.
+ * @return The summary, such as "3 match(es) in 2 file(s), 10 file(s) searched".
+ */
+static std::u16string summarize(const GrepJob::Stats &stats) {
+    auto summary = std::u16string{};
+    appendNumber(summary, stats.match_count);
+    summary.append(u" match(es) in ");
+    appendNumber(summary, stats.files_matched);
+    summary.append(u" file(s), ");
+    appendNumber(summary, stats.files_scanned);
+    summary.append(u" file(s) searched");
+    if (stats.files_skipped > 0) {
+        summary.append(u", ");
+        appendNumber(summary, stats.files_skipped);
+        summary.append(u" skipped");
+    }
+    return summary;
+}
+
+GrepCommand::GrepCommand(const Action action, CursorContextManager &contextManager, std::shared_ptr<CVarBool> caseSensitive, std::shared_ptr<GrepJob> job)
+    : m_action(action),
+      m_context_manager(contextManager),
+      m_case_sensitive(std::move(caseSensitive)),
+      m_job(std::move(job)) {}
+
+void GrepCommand::provideAutoComplete(const std::span<const std::u16string_view> previousArgs, const int32_t argumentIndex, const std::u16string_view input, const AutoCompleteCallback &itemCallback) const {
+    if (m_action != Action::Grep || previousArgs.empty()) {
+        return;
+    }
+
+    // The directory follows the term, itself after the optional flag
+    const auto directory_index = previousArgs[0] == u"-e" ? 2 : 1;
+    if (argumentIndex == directory_index) {
+        CommandManager::getPathCompletions(input, true, itemCallback);
+    }
+}
+
+std::optional<std::u16string> GrepCommand::run(CursorContext &payload, const std::span<const std::u16string_view> args) {
+    (void) payload;
+
+    switch (m_action) {
+        case Action::Grep:
+            return runGrep(args);
+        case Action::Cancel:
+            // Silent when nothing runs
+            return cancel(m_context_manager, *m_job);
+    }
+
+    return std::nullopt;
+}
+
+std::optional<std::u16string> GrepCommand::runGrep(std::span<const std::u16string_view> args) const {
+    const auto regex = !args.empty() && args.front() == u"-e";
+    if (regex) {
+        args = args.subspan(1);
+    }
+
+    if (args.empty() || args.size() > 2) {
+        return u"Usage: grep [-e] <term> [dir]";
+    }
+
+    const auto term = args[0];
+    if (term.empty()) {
+        return u"Search term is empty.";
+    }
+
+    const auto case_sensitive = m_case_sensitive->m_value;
+    if (regex) {
+        // Compiled once here for the error message; the workers compile their own copies
+        if (const auto pattern = Regex(term, case_sensitive); !pattern.isValid()) {
+            return std::u16string(u"Invalid regex: ").append(pattern.getError());
+        }
+    }
+
+    const auto root = std::filesystem::path(args.size() == 2 ? utf8::utf16to8(args[1]) : std::string("."));
+    auto error_code = std::error_code{};
+    if (!std::filesystem::is_directory(root, error_code)) {
+        return std::u16string(u"Not a directory: ").append(args.size() == 2 ? args[1] : u".");
+    }
+
+    // Empty the results buffer of the previous search, or open one
+    auto results_index = m_context_manager.indexOf(RESULTS_NAME);
+    if (!results_index) {
+        (void) m_context_manager.createContext();
+        results_index = m_context_manager.getCount() - 1;
+    }
+
+    auto &results = m_context_manager.get(*results_index);
+    results.highlighter.setMode(HighLightId::None);
+    for (const auto &edit : results.cursor.loadContent(u"")) {
+        results.notifyEdit(edit);
+    }
+
+    // A listing, not a file: it never asks to be saved
+    results.cursor.setName(RESULTS_NAME);
+    results.cursor.setModified(false);
+    results.scroll.follow_indicator = true;
+    results.stick.active = false;
+    results.stick.index = 0;
+    results.wants_redraw = true;
+    m_context_manager.activate(*results_index);
+
+    m_job->start(root, term, case_sensitive, regex, ParallelSearch::getDefaultThreadCount());
+    return std::u16string(u"grep: searching ").append(args.size() == 2 ? args[1] : u".").append(u"...");
+}
+
+std::optional<std::u16string> GrepCommand::pump(CursorContextManager &contextManager, GrepJob &job) {
+    if (!job.isStarted()) {
+        return std::nullopt;
+    }
+
+    // Read the state first: once the threads are done, the take below gets everything they produced
+    const auto is_done = !job.isRunning();
+    if (!appendOutput(contextManager, job)) {
+        // Nowhere to list the matches any more
+        job.cancel();
+        return u"grep cancelled: results buffer closed";
+    }
+
+    if (!is_done) {
+        return std::nullopt;
+    }
+
+    job.cancel();
+    return summarize(job.getStats());
+}
+
+std::optional<std::u16string> GrepCommand::cancel(CursorContextManager &contextManager, GrepJob &job) {
+    if (!job.isStarted()) {
+        return std::nullopt;
+    }
+
+    job.cancel();
+    (void) appendOutput(contextManager, job);
+    return std::u16string(u"grep cancelled: ").append(summarize(job.getStats()));
+}
@@ -0,0 +1,133 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef GREP_COMMAND_H
+#define GREP_COMMAND_H
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../core/base/AutoCompleteCallback.h"
+#include "../core/CursorContext.h"
+#include "../core/CursorContextManager.h"
+#include "../core/base/Command.h"
+#include "../core/GrepJob.h"
+#include "../core/cvar/CVarBool.h"
+
+
+/**
+ * @brief Command searching the files of a directory tree, listing the matches in a results buffer.
+ *
+ * A single class parameterized by an Action selected at construction, registered once per action;
+ * the instances share the GrepJob running the search. The search runs in the background: the
+ * results buffer, named RESULTS_NAME, is emptied and shown at once, and pump appends the
+ * `file:line:column: text` entries between frames as the job produces them. An entry is reached
+ * with `open <file>` then `goto_line <line>`.
+ */
+class GrepCommand final : public Command<CursorContext> {
+public:
+    /** @brief The concrete behaviour a given instance performs. */
+    enum class Action {
+        Grep,  ///< Start a new search.
+        Cancel ///< Stop the running search.
+    };
+
+private:
+    /** The action performed by this instance. */
+    const Action m_action;
+
+    /** Reference to the manager owning the open cursor contexts. */
+    CursorContextManager &m_context_manager;
+
+    /** CVar controlling whether comparisons are case-sensitive. */
+    const std::shared_ptr<CVarBool> m_case_sensitive;
+
+    /** The search, shared by the instances and polled by the main loop. */
+    const std::shared_ptr<GrepJob> m_job;
+
+    /**
+     * @brief Runs the Grep action: validates the arguments, prepares the results buffer and starts the job.
+     * @param args The command arguments: an optional -e flag, the term and an optional directory.
+     * @return A status or error message.
+     */
+    [[nodiscard]] std::optional<std::u16string> runGrep(std::span<const std::u16string_view> args) const;
+
+public:
+    /** Name of the results buffer. */
+    static constexpr auto RESULTS_NAME = std::string_view("*grep*");
+
+    /**
+     * @brief Constructs a GrepCommand bound to a single action.
+     * @param action The action this instance performs.
+     * @param contextManager Reference to the manager owning the open cursor contexts.
+     * @param caseSensitive The CVar controlling whether comparisons are case-sensitive.
+     * @param job The search shared by the instances.
+     */
+    explicit GrepCommand(Action action, CursorContextManager &contextManager, std::shared_ptr<CVarBool> caseSensitive, std::shared_ptr<GrepJob> job);
+
+    /**
+     * @brief Provides auto-completion suggestions for command arguments.
+     *
+     * The directory argument of grep completes to folder paths; the rest does not auto-complete.
+     *
+     * @param previousArgs The arguments typed before the one being completed, excluding the command name.
+     * @param argumentIndex The index of the argument currently being completed.
+     * @param input The current partial input from the user for this argument.
+     * @param itemCallback A callback to be invoked with each completion suggestion.
+     */
+    void provideAutoComplete(std::span<const std::u16string_view> previousArgs, int32_t argumentIndex, std::u16string_view input, const AutoCompleteCallback &itemCallback) const override;
+
+    /**
+     * @brief Executes the action bound to this instance.
+     *
+     * grep expects the term, quoted when it holds spaces, after an optional -e flag making it a
+     * regular expression, then an optional directory, the working directory by default.
+     * grep_cancel takes no argument, and does nothing when no search runs.
+     *
+     * @param payload The cursor context that was active when the command was invoked.
+     * @param args Command arguments, whose meaning depends on the action.
+     * @return A status or error message.
+     */
+    [[nodiscard]] std::optional<std::u16string> run(CursorContext &payload, std::span<const std::u16string_view> args) override;
+
+    /**
+     * @brief Appends the entries the job produced since the last call to the results buffer.
+     *
+     * Meant to be called between frames while the job is started. Closing the results buffer
+     * cancels the search. Once the job is done and drained, its threads are released.
+     *
+     * @param contextManager The manager owning the results buffer.
+     * @param job The search to drain.
+     * @return The summary of the search once it is over, std::nullopt before.
+     */
+    [[nodiscard]] static std::optional<std::u16string> pump(CursorContextManager &contextManager, GrepJob &job);
+
+    /**
+     * @brief Stops the search, listing what it found so far.
+     * @param contextManager The manager owning the results buffer.
+     * @param job The search to stop.
+     * @return The summary of the search, std::nullopt when none was running.
+     */
+    [[nodiscard]] static std::optional<std::u16string> cancel(CursorContextManager &contextManager, GrepJob &job);
+};
+
+
+#endif //GREP_COMMAND_H
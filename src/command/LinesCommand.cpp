@@ -0,0 +1,116 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "LinesCommand.h"
+
+#include <algorithm>
+#include <array>
+#include <ranges>
+#include <string>
+#include <utility>
+
+#include "../core/base/NumberText.h"
+#include "../core/cursor/LineTransform.h"
+#include "../core/cursor/ParallelSearch.h"
+
+
+/** The actions, with the rewrite each one applies. */
+static constexpr auto ACTIONS = std::array<std::pair<std::u16string_view, LineTransform::Kind>, 5> {{
+    { u"sort", LineTransform::Kind::Sort },
+    { u"sort_numeric", LineTransform::Kind::SortNumeric },
+    { u"unique", LineTransform::Kind::Unique },
+    { u"reverse", LineTransform::Kind::Reverse },
+    { u"trim", LineTransform::Kind::Trim }
+}};
+
+void LinesCommand::provideAutoComplete(const std::span<const std::u16string_view> previousArgs, const int32_t argumentIndex, const std::u16string_view input, const AutoCompleteCallback &itemCallback) const {
+    (void) previousArgs;
+    if (argumentIndex != 0) {
+        return;
+    }
+
+    for (const auto &action : ACTIONS | std::views::keys) {
+        if (action.starts_with(input)) {
+            itemCallback(action);
+        }
+    }
+}
+
+std::optional<std::u16string> LinesCommand::run(CursorContext &payload, const std::span<const std::u16string_view> args) {
+    if (args.size() != 1) {
+        return u"Usage: lines sort|sort_numeric|unique|reverse|trim";
+    }
+
+    const auto action = std::ranges::find(ACTIONS, args[0], &std::pair<std::u16string_view, LineTransform::Kind>::first);
+    if (action == ACTIONS.end()) {
+        return std::u16string(u"Unknown action: ").append(args[0]);
+    }
+
+    // The lines the selection touches, not the one it ends at the start of; the whole buffer
+    // without a selection, less the empty line after a final line end
+    auto &cursor = payload.cursor;
+    auto first_line = 0u;
+    auto last_line = cursor.getLineCount() - 1;
+    if (const auto &range = cursor.getSelectedRange()) {
+        first_line = range->line_start;
+        last_line = range->column_end == 0 && range->line_end > range->line_start ? range->line_end - 1 : range->line_end;
+    } else if (last_line > 0 && cursor.getString(last_line).empty()) {
+        --last_line;
+    }
+
+    const auto kind = action->second;
+    const auto result = LineTransform::apply(cursor, first_line, last_line, kind, ParallelSearch::getDefaultThreadCount());
+    if (result.edit) {
+        payload.notifyEdit(*result.edit);
+    }
+
+    // The lines stay selected, ready for the next rewrite
+    const auto end_line = first_line + result.line_count - 1;
+    cursor.clearCarets();
+    cursor.activateSelection(false);
+    cursor.setPosition(first_line, 0);
+    cursor.activateSelection(true);
+    cursor.setPosition(end_line, static_cast<uint32_t>(cursor.getString(end_line).length()));
+
+    payload.stick.index = cursor.getColumn();
+    payload.search.resetMatches();
+    payload.wants_redraw = true;
+    payload.scroll.follow_indicator = true;
+
+    auto message = std::u16string{};
+    switch (kind) {
+        case LineTransform::Kind::Unique:
+            message = u"removed ";
+            appendNumber(message, result.changed);
+            message.append(u" duplicate line(s)");
+            break;
+        case LineTransform::Kind::Trim:
+            message = u"trimmed ";
+            appendNumber(message, result.changed);
+            message.append(u" line(s)");
+            break;
+        default:
+            message = u"moved ";
+            appendNumber(message, result.changed);
+            message.append(u" of ");
+            appendNumber(message, result.line_count);
+            message.append(u" line(s)");
+            break;
+    }
+    return message;
+}
@@ -0,0 +1,68 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINES_COMMAND_H
+#define LINES_COMMAND_H
+
+#include <span>
+#include <string>
+
+#include "../core/base/AutoCompleteCallback.h"
+#include "../core/CursorContext.h"
+#include "../core/base/Command.h"
+
+
+/**
+ * @brief Command for rewriting whole lines at once.
+ *
+ * Sorts the lines ("sort", or "sort_numeric" by the number each starts with), drops the repeated
+ * ones ("unique"), reverses them ("reverse") or trims their trailing blanks ("trim"). It works on
+ * the lines the selection touches, or on the whole buffer without one, and lands as one undo step
+ * and one edit for the highlighter (see LineTransform).
+ */
+class LinesCommand final : public Command<CursorContext> {
+public:
+    /** @brief Constructs a LinesCommand with default initialization. */
+    explicit LinesCommand() = default;
+
+    /**
+      * @brief Provides auto-completion suggestions for command arguments.
+      *
+      * This command auto-completes argument 0 with "sort", "sort_numeric", "unique", "reverse" and "trim".
+      *
+      * @param previousArgs The arguments typed before the one being completed, excluding the command name.
+      * @param argumentIndex The index of the argument currently being completed.
+      * @param input The current partial input from the user for this argument.
+      * @param itemCallback A callback to be invoked with each completion suggestion.
+      */
+    void provideAutoComplete(std::span<const std::u16string_view> previousArgs, int32_t argumentIndex, std::u16string_view input, const AutoCompleteCallback &itemCallback) const override;
+
+    /**
+     * @brief Rewrites the lines, then selects them.
+     *
+     * This command expects 1 argument: "sort", "sort_numeric", "unique", "reverse" or "trim".
+     *
+     * @param payload The cursor context holding the lines.
+     * @param args Command arguments.
+     * @return An optional message indicating the result of the operation.
+     */
+    [[nodiscard]] std::optional<std::u16string> run(CursorContext &payload, std::span<const std::u16string_view> args) override;
+};
+
+
+#endif //LINES_COMMAND_H
@@ -0,0 +1,93 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "MacroCommand.h"
+
+#include <array>
+#include <charconv>
+#include <system_error>
+#include <utility>
+
+#include <utf8/cpp17.h>
+
+
+MacroCommand::MacroCommand(std::shared_ptr<MacroRecorder> recorder)
+    : m_recorder(std::move(recorder)) {}
+
+void MacroCommand::provideAutoComplete(const std::span<const std::u16string_view> previousArgs, const int32_t argumentIndex, const std::u16string_view input, const AutoCompleteCallback &itemCallback) const {
+    (void) previousArgs;
+    if (argumentIndex != 0) {
+        return;
+    }
+
+    static constexpr auto actions = std::array<std::u16string_view, 3> { u"record", u"stop", u"play" };
+    for (const auto &action : actions) {
+        if (action.starts_with(input)) {
+            itemCallback(action);
+        }
+    }
+}
+
+std::optional<std::u16string> MacroCommand::run(CursorContext &payload, const std::span<const std::u16string_view> args) {
+    (void) payload;
+    if (args.empty() || args.size() > 2 || (args.size() == 2 && args[0] != u"play")) {
+        return u"Usage: macro record|stop|play [count]";
+    }
+
+    if (args[0] == u"record") {
+        if (!m_recorder->startRecording()) {
+            return u"A macro is already being recorded.";
+        }
+        return u"Recording a macro; \"macro stop\" ends it.";
+    }
+
+    if (args[0] == u"stop") {
+        if (!m_recorder->stopRecording()) {
+            return u"No macro is being recorded.";
+        }
+
+        const auto step_count = m_recorder->getStepCount();
+        return std::u16string(u"Macro recorded: ").append(utf8::utf8to16(std::to_string(step_count))).append(step_count == 1 ? u" step." : u" steps.");
+    }
+
+    if (args[0] == u"play") {
+        auto count = uint32_t{1};
+        if (args.size() == 2) {
+            const auto arg = utf8::utf16to8(args[1]);
+            const auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.length(), count);
+            if (ec != std::errc{} || ptr != arg.data() + arg.length() || count == 0) {
+                return u"Expected a positive count.";
+            }
+        }
+
+        if (m_recorder->isRecording()) {
+            return u"Stop the recording first.";
+        }
+        if (m_recorder->getStepCount() == 0) {
+            return u"No macro recorded.";
+        }
+        if (!m_recorder->startPlayback(count)) {
+            return u"A macro is already playing.";
+        }
+
+        // The main loop takes it from here
+        return std::nullopt;
+    }
+
+    return std::u16string(u"Unknown action: ").append(args[0]);
+}
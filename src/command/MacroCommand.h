@@ -0,0 +1,78 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MACRO_COMMAND_H
+#define MACRO_COMMAND_H
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../core/base/AutoCompleteCallback.h"
+#include "../core/CursorContext.h"
+#include "../core/base/Command.h"
+#include "../core/MacroRecorder.h"
+
+
+/**
+ * @brief Command recording the input into a macro and playing it back.
+ *
+ * "record" starts a recording, "stop" ends it, and "play [count]" replays the macro count times.
+ * The playback itself runs from the main loop, a slice at a time, with the progress shown in the
+ * prompt; Escape stops it.
+ */
+class MacroCommand final : public Command<CursorContext> {
+private:
+    /** The recorder, shared with the keyboard input and polled by the main loop. */
+    const std::shared_ptr<MacroRecorder> m_recorder;
+
+public:
+    /**
+     * @brief Constructs a MacroCommand driving the given recorder.
+     * @param recorder The macro recorder.
+     */
+    explicit MacroCommand(std::shared_ptr<MacroRecorder> recorder);
+
+    /**
+      * @brief Provides auto-completion suggestions for command arguments.
+      *
+      * This command auto-completes argument 0 with "record", "stop" and "play".
+      *
+      * @param previousArgs The arguments typed before the one being completed, excluding the command name.
+      * @param argumentIndex The index of the argument currently being completed.
+      * @param input The current partial input from the user for this argument.
+      * @param itemCallback A callback to be invoked with each completion suggestion.
+      */
+    void provideAutoComplete(std::span<const std::u16string_view> previousArgs, int32_t argumentIndex, std::u16string_view input, const AutoCompleteCallback &itemCallback) const override;
+
+    /**
+     * @brief Starts or stops the recording, or starts the playback.
+     *
+     * This command expects "record", "stop", or "play" followed by an optional count.
+     *
+     * @param payload The cursor context (unused).
+     * @param args Command arguments.
+     * @return An optional message indicating the result of the operation.
+     */
+    [[nodiscard]] std::optional<std::u16string> run(CursorContext &payload, std::span<const std::u16string_view> args) override;
+};
+
+
+#endif //MACRO_COMMAND_H
@@ -0,0 +1,73 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "MemCommand.h"
+
+#include <format>
+
+#include <utf8.h>
+
+#include "../core/base/ByteSize.h"
+
+
+MemCommand::MemCommand(CursorContextManager &contextManager, const Theme &theme, const QuadBuffer &quadBuffer)
+    : m_context_manager(contextManager),
+      m_theme(theme),
+      m_quad_buffer(quadBuffer) {}
+
+void MemCommand::provideAutoComplete(const std::span<const std::u16string_view> previousArgs, const int32_t argumentIndex, const std::u16string_view input, const AutoCompleteCallback &itemCallback) const {
+    (void) previousArgs;
+    constexpr auto all_argument = std::u16string_view(u"all");
+    if (argumentIndex == 0 && all_argument.starts_with(input)) {
+        itemCallback(all_argument);
+    }
+}
+
+std::optional<std::u16string> MemCommand::run(CursorContext &payload, const std::span<const std::u16string_view> args) {
+    if (args.empty()) {
+        const auto usage = payload.getMemoryUsage();
+        return utf8::utf8to16(std::format("buffer {}: text {}, lines {}, metrics {}, undo {}, hl cache {}, tree ~{}, search {}",
+            formatByteSize(usage.total()),
+            formatByteSize(usage.buffer.text),
+            formatByteSize(usage.buffer.line_table),
+            formatByteSize(usage.buffer.line_metrics),
+            formatByteSize(usage.undo_history),
+            formatByteSize(usage.highlight_cache),
+            formatByteSize(usage.syntax_tree),
+            formatByteSize(usage.search_index)));
+    }
+
+    if (args.size() != 1 || args[0] != u"all") {
+        return u"Usage: mem [all]";
+    }
+
+    auto buffers_bytes = std::size_t{0};
+    const auto buffer_count = m_context_manager.getCount();
+    for (size_t index = 0; index < buffer_count; ++index) {
+        buffers_bytes += m_context_manager.get(index).getMemoryUsage().total();
+    }
+
+    const auto atlas_bytes = m_theme.getAtlasMemoryUsage();
+    const auto quad_bytes = m_quad_buffer.getMemoryUsage();
+    return utf8::utf8to16(std::format("total {}: {} buffers {}, atlas {}, quads {}",
+        formatByteSize(buffers_bytes + atlas_bytes + quad_bytes),
+        buffer_count,
+        formatByteSize(buffers_bytes),
+        formatByteSize(atlas_bytes),
+        formatByteSize(quad_bytes)));
+}
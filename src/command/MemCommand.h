@@ -0,0 +1,84 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MEM_COMMAND_H
+#define MEM_COMMAND_H
+
+#include <span>
+#include <string>
+
+#include "../core/base/AutoCompleteCallback.h"
+#include "../core/CursorContext.h"
+#include "../core/CursorContextManager.h"
+#include "../core/base/Command.h"
+#include "../core/renderer/QuadBuffer.h"
+#include "../core/theme/Theme.h"
+
+
+/**
+ * @brief Command reporting where the editor memory goes.
+ *
+ * Without argument, breaks down the active buffer: text, line table, line metrics, undo history,
+ * highlight cache and syntax tree. With "all", sums every open buffer and adds the process-wide
+ * glyph atlases and quad buffer.
+ */
+class MemCommand final : public Command<CursorContext> {
+private:
+    /** Reference to the manager owning the open cursor contexts. */
+    CursorContextManager &m_context_manager;
+
+    /** Reference to the theme owning the glyph atlases. */
+    const Theme &m_theme;
+
+    /** Reference to the quad buffer shared by every view. */
+    const QuadBuffer &m_quad_buffer;
+
+public:
+    /**
+     * @brief Constructs a MemCommand reading the given subsystems.
+     *
+     * @param contextManager Reference to the manager owning the open cursor contexts.
+     * @param theme Reference to the theme owning the glyph atlases.
+     * @param quadBuffer Reference to the quad buffer shared by every view.
+     */
+    explicit MemCommand(CursorContextManager &contextManager, const Theme &theme, const QuadBuffer &quadBuffer);
+
+    /**
+     * @brief Provides auto-completion suggestions for command arguments.
+     *
+     * Completes the first argument with "all".
+     *
+     * @param previousArgs The arguments typed before the one being completed, excluding the command name.
+     * @param argumentIndex The index of the argument currently being completed.
+     * @param input The current partial input from the user for this argument.
+     * @param itemCallback A callback to be invoked with each completion suggestion.
+     */
+    void provideAutoComplete(std::span<const std::u16string_view> previousArgs, int32_t argumentIndex, std::u16string_view input, const AutoCompleteCallback &itemCallback) const override;
+
+    /**
+     * @brief Reports the memory breakdown.
+     *
+     * @param payload The cursor context whose buffer is broken down.
+     * @param args Nothing for the active buffer, or "all" for the process-wide totals.
+     * @return The breakdown, or a usage message.
+     */
+    [[nodiscard]] std::optional<std::u16string> run(CursorContext &payload, std::span<const std::u16string_view> args) override;
+};
+
+
+#endif //MEM_COMMAND_H
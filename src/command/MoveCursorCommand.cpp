@@ -226,7 +226,8 @@ void MoveCursorCommand::stickToColumn(CursorContext &payload, const uint32_t lin
         return;
     }
 
-    if (payload.stick.active) {
+    // Placing the main caret is a jump, which would drop the extra carets: they each keep the column they clamped to
+    if (payload.stick.active && payload.cursor.getCaretCount() == 1) {
         const auto cursor_line = payload.cursor.getLine();
         const auto string_length = static_cast<uint32_t>(payload.cursor.getString().length());
         const auto new_column = std::min(payload.stick.index, string_length);
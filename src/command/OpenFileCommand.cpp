@@ -18,6 +18,7 @@
  */
 #include "OpenFileCommand.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <format>
 #include <fstream>
@@ -29,6 +30,7 @@
 
 #include "../core/CommandManager.h"
 #include "../core/base/OpenSizeLimit.h"
+#include "../core/cursor/SwapJournal.h"
 
 
 OpenFileCommand::OpenFileCommand(CursorContextManager &contextManager, std::shared_ptr<CVarInt> openSizeLimit)
@@ -40,11 +42,17 @@ void OpenFileCommand::provideAutoComplete(const std::span<const std::u16string_v
     if (argumentIndex == 0) {
         // The first argument is the path
         CommandManager::getPathCompletions(input, false, itemCallback);
-    } else if (argumentIndex == 1) {
-        // The second argument can only be the force flag
-        constexpr auto force_flag = std::u16string_view(u"-f");
-        if (force_flag.starts_with(input)) {
-            itemCallback(force_flag);
+    } else if (argumentIndex > 0) {
+        // The other arguments are the flags not typed yet; -r and -d exclude each other
+        const auto typed = [&previousArgs](const std::u16string_view flag) {
+            return std::ranges::find(previousArgs, flag) != previousArgs.end();
+        };
+        for (const auto flag : {u"-f", u"-r", u"-d"}) {
+            const auto flag_view = std::u16string_view(flag);
+            const auto excluded = (flag_view == u"-r" && typed(u"-d")) || (flag_view == u"-d" && typed(u"-r"));
+            if (!typed(flag_view) && !excluded && flag_view.starts_with(input)) {
+                itemCallback(flag_view);
+            }
         }
     }
 }
@@ -53,7 +61,7 @@ std::optional<std::u16string> OpenFileCommand::run(CursorContext &payload, const
     if (args.empty()) {
         // From the prompt the filename is mandatory; from the editor, ask for it interactively.
         if (payload.from_prompt) {
-            return u"Usage: open <filename> [-f]";
+            return u"Usage: open <filename> [-f] [-r|-d]";
         }
 
         payload.command_feedback = requestPathArgument(u"open ", u"open", payload.command_runner,
@@ -64,12 +72,21 @@ std::optional<std::u16string> OpenFileCommand::run(CursorContext &payload, const
         return std::nullopt;
     }
 
-    if (args.size() > 2 || (args.size() == 2 && args[1] != u"-f")) {
-        return u"Usage: open <filename> [-f]";
+    // Read the flags once: -f skips the large-file confirmation below, -r and -d answer the recovery one.
+    auto force_open = false;
+    auto recover_swap = false;
+    auto discard_swap = false;
+    for (const auto flag : args.subspan(1)) {
+        auto &seen = flag == u"-f" ? force_open : flag == u"-r" ? recover_swap : discard_swap;
+        if ((flag != u"-f" && flag != u"-r" && flag != u"-d") || seen) {
+            return u"Usage: open <filename> [-f] [-r|-d]";
+        }
+        seen = true;
     }
 
-    // Read the force flag once: it skips the large-file confirmation below.
-    const auto force_open = args.size() == 2 && args[1] == u"-f";
+    if (recover_swap && discard_swap) {
+        return u"Usage: open <filename> [-f] [-r|-d]";
+    }
 
     const auto path = utf8::utf16to8(args[0]);
 
@@ -110,7 +127,30 @@ std::optional<std::u16string> OpenFileCommand::run(CursorContext &payload, const
                     return std::nullopt;
                 }
                 return std::nullopt;
-            }
+            },
+            .on_input_callback = {}
+        };
+
+        return std::nullopt;
+    }
+
+    // A swap file newer than the file means a session ended before saving its edits: offer them back.
+    // Either answer reruns the command with the size confirmation already given.
+    if (!recover_swap && !discard_swap && SwapJournal::hasRecovery(path)) {
+        payload.command_feedback = CommandFeedback {
+            .prompt_message = u"Recover unsaved changes from the swap file ? [y/N]: ",
+            .command_string = std::u16string(u"open ").append(quoteArgument(args[0])).append(u" -f"),
+            .on_complete_callback = [](const std::u16string_view input, const AutoCompleteCallback &itemCallback) {
+                (void) input;
+                itemCallback(u"n");
+                itemCallback(u"y");
+            },
+            .on_validate_callback = [&](const std::u16string_view input, const std::u16string_view command) -> std::optional<std::u16string> {
+                const auto recover = input == u"y" || input == u"Y";
+                payload.command_runner.runCommand(std::u16string(command).append(recover ? u" -r" : u" -d"), true);
+                return std::nullopt;
+            },
+            .on_input_callback = {}
         };
 
         return std::nullopt;
@@ -124,6 +164,17 @@ std::optional<std::u16string> OpenFileCommand::run(CursorContext &payload, const
         return error;
     }
 
+    // Replay the swap file over the file before anything is loaded, so an unreadable one changes nothing.
+    // Discarding needs no work here: loading the file rebases its journal, which removes the swap file.
+    auto recovery = std::optional<SwapJournal::Recovery>{};
+    if (recover_swap) {
+        recovery = SwapJournal::recover(SwapJournal::pathFor(path), content);
+        if (!recovery) {
+            return std::u16string(u"Could not read the swap file of ").append(args[0]).append(u", open it with -d to discard it.");
+        }
+        content = std::move(recovery->content);
+    }
+
     // Load in place when the active context is pristine (no name, empty buffer);
     // otherwise the file opens in its own new context.
     auto &active = m_context_manager.active();
@@ -142,7 +193,18 @@ std::optional<std::u16string> OpenFileCommand::run(CursorContext &payload, const
 
     // In case the command is bound to a key, it will eventually needs a redraw the views.
     payload.wants_redraw = true;
-    return std::nullopt;
+    if (!recovery) {
+        return std::nullopt;
+    }
+
+    // The recovered edits are not on disk: the buffer is modified, and its journal starts over from
+    // a snapshot of it, since the edits would no longer apply to the file
+    auto &cursor = m_context_manager.active().cursor;
+    cursor.setModified(true);
+    cursor.compactSwap(true);
+
+    return utf8::utf8to16(std::format("Recovered {} edits{}", recovery->edit_count,
+        recovery->complete ? "." : ", the swap file was cut short: the last ones may be missing."));
 }
 
 std::optional<size_t> OpenFileCommand::findOpenContext(const std::string &path) const {
@@ -242,12 +304,15 @@ void OpenFileCommand::loadInto(CursorContext &target, const std::string &path, c
     // Replace the buffer whole. loadContent keeps it out of the undo history, which also discards
     // the history of the previous buffer, and puts the caret back at the origin.
     for (const auto &edit : target.cursor.loadContent(content)) {
-        target.highlighter.edit(edit);
+        target.notifyEdit(edit);
     }
 
-    // Set cursor name. A freshly loaded buffer matches the disk, so it starts clean.
+    // Set cursor name. A freshly loaded buffer matches the disk, so it starts clean. The journal is
+    // attached after the load, which it has no use for, and the clean state rebases it: a swap file
+    // left over for this file is removed.
     target.cursor.setName(path);
     target.cursor.setLineEnding(lineEnding);
+    target.cursor.attachSwap(std::make_unique<SwapJournal>(SwapJournal::pathFor(path)));
     target.cursor.setModified(false);
     target.scroll.follow_indicator = true;
     target.stick.active = false;
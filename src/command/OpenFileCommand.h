@@ -46,6 +46,8 @@
  * so the same file never lives in two diverging buffers.
  * Opening a file larger than the open_size_limit CVar asks for confirmation first,
  * which the -f flag skips.
+ * A swap file left newer than the file by a session that ended before saving offers its
+ * edits back: the -r flag replays them over the file, the -d flag discards them.
  */
 class OpenFileCommand final : public Command<CursorContext> {
 private:
@@ -85,6 +87,7 @@ private:
      *
      * Switches the highlight mode from the file extension, names the cursor after
      * the path, resets its position and scroll state, and discards the undo history.
+     * The buffer is then journaled to the swap file of the path, which starts empty.
      *
      * @param target The context receiving the file content.
      * @param path UTF-8 encoded path of the loaded file.
@@ -106,7 +109,7 @@ public:
      * @brief Provides auto-completion suggestions for file paths.
      *
      * This command auto-completes argument 0 which is the file path,
-     * and argument 1 which can only be the -f flag.
+     * and the following ones with the -f, -r and -d flags not typed yet.
      *
      * @param previousArgs The arguments typed before the one being completed, excluding the command name.
      * @param argumentIndex The index of the argument currently being completed.
@@ -120,7 +123,8 @@ public:
      *
      * Opens the specified file and loads its content into the editor.
      * Expect 1 argument which is the file path. The file path must be "quoted" if it contains blank characters (spaces).
-     * An optional second argument, -f, skips the large-file confirmation.
+     * The optional flags follow: -f skips the large-file confirmation, -r recovers the
+     * unsaved edits of the swap file and -d discards them; -r and -d exclude each other.
      *
      * @param payload The cursor context that will be updated with the new file content.
      * @param args Command arguments specifying the file path to open.
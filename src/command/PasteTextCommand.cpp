@@ -55,12 +55,19 @@ std::optional<std::u16string> PasteTextCommand::run(CursorContext &payload, cons
         return u"Clipboard is empty.";
     }
 
-    // Pasting over a selection replaces it, and deactivates it either way.
-    payload.eraseSelectionIfAny();
+    if (payload.cursor.getCaretCount() > 1) {
+        // The clipboard goes in at every caret, over what each one selects, as one step
+        if (const auto &edit = payload.cursor.insertAtCarets(utf16_clipboard_text)) {
+            payload.notifyEdit(*edit);
+        }
+    } else {
+        // Pasting over a selection replaces it, and deactivates it either way.
+        payload.eraseSelectionIfAny();
 
-    // Append the text at the cursor position
-    const auto &edit = payload.cursor.insert(utf16_clipboard_text);
-    payload.highlighter.edit(edit);
+        // Append the text at the cursor position
+        const auto &edit = payload.cursor.insert(utf16_clipboard_text);
+        payload.notifyEdit(edit);
+    }
 
     // The pasted text moved the cursor: the next vertical move must aim at the column it landed
     // on, not at the one the last up/down move armed on a previous line.
@@ -65,7 +65,8 @@ std::optional<std::u16string> QuitCommand::run(CursorContext &payload, const std
                         return std::nullopt;
                     }
                     return std::nullopt;
-                }
+                },
+                .on_input_callback = {}
             };
 
             return std::nullopt;
@@ -38,10 +38,8 @@ std::optional<std::u16string> RedoCommand::run(CursorContext &payload, const std
     }
 
     // A group can hold more than one edit; tree-sitter takes them in sequence and merges the
-    // dirty span itself, so each one is relayed as it comes.
-    for (const auto &edit : edits) {
-        payload.highlighter.edit(edit);
-    }
+    // dirty span itself, while the search index folds them into one shift.
+    payload.notifyEdits(edits);
     payload.cursor.activateSelection(false);
     payload.stick.index = payload.cursor.getColumn();
     payload.search.resetMatches();
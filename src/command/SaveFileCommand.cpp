@@ -20,6 +20,7 @@
 
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <system_error>
 #include <utility>
 
@@ -27,6 +28,7 @@
 
 #include "../core/CommandManager.h"
 #include "../core/base/LineEnding.h"
+#include "../core/cursor/SwapJournal.h"
 
 
 /** @brief Writes a UTF-8 payload to a path, truncating it; returns false when anything went wrong. */
@@ -118,7 +120,8 @@ std::optional<std::u16string> SaveFileCommand::run(CursorContext &payload, const
                     return std::nullopt;
                 }
                 return std::nullopt;
-            }
+            },
+            .on_input_callback = {}
         };
 
         return std::nullopt;
@@ -171,7 +174,11 @@ std::optional<std::u16string> SaveFileCommand::run(CursorContext &payload, const
         }
     }
 
-    // The file is written: set the cursor name, and the buffer content now matches the disk.
+    // The file is written: set the cursor name, and the buffer content now matches the disk. Saving
+    // under another name moves the journal to the swap file of that name; the clean state rebases it.
+    if (!is_same_file || payload.cursor.getSwap() == nullptr) {
+        payload.cursor.attachSwap(std::make_unique<SwapJournal>(SwapJournal::pathFor(file_to_save.string())));
+    }
     payload.cursor.setName(file_to_save.string());
     payload.cursor.setModified(false);
 
@@ -0,0 +1,199 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "SearchAllCommand.h"
+
+#include <vector>
+
+#include <utf8.h>
+
+#include "../core/base/NumberText.h"
+#include "../core/base/Regex.h"
+#include "../core/cursor/ParallelSearch.h"
+
+
+/**
+ * @brief Moves the pending entries of a job to the end of the results buffer.
+ * @param contextManager The manager owning the results buffer.
+ * @param job The search to drain.
+ * @return false when the results buffer was closed.
+ */
+static bool appendOutput(CursorContextManager &contextManager, SearchAllJob &job) {
+    const auto results_index = contextManager.indexOf(SearchAllCommand::RESULTS_NAME);
+    if (!results_index) {
+        return false;
+    }
+
+    auto output = std::u16string{};
+    if (!job.takeOutput(output)) {
+        return true;
+    }
+
+    auto &results = contextManager.get(*results_index);
+    results.notifyEdit(results.cursor.appendContent(output));
+    if (*results_index == contextManager.getActiveIndex()) {
+        results.wants_redraw = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Describes what a search found.
+ * @param stats The counters of the search.
+ * @return The summary, such as "3 match(es) in 2 buffer(s)".
+ */
+static std::u16string summarize(const SearchAllJob::Stats &stats) {
+    auto summary = std::u16string{};
+    if (stats.match_count == 0) {
+        summary = u"not found";
+    } else {
+        appendNumber(summary, stats.match_count);
+        summary.append(u" match(es) in ");
+        appendNumber(summary, stats.buffers_matched);
+        summary.append(u" buffer(s)");
+        if (stats.buffers_truncated > 0) {
+            summary.append(u", listing ");
+            appendNumber(summary, SearchAllCommand::MAX_MATCHES_PER_BUFFER);
+            summary.append(u" per buffer at most");
+        }
+    }
+
+    if (stats.buffers_edited > 0) {
+        summary.append(u", ");
+        appendNumber(summary, stats.buffers_edited);
+        summary.append(u" buffer(s) edited or closed during the search, listed in part");
+    }
+    return summary;
+}
+
+SearchAllCommand::SearchAllCommand(CursorContextManager &contextManager, std::shared_ptr<CVarBool> caseSensitive, std::shared_ptr<SearchAllJob> job)
+    : m_context_manager(contextManager),
+      m_case_sensitive(std::move(caseSensitive)),
+      m_job(std::move(job)) {}
+
+void SearchAllCommand::provideAutoComplete(const std::span<const std::u16string_view> previousArgs, const int32_t argumentIndex, const std::u16string_view input, const AutoCompleteCallback &itemCallback) const {
+    (void) previousArgs;
+    (void) argumentIndex;
+    (void) input;
+    (void) itemCallback;
+    // No-op
+}
+
+std::optional<std::u16string> SearchAllCommand::run(CursorContext &payload, std::span<const std::u16string_view> args) {
+    (void) payload;
+
+    const auto regex = !args.empty() && args.front() == u"-e";
+    if (regex) {
+        args = args.subspan(1);
+    }
+
+    if (args.empty()) {
+        return u"Usage: search_all [-e] <term>";
+    }
+
+    auto term = std::u16string{};
+    for (auto index = 0u; index < args.size(); ++index) {
+        if (index > 0) {
+            term.push_back(u' ');
+        }
+        term.append(args[index]);
+    }
+
+    if (term.empty()) {
+        return u"Search term is empty.";
+    }
+
+    const auto case_sensitive = m_case_sensitive->m_value;
+    if (regex) {
+        // Compiled once here for the error message; the workers compile their own copies
+        if (const auto pattern = Regex(term, case_sensitive); !pattern.isValid()) {
+            return std::u16string(u"Invalid regex: ").append(pattern.getError());
+        }
+    }
+
+    // Every buffer but the results one, which would otherwise list the previous results; the
+    // names are taken now, as a save-as may rename a buffer while the workers run
+    auto cursors = std::vector<const Cursor *>{};
+    auto names = std::vector<std::u16string>{};
+    for (size_t index = 0; index < m_context_manager.getCount(); ++index) {
+        const auto &cursor = m_context_manager.get(index).cursor;
+        if (cursor.getName() != RESULTS_NAME) {
+            cursors.push_back(&cursor);
+            names.push_back(utf8::utf8to16(cursor.getName().empty() ? "Untitled" : cursor.getName()));
+        }
+    }
+
+    // Empty the results buffer of the previous search, or open one
+    auto results_index = m_context_manager.indexOf(RESULTS_NAME);
+    if (!results_index) {
+        (void) m_context_manager.createContext();
+        results_index = m_context_manager.getCount() - 1;
+    }
+
+    auto &results = m_context_manager.get(*results_index);
+    results.highlighter.setMode(HighLightId::None);
+    for (const auto &edit : results.cursor.loadContent(u"")) {
+        results.notifyEdit(edit);
+    }
+
+    // A listing, not a file: it never asks to be saved
+    results.cursor.setName(RESULTS_NAME);
+    results.cursor.setModified(false);
+    results.scroll.follow_indicator = true;
+    results.stick.active = false;
+    results.stick.index = 0;
+    results.wants_redraw = true;
+    m_context_manager.activate(*results_index);
+
+    m_job->start(cursors, names, term, case_sensitive, regex, MAX_MATCHES_PER_BUFFER, ParallelSearch::getDefaultThreadCount());
+    auto message = std::u16string(u"search_all: searching ");
+    appendNumber(message, cursors.size());
+    message.append(u" buffer(s)...");
+    return message;
+}
+
+std::optional<std::u16string> SearchAllCommand::pump(CursorContextManager &contextManager, SearchAllJob &job) {
+    if (!job.isStarted()) {
+        return std::nullopt;
+    }
+
+    // Read the state first: once the threads are done, the take below gets everything they released
+    const auto is_done = !job.isRunning();
+    if (!appendOutput(contextManager, job)) {
+        // Nowhere to list the matches any more
+        job.cancel();
+        return u"search_all cancelled: results buffer closed";
+    }
+
+    if (!is_done) {
+        return std::nullopt;
+    }
+
+    job.cancel();
+    return summarize(job.getStats());
+}
+
+std::optional<std::u16string> SearchAllCommand::cancel(CursorContextManager &contextManager, SearchAllJob &job) {
+    if (!job.isStarted()) {
+        return std::nullopt;
+    }
+
+    job.cancel();
+    (void) appendOutput(contextManager, job);
+    return std::u16string(u"search_all cancelled: ").append(summarize(job.getStats()));
+}
@@ -0,0 +1,117 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SEARCH_ALL_COMMAND_H
+#define SEARCH_ALL_COMMAND_H
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "../core/base/AutoCompleteCallback.h"
+#include "../core/CursorContext.h"
+#include "../core/CursorContextManager.h"
+#include "../core/base/Command.h"
+#include "../core/SearchAllJob.h"
+#include "../core/cvar/CVarBool.h"
+
+
+/**
+ * @brief Command searching every open buffer at once, listing the matches in a results buffer.
+ *
+ * The buffers are scanned by a SearchAllJob on background threads, so the editor keeps taking
+ * input meanwhile. The results buffer, named RESULTS_NAME, is emptied and shown at once, and pump
+ * appends the `file:line:column: text` entries between frames, with 1-based lines and columns, so
+ * an entry is reached with `buffer <file>` then `goto_line <line>`. It is reused by the next
+ * search_all and never scanned itself.
+ */
+class SearchAllCommand final : public Command<CursorContext> {
+private:
+    /** Reference to the manager owning the open cursor contexts. */
+    CursorContextManager &m_context_manager;
+
+    /** CVar controlling whether comparisons are case-sensitive. */
+    const std::shared_ptr<CVarBool> m_case_sensitive;
+
+    /** The search, polled by the main loop. */
+    const std::shared_ptr<SearchAllJob> m_job;
+
+public:
+    /** Name of the results buffer. */
+    static constexpr auto RESULTS_NAME = std::string_view("*search_all*");
+
+    /** Number of matches listed per buffer; the rest are counted out as truncated. */
+    static constexpr uint32_t MAX_MATCHES_PER_BUFFER = 10000;
+
+    /**
+     * @brief Constructs a SearchAllCommand.
+     * @param contextManager Reference to the manager owning the open cursor contexts.
+     * @param caseSensitive The CVar controlling whether comparisons are case-sensitive.
+     * @param job The search polled by the main loop.
+     */
+    explicit SearchAllCommand(CursorContextManager &contextManager, std::shared_ptr<CVarBool> caseSensitive, std::shared_ptr<SearchAllJob> job);
+
+    /**
+     * @brief Provides auto-completion suggestions for command arguments.
+     *
+     * This command does not auto-complete.
+     *
+     * @param previousArgs The arguments typed before the one being completed, excluding the command name.
+     * @param argumentIndex The index of the argument currently being completed.
+     * @param input The current partial input from the user for this argument.
+     * @param itemCallback A callback to be invoked with each completion suggestion.
+     */
+    void provideAutoComplete(std::span<const std::u16string_view> previousArgs, int32_t argumentIndex, std::u16string_view input, const AutoCompleteCallback &itemCallback) const override;
+
+    /**
+     * @brief Starts searching every open buffer and shows the results buffer.
+     *
+     * Expects the term, joined back with single spaces like search does, after an optional -e flag
+     * making it a regular expression.
+     *
+     * @param payload The cursor context that was active when the command was invoked.
+     * @param args Command arguments: an optional -e flag, then the term.
+     * @return A status or error message.
+     */
+    [[nodiscard]] std::optional<std::u16string> run(CursorContext &payload, std::span<const std::u16string_view> args) override;
+
+    /**
+     * @brief Appends the entries the job released since the last call to the results buffer.
+     *
+     * Meant to be called between frames while the job is started. Closing the results buffer
+     * cancels the search. Once the job is done and drained, its threads are released.
+     *
+     * @param contextManager The manager owning the results buffer.
+     * @param job The search to drain.
+     * @return The summary of the search once it is over, std::nullopt before.
+     */
+    [[nodiscard]] static std::optional<std::u16string> pump(CursorContextManager &contextManager, SearchAllJob &job);
+
+    /**
+     * @brief Stops the search, listing what it found so far.
+     * @param contextManager The manager owning the results buffer.
+     * @param job The search to stop.
+     * @return The summary of the search, std::nullopt when none was running.
+     */
+    [[nodiscard]] static std::optional<std::u16string> cancel(CursorContextManager &contextManager, SearchAllJob &job);
+};
+
+
+#endif //SEARCH_ALL_COMMAND_H
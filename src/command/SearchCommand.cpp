@@ -20,6 +20,8 @@
 
 #include "SearchCommand.h"
 
+#include "../core/base/NumberText.h"
+
 
 SearchCommand::SearchCommand(const Action action, std::shared_ptr<CVarBool> caseSensitive)
     : m_action(action),
@@ -51,14 +53,33 @@ std::optional<std::u16string> SearchCommand::run(CursorContext &payload, const s
     return std::nullopt;
 }
 
-std::optional<std::u16string> SearchCommand::runSearch(CursorContext &payload, const std::span<const std::u16string_view> args) const {
+std::optional<std::u16string> SearchCommand::runSearch(CursorContext &payload, std::span<const std::u16string_view> args) const {
+    const auto regex = !args.empty() && args.front() == u"-e";
+    if (regex) {
+        args = args.subspan(1);
+    }
+
     if (args.empty()) {
         // From the prompt the search term is mandatory; from the editor, ask for it interactively.
-        if (payload.from_prompt) {
-            return u"Usage: search <term>";
+        if (payload.from_prompt || regex) {
+            return u"Usage: search [-e] <term>";
         }
 
-        payload.command_feedback = requestArgument(u"search ", u"search", payload.command_runner);
+        // Preview the term as it is typed, from where the cursor stands now
+        const auto origin_line = payload.cursor.getLine();
+        const auto origin_column = payload.cursor.getColumn();
+        auto feedback = requestArgument(u"search ", u"search", payload.command_runner);
+        feedback.on_input_callback = [&payload, caseSensitive = m_case_sensitive, origin_line, origin_column](const std::u16string_view input) {
+            previewSearch(payload, input, caseSensitive->m_value, origin_line, origin_column);
+        };
+        feedback.on_validate_callback = [&payload, origin_line, origin_column](const std::u16string_view input, const std::u16string_view command) -> std::optional<std::u16string> {
+            // Look up the confirmed term from the origin too, so it lands on the match the preview shows
+            payload.cursor.activateSelection(false);
+            payload.cursor.setPosition(origin_line, origin_column);
+            payload.command_runner.runCommand(std::u16string(command).append(u" ").append(input), true);
+            return std::nullopt;
+        };
+        payload.command_feedback = std::move(feedback);
 
         return std::nullopt;
     }
@@ -78,18 +99,28 @@ std::optional<std::u16string> SearchCommand::runSearch(CursorContext &payload, c
         joined_term.append(args[index]);
     }
 
+    if (joined_term.empty()) {
+        return u"Search term is empty.";
+    }
+
+    const auto case_sensitive = m_case_sensitive->m_value;
+    payload.search.preview_pending = false;
+    if (auto error = prepareIndex(payload, joined_term, case_sensitive, regex)) {
+        return error;
+    }
+
     // Stored before the not-found return below, so find_next keeps working after a failed search.
     payload.search.term = std::move(joined_term);
-    const auto &term = payload.search.term.value();
+    payload.search.regex = regex;
 
     const auto &cursor = payload.cursor;
-    const auto case_sensitive = m_case_sensitive->m_value;
-    auto scanner = LineScanner(term, case_sensitive);
+    auto &matches = payload.search.index;
+    auto scanner = matches.getScanner();
 
     // Look from the cursor to the end, then wrap around from the top of the buffer.
-    auto match = searchForward(cursor, scanner, cursor.getLine(), cursor.getColumn());
+    auto match = searchForward(cursor, scanner, matches, cursor.getLine(), cursor.getColumn());
     if (!match) {
-        match = searchForward(cursor, scanner, 0, 0);
+        match = searchForward(cursor, scanner, matches, 0, 0);
     }
 
     if (!match) {
@@ -97,9 +128,8 @@ std::optional<std::u16string> SearchCommand::runSearch(CursorContext &payload, c
         return u"not found";
     }
 
-    const auto current_matches = scanMatches(cursor, scanner, match.value());
-    storeMatchStats(payload, current_matches, match.value(), case_sensitive, current_matches.index >= 0);
-    selectMatch(payload, match.value(), static_cast<uint32_t>(term.length()));
+    storeRank(payload, matches.rank(cursor, match->line, match->column), match.value(), case_sensitive);
+    selectMatch(payload, match.value());
     return std::nullopt;
 }
 
@@ -108,11 +138,15 @@ std::optional<std::u16string> SearchCommand::runFind(CursorContext &payload) con
         return u"no search term";
     }
 
-    const auto &term = payload.search.term.value();
     const auto &cursor = payload.cursor;
     const auto case_sensitive = m_case_sensitive->m_value;
     const auto backward = m_action == Action::FindPrev;
-    auto scanner = LineScanner(term, case_sensitive);
+    if (auto error = prepareIndex(payload, payload.search.term.value(), case_sensitive, payload.search.regex)) {
+        return error;
+    }
+
+    auto &matches = payload.search.index;
+    auto scanner = matches.getScanner();
     const auto selection = cursor.getSelectedRange();
 
     // Read the stored statistics before the lookup moves the selection they are anchored on.
@@ -127,21 +161,25 @@ std::optional<std::u16string> SearchCommand::runFind(CursorContext &payload) con
         const auto from_line = selection ? selection->line_end : cursor.getLine();
         const auto from_column = selection ? selection->column_end : cursor.getColumn();
 
-        match = searchForward(cursor, scanner, from_line, from_column);
+        match = searchForward(cursor, scanner, matches, from_line, from_column);
+        if (match && match->length == 0 && match->line == from_line && match->column == from_column) {
+            // An empty match right where the lookup starts is the one already selected
+            match = searchForward(cursor, scanner, matches, from_line, from_column + 1);
+        }
         if (!match) {
             wrapped = true;
-            match = searchForward(cursor, scanner, 0, 0);
+            match = searchForward(cursor, scanner, matches, 0, 0);
         }
     } else {
         const auto before_line = selection ? selection->line_start : cursor.getLine();
         const auto before_column = selection ? selection->column_start : cursor.getColumn();
 
-        match = searchBackward(cursor, scanner, before_line, before_column);
+        match = searchBackward(cursor, scanner, matches, before_line, before_column);
         if (!match) {
             wrapped = true;
             const auto last_line = cursor.getLineCount() - 1;
             const auto last_column = static_cast<uint32_t>(cursor.getString(last_line).length()) + 1;
-            match = searchBackward(cursor, scanner, last_line, last_column);
+            match = searchBackward(cursor, scanner, matches, last_line, last_column);
         }
     }
 
@@ -159,20 +197,26 @@ std::optional<std::u16string> SearchCommand::runFind(CursorContext &payload) con
 
         if (index >= 0 && index < stored_total) {
             storeMatchStats(payload, MatchStats{.index = index, .total = stored_total}, match.value(), case_sensitive, true);
-            selectMatch(payload, match.value(), static_cast<uint32_t>(term.length()));
+            selectMatch(payload, match.value());
             return std::nullopt;
         }
     }
 
-    const auto current_matches = scanMatches(cursor, scanner, match.value());
-    storeMatchStats(payload, current_matches, match.value(), case_sensitive, current_matches.index >= 0);
-    selectMatch(payload, match.value(), static_cast<uint32_t>(term.length()));
+    storeRank(payload, matches.rank(cursor, match->line, match->column), match.value(), case_sensitive);
+    selectMatch(payload, match.value());
     return std::nullopt;
 }
 
-std::optional<std::u16string> SearchCommand::runReplace(CursorContext &payload, const std::span<const std::u16string_view> args) const {
+std::optional<std::u16string> SearchCommand::runReplace(CursorContext &payload, std::span<const std::u16string_view> args) const {
+    const auto regex = !args.empty() && args.front() == u"-e";
+    if (regex) {
+        args = args.subspan(1);
+    }
+
     if (args.size() != 2) {
-        return u"Usage: replace <from> <to>";
+        return m_action == Action::Replace
+            ? u"Usage: replace [-e] <from> <to>"
+            : u"Usage: replace_all [-e] <from> <to>";
     }
 
     const auto from = args[0];
@@ -183,13 +227,23 @@ std::optional<std::u16string> SearchCommand::runReplace(CursorContext &payload,
 
     const auto &cursor = payload.cursor;
     const auto case_sensitive = m_case_sensitive->m_value;
-    auto scanner = LineScanner(from, case_sensitive);
+    if (auto error = prepareIndex(payload, from, case_sensitive, regex)) {
+        return error;
+    }
+
+    auto &matches = payload.search.index;
+    auto scanner = matches.getScanner();
+    if (regex && Regex::getHighestReference(to) > static_cast<int32_t>(scanner.getRegex()->getGroupCount())) {
+        return u"Replacement refers to a missing group.";
+    }
+
     payload.search.term = std::u16string(from);
+    payload.search.regex = regex;
 
     if (m_action == Action::Replace) {
-        auto match = searchForward(cursor, scanner, cursor.getLine(), cursor.getColumn());
+        auto match = searchForward(cursor, scanner, matches, cursor.getLine(), cursor.getColumn());
         if (!match) {
-            match = searchForward(cursor, scanner, 0, 0);
+            match = searchForward(cursor, scanner, matches, 0, 0);
         }
 
         if (!match) {
@@ -197,38 +251,36 @@ std::optional<std::u16string> SearchCommand::runReplace(CursorContext &payload,
             return u"not found";
         }
 
-        const auto current_matches = scanMatches(cursor, scanner, match.value());
-        storeMatchStats(payload, current_matches, match.value(), case_sensitive, current_matches.index >= 0);
-        selectMatch(payload, match.value(), static_cast<uint32_t>(from.length()));
-        replaceSelection(payload, to);
-        return std::u16string(u"replaced ").append(toU16(1)).append(u" occurrence(s)");
+        storeRank(payload, matches.rank(cursor, match->line, match->column), match.value(), case_sensitive);
+        const auto replacement = MatchReplacer::expand(scanner, cursor.getString(match->line), match->column, match->length, to);
+        selectMatch(payload, match.value());
+        replaceSelection(payload, replacement);
+        return std::u16string(u"replaced ").append(formatNumber(1)).append(u" occurrence(s)");
     }
 
-    // REPLACE_ALL: resume scanning past each replacement so freshly inserted text is never re-matched.
-    auto count = 0u;
-    auto start_line = 0u;
-    auto start_column = 0u;
-    while (const auto match = searchForward(cursor, scanner, start_line, start_column)) {
-        selectMatch(payload, match.value(), static_cast<uint32_t>(from.length()));
-        replaceSelection(payload, to);
-        start_line = cursor.getLine();
-        start_column = cursor.getColumn();
-        ++count;
+    // REPLACE_ALL: every match is looked up on the text as it stands, then replaced in one splice,
+    // so freshly inserted text is never re-matched and the whole rewrite undoes as one step
+    const auto result = MatchReplacer::replaceAll(payload.cursor, scanner, to);
+    if (result.edit) {
+        payload.notifyEdit(result.edit.value());
+        payload.stick.index = cursor.getColumn();
+        payload.scroll.follow_indicator = true;
+        payload.wants_redraw = true;
     }
 
     // Every match was consumed, so the persistent indicator has nothing left to show.
     payload.search.resetMatches();
-    return std::u16string(u"replaced ").append(toU16(count)).append(u" occurrence(s)");
+    return std::u16string(u"replaced ").append(formatNumber(result.count)).append(u" occurrence(s)");
 }
 
-void SearchCommand::selectMatch(CursorContext &payload, const MatchLocation &match, const uint32_t termLength) {
+void SearchCommand::selectMatch(CursorContext &payload, const MatchLocation &match) {
     auto &cursor = payload.cursor;
 
     // Reset any active selection so the anchor snaps to the start of the new match.
     cursor.activateSelection(false);
     cursor.setPosition(match.line, match.column);
     cursor.activateSelection(true);
-    cursor.setPosition(match.line, match.column + termLength);
+    cursor.setPosition(match.line, match.column + match.length);
 
     payload.scroll.follow_indicator = true;
     payload.wants_redraw = true;
@@ -246,66 +298,59 @@ void SearchCommand::replaceSelection(CursorContext &payload, const std::u16strin
     const auto &edit = cursor.insert(replacement);
     payload.stick.index = cursor.getColumn();
     payload.scroll.follow_indicator = true;
-    payload.highlighter.edit(edit);
+    payload.notifyEdit(edit);
     payload.wants_redraw = true;
 }
 
-std::optional<SearchCommand::MatchLocation> SearchCommand::searchForward(const Cursor &cursor, LineScanner &scanner, const uint32_t startLine, const uint32_t startColumn) {
-    const auto line_count = cursor.getLineCount();
-    for (auto line = startLine; line < line_count; ++line) {
-        scanner.setLine(cursor.getString(line));
-        const auto from = line == startLine ? startColumn : 0u;
-        if (const auto position = scanner.indexOf(from); position != std::u16string_view::npos) {
-            return MatchLocation{.line = line, .column = static_cast<uint32_t>(position)};
+std::optional<std::u16string> SearchCommand::prepareIndex(CursorContext &payload, const std::u16string_view term, const bool caseSensitive, const bool regex) {
+    auto &index = payload.search.index;
+    if (index.isBuiltFor(term, caseSensitive, regex)) {
+        return std::nullopt;
+    }
+
+    if (regex) {
+        auto pattern = std::make_shared<Regex>(term, caseSensitive);
+        if (!pattern->isValid()) {
+            return std::u16string(u"Invalid regex: ").append(pattern->getError());
         }
+        index.start(payload.cursor, std::move(pattern));
+    } else {
+        index.start(payload.cursor, term, caseSensitive);
     }
 
+    index.step(payload.cursor, INITIAL_COUNT_LINES);
     return std::nullopt;
 }
 
-std::optional<SearchCommand::MatchLocation> SearchCommand::searchBackward(const Cursor &cursor, LineScanner &scanner, const uint32_t beforeLine, const uint32_t beforeColumn) {
-    // Decrement in the condition so line 0 is scanned too, then stops before wrapping around.
-    for (auto line = beforeLine + 1; line-- > 0;) {
-        const auto text = cursor.getString(line);
-        scanner.setLine(text);
-        const auto limit = line == beforeLine
-            ? beforeColumn
-            : text.length() + 1;
-
-        if (const auto position = scanner.lastIndexOf(limit); position != std::u16string_view::npos) {
-            return MatchLocation{.line = line, .column = static_cast<uint32_t>(position)};
+std::optional<SearchCommand::MatchLocation> SearchCommand::searchForward(const Cursor &cursor, LineScanner &scanner, MatchIndex &index, const uint32_t startLine, const uint32_t startColumn,
+                                                                        const uint32_t endLine) {
+    // The start line is scanned from the column; past it, the index jumps straight to the lines holding a match.
+    for (auto line = std::optional<uint32_t>(startLine); line && *line < endLine; line = index.nextLineWithMatch(cursor, *line)) {
+        scanner.setLine(cursor.getString(*line));
+        const auto from = *line == startLine ? startColumn : 0u;
+        if (const auto position = scanner.indexOf(from); position != std::u16string_view::npos) {
+            return MatchLocation{.line = *line, .column = static_cast<uint32_t>(position), .length = static_cast<uint32_t>(scanner.matchLength())};
         }
     }
 
     return std::nullopt;
 }
 
-SearchCommand::MatchStats SearchCommand::scanMatches(const Cursor &cursor, LineScanner &scanner, const MatchLocation &current) {
-    const auto term_length = scanner.termLength();
-    if (term_length == 0) {
-        return MatchStats{.index = -1, .total = 0};
-    }
+std::optional<SearchCommand::MatchLocation> SearchCommand::searchBackward(const Cursor &cursor, LineScanner &scanner, MatchIndex &index, const uint32_t beforeLine, const uint32_t beforeColumn) {
+    // Lines are only ever visited upwards, so only the first one is bounded by the column.
+    for (auto line = std::optional<uint32_t>(beforeLine); line; line = index.previousLineWithMatch(cursor, *line)) {
+        const auto text = cursor.getString(*line);
+        scanner.setLine(text);
+        const auto limit = *line == beforeLine
+            ? beforeColumn
+            : text.length() + 1;
 
-    auto index = -1;
-    auto total = 0;
-    const auto line_count = cursor.getLineCount();
-    for (auto line = 0u; line < line_count; ++line) {
-        scanner.setLine(cursor.getString(line));
-        size_t from = 0;
-        while (true) {
-            const auto position = scanner.indexOf(from);
-            if (position == std::u16string_view::npos) {
-                break;
-            }
-            if (line == current.line && static_cast<uint32_t>(position) == current.column) {
-                index = total;
-            }
-            ++total;
-            from = position + term_length;
+        if (const auto position = scanner.lastIndexOf(limit); position != std::u16string_view::npos) {
+            return MatchLocation{.line = *line, .column = static_cast<uint32_t>(position), .length = static_cast<uint32_t>(scanner.matchLength())};
         }
     }
 
-    return MatchStats{.index = index, .total = total};
+    return std::nullopt;
 }
 
 void SearchCommand::storeMatchStats(CursorContext &payload, const MatchStats &stats, const MatchLocation &match, const bool caseSensitive, const bool scanned) {
@@ -313,8 +358,33 @@ void SearchCommand::storeMatchStats(CursorContext &payload, const MatchStats &st
     payload.search.match_count = stats.total;
     payload.search.match_line = match.line;
     payload.search.match_column = match.column;
+    payload.search.match_length = match.length;
     payload.search.match_case_sensitive = caseSensitive;
     payload.search.match_scanned = scanned;
+    payload.search.match_pending = false;
+}
+
+void SearchCommand::storeRank(CursorContext &payload, const MatchIndex::Rank &rank, const MatchLocation &anchor, const bool caseSensitive) {
+    if (rank.complete && rank.total == 0) {
+        payload.search.resetMatches();
+        return;
+    }
+
+    // Prefer the ordinal of a match landing on the anchor; otherwise place the counter just past
+    // the matches preceding it, clamped in case the anchor sits after the final match.
+    auto index = -1;
+    if (rank.counted) {
+        index = rank.index >= 0 ? rank.index : std::clamp(rank.before, 0, std::max(rank.total - 1, 0));
+    }
+
+    // Only an anchor sitting on a match, ranked against the final total, can be stepped; the match
+    // is the one the enumeration holds there, as long as the selection, if any, is exactly it.
+    auto match = anchor;
+    if (rank.index >= 0) {
+        match.length = rank.length;
+    }
+    storeMatchStats(payload, MatchStats{.index = index, .total = rank.total}, match, caseSensitive, rank.complete && rank.index >= 0);
+    payload.search.match_pending = !rank.complete;
 }
 
 bool SearchCommand::canStepMatchStats(const CursorContext &payload, const LineScanner &scanner, const bool caseSensitive, const bool backward) {
@@ -330,8 +400,8 @@ bool SearchCommand::canStepMatchStats(const CursorContext &payload, const LineSc
     }
 
     if (backward && scanner.isSelfOverlapping()) {
-        // scanMatches enumerates non-overlapping occurrences; a term overlapping itself lets the
-        // backward lookup land between two of them, where only a rescan can rank the result.
+        // The index counts non-overlapping occurrences; a term overlapping itself lets the
+        // backward lookup land between two of them, where only a fresh lookup can rank the result.
         return false;
     }
 
@@ -341,7 +411,7 @@ bool SearchCommand::canStepMatchStats(const CursorContext &payload, const LineSc
         && selection->line_start == search.match_line
         && selection->line_end == search.match_line
         && selection->column_start == search.match_column
-        && selection->column_end == search.match_column + static_cast<uint32_t>(scanner.termLength());
+        && selection->column_end == search.match_column + search.match_length;
 }
 
 void SearchCommand::refreshMatchStats(CursorContext &payload, const bool caseSensitive) {
@@ -352,54 +422,93 @@ void SearchCommand::refreshMatchStats(CursorContext &payload, const bool caseSen
         return;
     }
 
-    const auto &term = payload.search.term.value();
     const auto &cursor = payload.cursor;
-    auto scanner = LineScanner(term, caseSensitive);
+    if (prepareIndex(payload, payload.search.term.value(), caseSensitive, payload.search.regex)) {
+        // Case sensitivity never makes a pattern invalid, so this is only defensive
+        payload.search.resetMatches();
+        return;
+    }
+
+    auto &matches = payload.search.index;
 
     // Anchor on the current selection start, or the bare cursor when nothing is selected.
     const auto selection = cursor.getSelectedRange();
     const auto anchor_line = selection ? selection->line_start : cursor.getLine();
     const auto anchor_column = selection ? selection->column_start : cursor.getColumn();
 
-    auto total = 0;
-    auto before = 0;
-    auto exact = -1;
-    const auto line_count = cursor.getLineCount();
-    for (auto line = 0u; line < line_count; ++line) {
-        scanner.setLine(cursor.getString(line));
-        size_t from = 0;
-        while (true) {
-            const auto position = scanner.indexOf(from);
-            if (position == std::u16string_view::npos) {
-                break;
-            }
-            const auto column = static_cast<uint32_t>(position);
-            if (line == anchor_line && column == anchor_column) {
-                exact = total;
-            }
-            if (line < anchor_line || (line == anchor_line && column < anchor_column)) {
-                ++before;
-            }
-            ++total;
-            from = position + scanner.termLength();
-        }
-    }
+    storeRank(payload, matches.rank(cursor, anchor_line, anchor_column), MatchLocation{.line = anchor_line, .column = anchor_column, .length = 0}, caseSensitive);
+}
 
-    if (total == 0) {
-        payload.search.resetMatches();
+void SearchCommand::previewSearch(CursorContext &payload, const std::u16string_view term, const bool caseSensitive, const uint32_t originLine, const uint32_t originColumn) {
+    auto &search = payload.search;
+    auto &cursor = payload.cursor;
+    payload.wants_redraw = true;
+    payload.scroll.follow_indicator = true;
+
+    if (term.empty()) {
+        search.resetMatches();
+        cursor.activateSelection(false);
+        cursor.setPosition(originLine, originColumn);
         return;
     }
 
-    // Prefer the ordinal of a match landing on the anchor; otherwise place the counter just past
-    // the matches preceding it, clamped in case the anchor sits after the final match.
-    const auto index = exact >= 0 ? exact : before;
-    const auto stats = MatchStats{.index = std::clamp(index, 0, total - 1), .total = total};
+    // A literal term is always valid; the index narrows the previous term's matches when it can
+    (void) prepareIndex(payload, term, caseSensitive, false);
+    search.preview_line = originLine;
+    search.preview_column = originColumn;
+    search.preview_case_sensitive = caseSensitive;
+    search.preview_pending = true;
+    resolvePreview(payload);
+}
+
+void SearchCommand::resolvePreview(CursorContext &payload) {
+    auto &search = payload.search;
+    auto &cursor = payload.cursor;
+    auto &index = search.index;
+    auto scanner = index.getScanner();
+    const auto counted = index.getCountedLines();
+    const auto origin = MatchLocation{.line = search.preview_line, .column = search.preview_column, .length = 0};
+
+    auto match = searchForward(cursor, scanner, index, origin.line, origin.column, counted);
+    if (!match && !index.isCounting()) {
+        match = searchForward(cursor, scanner, index, 0, 0, counted);
+    }
+
+    if (match) {
+        search.preview_pending = false;
+        storeRank(payload, index.rank(cursor, match->line, match->column), match.value(), search.preview_case_sensitive);
+        selectMatch(payload, match.value());
+        return;
+    }
 
-    // Only an anchor sitting on a match got its exact ordinal, so only that one can be stepped.
-    storeMatchStats(payload, stats, MatchLocation{.line = anchor_line, .column = anchor_column}, caseSensitive, exact >= 0);
+    // Nothing to show yet: wait on the origin, with the count so far, for the lines left to count
+    cursor.activateSelection(false);
+    cursor.setPosition(origin.line, origin.column);
+    payload.wants_redraw = true;
+    if (!index.isCounting()) {
+        search.resetMatches();
+        return;
+    }
+    storeRank(payload, index.rank(cursor, origin.line, origin.column), origin, search.preview_case_sensitive);
 }
 
-std::u16string SearchCommand::toU16(const uint32_t value) {
-    const auto digits = std::to_string(value);
-    return {digits.begin(), digits.end()};
+bool SearchCommand::advanceMatchCount(CursorContext &payload, const uint32_t lineBudget) {
+    auto &search = payload.search;
+    if (!search.index.isCounting()) {
+        return false;
+    }
+
+    const auto counting = search.index.step(payload.cursor, lineBudget);
+    if (search.preview_pending && payload.command_feedback) {
+        // Still previewing, and the lines just counted may hold the first match
+        resolvePreview(payload);
+    }
+    if (search.match_pending) {
+        // Edits and moves reset the pending flag, so the stored anchor is still the one ranked last
+        const auto anchor = MatchLocation{.line = search.match_line, .column = search.match_column, .length = search.match_length};
+        storeRank(payload, search.index.rank(payload.cursor, anchor.line, anchor.column), anchor, search.match_case_sensitive);
+        payload.wants_redraw = true;
+    }
+
+    return counting;
 }
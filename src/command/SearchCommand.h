@@ -19,6 +19,7 @@
 #ifndef SEARCH_COMMAND_H
 #define SEARCH_COMMAND_H
 
+#include <limits>
 #include <memory>
 #include <optional>
 #include <span>
@@ -28,6 +29,9 @@
 #include "../core/CursorContext.h"
 #include "../core/base/Command.h"
 #include "../core/base/LineScanner.h"
+#include "../core/base/Regex.h"
+#include "../core/cursor/MatchIndex.h"
+#include "../core/cursor/MatchReplacer.h"
 #include "../core/cvar/CVarBool.h"
 
 
@@ -35,7 +39,18 @@
  * @brief Command implementing the search and replace features of the editor.
  *
  * A single class parameterized by an Action selected at construction, registered once per action.
- * Matches are recomputed on every navigation rather than cached, so edits never leave stale offsets behind.
+ * Match positions are looked up on every navigation rather than cached, so edits never leave stale
+ * offsets behind; the per-line counts of the MatchIndex follow the edits, and let a lookup skip the
+ * lines without a match and rank a match without scanning the buffer. A new term is counted
+ * progressively: the first match is selected at once, and its ordinal and the total fill in as
+ * advanceMatchCount works through the buffer.
+ *
+ * Search, replace and replace_all take a leading -e flag to treat the term as a Regex; the
+ * replacement of a pattern may then refer to its groups as \0 to \9.
+ *
+ * Asked for its term from the prompt, search previews it as it is typed (previewSearch): each
+ * keystroke selects the first match from where the cursor stood, and the term confirmed is looked
+ * up from there again, so the match it lands on is the one shown.
  */
 class SearchCommand final : public Command<CursorContext> {
 public:
@@ -49,10 +64,11 @@ public:
     };
 
 private:
-    /** @brief The line and starting column of a single match. */
+    /** @brief The line, starting column and length of a single match. */
     struct MatchLocation final {
         uint32_t line;   ///< Line where the match starts and ends (matches never span lines).
         uint32_t column; ///< Column where the match starts.
+        uint32_t length; ///< Length of the match in code units; a pattern can match an empty string.
     };
 
     /** @brief The ordinal of a match among all occurrences, and the total number of occurrences. */
@@ -68,50 +84,52 @@ private:
     const std::shared_ptr<CVarBool> m_case_sensitive;
 
     /**
-     * @brief Renders an unsigned value as a UTF-16 decimal string.
-     * @param value The value to render.
-     * @return The decimal representation.
+     * @brief Makes the match index of a context count the given term under the given mode.
+     *
+     * The index survives edits and navigation; it is only rebuilt when the term, the
+     * case-sensitivity mode or the regex flag changes. A rebuild counts the first INITIAL_COUNT_LINES
+     * lines right away and leaves the rest to advanceMatchCount, so a lookup never waits for a whole
+     * buffer. Lookups copy the scanner of the index, which shares its compiled pattern.
+     *
+     * @param payload The cursor context holding the index.
+     * @param term The term to look for; must not be empty.
+     * @param caseSensitive Whether comparisons are case-sensitive.
+     * @param regex Whether @p term is a regular expression.
+     * @return An error message when @p term is not a valid pattern, std::nullopt otherwise.
      */
-    [[nodiscard]] static std::u16string toU16(uint32_t value);
+    [[nodiscard]] static std::optional<std::u16string> prepareIndex(CursorContext &payload, std::u16string_view term, bool caseSensitive, bool regex);
 
     /**
      * @brief Scans forward for the first match at or after a position, without wrapping.
      * @param cursor The cursor whose buffer is scanned.
      * @param scanner The scanner holding the term and the case-sensitivity mode; stateful, its setLine is
      *                called on every line walked.
+     * @param index The match index of the same term and mode, used to skip the lines without a match.
      * @param startLine The line to start scanning from.
      * @param startColumn The column to start scanning from on the first line.
+     * @param endLine The line the scan stops before.
      * @return The match location, or std::nullopt when none is found.
      */
-    [[nodiscard]] static std::optional<MatchLocation> searchForward(const Cursor &cursor, LineScanner &scanner, uint32_t startLine, uint32_t startColumn);
+    [[nodiscard]] static std::optional<MatchLocation> searchForward(const Cursor &cursor, LineScanner &scanner, MatchIndex &index, uint32_t startLine, uint32_t startColumn,
+                                                                   uint32_t endLine = std::numeric_limits<uint32_t>::max());
 
     /**
      * @brief Scans backward for the last match starting before a position, without wrapping.
      * @param cursor The cursor whose buffer is scanned.
      * @param scanner The scanner holding the term and the case-sensitivity mode; stateful, its setLine is
      *                called on every line walked.
+     * @param index The match index of the same term and mode, used to skip the lines without a match.
      * @param beforeLine The line to start scanning from.
      * @param beforeColumn The exclusive column bound on the first line.
      * @return The match location, or std::nullopt when none is found.
      */
-    [[nodiscard]] static std::optional<MatchLocation> searchBackward(const Cursor &cursor, LineScanner &scanner, uint32_t beforeLine, uint32_t beforeColumn);
-
-    /**
-     * @brief Scans every non-overlapping occurrence of a term in a single pass.
-     *
-     * Counts the total number of occurrences and records the ordinal of the one matching @p current.
-     *
-     * @param cursor The cursor whose buffer is scanned.
-     * @param scanner The scanner holding the term and the case-sensitivity mode; stateful, its setLine is
-     *                called on every line walked.
-     * @param current The match whose ordinal is looked up.
-     * @return The ordinal of @p current (or -1 when absent) and the total occurrence count.
-     */
-    [[nodiscard]] static MatchStats scanMatches(const Cursor &cursor, LineScanner &scanner, const MatchLocation &current);
+    [[nodiscard]] static std::optional<MatchLocation> searchBackward(const Cursor &cursor, LineScanner &scanner, MatchIndex &index, uint32_t beforeLine, uint32_t beforeColumn);
 
     /**
      * @brief Stores the match statistics along with the match they describe.
      *
+     * The statistics are final: the pending flag is cleared.
+     *
      * @param payload The cursor context to update.
      * @param stats The ordinal and total to publish.
      * @param match The match the ordinal describes.
@@ -120,6 +138,20 @@ private:
      */
     static void storeMatchStats(CursorContext &payload, const MatchStats &stats, const MatchLocation &match, bool caseSensitive, bool scanned);
 
+    /**
+     * @brief Stores the rank of a position as the match statistics, anchored on that position.
+     *
+     * The ordinal of a match sitting on the anchor is preferred; otherwise the counter is placed just
+     * past the matches preceding it. While the index is still counting, the statistics are flagged
+     * pending, and the ordinal stays unknown until the lines before the anchor are counted.
+     *
+     * @param payload The cursor context to update.
+     * @param rank The rank of @p anchor, as returned by MatchIndex::rank.
+     * @param anchor The position the statistics are anchored on, usually a match.
+     * @param caseSensitive The case-sensitivity mode the rank was computed under.
+     */
+    static void storeRank(CursorContext &payload, const MatchIndex::Rank &rank, const MatchLocation &anchor, bool caseSensitive);
+
     /**
      * @brief Tells whether the stored total can be stepped instead of recounted.
      *
@@ -139,9 +171,8 @@ private:
      * @brief Selects a match and requests the view to follow the cursor.
      * @param payload The cursor context to update.
      * @param match The match to select.
-     * @param termLength The length of the matched term, in code units.
      */
-    static void selectMatch(CursorContext &payload, const MatchLocation &match, uint32_t termLength);
+    static void selectMatch(CursorContext &payload, const MatchLocation &match);
 
     /**
      * @brief Replaces a selected match with a replacement string, reusing the editor's text-input sequence.
@@ -150,10 +181,21 @@ private:
      */
     static void replaceSelection(CursorContext &payload, std::u16string_view replacement);
 
+    /**
+     * @brief Selects the first match of the previewed term after its origin, among the counted lines.
+     *
+     * Once the whole buffer is counted, the lookup wraps around to the top. Until then, a term with
+     * no match between the origin and the last counted line leaves the cursor on the origin and the
+     * preview pending.
+     *
+     * @param payload The cursor context holding the preview.
+     */
+    static void resolvePreview(CursorContext &payload);
+
     /**
      * @brief Runs the Search action: stores the term and selects its first match.
      * @param payload The cursor context to update.
-     * @param args The command arguments forming the term.
+     * @param args The command arguments forming the term, after an optional -e flag.
      * @return A status or error message.
      */
     [[nodiscard]] std::optional<std::u16string> runSearch(CursorContext &payload, std::span<const std::u16string_view> args) const;
@@ -168,12 +210,15 @@ private:
     /**
      * @brief Runs the Replace or ReplaceAll action.
      * @param payload The cursor context to update.
-     * @param args The command arguments: the term and its replacement.
+     * @param args The command arguments: an optional -e flag, the term and its replacement.
      * @return A status or error message.
      */
     [[nodiscard]] std::optional<std::u16string> runReplace(CursorContext &payload, std::span<const std::u16string_view> args) const;
 
 public:
+    /** Number of lines a new index counts before the lookup that started it returns. */
+    static constexpr uint32_t INITIAL_COUNT_LINES = 65536;
+
     /**
      * @brief Constructs a SearchCommand bound to a single action.
      * @param action The action this instance performs.
@@ -212,6 +257,37 @@ public:
      * @param caseSensitive Whether comparisons are case-sensitive.
      */
     static void refreshMatchStats(CursorContext &payload, bool caseSensitive);
+
+    /**
+     * @brief Selects the first match of a term being typed, looking from where the search started.
+     *
+     * Run on every change of the input of the search prompt, so it must keep up with typing on any
+     * buffer. A term extending the previous one is narrowed down from its matches by the index
+     * instead of counted again; any other term restarts the count, which goes on between frames.
+     * Only the counted lines are looked at here: when they hold no match past the origin, the
+     * preview stays pending and advanceMatchCount finishes it as the count reaches further. An
+     * empty term puts the cursor back on the origin.
+     *
+     * @param payload The cursor context to update.
+     * @param term The term typed so far.
+     * @param caseSensitive Whether comparisons are case-sensitive.
+     * @param originLine The line the search looks from.
+     * @param originColumn The column the search looks from.
+     */
+    static void previewSearch(CursorContext &payload, std::u16string_view term, bool caseSensitive, uint32_t originLine, uint32_t originColumn);
+
+    /**
+     * @brief Counts the next run of lines of the search index, and refreshes pending match statistics.
+     *
+     * Meant to be called between frames while it returns true. Counting carries on across edits and
+     * moves, which only stop the statistics from being refreshed; a new term or case-sensitivity mode
+     * restarts it from the top. A pending preview looks again at the lines just counted.
+     *
+     * @param payload The cursor context whose index is counted.
+     * @param lineBudget The maximum number of lines to count.
+     * @return true while lines remain to be counted.
+     */
+    static bool advanceMatchCount(CursorContext &payload, uint32_t lineBudget);
 };
 
 
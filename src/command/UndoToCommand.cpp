@@ -0,0 +1,76 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "UndoToCommand.h"
+
+#include <charconv>
+#include <system_error>
+
+#include <utf8/cpp17.h>
+
+
+void UndoToCommand::provideAutoComplete(const std::span<const std::u16string_view> previousArgs, const int32_t argumentIndex, const std::u16string_view input, const AutoCompleteCallback &itemCallback) const {
+    (void) previousArgs;
+    if (argumentIndex == 0) {
+        constexpr auto saved = std::u16string_view(u"saved");
+        if (saved.starts_with(input)) {
+            itemCallback(saved);
+        }
+    }
+}
+
+std::optional<std::u16string> UndoToCommand::run(CursorContext &payload, const std::span<const std::u16string_view> args) {
+    if (args.size() != 1) {
+        return u"Usage: undo_to saved|<steps>";
+    }
+
+    auto edit = std::optional<BufferEdit>();
+    if (args[0] == u"saved") {
+        if (!payload.cursor.isModified()) {
+            return u"Already at the saved state.";
+        }
+
+        edit = payload.cursor.undoToSaved();
+        if (!edit) {
+            return u"The saved state is no longer in the history.";
+        }
+    } else {
+        const auto arg = utf8::utf16to8(args[0]);
+        auto steps = uint32_t{0};
+        const auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.length(), steps);
+        if (ec != std::errc{} || ptr != arg.data() + arg.length() || steps == 0) {
+            return u"Expected saved or a positive number of steps.";
+        }
+
+        edit = payload.cursor.undoSteps(steps);
+        if (!edit) {
+            return u"Nothing to undo.";
+        }
+    }
+
+    // However many groups were crossed, the change is relayed as one edit: tree-sitter reparses once
+    payload.notifyEdit(*edit);
+    payload.cursor.activateSelection(false);
+    payload.stick.index = payload.cursor.getColumn();
+    payload.search.resetMatches();
+
+    // Redraw and follow the cursor.
+    payload.wants_redraw = true;
+    payload.scroll.follow_indicator = true;
+    return std::nullopt;
+}
@@ -0,0 +1,67 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef UNDO_TO_COMMAND_H
+#define UNDO_TO_COMMAND_H
+
+#include <span>
+#include <string>
+
+#include "../core/base/AutoCompleteCallback.h"
+#include "../core/CursorContext.h"
+#include "../core/base/Command.h"
+
+
+/**
+ * @brief Command for moving through the undo history by many steps at once.
+ *
+ * Goes back to the state the buffer was last saved in, redoing when it lies ahead, or undoes a
+ * number of steps. However far the move, the highlighter receives a single edit, so the syntax
+ * tree is reparsed once.
+ */
+class UndoToCommand final : public Command<CursorContext> {
+public:
+    /** @brief Constructs an UndoToCommand with default initialization. */
+    explicit UndoToCommand() = default;
+
+    /**
+      * @brief Provides auto-completion suggestions for command arguments.
+      *
+      * This command auto-completes argument 0 with "saved".
+      *
+      * @param previousArgs The arguments typed before the one being completed, excluding the command name.
+      * @param argumentIndex The index of the argument currently being completed.
+      * @param input The current partial input from the user for this argument.
+      * @param itemCallback A callback to be invoked with each completion suggestion.
+      */
+    void provideAutoComplete(std::span<const std::u16string_view> previousArgs, int32_t argumentIndex, std::u16string_view input, const AutoCompleteCallback &itemCallback) const override;
+
+    /**
+     * @brief Executes the move through the history.
+     *
+     * This command expects 1 argument: "saved", or the number of steps to undo.
+     *
+     * @param payload The cursor context that will be modified by the move.
+     * @param args Command arguments.
+     * @return An optional message indicating the result of the operation.
+     */
+    [[nodiscard]] std::optional<std::u16string> run(CursorContext &payload, std::span<const std::u16string_view> args) override;
+};
+
+
+#endif //UNDO_TO_COMMAND_H
@@ -21,9 +21,12 @@
 
 #include <cstddef>
 #include <optional>
+#include <span>
 #include <string>
 
 #include "cursor/Cursor.h"
+#include "cursor/MatchIndex.h"
+#include "cursor/MatchRangeCache.h"
 #include "cursor/PromptCursor.h"
 #include "base/CommandFeedback.h"
 #include "highlighter/HighLighter.h"
@@ -62,6 +65,7 @@ private:
      */
     struct SearchState final {
         std::optional<std::u16string> term;  ///< The last searched term, if any.
+        bool regex = false;                  ///< Whether term is a regular expression rather than literal text.
         int32_t match_index = -1;            ///< Zero-based ordinal of current match, -1 when none.
         int32_t match_count = 0;             ///< Total matches for the current term, 0 when none.
 
@@ -71,18 +75,60 @@ private:
          */
         uint32_t match_line = 0;             ///< Line of the match match_index designates.
         uint32_t match_column = 0;           ///< Column of the match match_index designates.
+        uint32_t match_length = 0;           ///< Length of the match match_index designates.
         bool match_case_sensitive = false;   ///< Case-sensitivity mode the statistics were computed under.
         bool match_scanned = false;          ///< true when match_index is the exact ordinal of that match.
 
+        /**
+         * true while the index is still counting the buffer: match_count is the count so far and
+         * match_index is -1 until the lines before the match are counted. The main loop advances the
+         * count between frames and refreshes both (see SearchCommand::advanceMatchCount).
+         */
+        bool match_pending = false;
+
+        /**
+         * Where the incremental search of the search prompt looks from, and under which mode. While
+         * its first match may lie in the lines the index has yet to count, the lookup is pending and
+         * the main loop finishes it between frames (see SearchCommand::previewSearch).
+         */
+        uint32_t preview_line = 0;           ///< Line the incremental search looks from.
+        uint32_t preview_column = 0;         ///< Column the incremental search looks from.
+        bool preview_case_sensitive = false; ///< Case-sensitivity mode of the incremental search.
+        bool preview_pending = false;        ///< true while the first match of the previewed term is still looked for.
+
+        /** Per-line match counts of the last term looked up, kept current by notifyEdit. */
+        MatchIndex index;
+
+        /** Matches of the term of the index on the lines the editor draws, kept current by notifyEdit. */
+        MatchRangeCache ranges;
+
         /** @brief Forgets the match statistics while keeping the term, so find_next/find_prev still work. */
         void resetMatches() {
             match_index = -1;
             match_count = 0;
             match_scanned = false;
+            match_pending = false;
+            preview_pending = false;
         }
     };
 
 public:
+    /**
+     * @brief Bytes held by a context, split by subsystem.
+     */
+    struct MemoryUsage final {
+        BufferMemory buffer{};           ///< Text, line table and line metrics of the text buffer.
+        std::size_t undo_history = 0;    ///< Allocated to the text of the undo/redo history, in bytes.
+        std::size_t highlight_cache = 0; ///< Rows of the highlight cache window.
+        std::size_t syntax_tree = 0;     ///< Estimated size of the tree-sitter syntax tree.
+        std::size_t search_index = 0;    ///< Per-line match counts of the search term, and its matches on the drawn lines.
+
+        /** @return The sum of every counter. */
+        [[nodiscard]] std::size_t total() const {
+            return buffer.text + buffer.line_table + buffer.line_metrics + undo_history + highlight_cache + syntax_tree + search_index;
+        }
+    };
+
     /** Runtime objects */
     CommandRunner &command_runner;  ///< The command runner object of the application.
     Theme &theme;                   ///< The theme object of the application.
@@ -124,11 +170,59 @@ public:
           cursor(std::move(buffer)),
           highlighter(cursor) {}
 
+    /**
+     * @brief Measures the bytes this context holds, split by subsystem.
+     *
+     * Cheap enough to run every frame: every counter is either kept up to date by its owner or
+     * read from allocated capacities, the highlight cache being the only one summed over its rows.
+     *
+     * @return The memory usage of the buffer, its history and its highlighter.
+     */
+    [[nodiscard]] MemoryUsage getMemoryUsage() const {
+        return {
+            .buffer = cursor.getBufferMemory(),
+            .undo_history = cursor.getHistoryMemory(),
+            .highlight_cache = highlighter.getCacheMemoryUsage(),
+            .syntax_tree = highlighter.getTreeMemoryUsage(),
+            .search_index = search.index.getMemoryUsage() + search.ranges.getMemoryUsage()
+        };
+    }
+
+    /**
+     * @brief Passes an edit the cursor made on to everything tracking the buffer.
+     *
+     * The highlighter, the search index and its match ranges all follow the buffer edit by edit;
+     * every path editing the cursor calls this right after, in the order the cursor returned the edits.
+     *
+     * @param edit The edit, as returned by the Cursor.
+     */
+    void notifyEdit(const BufferEdit &edit) {
+        highlighter.edit(edit);
+        search.index.edit(edit);
+        search.ranges.edit(edit);
+    }
+
+    /**
+     * @brief Passes a run of edits the cursor made at once, such as an undo step, on to everything tracking the buffer.
+     *
+     * The highlighter and the match ranges take them one by one; the search index shifts its
+     * counts once for the whole run.
+     *
+     * @param edits The edits, in the order the Cursor returned them.
+     */
+    void notifyEdits(const std::span<const BufferEdit> edits) {
+        for (const auto &edit : edits) {
+            highlighter.edit(edit);
+            search.ranges.edit(edit);
+        }
+        search.index.edit(edits);
+    }
+
     /**
      * @brief Erases the active selection, if any, and leaves the context consistent with it.
      *
      * Every editing path starts by dropping whatever is selected, and each one has to feed the
-     * resulting edit to the highlighter, put the cursor where the removed range collapsed, and
+     * resulting edit to notifyEdit, put the cursor where the removed range collapsed, and
      * disarm the selection. This context owns both the Cursor and the HighLighter, so it is the
      * one place that whole sequence can live. A selection that is merely armed but empty erases
      * nothing and is disarmed by the Cursor itself.
@@ -141,7 +235,7 @@ public:
             return false;
         }
 
-        highlighter.edit(edit.value());
+        notifyEdit(edit.value());
         cursor.setPosition(edit->new_end.line, edit->new_end.column);
         cursor.activateSelection(false);
         return true;
@@ -21,6 +21,7 @@
 #include <algorithm>
 
 #include "cursor/buffer/LineBuffer.h"
+#include "../platform/Platform.h"
 
 
 CursorContextManager::CursorContextManager(CommandRunner &commandRunner, Theme &theme, PromptCursor &promptCursor, std::shared_ptr<CVarInt> maxUndo)
@@ -55,6 +56,11 @@ std::unique_ptr<CursorContext> CursorContextManager::makeContext() const {
     // Every cursor shares the same history depth CVar, so dim_max_undo applies globally.
     context->cursor.shareMaxHistoryDepth(m_max_undo);
     context->cursor.setMaxHistoryDepth();
+
+    // Where there is a scratch directory, what the depth cap pushes out goes to disk rather than away
+    if (const auto directory = Platform::tempDir()) {
+        context->cursor.enableHistoryJournal(*directory);
+    }
     return context;
 }
 
@@ -119,6 +125,12 @@ void CursorContextManager::applyMaxHistoryDepth() {
     }
 }
 
+void CursorContextManager::holdUndoGroups(const bool hold) {
+    for (const auto &context : m_contexts) {
+        context->cursor.holdUndoGroup(hold);
+    }
+}
+
 void CursorContextManager::refreshIndices() {
     for (size_t index = 0; index < m_contexts.size(); ++index) {
         m_contexts[index]->buffer_index = index + 1;
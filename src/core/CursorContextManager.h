@@ -146,6 +146,15 @@ public:
 
     /** @brief Trims the undo/redo history of every open context down to the shared maximum depth. */
     void applyMaxHistoryDepth();
+
+    /**
+     * @brief Holds or releases a single undo group in every open context.
+     *
+     * Contexts opened while the groups are held keep the usual grouping.
+     *
+     * @param hold Whether to hold the groups or release them.
+     */
+    void holdUndoGroups(bool hold);
 };
 
 
@@ -0,0 +1,303 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "FilterJob.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include <utf8.h>
+
+
+namespace {
+
+/**
+ * @brief Appends UTF-16 text to a string as UTF-8, a lone surrogate becoming U+FFFD.
+ * @param text The text to encode; must not end inside a surrogate pair.
+ * @param out The string to append to.
+ */
+void encodeUtf8(const std::u16string_view text, std::string &out) {
+    for (size_t index = 0; index < text.length(); ++index) {
+        auto code_point = static_cast<uint32_t>(text[index]);
+        if (code_point < 0x80) {
+            out.push_back(static_cast<char>(code_point));
+            continue;
+        }
+
+        if ((code_point & 0xFC00) == 0xD800 && index + 1 < text.length() && (text[index + 1] & 0xFC00) == 0xDC00) {
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (text[index + 1] - 0xDC00);
+            ++index;
+        } else if ((code_point & 0xF800) == 0xD800) {
+            code_point = 0xFFFD;
+        }
+
+        if (code_point < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        } else if (code_point < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        }
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+/**
+ * @brief Decodes the complete UTF-8 sequences of a string, keeping an incomplete one at its end.
+ *
+ * A sequence can be cut between two reads: its lead bytes wait in @p pending for the rest.
+ *
+ * @param pending The bytes read and not decoded yet; left with the incomplete tail.
+ * @param out The string to append the decoded text to.
+ */
+void decodeUtf8(std::string &pending, std::u16string &out) {
+    // Look back over at most three bytes for a lead byte whose sequence runs past the end
+    auto complete = pending.length();
+    for (size_t back = 1; back <= std::min<size_t>(3, pending.length()); ++back) {
+        const auto byte = static_cast<unsigned char>(pending[pending.length() - back]);
+        if ((byte & 0xC0) == 0x80) {
+            continue;
+        }
+
+        const auto length = byte >= 0xF0 ? 4u : byte >= 0xE0 ? 3u : byte >= 0xC0 ? 2u : 1u;
+        if (length > back) {
+            complete = pending.length() - back;
+        }
+        break;
+    }
+
+    const auto bytes = std::string_view(pending).substr(0, complete);
+    if (utf8::find_invalid(bytes.begin(), bytes.end()) == bytes.end()) {
+        utf8::utf8to16(bytes.begin(), bytes.end(), std::back_inserter(out));
+    } else {
+        const auto valid = utf8::replace_invalid(bytes);
+        utf8::utf8to16(valid.begin(), valid.end(), std::back_inserter(out));
+    }
+    pending.erase(0, complete);
+}
+
+}
+
+
+FilterJob::FilterJob()
+    : p_cursor(nullptr),
+      m_edit_count(0),
+      m_range(),
+      m_adds_line_end(false),
+      m_exit_code(-1),
+      m_cancelled(false),
+      m_running(0),
+      m_bytes_written(0),
+      m_bytes_read(0) {}
+
+FilterJob::~FilterJob() {
+    cancel();
+}
+
+bool FilterJob::start(const Cursor &cursor, const TextRange &range, const std::string &command) {
+    cancel();
+    m_threads.clear();
+    m_child.reset();
+    p_cursor = nullptr;
+
+    auto child = std::make_unique<ChildProcess>(command);
+    if (!child->isStarted()) {
+        return false;
+    }
+
+    m_child = std::move(child);
+    p_cursor = &cursor;
+    m_gate = cursor.getReadGate();
+    m_edit_count = m_gate->getEditCount();
+    m_range = range;
+    m_adds_line_end = range.column_end != 0 || range.line_end == range.line_start;
+    m_output.clear();
+    m_error.clear();
+    m_exit_code = -1;
+    m_cancelled = false;
+    m_bytes_written = 0;
+    m_bytes_read = 0;
+
+    m_running = 3;
+    m_threads.reserve(3);
+    m_threads.emplace_back([this](const std::stop_token &stopToken) {
+        writeInput(stopToken);
+        --m_running;
+    });
+    m_threads.emplace_back([this] {
+        readOutput();
+        --m_running;
+    });
+    m_threads.emplace_back([this] {
+        readError();
+        --m_running;
+    });
+    return true;
+}
+
+void FilterJob::cancel() {
+    if (!m_child || !isRunning()) {
+        return;
+    }
+
+    // Killing the group ends the reads; the writer stops between chunks or fails its write
+    m_cancelled = true;
+    m_child->kill();
+    m_threads.clear();
+}
+
+bool FilterJob::isRunning() const {
+    return m_running > 0;
+}
+
+bool FilterJob::isStarted() const {
+    return p_cursor != nullptr;
+}
+
+const Cursor *FilterJob::getCursor() const {
+    return p_cursor;
+}
+
+const TextRange &FilterJob::getRange() const {
+    return m_range;
+}
+
+FilterJob::Stats FilterJob::getStats() const {
+    return Stats{
+        .bytes_written = m_bytes_written,
+        .bytes_read = m_bytes_read
+    };
+}
+
+FilterJob::Result FilterJob::takeResult() {
+    m_threads.clear();
+    m_child.reset();
+    p_cursor = nullptr;
+    const auto gate = std::exchange(m_gate, {});
+
+    return Result{
+        .output = std::exchange(m_output, {}),
+        .error = std::exchange(m_error, {}),
+        .exit_code = m_exit_code,
+        .cancelled = m_cancelled,
+        .edited = gate && gate->getEditCount() != m_edit_count
+    };
+}
+
+void FilterJob::writeInput(const std::stop_token &stopToken) {
+    auto chunk = std::string{};
+    chunk.reserve(CHUNK_BYTES + CHUNK_BYTES / 2);
+
+    const auto flush = [this, &chunk] {
+        if (!m_child->writeInput(chunk)) {
+            return false;
+        }
+        m_bytes_written += chunk.length();
+        chunk.clear();
+        return true;
+    };
+
+    // A line is encoded a slice at a time, so a huge one still goes in chunks of about CHUNK_BYTES.
+    // Each slice is read with the gate held, and the gate is let go before writing: a child that
+    // reads slowly never holds an edit back.
+    static constexpr size_t SLICE_UNITS = CHUNK_BYTES / 4;
+    auto open = true;
+    for (auto line = m_range.line_start; open && line <= m_range.line_end; ++line) {
+        auto column = line == m_range.line_start ? m_range.column_start : 0u;
+        auto line_done = false;
+        while (open && !line_done) {
+            if (const auto lock = m_gate->lockUnchanged(m_edit_count); lock.owns_lock()) {
+                auto text = p_cursor->getString(line);
+                if (line == m_range.line_end) {
+                    text = text.substr(0, m_range.column_end);
+                }
+                text.remove_prefix(column);
+
+                auto slice = text.substr(0, SLICE_UNITS);
+                if (slice.length() < text.length() && (slice.back() & 0xFC00) == 0xD800) {
+                    // Never split a surrogate pair
+                    slice.remove_suffix(1);
+                }
+                encodeUtf8(slice, chunk);
+                column += static_cast<uint32_t>(slice.length());
+                line_done = slice.length() == text.length();
+            } else {
+                // Edited or closed: the rest of the range is not the text the job started from
+                open = false;
+                break;
+            }
+
+            if (chunk.length() >= CHUNK_BYTES) {
+                open = !stopToken.stop_requested() && flush();
+            }
+        }
+
+        if (open && (line < m_range.line_end || m_adds_line_end)) {
+            chunk.push_back('\n');
+        }
+    }
+
+    if (open && !chunk.empty()) {
+        (void) flush();
+    }
+    m_child->closeInput();
+}
+
+void FilterJob::readOutput() {
+    auto buffer = std::string(CHUNK_BYTES, '\0');
+    auto pending = std::string{};
+    for (auto count = m_child->readOutput(buffer.data(), buffer.size()); count > 0; count = m_child->readOutput(buffer.data(), buffer.size())) {
+        m_bytes_read += static_cast<uint64_t>(count);
+        pending.append(buffer.data(), static_cast<size_t>(count));
+        decodeUtf8(pending, m_output);
+    }
+
+    // Whatever is left is a cut sequence the output ended in
+    if (!pending.empty()) {
+        m_output.push_back(u'\uFFFD');
+    }
+
+    // CRLF line ends read as LF, off the main thread: the buffer stores lines without their ends
+    auto kept = m_output.begin();
+    for (auto unit = m_output.begin(); unit != m_output.end(); ++unit) {
+        if (*unit != u'\r' || std::next(unit) == m_output.end() || *std::next(unit) != u'\n') {
+            *kept++ = *unit;
+        }
+    }
+    m_output.erase(kept, m_output.end());
+
+    // The line end answering the one added to the input
+    if (m_adds_line_end && m_output.ends_with(u'\n')) {
+        m_output.pop_back();
+    }
+
+    m_exit_code = m_child->wait();
+}
+
+void FilterJob::readError() {
+    auto buffer = std::string(CHUNK_BYTES, '\0');
+    for (auto count = m_child->readError(buffer.data(), buffer.size()); count > 0; count = m_child->readError(buffer.data(), buffer.size())) {
+        const auto kept = std::min(static_cast<size_t>(count), MAX_ERROR_BYTES - m_error.length());
+        m_error.append(buffer.data(), kept);
+    }
+}
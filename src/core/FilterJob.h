@@ -0,0 +1,186 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILTER_JOB_H
+#define FILTER_JOB_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "cursor/Cursor.h"
+#include "cursor/ReadGate.h"
+#include "cursor/TextRange.h"
+#include "../platform/ChildProcess.h"
+
+
+/**
+ * @brief Pipes a range of a buffer through a shell command on background threads, collecting its output.
+ *
+ * One thread encodes the range to UTF-8 a chunk of CHUNK_BYTES at a time and writes it to the
+ * child, so the input is never copied whole and a child that reads slowly holds the thread, not
+ * the memory. A second thread reads the output and decodes it to UTF-16 as it arrives, an invalid
+ * sequence becoming U+FFFD, then waits for the child to exit; a third keeps the first
+ * MAX_ERROR_BYTES of the error stream for the report.
+ *
+ * The range is piped with a final line end when it does not end with one, so line tools see
+ * complete lines, and the output then loses its own final line end. CRLF line ends in the output
+ * read as LF. The job is owned and polled by the main thread only.
+ *
+ * The range is read through the buffer's ReadGate, a slice at a time and never while writing to
+ * the child. Editing or closing the buffer meanwhile stops the writer, and the result then says
+ * the buffer was edited: the output no longer answers its text.
+ */
+class FilterJob final {
+public:
+    /** Number of bytes written or read per call to the child. */
+    static constexpr size_t CHUNK_BYTES = 65536;
+
+    /** Number of bytes of the error stream kept for the report; the rest is read and dropped. */
+    static constexpr size_t MAX_ERROR_BYTES = 4096;
+
+    /** @brief Counters of a job, readable while it runs. */
+    struct Stats final {
+        uint64_t bytes_written; ///< UTF-8 bytes piped to the child.
+        uint64_t bytes_read;    ///< Bytes the child wrote to its output.
+    };
+
+    /** @brief What a job produced, once it is over. */
+    struct Result final {
+        std::u16string output; ///< The output of the child, decoded.
+        std::string error;     ///< The start of the error stream of the child. UTF-8.
+        int exit_code;         ///< The exit code of the child; -1 when a signal ended it.
+        bool cancelled;        ///< true when the job was cancelled before the child exited on its own.
+        bool edited;           ///< true when the buffer was edited, or closed, after the job started.
+    };
+
+private:
+    /** The child running the command, while the job is started. */
+    std::unique_ptr<ChildProcess> m_child;
+
+    /** The buffer the range is read from; only touched with the gate held. */
+    const Cursor *p_cursor;
+
+    /** The gate the buffer is read through. */
+    std::shared_ptr<ReadGate> m_gate;
+
+    /** Edit count of the gate when the job started. */
+    uint64_t m_edit_count;
+
+    /** The range piped to the child. */
+    TextRange m_range;
+
+    /** Whether a line end is piped after the range, and dropped from the end of the output. */
+    bool m_adds_line_end;
+
+    /** The output decoded so far; only the reader thread touches it until the job is over. */
+    std::u16string m_output;
+
+    /** The start of the error stream; only the error thread touches it until the job is over. */
+    std::string m_error;
+
+    /** Exit code of the child, set by the reader thread once the child exited. */
+    int m_exit_code;
+
+    /** true once cancel killed the child. */
+    bool m_cancelled;
+
+    /** Number of threads still running. */
+    std::atomic<uint32_t> m_running;
+
+    std::atomic<uint64_t> m_bytes_written; ///< See Stats::bytes_written.
+    std::atomic<uint64_t> m_bytes_read;    ///< See Stats::bytes_read.
+
+    /** The writer, the reader and the error thread; destroying them requests their stop and joins them. */
+    std::vector<std::jthread> m_threads;
+
+    /**
+     * @brief Encodes the range and writes it to the child, then closes the child's input.
+     * @param stopToken Requests the writer to stop after the current chunk.
+     */
+    void writeInput(const std::stop_token &stopToken);
+
+    /** @brief Reads and decodes the output until the child closes it, then waits for the child to exit. */
+    void readOutput();
+
+    /** @brief Reads the error stream until the child closes it. */
+    void readError();
+
+public:
+    /** @brief Deleted copy constructor. */
+    FilterJob(const FilterJob &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    FilterJob &operator=(const FilterJob &) = delete;
+
+    /** @brief Constructs an idle job. */
+    explicit FilterJob();
+
+    /** @brief Kills the child, if running, and waits for the threads. */
+    ~FilterJob();
+
+    /**
+     * @brief Starts piping a range through a command, cancelling the previous job first.
+     *
+     * @param cursor The buffer holding the range.
+     * @param range The range to pipe; its coordinates must be ordered.
+     * @param command The command line, as typed in a shell. UTF-8.
+     * @return false when the command could not be started, leaving the job idle.
+     */
+    bool start(const Cursor &cursor, const TextRange &range, const std::string &command);
+
+    /**
+     * @brief Kills the child and waits for the threads. No-op when idle.
+     *
+     * The job stays started: takeResult hands over what the child produced until then, marked as
+     * cancelled.
+     */
+    void cancel();
+
+    /** @return true while the threads run; the result is only complete once they are done. */
+    [[nodiscard]] bool isRunning() const;
+
+    /** @return true from start until the result is taken. */
+    [[nodiscard]] bool isStarted() const;
+
+    /** @return The buffer the range is read from, while the job is started; nullptr otherwise. */
+    [[nodiscard]] const Cursor *getCursor() const;
+
+    /** @return The range piped to the child. */
+    [[nodiscard]] const TextRange &getRange() const;
+
+    /** @return A snapshot of the counters. */
+    [[nodiscard]] Stats getStats() const;
+
+    /**
+     * @brief Waits for the threads, then hands over what the job produced and leaves it idle.
+     *
+     * Meant to be called once isRunning turned false, or after cancel.
+     *
+     * @return The output, the error report and the exit code.
+     */
+    [[nodiscard]] Result takeResult();
+};
+
+
+#endif //FILTER_JOB_H
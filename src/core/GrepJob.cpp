@@ -0,0 +1,367 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "GrepJob.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include <utf8.h>
+
+#include "base/CaseFold.h"
+#include "base/LineScanner.h"
+#include "base/NumberText.h"
+#include "base/Regex.h"
+#include "cursor/SurrogatePair.h"
+#include "../platform/MappedFile.h"
+
+
+namespace {
+
+/**
+ * @brief Folds an ASCII letter to lower case, leaving every other byte alone.
+ * @param byte The byte to fold.
+ * @return The folded byte.
+ */
+char foldAscii(const char byte) {
+    return byte >= 'A' && byte <= 'Z' ? static_cast<char>(byte - 'A' + 'a') : byte;
+}
+
+/** @brief Hashes a byte the way FoldEqual compares it. */
+struct FoldHash final {
+    size_t operator()(const char byte) const {
+        return static_cast<unsigned char>(foldAscii(byte));
+    }
+};
+
+/** @brief Compares two bytes, ASCII letters regardless of case. */
+struct FoldEqual final {
+    bool operator()(const char left, const char right) const {
+        return foldAscii(left) == foldAscii(right);
+    }
+};
+
+/**
+ * @brief Tells whether a non-ASCII character folds to a unit of an ASCII needle, like the Kelvin sign to k.
+ *
+ * A case-insensitive match of such a needle may hold bytes the ASCII comparison of the raw-byte
+ * pre-filter does not recognize.
+ *
+ * @param needle The ASCII needle.
+ * @return true when the pre-filter could miss a case-insensitive match of @p needle.
+ */
+bool hasNonAsciiFold(const std::u16string_view needle) {
+    for (const auto &rule : CaseFold::getRules()) {
+        for (auto unit = uint32_t{ rule.first }; unit <= rule.last; unit += rule.step) {
+            const auto folded = CaseFold::fold(static_cast<char16_t>(unit));
+            if (unit >= 0x80 && folded < 0x80
+                && std::ranges::any_of(needle, [folded](const char16_t character) { return CaseFold::fold(character) == folded; })) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/** Searcher of the raw-byte pre-filter. */
+using ByteSearcher = std::boyer_moore_horspool_searcher<std::string::const_iterator, FoldHash, FoldEqual>;
+
+/** @brief Where a line lies in the converted text of a file. */
+struct LineSpan final {
+    size_t start;  ///< Offset of the line in the text.
+    size_t length; ///< Length of the line, without its line ending.
+};
+
+/**
+ * @brief The lines of a converted file, as LineScanner::forEachMatch expects them.
+ *
+ * The whole text is one run: the separators between lines are gaps in it, which forEachMatch
+ * steps over.
+ */
+struct FileLines final {
+    std::u16string_view text;            ///< Converted content of the file.
+    const std::vector<LineSpan> &lines;  ///< Lines of the text, in order.
+    uint32_t end;                        ///< Line the scan stops before.
+
+    [[nodiscard]] uint32_t getLineCount() const {
+        return end;
+    }
+
+    [[nodiscard]] std::u16string_view getString(const uint32_t line) const {
+        return text.substr(lines[line].start, lines[line].length);
+    }
+
+    [[nodiscard]] uint32_t getContiguousLineCount(const uint32_t line) const {
+        return getLineCount() - line;
+    }
+};
+
+}
+
+
+GrepJob::GrepJob()
+    : m_walking(false),
+      m_running(0),
+      m_files_scanned(0),
+      m_files_skipped(0),
+      m_files_matched(0),
+      m_match_count(0) {}
+
+GrepJob::~GrepJob() {
+    cancel();
+}
+
+void GrepJob::start(const std::filesystem::path &root, const std::u16string_view term, const bool caseSensitive, const bool regex, const uint32_t threadCount) {
+    cancel();
+
+    m_queue.clear();
+    m_walking = true;
+    m_output.clear();
+    m_files_scanned = 0;
+    m_files_skipped = 0;
+    m_files_matched = 0;
+    m_match_count = 0;
+
+    const auto worker_count = std::max(threadCount, 1u);
+    m_running = worker_count + 1;
+    m_threads.reserve(worker_count + 1);
+    m_threads.emplace_back([this, root](const std::stop_token &stopToken) {
+        walk(stopToken, root);
+        --m_running;
+    });
+
+    for (auto worker = 0u; worker < worker_count; ++worker) {
+        m_threads.emplace_back([this, term = std::u16string(term), caseSensitive, regex](const std::stop_token &stopToken) {
+            work(stopToken, term, caseSensitive, regex);
+            --m_running;
+        });
+    }
+}
+
+void GrepJob::cancel() {
+    // A jthread requests its stop then joins when destroyed; the condition wait wakes on the request
+    m_threads.clear();
+    m_running = 0;
+}
+
+bool GrepJob::isRunning() const {
+    return m_running > 0;
+}
+
+bool GrepJob::isStarted() const {
+    return !m_threads.empty();
+}
+
+bool GrepJob::takeOutput(std::u16string &out) {
+    const auto lock = std::lock_guard(m_output_mutex);
+    if (m_output.empty()) {
+        return false;
+    }
+
+    out.append(m_output);
+    m_output.clear();
+    return true;
+}
+
+GrepJob::Stats GrepJob::getStats() const {
+    return Stats{
+        .files_scanned = m_files_scanned,
+        .files_skipped = m_files_skipped,
+        .files_matched = m_files_matched,
+        .match_count = m_match_count
+    };
+}
+
+void GrepJob::walk(const std::stop_token &stopToken, const std::filesystem::path &root) {
+    // Non-throwing filesystem overloads only, as for the path completions: an unreadable entry
+    // must never terminate the app
+    auto error_code = std::error_code{};
+    auto iterator = std::filesystem::recursive_directory_iterator(root, std::filesystem::directory_options::skip_permission_denied, error_code);
+    for (const auto end = std::filesystem::recursive_directory_iterator(); !error_code && iterator != end && !stopToken.stop_requested(); iterator.increment(error_code)) {
+        const auto &entry = *iterator;
+        auto entry_error = std::error_code{};
+        if (entry.is_directory(entry_error)) {
+            if (entry.path().filename().string().starts_with('.')) {
+                iterator.disable_recursion_pending();
+            }
+            continue;
+        }
+
+        if (entry.is_regular_file(entry_error)) {
+            const auto lock = std::lock_guard(m_queue_mutex);
+            m_queue.push_back(entry.path());
+            m_queue_condition.notify_one();
+        }
+    }
+
+    const auto lock = std::lock_guard(m_queue_mutex);
+    m_walking = false;
+    m_queue_condition.notify_all();
+}
+
+void GrepJob::work(const std::stop_token &stopToken, const std::u16string &term, const bool caseSensitive, const bool regex) {
+    const auto scanner = regex
+        ? LineScanner(std::make_shared<Regex>(term, caseSensitive))
+        : LineScanner(term, caseSensitive);
+
+    // An ASCII needle reads the same in UTF-8: look for it in the bytes before converting anything.
+    // The bytes are always compared regardless of case; a false candidate only costs a conversion.
+    const auto needle = std::u16string_view(regex ? scanner.getRegex()->getPrefix() : term);
+    const auto needle_is_ascii = !needle.empty() && std::ranges::all_of(needle, [](const char16_t unit) { return unit < 0x80; })
+        && (caseSensitive || !hasNonAsciiFold(needle));
+    const auto needle_bytes = needle_is_ascii ? std::string(needle.begin(), needle.end()) : std::string{};
+    const auto searcher = needle_is_ascii
+        ? std::optional<ByteSearcher>(std::in_place, needle_bytes.begin(), needle_bytes.end())
+        : std::nullopt;
+
+    // Reused from file to file, so a worker reaches its peak memory once
+    auto text = std::u16string{};
+    auto lines = std::vector<LineSpan>{};
+    auto entries = std::u16string{};
+
+    while (true) {
+        auto path = std::filesystem::path{};
+        {
+            auto lock = std::unique_lock(m_queue_mutex);
+            m_queue_condition.wait(lock, stopToken, [this] { return !m_queue.empty() || !m_walking; });
+            if (stopToken.stop_requested() || m_queue.empty()) {
+                // Stopped, or the walk is over and nothing is left
+                return;
+            }
+            path = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        const auto file = MappedFile(path.string());
+        const auto bytes = file.getBytes();
+        if (!file.isOpen() || bytes.substr(0, BINARY_PROBE_BYTES).find('\0') != std::string_view::npos) {
+            ++m_files_skipped;
+            continue;
+        }
+
+        // Every pass over the file goes by chunks, so a stop request waits for a chunk, not a file.
+        // The pre-filter windows overlap by the needle length, so no occurrence straddles two.
+        if (searcher) {
+            auto found = false;
+            for (size_t start = 0; !found && start < bytes.length(); start += CHUNK_BYTES) {
+                if (stopToken.stop_requested()) {
+                    return;
+                }
+                const auto window = bytes.substr(start, CHUNK_BYTES + needle_bytes.length() - 1);
+                found = std::search(window.begin(), window.end(), *searcher) != window.end();
+            }
+            if (!found) {
+                ++m_files_scanned;
+                continue;
+            }
+        }
+
+        auto name = std::u16string{};
+        try {
+            name = utf8::utf8to16(path.lexically_normal().string());
+        } catch (const utf8::exception &) {
+            // A name that is not valid UTF-8 could not be opened from the listing anyway
+            ++m_files_skipped;
+            continue;
+        }
+
+        // Chunks end before a lead byte, so each one holds whole sequences and is validated before
+        // it is converted: the conversion cannot throw
+        text.clear();
+        auto valid = true;
+        for (size_t start = 0; valid && start < bytes.length();) {
+            if (stopToken.stop_requested()) {
+                return;
+            }
+            auto end = std::min(start + CHUNK_BYTES, bytes.length());
+            while (end < bytes.length() && (static_cast<unsigned char>(bytes[end]) & 0xC0) == 0x80 && end > start + 1) {
+                --end;
+            }
+            const auto chunk = bytes.substr(start, end - start);
+            valid = utf8::find_invalid(chunk.begin(), chunk.end()) == chunk.end();
+            if (valid) {
+                utf8::utf8to16(chunk.begin(), chunk.end(), std::back_inserter(text));
+            }
+            start = end;
+        }
+        if (!valid) {
+            ++m_files_skipped;
+            continue;
+        }
+
+        lines.clear();
+        for (size_t start = 0;;) {
+            if (lines.size() % CHUNK_LINES == 0 && stopToken.stop_requested()) {
+                return;
+            }
+            const auto end = text.find(u'\n', start);
+            auto length = (end == std::u16string::npos ? text.length() : end) - start;
+            if (length > 0 && text[start + length - 1] == u'\r') {
+                // Leave the carriage return of a CRLF line ending out of the line
+                --length;
+            }
+            lines.push_back(LineSpan{.start = start, .length = length});
+            if (end == std::u16string::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+
+        entries.clear();
+        auto match_count = 0u;
+        auto listing = true;
+        for (uint32_t first = 0; listing && first < lines.size(); first += CHUNK_LINES) {
+            const auto file_lines = FileLines{.text = text, .lines = lines, .end = static_cast<uint32_t>(std::min<size_t>(first + CHUNK_LINES, lines.size()))};
+            scanner.forEachMatch(file_lines, first, 0, [&](const uint32_t line, const uint32_t column) {
+                if (stopToken.stop_requested()) {
+                    listing = false;
+                    return false;
+                }
+
+                const auto line_text = file_lines.getString(line);
+                entries.append(name).push_back(u':');
+                appendNumber(entries, line + 1);
+                entries.push_back(u':');
+                appendNumber(entries, column + 1);
+                entries.append(u": ");
+                if (line_text.length() > MAX_ENTRY_TEXT) {
+                    entries.append(line_text.substr(0, snapToCharBoundary(line_text, MAX_ENTRY_TEXT)));
+                } else {
+                    entries.append(line_text);
+                }
+                entries.push_back(u'\n');
+                listing = ++match_count < MAX_MATCHES_PER_FILE;
+                return listing;
+            });
+        }
+        if (stopToken.stop_requested()) {
+            return;
+        }
+
+        ++m_files_scanned;
+        if (match_count > 0) {
+            ++m_files_matched;
+            m_match_count += match_count;
+
+            const auto lock = std::lock_guard(m_output_mutex);
+            m_output.append(entries);
+        }
+    }
+}
@@ -0,0 +1,172 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef GREP_JOB_H
+#define GREP_JOB_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Searches every file under a directory on background threads, producing a listing as it goes.
+ *
+ * One thread walks the tree and queues the regular files; a pool of workers maps each file
+ * (MappedFile), skips it when it looks binary (a NUL byte in its first BINARY_PROBE_BYTES bytes)
+ * or is not valid UTF-8, and runs a LineScanner over the whole file. Every pass over a file goes
+ * by CHUNK_BYTES or CHUNK_LINES, so cancel() waits for a chunk, not for a large file. When the term, or
+ * the literal prefix of a pattern, is ASCII, the raw bytes are searched for it first, so a file
+ * without a match is never converted; a case-insensitive needle a non-ASCII character folds into,
+ * like the Kelvin sign into k, goes without. Hidden directories, whose name starts with a dot, are not
+ * walked.
+ *
+ * Each match adds a `file:line:column: text` entry, with 1-based lines and columns, to the
+ * output takeOutput hands over; the entries of a file are contiguous, the files come in the order
+ * the workers finish them. The job is owned and polled by the main thread only.
+ */
+class GrepJob final {
+public:
+    /** Number of leading bytes looked at for a NUL byte, the mark of a binary file. */
+    static constexpr size_t BINARY_PROBE_BYTES = 8192;
+
+    /** Number of bytes of a file a worker reads, validates or converts between two looks at a stop request. */
+    static constexpr size_t CHUNK_BYTES = 1u << 20;
+
+    /** Number of lines of a file a worker splits or scans between two looks at a stop request. */
+    static constexpr uint32_t CHUNK_LINES = 16384;
+
+    /** Number of matches listed per file; the rest of the file is skipped. */
+    static constexpr uint32_t MAX_MATCHES_PER_FILE = 1000;
+
+    /** Number of code units of a matching line an entry shows; the rest is cut. */
+    static constexpr size_t MAX_ENTRY_TEXT = 512;
+
+    /** @brief Counters of a job, readable while it runs. */
+    struct Stats final {
+        uint64_t files_scanned; ///< Files searched through.
+        uint64_t files_skipped; ///< Files that could not be read, binary ones, or not UTF-8.
+        uint64_t files_matched; ///< Files with at least one match.
+        uint64_t match_count;   ///< Matches listed.
+    };
+
+private:
+    /** Files found by the walker, waiting for a worker. */
+    std::deque<std::filesystem::path> m_queue;
+
+    /** Guards m_queue and m_walking. */
+    std::mutex m_queue_mutex;
+
+    /** Wakes the workers when files are queued or the walk ends. */
+    std::condition_variable_any m_queue_condition;
+
+    /** true until the walker has queued every file. */
+    bool m_walking;
+
+    /** Entries produced and not taken yet. */
+    std::u16string m_output;
+
+    /** Guards m_output. */
+    std::mutex m_output_mutex;
+
+    /** Number of threads still running, walker included. */
+    std::atomic<uint32_t> m_running;
+
+    std::atomic<uint64_t> m_files_scanned; ///< See Stats::files_scanned.
+    std::atomic<uint64_t> m_files_skipped; ///< See Stats::files_skipped.
+    std::atomic<uint64_t> m_files_matched; ///< See Stats::files_matched.
+    std::atomic<uint64_t> m_match_count;   ///< See Stats::match_count.
+
+    /** The walker, then the workers; destroying them requests their stop and joins them. */
+    std::vector<std::jthread> m_threads;
+
+    /**
+     * @brief Walks the tree and queues its regular files.
+     * @param stopToken Requests the walk to stop early.
+     * @param root The directory to walk.
+     */
+    void walk(const std::stop_token &stopToken, const std::filesystem::path &root);
+
+    /**
+     * @brief Searches the queued files until the queue is drained and the walk is over.
+     * @param stopToken Requests the worker to stop, within a chunk of the current file.
+     * @param term The term or the pattern to look for.
+     * @param caseSensitive Whether comparisons are case-sensitive.
+     * @param regex Whether @p term is a regular expression.
+     */
+    void work(const std::stop_token &stopToken, const std::u16string &term, bool caseSensitive, bool regex);
+
+public:
+    /** @brief Deleted copy constructor. */
+    GrepJob(const GrepJob &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    GrepJob &operator=(const GrepJob &) = delete;
+
+    /** @brief Constructs an idle job. */
+    explicit GrepJob();
+
+    /** @brief Stops the job, if running, and waits for its threads. */
+    ~GrepJob();
+
+    /**
+     * @brief Starts searching a directory tree, stopping the previous search first.
+     *
+     * The counters and the pending output start over.
+     *
+     * @param root The directory to search.
+     * @param term The term or the pattern to look for; a pattern must be valid.
+     * @param caseSensitive Whether comparisons are case-sensitive.
+     * @param regex Whether @p term is a regular expression.
+     * @param threadCount The number of workers, at least 1; the walker runs beside them.
+     */
+    void start(const std::filesystem::path &root, std::u16string_view term, bool caseSensitive, bool regex, uint32_t threadCount);
+
+    /**
+     * @brief Stops the search and waits for its threads, which finish the file they are on.
+     *
+     * The entries already produced can still be taken. No-op when idle.
+     */
+    void cancel();
+
+    /** @return true while the search runs; the entries produced until it stops may still be pending. */
+    [[nodiscard]] bool isRunning() const;
+
+    /** @return true when the threads of a search are still held, running or done; cancel releases them. */
+    [[nodiscard]] bool isStarted() const;
+
+    /**
+     * @brief Moves the entries produced since the last call to the end of a string.
+     * @param out The string to append to; every entry ends with a newline.
+     * @return true when anything was appended.
+     */
+    bool takeOutput(std::u16string &out);
+
+    /** @return A snapshot of the counters. */
+    [[nodiscard]] Stats getStats() const;
+};
+
+
+#endif //GREP_JOB_H
@@ -0,0 +1,140 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "MacroRecorder.h"
+
+#include <algorithm>
+#include <utility>
+
+
+MacroRecorder::MacroRecorder()
+    : m_state(State::Idle),
+      m_play_count(0),
+      m_played_count(0),
+      m_step_index(0) {}
+
+MacroRecorder::State MacroRecorder::getState() const {
+    return m_state;
+}
+
+bool MacroRecorder::isRecording() const {
+    return m_state == State::Recording;
+}
+
+bool MacroRecorder::isPlaying() const {
+    return m_state == State::Playing;
+}
+
+std::size_t MacroRecorder::getStepCount() const {
+    return m_steps.size();
+}
+
+bool MacroRecorder::startRecording() {
+    if (m_state != State::Idle) {
+        return false;
+    }
+
+    m_recording.clear();
+    m_state = State::Recording;
+    return true;
+}
+
+bool MacroRecorder::stopRecording() {
+    if (m_state != State::Recording) {
+        return false;
+    }
+
+    m_steps = std::move(m_recording);
+    m_recording = {};
+    m_state = State::Idle;
+    return true;
+}
+
+void MacroRecorder::append(Step step) {
+    if (m_state == State::Recording) {
+        m_recording.emplace_back(std::move(step));
+    }
+}
+
+void MacroRecorder::recordKey(const int32_t keycode, const uint16_t modifiers) {
+    append(Step{.type = StepType::Key, .text = {}, .input = {}, .keycode = keycode, .modifiers = modifiers});
+}
+
+void MacroRecorder::recordText(const std::string_view input) {
+    // A typed word replays as one insert rather than one per character
+    if (m_state == State::Recording && !m_recording.empty() && m_recording.back().type == StepType::Text) {
+        m_recording.back().input.append(input);
+        return;
+    }
+
+    append(Step{.type = StepType::Text, .text = {}, .input = std::string(input), .keycode = 0, .modifiers = 0});
+}
+
+void MacroRecorder::recordCommand(const std::u16string_view command) {
+    append(Step{.type = StepType::Command, .text = std::u16string(command), .input = {}, .keycode = 0, .modifiers = 0});
+}
+
+void MacroRecorder::recordLine(const std::u16string_view line) {
+    append(Step{.type = StepType::Line, .text = std::u16string(line), .input = {}, .keycode = 0, .modifiers = 0});
+}
+
+bool MacroRecorder::startPlayback(const uint32_t count) {
+    if (m_state != State::Idle || m_steps.empty() || count == 0) {
+        return false;
+    }
+
+    m_play_count = std::min(count, MAX_PLAY_COUNT);
+    m_played_count = 0;
+    m_step_index = 0;
+    m_state = State::Playing;
+    return true;
+}
+
+const MacroRecorder::Step *MacroRecorder::nextStep() {
+    if (m_state != State::Playing) {
+        return nullptr;
+    }
+
+    if (m_step_index == m_steps.size()) {
+        m_step_index = 0;
+        if (++m_played_count == m_play_count) {
+            m_state = State::Idle;
+            return nullptr;
+        }
+    }
+
+    return &m_steps[m_step_index++];
+}
+
+void MacroRecorder::stopPlayback() {
+    if (m_state == State::Playing) {
+        m_state = State::Idle;
+    }
+}
+
+uint32_t MacroRecorder::getPlayCount() const {
+    return m_play_count;
+}
+
+uint32_t MacroRecorder::getPlayedCount() const {
+    return m_played_count;
+}
+
+uint64_t MacroRecorder::getPlayedStepCount() const {
+    return static_cast<uint64_t>(m_played_count) * m_steps.size() + m_step_index;
+}
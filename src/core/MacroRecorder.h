@@ -0,0 +1,184 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MACRO_RECORDER_H
+#define MACRO_RECORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Records the input of a session as a list of steps, and hands them back to replay it.
+ *
+ * The steps are what reaches the editor: the keys and text it consumed, the commands run from key
+ * bindings, and the lines confirmed in the prompt, or the questions cancelled there. The typing done
+ * inside the prompt is not a step, only the line it ends with, and neither are the commands driving
+ * the prompt itself. Consecutive text inputs are merged into one step. Mouse and touch input is not
+ * recorded.
+ *
+ * The recorder only stores and sequences; ApplicationWindow dispatches the steps, a slice at a time.
+ * A new recording replaces the previous macro only once it is stopped.
+ */
+class MacroRecorder final {
+public:
+    /** Maximum number of times a macro plays in one go. */
+    static constexpr uint32_t MAX_PLAY_COUNT = 1'000'000;
+
+    /** @brief The kind of input a step replays. */
+    enum class StepType : uint8_t {
+        Key,     ///< A key the focused view consumed.
+        Text,    ///< Text typed in the editor.
+        Command, ///< A command run from a key binding.
+        Line     ///< A line confirmed in the prompt: a command, or the answer to a question.
+    };
+
+    /** @brief One recorded input. */
+    struct Step final {
+        StepType type;         ///< What the step replays.
+        std::u16string text;   ///< The command or the prompt line.
+        std::string input;     ///< The typed text, in UTF-8 as the views receive it.
+        int32_t keycode;       ///< The key, for a Key step.
+        uint16_t modifiers;    ///< The modifiers held with the key, for a Key step.
+    };
+
+    /** @brief What the recorder is busy with. */
+    enum class State : uint8_t {
+        Idle,
+        Recording,
+        Playing
+    };
+
+private:
+    /** The steps of the last macro recorded. */
+    std::vector<Step> m_steps;
+
+    /** The steps of the recording in progress. */
+    std::vector<Step> m_recording;
+
+    /** What the recorder is busy with. */
+    State m_state;
+
+    /** Number of times the macro plays, in the current playback. */
+    uint32_t m_play_count;
+
+    /** Number of times the macro played through, in the current playback. */
+    uint32_t m_played_count;
+
+    /** Index of the next step to play. */
+    std::size_t m_step_index;
+
+    /**
+     * @brief Appends a step to the recording in progress, if any.
+     * @param step The step.
+     */
+    void append(Step step);
+
+public:
+    /** @brief Deleted copy constructor. */
+    MacroRecorder(const MacroRecorder &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    MacroRecorder &operator=(const MacroRecorder &) = delete;
+
+    /** @brief Constructs an idle recorder without a macro. */
+    explicit MacroRecorder();
+
+    /** @return What the recorder is busy with. */
+    [[nodiscard]] State getState() const;
+
+    /** @return true while a recording is in progress. */
+    [[nodiscard]] bool isRecording() const;
+
+    /** @return true while a macro is being played. */
+    [[nodiscard]] bool isPlaying() const;
+
+    /** @return The number of steps of the last macro recorded. */
+    [[nodiscard]] std::size_t getStepCount() const;
+
+    /**
+     * @brief Starts a new recording; the previous macro stays playable until it is stopped.
+     * @return false when the recorder is busy.
+     */
+    bool startRecording();
+
+    /**
+     * @brief Ends the recording in progress, making it the macro.
+     * @return false when no recording is in progress.
+     */
+    bool stopRecording();
+
+    /**
+     * @brief Records a key consumed by the focused view.
+     * @param keycode The key.
+     * @param modifiers The modifiers held with it.
+     */
+    void recordKey(int32_t keycode, uint16_t modifiers);
+
+    /**
+     * @brief Records text typed in the editor, merged into the previous step when it is text too.
+     * @param input The text, UTF-8.
+     */
+    void recordText(std::string_view input);
+
+    /**
+     * @brief Records a command run from a key binding.
+     * @param command The command string.
+     */
+    void recordCommand(std::u16string_view command);
+
+    /**
+     * @brief Records a line confirmed in the prompt.
+     * @param line The line.
+     */
+    void recordLine(std::u16string_view line);
+
+    /**
+     * @brief Starts playing the macro a number of times.
+     * @param count The number of times, clamped to MAX_PLAY_COUNT.
+     * @return false when the recorder is busy, there is no macro, or the count is 0.
+     */
+    bool startPlayback(uint32_t count);
+
+    /**
+     * @brief Returns the next step to play, and moves past it.
+     *
+     * Once the last step of the last time was handed over, the playback ends and nullptr is returned.
+     *
+     * @return The step, valid until the next call, or nullptr when the playback is over.
+     */
+    [[nodiscard]] const Step *nextStep();
+
+    /** @brief Ends the playback in progress, wherever it stands. */
+    void stopPlayback();
+
+    /** @return The number of times the macro plays, in the current or last playback. */
+    [[nodiscard]] uint32_t getPlayCount() const;
+
+    /** @return The number of times the macro played through, in the current or last playback. */
+    [[nodiscard]] uint32_t getPlayedCount() const;
+
+    /** @return The number of steps played since the playback started, over all the times. */
+    [[nodiscard]] uint64_t getPlayedStepCount() const;
+};
+
+
+#endif //MACRO_RECORDER_H
@@ -0,0 +1,191 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "SearchAllJob.h"
+
+#include <algorithm>
+
+#include "base/LineScanner.h"
+#include "base/NumberText.h"
+#include "cursor/LinesAbove.h"
+
+
+SearchAllJob::SearchAllJob()
+    : m_next_slice(0),
+      m_next_release(0),
+      m_max_matches(0),
+      m_stats(),
+      m_running(0) {}
+
+SearchAllJob::~SearchAllJob() {
+    cancel();
+}
+
+void SearchAllJob::start(const std::span<const Cursor *const> cursors, const std::span<const std::u16string> names, const std::u16string_view term, const bool caseSensitive, const bool regex, const uint32_t maxMatches, const uint32_t threadCount) {
+    cancel();
+
+    // Read on the calling thread, which is the one editing: the buffers stand still here
+    m_sources.clear();
+    m_slices.clear();
+    for (uint32_t index = 0; index < cursors.size(); ++index) {
+        const auto &cursor = *cursors[index];
+        const auto gate = cursor.getReadGate();
+        m_sources.push_back(std::make_unique<Source>(gate, &cursor, gate->getEditCount(), names[index], false, 0, false, false));
+
+        const auto line_count = cursor.getLineCount();
+        for (uint32_t start = 0; start < line_count; start += std::min(SLICE_LINES, line_count - start)) {
+            m_slices.push_back(Slice{
+                .source = index,
+                .start = start,
+                .end = start + std::min(SLICE_LINES, line_count - start),
+                .entries = {},
+                .match_count = 0,
+                .truncated = false,
+                .skipped = false,
+                .done = false
+            });
+        }
+    }
+
+    m_next_slice = 0;
+    m_next_release = 0;
+    m_max_matches = maxMatches;
+    m_output.clear();
+    m_stats = Stats{.match_count = 0, .buffers_matched = 0, .buffers_truncated = 0, .buffers_edited = 0};
+
+    const auto worker_count = std::clamp<size_t>(threadCount, 1, std::max<size_t>(m_slices.size(), 1));
+    m_running = static_cast<uint32_t>(worker_count);
+    m_threads.reserve(worker_count);
+    for (size_t worker = 0; worker < worker_count; ++worker) {
+        m_threads.emplace_back([this, term = std::u16string(term), caseSensitive, regex](const std::stop_token &stopToken) {
+            work(stopToken, term, caseSensitive, regex);
+            --m_running;
+        });
+    }
+}
+
+void SearchAllJob::cancel() {
+    // A jthread requests its stop then joins when destroyed; a worker checks it between slices
+    m_threads.clear();
+    m_running = 0;
+}
+
+bool SearchAllJob::isRunning() const {
+    return m_running > 0;
+}
+
+bool SearchAllJob::isStarted() const {
+    return !m_threads.empty();
+}
+
+bool SearchAllJob::takeOutput(std::u16string &out) {
+    const auto lock = std::lock_guard(m_output_mutex);
+    if (m_output.empty()) {
+        return false;
+    }
+
+    out.append(m_output);
+    m_output.clear();
+    return true;
+}
+
+SearchAllJob::Stats SearchAllJob::getStats() const {
+    const auto lock = std::lock_guard(m_output_mutex);
+    return m_stats;
+}
+
+void SearchAllJob::work(const std::stop_token &stopToken, const std::u16string &term, const bool caseSensitive, const bool regex) {
+    // Each worker holds its own scanner: the DFA cache of a Regex is not meant to be shared
+    const auto scanner = regex
+        ? LineScanner(std::make_shared<Regex>(term, caseSensitive))
+        : LineScanner(term, caseSensitive);
+
+    for (auto index = m_next_slice++; index < m_slices.size() && !stopToken.stop_requested(); index = m_next_slice++) {
+        auto &slice = m_slices[index];
+        auto &source = *m_sources[slice.source];
+
+        // Held for the slice only: an edit of the buffer waits for it, and no longer
+        if (const auto lock = source.gate->lockUnchanged(source.edit_count); lock.owns_lock()) {
+            // Once the buffer listed its share, the rest of it is only probed for one more match
+            const auto cap = source.full ? 0u : m_max_matches;
+            const auto lines = LinesAbove{.cursor = *source.cursor, .end = slice.end};
+            scanner.forEachMatch(lines, slice.start, 0, [&](const uint32_t line, const uint32_t column) {
+                if (slice.match_count == cap) {
+                    slice.truncated = true;
+                    return false;
+                }
+
+                slice.entries.append(source.name).push_back(u':');
+                appendNumber(slice.entries, line + 1);
+                slice.entries.push_back(u':');
+                appendNumber(slice.entries, column + 1);
+                slice.entries.append(u": ").append(lines.getString(line)).push_back(u'\n');
+                ++slice.match_count;
+                return true;
+            });
+        } else {
+            slice.skipped = true;
+        }
+        release(index);
+    }
+}
+
+void SearchAllJob::release(const size_t index) {
+    const auto lock = std::lock_guard(m_output_mutex);
+    m_slices[index].done = true;
+
+    for (; m_next_release < m_slices.size() && m_slices[m_next_release].done; ++m_next_release) {
+        auto &slice = m_slices[m_next_release];
+        auto &source = *m_sources[slice.source];
+        if (slice.skipped && !source.edited) {
+            source.edited = true;
+            ++m_stats.buffers_edited;
+        }
+
+        // Keep the entries under the cap of the buffer, cutting after the last one that fits
+        const auto room = m_max_matches - source.listed;
+        auto taken = std::min<uint64_t>(slice.match_count, room);
+        auto length = slice.entries.length();
+        if (taken < slice.match_count) {
+            length = 0;
+            for (auto entry = uint64_t{0}; entry < taken; ++entry) {
+                length = slice.entries.find(u'\n', length) + 1;
+            }
+        }
+
+        if (taken > 0) {
+            if (source.listed == 0) {
+                ++m_stats.buffers_matched;
+            }
+            source.listed += taken;
+            m_stats.match_count += taken;
+            m_output.append(slice.entries, 0, length);
+        }
+
+        if ((slice.truncated || taken < slice.match_count) && !source.truncated) {
+            source.truncated = true;
+            ++m_stats.buffers_truncated;
+        }
+        if (source.listed == m_max_matches) {
+            source.full = true;
+        }
+
+        // Released: the memory goes back as the search runs
+        slice.entries = std::u16string{};
+    }
+}
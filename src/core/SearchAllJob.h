@@ -0,0 +1,188 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SEARCH_ALL_JOB_H
+#define SEARCH_ALL_JOB_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "cursor/Cursor.h"
+#include "cursor/ReadGate.h"
+
+
+/**
+ * @brief Searches several open buffers at once on background threads, producing a listing as it goes.
+ *
+ * Buffers are cut into slices of SLICE_LINES lines, which the workers claim one at a time, so a
+ * single huge buffer keeps every worker busy as well as a dozen small ones. Each worker compiles
+ * its own copy of a pattern, as the DFA cache of a Regex is not meant to be shared between threads.
+ *
+ * The main thread keeps editing meanwhile: a slice is scanned under the ReadGate of its buffer, so
+ * an edit waits for the slices in flight at most. A buffer edited or closed during the search is
+ * not scanned any further; what was found in it before stays listed, against the text it had.
+ *
+ * Each match adds a `name:line:column: text` entry, with 1-based lines and columns, to the output
+ * takeOutput hands over. Entries come in the order of the buffers, then of the text, as the slices
+ * are released in order once scanned. The job is owned and polled by the main thread only.
+ */
+class SearchAllJob final {
+public:
+    /** Number of lines a worker scans per claim, and per hold of the read gate. */
+    static constexpr uint32_t SLICE_LINES = 16384;
+
+    /** @brief Counters of a job, readable while it runs. */
+    struct Stats final {
+        uint64_t match_count;       ///< Matches listed.
+        uint32_t buffers_matched;   ///< Buffers with at least one match listed.
+        uint32_t buffers_truncated; ///< Buffers holding more matches than the cap.
+        uint32_t buffers_edited;    ///< Buffers edited or closed before they were scanned through.
+    };
+
+private:
+    /** @brief A buffer being searched, as it stood when the search started. */
+    struct Source final {
+        std::shared_ptr<ReadGate> gate; ///< The gate the buffer is read through.
+        const Cursor *cursor;           ///< The buffer; only touched with the gate held.
+        uint64_t edit_count;            ///< Edit count of the gate when the search started.
+        std::u16string name;            ///< Name the entries start with.
+        std::atomic<bool> full;         ///< true once the cap of matches is listed; the rest is only probed.
+        uint64_t listed;                ///< Matches released so far; under m_output_mutex.
+        bool edited;                    ///< true once a slice found the buffer edited; under m_output_mutex.
+        bool truncated;                 ///< true once a match past the cap was found; under m_output_mutex.
+    };
+
+    /** @brief A run of lines of one buffer, claimed by one worker. */
+    struct Slice final {
+        uint32_t source;        ///< Index of the buffer in m_sources.
+        uint32_t start;         ///< First line of the slice.
+        uint32_t end;           ///< Line past the slice.
+        std::u16string entries; ///< Entries found, each ending with a newline.
+        uint32_t match_count;   ///< Number of entries.
+        bool truncated;         ///< true when the slice holds more matches than it could list.
+        bool skipped;           ///< true when the buffer was edited before the slice could be scanned.
+        bool done;              ///< true once scanned; under m_output_mutex.
+    };
+
+    /** The buffers searched; fixed while the threads run. */
+    std::vector<std::unique_ptr<Source>> m_sources;
+
+    /** The slices, in buffer then text order; fixed while the threads run. */
+    std::vector<Slice> m_slices;
+
+    /** Index of the next slice to claim. */
+    std::atomic<size_t> m_next_slice;
+
+    /** Index of the next slice to release to the output; under m_output_mutex. */
+    size_t m_next_release;
+
+    /** Number of matches listed per buffer. */
+    uint32_t m_max_matches;
+
+    /** Entries released and not taken yet. */
+    std::u16string m_output;
+
+    /** Guards m_output, the release of the slices and the counters. */
+    mutable std::mutex m_output_mutex;
+
+    /** Counters, under m_output_mutex. */
+    Stats m_stats;
+
+    /** Number of workers still running. */
+    std::atomic<uint32_t> m_running;
+
+    /** The workers; destroying them requests their stop and joins them. */
+    std::vector<std::jthread> m_threads;
+
+    /**
+     * @brief Scans the slices until none is left.
+     * @param stopToken Requests the worker to stop after the current slice.
+     * @param term The term or the pattern to look for.
+     * @param caseSensitive Whether comparisons are case-sensitive.
+     * @param regex Whether @p term is a regular expression.
+     */
+    void work(const std::stop_token &stopToken, const std::u16string &term, bool caseSensitive, bool regex);
+
+    /**
+     * @brief Marks a slice as scanned and moves the scanned slices at the head of the order to the output.
+     * @param index The index of the slice.
+     */
+    void release(size_t index);
+
+public:
+    /** @brief Deleted copy constructor. */
+    SearchAllJob(const SearchAllJob &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    SearchAllJob &operator=(const SearchAllJob &) = delete;
+
+    /** @brief Constructs an idle job. */
+    explicit SearchAllJob();
+
+    /** @brief Stops the job, if running, and waits for its threads. */
+    ~SearchAllJob();
+
+    /**
+     * @brief Starts searching buffers, stopping the previous search first.
+     *
+     * Matches are the ones LineScanner::forEachMatch enumerates, so a buffer yields the same
+     * matches as a search run on it alone. The counters and the pending output start over.
+     *
+     * @param cursors The buffers to search; read from the calling thread here, from the workers after.
+     * @param names The name each buffer's entries start with, in the order of @p cursors.
+     * @param term The term or the pattern to look for; a pattern must be valid.
+     * @param caseSensitive Whether comparisons are case-sensitive.
+     * @param regex Whether @p term is a regular expression.
+     * @param maxMatches The number of matches listed per buffer.
+     * @param threadCount The number of workers, at least 1.
+     */
+    void start(std::span<const Cursor *const> cursors, std::span<const std::u16string> names, std::u16string_view term, bool caseSensitive, bool regex, uint32_t maxMatches, uint32_t threadCount);
+
+    /**
+     * @brief Stops the search and waits for its threads, which finish the slice they are on.
+     *
+     * The entries already released can still be taken. No-op when idle.
+     */
+    void cancel();
+
+    /** @return true while the search runs; the entries released until it stops may still be pending. */
+    [[nodiscard]] bool isRunning() const;
+
+    /** @return true when the threads of a search are still held, running or done; cancel releases them. */
+    [[nodiscard]] bool isStarted() const;
+
+    /**
+     * @brief Moves the entries released since the last call to the end of a string.
+     * @param out The string to append to; every entry ends with a newline.
+     * @return true when anything was appended.
+     */
+    bool takeOutput(std::u16string &out);
+
+    /** @return A snapshot of the counters. */
+    [[nodiscard]] Stats getStats() const;
+};
+
+
+#endif //SEARCH_ALL_JOB_H
@@ -0,0 +1,53 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BYTE_SIZE_H
+#define BYTE_SIZE_H
+
+#include <array>
+#include <cstddef>
+#include <format>
+#include <string>
+
+
+/**
+ * @brief Renders a byte count with the largest binary unit keeping it at or above one.
+ *
+ * Bytes print as an integer ("512 B"); the other units keep one decimal ("1.5 KiB", "12.0 MiB").
+ * Units are 1024-based, like the rest of the editor.
+ *
+ * @param bytes The byte count to render.
+ * @return The human-readable size.
+ */
+[[nodiscard]] inline std::string formatByteSize(const std::size_t bytes) {
+    static constexpr auto units = std::array<const char *, 4> { "KiB", "MiB", "GiB", "TiB" };
+    if (bytes < 1024) {
+        return std::format("{} B", bytes);
+    }
+
+    auto value = static_cast<double>(bytes) / 1024.0;
+    auto unit = size_t{0};
+    while (value >= 1024.0 && unit + 1 < units.size()) {
+        value /= 1024.0;
+        ++unit;
+    }
+    return std::format("{:.1f} {}", value, units[unit]);
+}
+
+
+#endif //BYTE_SIZE_H
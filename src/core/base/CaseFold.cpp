@@ -0,0 +1,192 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "CaseFold.h"
+
+#include <algorithm>
+
+
+namespace {
+
+/** The mappings of CaseFolding.txt (Unicode 14.0) of status C and S, within the Basic Multilingual Plane. */
+constexpr auto RULES = std::to_array<CaseFold::Rule>({
+    { 0x0041, 0x005A, 0x0020, 1 }, { 0x00B5, 0x00B5, 0x0307, 1 }, { 0x00C0, 0x00D6, 0x0020, 1 }, { 0x00D8, 0x00DE, 0x0020, 1 },
+    { 0x0100, 0x012E, 0x0001, 2 }, { 0x0132, 0x0136, 0x0001, 2 }, { 0x0139, 0x0147, 0x0001, 2 }, { 0x014A, 0x0176, 0x0001, 2 },
+    { 0x0178, 0x0178, 0xFF87, 1 }, { 0x0179, 0x017D, 0x0001, 2 }, { 0x017F, 0x017F, 0xFEF4, 1 }, { 0x0181, 0x0181, 0x00D2, 1 },
+    { 0x0182, 0x0184, 0x0001, 2 }, { 0x0186, 0x0186, 0x00CE, 1 }, { 0x0187, 0x0187, 0x0001, 1 }, { 0x0189, 0x018A, 0x00CD, 1 },
+    { 0x018B, 0x018B, 0x0001, 1 }, { 0x018E, 0x018E, 0x004F, 1 }, { 0x018F, 0x018F, 0x00CA, 1 }, { 0x0190, 0x0190, 0x00CB, 1 },
+    { 0x0191, 0x0191, 0x0001, 1 }, { 0x0193, 0x0193, 0x00CD, 1 }, { 0x0194, 0x0194, 0x00CF, 1 }, { 0x0196, 0x0196, 0x00D3, 1 },
+    { 0x0197, 0x0197, 0x00D1, 1 }, { 0x0198, 0x0198, 0x0001, 1 }, { 0x019C, 0x019C, 0x00D3, 1 }, { 0x019D, 0x019D, 0x00D5, 1 },
+    { 0x019F, 0x019F, 0x00D6, 1 }, { 0x01A0, 0x01A4, 0x0001, 2 }, { 0x01A6, 0x01A6, 0x00DA, 1 }, { 0x01A7, 0x01A7, 0x0001, 1 },
+    { 0x01A9, 0x01A9, 0x00DA, 1 }, { 0x01AC, 0x01AC, 0x0001, 1 }, { 0x01AE, 0x01AE, 0x00DA, 1 }, { 0x01AF, 0x01AF, 0x0001, 1 },
+    { 0x01B1, 0x01B2, 0x00D9, 1 }, { 0x01B3, 0x01B5, 0x0001, 2 }, { 0x01B7, 0x01B7, 0x00DB, 1 }, { 0x01B8, 0x01B8, 0x0001, 1 },
+    { 0x01BC, 0x01BC, 0x0001, 1 }, { 0x01C4, 0x01C4, 0x0002, 1 }, { 0x01C5, 0x01C5, 0x0001, 1 }, { 0x01C7, 0x01C7, 0x0002, 1 },
+    { 0x01C8, 0x01C8, 0x0001, 1 }, { 0x01CA, 0x01CA, 0x0002, 1 }, { 0x01CB, 0x01DB, 0x0001, 2 }, { 0x01DE, 0x01EE, 0x0001, 2 },
+    { 0x01F1, 0x01F1, 0x0002, 1 }, { 0x01F2, 0x01F4, 0x0001, 2 }, { 0x01F6, 0x01F6, 0xFF9F, 1 }, { 0x01F7, 0x01F7, 0xFFC8, 1 },
+    { 0x01F8, 0x021E, 0x0001, 2 }, { 0x0220, 0x0220, 0xFF7E, 1 }, { 0x0222, 0x0232, 0x0001, 2 }, { 0x023A, 0x023A, 0x2A2B, 1 },
+    { 0x023B, 0x023B, 0x0001, 1 }, { 0x023D, 0x023D, 0xFF5D, 1 }, { 0x023E, 0x023E, 0x2A28, 1 }, { 0x0241, 0x0241, 0x0001, 1 },
+    { 0x0243, 0x0243, 0xFF3D, 1 }, { 0x0244, 0x0244, 0x0045, 1 }, { 0x0245, 0x0245, 0x0047, 1 }, { 0x0246, 0x024E, 0x0001, 2 },
+    { 0x0345, 0x0345, 0x0074, 1 }, { 0x0370, 0x0372, 0x0001, 2 }, { 0x0376, 0x0376, 0x0001, 1 }, { 0x037F, 0x037F, 0x0074, 1 },
+    { 0x0386, 0x0386, 0x0026, 1 }, { 0x0388, 0x038A, 0x0025, 1 }, { 0x038C, 0x038C, 0x0040, 1 }, { 0x038E, 0x038F, 0x003F, 1 },
+    { 0x0391, 0x03A1, 0x0020, 1 }, { 0x03A3, 0x03AB, 0x0020, 1 }, { 0x03C2, 0x03C2, 0x0001, 1 }, { 0x03CF, 0x03CF, 0x0008, 1 },
+    { 0x03D0, 0x03D0, 0xFFE2, 1 }, { 0x03D1, 0x03D1, 0xFFE7, 1 }, { 0x03D5, 0x03D5, 0xFFF1, 1 }, { 0x03D6, 0x03D6, 0xFFEA, 1 },
+    { 0x03D8, 0x03EE, 0x0001, 2 }, { 0x03F0, 0x03F0, 0xFFCA, 1 }, { 0x03F1, 0x03F1, 0xFFD0, 1 }, { 0x03F4, 0x03F4, 0xFFC4, 1 },
+    { 0x03F5, 0x03F5, 0xFFC0, 1 }, { 0x03F7, 0x03F7, 0x0001, 1 }, { 0x03F9, 0x03F9, 0xFFF9, 1 }, { 0x03FA, 0x03FA, 0x0001, 1 },
+    { 0x03FD, 0x03FF, 0xFF7E, 1 }, { 0x0400, 0x040F, 0x0050, 1 }, { 0x0410, 0x042F, 0x0020, 1 }, { 0x0460, 0x0480, 0x0001, 2 },
+    { 0x048A, 0x04BE, 0x0001, 2 }, { 0x04C0, 0x04C0, 0x000F, 1 }, { 0x04C1, 0x04CD, 0x0001, 2 }, { 0x04D0, 0x052E, 0x0001, 2 },
+    { 0x0531, 0x0556, 0x0030, 1 }, { 0x10A0, 0x10C5, 0x1C60, 1 }, { 0x10C7, 0x10C7, 0x1C60, 1 }, { 0x10CD, 0x10CD, 0x1C60, 1 },
+    { 0x13F8, 0x13FD, 0xFFF8, 1 }, { 0x1C80, 0x1C80, 0xE7B2, 1 }, { 0x1C81, 0x1C81, 0xE7B3, 1 }, { 0x1C82, 0x1C82, 0xE7BC, 1 },
+    { 0x1C83, 0x1C84, 0xE7BE, 1 }, { 0x1C85, 0x1C85, 0xE7BD, 1 }, { 0x1C86, 0x1C86, 0xE7C4, 1 }, { 0x1C87, 0x1C87, 0xE7DC, 1 },
+    { 0x1C88, 0x1C88, 0x89C3, 1 }, { 0x1C90, 0x1CBA, 0xF440, 1 }, { 0x1CBD, 0x1CBF, 0xF440, 1 }, { 0x1E00, 0x1E94, 0x0001, 2 },
+    { 0x1E9B, 0x1E9B, 0xFFC6, 1 }, { 0x1E9E, 0x1E9E, 0xE241, 1 }, { 0x1EA0, 0x1EFE, 0x0001, 2 }, { 0x1F08, 0x1F0F, 0xFFF8, 1 },
+    { 0x1F18, 0x1F1D, 0xFFF8, 1 }, { 0x1F28, 0x1F2F, 0xFFF8, 1 }, { 0x1F38, 0x1F3F, 0xFFF8, 1 }, { 0x1F48, 0x1F4D, 0xFFF8, 1 },
+    { 0x1F59, 0x1F5F, 0xFFF8, 2 }, { 0x1F68, 0x1F6F, 0xFFF8, 1 }, { 0x1F88, 0x1F8F, 0xFFF8, 1 }, { 0x1F98, 0x1F9F, 0xFFF8, 1 },
+    { 0x1FA8, 0x1FAF, 0xFFF8, 1 }, { 0x1FB8, 0x1FB9, 0xFFF8, 1 }, { 0x1FBA, 0x1FBB, 0xFFB6, 1 }, { 0x1FBC, 0x1FBC, 0xFFF7, 1 },
+    { 0x1FBE, 0x1FBE, 0xE3FB, 1 }, { 0x1FC8, 0x1FCB, 0xFFAA, 1 }, { 0x1FCC, 0x1FCC, 0xFFF7, 1 }, { 0x1FD8, 0x1FD9, 0xFFF8, 1 },
+    { 0x1FDA, 0x1FDB, 0xFF9C, 1 }, { 0x1FE8, 0x1FE9, 0xFFF8, 1 }, { 0x1FEA, 0x1FEB, 0xFF90, 1 }, { 0x1FEC, 0x1FEC, 0xFFF9, 1 },
+    { 0x1FF8, 0x1FF9, 0xFF80, 1 }, { 0x1FFA, 0x1FFB, 0xFF82, 1 }, { 0x1FFC, 0x1FFC, 0xFFF7, 1 }, { 0x2126, 0x2126, 0xE2A3, 1 },
+    { 0x212A, 0x212A, 0xDF41, 1 }, { 0x212B, 0x212B, 0xDFBA, 1 }, { 0x2132, 0x2132, 0x001C, 1 }, { 0x2160, 0x216F, 0x0010, 1 },
+    { 0x2183, 0x2183, 0x0001, 1 }, { 0x24B6, 0x24CF, 0x001A, 1 }, { 0x2C00, 0x2C2F, 0x0030, 1 }, { 0x2C60, 0x2C60, 0x0001, 1 },
+    { 0x2C62, 0x2C62, 0xD609, 1 }, { 0x2C63, 0x2C63, 0xF11A, 1 }, { 0x2C64, 0x2C64, 0xD619, 1 }, { 0x2C67, 0x2C6B, 0x0001, 2 },
+    { 0x2C6D, 0x2C6D, 0xD5E4, 1 }, { 0x2C6E, 0x2C6E, 0xD603, 1 }, { 0x2C6F, 0x2C6F, 0xD5E1, 1 }, { 0x2C70, 0x2C70, 0xD5E2, 1 },
+    { 0x2C72, 0x2C72, 0x0001, 1 }, { 0x2C75, 0x2C75, 0x0001, 1 }, { 0x2C7E, 0x2C7F, 0xD5C1, 1 }, { 0x2C80, 0x2CE2, 0x0001, 2 },
+    { 0x2CEB, 0x2CED, 0x0001, 2 }, { 0x2CF2, 0x2CF2, 0x0001, 1 }, { 0xA640, 0xA66C, 0x0001, 2 }, { 0xA680, 0xA69A, 0x0001, 2 },
+    { 0xA722, 0xA72E, 0x0001, 2 }, { 0xA732, 0xA76E, 0x0001, 2 }, { 0xA779, 0xA77B, 0x0001, 2 }, { 0xA77D, 0xA77D, 0x75FC, 1 },
+    { 0xA77E, 0xA786, 0x0001, 2 }, { 0xA78B, 0xA78B, 0x0001, 1 }, { 0xA78D, 0xA78D, 0x5AD8, 1 }, { 0xA790, 0xA792, 0x0001, 2 },
+    { 0xA796, 0xA7A8, 0x0001, 2 }, { 0xA7AA, 0xA7AA, 0x5ABC, 1 }, { 0xA7AB, 0xA7AB, 0x5AB1, 1 }, { 0xA7AC, 0xA7AC, 0x5AB5, 1 },
+    { 0xA7AD, 0xA7AD, 0x5ABF, 1 }, { 0xA7AE, 0xA7AE, 0x5ABC, 1 }, { 0xA7B0, 0xA7B0, 0x5AEE, 1 }, { 0xA7B1, 0xA7B1, 0x5AD6, 1 },
+    { 0xA7B2, 0xA7B2, 0x5AEB, 1 }, { 0xA7B3, 0xA7B3, 0x03A0, 1 }, { 0xA7B4, 0xA7C2, 0x0001, 2 }, { 0xA7C4, 0xA7C4, 0xFFD0, 1 },
+    { 0xA7C5, 0xA7C5, 0x5ABD, 1 }, { 0xA7C6, 0xA7C6, 0x75C8, 1 }, { 0xA7C7, 0xA7C9, 0x0001, 2 }, { 0xA7D0, 0xA7D0, 0x0001, 1 },
+    { 0xA7D6, 0xA7D8, 0x0001, 2 }, { 0xA7F5, 0xA7F5, 0x0001, 1 }, { 0xAB70, 0xABBF, 0x6830, 1 }, { 0xFF21, 0xFF3A, 0x0020, 1 },
+});
+
+/** @brief The two stages of the table, and how many distinct blocks the second one holds. */
+struct Table final {
+    std::array<uint8_t, CaseFold::BLOCK_COUNT> blocks;
+    std::array<char16_t, CaseFold::MAX_DISTINCT_BLOCKS * CaseFold::BLOCK_SIZE> offsets;
+    size_t distinct_block_count;
+};
+
+/** @return The table expanded from RULES, each distinct block stored once. */
+consteval Table buildTable() {
+    auto offsets = std::array<char16_t, 0x10000>{};
+    for (const auto &rule : RULES) {
+        for (auto unit = uint32_t{ rule.first }; unit <= rule.last; unit += rule.step) {
+            offsets[unit] = rule.offset;
+        }
+    }
+
+    auto table = Table{ .blocks = {}, .offsets = {}, .distinct_block_count = 0 };
+    for (size_t block = 0; block < CaseFold::BLOCK_COUNT; ++block) {
+        const auto *const units = offsets.data() + block * CaseFold::BLOCK_SIZE;
+
+        auto distinct = size_t{ 0 };
+        for (; distinct < table.distinct_block_count; ++distinct) {
+            const auto *const stored = table.offsets.data() + distinct * CaseFold::BLOCK_SIZE;
+            auto same = true;
+            for (size_t unit = 0; unit < CaseFold::BLOCK_SIZE && same; ++unit) {
+                same = stored[unit] == units[unit];
+            }
+            if (same) {
+                break;
+            }
+        }
+
+        if (distinct == table.distinct_block_count) {
+            // A block never seen before: a failed build here means MAX_DISTINCT_BLOCKS is too small
+            if (distinct == CaseFold::MAX_DISTINCT_BLOCKS) {
+                throw "CaseFold::MAX_DISTINCT_BLOCKS is too small for the rules";
+            }
+            for (size_t unit = 0; unit < CaseFold::BLOCK_SIZE; ++unit) {
+                table.offsets[distinct * CaseFold::BLOCK_SIZE + unit] = units[unit];
+            }
+            ++table.distinct_block_count;
+        }
+        table.blocks[block] = static_cast<uint8_t>(distinct);
+    }
+
+    return table;
+}
+
+constexpr auto TABLE = buildTable();
+
+/** @return The number of code units RULES folds to another unit. */
+consteval size_t countFoldedUnits() {
+    auto count = size_t{ 0 };
+    for (const auto &rule : RULES) {
+        count += (rule.last - rule.first) / rule.step + 1;
+    }
+    return count;
+}
+
+/** @brief A code unit RULES folds to another unit, sorted by that unit. */
+struct Inverse final {
+    char16_t folded; ///< The unit it folds to.
+    char16_t unit;   ///< The code unit.
+
+    constexpr bool operator<(const Inverse &other) const {
+        return folded != other.folded ? folded < other.folded : unit < other.unit;
+    }
+};
+
+/** @return Every code unit RULES folds, sorted by the unit it folds to. */
+consteval std::array<Inverse, countFoldedUnits()> buildInverses() {
+    auto inverses = std::array<Inverse, countFoldedUnits()>{};
+    auto count = size_t{ 0 };
+    for (const auto &rule : RULES) {
+        for (auto unit = uint32_t{ rule.first }; unit <= rule.last; unit += rule.step) {
+            inverses[count++] = { static_cast<char16_t>(unit + rule.offset), static_cast<char16_t>(unit) };
+        }
+    }
+    std::sort(inverses.begin(), inverses.end());
+
+    // The unit itself takes a slot of its Cases
+    for (size_t start = 0, end = 0; start < inverses.size(); start = end) {
+        while (end < inverses.size() && inverses[end].folded == inverses[start].folded) {
+            ++end;
+        }
+        if (end - start >= CaseFold::MAX_CASES) {
+            throw "CaseFold::MAX_CASES is too small for the rules";
+        }
+    }
+    return inverses;
+}
+
+constexpr auto INVERSES = buildInverses();
+
+}
+
+
+const std::array<uint8_t, CaseFold::BLOCK_COUNT> CaseFold::BLOCKS = TABLE.blocks;
+
+const std::array<char16_t, CaseFold::MAX_DISTINCT_BLOCKS * CaseFold::BLOCK_SIZE> CaseFold::OFFSETS = TABLE.offsets;
+
+CaseFold::Cases CaseFold::getCases(const char16_t folded) {
+    auto cases = Cases{};
+    cases.fill(folded);
+
+    const auto [begin, end] = std::equal_range(INVERSES.begin(), INVERSES.end(), Inverse{ folded, 0 }, [](const Inverse &left, const Inverse &right) {
+        return left.folded < right.folded;
+    });
+    std::transform(begin, end, cases.begin() + 1, [](const Inverse &inverse) { return inverse.unit; });
+    return cases;
+}
+
+std::span<const CaseFold::Rule> CaseFold::getRules() {
+    return RULES;
+}
@@ -0,0 +1,111 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CASE_FOLD_H
+#define CASE_FOLD_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+/**
+ * @brief Static-only simple Unicode case folding of UTF-16 code units.
+ *
+ * Folds the way the CaseFolding.txt mappings of status C and S do, for the Basic Multilingual
+ * Plane: one code unit to one code unit, so a folded text keeps the columns of the original.
+ * Characters outside it, written as surrogate pairs, are left alone.
+ *
+ * The mappings are kept as a short list of rules, and the compiler expands them into a two-stage
+ * table at build time: the high bits of a code unit pick a block, shared by every run of code
+ * units folding alike, and the low bits pick the offset to add within it.
+ */
+class CaseFold final {
+public:
+    /** @brief A run of code points folding by the same offset, every code point or every other one. */
+    struct Rule final {
+        char16_t first;  ///< First code point of the run.
+        char16_t last;   ///< Last code point of the run.
+        char16_t offset; ///< Offset to add to fold, modulo 0x10000.
+        uint8_t step;    ///< 1 when every code point of the run folds, 2 when every other one does.
+    };
+
+    /** Number of low bits of a code unit that index into its block. */
+    static constexpr uint32_t BLOCK_SHIFT = 6;
+
+    /** Number of code units per block. */
+    static constexpr uint32_t BLOCK_SIZE = 1u << BLOCK_SHIFT;
+
+    /** Number of entries of the first stage, one per block of code units. */
+    static constexpr size_t BLOCK_COUNT = 0x10000 >> BLOCK_SHIFT;
+
+    /** Number of distinct blocks the second stage has room for. */
+    static constexpr size_t MAX_DISTINCT_BLOCKS = 64;
+
+    /** Largest number of code units folding to the same unit, that unit included. */
+    static constexpr size_t MAX_CASES = 4;
+
+    /** @brief The code units folding to one unit, that unit first; the slots left over repeat it. */
+    using Cases = std::array<char16_t, MAX_CASES>;
+
+private:
+    /** First stage: the distinct block each block of code units folds with. */
+    static const std::array<uint8_t, BLOCK_COUNT> BLOCKS;
+
+    /** Second stage: the offsets of the distinct blocks, back to back. */
+    static const std::array<char16_t, MAX_DISTINCT_BLOCKS * BLOCK_SIZE> OFFSETS;
+
+public:
+    /** @brief Deleted constructor; this class is static-only. */
+    CaseFold() = delete;
+
+    /**
+     * @brief Lower-cases an ASCII letter, leaving other code units untouched.
+     * @param unit The code unit to fold.
+     * @return The lower-cased code unit.
+     */
+    [[nodiscard]] static constexpr char16_t foldAscii(const char16_t unit) {
+        return unit >= u'A' && unit <= u'Z' ? static_cast<char16_t>(unit - u'A' + u'a') : unit;
+    }
+
+    /**
+     * @brief Folds a code unit.
+     * @param unit The code unit to fold.
+     * @return The folded code unit; the unit itself when it has no folding.
+     */
+    [[nodiscard]] static char16_t fold(const char16_t unit) {
+        if (unit < 0x80) {
+            return foldAscii(unit);
+        }
+        return static_cast<char16_t>(unit + OFFSETS[BLOCKS[unit >> BLOCK_SHIFT] * BLOCK_SIZE + (unit & (BLOCK_SIZE - 1))]);
+    }
+
+    /**
+     * @brief Lists the code units folding to a unit, such as K, k and the Kelvin sign for k.
+     * @param folded The unit, as fold returns it.
+     * @return The units folding to @p folded.
+     */
+    [[nodiscard]] static Cases getCases(char16_t folded);
+
+    /** @return The rules the table is built from, in code point order; a code point in none folds to itself. */
+    [[nodiscard]] static std::span<const Rule> getRules();
+};
+
+
+#endif //CASE_FOLD_H
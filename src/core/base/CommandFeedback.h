@@ -35,7 +35,8 @@
  *
  * Used when a command requires user confirmation or additional input after initial execution
  * (e.g., "Are you sure? [y/n]"). This structure holds the prompt message, the command string
- * to run next, an optional completion provider, and a callback to handle the user's input.
+ * to run next, an optional completion provider, a callback to handle the user's input, and an
+ * optional callback following the input as it is typed (the search previews its term with it).
  *
  * Every instance carries a distinct id, so a feedback replacing another one can be told apart from
  * the one it replaced. Copies keep the id of the instance they were made from.
@@ -49,6 +50,7 @@ struct CommandFeedback final {
     std::u16string command_string;                  ///< Command associated with the feedback.
     std::function<void(std::u16string_view input, const AutoCompleteCallback &itemCallback)> on_complete_callback; ///< Optional provider computing completions from the current input.
     FeedbackCallback on_validate_callback;          ///< Callback to run after receiving user input.
+    std::function<void(std::u16string_view input)> on_input_callback; ///< Optional callback run whenever the input changes, before it is validated.
 };
 
 
@@ -92,7 +94,8 @@ struct CommandFeedback final {
         .on_validate_callback = [&runner](const std::u16string_view input, const std::u16string_view command) -> std::optional<std::u16string> {
             runner.runCommand(std::u16string(command).append(u" ").append(input), true);
             return std::nullopt;
-        }
+        },
+        .on_input_callback = {}
     };
 }
 
@@ -114,7 +117,8 @@ struct CommandFeedback final {
         .on_validate_callback = [&runner](const std::u16string_view input, const std::u16string_view command) -> std::optional<std::u16string> {
             runner.runCommand(std::u16string(command).append(u" ").append(quoteArgument(input)), true);
             return std::nullopt;
-        }
+        },
+        .on_input_callback = {}
     };
 }
 
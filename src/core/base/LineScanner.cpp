@@ -22,48 +22,82 @@ LineScanner::LineScanner(const std::u16string_view term, const bool caseSensitiv
     : m_term(term),
       m_case_sensitive(caseSensitive) {
     if (!m_case_sensitive) {
-        // Fold the term once, instead of folding both sides at every candidate position.
+        // Fold the term once; the search folds the text inside its comparison.
         for (auto &character : m_term) {
-            character = toLowerAscii(character);
+            character = CaseFold::fold(character);
         }
     }
 }
 
+LineScanner::LineScanner(std::shared_ptr<Regex> regex)
+    : m_case_sensitive(regex->isCaseSensitive()),
+      m_regex(std::move(regex)) {}
+
 void LineScanner::setLine(const std::u16string_view line) {
-    if (m_case_sensitive) {
-        m_line = line;
-        return;
-    }
+    m_line = line;
+}
 
-    // Fold the line once into the scratch; every lookup on it then runs on the folded copy.
-    m_folded_line.assign(line);
-    for (auto &character : m_folded_line) {
-        character = toLowerAscii(character);
+size_t LineScanner::indexOf(const size_t from) const {
+    if (m_regex) {
+        const auto match = m_regex->find(m_line, from);
+        m_match_length = match ? match->end - match->start : 0;
+        return match ? match->start : std::u16string_view::npos;
     }
 
-    m_line = m_folded_line;
+    // The term is folded and the search folds the line, so find carries the same semantics as the
+    // per-position comparison: in particular an empty term matches at from whenever it fits within the line.
+    m_match_length = m_term.length();
+    return SubstringSearch::find(m_line, m_term, from, !m_case_sensitive);
 }
 
-size_t LineScanner::indexOf(const size_t from) const {
-    // Both sides are folded, so find carries the same semantics as the per-position comparison:
-    // in particular an empty term matches at from whenever it fits within the line.
-    return m_line.find(m_term, from);
+size_t LineScanner::lastIndexOf(const size_t limit) const {
+    if (m_regex) {
+        const auto match = m_regex->findLast(m_line, limit);
+        m_match_length = match ? match->end - match->start : 0;
+        return match ? match->start : std::u16string_view::npos;
+    }
+
+    m_match_length = m_term.length();
+    return SubstringSearch::findLast(m_line, m_term, limit, !m_case_sensitive);
 }
 
-size_t LineScanner::lastIndexOf(const size_t limit) const {
-    if (limit == 0) {
-        return std::u16string_view::npos;
+bool LineScanner::isMatchAt(const size_t column, const size_t offset) const {
+    if (column > m_line.length() || m_term.length() > m_line.length() - column) {
+        return false;
+    }
+
+    for (auto index = offset; index < m_term.length(); ++index) {
+        const auto character = m_line[column + index];
+        if ((m_case_sensitive ? character : CaseFold::fold(character)) != m_term[index]) {
+            return false;
+        }
     }
 
-    // rfind returns the greatest start position <= limit - 1, i.e. strictly before the limit.
-    return m_line.rfind(m_term, limit - 1);
+    m_match_length = m_term.length();
+    return true;
 }
 
 size_t LineScanner::termLength() const {
     return m_term.length();
 }
 
+size_t LineScanner::matchLength() const {
+    return m_match_length;
+}
+
+size_t LineScanner::nextFrom(const size_t position) const {
+    return position + std::max<size_t>(m_match_length, 1);
+}
+
+const std::shared_ptr<Regex> &LineScanner::getRegex() const {
+    return m_regex;
+}
+
 bool LineScanner::isSelfOverlapping() const {
+    if (m_regex) {
+        return true;
+    }
+
     // A shift that leaves the term matching itself is exactly an overlap of two occurrences.
     const auto term = std::u16string_view { m_term };
     for (size_t shift = 1; shift < term.length(); ++shift) {
@@ -74,11 +108,3 @@ bool LineScanner::isSelfOverlapping() const {
 
     return false;
 }
-
-char16_t LineScanner::toLowerAscii(const char16_t character) {
-    if (character >= u'A' && character <= u'Z') {
-        return static_cast<char16_t>(character - u'A' + u'a');
-    }
-
-    return character;
-}
@@ -19,41 +19,47 @@
 #ifndef LINE_SCANNER_H
 #define LINE_SCANNER_H
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 
+#include "Regex.h"
+#include "CaseFold.h"
+#include "SubstringSearch.h"
+
 
 /**
- * @brief Scans buffer lines for one term, folding case once per term and once per line.
+ * @brief Scans buffer lines for one term, folding its case once per term.
+ *
+ * The case-insensitive comparison is the simple Unicode fold of CaseFold: the term is folded
+ * once, and the text inside the comparison, so no line is ever copied. Lookups run on
+ * the vector kernels of SubstringSearch, either on one line at a time (setLine, indexOf,
+ * lastIndexOf) or on whole runs of lines stored back to back (forEachMatch).
  *
- * The case-insensitive comparison is the ASCII-only fold of toLowerAscii, applied to both sides
- * exactly as the per-position comparison it replaces did; matching then runs on the folded copies,
- * so a single find/rfind replaces the hand-rolled quadratic scan.
+ * A scanner can also run a Regex instead of a literal term. Its matches vary in length, which
+ * matchLength() reports after each lookup, and its literal prefix, when it has one, is what the
+ * vector kernels look for before the DFA checks each candidate. The compiled Regex is shared by
+ * the copies of a scanner, so they also share its DFA cache, and a scanner belongs to one thread.
  */
 class LineScanner final {
 private:
-    /** The term to look for, ASCII-folded when the comparison is case-insensitive. */
+    /** The term to look for, folded when the comparison is case-insensitive. */
     std::u16string m_term;
 
-    /** Scratch holding the folded copy of the current line; unused when the comparison is case-sensitive. */
-    std::u16string m_folded_line;
-
-    /** The line being scanned: the caller's view, or a view over m_folded_line. */
+    /** The line being scanned, as given by the caller. */
     std::u16string_view m_line;
 
     /** true when the comparison is case-sensitive and no folding happens. */
     const bool m_case_sensitive;
 
-    /**
-     * @brief Lower-cases an ASCII letter, leaving other code units untouched.
-     *
-     * Only A-Z are folded; this is the deliberate ASCII-only limitation of the v1 case-insensitive matching.
-     *
-     * @param character The code unit to fold.
-     * @return The lower-cased code unit.
-     */
-    [[nodiscard]] static char16_t toLowerAscii(char16_t character);
+    /** The compiled pattern of a regex scanner; null for a literal one. */
+    std::shared_ptr<Regex> m_regex;
+
+    /** Length of the match the last lookup found; a lookup is const, this is its by-product. */
+    mutable size_t m_match_length = 0;
 
 public:
     /**
@@ -64,7 +70,13 @@ public:
     explicit LineScanner(std::u16string_view term, bool caseSensitive);
 
     /**
-     * @brief Sets the line the next lookups run on, folding it once when needed.
+     * @brief Builds a scanner running a regular expression.
+     * @param regex The compiled pattern; must be valid.
+     */
+    explicit LineScanner(std::shared_ptr<Regex> regex);
+
+    /**
+     * @brief Sets the line the next lookups run on.
      *
      * The scanner keeps a view into the line, not a copy, so the line must outlive the lookups run on it.
      *
@@ -86,19 +98,157 @@ public:
      */
     [[nodiscard]] size_t lastIndexOf(size_t limit) const;
 
-    /** @return The term length in code units. */
+    /**
+     * @brief Tells whether the term occurs at a column of the current line, comparing from an offset into it.
+     *
+     * A caller knowing that the first units of the term match there, because a shorter term they
+     * spell was found at that column, passes their count so only the rest is compared. Literal
+     * scanners only.
+     *
+     * @param column The column the occurrence would start at.
+     * @param offset The number of leading units of the term known to match.
+     * @return true when the term occurs at @p column.
+     */
+    [[nodiscard]] bool isMatchAt(size_t column, size_t offset) const;
+
+    /** @return The term length in code units; 0 for a regex scanner. */
     [[nodiscard]] size_t termLength() const;
 
+    /** @return The length of the match found by the last successful indexOf or lastIndexOf, in code units. */
+    [[nodiscard]] size_t matchLength() const;
+
+    /**
+     * @brief Returns where a non-overlapping enumeration resumes after the match last found.
+     * @param position The column of that match.
+     * @return The column past its end, or one past @p position for an empty match.
+     */
+    [[nodiscard]] size_t nextFrom(size_t position) const;
+
+    /** @return The compiled pattern of a regex scanner, or null for a literal one. */
+    [[nodiscard]] const std::shared_ptr<Regex> &getRegex() const;
+
     /**
      * @brief Tells whether the term can overlap itself, i.e. a proper prefix of it is also a suffix.
      *
      * scanMatches enumerates non-overlapping occurrences, so a term that cannot overlap itself has
-     * every one of its occurrences in that enumeration. Backward stepping relies on it.
+     * every one of its occurrences in that enumeration. Backward stepping relies on it. A regex is
+     * assumed to overlap itself.
      *
      * @return true when two occurrences of the term can overlap.
      */
     [[nodiscard]] bool isSelfOverlapping() const;
+
+    /**
+     * @brief Visits every non-overlapping occurrence of the term from a position to the end of the text.
+     *
+     * Lines stored back to back are scanned as one block, one kernel call per match instead of one
+     * per line, so match-free stretches cost no per-line work at all. A candidate running over the
+     * end of its line is discarded. Occurrences are the ones indexOf enumerates line by line,
+     * resuming past each match; an empty term falls back to that line-by-line enumeration. A regex
+     * with a literal prefix runs the same block scan on its prefix and checks each candidate with
+     * the DFA; one without a prefix is run line by line. Inside the visitor, matchLength() is the
+     * length of the occurrence visited.
+     *
+     * @tparam TLines Text source offering getLineCount(), getString(line) and getContiguousLineCount(line), such as Cursor.
+     * @tparam TVisitor Callable taking the line and the column of a match, returning false to stop.
+     * @param lines The text to scan.
+     * @param startLine The line to start scanning from.
+     * @param startColumn The column to start scanning from on the first line.
+     * @param visit Called once per occurrence, in text order.
+     */
+    template<typename TLines, typename TVisitor>
+    void forEachMatch(const TLines &lines, uint32_t startLine, size_t startColumn, TVisitor &&visit) const;
 };
 
+template<typename TLines, typename TVisitor>
+void LineScanner::forEachMatch(const TLines &lines, const uint32_t startLine, size_t startColumn, TVisitor &&visit) const {
+    const auto line_count = lines.getLineCount();
+    const auto needle = std::u16string_view(m_regex ? m_regex->getPrefix() : m_term);
+    const auto needle_length = needle.length();
+
+    if (m_regex && needle_length == 0) {
+        // Nothing to look for ahead of the DFA, which runs on each line
+        for (auto line = startLine; line < line_count; ++line) {
+            const auto text = lines.getString(line);
+            auto from = line == startLine ? startColumn : 0;
+            while (const auto match = m_regex->find(text, from)) {
+                m_match_length = match->end - match->start;
+                if (!visit(line, static_cast<uint32_t>(match->start))) {
+                    return;
+                }
+                from = match->end > match->start ? match->end : match->start + 1;
+            }
+        }
+        return;
+    }
+
+    if (needle_length == 0) {
+        // Block offsets cannot tell which of two touching lines an empty match belongs to
+        m_match_length = 0;
+        for (auto line = startLine; line < line_count; ++line) {
+            const auto text = lines.getString(line);
+            for (auto from = line == startLine ? startColumn : 0; from <= text.length(); ++from) {
+                if (!visit(line, static_cast<uint32_t>(from))) {
+                    return;
+                }
+            }
+        }
+        return;
+    }
+
+    for (auto run_start = startLine; run_start < line_count;) {
+        const auto run_end = run_start + lines.getContiguousLineCount(run_start);
+        const auto first = lines.getString(run_start);
+        const auto last = lines.getString(run_end - 1);
+        const auto block = std::u16string_view(first.data(), last.data() + last.length());
+
+        // A column past the end of the first line has no match on it, and must not reach the next one
+        auto from = std::min(startColumn, first.length());
+        startColumn = 0;
+
+        auto line = run_start;
+        auto line_start = size_t{ 0 };
+        auto line_end = first.length();
+        while (true) {
+            const auto position = SubstringSearch::find(block, needle, from, !m_case_sensitive);
+            if (position == std::u16string_view::npos) {
+                break;
+            }
+
+            // Walk to the line holding the candidate; lines of a run are in order, so this never goes back
+            while (position >= line_end) {
+                const auto text = lines.getString(++line);
+                line_start = static_cast<size_t>(text.data() - block.data());
+                line_end = line_start + text.length();
+            }
+
+            if (position + needle_length > line_end) {
+                // Straddles the end of its line: not a match, but the next position may be
+                from = position + 1;
+                continue;
+            }
+
+            auto match_end = position + needle_length;
+            if (m_regex) {
+                // The prefix only makes a candidate; the DFA decides from there, within the line
+                const auto end = m_regex->matchAt(block.substr(line_start, line_end - line_start), position - line_start);
+                if (!end) {
+                    from = position + 1;
+                    continue;
+                }
+                match_end = line_start + *end;
+            }
+
+            m_match_length = match_end - position;
+            if (!visit(line, static_cast<uint32_t>(position - line_start))) {
+                return;
+            }
+            from = match_end;
+        }
+
+        run_start = run_end;
+    }
+}
+
 
 #endif //LINE_SCANNER_H
@@ -0,0 +1,55 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef NUMBER_TEXT_H
+#define NUMBER_TEXT_H
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <string>
+
+
+/**
+ * @brief Appends an unsigned value to a UTF-16 string as decimal digits.
+ *
+ * The digits go through a stack buffer: building a status line or a listing entry allocates
+ * nothing beyond the growth of @p text.
+ *
+ * @param text The string to append to.
+ * @param value The value to render.
+ */
+inline void appendNumber(std::u16string &text, const uint64_t value) {
+    auto digits = std::array<char, 20>{};
+    const auto end = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+    text.append(digits.data(), end);
+}
+
+/**
+ * @brief Renders an unsigned value as UTF-16 decimal digits.
+ * @param value The value to render.
+ * @return The decimal representation.
+ */
+[[nodiscard]] inline std::u16string formatNumber(const uint64_t value) {
+    auto text = std::u16string{};
+    appendNumber(text, value);
+    return text;
+}
+
+
+#endif //NUMBER_TEXT_H
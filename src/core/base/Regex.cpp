@@ -0,0 +1,1297 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Regex.h"
+
+#include <algorithm>
+
+#include "CaseFold.h"
+#include "SubstringSearch.h"
+
+
+namespace {
+
+/** Repetition bound meaning "no upper bound". */
+constexpr uint32_t UNBOUNDED = UINT32_MAX;
+
+/** Deepest group nesting a pattern may use, which bounds the recursion of the parser and the compiler. */
+constexpr uint32_t MAX_NESTING = 256;
+
+using Ranges = std::vector<std::pair<char16_t, char16_t>>;
+
+/** @brief A node of the parsed pattern. */
+struct Node final {
+    /** @brief What a node stands for. */
+    enum class Kind : uint8_t {
+        Empty,      ///< Matches the empty string.
+        Set,        ///< One code unit of ranges.
+        Concat,     ///< The children in sequence.
+        Alternate,  ///< One of the children, the first preferred.
+        Repeat,     ///< The single child, min to max times.
+        Group,      ///< The single child, captured when group >= 0.
+        LineStart,  ///< Column 0.
+        LineEnd     ///< The end of the line.
+    };
+
+    Kind kind = Kind::Empty;     ///< What the node stands for.
+    Ranges ranges;               ///< Code units of a Set.
+    std::vector<Node> children;  ///< Operands of Concat, Alternate, Repeat and Group.
+    uint32_t min = 0;            ///< Lower bound of a Repeat.
+    uint32_t max = 0;            ///< Upper bound of a Repeat, or UNBOUNDED.
+    bool greedy = true;          ///< Whether a Repeat prefers more iterations.
+    int32_t group = -1;          ///< Capture index of a Group, 1-based, or -1.
+};
+
+/** @return An empty node of the given kind. */
+Node makeNode(const Node::Kind kind) {
+    auto node = Node{};
+    node.kind = kind;
+    return node;
+}
+
+/** @return A Set node of the given ranges, taken as they are. */
+Node makeRangesNode(Ranges ranges) {
+    auto node = makeNode(Node::Kind::Set);
+    node.ranges = std::move(ranges);
+    return node;
+}
+
+/** @brief Sorts and merges ranges in place. */
+void normalize(Ranges &ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    auto merged = Ranges{};
+    for (const auto &range : ranges) {
+        if (!merged.empty() && static_cast<uint32_t>(range.first) <= static_cast<uint32_t>(merged.back().second) + 1) {
+            merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    ranges = std::move(merged);
+}
+
+/** @brief Replaces normalized ranges by every code unit they leave out. */
+void complement(Ranges &ranges) {
+    auto result = Ranges{};
+    auto next = uint32_t{0};
+    for (const auto &[low, high] : ranges) {
+        if (low > next) {
+            result.emplace_back(static_cast<char16_t>(next), static_cast<char16_t>(low - 1));
+        }
+        next = static_cast<uint32_t>(high) + 1;
+    }
+    if (next <= 0xFFFF) {
+        result.emplace_back(static_cast<char16_t>(next), u'\xFFFF');
+    }
+    ranges = std::move(result);
+}
+
+/** @return true when normalized ranges hold a code unit. */
+bool holds(const Ranges &ranges, const char16_t unit) {
+    const auto after = std::upper_bound(ranges.begin(), ranges.end(), unit, [](const char16_t value, const auto &range) {
+        return value < range.first;
+    });
+    return after != ranges.begin() && unit <= std::prev(after)->second;
+}
+
+/** @brief Adds every code unit folding like a code unit of normalized ranges, then normalizes them. */
+void addOtherCase(Ranges &ranges) {
+    // Collect the folds of the members first, then add every code unit folding to one of them
+    auto folds = Ranges{};
+    for (const auto &rule : CaseFold::getRules()) {
+        for (auto unit = uint32_t{ rule.first }; unit <= rule.last; unit += rule.step) {
+            const auto folded = CaseFold::fold(static_cast<char16_t>(unit));
+            if (holds(ranges, static_cast<char16_t>(unit)) || holds(ranges, folded)) {
+                folds.emplace_back(folded, folded);
+            }
+        }
+    }
+    normalize(folds);
+
+    for (const auto &rule : CaseFold::getRules()) {
+        for (auto unit = uint32_t{ rule.first }; unit <= rule.last; unit += rule.step) {
+            if (holds(folds, CaseFold::fold(static_cast<char16_t>(unit)))) {
+                ranges.emplace_back(static_cast<char16_t>(unit), static_cast<char16_t>(unit));
+            }
+        }
+    }
+    ranges.insert(ranges.end(), folds.begin(), folds.end());
+    normalize(ranges);
+}
+
+/** @brief Recursive-descent parser of the pattern syntax. */
+class Parser final {
+private:
+    std::u16string_view m_pattern;
+    bool m_case_sensitive;
+    size_t m_position = 0;
+    uint32_t m_depth = 0;
+    uint32_t m_group_count = 0;
+    std::u16string m_error;
+
+    [[nodiscard]] bool atEnd() const {
+        return m_position >= m_pattern.length();
+    }
+
+    [[nodiscard]] char16_t peek() const {
+        return m_pattern[m_position];
+    }
+
+    bool fail(const std::u16string_view message) {
+        if (m_error.empty()) {
+            m_error = message;
+        }
+        return false;
+    }
+
+    /** @return A Set node of the given ranges, folded when the comparison is case-insensitive. */
+    [[nodiscard]] Node makeSet(Ranges ranges) const {
+        normalize(ranges);
+        if (!m_case_sensitive) {
+            addOtherCase(ranges);
+        }
+        return makeRangesNode(std::move(ranges));
+    }
+
+    /** @brief Reads exactly @p digits hexadecimal digits. */
+    bool parseHex(const uint32_t digits, char16_t &value) {
+        auto result = uint32_t{0};
+        for (uint32_t index = 0; index < digits; ++index) {
+            if (atEnd()) {
+                return fail(u"truncated hexadecimal escape");
+            }
+            const auto character = m_pattern[m_position++];
+            auto digit = uint32_t{0};
+            if (character >= u'0' && character <= u'9') {
+                digit = character - u'0';
+            } else if (character >= u'a' && character <= u'f') {
+                digit = character - u'a' + 10;
+            } else if (character >= u'A' && character <= u'F') {
+                digit = character - u'A' + 10;
+            } else {
+                return fail(u"invalid hexadecimal escape");
+            }
+            result = result * 16 + digit;
+        }
+        value = static_cast<char16_t>(result);
+        return true;
+    }
+
+    /**
+     * @brief Parses the escape following a backslash, which was consumed.
+     * @param ranges Receives the code units the escape stands for.
+     * @return false on a syntax error.
+     */
+    bool parseEscape(Ranges &ranges) {
+        if (atEnd()) {
+            return fail(u"trailing backslash");
+        }
+
+        const auto character = m_pattern[m_position++];
+        auto negated = false;
+        switch (character) {
+            case u'D':
+                negated = true;
+                [[fallthrough]];
+            case u'd':
+                ranges = { { u'0', u'9' } };
+                break;
+            case u'W':
+                negated = true;
+                [[fallthrough]];
+            case u'w':
+                ranges = { { u'0', u'9' }, { u'A', u'Z' }, { u'_', u'_' }, { u'a', u'z' } };
+                break;
+            case u'S':
+                negated = true;
+                [[fallthrough]];
+            case u's':
+                ranges = { { u'\t', u'\r' }, { u' ', u' ' } };
+                break;
+            case u't':
+                ranges = { { u'\t', u'\t' } };
+                break;
+            case u'n':
+                ranges = { { u'\n', u'\n' } };
+                break;
+            case u'r':
+                ranges = { { u'\r', u'\r' } };
+                break;
+            case u'f':
+                ranges = { { u'\f', u'\f' } };
+                break;
+            case u'v':
+                ranges = { { u'\v', u'\v' } };
+                break;
+            case u'x':
+            case u'u': {
+                auto value = char16_t{0};
+                if (!parseHex(character == u'x' ? 2 : 4, value)) {
+                    return false;
+                }
+                ranges = { { value, value } };
+                break;
+            }
+            default:
+                if ((character >= u'0' && character <= u'9') || (character >= u'A' && character <= u'Z') || (character >= u'a' && character <= u'z')) {
+                    return fail(std::u16string(u"unknown escape \\").append(1, character));
+                }
+                ranges = { { character, character } };
+                break;
+        }
+
+        normalize(ranges);
+        if (negated) {
+            complement(ranges);
+        }
+        return true;
+    }
+
+    /** @brief Parses a bracketed class; the opening bracket was consumed. */
+    bool parseClass(Node &node) {
+        auto negated = false;
+        if (!atEnd() && peek() == u'^') {
+            negated = true;
+            ++m_position;
+        }
+
+        auto ranges = Ranges{};
+        auto first = true;
+        while (true) {
+            if (atEnd()) {
+                return fail(u"unterminated [");
+            }
+            if (peek() == u']' && !first) {
+                ++m_position;
+                break;
+            }
+            first = false;
+
+            // One member: a code unit, possibly starting a range, or an escape
+            auto low = m_pattern[m_position++];
+            if (low == u'\\') {
+                auto escaped = Ranges{};
+                if (!parseEscape(escaped)) {
+                    return false;
+                }
+                if (escaped.size() != 1 || escaped[0].first != escaped[0].second) {
+                    // A shorthand class such as \d never starts a range
+                    ranges.insert(ranges.end(), escaped.begin(), escaped.end());
+                    continue;
+                }
+                low = escaped[0].first;
+            }
+
+            auto high = low;
+            if (m_position + 1 < m_pattern.length() && peek() == u'-' && m_pattern[m_position + 1] != u']') {
+                ++m_position;
+                high = m_pattern[m_position++];
+                if (high == u'\\') {
+                    auto escaped = Ranges{};
+                    if (!parseEscape(escaped)) {
+                        return false;
+                    }
+                    if (escaped.size() != 1 || escaped[0].first != escaped[0].second) {
+                        return fail(u"invalid range in []");
+                    }
+                    high = escaped[0].first;
+                }
+                if (high < low) {
+                    return fail(u"invalid range in []");
+                }
+            }
+            ranges.emplace_back(low, high);
+        }
+
+        normalize(ranges);
+        if (negated) {
+            // Fold before complementing, so [^a] excludes A as well when the case is ignored
+            if (!m_case_sensitive) {
+                addOtherCase(ranges);
+            }
+            complement(ranges);
+            node = makeRangesNode(std::move(ranges));
+            return true;
+        }
+        node = makeSet(std::move(ranges));
+        return true;
+    }
+
+    /** @brief Reads a decimal number for a counted repetition. */
+    bool parseNumber(uint32_t &value) {
+        const auto start = m_position;
+        auto result = uint64_t{0};
+        while (!atEnd() && peek() >= u'0' && peek() <= u'9') {
+            result = std::min<uint64_t>(result * 10 + (peek() - u'0'), UINT32_MAX);
+            ++m_position;
+        }
+        value = static_cast<uint32_t>(result);
+        return m_position > start;
+    }
+
+    /**
+     * @brief Parses a counted repetition {n}, {n,} or {n,m}, the brace being next.
+     *
+     * A brace not opening a valid repetition is a literal brace, and nothing is consumed.
+     *
+     * @return true when a repetition was read.
+     */
+    bool parseCount(uint32_t &min, uint32_t &max) {
+        const auto start = m_position;
+        ++m_position;
+        if (!parseNumber(min)) {
+            m_position = start;
+            return false;
+        }
+        max = min;
+        if (!atEnd() && peek() == u',') {
+            ++m_position;
+            if (!parseNumber(max)) {
+                max = UNBOUNDED;
+            }
+        }
+        if (atEnd() || peek() != u'}') {
+            m_position = start;
+            return false;
+        }
+        ++m_position;
+        return true;
+    }
+
+    bool parseAtom(Node &node) {
+        const auto character = m_pattern[m_position++];
+        switch (character) {
+            case u'(': {
+                if (++m_depth > MAX_NESTING) {
+                    return fail(u"pattern nested too deeply");
+                }
+                auto group = -1;
+                if (m_pattern.substr(m_position).starts_with(u"?:")) {
+                    m_position += 2;
+                } else {
+                    group = static_cast<int32_t>(++m_group_count);
+                }
+
+                auto child = Node{};
+                if (!parseAlternation(child)) {
+                    return false;
+                }
+                if (atEnd() || peek() != u')') {
+                    return fail(u"missing )");
+                }
+                ++m_position;
+                --m_depth;
+                node = makeNode(Node::Kind::Group);
+                node.group = group;
+                node.children.push_back(std::move(child));
+                return true;
+            }
+            case u'[':
+                return parseClass(node);
+            case u'.':
+                node = makeRangesNode({ { u'\0', u'\xFFFF' } });
+                return true;
+            case u'^':
+                node = makeNode(Node::Kind::LineStart);
+                return true;
+            case u'$':
+                node = makeNode(Node::Kind::LineEnd);
+                return true;
+            case u'\\': {
+                auto ranges = Ranges{};
+                if (!parseEscape(ranges)) {
+                    return false;
+                }
+                node = makeSet(std::move(ranges));
+                return true;
+            }
+            case u'*':
+            case u'+':
+            case u'?':
+                return fail(u"nothing to repeat");
+            case u')':
+                return fail(u"unmatched )");
+            default:
+                node = makeSet({ { character, character } });
+                return true;
+        }
+    }
+
+    bool parseRepeat(Node &node) {
+        if (!parseAtom(node)) {
+            return false;
+        }
+
+        while (!atEnd()) {
+            auto min = uint32_t{0};
+            auto max = uint32_t{0};
+            const auto character = peek();
+            if (character == u'*') {
+                min = 0;
+                max = UNBOUNDED;
+                ++m_position;
+            } else if (character == u'+') {
+                min = 1;
+                max = UNBOUNDED;
+                ++m_position;
+            } else if (character == u'?') {
+                min = 0;
+                max = 1;
+                ++m_position;
+            } else if (character != u'{' || !parseCount(min, max)) {
+                return true;
+            }
+
+            if (node.kind == Node::Kind::LineStart || node.kind == Node::Kind::LineEnd || node.kind == Node::Kind::Repeat) {
+                return fail(u"nothing to repeat");
+            }
+            if ((max != UNBOUNDED && max > Regex::MAX_REPEAT) || min > Regex::MAX_REPEAT) {
+                return fail(u"repetition count too large");
+            }
+            if (max < min) {
+                return fail(u"invalid repetition count");
+            }
+
+            auto greedy = true;
+            if (!atEnd() && peek() == u'?') {
+                greedy = false;
+                ++m_position;
+            }
+
+            auto repeat = makeNode(Node::Kind::Repeat);
+            repeat.min = min;
+            repeat.max = max;
+            repeat.greedy = greedy;
+            repeat.children.push_back(std::move(node));
+            node = std::move(repeat);
+        }
+        return true;
+    }
+
+    bool parseConcat(Node &node) {
+        node = makeNode(Node::Kind::Concat);
+        while (!atEnd() && peek() != u'|' && peek() != u')') {
+            auto child = Node{};
+            if (!parseRepeat(child)) {
+                return false;
+            }
+            node.children.push_back(std::move(child));
+        }
+        if (node.children.empty()) {
+            node = Node{};
+        } else if (node.children.size() == 1) {
+            auto child = std::move(node.children.front());
+            node = std::move(child);
+        }
+        return true;
+    }
+
+public:
+    Parser(const std::u16string_view pattern, const bool caseSensitive)
+        : m_pattern(pattern),
+          m_case_sensitive(caseSensitive) {}
+
+    bool parseAlternation(Node &node) {
+        auto first = Node{};
+        if (!parseConcat(first)) {
+            return false;
+        }
+        if (atEnd() || peek() != u'|') {
+            node = std::move(first);
+            return true;
+        }
+
+        node = makeNode(Node::Kind::Alternate);
+        node.children.push_back(std::move(first));
+        while (!atEnd() && peek() == u'|') {
+            ++m_position;
+            auto next = Node{};
+            if (!parseConcat(next)) {
+                return false;
+            }
+            node.children.push_back(std::move(next));
+        }
+        return true;
+    }
+
+    /** @brief Parses the whole pattern. */
+    bool parse(Node &node) {
+        if (!parseAlternation(node)) {
+            return false;
+        }
+        if (!atEnd()) {
+            return fail(u"unmatched )");
+        }
+        return true;
+    }
+
+    [[nodiscard]] uint32_t getGroupCount() const {
+        return m_group_count;
+    }
+
+    [[nodiscard]] const std::u16string &getError() const {
+        return m_error;
+    }
+};
+
+/**
+ * @brief Appends to a prefix the literal every match of a node starts with.
+ * @param node The node.
+ * @param caseSensitive Whether the comparison is case-sensitive.
+ * @param prefix Receives the literal, folded when the comparison is case-insensitive.
+ * @return true when the whole node is literal, so the prefix may go on with what follows it.
+ */
+bool appendPrefix(const Node &node, const bool caseSensitive, std::u16string &prefix) {
+    switch (node.kind) {
+        case Node::Kind::Empty:
+        case Node::Kind::LineStart:
+            return true;
+        case Node::Kind::Set: {
+            // A single code unit, or every case of one character when the case is ignored
+            const auto &ranges = node.ranges;
+            const auto first = ranges.front().first;
+            if (ranges.size() == 1 && first == ranges.front().second) {
+                prefix.push_back(caseSensitive ? first : CaseFold::fold(first));
+                return true;
+            }
+            if (caseSensitive) {
+                return false;
+            }
+            // No character has more than four cases; a larger set is a real class
+            const auto folded = CaseFold::fold(first);
+            auto count = uint32_t{ 0 };
+            for (const auto &[low, high] : ranges) {
+                for (auto unit = uint32_t{ low }; unit <= high; ++unit) {
+                    if (++count > 4 || CaseFold::fold(static_cast<char16_t>(unit)) != folded) {
+                        return false;
+                    }
+                }
+            }
+            prefix.push_back(folded);
+            return true;
+        }
+        case Node::Kind::Concat:
+            for (const auto &child : node.children) {
+                if (!appendPrefix(child, caseSensitive, prefix)) {
+                    return false;
+                }
+            }
+            return true;
+        case Node::Kind::Group:
+            return appendPrefix(node.children.front(), caseSensitive, prefix);
+        case Node::Kind::Repeat:
+            // The first iteration is certain, the following ones are not
+            if (node.min > 0) {
+                appendPrefix(node.children.front(), caseSensitive, prefix);
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Turns a parsed pattern around, so it matches the text of its matches read backwards.
+ *
+ * Sequences run the other way and the line anchors swap places; groups no longer capture, the
+ * reversed pattern only telling where a match starts.
+ *
+ * @param node The node to reverse.
+ * @return The reversed node.
+ */
+Node reversed(Node node) {
+    switch (node.kind) {
+        case Node::Kind::Concat:
+            std::reverse(node.children.begin(), node.children.end());
+            break;
+        case Node::Kind::Group:
+            node.group = -1;
+            break;
+        case Node::Kind::LineStart:
+            node.kind = Node::Kind::LineEnd;
+            break;
+        case Node::Kind::LineEnd:
+            node.kind = Node::Kind::LineStart;
+            break;
+        default:
+            break;
+    }
+
+    for (auto &child : node.children) {
+        child = reversed(std::move(child));
+    }
+    return node;
+}
+
+}
+
+class Regex::Compiler final {
+private:
+    std::vector<Instruction> &m_program;
+    std::vector<Ranges> &m_sets;
+    bool m_too_large = false;
+
+public:
+    Compiler(std::vector<Instruction> &program, std::vector<Ranges> &sets)
+        : m_program(program),
+          m_sets(sets) {}
+
+    /** @return The index of a new instruction whose next is the instruction following it. */
+    uint32_t emit(const Op op, const uint32_t argument = 0) {
+        if (m_program.size() >= Regex::MAX_PROGRAM_SIZE) {
+            m_too_large = true;
+        }
+        const auto index = static_cast<uint32_t>(m_program.size());
+        m_program.push_back({.op = op, .next = index + 1, .alternative = index + 1, .argument = argument});
+        return index;
+    }
+
+    [[nodiscard]] uint32_t here() const {
+        return static_cast<uint32_t>(m_program.size());
+    }
+
+    [[nodiscard]] bool isTooLarge() const {
+        return m_too_large;
+    }
+
+    /** @brief Points a split at a body and the instruction skipping it, preferring the body when @p greedy. */
+    void setSplit(const uint32_t split, const uint32_t body, const uint32_t skip, const bool greedy) {
+        m_program[split].next = greedy ? body : skip;
+        m_program[split].alternative = greedy ? skip : body;
+    }
+
+    void compile(const Node &node) {
+        if (m_too_large) {
+            return;
+        }
+
+        switch (node.kind) {
+            case Node::Kind::Empty:
+                break;
+            case Node::Kind::Set:
+                m_sets.push_back(node.ranges);
+                emit(Op::Set, static_cast<uint32_t>(m_sets.size() - 1));
+                break;
+            case Node::Kind::Concat:
+                for (const auto &child : node.children) {
+                    compile(child);
+                }
+                break;
+            case Node::Kind::Alternate: {
+                // split(a, split(b, c)), every branch jumping past the last one
+                auto jumps = std::vector<uint32_t>{};
+                for (size_t index = 0; index < node.children.size(); ++index) {
+                    if (index + 1 < node.children.size()) {
+                        const auto split = emit(Op::Split);
+                        compile(node.children[index]);
+                        jumps.push_back(emit(Op::Jump));
+                        setSplit(split, split + 1, here(), true);
+                    } else {
+                        compile(node.children[index]);
+                    }
+                }
+                for (const auto jump : jumps) {
+                    m_program[jump].next = here();
+                }
+                break;
+            }
+            case Node::Kind::Group:
+                if (node.group >= 0) {
+                    emit(Op::Save, static_cast<uint32_t>(node.group) * 2);
+                }
+                compile(node.children.front());
+                if (node.group >= 0) {
+                    emit(Op::Save, static_cast<uint32_t>(node.group) * 2 + 1);
+                }
+                break;
+            case Node::Kind::Repeat: {
+                const auto &child = node.children.front();
+                for (uint32_t count = 0; count < node.min && !m_too_large; ++count) {
+                    compile(child);
+                }
+
+                if (node.max == UNBOUNDED) {
+                    // loop: split(body, out); body; jump loop
+                    const auto split = emit(Op::Split);
+                    compile(child);
+                    const auto jump = emit(Op::Jump);
+                    m_program[jump].next = split;
+                    setSplit(split, split + 1, here(), node.greedy);
+                    break;
+                }
+
+                // (x(x(x)?)?)?: every optional iteration may skip to the end
+                auto splits = std::vector<uint32_t>{};
+                for (auto count = node.min; count < node.max && !m_too_large; ++count) {
+                    splits.push_back(emit(Op::Split));
+                    compile(child);
+                }
+                for (const auto split : splits) {
+                    setSplit(split, split + 1, here(), node.greedy);
+                }
+                break;
+            }
+            case Node::Kind::LineStart:
+                emit(Op::LineStart);
+                break;
+            case Node::Kind::LineEnd:
+                emit(Op::LineEnd);
+                break;
+        }
+    }
+};
+
+size_t Regex::StateSetHash::operator()(const std::vector<uint32_t> &states) const {
+    // FNV-1a over the instruction indices
+    auto hash = size_t{14695981039346656037ull};
+    for (const auto state : states) {
+        hash = (hash ^ state) * 1099511628211ull;
+    }
+    return hash;
+}
+
+Regex::Regex(const std::u16string_view pattern, const bool caseSensitive, const size_t cacheBytes)
+    : m_pattern(pattern),
+      m_case_sensitive(caseSensitive),
+      m_cache_budget(cacheBytes) {
+    auto parser = Parser(pattern, caseSensitive);
+    auto root = Node{};
+    if (!parser.parse(root)) {
+        m_error = parser.getError();
+        return;
+    }
+    m_group_count = parser.getGroupCount();
+    appendPrefix(root, caseSensitive, m_prefix);
+
+    auto compiler = Compiler(m_program, m_sets);
+    compiler.compile(root);
+    compiler.emit(Op::Match);
+
+    // The loop of the unanchored search: any code unit, past which step() starts a new group
+    m_sets.push_back({ { u'\0', u'\xFFFF' } });
+    m_unanchored_loop = compiler.emit(Op::Set, static_cast<uint32_t>(m_sets.size() - 1));
+
+    // The pattern backwards, run from the end of a match to find its start
+    m_reverse_start = compiler.here();
+    compiler.compile(reversed(std::move(root)));
+    compiler.emit(Op::Match);
+
+    if (compiler.isTooLarge()) {
+        m_error = u"pattern too large";
+        m_program.clear();
+        m_sets.clear();
+        return;
+    }
+
+    // Split the code units into the classes no set tells apart: the DFA has one transition per class
+    m_class_starts.push_back(u'\0');
+    for (const auto &set : m_sets) {
+        for (const auto &[low, high] : set) {
+            m_class_starts.push_back(low);
+            if (high < 0xFFFF) {
+                m_class_starts.push_back(static_cast<char16_t>(high + 1));
+            }
+        }
+    }
+    std::sort(m_class_starts.begin(), m_class_starts.end());
+    m_class_starts.erase(std::unique(m_class_starts.begin(), m_class_starts.end()), m_class_starts.end());
+
+    for (char16_t character = 0; character < m_ascii_classes.size(); ++character) {
+        m_ascii_classes[character] = static_cast<uint16_t>(std::upper_bound(m_class_starts.begin(), m_class_starts.end(), character) - m_class_starts.begin() - 1);
+    }
+
+    m_visited.assign(m_program.size(), 0);
+    m_claimed.assign(m_program.size(), 0);
+    resetCache();
+}
+
+bool Regex::isValid() const {
+    return m_error.empty();
+}
+
+const std::u16string &Regex::getError() const {
+    return m_error;
+}
+
+const std::u16string &Regex::getPattern() const {
+    return m_pattern;
+}
+
+bool Regex::isCaseSensitive() const {
+    return m_case_sensitive;
+}
+
+uint32_t Regex::getGroupCount() const {
+    return m_group_count;
+}
+
+const std::u16string &Regex::getPrefix() const {
+    return m_prefix;
+}
+
+uint32_t Regex::classOf(const char16_t character) const {
+    if (character < m_ascii_classes.size()) {
+        return m_ascii_classes[character];
+    }
+    return static_cast<uint32_t>(std::upper_bound(m_class_starts.begin(), m_class_starts.end(), character) - m_class_starts.begin() - 1);
+}
+
+bool Regex::setContains(const uint32_t set, const char16_t character) const {
+    const auto &ranges = m_sets[set];
+    const auto range = std::upper_bound(ranges.begin(), ranges.end(), character, [](const char16_t value, const std::pair<char16_t, char16_t> &item) {
+        return value < item.first;
+    });
+    return range != ranges.begin() && character <= std::prev(range)->second;
+}
+
+void Regex::closure(const std::vector<uint32_t> &seeds, const bool atLineStart, const bool atLineEnd, std::vector<uint32_t> &states) {
+    states.clear();
+    if (++m_generation == 0) {
+        std::fill(m_visited.begin(), m_visited.end(), 0);
+        m_generation = 1;
+    }
+
+    auto stack = std::vector<uint32_t>(seeds.rbegin(), seeds.rend());
+    while (!stack.empty()) {
+        const auto index = stack.back();
+        stack.pop_back();
+        if (m_visited[index] == m_generation) {
+            continue;
+        }
+        m_visited[index] = m_generation;
+
+        const auto &instruction = m_program[index];
+        switch (instruction.op) {
+            case Op::Split:
+                stack.push_back(instruction.alternative);
+                stack.push_back(instruction.next);
+                break;
+            case Op::Jump:
+            case Op::Save:
+                stack.push_back(instruction.next);
+                break;
+            case Op::LineStart:
+                if (atLineStart) {
+                    stack.push_back(instruction.next);
+                }
+                break;
+            case Op::LineEnd:
+                if (atLineEnd) {
+                    stack.push_back(instruction.next);
+                } else {
+                    states.push_back(index);
+                }
+                break;
+            case Op::Set:
+            case Op::Match:
+                states.push_back(index);
+                break;
+        }
+    }
+    std::sort(states.begin(), states.end());
+}
+
+uint32_t Regex::stateFor(std::vector<uint32_t> &&states, bool &flushed) {
+    if (const auto existing = m_state_ids.find(states); existing != m_state_ids.end()) {
+        return existing->second;
+    }
+
+    // The key, its hash node, the state and its row of transitions
+    const auto cost = states.size() * sizeof(uint32_t) + sizeof(DfaState) + 64 + m_class_starts.size() * sizeof(uint32_t);
+    if (m_cache_bytes + cost > m_cache_budget && m_states.size() > 1) {
+        resetCache();
+        ++m_cache_flushes;
+        flushed = true;
+        if (const auto existing = m_state_ids.find(states); existing != m_state_ids.end()) {
+            return existing->second;
+        }
+    }
+
+    auto match = false;
+    auto has_line_end = false;
+    for (const auto state : states) {
+        if (state != MARK) {
+            match = match || m_program[state].op == Op::Match;
+            has_line_end = has_line_end || m_program[state].op == Op::LineEnd;
+        }
+    }
+
+    auto match_at_end = match;
+    if (!match && has_line_end) {
+        auto seeds = states;
+        std::erase(seeds, MARK);
+        auto reached = std::vector<uint32_t>{};
+        closure(seeds, false, true, reached);
+        match_at_end = std::any_of(reached.begin(), reached.end(), [this](const uint32_t state) {
+            return m_program[state].op == Op::Match;
+        });
+    }
+
+    const auto id = static_cast<uint32_t>(m_states.size());
+    const auto [entry, inserted] = m_state_ids.emplace(std::move(states), id);
+    (void) inserted;
+    m_states.push_back({.nfa = &entry->first, .match = match, .match_at_end = match_at_end});
+    m_transitions.resize(m_transitions.size() + m_class_starts.size(), UNKNOWN_STATE);
+    m_cache_bytes += cost;
+    return id;
+}
+
+void Regex::resetCache() {
+    m_states.clear();
+    m_transitions.clear();
+    m_state_ids.clear();
+    m_cache_bytes = 0;
+    for (auto &row : m_start_states) {
+        row.fill(UNKNOWN_STATE);
+    }
+
+    auto flushed = false;
+    stateFor({}, flushed);
+}
+
+void Regex::beginKey() {
+    if (++m_key_generation == 0) {
+        std::fill(m_claimed.begin(), m_claimed.end(), 0);
+        m_key_generation = 1;
+    }
+}
+
+bool Regex::appendGroup(std::vector<uint32_t> &key, const std::vector<uint32_t> &states) {
+    auto match = false;
+    auto needs_mark = !key.empty();
+    for (const auto state : states) {
+        if (m_claimed[state] == m_key_generation) {
+            continue;
+        }
+        m_claimed[state] = m_key_generation;
+
+        // An empty group leaves no mark behind
+        if (needs_mark) {
+            key.push_back(MARK);
+            needs_mark = false;
+        }
+        key.push_back(state);
+        match = match || m_program[state].op == Op::Match;
+    }
+    return match;
+}
+
+uint32_t Regex::startState(const Entry entry, const bool atBoundary) {
+    auto &cached = m_start_states[static_cast<size_t>(entry)][atBoundary ? 1 : 0];
+    if (cached == UNKNOWN_STATE) {
+        // Backwards, the LineStart instructions stand for the end of the line
+        auto states = std::vector<uint32_t>{};
+        closure({ entry == Entry::Reverse ? m_reverse_start : 0u }, atBoundary, false, states);
+
+        auto key = std::vector<uint32_t>{};
+        beginKey();
+        if (!appendGroup(key, states) && entry == Entry::Unanchored) {
+            // The loop goes last: the matches it starts later lose to the ones starting here
+            appendGroup(key, { m_unanchored_loop });
+        }
+
+        auto flushed = false;
+        const auto id = stateFor(std::move(key), flushed);
+        // A flush reset every start state, this one included
+        cached = id;
+        return id;
+    }
+    return cached;
+}
+
+uint32_t Regex::step(const uint32_t state, const uint32_t characterClass) {
+    const auto slot = static_cast<size_t>(state) * m_class_starts.size() + characterClass;
+    if (const auto known = m_transitions[slot]; known != UNKNOWN_STATE) {
+        return known;
+    }
+
+    // Any code unit of the class behaves the same, so its first one stands for all of them. The
+    // groups step one by one, earliest start first, and a group that matched cuts the later ones
+    const auto character = m_class_starts[characterClass];
+    const auto &nfa = *m_states[state].nfa;
+    auto key = std::vector<uint32_t>{};
+    auto seeds = std::vector<uint32_t>{};
+    auto states = std::vector<uint32_t>{};
+    beginKey();
+    for (auto first = nfa.begin(); first != nfa.end();) {
+        const auto last = std::find(first, nfa.end(), MARK);
+        if (*first == m_unanchored_loop) {
+            // Past the loop, a new group starts, the loop itself going on last
+            closure({ 0u }, false, false, states);
+            if (!appendGroup(key, states)) {
+                appendGroup(key, { m_unanchored_loop });
+            }
+            break;
+        }
+
+        seeds.clear();
+        for (auto index = first; index != last; ++index) {
+            const auto &instruction = m_program[*index];
+            if (instruction.op == Op::Set && setContains(instruction.argument, character)) {
+                seeds.push_back(instruction.next);
+            }
+        }
+        closure(seeds, false, false, states);
+        if (appendGroup(key, states) || last == nfa.end()) {
+            break;
+        }
+        first = last + 1;
+    }
+
+    auto flushed = false;
+    const auto next = stateFor(std::move(key), flushed);
+    if (!flushed) {
+        m_transitions[slot] = next;
+    }
+    return next;
+}
+
+std::optional<size_t> Regex::longestEnd(const std::u16string_view line, const size_t from, const Entry entry) {
+    auto state = startState(entry, from == 0);
+    auto end = std::optional<size_t>{};
+    if (m_states[state].match) {
+        end = from;
+    }
+
+    for (auto position = from; position < line.length(); ++position) {
+        state = step(state, classOf(line[position]));
+        if (state == DEAD_STATE) {
+            return end;
+        }
+        if (m_states[state].match) {
+            end = position + 1;
+        }
+    }
+
+    if (m_states[state].match_at_end) {
+        end = line.length();
+    }
+    return end;
+}
+
+std::optional<size_t> Regex::earliestStart(const std::u16string_view line, const size_t from, const size_t end) {
+    // The reversed pattern tests the end of the line where it starts and column 0 where it ends,
+    // the way match_at_end tests the end of the line forwards
+    auto state = startState(Entry::Reverse, end == line.length());
+    auto start = std::optional<size_t>{};
+    if (m_states[state].match) {
+        start = end;
+    }
+
+    for (auto position = end; position > from; --position) {
+        state = step(state, classOf(line[position - 1]));
+        if (state == DEAD_STATE) {
+            return start;
+        }
+        if (m_states[state].match) {
+            start = position - 1;
+        }
+    }
+
+    if (from == 0 && m_states[state].match_at_end) {
+        start = 0;
+    }
+    return start;
+}
+
+std::optional<size_t> Regex::matchAt(const std::u16string_view line, const size_t start) {
+    if (start > line.length()) {
+        return std::nullopt;
+    }
+    return longestEnd(line, start, Entry::Anchored);
+}
+
+std::optional<Regex::Span> Regex::find(const std::u16string_view line, const size_t from) {
+    if (from > line.length()) {
+        return std::nullopt;
+    }
+
+    auto first = from;
+    if (!m_prefix.empty()) {
+        // Every match starts with the prefix: the vector search skips to its first occurrence
+        first = SubstringSearch::find(line, m_prefix, from, !m_case_sensitive);
+        if (first == std::u16string_view::npos) {
+            return std::nullopt;
+        }
+    }
+
+    // One forward pass finds where the leftmost-longest match ends, and one backward pass from
+    // there where it starts: both are linear, whatever the pattern
+    const auto end = longestEnd(line, first, Entry::Unanchored);
+    if (!end) {
+        return std::nullopt;
+    }
+
+    const auto start = earliestStart(line, first, *end);
+    if (!start) {
+        return std::nullopt;
+    }
+    return Span{.start = *start, .end = *end};
+}
+
+std::optional<Regex::Span> Regex::findLast(const std::u16string_view line, const size_t limit) {
+    auto last = std::optional<Span>{};
+    for (auto match = find(line, 0); match && match->start < limit;) {
+        last = match;
+        const auto from = match->end > match->start ? match->end : match->start + 1;
+        match = find(line, from);
+    }
+    return last;
+}
+
+std::vector<std::optional<Regex::Span>> Regex::capture(const std::u16string_view line, const Span &match) const {
+    // A Pike VM from the start of the match, keeping only the threads ending exactly at its end:
+    // threads run in priority order, so the first one to match holds the groups a backtracking
+    // engine would report for that span
+    constexpr auto unset = std::u16string_view::npos;
+    const auto slot_count = (m_group_count + 1) * 2;
+
+    struct Thread final {
+        uint32_t index;
+        std::vector<size_t> slots;
+    };
+
+    auto visited = std::vector<size_t>(m_program.size(), unset);
+    const auto add = [&](std::vector<Thread> &list, const uint32_t start, const std::vector<size_t> &slots, const size_t position) {
+        auto stack = std::vector<Thread>{};
+        stack.push_back({.index = start, .slots = slots});
+        while (!stack.empty()) {
+            auto thread = std::move(stack.back());
+            stack.pop_back();
+            if (visited[thread.index] == position) {
+                continue;
+            }
+            visited[thread.index] = position;
+
+            const auto &instruction = m_program[thread.index];
+            switch (instruction.op) {
+                case Op::Split:
+                    stack.push_back({.index = instruction.alternative, .slots = thread.slots});
+                    stack.push_back({.index = instruction.next, .slots = std::move(thread.slots)});
+                    break;
+                case Op::Jump:
+                    stack.push_back({.index = instruction.next, .slots = std::move(thread.slots)});
+                    break;
+                case Op::Save:
+                    thread.slots[instruction.argument] = position;
+                    stack.push_back({.index = instruction.next, .slots = std::move(thread.slots)});
+                    break;
+                case Op::LineStart:
+                    if (position == 0) {
+                        stack.push_back({.index = instruction.next, .slots = std::move(thread.slots)});
+                    }
+                    break;
+                case Op::LineEnd:
+                    if (position == line.length()) {
+                        stack.push_back({.index = instruction.next, .slots = std::move(thread.slots)});
+                    }
+                    break;
+                case Op::Set:
+                case Op::Match:
+                    list.push_back(std::move(thread));
+                    break;
+            }
+        }
+    };
+
+    auto current = std::vector<Thread>{};
+    auto next = std::vector<Thread>{};
+    add(current, 0, std::vector<size_t>(slot_count, unset), match.start);
+
+    auto result = std::vector<std::optional<Span>>(m_group_count + 1);
+    result[0] = match;
+    for (auto position = match.start; !current.empty(); ++position) {
+        for (auto &thread : current) {
+            const auto &instruction = m_program[thread.index];
+            if (instruction.op == Op::Match) {
+                if (position == match.end) {
+                    for (uint32_t group = 1; group <= m_group_count; ++group) {
+                        const auto start = thread.slots[group * 2];
+                        const auto end = thread.slots[group * 2 + 1];
+                        if (start != unset && end != unset && start <= end) {
+                            result[group] = Span{.start = start, .end = end};
+                        }
+                    }
+                    return result;
+                }
+                continue;
+            }
+
+            if (position < match.end && setContains(instruction.argument, line[position])) {
+                add(next, instruction.next, thread.slots, position + 1);
+            }
+        }
+
+        if (position >= match.end) {
+            break;
+        }
+        current.swap(next);
+        next.clear();
+    }
+
+    return result;
+}
+
+size_t Regex::getCacheMemoryUsage() const {
+    return m_cache_bytes;
+}
+
+uint64_t Regex::getCacheFlushCount() const {
+    return m_cache_flushes;
+}
+
+std::u16string Regex::expand(const std::u16string_view replacement, const std::u16string_view line, const std::vector<std::optional<Span>> &groups) {
+    auto result = std::u16string{};
+    result.reserve(replacement.length());
+    for (size_t index = 0; index < replacement.length(); ++index) {
+        const auto character = replacement[index];
+        if (character != u'\\' || index + 1 == replacement.length()) {
+            result.push_back(character);
+            continue;
+        }
+
+        const auto escaped = replacement[++index];
+        if (escaped >= u'0' && escaped <= u'9') {
+            const auto group = static_cast<size_t>(escaped - u'0');
+            if (group < groups.size() && groups[group]) {
+                result.append(line.substr(groups[group]->start, groups[group]->end - groups[group]->start));
+            }
+        } else if (escaped == u'n') {
+            result.push_back(u'\n');
+        } else if (escaped == u't') {
+            result.push_back(u'\t');
+        } else {
+            result.push_back(escaped);
+        }
+    }
+    return result;
+}
+
+int32_t Regex::getHighestReference(const std::u16string_view replacement) {
+    auto highest = -1;
+    for (size_t index = 0; index + 1 < replacement.length(); ++index) {
+        if (replacement[index] != u'\\') {
+            continue;
+        }
+        const auto escaped = replacement[++index];
+        if (escaped >= u'0' && escaped <= u'9') {
+            highest = std::max(highest, static_cast<int32_t>(escaped - u'0'));
+        }
+    }
+    return highest;
+}
@@ -0,0 +1,358 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef REGEX_H
+#define REGEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief A regular expression matched over UTF-16 lines by a lazily built, memory-capped DFA.
+ *
+ * The pattern compiles to a Thompson NFA. Searches run on a DFA whose states are sets of NFA
+ * states, each built the first time a search reaches it and cached along with its transitions;
+ * when the cache outgrows its budget it is dropped and refilled from the state in use, so memory
+ * stays bounded whatever the pattern. When every match starts with the same literal, that prefix
+ * is looked up with SubstringSearch first and the DFA only runs where it occurs.
+ *
+ * Matching is confined to a line and leftmost-longest, like POSIX: the match starting first wins,
+ * then the longest one from there. A search is two linear passes: an unanchored one, whose DFA
+ * states keep their NFA threads grouped by where they started and drop the later groups once an
+ * earlier one matched, finds where that match ends, and the pattern compiled backwards runs from
+ * there to find where it starts. Capture groups are resolved on demand by capture(), an NFA
+ * simulation confined to the span the DFA found, which honours greedy and lazy quantifiers the way
+ * backtracking engines do.
+ *
+ * Syntax: literals, `.`, classes `[...]` and `[^...]` with ranges, `\d \w \s` and their negations
+ * `\D \W \S`, `\t`, `\xHH`, `\uHHHH`, escaped metacharacters, the line anchors `^` and `$`, groups
+ * `( )` and `(?: )`, `|`, and the quantifiers `* + ? {n} {n,} {n,m}`, lazy when followed by `?`.
+ * Case-insensitive patterns fold with CaseFold, like the literal search, so a code unit matches
+ * wherever its fold does; everything matches UTF-16 code units.
+ *
+ * Searches fill the DFA cache, so a Regex is not thread-safe: threads searching at the same time
+ * each compile their own.
+ */
+class Regex final {
+public:
+    /** @brief A half-open range of columns, [start, end). */
+    struct Span final {
+        size_t start; ///< First column of the range.
+        size_t end;   ///< Column just past the range.
+    };
+
+    /** Default budget of the DFA cache, in bytes. */
+    static constexpr size_t DEFAULT_CACHE_BYTES = 1u << 20;
+
+    /** Largest bound a counted repetition accepts. */
+    static constexpr uint32_t MAX_REPEAT = 1000;
+
+    /** Largest number of NFA instructions a pattern may compile to. */
+    static constexpr size_t MAX_PROGRAM_SIZE = 1u << 16;
+
+private:
+    /** @brief The NFA instruction set. */
+    enum class Op : uint8_t {
+        Set,        ///< Consume a code unit belonging to m_sets[argument], then go to next.
+        Split,      ///< Go to next and to alternative, next being preferred.
+        Jump,       ///< Go to next.
+        Save,       ///< Record the position in capture slot argument, then go to next.
+        LineStart,  ///< Go to next at column 0 only.
+        LineEnd,    ///< Go to next at the end of the line only.
+        Match       ///< The pattern matched.
+    };
+
+    /** @brief One NFA instruction. */
+    struct Instruction final {
+        Op op;                 ///< The operation.
+        uint32_t next;         ///< The instruction following this one.
+        uint32_t alternative;  ///< The second branch of a Split.
+        uint32_t argument;     ///< Set index of a Set, slot of a Save.
+    };
+
+    /** @brief Sorted, disjoint, inclusive code unit ranges. */
+    using Ranges = std::vector<std::pair<char16_t, char16_t>>;
+
+    /** @brief Emits the NFA of a parsed pattern; defined along with the parser in Regex.cpp. */
+    class Compiler;
+
+    /** @brief The entry a search starts the DFA from. */
+    enum class Entry : uint8_t {
+        Anchored,   ///< Matches starting at the search column.
+        Unanchored, ///< Matches starting at the search column or any later one, grouped by start.
+        Reverse     ///< The pattern backwards, from the column a match ends at.
+    };
+
+    /** @brief Hashes the NFA state set keying a DFA state. */
+    struct StateSetHash final {
+        size_t operator()(const std::vector<uint32_t> &states) const;
+    };
+
+    /** @brief One cached DFA state. */
+    struct DfaState final {
+        const std::vector<uint32_t> *nfa; ///< The NFA states it stands for, start groups split by MARK, owned by m_state_ids.
+        bool match;                       ///< A match ends before the next code unit.
+        bool match_at_end;                ///< A match ends here if the line ends here.
+    };
+
+    /** Transition not computed yet. */
+    static constexpr uint32_t UNKNOWN_STATE = UINT32_MAX;
+
+    /** The state matching nothing more; always the first state of the cache. */
+    static constexpr uint32_t DEAD_STATE = 0;
+
+    /** Separates the start groups of the NFA states of a DFA state, earliest start first. */
+    static constexpr uint32_t MARK = UINT32_MAX;
+
+    /** The pattern, as given. */
+    std::u16string m_pattern;
+
+    /** Whether the comparison is case-sensitive. */
+    bool m_case_sensitive;
+
+    /** Why the pattern did not compile; empty when it did. */
+    std::u16string m_error;
+
+    /** The NFA; the anchored entry is instruction 0. */
+    std::vector<Instruction> m_program;
+
+    /** The instruction consuming any code unit that starts a new group of an unanchored search at every column. */
+    uint32_t m_unanchored_loop = 0;
+
+    /** The entry of the NFA of the pattern backwards, to find where a match ending at a known column starts. */
+    uint32_t m_reverse_start = 0;
+
+    /** The code unit sets of the Set instructions. */
+    std::vector<Ranges> m_sets;
+
+    /** Number of capture groups, not counting the whole match. */
+    uint32_t m_group_count = 0;
+
+    /** Literal every match starts with, folded when the comparison is case-insensitive; may be empty. */
+    std::u16string m_prefix;
+
+    /** First code unit of every alphabet class; code units of a class are told apart by no set. */
+    std::vector<char16_t> m_class_starts;
+
+    /** Alphabet class of every ASCII code unit, the common case spared the binary search. */
+    std::array<uint16_t, 128> m_ascii_classes{};
+
+    /** Byte budget of the DFA cache. */
+    size_t m_cache_budget;
+
+    /** Bytes held by the DFA cache. */
+    size_t m_cache_bytes = 0;
+
+    /** Number of times the DFA cache was dropped for outgrowing its budget. */
+    uint64_t m_cache_flushes = 0;
+
+    /** The DFA states, indexed by id. */
+    std::vector<DfaState> m_states;
+
+    /** The DFA transitions, m_class_starts.size() per state; UNKNOWN_STATE until computed. */
+    std::vector<uint32_t> m_transitions;
+
+    /** Id of every DFA state, by NFA state set. */
+    std::unordered_map<std::vector<uint32_t>, uint32_t, StateSetHash> m_state_ids;
+
+    /** Start states by [Entry][at the line boundary the entry starts from]; UNKNOWN_STATE until computed. */
+    std::array<std::array<uint32_t, 2>, 3> m_start_states{};
+
+    /** Scratch of closure(): the generation that last visited each instruction. */
+    std::vector<uint32_t> m_visited;
+
+    /** Scratch of closure(): the current generation. */
+    uint32_t m_generation = 0;
+
+    /** Scratch of appendGroup(): the key generation that last took each instruction in. */
+    std::vector<uint32_t> m_claimed;
+
+    /** Scratch of appendGroup(): the current key generation. */
+    uint32_t m_key_generation = 0;
+
+    /** @return The alphabet class of a code unit. */
+    [[nodiscard]] uint32_t classOf(char16_t character) const;
+
+    /** @return true when the set of a Set instruction holds the code unit. */
+    [[nodiscard]] bool setContains(uint32_t set, char16_t character) const;
+
+    /**
+     * @brief Follows the empty transitions from a list of instructions.
+     * @param seeds The instructions to start from.
+     * @param atLineStart Whether LineStart instructions are passed.
+     * @param atLineEnd Whether LineEnd instructions are passed.
+     * @param states Receives the sorted instructions reached that consume a code unit, match, or wait on an anchor.
+     */
+    void closure(const std::vector<uint32_t> &seeds, bool atLineStart, bool atLineEnd, std::vector<uint32_t> &states);
+
+    /** @brief Starts a new DFA state key, which appendGroup() fills. */
+    void beginKey();
+
+    /**
+     * @brief Appends a start group to a DFA state key.
+     *
+     * The NFA states an earlier group holds are left out: they lead where they would from the
+     * earlier start, which wins.
+     *
+     * @param key The key being built.
+     * @param states The NFA states of the group, sorted.
+     * @return true when the group holds a match, so no later start may win and the groups after it are cut.
+     */
+    bool appendGroup(std::vector<uint32_t> &key, const std::vector<uint32_t> &states);
+
+    /**
+     * @brief Returns the DFA state of an NFA state set, creating it if needed.
+     *
+     * Creating a state past the cache budget drops the cache first, so every other state id
+     * becomes invalid.
+     *
+     * @param states The NFA state set, as closure() returns it.
+     * @param flushed Set to true when the cache was dropped.
+     * @return The state id.
+     */
+    uint32_t stateFor(std::vector<uint32_t> &&states, bool &flushed);
+
+    /** @brief Empties the DFA cache, keeping only the dead state. */
+    void resetCache();
+
+    /**
+     * @brief Returns the start state of a search.
+     * @param entry Where the search enters the NFA.
+     * @param atBoundary true when the search starts at the line boundary its anchor tests: column 0
+     *                   forwards, the end of the line backwards.
+     * @return The state id.
+     */
+    uint32_t startState(Entry entry, bool atBoundary);
+
+    /** @return The state reached from a state on a code unit of the given class. */
+    uint32_t step(uint32_t state, uint32_t characterClass);
+
+    /**
+     * @brief Finds where the longest of the matches starting first ends.
+     * @param line The line to scan.
+     * @param from The column matches may start from.
+     * @param entry Anchored for the matches starting at @p from only, Unanchored for the leftmost one.
+     * @return The end column, or std::nullopt when no match starts at or after @p from.
+     */
+    [[nodiscard]] std::optional<size_t> longestEnd(std::u16string_view line, size_t from, Entry entry);
+
+    /**
+     * @brief Finds the earliest start of the matches ending at a column, scanning backwards.
+     * @param line The line to scan.
+     * @param from The column matches may start from.
+     * @param end The column the matches end at.
+     * @return The start column, or std::nullopt when no match ends at @p end.
+     */
+    [[nodiscard]] std::optional<size_t> earliestStart(std::u16string_view line, size_t from, size_t end);
+
+public:
+    /**
+     * @brief Compiles a pattern.
+     * @param pattern The pattern.
+     * @param caseSensitive Whether the comparison is case-sensitive.
+     * @param cacheBytes Byte budget of the DFA cache.
+     */
+    explicit Regex(std::u16string_view pattern, bool caseSensitive, size_t cacheBytes = DEFAULT_CACHE_BYTES);
+
+    /** @return true when the pattern compiled; no other method may be called otherwise. */
+    [[nodiscard]] bool isValid() const;
+
+    /** @return Why the pattern did not compile; empty when it did. */
+    [[nodiscard]] const std::u16string &getError() const;
+
+    /** @return The pattern, as given. */
+    [[nodiscard]] const std::u16string &getPattern() const;
+
+    /** @return Whether the comparison is case-sensitive. */
+    [[nodiscard]] bool isCaseSensitive() const;
+
+    /** @return Number of capture groups, not counting the whole match. */
+    [[nodiscard]] uint32_t getGroupCount() const;
+
+    /** @return Literal every match starts with, folded when the comparison is case-insensitive; may be empty. */
+    [[nodiscard]] const std::u16string &getPrefix() const;
+
+    /**
+     * @brief Finds the longest match starting exactly at a column.
+     * @param line The line to match.
+     * @param start The column the match must start at.
+     * @return The end column of the match, or std::nullopt when none starts there.
+     */
+    [[nodiscard]] std::optional<size_t> matchAt(std::u16string_view line, size_t start);
+
+    /**
+     * @brief Finds the leftmost-longest match starting at or after a column.
+     * @param line The line to scan.
+     * @param from The column to start scanning from.
+     * @return The match, or std::nullopt when none.
+     */
+    [[nodiscard]] std::optional<Span> find(std::u16string_view line, size_t from);
+
+    /**
+     * @brief Finds the last match starting before a bound, among the non-overlapping matches of the line.
+     * @param line The line to scan.
+     * @param limit The exclusive upper bound for the match start column.
+     * @return The match, or std::nullopt when none.
+     */
+    [[nodiscard]] std::optional<Span> findLast(std::u16string_view line, size_t limit);
+
+    /**
+     * @brief Resolves the capture groups of a match.
+     * @param line The line holding the match.
+     * @param match The match, as find() or matchAt() returned it.
+     * @return The span of every group, the whole match first; std::nullopt for a group that did not take part.
+     */
+    [[nodiscard]] std::vector<std::optional<Span>> capture(std::u16string_view line, const Span &match) const;
+
+    /** @return The bytes held by the DFA cache. */
+    [[nodiscard]] size_t getCacheMemoryUsage() const;
+
+    /** @return Number of times the DFA cache was dropped for outgrowing its budget. */
+    [[nodiscard]] uint64_t getCacheFlushCount() const;
+
+    /**
+     * @brief Builds a replacement from a template referencing capture groups.
+     *
+     * `\0` to `\9` insert the text of a group (nothing for a group that did not take part), `\n`
+     * and `\t` a newline and a tab, and a backslash before any other character inserts that character.
+     *
+     * @param replacement The replacement template.
+     * @param line The line holding the match.
+     * @param groups The groups of the match, as capture() returned them.
+     * @return The replacement text.
+     */
+    [[nodiscard]] static std::u16string expand(std::u16string_view replacement, std::u16string_view line, const std::vector<std::optional<Span>> &groups);
+
+    /**
+     * @brief Returns the highest group a replacement template references.
+     * @param replacement The replacement template.
+     * @return The highest group number, or -1 when the template references none.
+     */
+    [[nodiscard]] static int32_t getHighestReference(std::u16string_view replacement);
+};
+
+
+#endif //REGEX_H
@@ -0,0 +1,298 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "SubstringSearch.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#include "CaseFold.h"
+
+// The vector kernels need SSE2 as a baseline, which only x86-64 guarantees, and the GCC/Clang
+// builtins for the run-time detection; anything else builds the scalar kernel alone.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SUBSTRING_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+
+/**
+ * @brief Compares a needle against the text at a position, folding the text when asked.
+ * @param text The text at the candidate position; at least needle.size() units long.
+ * @param needle The needle, already folded when @p foldCase is set.
+ * @param foldCase true to fold the text before comparing it.
+ * @return true when the needle matches.
+ */
+static bool matchesAt(const char16_t *text, const std::u16string_view needle, const bool foldCase) {
+    if (!foldCase) {
+        return std::equal(needle.begin(), needle.end(), text);
+    }
+
+    for (size_t index = 0; index < needle.size(); ++index) {
+        if (CaseFold::fold(text[index]) != needle[index]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/** @brief Scalar kernel; also finishes the positions too close to the end for a full vector. */
+static size_t findScalar(const std::u16string_view haystack, const std::u16string_view needle, const size_t from, const bool foldCase) {
+    if (!foldCase) {
+        return haystack.find(needle, from);
+    }
+
+    const auto first = needle.front();
+    const auto last_start = haystack.size() - needle.size();
+    for (auto position = from; position <= last_start; ++position) {
+        if (CaseFold::fold(haystack[position]) == first && matchesAt(haystack.data() + position, needle, true)) {
+            return position;
+        }
+    }
+
+    return std::u16string_view::npos;
+}
+
+#ifdef SUBSTRING_SEARCH_X86
+/** @brief Folds the ASCII letters of eight code units: adds 0x20 to the units in A-Z. */
+static __m128i foldAsciiSse2(const __m128i units) {
+    // (unit - 'A') < 26 unsigned, as a signed comparison once both sides are biased by 0x8000
+    const auto offset = _mm_xor_si128(_mm_sub_epi16(units, _mm_set1_epi16(u'A')), _mm_set1_epi16(INT16_MIN));
+    const auto is_upper = _mm_cmplt_epi16(offset, _mm_set1_epi16(INT16_MIN + 26));
+    return _mm_add_epi16(units, _mm_and_si128(is_upper, _mm_set1_epi16(u'a' - u'A')));
+}
+
+/** @return true when none of eight code units is outside ASCII. */
+static bool isAsciiSse2(const __m128i units) {
+    const auto high_bits = _mm_and_si128(units, _mm_set1_epi16(static_cast<int16_t>(0xFF80)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, _mm_setzero_si128())) == 0xFFFF;
+}
+
+/** @brief The cases of an anchor, one broadcast vector per case. */
+struct CaseVectorsSse2 final {
+    __m128i cases[CaseFold::MAX_CASES];
+};
+
+/** @brief Broadcasts the cases of an anchor, the code units folding to it. */
+static void broadcastCasesSse2(const char16_t anchor, CaseVectorsSse2 &vectors) {
+    const auto cases = CaseFold::getCases(anchor);
+    for (size_t index = 0; index < cases.size(); ++index) {
+        vectors.cases[index] = _mm_set1_epi16(static_cast<int16_t>(cases[index]));
+    }
+}
+
+/** @brief Compares eight code units against an anchor through its cases, which is folding them without the table. */
+static __m128i matchCasesSse2(const __m128i units, const CaseVectorsSse2 &vectors) {
+    auto matched = _mm_cmpeq_epi16(units, vectors.cases[0]);
+    for (size_t index = 1; index < CaseFold::MAX_CASES; ++index) {
+        matched = _mm_or_si128(matched, _mm_cmpeq_epi16(units, vectors.cases[index]));
+    }
+    return matched;
+}
+
+/** @brief SSE2 kernel: eight candidate positions per step, anchored on the first and last unit of the needle. */
+static size_t findSse2(const std::u16string_view haystack, const std::u16string_view needle, const size_t from, const bool foldCase) {
+    static constexpr size_t width = 8;
+    const auto *text = haystack.data();
+    const auto tail_offset = needle.size() - 1;
+    const auto last_start = haystack.size() - needle.size();
+    const auto first = _mm_set1_epi16(static_cast<int16_t>(needle.front()));
+    const auto last = _mm_set1_epi16(static_cast<int16_t>(needle.back()));
+
+    // Broadcast on the first vector holding a non-ASCII unit, so ASCII text never looks them up
+    auto first_cases = CaseVectorsSse2{};
+    auto last_cases = CaseVectorsSse2{};
+    auto has_cases = false;
+
+    auto position = from;
+    for (; position + width <= last_start + 1; position += width) {
+        const auto heads = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + position));
+        const auto tails = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + position + tail_offset));
+
+        auto anchors = __m128i{};
+        if (!foldCase) {
+            anchors = _mm_and_si128(_mm_cmpeq_epi16(heads, first), _mm_cmpeq_epi16(tails, last));
+        } else if (isAsciiSse2(_mm_or_si128(heads, tails))) {
+            anchors = _mm_and_si128(_mm_cmpeq_epi16(foldAsciiSse2(heads), first), _mm_cmpeq_epi16(foldAsciiSse2(tails), last));
+        } else {
+            if (!has_cases) {
+                broadcastCasesSse2(needle.front(), first_cases);
+                broadcastCasesSse2(needle.back(), last_cases);
+                has_cases = true;
+            }
+            anchors = _mm_and_si128(matchCasesSse2(heads, first_cases), matchCasesSse2(tails, last_cases));
+        }
+
+        // Two mask bits per code unit; both are set or clear together
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(anchors));
+        while (mask != 0) {
+            const auto candidate = position + static_cast<size_t>(std::countr_zero(mask)) / 2;
+            if (matchesAt(text + candidate, needle, foldCase)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+            mask &= mask - 1;
+        }
+    }
+
+    return findScalar(haystack, needle, position, foldCase);
+}
+
+/** @brief Folds the ASCII letters of sixteen code units; the AVX2 twin of foldAsciiSse2. */
+__attribute__((target("avx2")))
+static __m256i foldAsciiAvx2(const __m256i units) {
+    const auto offset = _mm256_xor_si256(_mm256_sub_epi16(units, _mm256_set1_epi16(u'A')), _mm256_set1_epi16(INT16_MIN));
+    const auto is_upper = _mm256_cmpgt_epi16(_mm256_set1_epi16(INT16_MIN + 26), offset);
+    return _mm256_add_epi16(units, _mm256_and_si256(is_upper, _mm256_set1_epi16(u'a' - u'A')));
+}
+
+/** @return true when none of sixteen code units is outside ASCII; the AVX2 twin of isAsciiSse2. */
+__attribute__((target("avx2")))
+static bool isAsciiAvx2(const __m256i units) {
+    const auto high_bits = _mm256_and_si256(units, _mm256_set1_epi16(static_cast<int16_t>(0xFF80)));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(high_bits, _mm256_setzero_si256()))) == 0xFFFFFFFF;
+}
+
+/** @brief The cases of an anchor, one broadcast vector per case; the AVX2 twin of CaseVectorsSse2. */
+struct CaseVectorsAvx2 final {
+    __m256i cases[CaseFold::MAX_CASES];
+};
+
+/** @brief Broadcasts the cases of an anchor; the AVX2 twin of broadcastCasesSse2. */
+__attribute__((target("avx2")))
+static void broadcastCasesAvx2(const char16_t anchor, CaseVectorsAvx2 &vectors) {
+    const auto cases = CaseFold::getCases(anchor);
+    for (size_t index = 0; index < cases.size(); ++index) {
+        vectors.cases[index] = _mm256_set1_epi16(static_cast<int16_t>(cases[index]));
+    }
+}
+
+/** @brief Compares sixteen code units against an anchor through its cases; the AVX2 twin of matchCasesSse2. */
+__attribute__((target("avx2")))
+static __m256i matchCasesAvx2(const __m256i units, const CaseVectorsAvx2 &vectors) {
+    auto matched = _mm256_cmpeq_epi16(units, vectors.cases[0]);
+    for (size_t index = 1; index < CaseFold::MAX_CASES; ++index) {
+        matched = _mm256_or_si256(matched, _mm256_cmpeq_epi16(units, vectors.cases[index]));
+    }
+    return matched;
+}
+
+/** @brief AVX2 kernel: sixteen candidate positions per step; otherwise the same as findSse2. */
+__attribute__((target("avx2")))
+static size_t findAvx2(const std::u16string_view haystack, const std::u16string_view needle, const size_t from, const bool foldCase) {
+    static constexpr size_t width = 16;
+    const auto *text = haystack.data();
+    const auto tail_offset = needle.size() - 1;
+    const auto last_start = haystack.size() - needle.size();
+    const auto first = _mm256_set1_epi16(static_cast<int16_t>(needle.front()));
+    const auto last = _mm256_set1_epi16(static_cast<int16_t>(needle.back()));
+
+    auto first_cases = CaseVectorsAvx2{};
+    auto last_cases = CaseVectorsAvx2{};
+    auto has_cases = false;
+
+    auto position = from;
+    for (; position + width <= last_start + 1; position += width) {
+        const auto heads = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + position));
+        const auto tails = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + position + tail_offset));
+
+        auto anchors = __m256i{};
+        if (!foldCase) {
+            anchors = _mm256_and_si256(_mm256_cmpeq_epi16(heads, first), _mm256_cmpeq_epi16(tails, last));
+        } else if (isAsciiAvx2(_mm256_or_si256(heads, tails))) {
+            anchors = _mm256_and_si256(_mm256_cmpeq_epi16(foldAsciiAvx2(heads), first), _mm256_cmpeq_epi16(foldAsciiAvx2(tails), last));
+        } else {
+            if (!has_cases) {
+                broadcastCasesAvx2(needle.front(), first_cases);
+                broadcastCasesAvx2(needle.back(), last_cases);
+                has_cases = true;
+            }
+            anchors = _mm256_and_si256(matchCasesAvx2(heads, first_cases), matchCasesAvx2(tails, last_cases));
+        }
+
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(anchors));
+        while (mask != 0) {
+            const auto candidate = position + static_cast<size_t>(std::countr_zero(mask)) / 2;
+            if (matchesAt(text + candidate, needle, foldCase)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+            mask &= mask - 1;
+        }
+    }
+
+    // Less than a full vector left: the SSE2 kernel takes what it can, then the scalar one
+    return findSse2(haystack, needle, position, foldCase);
+}
+#endif
+
+SubstringSearch::Kernel SubstringSearch::getBestKernel() {
+#ifdef SUBSTRING_SEARCH_X86
+    static const auto kernel = __builtin_cpu_supports("avx2") ? Kernel::Avx2 : Kernel::Sse2;
+    return kernel;
+#else
+    return Kernel::Scalar;
+#endif
+}
+
+size_t SubstringSearch::find(const std::u16string_view haystack, const std::u16string_view needle, const size_t from, const bool foldCase) {
+    return find(haystack, needle, from, foldCase, getBestKernel());
+}
+
+size_t SubstringSearch::find(const std::u16string_view haystack, const std::u16string_view needle, const size_t from, const bool foldCase, const Kernel kernel) {
+    if (from > haystack.size() || needle.size() > haystack.size() - from) {
+        return std::u16string_view::npos;
+    }
+
+    if (needle.empty()) {
+        return from;
+    }
+
+    switch (kernel) {
+#ifdef SUBSTRING_SEARCH_X86
+        case Kernel::Avx2:
+            return findAvx2(haystack, needle, from, foldCase);
+        case Kernel::Sse2:
+            return findSse2(haystack, needle, from, foldCase);
+#endif
+        default:
+            return findScalar(haystack, needle, from, foldCase);
+    }
+}
+
+size_t SubstringSearch::findLast(const std::u16string_view haystack, const std::u16string_view needle, const size_t limit, const bool foldCase) {
+    if (limit == 0 || needle.size() > haystack.size()) {
+        return std::u16string_view::npos;
+    }
+
+    if (!foldCase) {
+        // rfind returns the greatest start position <= limit - 1, i.e. strictly before the limit.
+        return haystack.rfind(needle, limit - 1);
+    }
+
+    // Decrement in the condition so position 0 is tried too
+    for (auto position = std::min(limit - 1, haystack.size() - needle.size()) + 1; position-- > 0;) {
+        if (matchesAt(haystack.data() + position, needle, true)) {
+            return position;
+        }
+    }
+
+    return std::u16string_view::npos;
+}
@@ -0,0 +1,96 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SUBSTRING_SEARCH_H
+#define SUBSTRING_SEARCH_H
+
+#include <cstddef>
+#include <string_view>
+
+
+/**
+ * @brief Static-only substring search over UTF-16 text, optionally folding case.
+ *
+ * Candidates are found by comparing two anchors at once, the first and the last unit of the
+ * needle, over a whole vector of haystack positions; only the positions where both anchors match
+ * are compared in full. The haystack is folded with CaseFold inside the comparison, never copied,
+ * so one call can scan any amount of text. A vector of ASCII units folds with a few branch-free
+ * instructions; a vector holding a non-ASCII unit is compared against every case of the anchors
+ * instead (CaseFold::getCases), looked up once the first such vector shows up. The vector kernels
+ * exist on x86 only and are picked at run time from what the CPU supports; every other target
+ * runs the scalar kernel.
+ */
+class SubstringSearch final {
+public:
+    /** @brief The implementations of the search, slowest first. */
+    enum class Kernel {
+        Scalar,  ///< One position at a time; available everywhere.
+        Sse2,    ///< Eight positions per step, x86 only.
+        Avx2     ///< Sixteen positions per step, x86 CPUs supporting AVX2 only.
+    };
+
+    /** @brief Deleted constructor; this class is static-only. */
+    SubstringSearch() = delete;
+
+    /** @return The fastest kernel the running CPU supports; detected once. */
+    [[nodiscard]] static Kernel getBestKernel();
+
+    /**
+     * @brief Finds the first occurrence of a needle at or after an offset, with the best kernel.
+     *
+     * An empty needle matches at @p from whenever it fits within the haystack, as std::u16string_view::find does.
+     *
+     * @param haystack The text to scan.
+     * @param needle The text to look for; already folded when @p foldCase is set.
+     * @param from The offset to start scanning from.
+     * @param foldCase true to fold the haystack with CaseFold::fold before comparing it.
+     * @return The starting offset, or std::u16string_view::npos when absent.
+     */
+    [[nodiscard]] static size_t find(std::u16string_view haystack, std::u16string_view needle, size_t from, bool foldCase);
+
+    /**
+     * @brief Finds the first occurrence of a needle at or after an offset, with the given kernel.
+     *
+     * The kernel must be supported by the running CPU (at most getBestKernel()); tests use it to
+     * check every kernel against the others.
+     *
+     * @param haystack The text to scan.
+     * @param needle The text to look for; already folded when @p foldCase is set.
+     * @param from The offset to start scanning from.
+     * @param foldCase true to fold the haystack with CaseFold::fold before comparing it.
+     * @param kernel The implementation to run.
+     * @return The starting offset, or std::u16string_view::npos when absent.
+     */
+    [[nodiscard]] static size_t find(std::u16string_view haystack, std::u16string_view needle, size_t from, bool foldCase, Kernel kernel);
+
+    /**
+     * @brief Finds the last occurrence of a needle starting before a bound.
+     *
+     * Backward lookups scan a single line from the caret, so they stay scalar.
+     *
+     * @param haystack The text to scan.
+     * @param needle The text to look for; already folded when @p foldCase is set.
+     * @param limit The exclusive upper bound for the match start offset.
+     * @param foldCase true to fold the haystack with CaseFold::fold before comparing it.
+     * @return The starting offset, or std::u16string_view::npos when absent.
+     */
+    [[nodiscard]] static size_t findLast(std::u16string_view haystack, std::u16string_view needle, size_t limit, bool foldCase);
+};
+
+
+#endif //SUBSTRING_SEARCH_H
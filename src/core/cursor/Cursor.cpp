@@ -19,11 +19,33 @@
 #include "Cursor.h"
 
 #include <algorithm>
+#include <iterator>
 #include <tuple>
 
 #include "SurrogatePair.h"
 
 
+/**
+ * @brief Merges an erase and the insert made right after it at the same start into one edit.
+ *
+ * The erase leaves the start of its range where it was, so the insert starts at the very same
+ * offset: the erase brings the old end, the insert the new one.
+ *
+ * @param erase_edit The edit of the erase.
+ * @param insert_edit The edit of the insert that followed it.
+ * @return A BufferEdit covering both, for the incremental re-parse.
+ */
+static BufferEdit combineEdits(const BufferEdit &erase_edit, const BufferEdit &insert_edit) {
+    return BufferEdit{
+        .start_byte = erase_edit.start_byte,
+        .old_end_byte = erase_edit.old_end_byte,
+        .new_end_byte = insert_edit.new_end_byte,
+        .start = erase_edit.start,
+        .old_end = erase_edit.old_end,
+        .new_end = insert_edit.new_end
+    };
+}
+
 /**
  * @brief Applies a stored replacement to the buffer and describes it as one edit.
  *
@@ -40,19 +62,178 @@
 static BufferEdit replaceRange(TextBuffer &buffer, const BufferEdit::Position &start, const std::u16string_view remove, const std::u16string_view insert) {
     const auto end = advancePosition(start, remove);
 
-    // The two halves carry the offsets and the points of the combined edit: the erase leaves the
-    // start of the range where it was, so the insert that follows starts at the very same offset.
     const auto &erase_edit = buffer.erase(start.line, start.column, end.line, end.column);
     const auto &insert_edit = buffer.insert(start.line, start.column, insert);
+    return combineEdits(erase_edit, insert_edit);
+}
 
-    return BufferEdit{
-        .start_byte = erase_edit.start_byte,
-        .old_end_byte = erase_edit.old_end_byte,
-        .new_end_byte = insert_edit.new_end_byte,
-        .start = erase_edit.start,
-        .old_end = erase_edit.old_end,
-        .new_end = insert_edit.new_end
+/**
+ * @brief Rewrites a buffer into a text, replacing only the part that differs.
+ *
+ * The common prefix and suffix are found by reading the lines in place, so neither side is copied
+ * and the edit spans only what differs. Byte offsets count two bytes per code unit, line breaks
+ * included, as the buffers do.
+ *
+ * @param buffer The buffer to rewrite.
+ * @param text The text the buffer must hold afterwards.
+ * @return The edit turning the buffer into the text.
+ */
+static BufferEdit restoreText(TextBuffer &buffer, const std::u16string_view text) {
+    // Whole equal lines first, then the columns of the first line that differs
+    auto line = uint32_t{0};
+    auto offset = std::size_t{0};
+    auto column = uint32_t{0};
+    while (true) {
+        const auto current = buffer.getString(line);
+        const auto line_break = text.find(u'\n', offset);
+        const auto wanted = text.substr(offset, line_break == std::u16string_view::npos ? std::u16string_view::npos : line_break - offset);
+        if (current == wanted && line + 1 < buffer.getStringCount() && line_break != std::u16string_view::npos) {
+            offset = line_break + 1;
+            ++line;
+            continue;
+        }
+        column = static_cast<uint32_t>(std::ranges::mismatch(current, wanted).in1 - current.begin());
+        offset += column;
+        break;
+    }
+    const auto start = BufferEdit::Position{.line = line, .column = column};
+
+    // Then backwards from both ends, never past the prefix on either side
+    auto end_line = buffer.getStringCount() - 1;
+    auto end_text = buffer.getString(end_line);
+    auto end_column = static_cast<uint32_t>(end_text.length());
+    const auto size = buffer.getByteOffset(end_line, end_column) / sizeof(char16_t);
+    auto text_end = text.size();
+    for (auto limit = std::min(size, text.size()) - offset; limit > 0 && (end_column == 0 ? u'\n' : end_text[end_column - 1]) == text[text_end - 1]; --limit) {
+        if (end_column == 0) {
+            end_text = buffer.getString(--end_line);
+            end_column = static_cast<uint32_t>(end_text.length());
+        } else {
+            --end_column;
+        }
+        --text_end;
+    }
+
+    const auto &erase_edit = buffer.erase(start.line, start.column, end_line, end_column);
+    const auto &insert_edit = buffer.insert(start.line, start.column, text.substr(offset, text_end - offset));
+    return combineEdits(erase_edit, insert_edit);
+}
+
+/**
+ * @brief Tells whether a group holds edits that apply as one buffer splice.
+ *
+ * commitBatch() records its edits from the last one in the buffer to the first, so each one ends
+ * before the one recorded just before it starts: replayed in turn, none of them moves the others,
+ * and they describe the very change applying them all at once does. A group recorded by typing
+ * rarely lines up that way; when one does, both readings still agree.
+ *
+ * @param history The history holding the text of the group.
+ * @param group The group to look at.
+ * @return true when the group holds several edits laid out that way.
+ */
+static bool isSpliceable(const UndoHistory &history, const UndoHistory::Group &group) {
+    if (group.edits.size() < 2) {
+        return false;
+    }
+
+    for (auto it = group.edits.begin() + 1; it != group.edits.end(); ++it) {
+        const auto end = advancePosition(it->start, history.text(it->removed));
+        const auto &next = std::prev(it)->start;
+        if (std::tie(end.line, end.column) > std::tie(next.line, next.column)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Moves a position past the ordered edits before it.
+ *
+ * Only the last of them matters: the end of the range it replaced, before and after the change,
+ * is what every position after it moves with. A position on the line that range ended on keeps
+ * its distance to that end; one further down only follows the line count.
+ *
+ * @param position The position, before the edits.
+ * @param oldEnd The end of the range the previous edit replaced, before the change.
+ * @param newEnd The end of the text the previous edit put in, after the change.
+ * @return The position after the edits.
+ */
+static BufferEdit::Position shiftPosition(const BufferEdit::Position &position, const BufferEdit::Position &oldEnd, const BufferEdit::Position &newEnd) {
+    if (position.line == oldEnd.line) {
+        return {.line = newEnd.line, .column = newEnd.column + (position.column - oldEnd.column)};
+    }
+    return {.line = position.line + newEnd.line - oldEnd.line, .column = position.column};
+}
+
+/**
+ * @brief Widens an edit so it also covers the edit made right after it.
+ *
+ * The result spans the union of both ranges, so it may take in text neither changed, but it turns
+ * the text before the first edit into the text after the second. A position past the end of the
+ * first edit moves with that end, which is how the second edit's end is mapped back to the text
+ * before both.
+ *
+ * @param merged The first edit, widened in place.
+ * @param next The edit made after it, in the coordinates of the text the first one left.
+ */
+static void mergeEdit(BufferEdit &merged, const BufferEdit &next) {
+    const auto before = [](const BufferEdit::Position &left, const BufferEdit::Position &right) {
+        return std::tie(left.line, left.column) < std::tie(right.line, right.column);
     };
+
+    if (next.start_byte < merged.start_byte) {
+        merged.start_byte = next.start_byte;
+        merged.start = next.start;
+    }
+    if (before(merged.new_end, next.old_end)) {
+        merged.old_end = shiftPosition(next.old_end, merged.new_end, merged.old_end);
+        merged.old_end_byte = next.old_end_byte - merged.new_end_byte + merged.old_end_byte;
+        merged.new_end = next.new_end;
+        merged.new_end_byte = next.new_end_byte;
+    } else {
+        merged.new_end = shiftPosition(merged.new_end, next.old_end, next.new_end);
+        merged.new_end_byte = merged.new_end_byte - next.old_end_byte + next.new_end_byte;
+    }
+}
+
+/**
+ * @brief Returns the range a caret selects, start before end.
+ * @param caret The caret.
+ * @return The range between the anchor and the position, empty at the position when they meet.
+ */
+static TextRange rangeOf(const Cursor::Caret &caret) {
+    const auto &[start, end] = std::minmax(caret.anchor, caret.position, [](const auto &a, const auto &b) {
+        return std::tie(a.line, a.column) < std::tie(b.line, b.column);
+    });
+    return {.line_start = start.line, .column_start = start.column, .line_end = end.line, .column_end = end.column};
+}
+
+/**
+ * @brief Tells whether two carets get in each other's way.
+ *
+ * They do when they stand at the same place or start at the same place, or when one starts inside
+ * what the other selects: a caret right at the end of a selection can stay, the two edits would
+ * not overlap.
+ *
+ * @param a One caret.
+ * @param b The other caret.
+ * @return true when the carets must be merged.
+ */
+static bool collides(const Cursor::Caret &a, const Cursor::Caret &b) {
+    if (a.position.line == b.position.line && a.position.column == b.position.column) {
+        return true;
+    }
+
+    const auto a_range = rangeOf(a);
+    const auto b_range = rangeOf(b);
+    const auto a_start = std::tie(a_range.line_start, a_range.column_start);
+    const auto b_start = std::tie(b_range.line_start, b_range.column_start);
+    if (a_start == b_start) {
+        return true;
+    }
+    return a_start < b_start
+        ? b_start < std::tie(a_range.line_end, a_range.column_end)
+        : a_start < std::tie(b_range.line_end, b_range.column_end);
 }
 
 Cursor::Cursor(std::unique_ptr<TextBuffer> buffer)
@@ -62,42 +243,61 @@ Cursor::Cursor(std::unique_ptr<TextBuffer> buffer)
       m_line(0),
       m_is_selection_active(false),
       m_selected_line_start(0),
-      m_selected_column_start(0) {}
+      m_selected_column_start(0),
+      m_batch_open(false),
+      m_read_gate(std::make_shared<ReadGate>()) {}
+
+Cursor::~Cursor() {
+    (void) m_read_gate->lockForEdit();
+}
+
+std::shared_ptr<ReadGate> Cursor::getReadGate() const {
+    return m_read_gate;
+}
+
+Cursor::BufferEditAccess Cursor::editBuffer() const {
+    return BufferEditAccess{
+        .lock = m_read_gate->lockForEdit(),
+        .buffer = m_buffer.get()
+    };
+}
 
 void Cursor::pageUp(const uint32_t lineCount) {
     m_history.markBoundary();
+    forEachCaret([this, lineCount] {
+        // Don't go before 0
+        if (m_line > lineCount) {
+            m_line -= lineCount;
+        } else {
+            m_line = 0;
+        }
 
-    // Don't go before 0
-    if (m_line > lineCount) {
-        m_line -= lineCount;
-    } else {
-        m_line = 0;
-    }
-
-    const auto cursor_string_length = static_cast<uint32_t>(m_buffer->getString(m_line).length());
-    if (m_column > cursor_string_length) {
-        m_column = cursor_string_length;
-    }
-    m_column = snapColumnOnLine(m_line, m_column);
+        const auto cursor_string_length = static_cast<uint32_t>(m_buffer->getString(m_line).length());
+        if (m_column > cursor_string_length) {
+            m_column = cursor_string_length;
+        }
+        m_column = snapColumnOnLine(m_line, m_column);
+    });
 }
 
 void Cursor::pageDown(const uint32_t lineCount) {
     m_history.markBoundary();
+    forEachCaret([this, lineCount] {
+        // Don't go after the end
+        const auto cursor_line_count = m_buffer->getStringCount() - 1;
+        const auto cursor_new_line = m_line + lineCount;
+        if (cursor_new_line > cursor_line_count) {
+            m_line = cursor_line_count;
+        } else {
+            m_line = cursor_new_line;
+        }
 
-    // Don't go after the end
-    const auto cursor_line_count = m_buffer->getStringCount() - 1;
-    const auto cursor_new_line = m_line + lineCount;
-    if (cursor_new_line > cursor_line_count) {
-        m_line = cursor_line_count;
-    } else {
-        m_line = cursor_new_line;
-    }
-
-    const auto cursor_string_length = static_cast<uint32_t>(m_buffer->getString(m_line).length());
-    if (m_column > cursor_string_length) {
-        m_column = cursor_string_length;
-    }
-    m_column = snapColumnOnLine(m_line, m_column);
+        const auto cursor_string_length = static_cast<uint32_t>(m_buffer->getString(m_line).length());
+        if (m_column > cursor_string_length) {
+            m_column = cursor_string_length;
+        }
+        m_column = snapColumnOnLine(m_line, m_column);
+    });
 }
 
 void Cursor::setName(const std::string_view name) {
@@ -126,6 +326,11 @@ void Cursor::setModified(const bool modified) {
         m_history.markUnsaved();
     } else {
         m_history.markSaved();
+
+        // The disk holds every edit now: there is nothing left to recover
+        if (m_swap) {
+            m_swap->rebase();
+        }
     }
 }
 
@@ -171,6 +376,10 @@ uint32_t Cursor::getLineCount() const {
     return m_buffer->getStringCount();
 }
 
+uint32_t Cursor::getContiguousLineCount(const uint32_t line) const {
+    return m_buffer->getContiguousLineCount(line);
+}
+
 uint32_t Cursor::getLongestLineLength(const uint32_t tabWeight) const {
     return m_buffer->getLongestLineLength(tabWeight);
 }
@@ -209,87 +418,99 @@ std::optional<std::vector<std::u16string_view>> Cursor::getSelectedText() const
 
 void Cursor::moveLeft() {
     m_history.markBoundary();
-
-    if (m_column == 0) {
-        // At the very beginning of a line, the cursor can't go left
-        if (m_line > 0) {
-            // The cursor can go above instead
-            m_column = static_cast<uint32_t>(m_buffer->getString(m_line - 1).length());
-            --m_line;
+    forEachCaret([this] {
+        if (m_column == 0) {
+            // At the very beginning of a line, the cursor can't go left
+            if (m_line > 0) {
+                // The cursor can go above instead
+                m_column = static_cast<uint32_t>(m_buffer->getString(m_line - 1).length());
+                --m_line;
+            }
+        } else {
+            m_column -= charLengthBefore(m_buffer->getString(m_line), m_column);
         }
-    } else {
-        m_column -= charLengthBefore(m_buffer->getString(m_line), m_column);
-    }
+    });
 }
 
 void Cursor::moveRight() {
     m_history.markBoundary();
-
-    if (m_column == m_buffer->getString(m_line).length()) {
-        // At the very end of a line, the cursor can't go right
-        if (m_line < m_buffer->getStringCount() - 1) {
-            // The cursor can go below instead
-            m_column = 0;
-            ++m_line;
+    forEachCaret([this] {
+        if (m_column == m_buffer->getString(m_line).length()) {
+            // At the very end of a line, the cursor can't go right
+            if (m_line < m_buffer->getStringCount() - 1) {
+                // The cursor can go below instead
+                m_column = 0;
+                ++m_line;
+            }
+        } else {
+            m_column += charLengthAfter(m_buffer->getString(m_line), m_column);
         }
-    } else {
-        m_column += charLengthAfter(m_buffer->getString(m_line), m_column);
-    }
+    });
 }
 
 void Cursor::moveUp() {
     m_history.markBoundary();
-
-    if (m_line > 0) {
-        const auto string_above_length = static_cast<uint32_t>(m_buffer->getString(m_line - 1).length());
-        if (m_column > string_above_length) {
-            m_column = string_above_length;
+    forEachCaret([this] {
+        if (m_line > 0) {
+            const auto string_above_length = static_cast<uint32_t>(m_buffer->getString(m_line - 1).length());
+            if (m_column > string_above_length) {
+                m_column = string_above_length;
+            }
+            m_column = snapColumnOnLine(m_line - 1, m_column);
+            --m_line;
+        } else {
+            m_column = 0;
         }
-        m_column = snapColumnOnLine(m_line - 1, m_column);
-        --m_line;
-    } else {
-        m_column = 0;
-    }
+    });
 }
 
 void Cursor::moveDown() {
     m_history.markBoundary();
-
-    if (m_line < m_buffer->getStringCount() - 1) {
-        const auto string_below_length = static_cast<uint32_t>(m_buffer->getString(m_line + 1).length());
-        if (m_column > string_below_length) {
-            // The cursor can't stay at the same X position, put it at the end of the next line
-            m_column = string_below_length;
+    forEachCaret([this] {
+        if (m_line < m_buffer->getStringCount() - 1) {
+            const auto string_below_length = static_cast<uint32_t>(m_buffer->getString(m_line + 1).length());
+            if (m_column > string_below_length) {
+                // The cursor can't stay at the same X position, put it at the end of the next line
+                m_column = string_below_length;
+            }
+            m_column = snapColumnOnLine(m_line + 1, m_column);
+            ++m_line;
+        } else {
+            m_column = static_cast<uint32_t>(m_buffer->getString(m_line).length());
         }
-        m_column = snapColumnOnLine(m_line + 1, m_column);
-        ++m_line;
-    } else {
-        m_column = static_cast<uint32_t>(m_buffer->getString(m_line).length());
-    }
+    });
 }
 
 void Cursor::moveToStartOfLine() {
     m_history.markBoundary();
-    m_column = 0;
+    forEachCaret([this] {
+        m_column = 0;
+    });
 }
 
 void Cursor::moveToEndOfLine() {
     m_history.markBoundary();
-    m_column = static_cast<uint32_t>(m_buffer->getString(m_line).length());
+    forEachCaret([this] {
+        m_column = static_cast<uint32_t>(m_buffer->getString(m_line).length());
+    });
 }
 
 void Cursor::moveToStartOfFile() {
     m_history.markBoundary();
-    m_line = 0;
-    m_column = 0;
+    forEachCaret([this] {
+        m_line = 0;
+        m_column = 0;
+    });
 }
 
 void Cursor::moveToEndOfFile() {
     m_history.markBoundary();
-    const auto string_count = m_buffer->getStringCount() - 1;
-    const auto string_length = static_cast<uint32_t>(m_buffer->getString(string_count).length());
-    m_line = string_count;
-    m_column = string_length;
+    forEachCaret([this] {
+        const auto string_count = m_buffer->getStringCount() - 1;
+        const auto string_length = static_cast<uint32_t>(m_buffer->getString(string_count).length());
+        m_line = string_count;
+        m_column = string_length;
+    });
 }
 
 void Cursor::activateSelection(const bool active) {
@@ -301,6 +522,13 @@ void Cursor::activateSelection(const bool active) {
         m_is_selection_active = false;
         m_selected_line_start = 0;
         m_selected_column_start = 0;
+    } else {
+        return;
+    }
+
+    // The extra carets start or drop their selections along with the main one
+    for (auto &caret : m_carets) {
+        caret.anchor = caret.position;
     }
 }
 
@@ -315,16 +543,19 @@ void Cursor::setPosition(const uint32_t line, const uint32_t column) {
 
     m_column = snapColumnOnLine(line, column);
     m_line = line;
+    clearCarets();
 }
 
 BufferEdit Cursor::insert(const std::u16string_view characters) {
+    clearCarets();
     const auto cursor_before = position();
     const auto previous_line = m_line;
-    const auto &edit = m_buffer->insert(m_line, m_column, characters);
+    const auto &edit = editBuffer()->insert(m_line, m_column, characters);
     m_line = edit.new_end.line;
     m_column = edit.new_end.column;
 
-    m_history.record(UndoHistory::Edit{.start = edit.start, .removed = {}, .inserted = std::u16string(characters)}, cursor_before, position());
+    m_history.record(edit.start, {}, characters, cursor_before, position());
+    journal(edit, characters);
 
     if (m_line != previous_line) {
         m_history.markBoundary();
@@ -333,16 +564,18 @@ BufferEdit Cursor::insert(const std::u16string_view characters) {
 }
 
 BufferEdit Cursor::erase(const uint32_t lineStart, const uint32_t columnStart, const uint32_t lineEnd, const uint32_t columnEnd) const {
-    return m_buffer->erase(lineStart, columnStart, lineEnd, columnEnd);
+    return editBuffer()->erase(lineStart, columnStart, lineEnd, columnEnd);
 }
 
 BufferEdit Cursor::newLine() {
+    clearCarets();
     const auto cursor_before = position();
-    const auto &edit = m_buffer->insert(m_line, m_column, u"\n");
+    const auto &edit = editBuffer()->insert(m_line, m_column, u"\n");
     m_line = edit.new_end.line;
     m_column = edit.new_end.column;
 
-    m_history.record(UndoHistory::Edit{.start = edit.start, .removed = {}, .inserted = u"\n"}, cursor_before, position());
+    m_history.record(edit.start, {}, u"\n", cursor_before, position());
+    journal(edit, u"\n");
 
     // The cursor always changes line
     m_history.markBoundary();
@@ -350,15 +583,17 @@ BufferEdit Cursor::newLine() {
 }
 
 std::optional<BufferEdit> Cursor::eraseLeft() {
+    clearCarets();
     if (m_column > 0) {
         // We can erase on the left since column > 0
         const auto cursor_before = position();
             const auto erased_column = m_column - charLengthBefore(m_buffer->getString(m_line), m_column);
-        auto removed = textInRange(m_line, erased_column, m_line, m_column);
-        const auto &edit = m_buffer->erase(m_line, m_column, m_line, erased_column);
+        const auto removed = textInRange(m_line, erased_column, m_line, m_column);
+        const auto &edit = editBuffer()->erase(m_line, m_column, m_line, erased_column);
         m_column = edit.new_end.column;
 
-        m_history.record(UndoHistory::Edit{.start = edit.start, .removed = std::move(removed), .inserted = {}}, cursor_before, position());
+        m_history.record(edit.start, removed, {}, cursor_before, position());
+        journal(edit, {});
         return edit;
     }
 
@@ -366,12 +601,13 @@ std::optional<BufferEdit> Cursor::eraseLeft() {
         // We can't erase left because column = 0, so we move the remainder of this line to the end of the line above
         const auto cursor_before = position();
             const auto string_above_length = static_cast<uint32_t>(m_buffer->getString(m_line - 1).length());
-        auto removed = textInRange(m_line - 1, string_above_length, m_line, m_column);
-        const auto &edit =  m_buffer->erase(m_line, m_column, m_line - 1, string_above_length);
+        const auto removed = textInRange(m_line - 1, string_above_length, m_line, m_column);
+        const auto &edit =  editBuffer()->erase(m_line, m_column, m_line - 1, string_above_length);
         m_line = edit.new_end.line;
         m_column = edit.new_end.column;
 
-        m_history.record(UndoHistory::Edit{.start = edit.start, .removed = std::move(removed), .inserted = {}}, cursor_before, position());
+        m_history.record(edit.start, removed, {}, cursor_before, position());
+        journal(edit, {});
 
         // The cursor always changes line
         m_history.markBoundary();
@@ -382,24 +618,27 @@ std::optional<BufferEdit> Cursor::eraseLeft() {
 }
 
 std::optional<BufferEdit> Cursor::eraseRight() {
+    clearCarets();
     if (m_column < m_buffer->getString(m_line).length()) {
         // We can erase on the right since column < string_length
         const auto cursor_before = position();
             const auto erased_column = m_column + charLengthAfter(m_buffer->getString(m_line), m_column);
-        auto removed = textInRange(m_line, m_column, m_line, erased_column);
-        const auto &edit = m_buffer->erase(m_line, m_column, m_line, erased_column);
+        const auto removed = textInRange(m_line, m_column, m_line, erased_column);
+        const auto &edit = editBuffer()->erase(m_line, m_column, m_line, erased_column);
 
-        m_history.record(UndoHistory::Edit{.start = edit.start, .removed = std::move(removed), .inserted = {}}, cursor_before, position());
+        m_history.record(edit.start, removed, {}, cursor_before, position());
+        journal(edit, {});
         return edit;
     }
 
     if (m_line < m_buffer->getStringCount() - 1) {
         // We can't erase right because column >= string_length, so we move the line below and append it to this line
         const auto cursor_before = position();
-            auto removed = textInRange(m_line, m_column, m_line + 1, 0);
-        const auto &edit = m_buffer->erase(m_line, m_column, m_line + 1, 0);
+            const auto removed = textInRange(m_line, m_column, m_line + 1, 0);
+        const auto &edit = editBuffer()->erase(m_line, m_column, m_line + 1, 0);
 
-        m_history.record(UndoHistory::Edit{.start = edit.start, .removed = std::move(removed), .inserted = {}}, cursor_before, position());
+        m_history.record(edit.start, removed, {}, cursor_before, position());
+        journal(edit, {});
         return edit;
     }
 
@@ -407,6 +646,7 @@ std::optional<BufferEdit> Cursor::eraseRight() {
 }
 
 std::optional<BufferEdit> Cursor::eraseSelection() {
+    clearCarets();
     const auto &range = getSelectedRange();
     if (!range) {
         // No selection, or a degenerate one: nothing to erase, nothing to record.
@@ -416,14 +656,17 @@ std::optional<BufferEdit> Cursor::eraseSelection() {
         return std::nullopt;
     }
 
+    // A selection can be most of a large buffer: the buffer hands its text over rather than a copy,
+    // and the history adopts it as it is
     const auto cursor_before = position();
     const auto previous_line = m_line;
-    auto removed = textInRange(range->line_start, range->column_start, range->line_end, range->column_end);
-    const auto &edit = m_buffer->erase(range->line_start, range->column_start, range->line_end, range->column_end);
+    auto removed = std::u16string{};
+    const auto &edit = editBuffer()->extract(range->line_start, range->column_start, range->line_end, range->column_end, removed);
     m_line = edit.new_end.line;
     m_column = edit.new_end.column;
 
-    m_history.record(UndoHistory::Edit{.start = edit.start, .removed = std::move(removed), .inserted = {}}, cursor_before, position());
+    m_history.recordShared(edit.start, std::make_shared<const std::u16string>(std::move(removed)), {}, cursor_before, position());
+    journal(edit, {});
 
     if (m_line != previous_line) {
         m_history.markBoundary();
@@ -431,6 +674,365 @@ std::optional<BufferEdit> Cursor::eraseSelection() {
     return edit;
 }
 
+BufferEdit Cursor::replace(const TextRange &range, const std::u16string_view characters) {
+    // A group of its own, whatever was typed before or is typed next
+    m_history.markBoundary();
+    clearCarets();
+    activateSelection(false);
+
+    const auto cursor_before = position();
+    auto removed = std::u16string{};
+    const auto edit = [&] {
+        // Both halves under one hold of the read gate, as a single edit
+        const auto buffer = editBuffer();
+        const auto &erase_edit = buffer->extract(range.line_start, range.column_start, range.line_end, range.column_end, removed);
+        return combineEdits(erase_edit, buffer->insert(erase_edit.start.line, erase_edit.start.column, characters));
+    }();
+    m_line = edit.new_end.line;
+    m_column = edit.new_end.column;
+
+    m_history.recordShared(edit.start, std::make_shared<const std::u16string>(std::move(removed)), characters, cursor_before, position());
+    journal(edit, characters);
+    m_history.markBoundary();
+    return edit;
+}
+
+void Cursor::beginBatch() {
+    m_batch.clear();
+    m_batch_text.clear();
+    m_batch_open = true;
+}
+
+void Cursor::batchReplace(const TextRange &range, const std::u16string_view characters) {
+    if (!m_batch_open) {
+        throw std::runtime_error("Cursor::batchReplace without an open batch.");
+    }
+
+    const auto starts_after_previous = m_batch.empty()
+        || std::tie(range.line_start, range.column_start) >= std::tie(m_batch.back().range.line_end, m_batch.back().range.column_end);
+    if (!starts_after_previous || std::tie(range.line_start, range.column_start) > std::tie(range.line_end, range.column_end)) {
+        throw std::runtime_error("Cursor::batchReplace out of order.");
+    }
+
+    if (range.line_end >= m_buffer->getStringCount() || range.column_end > m_buffer->getString(range.line_end).length()
+        || range.column_start > m_buffer->getString(range.line_start).length()) {
+        throw std::runtime_error("Cursor::batchReplace out of range.");
+    }
+
+    m_batch.emplace_back(BatchEdit{.range = range, .text_begin = m_batch_text.length(), .text_length = characters.length()});
+    m_batch_text.append(characters);
+}
+
+std::optional<BufferEdit> Cursor::commitBatch() {
+    m_batch_open = false;
+    clearCarets();
+    if (m_batch.empty()) {
+        return std::nullopt;
+    }
+
+    // A group of its own, whatever was typed before or is typed next
+    m_history.markBoundary();
+    activateSelection(false);
+    const auto cursor_before = position();
+
+    // The replaced pieces are read before the splice moves anything, all into one string
+    auto removed = std::u16string{};
+    auto removed_ends = std::vector<std::size_t>{};
+    auto splices = std::vector<BufferSplice>{};
+    removed_ends.reserve(m_batch.size());
+    splices.reserve(m_batch.size());
+    for (const auto &[range, text_begin, text_length] : m_batch) {
+        if (range.line_start == range.line_end) {
+            removed.append(m_buffer->getString(range.line_start).substr(range.column_start, range.column_end - range.column_start));
+        } else {
+            removed.append(textInRange(range.line_start, range.column_start, range.line_end, range.column_end));
+        }
+        removed_ends.push_back(removed.length());
+        splices.emplace_back(BufferSplice{
+            .start = {.line = range.line_start, .column = range.column_start},
+            .end = {.line = range.line_end, .column = range.column_end},
+            .text = std::u16string_view(m_batch_text).substr(text_begin, text_length)
+        });
+    }
+
+    const auto edit = editBuffer()->splice(splices);
+    m_line = edit.new_end.line;
+    m_column = edit.new_end.column;
+
+    // Recorded from the last replacement to the first: the coordinates of each one then still hold
+    // when the group is replayed edit by edit, which is how the swap journal replays it too
+    for (auto i = m_batch.size(); i-- > 0;) {
+        const auto removed_begin = i == 0 ? 0 : removed_ends[i - 1];
+        const auto removed_text = std::u16string_view(removed).substr(removed_begin, removed_ends[i] - removed_begin);
+        const auto &splice = splices[i];
+        m_history.record(splice.start, removed_text, splice.text, cursor_before, position());
+
+        // The swap journal only reads where the replaced range lies
+        journal(BufferEdit{
+            .start_byte = 0,
+            .old_end_byte = 0,
+            .new_end_byte = 0,
+            .start = splice.start,
+            .old_end = splice.end,
+            .new_end = splice.start
+        }, splice.text);
+    }
+    m_history.markBoundary();
+
+    // Whatever a large batch queued goes with it
+    m_batch = {};
+    m_batch_text = {};
+    return edit;
+}
+
+Cursor::Caret Cursor::mainCaret() const {
+    const auto anchor = m_is_selection_active
+        ? BufferEdit::Position{.line = m_selected_line_start, .column = m_selected_column_start}
+        : position();
+    return {.position = position(), .anchor = anchor};
+}
+
+void Cursor::forEachCaret(const std::function<void()> &move) {
+    if (!m_carets.empty()) {
+        const auto main_caret = mainCaret();
+        for (auto &caret : m_carets) {
+            m_line = caret.position.line;
+            m_column = caret.position.column;
+            m_selected_line_start = caret.anchor.line;
+            m_selected_column_start = caret.anchor.column;
+            move();
+            caret = mainCaret();
+        }
+        m_line = main_caret.position.line;
+        m_column = main_caret.position.column;
+        m_selected_line_start = main_caret.anchor.line;
+        m_selected_column_start = main_caret.anchor.column;
+    }
+
+    move();
+    mergeCarets();
+}
+
+void Cursor::mergeCarets() {
+    if (m_carets.empty()) {
+        return;
+    }
+
+    std::ranges::sort(m_carets, [](const Caret &a, const Caret &b) {
+        const auto a_range = rangeOf(a);
+        const auto b_range = rangeOf(b);
+        return std::tie(a_range.line_start, a_range.column_start) < std::tie(b_range.line_start, b_range.column_start);
+    });
+
+    // Sorted by start, a caret can only meet the last one kept before it, or the main one
+    const auto main_caret = mainCaret();
+    auto kept = m_carets.begin();
+    for (auto it = m_carets.begin(); it != m_carets.end(); ++it) {
+        if (collides(*it, main_caret) || (kept != m_carets.begin() && collides(*std::prev(kept), *it))) {
+            continue;
+        }
+        *kept++ = *it;
+    }
+    m_carets.erase(kept, m_carets.end());
+}
+
+std::vector<Cursor::Caret> Cursor::allCarets(std::size_t &mainIndex) const {
+    const auto main_caret = mainCaret();
+    const auto main_range = rangeOf(main_caret);
+    const auto next = std::ranges::lower_bound(m_carets, std::make_tuple(main_range.line_start, main_range.column_start), {}, [](const Caret &caret) {
+        const auto range = rangeOf(caret);
+        return std::make_tuple(range.line_start, range.column_start);
+    });
+    mainIndex = static_cast<std::size_t>(next - m_carets.begin());
+
+    auto carets = std::vector<Caret>{};
+    carets.reserve(m_carets.size() + 1);
+    carets.insert(carets.end(), m_carets.begin(), next);
+    carets.push_back(main_caret);
+    carets.insert(carets.end(), next, m_carets.end());
+    return carets;
+}
+
+std::optional<BufferEdit> Cursor::editAtCarets(std::vector<TextRange> &ranges, const std::size_t mainIndex, const std::u16string_view characters) {
+    beginBatch();
+    auto previous_end = BufferEdit::Position{.line = 0, .column = 0};
+    for (auto &range : ranges) {
+        if (std::tie(range.line_start, range.column_start) < std::tie(previous_end.line, previous_end.column)) {
+            range.line_start = previous_end.line;
+            range.column_start = previous_end.column;
+            if (std::tie(range.line_end, range.column_end) < std::tie(previous_end.line, previous_end.column)) {
+                range.line_end = previous_end.line;
+                range.column_end = previous_end.column;
+            }
+        }
+        if (range.line_start != range.line_end || range.column_start != range.column_end || !characters.empty()) {
+            batchReplace(range, characters);
+        }
+        previous_end = {.line = range.line_end, .column = range.column_end};
+    }
+    const auto edit = commitBatch();
+
+    // Each caret lands at the end of its text, moved by the replacements before it
+    auto landed = std::vector<Caret>{};
+    landed.reserve(ranges.size() - 1);
+    auto old_end = BufferEdit::Position{.line = 0, .column = 0};
+    auto new_end = old_end;
+    for (auto i = std::size_t{0}; i < ranges.size(); ++i) {
+        const auto &range = ranges[i];
+        const auto start = shiftPosition({.line = range.line_start, .column = range.column_start}, old_end, new_end);
+        const auto is_replaced = range.line_start != range.line_end || range.column_start != range.column_end || !characters.empty();
+        old_end = {.line = range.line_end, .column = range.column_end};
+        new_end = is_replaced ? advancePosition(start, characters) : start;
+
+        if (i == mainIndex) {
+            m_line = new_end.line;
+            m_column = new_end.column;
+        } else {
+            landed.emplace_back(Caret{.position = new_end, .anchor = new_end});
+        }
+    }
+    m_carets = std::move(landed);
+    mergeCarets();
+    return edit;
+}
+
+uint32_t Cursor::getCaretCount() const {
+    return static_cast<uint32_t>(m_carets.size()) + 1;
+}
+
+const std::vector<Cursor::Caret> &Cursor::getCarets() const {
+    return m_carets;
+}
+
+bool Cursor::addCaretAtNextMatch() {
+    const auto &range = getSelectedRange();
+    if (!range || range->line_start != range->line_end) {
+        return false;
+    }
+
+    // Looked for from the end of the main selection on, wrapping around the end of the buffer: the
+    // last line looked at is the one of the main selection, from its start
+    const auto needle = std::u16string(m_buffer->getString(range->line_start).substr(range->column_start, range->column_end - range->column_start));
+    const auto main_caret = mainCaret();
+    const auto line_count = m_buffer->getStringCount();
+    auto line = range->line_end;
+    auto from = static_cast<std::size_t>(range->column_end);
+    for (auto lap = uint32_t{0}; lap <= line_count; ++lap) {
+        const auto string = m_buffer->getString(line);
+        for (auto column = string.find(needle, from); column != std::u16string_view::npos; column = string.find(needle, column + 1)) {
+            const auto match = Caret{
+                .position = {.line = line, .column = static_cast<uint32_t>(column + needle.length())},
+                .anchor = {.line = line, .column = static_cast<uint32_t>(column)}
+            };
+            if (collides(match, main_caret)) {
+                // Back to the main selection: every occurrence holds a caret
+                return false;
+            }
+
+            // The carets ending before the occurrence are out of its way, the first ones after are checked
+            auto next = std::ranges::lower_bound(m_carets, std::make_tuple(line, static_cast<uint32_t>(column)), {}, [](const Caret &caret) {
+                const auto caret_range = rangeOf(caret);
+                return std::make_tuple(caret_range.line_end, caret_range.column_end);
+            });
+            auto is_taken = false;
+            for (; next != m_carets.end() && !is_taken; ++next) {
+                const auto caret_range = rangeOf(*next);
+                if (std::tie(caret_range.line_start, caret_range.column_start) > std::tie(match.position.line, match.position.column)) {
+                    break;
+                }
+                is_taken = collides(*next, match);
+            }
+            if (is_taken) {
+                continue;
+            }
+
+            // The occurrence becomes the main selection, so the view follows the search
+            m_history.markBoundary();
+            m_carets.emplace_back(mainCaret());
+            m_selected_line_start = match.anchor.line;
+            m_selected_column_start = match.anchor.column;
+            m_line = match.position.line;
+            m_column = match.position.column;
+            mergeCarets();
+            return true;
+        }
+
+        line = line + 1 == line_count ? 0 : line + 1;
+        from = 0;
+    }
+    return false;
+}
+
+bool Cursor::addCaretsOnSelectedLines() {
+    const auto &range = getSelectedRange();
+    if (!range || range->line_start == range->line_end) {
+        return false;
+    }
+
+    m_history.markBoundary();
+    activateSelection(false);
+    clearCarets();
+
+    const auto last_line = range->column_end == 0 ? range->line_end - 1 : range->line_end;
+    m_carets.reserve(last_line - range->line_start);
+    for (auto line = range->line_start; line < last_line; ++line) {
+        const auto end = BufferEdit::Position{.line = line, .column = static_cast<uint32_t>(m_buffer->getString(line).length())};
+        m_carets.emplace_back(Caret{.position = end, .anchor = end});
+    }
+    m_line = last_line;
+    m_column = static_cast<uint32_t>(m_buffer->getString(last_line).length());
+    return true;
+}
+
+void Cursor::clearCarets() {
+    // Many carets can take a fair amount of memory, which goes with them
+    if (!m_carets.empty()) {
+        m_carets = {};
+    }
+}
+
+std::optional<BufferEdit> Cursor::insertAtCarets(const std::u16string_view characters) {
+    auto main_index = std::size_t{0};
+    const auto carets = allCarets(main_index);
+    auto ranges = std::vector<TextRange>{};
+    ranges.reserve(carets.size());
+    std::ranges::transform(carets, std::back_inserter(ranges), rangeOf);
+    return editAtCarets(ranges, main_index, characters);
+}
+
+std::optional<BufferEdit> Cursor::eraseAtCarets(const bool forward) {
+    auto main_index = std::size_t{0};
+    const auto carets = allCarets(main_index);
+
+    const auto last_line = m_buffer->getStringCount() - 1;
+    auto ranges = std::vector<TextRange>{};
+    ranges.reserve(carets.size());
+    for (const auto &caret : carets) {
+        auto range = rangeOf(caret);
+        if (range.line_start != range.line_end || range.column_start != range.column_end) {
+            // A selection goes whole, whichever way the erase goes
+            ranges.push_back(range);
+            continue;
+        }
+
+        const auto [line, column] = caret.position;
+        const auto string = m_buffer->getString(line);
+        if (!forward && column > 0) {
+            range.column_start = column - charLengthBefore(string, column);
+        } else if (!forward && line > 0) {
+            range.line_start = line - 1;
+            range.column_start = static_cast<uint32_t>(m_buffer->getString(line - 1).length());
+        } else if (forward && column < string.length()) {
+            range.column_end = column + charLengthAfter(string, column);
+        } else if (forward && line < last_line) {
+            range.line_end = line + 1;
+            range.column_end = 0;
+        }
+        ranges.push_back(range);
+    }
+    return editAtCarets(ranges, main_index, {});
+}
+
 std::vector<BufferEdit> Cursor::loadContent(const std::u16string_view content) {
     auto edits = std::vector<BufferEdit>{};
     edits.reserve(2);
@@ -438,7 +1040,9 @@ std::vector<BufferEdit> Cursor::loadContent(const std::u16string_view content) {
     // clear() already keeps itself out of the history; the insert goes straight to the buffer for
     // the same reason, so the file is never copied into a group
     edits.emplace_back(clear());
-    edits.emplace_back(m_buffer->insert(0, 0, content));
+    edits.emplace_back(editBuffer()->insert(0, 0, content));
+    journal(edits.front(), {});
+    journal(edits.back(), content);
 
     m_line = 0;
     m_column = 0;
@@ -446,6 +1050,13 @@ std::vector<BufferEdit> Cursor::loadContent(const std::u16string_view content) {
     return edits;
 }
 
+BufferEdit Cursor::appendContent(const std::u16string_view content) {
+    const auto last_line = m_buffer->getStringCount() - 1;
+    const auto &edit = editBuffer()->insert(last_line, static_cast<uint32_t>(m_buffer->getString(last_line).length()), content);
+    journal(edit, content);
+    return edit;
+}
+
 BufferEdit Cursor::clear() {
     // Close the current undo group; the wipe itself is intentionally not snapshotted,
     // callers replace the whole content afterwards and clear the history themselves.
@@ -455,12 +1066,13 @@ BufferEdit Cursor::clear() {
     m_column = 0;
     m_line = 0;
     m_name = "";
+    clearCarets();
 
     m_is_selection_active = false;
     m_selected_line_start = 0;
     m_selected_column_start = 0;
 
-    return m_buffer->clear();
+    return editBuffer()->clear();
 }
 
 std::u16string Cursor::textInRange(const uint32_t lineStart, const uint32_t columnStart, const uint32_t lineEnd, const uint32_t columnEnd) const {
@@ -513,10 +1125,18 @@ std::vector<BufferEdit> Cursor::undo() {
 
     // Reverting means walking the group backwards: each edit's coordinates describe the buffer as
     // it stood just before that edit, which is only true once the later ones are already undone.
+    if (isSpliceable(m_history, *group)) {
+        auto edits = std::vector<BufferEdit>{spliceGroup(*group, true)};
+        settleAfterHistoryStep(group->cursor_before);
+        return edits;
+    }
+
     auto edits = std::vector<BufferEdit>{};
     edits.reserve(group->edits.size());
     for (auto it = group->edits.rbegin(); it != group->edits.rend(); ++it) {
-        edits.emplace_back(replaceRange(*m_buffer, it->start, it->inserted, it->removed));
+        const auto restored = m_history.text(it->removed);
+        edits.emplace_back(replaceRange(*editBuffer(), it->start, m_history.text(it->inserted), restored));
+        journal(edits.back(), restored);
     }
 
     settleAfterHistoryStep(group->cursor_before);
@@ -529,20 +1149,77 @@ std::vector<BufferEdit> Cursor::redo() {
         return {};
     }
 
+    if (isSpliceable(m_history, *group)) {
+        auto edits = std::vector<BufferEdit>{spliceGroup(*group, false)};
+        settleAfterHistoryStep(group->cursor_after);
+        return edits;
+    }
+
     // Re-applying replays the group in its original order, the mirror image of undo
     auto edits = std::vector<BufferEdit>{};
     edits.reserve(group->edits.size());
     for (const auto &edit : group->edits) {
-        edits.emplace_back(replaceRange(*m_buffer, edit.start, edit.removed, edit.inserted));
+        const auto inserted = m_history.text(edit.inserted);
+        edits.emplace_back(replaceRange(*editBuffer(), edit.start, m_history.text(edit.removed), inserted));
+        journal(edits.back(), inserted);
     }
 
     settleAfterHistoryStep(group->cursor_after);
     return edits;
 }
 
+BufferEdit Cursor::spliceGroup(const UndoHistory::Group &group, const bool revert) {
+    // The buffer wants the edits in its own order, the reverse of the group's. Reverting, each
+    // inserted range sits where the edits before it pushed it.
+    auto splices = std::vector<BufferSplice>{};
+    splices.reserve(group.edits.size());
+    auto previous_old_end = BufferEdit::Position{.line = 0, .column = 0};
+    auto previous_new_end = previous_old_end;
+    for (auto it = group.edits.rbegin(); it != group.edits.rend(); ++it) {
+        const auto removed = m_history.text(it->removed);
+        const auto inserted = m_history.text(it->inserted);
+        if (!revert) {
+            splices.emplace_back(BufferSplice{.start = it->start, .end = advancePosition(it->start, removed), .text = inserted});
+            continue;
+        }
+
+        const auto start = shiftPosition(it->start, previous_old_end, previous_new_end);
+        previous_old_end = advancePosition(it->start, removed);
+        previous_new_end = advancePosition(start, inserted);
+        splices.emplace_back(BufferSplice{.start = start, .end = previous_new_end, .text = removed});
+    }
+
+    const auto edit = editBuffer()->splice(splices);
+
+    // Replayed one by one, a redo goes in the group's order and an undo the other way round; the
+    // swap journal only reads where each replaced range lies
+    if (m_swap) {
+        const auto journal_edit = [&](const UndoHistory::Edit &step) {
+            const auto removed = m_history.text(revert ? step.inserted : step.removed);
+            const auto inserted = m_history.text(revert ? step.removed : step.inserted);
+            journal(BufferEdit{
+                .start_byte = 0,
+                .old_end_byte = 0,
+                .new_end_byte = 0,
+                .start = step.start,
+                .old_end = advancePosition(step.start, removed),
+                .new_end = step.start
+            }, inserted);
+        };
+
+        if (revert) {
+            std::ranges::for_each(group.edits.rbegin(), group.edits.rend(), journal_edit);
+        } else {
+            std::ranges::for_each(group.edits, journal_edit);
+        }
+    }
+    return edit;
+}
+
 void Cursor::settleAfterHistoryStep(const BufferEdit::Position &caret) {
     m_line = caret.line;
     m_column = caret.column;
+    clearCarets();
     activateSelection(false);
     m_history.markBoundary();
 
@@ -550,10 +1227,147 @@ void Cursor::settleAfterHistoryStep(const BufferEdit::Position &caret) {
     // plain boolean, so the restore conservatively counts as a modification (accepted simplification).
 }
 
+std::optional<BufferEdit> Cursor::travel(const std::optional<uint64_t> target, const uint32_t steps) {
+    auto caret = std::optional<BufferEdit::Position>();
+    auto merged = std::optional<BufferEdit>();
+    const auto record = [&merged](const BufferEdit &edit) {
+        if (edit.old_end_byte == edit.start_byte && edit.new_end_byte == edit.start_byte) {
+            return;
+        }
+        if (merged) {
+            mergeEdit(*merged, edit);
+        } else {
+            merged = edit;
+        }
+    };
+
+    if (target) {
+        if (const auto *const checkpoint = m_history.findCheckpoint(*target)) {
+            // The buffer takes what differs from the checkpoint, then the history skips the groups
+            // it stands for
+            const auto checkpoint_id = checkpoint->id;
+            record(restoreText(*editBuffer(), checkpoint->text));
+            caret = m_history.walkTo(checkpoint_id);
+        }
+    }
+
+    // The groups left are replayed straight into the buffer: the edits they produce are folded
+    // into the single one describing the whole move
+    const auto step_back = [this, &caret, &record] {
+        const auto *const group = m_history.undo();
+        if (group == nullptr) {
+            return false;
+        }
+        for (auto it = group->edits.rbegin(); it != group->edits.rend(); ++it) {
+            record(replaceRange(*editBuffer(), it->start, m_history.text(it->inserted), m_history.text(it->removed)));
+        }
+        caret = group->cursor_before;
+        return true;
+    };
+    const auto step_forward = [this, &caret, &record] {
+        const auto *const group = m_history.redo();
+        if (group == nullptr) {
+            return false;
+        }
+        for (const auto &edit : group->edits) {
+            record(replaceRange(*editBuffer(), edit.start, m_history.text(edit.removed), m_history.text(edit.inserted)));
+        }
+        caret = group->cursor_after;
+        return true;
+    };
+
+    if (target) {
+        while (m_history.getState() > *target && step_back()) {}
+        while (m_history.getState() < *target && step_forward()) {}
+    } else {
+        for (auto step = 0u; step < steps && step_back(); ++step) {}
+    }
+
+    if (!caret) {
+        return std::nullopt;
+    }
+
+    // Groups that cancel out leave no edit at all: an empty one at the origin stands for them
+    const auto edit = merged.value_or(BufferEdit{
+        .start_byte = 0,
+        .old_end_byte = 0,
+        .new_end_byte = 0,
+        .start = {.line = 0, .column = 0},
+        .old_end = {.line = 0, .column = 0},
+        .new_end = {.line = 0, .column = 0}
+    });
+    if (m_swap) {
+        journal(edit, textInRange(edit.start.line, edit.start.column, edit.new_end.line, edit.new_end.column));
+    }
+    settleAfterHistoryStep(*caret);
+    return edit;
+}
+
+std::optional<BufferEdit> Cursor::undoToSaved() {
+    const auto saved = m_history.getSavedState();
+    if (!saved || *saved == m_history.getState()) {
+        return std::nullopt;
+    }
+
+    return travel(saved, 0);
+}
+
+std::optional<BufferEdit> Cursor::undoSteps(const uint32_t steps) {
+    // Within memory the target is known, so a checkpoint can shorten the way; deeper, the groups
+    // are paged back one at a time anyway
+    return travel(m_history.getStateBack(steps), steps);
+}
+
+void Cursor::checkpointHistory() {
+    if (m_history.wantsCheckpoint(m_buffer->getMemoryUsage().text / sizeof(char16_t))) {
+        m_history.addCheckpoint(getText());
+    }
+}
+
+void Cursor::holdUndoGroup(const bool hold) {
+    m_history.holdGroup(hold);
+}
+
+void Cursor::journal(const BufferEdit &edit, const std::u16string_view inserted) const {
+    if (m_swap) {
+        m_swap->record(edit, inserted);
+    }
+}
+
+void Cursor::attachSwap(std::unique_ptr<SwapJournal> swap) {
+    m_swap = std::move(swap);
+}
+
+SwapJournal *Cursor::getSwap() const {
+    return m_swap.get();
+}
+
+void Cursor::compactSwap(const bool force) {
+    if (m_swap && (force || m_swap->wantsSnapshot(m_buffer->getMemoryUsage().text))) {
+        m_swap->snapshot(getText());
+    }
+}
+
 void Cursor::clearHistory() {
     m_history.clear();
 }
 
+void Cursor::enableHistoryJournal(const std::string &directory) {
+    m_history.enableJournal(directory);
+}
+
+std::size_t Cursor::getHistoryCharacters() const {
+    return m_history.getRetainedCharacters();
+}
+
+std::size_t Cursor::getHistoryMemory() const {
+    return m_history.getArenaMemory() + m_history.getCheckpointMemory();
+}
+
+BufferMemory Cursor::getBufferMemory() const {
+    return m_buffer->getMemoryUsage();
+}
+
 void Cursor::shareMaxHistoryDepth(std::shared_ptr<CVarInt> maxDepth) {
     m_history.shareMaxDepth(std::move(maxDepth));
 }
@@ -19,13 +19,20 @@
 #ifndef CURSOR_H
 #define CURSOR_H
 
+#include <functional>
 #include <memory>
 #include <optional>
+#include <shared_mutex>
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "buffer/TextBuffer.h"
 #include "buffer/BufferEdit.h"
+#include "buffer/BufferMemory.h"
+#include "buffer/BufferSplice.h"
+#include "ReadGate.h"
+#include "SwapJournal.h"
 #include "TextRange.h"
 #include "UndoHistory.h"
 #include "../base/LineEnding.h"
@@ -37,8 +44,35 @@
  *
  * This class manages cursor movement, editing operations,
  * and links to an abstract text buffer for storage.
+ *
+ * Extra carets can stand beside the main one: the moves apply to all of them, and the *AtCarets
+ * edits fan out to every one in a single batch.
  */
 class Cursor final {
+public:
+    /** @brief A caret beside the main one, with the anchor of its selection. */
+    struct Caret final {
+        BufferEdit::Position position; ///< Where the caret stands.
+        BufferEdit::Position anchor;   ///< Where its selection starts; the caret's own position when it selects nothing.
+    };
+
+private:
+    /** @brief A replacement queued by batchReplace(), until commitBatch() applies it. */
+    struct BatchEdit final {
+        TextRange range;         ///< The range replaced, read against the buffer as it stood at beginBatch().
+        std::size_t text_begin;  ///< Offset of its text in m_batch_text.
+        std::size_t text_length; ///< Length of its text.
+    };
+
+    /** @brief The buffer, locked against the background readers until the end of the expression editing it. */
+    struct BufferEditAccess final {
+        std::unique_lock<std::shared_mutex> lock; ///< Exclusive hold of the read gate.
+        TextBuffer *buffer;                       ///< The buffer to edit.
+
+        TextBuffer *operator->() const { return buffer; }
+        TextBuffer &operator*() const { return *buffer; }
+    };
+
 private:
     /** Name of the buffer (filename). */
     std::string m_name;
@@ -67,7 +101,43 @@ private:
     /** Undo/redo history, holding the text each edit replaced and where the saved state sits. */
     UndoHistory m_history;
 
+    /** Crash-recovery journal of the edits, for a buffer backed by a file; null otherwise. */
+    std::unique_ptr<SwapJournal> m_swap;
+
+    /** Whether a batch is open, between beginBatch() and commitBatch(). */
+    bool m_batch_open;
+
+    /** Replacements queued in the open batch, in buffer order. */
+    std::vector<BatchEdit> m_batch;
+
+    /** The texts of the queued replacements, back to back, so queuing one allocates nothing on its own. */
+    std::u16string m_batch_text;
+
+    /** Carets beside the main one, in buffer order; no two selections, the main one included, overlap. */
+    std::vector<Caret> m_carets;
+
+    /** Gate the background readers of the text go through; shared with them, so it outlives the cursor. */
+    std::shared_ptr<ReadGate> m_read_gate;
+
 private:
+    /**
+     * @brief Gives access to the buffer for an edit, once the background readers are out of it.
+     *
+     * Every change to the text goes through here: `editBuffer()->insert(...)` holds the read gate
+     * until the end of the statement.
+     *
+     * @return The buffer, with the gate held exclusively.
+     */
+    [[nodiscard]] BufferEditAccess editBuffer() const;
+
+    /**
+     * @brief Hands an edit that was just applied to the buffer to the swap journal, if any.
+     *
+     * @param edit The edit, whose start and old end give the replaced range.
+     * @param inserted The text the edit put in that range.
+     */
+    void journal(const BufferEdit &edit, std::u16string_view inserted) const;
+
     /**
      * @brief Erase a range of text inside the internal buffer. This does not move the cursor coordinates.
      *
@@ -131,6 +201,70 @@ private:
      */
     void settleAfterHistoryStep(const BufferEdit::Position &caret);
 
+    /**
+     * @brief Moves through the history by many groups at once, as a single edit.
+     *
+     * With a target, the nearest checkpoint is restored first when it saves groups, and only the
+     * groups between it and the target are replayed. The checkpoint only rewrites what differs
+     * from the buffer, and the ranges every replayed group touched are merged, so the highlighter
+     * sees one edit rather than one per group without the buffer ever being copied.
+     *
+     * @param target The identity of the state to reach, or std::nullopt to undo a number of steps.
+     * @param steps The number of groups to undo, without a target.
+     * @return The edit, or std::nullopt when the history did not move.
+     */
+    [[nodiscard]] std::optional<BufferEdit> travel(std::optional<uint64_t> target, uint32_t steps);
+
+    /**
+     * @brief Undoes or redoes a group recorded by commitBatch() in one buffer splice.
+     *
+     * Such a group lists its edits from the last one in the buffer to the first, each in the
+     * coordinates of the buffer before the batch. Redoing splices them as they are; undoing maps
+     * every inserted range through the edits before it first. Either way, the swap journal gets
+     * the edits one by one, in an order where each one's coordinates hold when it is replayed.
+     *
+     * @param group The group to apply.
+     * @param revert Whether to undo the group rather than redo it.
+     * @return The edit spanning the whole change.
+     */
+    [[nodiscard]] BufferEdit spliceGroup(const UndoHistory::Group &group, bool revert);
+
+    /** @return The main caret, with the anchor of the selection when one is active. */
+    [[nodiscard]] Caret mainCaret() const;
+
+    /**
+     * @brief Runs a move on every caret, then merges the carets it brought together.
+     *
+     * Each extra caret takes the place of the main one while the move runs, so every move keeps a
+     * single implementation whatever the number of carets.
+     *
+     * @param move The move, acting on the main caret.
+     */
+    void forEachCaret(const std::function<void()> &move);
+
+    /** @brief Sorts the extra carets and drops those whose selection meets another one, the main one winning. */
+    void mergeCarets();
+
+    /**
+     * @brief Returns every caret, the main one included, in buffer order.
+     * @param mainIndex Receives the index of the main caret.
+     * @return The carets.
+     */
+    [[nodiscard]] std::vector<Caret> allCarets(std::size_t &mainIndex) const;
+
+    /**
+     * @brief Replaces a range per caret with the same text, in one batch.
+     *
+     * A range starting before the end of the previous one is cut down to what is left of it. Every
+     * caret lands at the end of its text, and the carets brought together are merged.
+     *
+     * @param ranges The range each caret replaces, in the order of allCarets(); trimmed in place.
+     * @param mainIndex The index of the main caret among them.
+     * @param characters The text to put in each range.
+     * @return The edit spanning the whole change, or std::nullopt when nothing changed.
+     */
+    [[nodiscard]] std::optional<BufferEdit> editAtCarets(std::vector<TextRange> &ranges, std::size_t mainIndex, std::u16string_view characters);
+
 public:
     /** @brief Deleted copy constructor. */
     Cursor(const Cursor &) = delete;
@@ -144,6 +278,19 @@ public:
      */
     explicit Cursor(std::unique_ptr<TextBuffer> buffer);
 
+    /** @brief Counts as a last edit on the read gate, so no background reader touches the buffer afterwards. */
+    ~Cursor();
+
+    /**
+     * @brief Returns the gate a background thread reads the text through.
+     *
+     * The text may only be read from another thread while a lock of the gate is held, and the
+     * cursor itself only touched then: it may be gone otherwise.
+     *
+     * @return The gate, shared with the cursor.
+     */
+    [[nodiscard]] std::shared_ptr<ReadGate> getReadGate() const;
+
     /** @brief Returns the entire buffer content as a single string, lines joined with line breaks. */
     [[nodiscard]] std::u16string getText() const;
 
@@ -203,6 +350,16 @@ public:
     /** @brief Returns the total number of lines in the buffer. */
     [[nodiscard]] uint32_t getLineCount() const;
 
+    /**
+     * @brief Returns how many lines, starting at the given one, the buffer stores back to back.
+     *
+     * LineScanner::forEachMatch scans such a run in one pass.
+     *
+     * @param line The first line of the run.
+     * @return The number of lines in the run, at least 1.
+     */
+    [[nodiscard]] uint32_t getContiguousLineCount(uint32_t line) const;
+
     /**
      * @brief Returns the weighted character length of the longest line in the buffer.
      *
@@ -266,6 +423,7 @@ public:
      * @brief Sets the new position of the cursor.
      *
      * A column landing inside a surrogate pair is snapped back to the start of that character.
+     * The extra carets are dropped.
      *
      * @param line New line index.
      * @param column New column index.
@@ -313,6 +471,102 @@ public:
     /** @return An optional BufferEdit describing the change. */
     [[nodiscard]] std::optional<BufferEdit> eraseSelection();
 
+    /**
+     * @brief Replaces a range of text with another in one buffer splice, undone as one step.
+     *
+     * Meant for bulk rewrites: the range can hold any number of changes, applied by the caller to
+     * the text it hands in, and still cost one buffer operation, one history entry and one edit to
+     * re-parse. The selection is dropped and the caret lands at the end of the new text.
+     *
+     * @param range The range to replace; its coordinates must be ordered.
+     * @param characters The text to put in its place.
+     * @return The resulting BufferEdit describing the change.
+     */
+    [[nodiscard]] BufferEdit replace(const TextRange &range, std::u16string_view characters);
+
+    /**
+     * @brief Opens a batch of replacements, applied together by commitBatch().
+     *
+     * Drops whatever an earlier batch left queued. The buffer must not be edited before the batch
+     * is committed: the queued ranges are read against the buffer as it stands now.
+     */
+    void beginBatch();
+
+    /**
+     * @brief Queues a replacement in the open batch.
+     *
+     * Replacements are queued in buffer order: each range starts at or after the end of the
+     * previous one. The text is copied, so the caller's storage may go away before the commit.
+     *
+     * @param range The range to replace; its coordinates must be ordered.
+     * @param characters The text to put in its place.
+     * @throws std::runtime_error If no batch is open, or the range is out of order or out of the buffer.
+     */
+    void batchReplace(const TextRange &range, std::u16string_view characters);
+
+    /**
+     * @brief Applies the queued replacements in one buffer splice, undone as one step.
+     *
+     * As many replace() calls would each pay a buffer splice, a history entry, a longest-line
+     * update and an edit to re-parse; the batch pays one of each, whatever its size. The history
+     * keeps the replaced pieces only, not the text between them. The selection is dropped and the
+     * caret lands at the end of the last replacement.
+     *
+     * @return The edit spanning from the start of the first replacement to the end of the last
+     *         one, or std::nullopt when the batch was empty.
+     */
+    [[nodiscard]] std::optional<BufferEdit> commitBatch();
+
+    /** @return The number of carets, the main one included. */
+    [[nodiscard]] uint32_t getCaretCount() const;
+
+    /** @return The carets beside the main one, in buffer order. */
+    [[nodiscard]] const std::vector<Caret> &getCarets() const;
+
+    /**
+     * @brief Adds a caret on the next occurrence of the selected text, and makes it the main one.
+     *
+     * The search starts after the main selection and wraps around the end of the buffer; occurrences
+     * already holding a caret are passed over. The selection must fit on one line.
+     *
+     * @return true when a caret was added, false without a one-line selection or another occurrence.
+     */
+    bool addCaretAtNextMatch();
+
+    /**
+     * @brief Replaces the selection with a caret at the end of each line it covers.
+     *
+     * A selection ending at the start of a line leaves that line out. The main caret lands on the
+     * last line.
+     *
+     * @return true when carets were placed, false when the selection does not span lines.
+     */
+    bool addCaretsOnSelectedLines();
+
+    /** @brief Drops every caret but the main one. Any edit or jump that is not made at every caret does it too. */
+    void clearCarets();
+
+    /**
+     * @brief Inserts text at every caret, replacing what each one selects.
+     *
+     * Every caret's edit goes into one batch: a keystroke costs one buffer splice, one undo step and
+     * one edit to re-parse, whatever the number of carets.
+     *
+     * @param characters The UTF-16 string to insert.
+     * @return The edit spanning the whole change, or std::nullopt when nothing changed.
+     */
+    [[nodiscard]] std::optional<BufferEdit> insertAtCarets(std::u16string_view characters);
+
+    /**
+     * @brief Erases what every caret selects, or the character beside the carets selecting nothing.
+     *
+     * Applied in one batch like insertAtCarets(). Carets at the edge of the buffer erase nothing.
+     *
+     * @param forward Whether to erase the character after the carets rather than the one before.
+     * @return The edit spanning the whole change, or std::nullopt when nothing changed.
+     */
+    [[nodiscard]] std::optional<BufferEdit> eraseAtCarets(bool forward);
+
     /**
      * @brief Replaces the whole buffer with freshly loaded content, without recording it.
      *
@@ -326,6 +580,18 @@ public:
      */
     [[nodiscard]] std::vector<BufferEdit> loadContent(std::u16string_view content);
 
+    /**
+     * @brief Appends content at the end of the buffer, without recording it.
+     *
+     * The counterpart of loadContent for a buffer filled in several goes, such as a listing
+     * streamed in while it is produced. Nothing before the end moves, so the caret, the selection
+     * and the recorded history stay valid; undo never takes the appended text back.
+     *
+     * @param content The text to append.
+     * @return The resulting BufferEdit describing the change.
+     */
+    [[nodiscard]] BufferEdit appendContent(std::u16string_view content);
+
     /**
      * @brief Restores the buffer to its state before the last recorded group of edits.
      *
@@ -345,9 +611,71 @@ public:
      */
     [[nodiscard]] std::vector<BufferEdit> redo();
 
+    /**
+     * @brief Undoes or redoes back to the state the buffer was last saved in.
+     * @return One edit describing the whole change, or std::nullopt when the buffer is already
+     *         there or the saved state is out of the history.
+     */
+    [[nodiscard]] std::optional<BufferEdit> undoToSaved();
+
+    /**
+     * @brief Undoes a number of groups of edits at once.
+     *
+     * Same as as many undo() calls, reported as a single edit.
+     *
+     * @param steps The number of groups to undo; fewer are when the history is shorter.
+     * @return One edit describing the whole change, or std::nullopt when there is nothing to undo.
+     */
+    [[nodiscard]] std::optional<BufferEdit> undoSteps(uint32_t steps);
+
+    /** @brief Takes a checkpoint of the buffer for undoToSaved() and undoSteps(), when the history is due for one. */
+    void checkpointHistory();
+
+    /**
+     * @brief Gathers every edit made from now on into a single undo group, until released.
+     *
+     * Used by a macro replay, so a thousand replayed edits undo as one step.
+     *
+     * @param hold Whether to hold the group or release it.
+     */
+    void holdUndoGroup(bool hold);
+
     /** @brief Wipes the undo/redo history. */
     void clearHistory();
 
+    /**
+     * @brief Spills the history the depth and character caps push out to journal files in a directory.
+     * @param directory The directory, trailing separator included. UTF-8.
+     */
+    void enableHistoryJournal(const std::string &directory);
+
+    /**
+     * @brief Starts journaling the edits to a swap file, replacing the previous journal.
+     *
+     * The buffer must match the file on disk, unless a snapshot follows right away (compactSwap()).
+     *
+     * @param swap The journal; null to stop journaling, which removes the previous swap file.
+     */
+    void attachSwap(std::unique_ptr<SwapJournal> swap);
+
+    /** @return The swap journal, or nullptr when the buffer has none. */
+    [[nodiscard]] SwapJournal *getSwap() const;
+
+    /**
+     * @brief Compacts the swap journal into a snapshot of the buffer.
+     * @param force Compact even when the journal has not outgrown the buffer yet.
+     */
+    void compactSwap(bool force);
+
+    /** @return The number of characters the undo/redo history retains. */
+    [[nodiscard]] std::size_t getHistoryCharacters() const;
+
+    /** @return The bytes allocated to hold the text of the undo/redo history and its checkpoints. */
+    [[nodiscard]] std::size_t getHistoryMemory() const;
+
+    /** @return The bytes held by the underlying text buffer, split by what they store. */
+    [[nodiscard]] BufferMemory getBufferMemory() const;
+
     /**
      * @brief Shares the CVar capping the undo/redo history depth with the history.
      * @param maxDepth The shared CVar holding the maximum history depth.
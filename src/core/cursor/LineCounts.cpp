@@ -0,0 +1,277 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "LineCounts.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <numeric>
+#include <tuple>
+
+
+/** @return The lowest set bit of a 1-based Fenwick position. */
+static size_t lowBit(const size_t position) {
+    return position & (~position + 1);
+}
+
+/** @brief Adds a delta to an entry of a Fenwick tree. */
+static void addTo(std::vector<uint32_t> &tree, const size_t index, const uint32_t delta) {
+    for (auto position = index + 1; position <= tree.size(); position += lowBit(position)) {
+        tree[position - 1] += delta;
+    }
+}
+
+/** @return The sum of the first entries of a Fenwick tree. */
+static uint32_t sumOf(const std::vector<uint32_t> &tree, const size_t count) {
+    auto sum = 0u;
+    for (auto position = std::min(count, tree.size()); position > 0; position -= lowBit(position)) {
+        sum += tree[position - 1];
+    }
+    return sum;
+}
+
+/**
+ * @brief Finds the longest prefix of a Fenwick tree summing to at most a value.
+ * @param tree The tree.
+ * @param value The value; the sum of the prefix is taken off it.
+ * @return The number of entries in the prefix.
+ */
+static size_t findPrefix(const std::vector<uint32_t> &tree, uint32_t &value) {
+    // Descend from the largest power of two
+    auto position = size_t{0};
+    for (auto step = std::bit_floor(tree.size()); step > 0; step >>= 1) {
+        if (position + step <= tree.size() && tree[position + step - 1] <= value) {
+            position += step;
+            value -= tree[position - 1];
+        }
+    }
+    return position;
+}
+
+/** @brief Turns values into their Fenwick tree, in place and in O(n). */
+static void toTree(std::vector<uint32_t> &values) {
+    for (size_t index = 0; index < values.size(); ++index) {
+        if (const auto parent = index + lowBit(index + 1); parent < values.size()) {
+            values[parent] += values[index];
+        }
+    }
+}
+
+/** @brief Turns a Fenwick tree back into its values, in place and in O(n). */
+static void toCounts(std::vector<uint32_t> &values) {
+    for (auto index = values.size(); index-- > 0;) {
+        if (const auto parent = index + lowBit(index + 1); parent < values.size()) {
+            values[parent] -= values[index];
+        }
+    }
+}
+
+std::pair<size_t, uint32_t> LineCounts::locate(const uint32_t line) const {
+    auto offset = line;
+    const auto block = findPrefix(m_block_lines, offset);
+    return {block, offset};
+}
+
+void LineCounts::rebuildIndex() {
+    m_block_lines.resize(m_blocks.size());
+    m_block_totals.resize(m_blocks.size());
+    for (size_t block = 0; block < m_blocks.size(); ++block) {
+        m_block_lines[block] = static_cast<uint32_t>(m_blocks[block].size());
+        m_block_totals[block] = sumOf(m_blocks[block], m_blocks[block].size());
+    }
+    toTree(m_block_lines);
+    toTree(m_block_totals);
+}
+
+bool LineCounts::splitBlock(const size_t block) {
+    auto counts = std::move(m_blocks[block]);
+    if (counts.size() <= BLOCK_LINES * 2) {
+        m_blocks[block] = std::move(counts);
+        return false;
+    }
+
+    auto pieces = std::vector<std::vector<uint32_t>>{};
+    for (size_t offset = 0; offset < counts.size(); offset += BLOCK_LINES) {
+        auto &piece = pieces.emplace_back(counts.begin() + offset, counts.begin() + std::min<size_t>(offset + BLOCK_LINES, counts.size()));
+        toTree(piece);
+    }
+    m_blocks.erase(m_blocks.begin() + block);
+    m_blocks.insert(m_blocks.begin() + block, std::make_move_iterator(pieces.begin()), std::make_move_iterator(pieces.end()));
+    return true;
+}
+
+uint32_t LineCounts::size() const {
+    return m_size;
+}
+
+void LineCounts::assign(const uint32_t size) {
+    m_blocks.clear();
+    m_block_lines.clear();
+    m_block_totals.clear();
+    m_size = 0;
+    insert(0, size);
+}
+
+void LineCounts::clear() {
+    m_blocks = std::vector<std::vector<uint32_t>>{};
+    m_block_lines = std::vector<uint32_t>{};
+    m_block_totals = std::vector<uint32_t>{};
+    m_size = 0;
+}
+
+void LineCounts::add(const uint32_t line, const uint32_t delta) {
+    const auto [block, offset] = locate(line);
+    addTo(m_blocks[block], offset, delta);
+    addTo(m_block_totals, block, delta);
+}
+
+uint32_t LineCounts::get(const uint32_t line) const {
+    const auto [block, offset] = locate(line);
+    return sumOf(m_blocks[block], offset + 1) - sumOf(m_blocks[block], offset);
+}
+
+uint32_t LineCounts::prefix(const uint32_t line) const {
+    if (line >= m_size) {
+        return sumOf(m_block_totals, m_block_totals.size());
+    }
+
+    const auto [block, offset] = locate(line);
+    return sumOf(m_block_totals, block) + sumOf(m_blocks[block], offset);
+}
+
+uint32_t LineCounts::lineOf(const uint32_t ordinal) const {
+    auto rest = ordinal;
+    const auto block = findPrefix(m_block_totals, rest);
+    if (block >= m_blocks.size()) {
+        return m_size;
+    }
+    return sumOf(m_block_lines, block) + static_cast<uint32_t>(findPrefix(m_blocks[block], rest));
+}
+
+void LineCounts::insert(const uint32_t line, const uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    auto block = size_t{0};
+    auto offset = 0u;
+    if (m_blocks.empty()) {
+        m_blocks.emplace_back();
+    } else if (line < m_size) {
+        std::tie(block, offset) = locate(line);
+    } else {
+        // Lines appended go to the end of the last block
+        block = m_blocks.size() - 1;
+        offset = static_cast<uint32_t>(m_blocks.back().size());
+    }
+
+    // Zeros leave the total of the block as it was
+    auto &tree = m_blocks[block];
+    toCounts(tree);
+    tree.insert(tree.begin() + offset, count, 0u);
+    m_size += count;
+    if (splitBlock(block) || m_block_lines.size() != m_blocks.size()) {
+        rebuildIndex();
+        return;
+    }
+
+    toTree(m_blocks[block]);
+    addTo(m_block_lines, block, count);
+}
+
+void LineCounts::erase(const uint32_t line, const uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    const auto [first_block, first_offset] = locate(line);
+    auto block = first_block;
+    auto offset = first_offset;
+    auto remaining = count;
+    auto removed_total = 0u;
+    auto dropped = false;
+    while (remaining > 0) {
+        auto &tree = m_blocks[block];
+        const auto taken = std::min<uint32_t>(remaining, static_cast<uint32_t>(tree.size()) - offset);
+        if (taken == tree.size()) {
+            tree = std::vector<uint32_t>{};
+            dropped = true;
+        } else {
+            toCounts(tree);
+            removed_total += std::accumulate(tree.begin() + offset, tree.begin() + offset + taken, 0u);
+            tree.erase(tree.begin() + offset, tree.begin() + offset + taken);
+            toTree(tree);
+        }
+        remaining -= taken;
+        offset = 0;
+        ++block;
+    }
+    m_size -= count;
+
+    if (!dropped && block == first_block + 1) {
+        const auto next = first_block + 1;
+        if (next >= m_blocks.size() || m_blocks[first_block].size() + m_blocks[next].size() > BLOCK_LINES) {
+            // One block shrank, and stays apart from the next
+            addTo(m_block_lines, first_block, 0u - count);
+            addTo(m_block_totals, first_block, 0u - removed_total);
+            return;
+        }
+    }
+
+    std::erase_if(m_blocks, [](const std::vector<uint32_t> &tree) { return tree.empty(); });
+
+    // A block left small is merged with the next one, so erasing does not leave a trail of tiny blocks
+    if (const auto next = first_block + 1; next < m_blocks.size() && m_blocks[first_block].size() + m_blocks[next].size() <= BLOCK_LINES) {
+        toCounts(m_blocks[first_block]);
+        toCounts(m_blocks[next]);
+        m_blocks[first_block].insert(m_blocks[first_block].end(), m_blocks[next].begin(), m_blocks[next].end());
+        toTree(m_blocks[first_block]);
+        m_blocks.erase(m_blocks.begin() + next);
+    }
+    rebuildIndex();
+}
+
+void LineCounts::zero(const uint32_t first, const uint32_t end) {
+    if (first >= end) {
+        return;
+    }
+
+    auto [block, offset] = locate(first);
+    auto remaining = end - first;
+    while (remaining > 0) {
+        auto &tree = m_blocks[block];
+        const auto taken = std::min<uint32_t>(remaining, static_cast<uint32_t>(tree.size()) - offset);
+        toCounts(tree);
+        const auto removed = std::accumulate(tree.begin() + offset, tree.begin() + offset + taken, 0u);
+        std::fill(tree.begin() + offset, tree.begin() + offset + taken, 0u);
+        toTree(tree);
+        addTo(m_block_totals, block, 0u - removed);
+        remaining -= taken;
+        offset = 0;
+        ++block;
+    }
+}
+
+std::size_t LineCounts::getMemoryUsage() const {
+    auto bytes = m_blocks.capacity() * sizeof(std::vector<uint32_t>) + (m_block_lines.capacity() + m_block_totals.capacity()) * sizeof(uint32_t);
+    for (const auto &tree : m_blocks) {
+        bytes += tree.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
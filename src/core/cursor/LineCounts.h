@@ -0,0 +1,120 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINE_COUNTS_H
+#define LINE_COUNTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief A count per line of a buffer, with prefix sums, that follows lines being inserted and erased.
+ *
+ * The lines are cut into blocks of about BLOCK_LINES, each a Fenwick tree of its counts, and two
+ * more Fenwick trees over the blocks hold their line counts and their totals. A lookup or a point
+ * update is O(log n); inserting or erasing lines rewrites the blocks they fall in and updates the
+ * block trees, O(BLOCK_LINES + log n) for a few lines, and only rebuilds the block trees, O(n /
+ * BLOCK_LINES), when blocks are split, merged or dropped.
+ */
+class LineCounts final {
+public:
+    /** Number of lines a block is cut to; a block grows up to twice as many before it is split. */
+    static constexpr uint32_t BLOCK_LINES = 4096;
+
+private:
+    /** Fenwick tree of the counts of each block: entry i sums the counts of lines (i + 1 - lowbit(i + 1), i] of the block. */
+    std::vector<std::vector<uint32_t>> m_blocks;
+
+    /** Fenwick tree of the number of lines of each block. */
+    std::vector<uint32_t> m_block_lines;
+
+    /** Fenwick tree of the total count of each block. */
+    std::vector<uint32_t> m_block_totals;
+
+    /** Number of lines. */
+    uint32_t m_size = 0;
+
+    /**
+     * @brief Finds the block holding a line.
+     * @param line The line; must be below size().
+     * @return The index of the block and the line's offset in it.
+     */
+    [[nodiscard]] std::pair<size_t, uint32_t> locate(uint32_t line) const;
+
+    /** @brief Rebuilds the block trees after blocks were split, merged or dropped. */
+    void rebuildIndex();
+
+    /**
+     * @brief Replaces a block by pieces of BLOCK_LINES lines once it grew past twice as many.
+     * @param block The index of the block, whose tree was turned into counts.
+     * @return true when the block was split, so the block trees must be rebuilt.
+     */
+    bool splitBlock(size_t block);
+
+public:
+    /** @return The number of lines. */
+    [[nodiscard]] uint32_t size() const;
+
+    /** @brief Replaces every line by the given number of lines counting zero. */
+    void assign(uint32_t size);
+
+    /** @brief Drops every line and releases the memory. */
+    void clear();
+
+    /** @brief Adds a delta to the count of a line; unsigned wrap-around makes a negative delta work. */
+    void add(uint32_t line, uint32_t delta);
+
+    /** @return The count of a line, which must be below size(). */
+    [[nodiscard]] uint32_t get(uint32_t line) const;
+
+    /** @return The sum of the counts of the lines before the given one; every line past size(). */
+    [[nodiscard]] uint32_t prefix(uint32_t line) const;
+
+    /** @return The line holding the unit of the given ordinal: the longest prefix summing to at most @p ordinal. */
+    [[nodiscard]] uint32_t lineOf(uint32_t ordinal) const;
+
+    /**
+     * @brief Inserts lines counting zero.
+     * @param line The line they are inserted before; size() appends them.
+     * @param count The number of lines inserted.
+     */
+    void insert(uint32_t line, uint32_t count);
+
+    /**
+     * @brief Erases lines.
+     * @param line The first line erased.
+     * @param count The number of lines erased; they must all be below size().
+     */
+    void erase(uint32_t line, uint32_t count);
+
+    /**
+     * @brief Sets the counts of a run of lines to zero.
+     * @param first The first line of the run.
+     * @param end The line past the run; must not exceed size().
+     */
+    void zero(uint32_t first, uint32_t end);
+
+    /** @return The bytes held by the trees. */
+    [[nodiscard]] std::size_t getMemoryUsage() const;
+};
+
+
+#endif //LINE_COUNTS_H
@@ -0,0 +1,287 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "LineTransform.h"
+
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+
+#include "TextRange.h"
+
+
+namespace {
+
+/** Characters trimmed from the end of the lines. */
+constexpr auto BLANKS = std::u16string_view(u" \t");
+
+/**
+ * @brief Runs tasks on worker threads, the calling one included, and returns once all are done.
+ * @param taskCount The number of tasks, at least 1.
+ * @param task The task, called once with each index below @p taskCount.
+ */
+void share(const size_t taskCount, const std::function<void(size_t)> &task) {
+    auto workers = std::vector<std::jthread>{};
+    workers.reserve(taskCount - 1);
+    for (size_t index = 1; index < taskCount; ++index) {
+        workers.emplace_back([&task, index] { task(index); });
+    }
+    task(0);
+}
+
+/**
+ * @brief Sorts items keeping equal ones in order, on worker threads once there are enough of them.
+ *
+ * Each worker sorts a run of its own, then the runs are merged pairwise, the merges of one round
+ * running side by side. Both steps keep equal items in order, so the whole sort is stable.
+ *
+ * @param items The items to sort.
+ * @param less The order to sort them in.
+ * @param threadCount The number of threads sorting, the calling one included.
+ */
+template <typename T, typename Less>
+void parallelSort(std::vector<T> &items, const Less &less, const uint32_t threadCount) {
+    const auto run_count = std::clamp<size_t>(threadCount, 1, std::max<size_t>(items.size() / LineTransform::SLICE_LINES, 1));
+    if (run_count == 1) {
+        std::stable_sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    auto bounds = std::vector<size_t>(run_count + 1);
+    for (size_t run = 0; run <= run_count; ++run) {
+        bounds[run] = items.size() * run / run_count;
+    }
+
+    const auto at = [&items, &bounds](const size_t run) {
+        return items.begin() + static_cast<std::ptrdiff_t>(bounds[run]);
+    };
+
+    share(run_count, [&](const size_t run) {
+        std::stable_sort(at(run), at(run + 1), less);
+    });
+
+    // Each round merges the runs two by two, doubling their width; an odd one out waits for the next
+    for (size_t width = 1; width < run_count; width *= 2) {
+        share((run_count + 2 * width - 1) / (2 * width), [&](const size_t merge) {
+            const auto first = merge * 2 * width;
+            const auto middle = std::min(first + width, run_count);
+            const auto last = std::min(first + 2 * width, run_count);
+            if (middle < last) {
+                std::inplace_merge(at(first), at(middle), at(last), less);
+            }
+        });
+    }
+}
+
+/**
+ * @brief Returns the length of a line without its trailing blanks.
+ * @param line The line to measure.
+ * @return The length of the line once trimmed.
+ */
+uint32_t trimmedLength(const std::u16string_view line) {
+    const auto last = line.find_last_not_of(BLANKS);
+    return last == std::u16string_view::npos ? 0 : static_cast<uint32_t>(last + 1);
+}
+
+}
+
+
+std::optional<double> LineTransform::leadingNumber(const std::u16string_view line) {
+    auto index = line.find_first_not_of(BLANKS);
+    if (index == std::u16string_view::npos) {
+        return std::nullopt;
+    }
+
+    // The number is copied as ASCII for from_chars, which reads neither UTF-16 nor a plus sign
+    auto ascii = std::string{};
+    const auto negative = line[index] == u'-';
+    if (line[index] == u'-' || line[index] == u'+') {
+        ++index;
+    }
+    if (negative) {
+        ascii.push_back('-');
+    }
+
+    const auto is_digit = [&line](const size_t at) {
+        return at < line.length() && line[at] >= u'0' && line[at] <= u'9';
+    };
+
+    auto digit_count = 0u;
+    auto significant = false;
+    for (; is_digit(index); ++index, ++digit_count) {
+        significant = significant || line[index] != u'0';
+        ascii.push_back(static_cast<char>(line[index]));
+    }
+    if (index < line.length() && line[index] == u'.' && is_digit(index + 1)) {
+        ascii.push_back('.');
+        for (++index; is_digit(index); ++index, ++digit_count) {
+            ascii.push_back(static_cast<char>(line[index]));
+        }
+    }
+
+    if (digit_count == 0) {
+        return std::nullopt;
+    }
+
+    auto value = 0.0;
+    const auto [ptr, ec] = std::from_chars(ascii.data(), ascii.data() + ascii.length(), value);
+    if (ec == std::errc::result_out_of_range) {
+        // Too long for a double: huge when its integer part is not zero, tiny otherwise
+        value = significant ? std::numeric_limits<double>::infinity() : 0.0;
+        return negative ? -value : value;
+    }
+    return value;
+}
+
+std::vector<std::u16string_view> LineTransform::transform(std::vector<std::u16string_view> lines, const Kind kind, const uint32_t threadCount) {
+    switch (kind) {
+        case Kind::Sort:
+            parallelSort(lines, std::less<>{}, threadCount);
+            break;
+        case Kind::SortNumeric: {
+            // Each number is read once, not once per comparison
+            struct Keyed final {
+                double key;
+                std::u16string_view line;
+            };
+
+            auto keyed = std::vector<Keyed>{};
+            keyed.reserve(lines.size());
+            for (const auto &line : lines) {
+                keyed.push_back(Keyed{.key = leadingNumber(line).value_or(-std::numeric_limits<double>::infinity()), .line = line});
+            }
+
+            parallelSort(keyed, [](const Keyed &left, const Keyed &right) { return left.key < right.key; }, threadCount);
+            std::ranges::transform(keyed, lines.begin(), &Keyed::line);
+            break;
+        }
+        case Kind::Unique: {
+            auto seen = std::unordered_set<std::u16string_view>{};
+            seen.reserve(lines.size());
+
+            auto kept = lines.begin();
+            for (const auto &line : lines) {
+                if (seen.insert(line).second) {
+                    *kept++ = line;
+                }
+            }
+            lines.erase(kept, lines.end());
+            break;
+        }
+        case Kind::Reverse:
+            std::ranges::reverse(lines);
+            break;
+        case Kind::Trim:
+            for (auto &line : lines) {
+                line = line.substr(0, trimmedLength(line));
+            }
+            break;
+    }
+
+    return lines;
+}
+
+LineTransform::Result LineTransform::apply(Cursor &cursor, const uint32_t firstLine, const uint32_t lastLine, const Kind kind, const uint32_t threadCount) {
+    auto lines = std::vector<std::u16string_view>{};
+    lines.reserve(lastLine - firstLine + 1);
+    for (auto line = firstLine; line <= lastLine; ++line) {
+        lines.push_back(cursor.getString(line));
+    }
+
+    if (kind == Kind::Trim) {
+        // Only the blanks go, each line's in its own piece of a batch
+        auto changed = 0u;
+        cursor.beginBatch();
+        for (auto line = firstLine; line <= lastLine; ++line) {
+            const auto length = static_cast<uint32_t>(lines[line - firstLine].length());
+            const auto trimmed = trimmedLength(lines[line - firstLine]);
+            if (trimmed < length) {
+                cursor.batchReplace(TextRange{.line_start = line, .column_start = trimmed, .line_end = line, .column_end = length}, u"");
+                ++changed;
+            }
+        }
+
+        return Result{.edit = cursor.commitBatch(), .line_count = static_cast<uint32_t>(lines.size()), .changed = changed};
+    }
+
+    const auto result = transform(lines, kind, threadCount);
+    const auto line_count = static_cast<uint32_t>(result.size());
+
+    // Lines dropped when there are any, lines that moved otherwise
+    auto changed = static_cast<uint32_t>(lines.size() - result.size());
+    if (changed == 0) {
+        for (size_t index = 0; index < lines.size(); ++index) {
+            changed += lines[index] != result[index] ? 1 : 0;
+        }
+    }
+    if (changed == 0) {
+        return Result{.edit = std::nullopt, .line_count = line_count, .changed = 0};
+    }
+
+    // The lines that stay in place at either end are left out of the replacement
+    size_t prefix = 0;
+    while (prefix < result.size() && lines[prefix] == result[prefix]) {
+        ++prefix;
+    }
+    size_t suffix = 0;
+    while (suffix < result.size() - prefix && lines[lines.size() - 1 - suffix] == result[result.size() - 1 - suffix]) {
+        ++suffix;
+    }
+
+    const auto old_first = firstLine + static_cast<uint32_t>(prefix);
+    const auto old_last = lastLine - static_cast<uint32_t>(suffix);
+    if (prefix + suffix == result.size()) {
+        // Only whole lines dropped: their line ends go with them, the one below theirs when there
+        // is a line below, the one above otherwise
+        const auto range = suffix > 0
+            ? TextRange{.line_start = old_first, .column_start = 0, .line_end = old_last + 1, .column_end = 0}
+            : TextRange{
+                .line_start = old_first - 1,
+                .column_start = static_cast<uint32_t>(lines[prefix - 1].length()),
+                .line_end = old_last,
+                .column_end = static_cast<uint32_t>(lines.back().length())
+            };
+        return Result{.edit = cursor.replace(range, u""), .line_count = line_count, .changed = changed};
+    }
+
+    auto text = std::u16string{};
+    auto text_length = size_t{0};
+    for (auto index = prefix; index < result.size() - suffix; ++index) {
+        text_length += result[index].length() + 1;
+    }
+    text.reserve(text_length);
+    for (auto index = prefix; index < result.size() - suffix; ++index) {
+        if (index > prefix) {
+            text.push_back(u'\n');
+        }
+        text.append(result[index]);
+    }
+
+    const auto range = TextRange{
+        .line_start = old_first,
+        .column_start = 0,
+        .line_end = old_last,
+        .column_end = static_cast<uint32_t>(lines[old_last - firstLine].length())
+    };
+    return Result{.edit = cursor.replace(range, text), .line_count = line_count, .changed = changed};
+}
@@ -0,0 +1,103 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINE_TRANSFORM_H
+#define LINE_TRANSFORM_H
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "Cursor.h"
+#include "buffer/BufferEdit.h"
+
+
+/**
+ * @brief Rewrites a run of whole lines at once: sorting, dropping repeats, reversing, trimming.
+ *
+ * The lines are read as views into the buffer and rearranged as views, so the text itself is only
+ * copied once, into the replacement. Only the lines between the first and the last one that end up
+ * different are replaced, in one buffer splice and one undo step (Cursor::replace); trimming queues
+ * the trailing blanks of each line in a cursor batch instead, so the history keeps the blanks only.
+ * Sorting runs on worker threads once there are enough lines to share.
+ */
+class LineTransform final {
+public:
+    /** @brief The rewrites available. */
+    enum class Kind : uint8_t {
+        Sort,        ///< Lines in code unit order, equal lines keeping their order.
+        SortNumeric, ///< Lines in the order of the number they start with, equal ones keeping their order.
+        Unique,      ///< Every line seen above dropped, wherever it was.
+        Reverse,     ///< Lines in reverse order.
+        Trim         ///< Spaces and tabs dropped from the end of each line.
+    };
+
+    /** @brief Outcome of apply. */
+    struct Result final {
+        std::optional<BufferEdit> edit; ///< The splice applied, or std::nullopt when no line changed.
+        uint32_t line_count;            ///< Number of lines the run holds afterward.
+        uint32_t changed;               ///< Lines moved, dropped or trimmed.
+    };
+
+    /** Number of lines below which sorting does not start another thread. */
+    static constexpr uint32_t SLICE_LINES = 16384;
+
+    /** @brief Deleted constructor; this class is static-only. */
+    LineTransform() = delete;
+
+    /**
+     * @brief Returns the number a line starts with, which SortNumeric orders lines by.
+     *
+     * Leading spaces and tabs are skipped, then an optional sign, digits and a fraction are read.
+     *
+     * @param line The line to read.
+     * @return The number, or std::nullopt when the line does not start with one.
+     */
+    [[nodiscard]] static std::optional<double> leadingNumber(std::u16string_view line);
+
+    /**
+     * @brief Rewrites a list of lines.
+     *
+     * Lines without a number come first under SortNumeric, in their order.
+     *
+     * @param lines The lines to rewrite; the views must outlive the result, which points into them.
+     * @param kind The rewrite to apply.
+     * @param threadCount The number of threads sorting, the calling one included.
+     * @return The rewritten lines.
+     */
+    [[nodiscard]] static std::vector<std::u16string_view> transform(std::vector<std::u16string_view> lines, Kind kind, uint32_t threadCount);
+
+    /**
+     * @brief Rewrites a run of whole lines of a buffer, as a single edit.
+     *
+     * The selection and the extra carets are dropped; the caret lands at the end of the last line
+     * replaced.
+     *
+     * @param cursor The cursor whose buffer is rewritten.
+     * @param firstLine The first line of the run.
+     * @param lastLine The last line of the run, included; not before @p firstLine.
+     * @param kind The rewrite to apply.
+     * @param threadCount The number of threads sorting, the calling one included.
+     * @return The edit to pass on to whatever follows the buffer, and the size of the change.
+     */
+    [[nodiscard]] static Result apply(Cursor &cursor, uint32_t firstLine, uint32_t lastLine, Kind kind, uint32_t threadCount);
+};
+
+
+#endif //LINE_TRANSFORM_H
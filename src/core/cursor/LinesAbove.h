@@ -0,0 +1,53 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINES_ABOVE_H
+#define LINES_ABOVE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+
+#include "Cursor.h"
+
+
+/**
+ * @brief The lines of a cursor above a bound, as the text source of LineScanner::forEachMatch.
+ *
+ * Lets a scan over a slice of the buffer stop at the end of the slice instead of running on to
+ * the next match, however far below it is.
+ */
+struct LinesAbove final {
+    const Cursor &cursor; ///< The cursor whose lines are read.
+    uint32_t end;         ///< The exclusive bound; lines past it are not visited.
+
+    [[nodiscard]] uint32_t getLineCount() const {
+        return end;
+    }
+
+    [[nodiscard]] std::u16string_view getString(const uint32_t line) const {
+        return cursor.getString(line);
+    }
+
+    [[nodiscard]] uint32_t getContiguousLineCount(const uint32_t line) const {
+        return std::min(cursor.getContiguousLineCount(line), end - line);
+    }
+};
+
+
+#endif //LINES_ABOVE_H
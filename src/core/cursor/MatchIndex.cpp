@@ -0,0 +1,373 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "MatchIndex.h"
+
+#include <algorithm>
+#include <span>
+
+#include "LinesAbove.h"
+
+
+/**
+ * @brief Counts the occurrences of one line a non-overlapping enumeration visits, resuming past each.
+ * @param starts The columns of every occurrence on the line, in order.
+ * @param length The length of the occurrences.
+ * @return The number of occurrences visited.
+ */
+template<typename TCandidate>
+static uint32_t countNonOverlapping(const std::span<TCandidate> starts, const size_t length) {
+    auto count = 0u;
+    auto next = size_t{ 0 };
+    for (const auto &candidate : starts) {
+        if (candidate.column >= next) {
+            ++count;
+            next = candidate.column + length;
+        }
+    }
+    return count;
+}
+
+uint32_t MatchIndex::countLine(const Cursor &cursor, const uint32_t line) {
+    auto count = 0u;
+    m_scanner->setLine(cursor.getString(line));
+    for (auto position = m_scanner->indexOf(0); position != std::u16string_view::npos; position = m_scanner->indexOf(m_scanner->nextFrom(position))) {
+        ++count;
+    }
+    return count;
+}
+
+void MatchIndex::flush(const Cursor &cursor) {
+    if (!m_dirty) {
+        return;
+    }
+
+    const auto [first, last] = *m_dirty;
+    m_dirty.reset();
+
+    if (static_cast<uint64_t>(last - first) * 2 >= m_counts.size()) {
+        // Most of the buffer changed (a load, a clear): counting again beats a point update per line
+        restart(cursor);
+        return;
+    }
+
+    for (auto line = first; line <= last && line < m_counted; ++line) {
+        const auto stored = m_counts.get(line);
+        const auto counted = countLine(cursor, line);
+        if (counted != stored) {
+            m_counts.add(line, counted - stored);
+        }
+    }
+}
+
+void MatchIndex::restart(const Cursor &cursor) {
+    m_dirty.reset();
+    m_counted = 0;
+    m_counts.assign(cursor.getLineCount());
+    m_candidates.clear();
+    m_has_candidates = !m_regex;
+}
+
+void MatchIndex::dropCandidates() {
+    m_candidates = std::vector<Candidate>{};
+    m_has_candidates = false;
+}
+
+bool MatchIndex::canNarrow(const std::u16string_view term, const bool caseSensitive) const {
+    return m_scanner.has_value() && m_has_candidates && !m_regex && !m_dirty && m_case_sensitive == caseSensitive
+        && term.length() > m_term.length() && term.starts_with(m_term);
+}
+
+void MatchIndex::narrow(const Cursor &cursor, const std::u16string_view term) {
+    const auto known_length = m_term.length();
+    auto scanner = LineScanner(term, m_case_sensitive);
+
+    // The occurrences are filtered in place, one line at a time, so each line's count can change
+    // by a point update; the lines without one hold no match of either term
+    auto kept = size_t{ 0 };
+    for (size_t first = 0; first < m_candidates.size();) {
+        const auto line = m_candidates[first].line;
+        auto last = first;
+        while (last < m_candidates.size() && m_candidates[last].line == line) {
+            ++last;
+        }
+
+        const auto count = countNonOverlapping(std::span(m_candidates).subspan(first, last - first), known_length);
+        const auto kept_first = kept;
+        scanner.setLine(cursor.getString(line));
+        for (auto candidate = first; candidate < last; ++candidate) {
+            if (scanner.isMatchAt(m_candidates[candidate].column, known_length)) {
+                m_candidates[kept++] = m_candidates[candidate];
+            }
+        }
+
+        const auto narrowed_count = countNonOverlapping(std::span(m_candidates).subspan(kept_first, kept - kept_first), term.length());
+        if (narrowed_count != count) {
+            m_counts.add(line, narrowed_count - count);
+        }
+        first = last;
+    }
+    m_candidates.resize(kept);
+
+    m_scanner.emplace(std::move(scanner));
+    m_term = term;
+}
+
+bool MatchIndex::isBuiltFor(const std::u16string_view term, const bool caseSensitive, const bool regex) const {
+    return m_scanner.has_value() && m_case_sensitive == caseSensitive && m_regex == regex && m_term == term;
+}
+
+void MatchIndex::start(const Cursor &cursor, const std::u16string_view term, const bool caseSensitive) {
+    ++m_generation;
+    if (canNarrow(term, caseSensitive)) {
+        narrow(cursor, term);
+        return;
+    }
+
+    m_scanner.emplace(term, caseSensitive);
+    m_term = term;
+    m_case_sensitive = caseSensitive;
+    m_regex = false;
+    restart(cursor);
+}
+
+void MatchIndex::start(const Cursor &cursor, std::shared_ptr<Regex> regex) {
+    ++m_generation;
+    m_term = regex->getPattern();
+    m_case_sensitive = regex->isCaseSensitive();
+    m_regex = true;
+    m_scanner.emplace(std::move(regex));
+    restart(cursor);
+}
+
+bool MatchIndex::step(const Cursor &cursor, const uint32_t lineBudget) {
+    if (!isCounting()) {
+        return false;
+    }
+
+    // The enumeration skips the occurrences overlapping the one before, so it cannot list them all
+    // for a term overlapping itself
+    if (m_has_candidates && m_scanner->isSelfOverlapping()) {
+        dropCandidates();
+    }
+
+    // The lines past m_counted hold zero, so their counts are plain additions; one per line
+    // holding a match, flushed when the enumeration moves on to another line
+    const auto end = m_counted + std::min(lineBudget, m_counts.size() - m_counted);
+    auto pending_line = m_counted;
+    auto pending_count = 0u;
+    m_scanner->forEachMatch(LinesAbove{.cursor = cursor, .end = end}, m_counted, 0, [&](const uint32_t line, const uint32_t column) {
+        if (m_has_candidates) {
+            if (m_candidates.size() < MAX_CANDIDATES) {
+                m_candidates.push_back(Candidate{.line = line, .column = column});
+            } else {
+                dropCandidates();
+            }
+        }
+
+        if (line != pending_line) {
+            if (pending_count > 0) {
+                m_counts.add(pending_line, pending_count);
+            }
+            pending_line = line;
+            pending_count = 0;
+        }
+        ++pending_count;
+        return true;
+    });
+    if (pending_count > 0) {
+        m_counts.add(pending_line, pending_count);
+    }
+
+    m_counted = end;
+    return isCounting();
+}
+
+void MatchIndex::build(const Cursor &cursor, const std::u16string_view term, const bool caseSensitive) {
+    start(cursor, term, caseSensitive);
+    step(cursor, cursor.getLineCount());
+}
+
+bool MatchIndex::isCounting() const {
+    return m_scanner.has_value() && m_counted < m_counts.size();
+}
+
+uint32_t MatchIndex::getCountedLines() const {
+    return m_counted;
+}
+
+const LineScanner &MatchIndex::getScanner() const {
+    return *m_scanner;
+}
+
+bool MatchIndex::hasTerm() const {
+    return m_scanner.has_value();
+}
+
+uint64_t MatchIndex::getGeneration() const {
+    return m_generation;
+}
+
+void MatchIndex::clear() {
+    ++m_generation;
+    m_scanner.reset();
+    m_term.clear();
+    m_counts.clear();
+    m_dirty.reset();
+    m_counted = 0;
+    dropCandidates();
+}
+
+void MatchIndex::edit(const BufferEdit &edit) {
+    this->edit(std::span(&edit, 1));
+}
+
+void MatchIndex::edit(const std::span<const BufferEdit> edits) {
+    if (!m_scanner || edits.empty()) {
+        return;
+    }
+
+    // The occurrences would have to follow the edit too; the next term is counted from scratch instead
+    dropCandidates();
+
+    // Fold the edits into one: lines first..old_last before the first edit become first..new_last
+    // after the last one
+    auto first = edits.front().start.line;
+    auto old_last = edits.front().old_end.line;
+    auto new_last = edits.front().new_end.line;
+    for (const auto &next : edits.subspan(1)) {
+        const auto last = std::max(new_last, next.old_end.line);
+        first = std::min(first, next.start.line);
+        old_last += last - new_last;
+        new_last = last - next.old_end.line + next.new_end.line;
+    }
+
+    if (old_last >= m_counts.size()) {
+        // An edit was missed, the lines no longer line up: start over on the next lookup
+        clear();
+        return;
+    }
+
+    // An edit reaching past the counted lines pulls the count back to its first line, whose
+    // stale counts must go: the lines past m_counted hold zero until step() reaches them
+    const auto crosses_count = first < m_counted && old_last >= m_counted;
+    if (crosses_count) {
+        m_counts.zero(first, m_counted);
+    }
+
+    // Lines first..old_last become first..new_last; the counts of the lines kept are stale, the
+    // ones of the lines added are zero, and all of them are rescanned by the next flush
+    if (new_last > old_last) {
+        m_counts.insert(old_last + 1, new_last - old_last);
+    } else if (new_last < old_last) {
+        m_counts.erase(new_last + 1, old_last - new_last);
+    }
+
+    if (crosses_count) {
+        m_counted = first;
+    } else if (first < m_counted) {
+        m_counted = m_counted - old_last + new_last;
+    }
+
+    // Carry the lines dirtied by the previous edits over this one, then add the ones it touched
+    auto dirty_first = first;
+    auto dirty_last = new_last;
+    if (m_dirty) {
+        const auto map = [&](const uint32_t line, const uint32_t inside) {
+            if (line < first) {
+                return line;
+            }
+            return line > old_last ? line - old_last + new_last : inside;
+        };
+        dirty_first = std::min(dirty_first, map(m_dirty->first, first));
+        dirty_last = std::max(dirty_last, map(m_dirty->second, new_last));
+    }
+
+    // The lines not counted yet are left to step()
+    if (dirty_first < m_counted) {
+        m_dirty = std::pair { dirty_first, std::min(dirty_last, m_counted - 1) };
+    } else {
+        m_dirty.reset();
+    }
+}
+
+MatchIndex::Rank MatchIndex::rank(const Cursor &cursor, const uint32_t line, const uint32_t column) {
+    flush(cursor);
+
+    auto result = Rank{
+        .index = -1,
+        .length = 0,
+        .before = static_cast<int32_t>(m_counts.prefix(line)),
+        .total = static_cast<int32_t>(m_counts.prefix(m_counts.size())),
+        .counted = line <= m_counted,
+        .complete = !isCounting()
+    };
+    if (!result.counted) {
+        return result;
+    }
+
+    // Only the line of the position needs scanning: the tree counts the ones before it
+    m_scanner->setLine(cursor.getString(line));
+    for (auto position = m_scanner->indexOf(0); position != std::u16string_view::npos; position = m_scanner->indexOf(m_scanner->nextFrom(position))) {
+        if (position >= column) {
+            if (position == column) {
+                result.index = result.before;
+                result.length = static_cast<uint32_t>(m_scanner->matchLength());
+            }
+            break;
+        }
+        ++result.before;
+    }
+
+    return result;
+}
+
+std::optional<uint32_t> MatchIndex::nextLineWithMatch(const Cursor &cursor, const uint32_t line) {
+    flush(cursor);
+
+    const auto ordinal = m_counts.prefix(line + 1);
+    if (ordinal < m_counts.prefix(m_counted)) {
+        return m_counts.lineOf(ordinal);
+    }
+
+    // Past the counted lines, any line may hold a match
+    const auto next = std::max(line + 1, m_counted);
+    if (next >= m_counts.size()) {
+        return std::nullopt;
+    }
+    return next;
+}
+
+std::optional<uint32_t> MatchIndex::previousLineWithMatch(const Cursor &cursor, const uint32_t line) {
+    flush(cursor);
+
+    if (line > m_counted) {
+        // The line before is not counted yet, so it may hold a match
+        return line - 1;
+    }
+
+    const auto ordinal = m_counts.prefix(line);
+    if (ordinal == 0) {
+        return std::nullopt;
+    }
+    return m_counts.lineOf(ordinal - 1);
+}
+
+std::size_t MatchIndex::getMemoryUsage() const {
+    return m_counts.getMemoryUsage() + m_candidates.capacity() * sizeof(Candidate);
+}
@@ -0,0 +1,269 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MATCH_INDEX_H
+#define MATCH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "buffer/BufferEdit.h"
+#include "../base/LineScanner.h"
+#include "Cursor.h"
+#include "LineCounts.h"
+
+
+/**
+ * @brief Per-line match counts of one search term, kept up to date across edits.
+ *
+ * Counts are those of the non-overlapping enumeration of LineScanner::forEachMatch, and live in
+ * LineCounts, so the total, the ordinal of a match and the next or previous line holding one are
+ * O(log n) lookups. Matches never span lines, so an edit only invalidates the lines it touched:
+ * edit() records them as dirty, without reading the text, and the next query rescans them. An edit
+ * adding or removing lines also shifts the counts, which only rewrites the blocks it falls in; the
+ * edits of an undo step are folded into one shift.
+ *
+ * The count itself runs in slices: start() only sizes the counts, and every step() counts the next
+ * run of lines, so a huge buffer is counted between frames instead of in one blocking pass. Until
+ * the count completes, the lookups treat the lines not counted yet as possibly holding a match, and
+ * the ranks they return say which of their figures are final.
+ *
+ * A literal term also keeps where each of its occurrences starts, up to MAX_CANDIDATES of them.
+ * Every occurrence of a longer term it begins starts at one of those, so start() only checks them
+ * when the next term extends the indexed one, the way an incremental search grows its term,
+ * instead of counting the buffer again. An edit drops them.
+ *
+ * Every BufferEdit applied to the cursor must reach edit(), in order; CursorContext::notifyEdit
+ * does it along with the highlighter.
+ */
+class MatchIndex final {
+public:
+    /** @brief Where a position ranks among the matches. */
+    struct Rank final {
+        int32_t index;   ///< Ordinal of the match starting exactly at the position, or -1 when none does.
+        uint32_t length; ///< Length of that match, in code units; 0 when index is -1.
+        int32_t before;  ///< Number of matches starting before the position.
+        int32_t total;   ///< Total number of matches, or the number counted so far.
+        bool counted;    ///< true when the lines before the position are counted, so index and before are exact.
+        bool complete;   ///< true when the whole buffer is counted, so total is final.
+    };
+
+    /** Number of occurrences kept to narrow the index down to a longer term; a term with more is never narrowed. */
+    static constexpr size_t MAX_CANDIDATES = 262144;
+
+private:
+    /** @brief Where an occurrence of the indexed term starts. */
+    struct Candidate final {
+        uint32_t line;   ///< Line of the occurrence.
+        uint32_t column; ///< Column the occurrence starts at.
+    };
+
+    /** Scanner of the indexed term; empty until build() runs. */
+    std::optional<LineScanner> m_scanner;
+
+    /** The indexed term or pattern, as given to start(), to tell whether a lookup can reuse the index. */
+    std::u16string m_term;
+
+    /** The case-sensitivity mode of the indexed term. */
+    bool m_case_sensitive = false;
+
+    /** Whether m_term is a regular expression. */
+    bool m_regex = false;
+
+    /** Bumped whenever the indexed term or mode changes, so what was derived from the previous one can tell. */
+    uint64_t m_generation = 0;
+
+    /** The match count of every line. */
+    LineCounts m_counts;
+
+    /** First and last line touched by the edits since the last rescan, when any; always below m_counted. */
+    std::optional<std::pair<uint32_t, uint32_t>> m_dirty;
+
+    /** Number of lines counted from the top; the entries of the lines past it are all zero. */
+    uint32_t m_counted = 0;
+
+    /** Every occurrence of the literal term on the counted lines, overlapping ones included, in text order. */
+    std::vector<Candidate> m_candidates;
+
+    /** true while m_candidates is complete, so a longer term can be narrowed from it. */
+    bool m_has_candidates = false;
+
+    /** @return The number of matches on a line. */
+    [[nodiscard]] uint32_t countLine(const Cursor &cursor, uint32_t line);
+
+    /** @brief Rescans the dirty lines, if any. */
+    void flush(const Cursor &cursor);
+
+    /** @brief Zeroes the counts, sized for the buffer, so step() counts it from the top with the current scanner. */
+    void restart(const Cursor &cursor);
+
+    /** @brief Forgets the occurrences and releases them; the next term is counted from scratch. */
+    void dropCandidates();
+
+    /**
+     * @brief Tells whether start() can narrow the index down to a term instead of counting it.
+     * @param term The term to look for.
+     * @param caseSensitive Whether the comparison is case-sensitive.
+     * @return true when @p term extends the indexed literal term, under the same mode, and every occurrence of it is known.
+     */
+    [[nodiscard]] bool canNarrow(std::u16string_view term, bool caseSensitive) const;
+
+    /**
+     * @brief Keeps the occurrences where a term extending the indexed one occurs, and updates the counts of their lines.
+     * @param cursor The cursor whose buffer is indexed.
+     * @param term The longer term; canNarrow() must have accepted it.
+     */
+    void narrow(const Cursor &cursor, std::u16string_view term);
+
+public:
+    /**
+     * @brief Tells whether the index counts the given term under the given mode.
+     * @param term The term to look for.
+     * @param caseSensitive Whether the comparison is case-sensitive.
+     * @param regex Whether @p term is a regular expression.
+     * @return true when start() ran for exactly this term and mode.
+     */
+    [[nodiscard]] bool isBuiltFor(std::u16string_view term, bool caseSensitive, bool regex = false) const;
+
+    /**
+     * @brief Starts counting the matches of a term, replacing whatever was indexed.
+     *
+     * Sizes the counts without reading the buffer; step() does the counting. A term extending the
+     * indexed one is narrowed down from the occurrences of the indexed one instead, when they are
+     * all known: the counted lines stay counted, and only the others are left to step().
+     *
+     * @param cursor The cursor whose buffer is indexed.
+     * @param term The term to look for; must not be empty.
+     * @param caseSensitive Whether the comparison is case-sensitive.
+     */
+    void start(const Cursor &cursor, std::u16string_view term, bool caseSensitive);
+
+    /**
+     * @brief Starts counting the matches of a regular expression, replacing whatever was indexed.
+     * @param cursor The cursor whose buffer is indexed.
+     * @param regex The compiled pattern; must be valid. Its DFA cache is shared with getScanner().
+     */
+    void start(const Cursor &cursor, std::shared_ptr<Regex> regex);
+
+    /**
+     * @brief Counts the next run of lines of a count start() began.
+     *
+     * No-op once the count is complete. Edits made between two steps are followed as usual.
+     *
+     * @param cursor The cursor whose buffer is indexed.
+     * @param lineBudget The maximum number of lines to count.
+     * @return true while lines remain to be counted.
+     */
+    bool step(const Cursor &cursor, uint32_t lineBudget);
+
+    /**
+     * @brief Counts the matches of a term on every line, replacing whatever was indexed.
+     *
+     * start() and a step() over the whole buffer; edits afterwards only rescan the lines they touch.
+     *
+     * @param cursor The cursor whose buffer is indexed.
+     * @param term The term to look for; must not be empty.
+     * @param caseSensitive Whether the comparison is case-sensitive.
+     */
+    void build(const Cursor &cursor, std::u16string_view term, bool caseSensitive);
+
+    /** @return true when a term is indexed but not every line is counted yet. */
+    [[nodiscard]] bool isCounting() const;
+
+    /** @return The number of lines counted from the top. */
+    [[nodiscard]] uint32_t getCountedLines() const;
+
+    /** @return The scanner of the indexed term, to copy for lookups of the same term; start() must have run. */
+    [[nodiscard]] const LineScanner &getScanner() const;
+
+    /** @return true when a term is indexed, so getScanner() can be called. */
+    [[nodiscard]] bool hasTerm() const;
+
+    /** @return A value changing whenever start() or clear() changes the indexed term or mode. */
+    [[nodiscard]] uint64_t getGeneration() const;
+
+    /** @brief Forgets the indexed term and releases the counts. */
+    void clear();
+
+    /**
+     * @brief Records an edit, shifting the lines after it and marking the lines it touched dirty.
+     *
+     * Does not read the buffer, so a run of edits (an undo step) can be recorded after the cursor
+     * applied all of them. No-op while nothing is indexed.
+     *
+     * @param edit The edit, as returned by the Cursor.
+     */
+    void edit(const BufferEdit &edit);
+
+    /**
+     * @brief Records a run of edits, such as the ones of an undo step, with a single shift.
+     *
+     * The same as recording each one in order, except that the lines between them are marked
+     * dirty as well, the way consecutive edits already merge their dirty lines.
+     *
+     * @param edits The edits, in the order the Cursor returned them.
+     */
+    void edit(std::span<const BufferEdit> edits);
+
+    /**
+     * @brief Ranks a position among the matches.
+     * @param cursor The cursor whose buffer is indexed.
+     * @param line The line of the position.
+     * @param column The column of the position.
+     * @return The ordinal of the match at the position, if any, the matches before it and the total;
+     *         while counting, the ordinal is only known once the lines before the position are counted.
+     */
+    [[nodiscard]] Rank rank(const Cursor &cursor, uint32_t line, uint32_t column);
+
+    /**
+     * @brief Finds the first line after the given one holding at least one match.
+     *
+     * While counting, a line not counted yet may hold one: the first of them is returned as is,
+     * and the caller scans it.
+     *
+     * @param cursor The cursor whose buffer is indexed.
+     * @param line The line to look after.
+     * @return The line, or std::nullopt when no later line holds a match.
+     */
+    [[nodiscard]] std::optional<uint32_t> nextLineWithMatch(const Cursor &cursor, uint32_t line);
+
+    /**
+     * @brief Finds the last line before the given one holding at least one match.
+     *
+     * While counting, a line not counted yet may hold one: the one just before the given line is
+     * returned as is, and the caller scans it.
+     *
+     * @param cursor The cursor whose buffer is indexed.
+     * @param line The line to look before.
+     * @return The line, or std::nullopt when no earlier line holds a match.
+     */
+    [[nodiscard]] std::optional<uint32_t> previousLineWithMatch(const Cursor &cursor, uint32_t line);
+
+    /** @return The bytes held by the counts and the occurrences. */
+    [[nodiscard]] std::size_t getMemoryUsage() const;
+};
+
+
+#endif //MATCH_INDEX_H
@@ -0,0 +1,120 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "MatchRangeCache.h"
+
+#include <algorithm>
+
+
+void MatchRangeCache::moveWindow(const uint32_t line) const {
+    // Centered on the line, so scrolling either way keeps half a window of rows before moving again
+    const auto start_line = line > WINDOW_LINE_COUNT / 2 ? line - WINDOW_LINE_COUNT / 2 : 0;
+    auto rows = std::vector<Row>(WINDOW_LINE_COUNT);
+    for (size_t row = 0; row < rows.size(); ++row) {
+        const auto covered = start_line + row;
+        if (covered >= m_start_line && covered - m_start_line < m_rows.size()) {
+            rows[row] = std::move(m_rows[covered - m_start_line]);
+        }
+    }
+
+    m_rows = std::move(rows);
+    m_start_line = start_line;
+}
+
+std::span<const MatchRangeCache::Range> MatchRangeCache::getRanges(const Cursor &cursor, const MatchIndex &index, const uint32_t line) const {
+    if (m_generation != index.getGeneration()) {
+        m_generation = index.getGeneration();
+        m_rows = std::vector<Row>{};
+        m_scanner.reset();
+        if (index.hasTerm()) {
+            m_scanner.emplace(index.getScanner());
+        }
+    }
+
+    if (!m_scanner) {
+        return {};
+    }
+
+    if (line < m_start_line || line - m_start_line >= m_rows.size()) {
+        moveWindow(line);
+    }
+
+    auto &row = m_rows[line - m_start_line];
+    if (!row.scanned) {
+        const auto string = cursor.getString(line);
+        row.ranges.clear();
+        m_scanner->setLine(string);
+        for (auto position = m_scanner->indexOf(0); position != std::u16string_view::npos;) {
+            row.ranges.push_back(Range{.column = static_cast<uint32_t>(position), .length = static_cast<uint32_t>(m_scanner->matchLength())});
+            const auto next = m_scanner->nextFrom(position);
+            position = next <= string.length() ? m_scanner->indexOf(next) : std::u16string_view::npos;
+        }
+        row.scanned = true;
+        ++m_scan_count;
+    }
+
+    return row.ranges;
+}
+
+void MatchRangeCache::edit(const BufferEdit &edit) {
+    if (m_rows.empty()) {
+        return;
+    }
+
+    const auto first = edit.start.line;
+    const auto old_last = edit.old_end.line;
+    const auto new_last = edit.new_end.line;
+    const auto end_line = m_start_line + static_cast<uint32_t>(m_rows.size());
+    if (first >= end_line) {
+        // Below the window: nothing it covers moved
+        return;
+    }
+
+    if (old_last < m_start_line) {
+        // Above the window: the lines it covers only moved
+        m_start_line = m_start_line - old_last + new_last;
+        return;
+    }
+
+    if (first < m_start_line) {
+        // The edit runs into the window from above: the rows past it now follow its new last line
+        const auto replaced = std::min<size_t>(old_last + 1 - m_start_line, m_rows.size());
+        m_rows.erase(m_rows.begin(), m_rows.begin() + static_cast<std::ptrdiff_t>(replaced));
+        m_start_line = new_last + 1;
+    } else {
+        // The rows of the replaced lines make room for as many unscanned rows as the edit left lines
+        const auto at = static_cast<std::ptrdiff_t>(first - m_start_line);
+        const auto replaced_end = static_cast<std::ptrdiff_t>(std::min<size_t>(old_last + 1 - m_start_line, m_rows.size()));
+        m_rows.erase(m_rows.begin() + at, m_rows.begin() + replaced_end);
+        m_rows.insert(m_rows.begin() + at, std::min<size_t>(new_last - first + 1, WINDOW_LINE_COUNT), Row{});
+    }
+
+    m_rows.resize(WINDOW_LINE_COUNT);
+}
+
+uint32_t MatchRangeCache::getScanCount() const {
+    return m_scan_count;
+}
+
+std::size_t MatchRangeCache::getMemoryUsage() const {
+    auto bytes = m_rows.capacity() * sizeof(Row);
+    for (const auto &row : m_rows) {
+        bytes += row.ranges.capacity() * sizeof(Range);
+    }
+    return bytes;
+}
@@ -0,0 +1,118 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MATCH_RANGE_CACHE_H
+#define MATCH_RANGE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "buffer/BufferEdit.h"
+#include "../base/LineScanner.h"
+#include "Cursor.h"
+#include "MatchIndex.h"
+
+
+/**
+ * @brief The matches of the search term on the lines around the view, for the editor to highlight.
+ *
+ * Rows are scanned on the first request only, so the lines never drawn are never scanned, and
+ * scrolling back over lines already scanned costs nothing. The rows cover a window of lines,
+ * moved when a request falls outside it; the rows both windows cover are kept. Edits mark the
+ * rows they touch unscanned and shift the others, without reading the buffer, and a new term in
+ * the MatchIndex followed drops every row.
+ *
+ * Every BufferEdit applied to the cursor must reach edit(), in order; CursorContext::notifyEdit
+ * does it along with the search index.
+ */
+class MatchRangeCache final {
+public:
+    /** Number of lines covered by the window of rows; several screens of text. */
+    static constexpr uint32_t WINDOW_LINE_COUNT = 512;
+
+    /** @brief One match on a line. */
+    struct Range final {
+        uint32_t column; ///< Column the match starts at.
+        uint32_t length; ///< Length of the match, in code units.
+    };
+
+private:
+    /** @brief The matches of one line, once scanned. */
+    struct Row final {
+        std::vector<Range> ranges; ///< The matches, in the order of a non-overlapping enumeration.
+        bool scanned = false;      ///< false until the line is scanned, and again once edited.
+    };
+
+    /** Scanner of the term the rows were scanned for; empty while the index holds none. */
+    mutable std::optional<LineScanner> m_scanner;
+
+    /** MatchIndex::getGeneration() of the term the rows were scanned for. */
+    mutable uint64_t m_generation = 0;
+
+    /** Rows of the lines from m_start_line; empty, or WINDOW_LINE_COUNT rows long. */
+    mutable std::vector<Row> m_rows;
+
+    /** First line covered by the rows. */
+    mutable uint32_t m_start_line = 0;
+
+    /** Number of lines scanned since construction. */
+    mutable uint32_t m_scan_count = 0;
+
+    /**
+     * @brief Moves the window so it covers a line, keeping the rows both windows cover.
+     * @param line The line the new window must cover.
+     */
+    void moveWindow(uint32_t line) const;
+
+public:
+    /**
+     * @brief Returns the matches of the indexed term on a line, scanning it on the first request.
+     *
+     * The index is only read for its term: a term differing from the one the rows were scanned for
+     * drops them all first.
+     *
+     * @param cursor The cursor whose buffer is scanned.
+     * @param index The search index whose term is highlighted.
+     * @param line The line; must be a line of the buffer.
+     * @return The matches of the line, in column order; empty while no term is indexed. Valid until
+     *         the next call or edit.
+     */
+    [[nodiscard]] std::span<const Range> getRanges(const Cursor &cursor, const MatchIndex &index, uint32_t line) const;
+
+    /**
+     * @brief Records an edit: the rows of the lines it touched are scanned again when next requested.
+     *
+     * Does not read the buffer, so a run of edits (an undo step) can be recorded after the cursor
+     * applied all of them.
+     *
+     * @param edit The edit, as returned by the Cursor.
+     */
+    void edit(const BufferEdit &edit);
+
+    /** @return The number of lines scanned since construction. */
+    [[nodiscard]] uint32_t getScanCount() const;
+
+    /** @return The bytes held by the rows. */
+    [[nodiscard]] std::size_t getMemoryUsage() const;
+};
+
+
+#endif //MATCH_RANGE_CACHE_H
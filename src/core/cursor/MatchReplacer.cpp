@@ -0,0 +1,51 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "MatchReplacer.h"
+
+
+std::u16string MatchReplacer::expand(const LineScanner &scanner, const std::u16string_view line, const uint32_t column, const uint32_t length, const std::u16string_view replacement) {
+    const auto &regex = scanner.getRegex();
+    if (!regex) {
+        return std::u16string(replacement);
+    }
+
+    const auto groups = regex->capture(line, Regex::Span{.start = column, .end = column + length});
+    return Regex::expand(replacement, line, groups);
+}
+
+MatchReplacer::Result MatchReplacer::replaceAll(Cursor &cursor, const LineScanner &scanner, const std::u16string_view replacement) {
+    // Matches come from the top, which is the order the batch wants; the buffer only changes at
+    // the commit, so each match is still read against the text it was found in
+    auto count = 0u;
+    cursor.beginBatch();
+    scanner.forEachMatch(cursor, 0, 0, [&](const uint32_t line, const uint32_t column) {
+        const auto length = static_cast<uint32_t>(scanner.matchLength());
+        const auto range = TextRange{.line_start = line, .column_start = column, .line_end = line, .column_end = column + length};
+        if (scanner.getRegex()) {
+            cursor.batchReplace(range, expand(scanner, cursor.getString(line), column, length, replacement));
+        } else {
+            cursor.batchReplace(range, replacement);
+        }
+
+        ++count;
+        return true;
+    });
+
+    return Result{.edit = cursor.commitBatch(), .count = count};
+}
@@ -0,0 +1,82 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MATCH_REPLACER_H
+#define MATCH_REPLACER_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Cursor.h"
+#include "buffer/BufferEdit.h"
+#include "../base/LineScanner.h"
+
+
+/**
+ * @brief Replaces the matches of a scanner, one at a time or all of them in one buffer splice.
+ *
+ * Replacing every match through the cursor one by one costs an erase, an insert, a history entry
+ * and a re-parse per match, each on a buffer that the previous one just changed. replaceAll queues
+ * every match in a cursor batch instead (Cursor::beginBatch): one splice, one undo step and one
+ * BufferEdit, whatever the number of matches, and the history keeps the matches only, not the text
+ * between them.
+ */
+class MatchReplacer final {
+public:
+    /** @brief Outcome of replaceAll. */
+    struct Result final {
+        std::optional<BufferEdit> edit; ///< The splice applied, or std::nullopt when nothing matched.
+        uint32_t count;                 ///< Number of matches replaced.
+    };
+
+    /** @brief Deleted constructor; this class is static-only. */
+    MatchReplacer() = delete;
+
+    /**
+     * @brief Returns the text one match is replaced with.
+     *
+     * The replacement as given for a literal scanner; for a regex one, the replacement with its
+     * group references expanded against the match (see Regex::expand).
+     *
+     * @param scanner The scanner that found the match.
+     * @param line The text of the line holding the match.
+     * @param column The column where the match starts.
+     * @param length The length of the match.
+     * @param replacement The replacement, as given to the command.
+     * @return The text to put in place of the match.
+     */
+    [[nodiscard]] static std::u16string expand(const LineScanner &scanner, std::u16string_view line, uint32_t column, uint32_t length, std::u16string_view replacement);
+
+    /**
+     * @brief Replaces every match of a scanner in a buffer, as a single edit.
+     *
+     * Matches are the ones LineScanner::forEachMatch enumerates from the top, so the text inserted
+     * is never matched again. The caret lands after the last replacement.
+     *
+     * @param cursor The cursor whose buffer is rewritten.
+     * @param scanner The scanner holding the term or the pattern.
+     * @param replacement The replacement, as given to the command.
+     * @return The edit to pass on to whatever follows the buffer, and the number of matches replaced.
+     */
+    [[nodiscard]] static Result replaceAll(Cursor &cursor, const LineScanner &scanner, std::u16string_view replacement);
+};
+
+
+#endif //MATCH_REPLACER_H
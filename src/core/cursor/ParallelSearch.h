@@ -0,0 +1,41 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+#include <cstdint>
+
+
+/**
+ * @brief Sizes the worker pools of the parallel scans: search_all, grep and the line sort.
+ *
+ * The scans themselves live with the jobs running them (SearchAllJob, GrepJob) or with the
+ * rewrite they serve (LineTransform).
+ */
+class ParallelSearch final {
+public:
+    /** @brief Deleted constructor; this class is static-only. */
+    ParallelSearch() = delete;
+
+    /** @return The number of workers worth running on this machine, at least 1. */
+    [[nodiscard]] static uint32_t getDefaultThreadCount();
+};
+
+
+#endif //PARALLEL_SEARCH_H
@@ -0,0 +1,83 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef READ_GATE_H
+#define READ_GATE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+
+
+/**
+ * @brief Lets background threads read a buffer the main thread keeps editing.
+ *
+ * Every Cursor owns one, shared with the readers, so it outlives the buffer. An edit counts itself
+ * before it locks the gate exclusively; a reader names the count it started from, and only gets
+ * the lock while nothing was edited since. A reader that loses the race stops reading that buffer:
+ * its text moved under the positions it holds. Destroying the Cursor counts as an edit, so a
+ * closed buffer is never read again.
+ *
+ * A reader holds the lock for a bounded piece of work, a slice of lines, and the count is bumped
+ * before the exclusive lock is requested: no new reader gets in, so an edit waits for the slices
+ * in flight only.
+ */
+class ReadGate final {
+private:
+    /** Readers share it; an edit holds it exclusively. */
+    std::shared_mutex m_mutex;
+
+    /** Number of edits so far. */
+    std::atomic<uint64_t> m_edit_count{0};
+
+public:
+    /** @return The number of edits so far; a reader starts from it. */
+    [[nodiscard]] uint64_t getEditCount() const {
+        return m_edit_count;
+    }
+
+    /**
+     * @brief Locks the gate for reading, unless the buffer was edited since a given count.
+     * @param editCount The count the reader started from.
+     * @return A held lock, or an empty one when the buffer was edited.
+     */
+    [[nodiscard]] std::shared_lock<std::shared_mutex> lockUnchanged(const uint64_t editCount) {
+        if (m_edit_count != editCount) {
+            return {};
+        }
+
+        auto lock = std::shared_lock(m_mutex);
+        if (m_edit_count != editCount) {
+            return {};
+        }
+        return lock;
+    }
+
+    /**
+     * @brief Counts an edit, then waits for the readers in flight and locks them out.
+     * @return The lock to hold while the buffer changes.
+     */
+    [[nodiscard]] std::unique_lock<std::shared_mutex> lockForEdit() {
+        ++m_edit_count;
+        return std::unique_lock(m_mutex);
+    }
+};
+
+
+#endif //READ_GATE_H
@@ -0,0 +1,35 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SHARED_TEXT_H
+#define SHARED_TEXT_H
+
+#include <memory>
+#include <string>
+
+
+/**
+ * @brief An immutable text shared by reference count.
+ *
+ * Handed from the cursor to the undo history for the text of a large deletion: the copy taken out
+ * of the buffer is the one the history keeps, instead of a second one made into its arena.
+ */
+using SharedText = std::shared_ptr<const std::u16string>;
+
+
+#endif //SHARED_TEXT_H
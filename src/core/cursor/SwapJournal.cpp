@@ -0,0 +1,321 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "SwapJournal.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <system_error>
+#include <utility>
+
+#include "Cursor.h"
+#include "buffer/LineBuffer.h"
+
+
+/** Bytes every swap file starts with: a tag, then the format version. */
+static constexpr char SWAP_MAGIC[8] = {'B', 'B', 'L', 'O', 'C', 'S', 'W', '1'};
+
+/** Kind byte of a record replacing a range. */
+static constexpr char RECORD_EDIT = 'E';
+
+/** Kind byte of a record holding the whole buffer. */
+static constexpr char RECORD_SNAPSHOT = 'S';
+
+/**
+ * @brief Appends the bytes of a value to a record.
+ *
+ * @param bytes The bytes being built.
+ * @param value The value; a plain integer, whose bytes are written in native order.
+ */
+template<typename TValue>
+static void putField(std::vector<char> &bytes, const TValue value) {
+    const auto *const raw = reinterpret_cast<const char *>(&value);
+    bytes.insert(bytes.end(), raw, raw + sizeof(TValue));
+}
+
+/**
+ * @brief Reads a value of a record, when the swap file holds enough bytes for it.
+ *
+ * @param bytes The swap file.
+ * @param offset The offset of the value, advanced past it when it was read.
+ * @param value Receives the value.
+ * @return false when the file ends before the value does.
+ */
+template<typename TValue>
+static bool getField(const std::vector<char> &bytes, std::size_t &offset, TValue &value) {
+    if (bytes.size() - offset < sizeof(TValue)) {
+        return false;
+    }
+
+    std::memcpy(&value, bytes.data() + offset, sizeof(TValue));
+    offset += sizeof(TValue);
+    return true;
+}
+
+/**
+ * @brief Reads a text of a record, when the swap file holds all of it.
+ *
+ * @param bytes The swap file.
+ * @param offset The offset of the text, advanced past it when it was read.
+ * @param length The number of code units of the text.
+ * @param text Receives the text.
+ * @return false when the file ends before the text does.
+ */
+static bool getText(const std::vector<char> &bytes, std::size_t &offset, const uint64_t length, std::u16string &text) {
+    if ((bytes.size() - offset) / sizeof(char16_t) < length) {
+        return false;
+    }
+
+    text.resize(length);
+    std::memcpy(text.data(), bytes.data() + offset, length * sizeof(char16_t));
+    offset += length * sizeof(char16_t);
+    return true;
+}
+
+
+SwapJournal::SwapJournal(std::string path)
+    : m_path(std::move(path)),
+      m_journaled_bytes(0),
+      m_pending_rebase(false),
+      m_queued(0),
+      m_written(0),
+      m_hurry(false),
+      m_thread([this](const std::stop_token &stopToken) { run(stopToken); }) {}
+
+SwapJournal::~SwapJournal() {
+    // Whatever was pending is dropped: a journal that is destroyed has nothing left to recover
+    m_thread.request_stop();
+    m_thread.join();
+
+    auto error_code = std::error_code{};
+    std::filesystem::remove(m_path, error_code);
+}
+
+std::string SwapJournal::pathFor(const std::string_view filePath) {
+    const auto path = std::filesystem::path(filePath);
+    return (path.parent_path() / ("." + path.filename().string() + ".bbswp")).string();
+}
+
+void SwapJournal::run(const std::stop_token &stopToken) {
+    // The two buffers trade places on every batch, so both keep their capacity and recording an
+    // edit allocates nothing once the typing has warmed them up
+    auto records = std::vector<char>();
+
+    auto lock = std::unique_lock(m_mutex);
+    while (true) {
+        if (!m_wake.wait(lock, stopToken, [this] { return m_written != m_queued; })) {
+            // Stopping: the destructor removes the swap file, so there is nothing worth writing
+            return;
+        }
+
+        // Let a burst of typing gather into one write, unless someone waits for it
+        (void) m_wake.wait_for(lock, stopToken, std::chrono::milliseconds(FLUSH_INTERVAL_MS), [this] { return m_hurry; });
+        if (stopToken.stop_requested()) {
+            return;
+        }
+
+        records.swap(m_pending);
+        auto snapshot = std::move(m_pending_snapshot);
+        m_pending_snapshot.reset();
+        const auto rebase = std::exchange(m_pending_rebase, false);
+        const auto batch = m_queued;
+
+        lock.unlock();
+        write(rebase, snapshot, records);
+        records.clear();
+        lock.lock();
+
+        m_written = batch;
+        m_hurry = false;
+        m_wake.notify_all();
+    }
+}
+
+void SwapJournal::write(const bool rebase, const std::optional<std::u16string> &snapshot, const std::vector<char> &records) const {
+    auto error_code = std::error_code{};
+    if (rebase) {
+        std::filesystem::remove(m_path, error_code);
+    }
+
+    if (snapshot) {
+        // Written aside and renamed over, so a crash while compacting leaves the previous journal
+        auto header = std::vector<char>(std::begin(SWAP_MAGIC), std::end(SWAP_MAGIC));
+        header.push_back(RECORD_SNAPSHOT);
+        putField(header, static_cast<uint64_t>(snapshot->size()));
+
+        const auto temporary_path = m_path + ".tmp";
+        auto ofs = std::ofstream(temporary_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        ofs.write(header.data(), static_cast<std::streamsize>(header.size()));
+        ofs.write(reinterpret_cast<const char *>(snapshot->data()), static_cast<std::streamsize>(snapshot->size() * sizeof(char16_t)));
+        ofs.write(records.data(), static_cast<std::streamsize>(records.size()));
+        ofs.close();
+        if (!ofs.fail()) {
+            std::filesystem::rename(temporary_path, m_path, error_code);
+        }
+        if (ofs.fail() || error_code) {
+            std::filesystem::remove(temporary_path, error_code);
+        }
+        return;
+    }
+
+    if (records.empty()) {
+        return;
+    }
+
+    // A swap file that does not exist yet starts with the header: its edits apply to the file on disk
+    const auto exists = std::filesystem::exists(m_path, error_code);
+    auto ofs = std::ofstream(m_path, std::ios::out | std::ios::binary | std::ios::app);
+    if (!exists) {
+        ofs.write(SWAP_MAGIC, sizeof(SWAP_MAGIC));
+    }
+    ofs.write(records.data(), static_cast<std::streamsize>(records.size()));
+}
+
+void SwapJournal::record(const BufferEdit &edit, const std::u16string_view inserted) {
+    auto lock = std::unique_lock(m_mutex);
+    const auto was_idle = m_written == m_queued;
+    const auto size_before = m_pending.size();
+
+    m_pending.push_back(RECORD_EDIT);
+    putField(m_pending, edit.start.line);
+    putField(m_pending, edit.start.column);
+    putField(m_pending, edit.old_end.line);
+    putField(m_pending, edit.old_end.column);
+    putField(m_pending, static_cast<uint32_t>(inserted.size()));
+    const auto *const units = reinterpret_cast<const char *>(inserted.data());
+    m_pending.insert(m_pending.end(), units, units + inserted.size() * sizeof(char16_t));
+
+    m_journaled_bytes += m_pending.size() - size_before;
+    ++m_queued;
+    lock.unlock();
+
+    // The thread only needs waking for the first edit of a batch; it gathers the rest on its own
+    if (was_idle) {
+        m_wake.notify_all();
+    }
+}
+
+void SwapJournal::rebase() {
+    {
+        auto lock = std::unique_lock(m_mutex);
+        m_pending.clear();
+        m_pending_snapshot.reset();
+        m_pending_rebase = true;
+        m_journaled_bytes = 0;
+        ++m_queued;
+    }
+    m_wake.notify_all();
+}
+
+bool SwapJournal::wantsSnapshot(const std::size_t contentBytes) const {
+    return m_journaled_bytes > COMPACT_MIN_BYTES && m_journaled_bytes > 2 * static_cast<uint64_t>(contentBytes);
+}
+
+void SwapJournal::snapshot(std::u16string content) {
+    {
+        auto lock = std::unique_lock(m_mutex);
+        m_pending.clear();
+        m_pending_snapshot = std::move(content);
+        m_pending_rebase = false;
+        m_journaled_bytes = 0;
+        ++m_queued;
+    }
+    m_wake.notify_all();
+}
+
+void SwapJournal::flush() {
+    auto lock = std::unique_lock(m_mutex);
+    const auto target = m_queued;
+    m_hurry = true;
+    m_wake.notify_all();
+    m_wake.wait(lock, [this, target] { return m_written >= target; });
+}
+
+bool SwapJournal::hasRecovery(const std::string &filePath) {
+    const auto swap_path = pathFor(filePath);
+    auto error_code = std::error_code{};
+    const auto swap_time = std::filesystem::last_write_time(swap_path, error_code);
+    if (error_code) {
+        return false;
+    }
+
+    const auto file_time = std::filesystem::last_write_time(filePath, error_code);
+    return error_code || swap_time > file_time;
+}
+
+std::optional<SwapJournal::Recovery> SwapJournal::recover(const std::string &swapPath, const std::u16string_view diskContent) {
+    auto ifs = std::ifstream(swapPath, std::ios::in | std::ios::binary);
+    if (!ifs) {
+        return std::nullopt;
+    }
+
+    const auto bytes = std::vector<char>(std::istreambuf_iterator(ifs), std::istreambuf_iterator<char>());
+    if (ifs.bad() || bytes.size() < sizeof(SWAP_MAGIC) || std::memcmp(bytes.data(), SWAP_MAGIC, sizeof(SWAP_MAGIC)) != 0) {
+        return std::nullopt;
+    }
+
+    auto offset = sizeof(SWAP_MAGIC);
+    auto text = std::u16string();
+    auto recovery = Recovery{.content = {}, .edit_count = 0, .complete = true};
+
+    // The edits replay through a scratch cursor, which knows how to replace a range of lines
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    if (auto length = uint64_t{0}; offset < bytes.size() && bytes[offset] == RECORD_SNAPSHOT) {
+        ++offset;
+        if (!getField(bytes, offset, length) || !getText(bytes, offset, length, text)) {
+            return std::nullopt;
+        }
+        (void) cursor.loadContent(text);
+    } else {
+        (void) cursor.loadContent(diskContent);
+    }
+
+    while (offset < bytes.size()) {
+        auto range = TextRange{};
+        auto length = uint32_t{0};
+        const auto kind = bytes[offset++];
+        if (kind != RECORD_EDIT
+            || !getField(bytes, offset, range.line_start) || !getField(bytes, offset, range.column_start)
+            || !getField(bytes, offset, range.line_end) || !getField(bytes, offset, range.column_end)
+            || !getField(bytes, offset, length) || !getText(bytes, offset, length, text)) {
+            // A record cut short is the one the crash interrupted
+            recovery.complete = false;
+            break;
+        }
+
+        // A range that does not fit means the file changed under the journal: stop before making it worse
+        const auto fits = [&cursor](const uint32_t line, const uint32_t column) {
+            return line < cursor.getLineCount() && column <= cursor.getString(line).length();
+        };
+        const auto ordered = range.line_start < range.line_end || (range.line_start == range.line_end && range.column_start <= range.column_end);
+        if (!fits(range.line_start, range.column_start) || !fits(range.line_end, range.column_end) || !ordered) {
+            recovery.complete = false;
+            break;
+        }
+
+        (void) cursor.replace(range, text);
+        ++recovery.edit_count;
+    }
+
+    recovery.content = cursor.getText();
+    return recovery;
+}
@@ -0,0 +1,188 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SWAP_JOURNAL_H
+#define SWAP_JOURNAL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "buffer/BufferEdit.h"
+
+
+/**
+ * @brief Journals the edits of a file-backed buffer to a swap file, so they survive a crash.
+ *
+ * The swap file sits next to the file, named after it (`.name.bbswp`). It holds a header, an
+ * optional snapshot of the whole buffer, then every edit made since, as the range it replaced and
+ * the text it inserted; without a snapshot the edits apply to the file as it is on disk.
+ *
+ * record() only appends the edit to a buffer in memory, under a mutex no one else holds for long,
+ * so the typing path never touches the disk. A background thread wakes once something is pending,
+ * gathers for FLUSH_INTERVAL_MS, then swaps the pending buffer for its own and writes it out. Once
+ * the edits outgrow the buffer itself, wantsSnapshot() asks the owner to compact the journal into
+ * a snapshot, which is written to a sibling file and renamed over the swap file.
+ *
+ * The swap file is removed once the buffer matches the disk again (rebase()), and when the journal
+ * is destroyed: only a crash leaves one behind, for recover() to replay.
+ */
+class SwapJournal final {
+public:
+    /** Time the thread gathers edits for, in milliseconds, once the first one is pending. */
+    static constexpr uint32_t FLUSH_INTERVAL_MS = 500;
+
+    /** Bytes of edits below which the journal is never compacted, whatever the size of the buffer. */
+    static constexpr uint64_t COMPACT_MIN_BYTES = 1024u * 1024u;
+
+    /** @brief What recover() could rebuild from a swap file. */
+    struct Recovery final {
+        std::u16string content; ///< The buffer as it stood at the last edit that was flushed.
+        std::size_t edit_count; ///< Number of edits replayed over the file or the snapshot.
+        bool complete;          ///< false when a damaged or torn record cut the replay short.
+    };
+
+private:
+    /** Path of the swap file. UTF-8. */
+    const std::string m_path;
+
+    /** Bytes of edits journaled since the last snapshot or rebase; main thread only. */
+    uint64_t m_journaled_bytes;
+
+    /** Guards every member below it, up to the thread. */
+    std::mutex m_mutex;
+
+    /** Wakes the thread when work is queued or a flush is awaited, and flush() when a batch is written. */
+    std::condition_variable_any m_wake;
+
+    /** Records waiting for the thread, in file format. */
+    std::vector<char> m_pending;
+
+    /** Snapshot waiting for the thread; the pending records apply over it. */
+    std::optional<std::u16string> m_pending_snapshot;
+
+    /** Set when the swap file must be removed before the pending records are written. */
+    bool m_pending_rebase;
+
+    /** Number of requests queued so far: edits, snapshots and rebases. */
+    uint64_t m_queued;
+
+    /** Number of requests the thread wrote out; the thread has work while it is below m_queued. */
+    uint64_t m_written;
+
+    /** Set by flush() so the thread writes without gathering first. */
+    bool m_hurry;
+
+    /** The writer; declared last so it starts once everything it reads is constructed. */
+    std::jthread m_thread;
+
+    /**
+     * @brief Writes whatever is pending, until a stop is requested and nothing is.
+     * @param stopToken Requests the thread to stop, dropping what it did not write yet.
+     */
+    void run(const std::stop_token &stopToken);
+
+    /**
+     * @brief Writes a batch to the swap file.
+     *
+     * @param rebase Whether the swap file must be removed first.
+     * @param snapshot The snapshot the swap file must be rewritten with, if any.
+     * @param records The records to append.
+     */
+    void write(bool rebase, const std::optional<std::u16string> &snapshot, const std::vector<char> &records) const;
+
+public:
+    /** @brief Deleted copy constructor. */
+    SwapJournal(const SwapJournal &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    SwapJournal &operator=(const SwapJournal &) = delete;
+
+    /**
+     * @brief Starts journaling the edits of a buffer that matches a file on disk.
+     *
+     * Nothing is written until the first edit: an existing swap file stays as it is until then.
+     *
+     * @param path The swap file, as returned by pathFor(). UTF-8.
+     */
+    explicit SwapJournal(std::string path);
+
+    /** @brief Stops the thread and removes the swap file; pending records are discarded, as a clean close needs no swap. */
+    ~SwapJournal();
+
+    /**
+     * @brief Returns the swap file of a file.
+     * @param filePath The file. UTF-8.
+     * @return The path of its swap file. UTF-8.
+     */
+    [[nodiscard]] static std::string pathFor(std::string_view filePath);
+
+    /**
+     * @brief Queues an edit that was just applied to the buffer.
+     * @param edit The edit, whose start and old end give the replaced range.
+     * @param inserted The text the edit put in that range.
+     */
+    void record(const BufferEdit &edit, std::u16string_view inserted);
+
+    /** @brief Drops every edit: the buffer matches the file on disk again, so there is nothing to recover. */
+    void rebase();
+
+    /**
+     * @brief Tells whether the edits journaled since the last snapshot outgrew the buffer.
+     * @param contentBytes The size of the text of the buffer, in bytes.
+     * @return true when a snapshot would make the swap file shorter by at least half.
+     */
+    [[nodiscard]] bool wantsSnapshot(std::size_t contentBytes) const;
+
+    /**
+     * @brief Compacts the journal into a snapshot of the buffer.
+     * @param content The whole text of the buffer, as it stands after the last recorded edit.
+     */
+    void snapshot(std::u16string content);
+
+    /** @brief Waits until everything queued so far is on disk. */
+    void flush();
+
+    /**
+     * @brief Tells whether a file has a swap file written after it.
+     * @param filePath The file. UTF-8.
+     * @return true when the swap file exists and is newer than the file, or the file is gone.
+     */
+    [[nodiscard]] static bool hasRecovery(const std::string &filePath);
+
+    /**
+     * @brief Rebuilds a buffer from a swap file.
+     *
+     * A record that is cut short, or whose range does not fit the text, ends the replay: what was
+     * rebuilt until then is returned, flagged as incomplete.
+     *
+     * @param swapPath The swap file. UTF-8.
+     * @param diskContent The file as it is on disk, which the edits apply to unless the swap file holds a snapshot.
+     * @return The rebuilt buffer, or std::nullopt when the swap file cannot be read or is not one.
+     */
+    [[nodiscard]] static std::optional<Recovery> recover(const std::string &swapPath, std::u16string_view diskContent);
+};
+
+
+#endif //SWAP_JOURNAL_H
@@ -0,0 +1,199 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "UndoArena.h"
+
+#include <algorithm>
+
+
+UndoArena::UndoArena()
+    : m_end(ORIGIN) {}
+
+UndoArena::Chunk &UndoArena::reserve(Span &tail, const std::size_t extra) {
+    if (tail.length == 0) {
+        tail.position = m_end;
+    }
+
+    if (!m_chunks.empty() && !m_chunks.back().shared && m_chunks.back().capacity - m_chunks.back().used >= extra) {
+        return m_chunks.back();
+    }
+
+    // A span growing past its chunk gets twice the room it needs, so a long typed run moves a
+    // logarithmic number of times; a text stored at once gets exactly its size
+    const auto needed = tail.length + extra;
+    const auto capacity = needed <= CHUNK_UNITS ? CHUNK_UNITS : tail.length > 0 ? needed * 2 : needed;
+    auto chunk = Chunk{
+        .units = capacity == CHUNK_UNITS && m_spare ? std::move(m_spare) : std::make_unique_for_overwrite<char16_t[]>(capacity),
+        .shared = nullptr,
+        .capacity = capacity,
+        .used = 0,
+        .base = m_end - tail.length
+    };
+
+    // The tail keeps its position and moves physically, so the spans pointing at it stay valid
+    if (tail.length > 0) {
+        auto &back = m_chunks.back();
+        const auto *const units = unitsOf(back) + (tail.position - back.base);
+        std::copy_n(units, tail.length, chunk.units.get());
+        chunk.used = tail.length;
+        back.used -= tail.length;
+        if (back.used == 0) {
+            recycle(back);
+            m_chunks.pop_back();
+        }
+    }
+
+    return m_chunks.emplace_back(std::move(chunk));
+}
+
+const UndoArena::Chunk &UndoArena::chunkAt(const uint64_t position) const {
+    const auto after = std::ranges::upper_bound(m_chunks, position, {}, &Chunk::base);
+    return *std::prev(after);
+}
+
+void UndoArena::recycle(Chunk &chunk) {
+    if (chunk.units && chunk.capacity == CHUNK_UNITS && !m_spare) {
+        m_spare = std::move(chunk.units);
+    }
+}
+
+const char16_t *UndoArena::unitsOf(const Chunk &chunk) {
+    return chunk.shared ? chunk.shared->data() : chunk.units.get();
+}
+
+UndoArena::Span UndoArena::append(const std::u16string_view text) {
+    auto span = Span{.position = m_end, .length = 0};
+    extend(span, text);
+    return span;
+}
+
+UndoArena::Span UndoArena::adopt(SharedText text) {
+    if (text->empty()) {
+        return {.position = m_end, .length = 0};
+    }
+
+    const auto length = text->length();
+    const auto span = Span{.position = m_end, .length = static_cast<uint32_t>(length)};
+    m_chunks.emplace_back(Chunk{
+        .units = nullptr,
+        .shared = std::move(text),
+        .capacity = length,
+        .used = length,
+        .base = m_end
+    });
+    m_end += length;
+    return span;
+}
+
+UndoArena::Span UndoArena::storeFront(const std::u16string_view text) {
+    if (m_chunks.empty() || text.empty()) {
+        return append(text);
+    }
+
+    // Sized to fit and full from the start: text is only ever added at the back, so nothing grows here
+    const auto capacity = text.length() <= CHUNK_UNITS ? CHUNK_UNITS : text.length();
+    const auto base = m_chunks.front().base - text.length();
+    auto &chunk = m_chunks.emplace_front(Chunk{
+        .units = capacity == CHUNK_UNITS && m_spare ? std::move(m_spare) : std::make_unique_for_overwrite<char16_t[]>(capacity),
+        .shared = nullptr,
+        .capacity = capacity,
+        .used = text.length(),
+        .base = base
+    });
+    std::ranges::copy(text, chunk.units.get());
+    return {.position = base, .length = static_cast<uint32_t>(text.length())};
+}
+
+void UndoArena::extend(Span &span, const std::u16string_view text) {
+    if (text.empty()) {
+        return;
+    }
+
+    auto &chunk = reserve(span, text.length());
+    std::ranges::copy(text, chunk.units.get() + chunk.used);
+    chunk.used += text.length();
+    m_end += text.length();
+    span.length += static_cast<uint32_t>(text.length());
+}
+
+void UndoArena::prepend(Span &span, const std::u16string_view text) {
+    if (text.empty()) {
+        return;
+    }
+
+    auto &chunk = reserve(span, text.length());
+    auto *const units = chunk.units.get() + (span.position - chunk.base);
+    std::copy_backward(units, units + span.length, units + span.length + text.length());
+    std::ranges::copy(text, units);
+    chunk.used += text.length();
+    m_end += text.length();
+    span.length += static_cast<uint32_t>(text.length());
+}
+
+bool UndoArena::isBack(const Span &span) const {
+    return span.length == 0 || span.position + span.length == m_end;
+}
+
+std::u16string_view UndoArena::view(const Span &span) const {
+    if (span.length == 0) {
+        return {};
+    }
+
+    const auto &chunk = chunkAt(span.position);
+    return {unitsOf(chunk) + (span.position - chunk.base), span.length};
+}
+
+uint64_t UndoArena::end() const {
+    return m_end;
+}
+
+void UndoArena::releaseBefore(const uint64_t position) {
+    while (!m_chunks.empty() && m_chunks.front().base + m_chunks.front().used <= position) {
+        recycle(m_chunks.front());
+        m_chunks.pop_front();
+    }
+}
+
+void UndoArena::truncate(const uint64_t position) {
+    while (!m_chunks.empty() && m_chunks.back().base >= position) {
+        recycle(m_chunks.back());
+        m_chunks.pop_back();
+    }
+
+    if (!m_chunks.empty()) {
+        auto &back = m_chunks.back();
+        back.used = std::min<std::size_t>(back.used, position - back.base);
+    }
+    m_end = position;
+}
+
+void UndoArena::clear() {
+    for (auto &chunk : m_chunks) {
+        recycle(chunk);
+    }
+    m_chunks.clear();
+    m_end = ORIGIN;
+}
+
+std::size_t UndoArena::getMemoryUsage() const {
+    auto units = m_spare ? CHUNK_UNITS : 0;
+    for (const auto &chunk : m_chunks) {
+        units += chunk.capacity;
+    }
+    return units * sizeof(char16_t);
+}
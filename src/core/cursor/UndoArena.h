@@ -0,0 +1,199 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef UNDO_ARENA_H
+#define UNDO_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string_view>
+
+#include "SharedText.h"
+
+
+/**
+ * @brief Append-only storage for the text of an UndoHistory, in large chunks.
+ *
+ * The history records text in the order it is edited, and forgets it in the same order from both
+ * ends: the oldest undo steps when a cap is reached, the newest redo steps when an edit makes them
+ * unreachable. So the text lives back to back in chunks, addressed by a position that only grows,
+ * and is reclaimed a whole chunk at a time from the front, or cut off at the back. A typed run
+ * grows in place at the back, so typing allocates nothing until a chunk fills up, and a chunk
+ * emptied from the front is kept to be reused by the next one.
+ *
+ * A text too large to be worth copying can be adopted instead: its chunk is the shared storage the
+ * caller already built, read in place and never written to.
+ *
+ * Positions start at ORIGIN rather than 0, so that a group paged back from the undo journal, older
+ * than everything in memory, can be stored in front of the rest and still sort below it.
+ */
+class UndoArena final {
+public:
+    /** Capacity of a chunk in code units; a longer text gets a chunk of its own, sized to fit. */
+    static constexpr std::size_t CHUNK_UNITS = 32768;
+
+    /** Position of the first text stored in an empty arena; the ones stored in front take the positions below. */
+    static constexpr uint64_t ORIGIN = UINT64_C(1) << 62;
+
+    /** @brief A run of text stored in the arena; the default one is empty. */
+    struct Span final {
+        uint64_t position = 0; ///< Position of the first unit.
+        uint32_t length = 0;   ///< Number of units.
+    };
+
+private:
+    /** @brief A block of units; it holds the positions [base, base + used). */
+    struct Chunk final {
+        std::unique_ptr<char16_t[]> units; ///< The storage; null for an adopted text.
+        SharedText shared;                 ///< The adopted text, in place of units; null otherwise.
+        std::size_t capacity;              ///< Number of units the storage holds.
+        std::size_t used;                  ///< Number of units written from the start.
+        uint64_t base;                     ///< Position of the first unit.
+    };
+
+    /** Chunks in position order; the last one is where text is appended. */
+    std::deque<Chunk> m_chunks;
+
+    /** A standard chunk released from either end, reused before allocating a new one. */
+    std::unique_ptr<char16_t[]> m_spare;
+
+    /** Position past the last unit written. */
+    uint64_t m_end;
+
+    /**
+     * @brief Makes room for a number of units right after the back of the arena.
+     *
+     * A span ending at the back moves along into the new chunk when the current one cannot take
+     * the extra units, so it stays contiguous.
+     *
+     * @param tail The span ending at the back that must stay contiguous with the room, or an empty span.
+     * @param extra The number of units to make room for.
+     * @return The chunk holding @p tail and the room after it.
+     */
+    Chunk &reserve(Span &tail, std::size_t extra);
+
+    /**
+     * @brief Returns the chunk holding a position.
+     * @param position A position in the arena; must be below the back.
+     * @return The chunk.
+     */
+    [[nodiscard]] const Chunk &chunkAt(uint64_t position) const;
+
+    /** @brief Frees a chunk, or keeps its storage as the spare when it has the standard capacity. */
+    void recycle(Chunk &chunk);
+
+    /** @return The first unit of a chunk, wherever its storage is. */
+    [[nodiscard]] static const char16_t *unitsOf(const Chunk &chunk);
+
+public:
+    /** @brief Deleted copy constructor. */
+    UndoArena(const UndoArena &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    UndoArena &operator=(const UndoArena &) = delete;
+
+    /** @brief Constructs an empty arena, allocating nothing. */
+    explicit UndoArena();
+
+    /**
+     * @brief Stores a text at the back of the arena.
+     * @param text The text to store.
+     * @return The span of the stored text.
+     */
+    [[nodiscard]] Span append(std::u16string_view text);
+
+    /**
+     * @brief Stores a shared text at the back of the arena, without copying it.
+     *
+     * The text gets a chunk of its own that is never written to: the next text stored goes to a
+     * new chunk, and a span growing out of it is copied along first. The arena holds a reference
+     * until the span is released or truncated away.
+     *
+     * @param text The text to adopt; must not be null.
+     * @return The span of the adopted text.
+     */
+    [[nodiscard]] Span adopt(SharedText text);
+
+    /**
+     * @brief Stores a text in front of every other one, in a chunk of its own.
+     *
+     * Used for text older than everything stored, so its position stays below theirs. An empty
+     * arena stores it like append() does.
+     *
+     * @param text The text to store.
+     * @return The span of the stored text.
+     */
+    [[nodiscard]] Span storeFront(std::u16string_view text);
+
+    /**
+     * @brief Appends a text to the span at the back of the arena.
+     * @param span The span; must end at the back (isBack()). Updated in place, it may move.
+     * @param text The text to append.
+     */
+    void extend(Span &span, std::u16string_view text);
+
+    /**
+     * @brief Inserts a text in front of the span at the back of the arena.
+     *
+     * Moves the span along, so it costs its length: a backspace run gets one of these per key.
+     *
+     * @param span The span; must end at the back (isBack()). Updated in place, it may move.
+     * @param text The text to insert.
+     */
+    void prepend(Span &span, std::u16string_view text);
+
+    /**
+     * @brief Tells whether a span ends at the back of the arena, so it can grow in place.
+     * @param span A span of this arena.
+     * @return true when nothing was stored after it.
+     */
+    [[nodiscard]] bool isBack(const Span &span) const;
+
+    /**
+     * @brief Returns the text of a span.
+     * @param span A span still stored in the arena.
+     * @return A view valid until the next call storing text or releasing it.
+     */
+    [[nodiscard]] std::u16string_view view(const Span &span) const;
+
+    /** @return The position the next stored text starts at. */
+    [[nodiscard]] uint64_t end() const;
+
+    /**
+     * @brief Forgets every text stored before a position, freeing the chunks holding nothing else.
+     * @param position The position of the oldest text still needed.
+     */
+    void releaseBefore(uint64_t position);
+
+    /**
+     * @brief Forgets every text stored from a position on, so the next one is stored there.
+     * @param position The position past the newest text still needed.
+     */
+    void truncate(uint64_t position);
+
+    /** @brief Forgets every text, keeping one chunk to reuse, and starts over at ORIGIN. */
+    void clear();
+
+    /** @return The bytes allocated by the chunks, the spare and the adopted texts included. */
+    [[nodiscard]] std::size_t getMemoryUsage() const;
+};
+
+
+#endif //UNDO_ARENA_H
@@ -19,21 +19,69 @@
 #include "UndoHistory.h"
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
 #include <utility>
 
 
+/**
+ * @brief Appends the bytes of a value to a journal record.
+ *
+ * @param record The record being built.
+ * @param value The value; a plain integer or position, whose bytes are written as they are.
+ */
+template<typename TValue>
+static void putField(std::vector<char> &record, const TValue &value) {
+    const auto *const bytes = reinterpret_cast<const char *>(&value);
+    record.insert(record.end(), bytes, bytes + sizeof(TValue));
+}
+
+/**
+ * @brief Reads a value back from a journal record.
+ *
+ * @param record The record being read.
+ * @param offset The offset of the value, advanced past it.
+ * @return The value.
+ */
+template<typename TValue>
+static TValue getField(const std::vector<char> &record, std::size_t &offset) {
+    auto value = TValue{};
+    std::memcpy(&value, record.data() + offset, sizeof(TValue));
+    offset += sizeof(TValue);
+    return value;
+}
+
+
 UndoHistory::UndoHistory()
     : m_retained_characters(0),
       m_at_boundary(true),
       m_next_id(1),
       m_floor_id(0),
       m_saved_id(0),
-      m_saved_reachable(true) {}
+      m_saved_reachable(true),
+      m_groups_since_checkpoint(0),
+      m_group_held(false),
+      m_held_group_id(0) {}
 
 void UndoHistory::markBoundary() {
     m_at_boundary = true;
 }
 
+void UndoHistory::holdGroup(const bool hold) {
+    m_group_held = hold;
+    m_held_group_id = 0;
+    m_at_boundary = true;
+}
+
+void UndoHistory::enableJournal(const std::string &directory) {
+    // Two editors, or two buffers of one, may journal into the same directory at once
+    auto random = std::random_device();
+    const auto stem = directory + "bbloc_undo_" + std::to_string(random()) + "_" + std::to_string(random());
+    m_undo_journal = std::make_unique<UndoJournal>(stem + ".undo");
+    m_redo_journal = std::make_unique<UndoJournal>(stem + ".redo");
+}
+
 uint32_t UndoHistory::capacity() const {
     if (m_max_undo) {
         return static_cast<uint32_t>(std::max(1, m_max_undo->m_value));
@@ -43,11 +91,7 @@ uint32_t UndoHistory::capacity() const {
 }
 
 std::size_t UndoHistory::weigh(const Group &group) {
-    auto characters = std::size_t{0};
-    for (const auto &edit : group.edits) {
-        characters += edit.removed.length() + edit.inserted.length();
-    }
-    return characters;
+    return group.characters;
 }
 
 void UndoHistory::shareMaxDepth(std::shared_ptr<CVarInt> maxDepth) {
@@ -60,28 +104,275 @@ void UndoHistory::dropOldest(std::deque<Group> &stack) {
     stack.pop_front();
 }
 
-void UndoHistory::dropOldestUndo() {
-    // The floor is the state below the oldest group, so it is the one this drop puts out of reach
-    if (m_saved_id == m_floor_id) {
-        m_saved_reachable = false;
+bool UndoHistory::spill(UndoJournal *const journal, const Group &group) const {
+    if (journal == nullptr || !journal->isUsable()) {
+        return false;
+    }
+
+    // The header holds the fixed-size fields of the group then of every edit, and the texts follow
+    // in the same order, so paging the group back reads them into one block
+    auto header = std::vector<char>();
+    header.reserve(sizeof(uint64_t) + 2 * sizeof(BufferEdit::Position) + sizeof(uint32_t) + group.edits.size() * (sizeof(BufferEdit::Position) + 2 * sizeof(uint32_t)));
+    putField(header, group.id);
+    putField(header, group.cursor_before);
+    putField(header, group.cursor_after);
+    putField(header, static_cast<uint32_t>(group.edits.size()));
+
+    auto texts = std::vector<std::u16string_view>();
+    texts.reserve(group.edits.size() * 2);
+    for (const auto &edit : group.edits) {
+        putField(header, edit.start);
+        putField(header, edit.removed.length);
+        putField(header, edit.inserted.length);
+        texts.push_back(m_arena.view(edit.removed));
+        texts.push_back(m_arena.view(edit.inserted));
+    }
+
+    return journal->push(header, texts);
+}
+
+std::optional<UndoHistory::Group> UndoHistory::page(UndoJournal &journal, const bool inFront) {
+    auto record = std::vector<char>();
+    if (!journal.pop(record)) {
+        return std::nullopt;
+    }
+
+    auto offset = std::size_t{0};
+    auto group = Group{
+        .edits = {},
+        .cursor_before = {},
+        .cursor_after = {},
+        .id = getField<uint64_t>(record, offset),
+        .characters = 0,
+        .arena_begin = 0
+    };
+    group.cursor_before = getField<BufferEdit::Position>(record, offset);
+    group.cursor_after = getField<BufferEdit::Position>(record, offset);
+    group.edits.resize(getField<uint32_t>(record, offset));
+    for (auto &edit : group.edits) {
+        edit.start = getField<BufferEdit::Position>(record, offset);
+        edit.removed.length = getField<uint32_t>(record, offset);
+        edit.inserted.length = getField<uint32_t>(record, offset);
+        group.characters += edit.removed.length + edit.inserted.length;
+    }
+
+    // The texts are stored as one block, which the spans of the edits then share in order
+    auto text = std::u16string(group.characters, u'\0');
+    std::memcpy(text.data(), record.data() + offset, text.size() * sizeof(char16_t));
+    const auto block = inFront ? m_arena.storeFront(text) : m_arena.append(text);
+    group.arena_begin = block.position;
+
+    auto position = block.position;
+    for (auto &edit : group.edits) {
+        edit.removed.position = position;
+        position += edit.removed.length;
+        edit.inserted.position = position;
+        position += edit.inserted.length;
+    }
+
+    m_retained_characters += group.characters;
+    return group;
+}
+
+void UndoHistory::refillUndo() {
+    if (!m_undo_stack.empty() || !m_undo_journal || m_undo_journal->getCount() == 0) {
+        return;
+    }
+
+    if (auto group = page(*m_undo_journal, true)) {
+        m_undo_stack.emplace_back(std::move(*group));
+        return;
+    }
+
+    // Nothing below the unreadable group can be undone. The state the buffer is in is the one that
+    // group produced, which the floor does not name: read as modified until saved again. Only the
+    // states the redo stack leads to remain, beginning with the one the group just undone produces.
+    m_undo_journal->clear();
+    m_saved_reachable = false;
+    dropCheckpointsOutside(m_redo_stack.empty() ? std::numeric_limits<uint64_t>::max() : m_redo_stack.back().id, std::numeric_limits<uint64_t>::max());
+}
+
+void UndoHistory::refillRedo() {
+    if (!m_redo_stack.empty() || !m_redo_journal || m_redo_journal->getCount() == 0) {
+        return;
     }
 
-    m_floor_id = m_undo_stack.front().id;
+    if (auto group = page(*m_redo_journal, false)) {
+        m_redo_stack.emplace_back(std::move(*group));
+        return;
+    }
+
+    // Nothing beyond the unreadable group can be redone
+    m_redo_journal->clear();
+    dropCheckpointsOutside(0, currentState());
+}
+
+void UndoHistory::dropOldestUndo() {
+    auto &oldest = m_undo_stack.front();
+    if (!spill(m_undo_journal.get(), oldest)) {
+        // The states below the dropped group go with it, those of the journal included: they are
+        // all older, so their identities are all lower
+        if (m_saved_id < oldest.id) {
+            m_saved_reachable = false;
+        }
+
+        if (m_undo_journal) {
+            m_undo_journal->clear();
+        }
+        m_floor_id = oldest.id;
+        dropCheckpointsOutside(m_floor_id, std::numeric_limits<uint64_t>::max());
+    }
     dropOldest(m_undo_stack);
+
+    // The text of the oldest group left starts where the chunks holding only older text end
+    if (!m_undo_stack.empty()) {
+        m_arena.releaseBefore(m_undo_stack.front().arena_begin);
+    } else if (!m_redo_stack.empty()) {
+        m_arena.releaseBefore(m_redo_stack.back().arena_begin);
+    } else {
+        m_arena.clear();
+    }
 }
 
 void UndoHistory::dropOldestRedo() {
-    if (m_saved_id == m_redo_stack.front().id) {
-        m_saved_reachable = false;
+    if (!spill(m_redo_journal.get(), m_redo_stack.front())) {
+        // The group redoes into the furthest-forward state in memory, and the journal only holds
+        // states further forward still, so their identities are all higher
+        if (m_saved_id >= m_redo_stack.front().id) {
+            m_saved_reachable = false;
+        }
+
+        if (m_redo_journal) {
+            m_redo_journal->clear();
+        }
+        dropCheckpointsOutside(0, m_redo_stack.front().id - 1);
     }
 
+    // The front of the redo stack is the group recorded last, so its text is the back of the arena
+    const auto arena_begin = m_redo_stack.front().arena_begin;
     dropOldest(m_redo_stack);
+    m_arena.truncate(arena_begin);
 }
 
 uint64_t UndoHistory::currentState() const {
     return m_undo_stack.empty() ? m_floor_id : m_undo_stack.back().id;
 }
 
+void UndoHistory::dropCheckpointsOutside(const uint64_t lowest, const uint64_t highest) {
+    std::erase_if(m_checkpoints, [lowest, highest](const Checkpoint &checkpoint) {
+        return checkpoint.id < lowest || checkpoint.id > highest;
+    });
+}
+
+bool UndoHistory::holds(const uint64_t state) const {
+    if (state == currentState()) {
+        return true;
+    }
+
+    // The floor is only next in line once the undo journal has nothing left above it
+    if (state == m_floor_id && (!m_undo_journal || m_undo_journal->getCount() == 0)) {
+        return true;
+    }
+
+    const auto has_id = [state](const Group &group) { return group.id == state; };
+    return std::ranges::any_of(m_undo_stack, has_id) || std::ranges::any_of(m_redo_stack, has_id);
+}
+
+uint64_t UndoHistory::getState() const {
+    return currentState();
+}
+
+std::optional<uint64_t> UndoHistory::getSavedState() const {
+    if (!m_saved_reachable) {
+        return std::nullopt;
+    }
+
+    return m_saved_id;
+}
+
+std::optional<uint64_t> UndoHistory::getStateBack(const uint32_t steps) const {
+    if (steps < m_undo_stack.size()) {
+        return m_undo_stack[m_undo_stack.size() - 1 - steps].id;
+    }
+
+    if (steps == m_undo_stack.size() && (!m_undo_journal || m_undo_journal->getCount() == 0)) {
+        return m_floor_id;
+    }
+
+    // Deeper than memory: the identities of the spilled groups are on disk
+    return std::nullopt;
+}
+
+bool UndoHistory::wantsCheckpoint(const std::size_t characters) const {
+    return m_groups_since_checkpoint >= CHECKPOINT_INTERVAL && characters <= MAX_CHECKPOINT_CHARACTERS;
+}
+
+void UndoHistory::addCheckpoint(std::u16string text) {
+    const auto state = currentState();
+    m_groups_since_checkpoint = 0;
+
+    std::erase_if(m_checkpoints, [state](const Checkpoint &checkpoint) { return checkpoint.id == state; });
+    const auto position = std::ranges::find_if(m_checkpoints, [state](const Checkpoint &checkpoint) { return checkpoint.id > state; });
+    m_checkpoints.insert(position, Checkpoint{.id = state, .text = std::move(text)});
+
+    // Over budget, the checkpoints thin out rather than slide: the one whose neighbours lie closest
+    // together goes, so they keep covering the whole history, both of its ends included
+    auto characters = std::size_t{0};
+    for (const auto &checkpoint : m_checkpoints) {
+        characters += checkpoint.text.size();
+    }
+    while (!m_checkpoints.empty() && (m_checkpoints.size() > MAX_CHECKPOINTS || characters > MAX_CHECKPOINT_CHARACTERS)) {
+        auto dropped = m_checkpoints.begin();
+        if (m_checkpoints.size() > 2) {
+            auto narrowest = std::numeric_limits<uint64_t>::max();
+            for (auto it = m_checkpoints.begin() + 1; it + 1 != m_checkpoints.end(); ++it) {
+                if (const auto gap = (it + 1)->id - (it - 1)->id; gap < narrowest) {
+                    narrowest = gap;
+                    dropped = it;
+                }
+            }
+        }
+        characters -= dropped->text.size();
+        m_checkpoints.erase(dropped);
+    }
+}
+
+const UndoHistory::Checkpoint *UndoHistory::findCheckpoint(const uint64_t target) const {
+    // Identities stand in for the number of groups in between: a discarded redo branch leaves a
+    // gap in them, which only makes a checkpoint look further away than it is
+    const auto distance = [target](const uint64_t state) { return state > target ? state - target : target - state; };
+
+    const Checkpoint *nearest = nullptr;
+    auto nearest_distance = distance(currentState());
+    for (const auto &checkpoint : m_checkpoints) {
+        if (distance(checkpoint.id) < nearest_distance && holds(checkpoint.id)) {
+            nearest = &checkpoint;
+            nearest_distance = distance(checkpoint.id);
+        }
+    }
+    return nearest;
+}
+
+std::optional<BufferEdit::Position> UndoHistory::walkTo(const uint64_t state) {
+    auto caret = std::optional<BufferEdit::Position>();
+    while (currentState() > state) {
+        const auto *const group = undo();
+        if (group == nullptr) {
+            break;
+        }
+        caret = group->cursor_before;
+    }
+
+    while (currentState() < state) {
+        const auto *const group = redo();
+        if (group == nullptr) {
+            break;
+        }
+        caret = group->cursor_after;
+    }
+    return caret;
+}
+
 void UndoHistory::markSaved() {
     m_saved_id = currentState();
     m_saved_reachable = true;
@@ -96,6 +387,23 @@ bool UndoHistory::isSaved() const {
 }
 
 void UndoHistory::clearRedo() {
+    // The states ahead are about to be replaced by the edit being recorded
+    dropCheckpointsOutside(0, currentState());
+    if (m_redo_stack.empty()) {
+        return;
+    }
+
+    if (m_redo_journal) {
+        m_redo_journal->clear();
+    }
+
+    // A saved state ahead goes with the branch
+    if (m_saved_id > currentState()) {
+        m_saved_reachable = false;
+    }
+
+    // The most recently undone group is the oldest of the stack: everything from its text on goes
+    m_arena.truncate(m_redo_stack.back().arena_begin);
     for (const auto &group : m_redo_stack) {
         m_retained_characters -= weigh(group);
     }
@@ -132,32 +440,32 @@ void UndoHistory::applyMaxDepth() {
     trim();
 }
 
-bool UndoHistory::coalesce(Group &group, const Edit &edit) {
+bool UndoHistory::coalesce(Group &group, const BufferEdit::Position &start, const std::u16string_view removed, const std::u16string_view inserted) {
     auto &previous = group.edits.back();
 
-    if (previous.removed.empty() && edit.removed.empty()) {
+    if (previous.removed.length == 0 && removed.empty()) {
         // Typing: the new text starts exactly where the previous insert ended
-        const auto previous_end = advancePosition(previous.start, previous.inserted);
-        if (previous_end.line == edit.start.line && previous_end.column == edit.start.column) {
-            previous.inserted.append(edit.inserted);
+        const auto previous_end = advancePosition(previous.start, m_arena.view(previous.inserted));
+        if (previous_end.line == start.line && previous_end.column == start.column && m_arena.isBack(previous.inserted)) {
+            m_arena.extend(previous.inserted, inserted);
             return true;
         }
         return false;
     }
 
-    if (previous.inserted.empty() && edit.inserted.empty()) {
+    if (previous.inserted.length == 0 && inserted.empty() && m_arena.isBack(previous.removed)) {
         // Backspacing: the new erase ends exactly where the previous one began, so it belongs
         // in front of it — the text has to come back in reading order, not in typing order
-        const auto edit_end = advancePosition(edit.start, edit.removed);
+        const auto edit_end = advancePosition(start, removed);
         if (edit_end.line == previous.start.line && edit_end.column == previous.start.column) {
-            previous.removed.insert(0, edit.removed);
-            previous.start = edit.start;
+            m_arena.prepend(previous.removed, removed);
+            previous.start = start;
             return true;
         }
 
         // Deleting forward: the caret never moves, so both erases start at the same place
-        if (edit.start.line == previous.start.line && edit.start.column == previous.start.column) {
-            previous.removed.append(edit.removed);
+        if (start.line == previous.start.line && start.column == previous.start.column) {
+            m_arena.extend(previous.removed, removed);
             return true;
         }
     }
@@ -165,30 +473,76 @@ bool UndoHistory::coalesce(Group &group, const Edit &edit) {
     return false;
 }
 
-void UndoHistory::record(Edit edit, const BufferEdit::Position &cursorBefore, const BufferEdit::Position &cursorAfter) {
+UndoHistory::Group &UndoHistory::openGroup(const BufferEdit::Position &cursorBefore, const BufferEdit::Position &cursorAfter) {
+    // A held group goes on through the boundaries, as long as it is still the newest one
+    const auto extends_held = m_group_held && !m_undo_stack.empty() && m_undo_stack.back().id == m_held_group_id;
+    if ((m_at_boundary && !extends_held) || m_undo_stack.empty()) {
+        if (m_group_held) {
+            m_held_group_id = m_next_id;
+        }
+        m_undo_stack.emplace_back(Group{
+            .edits = {},
+            .cursor_before = cursorBefore,
+            .cursor_after = cursorAfter,
+            .id = m_next_id,
+            .characters = 0,
+            .arena_begin = m_arena.end()
+        });
+        ++m_next_id;
+        ++m_groups_since_checkpoint;
+    } else if (!m_checkpoints.empty() && m_checkpoints.back().id == m_undo_stack.back().id) {
+        // The group grows past the state the checkpoint copied: it no longer names that text
+        m_checkpoints.pop_back();
+    }
+    m_at_boundary = false;
+    return m_undo_stack.back();
+}
+
+void UndoHistory::record(const BufferEdit::Position &start, const std::u16string_view removed, const std::u16string_view inserted,
+                         const BufferEdit::Position &cursorBefore, const BufferEdit::Position &cursorAfter) {
     // An edit is coming: whatever could be redone is now unreachable
     clearRedo();
 
-    if (edit.removed.empty() && edit.inserted.empty()) {
+    if (removed.empty() && inserted.empty()) {
         // Replacing nothing with nothing leaves no trace to undo, but it still closes the
         // boundary the way any other edit would
         m_at_boundary = false;
         return;
     }
 
-    if (m_at_boundary || m_undo_stack.empty()) {
-        m_undo_stack.emplace_back(Group{.edits = {}, .cursor_before = cursorBefore, .cursor_after = cursorAfter, .id = m_next_id});
-        ++m_next_id;
-        m_at_boundary = false;
+    // Only a held group outlives a boundary, and the edit must not merge across it either
+    const auto at_boundary = m_at_boundary;
+    auto &group = openGroup(cursorBefore, cursorAfter);
+    group.characters += removed.length() + inserted.length();
+    m_retained_characters += removed.length() + inserted.length();
+    if (group.edits.empty() || at_boundary || !coalesce(group, start, removed, inserted)) {
+        const auto removed_span = m_arena.append(removed);
+        group.edits.emplace_back(Edit{.start = start, .removed = removed_span, .inserted = m_arena.append(inserted)});
     }
+    group.cursor_after = cursorAfter;
 
-    auto &group = m_undo_stack.back();
-    m_retained_characters += edit.removed.length() + edit.inserted.length();
-    if (group.edits.empty() || !coalesce(group, edit)) {
-        group.edits.emplace_back(std::move(edit));
+    trim();
+}
+
+void UndoHistory::recordShared(const BufferEdit::Position &start, const SharedText &removed, const std::u16string_view inserted,
+                               const BufferEdit::Position &cursorBefore, const BufferEdit::Position &cursorAfter) {
+    if (removed->length() < ADOPT_MIN_UNITS) {
+        record(start, std::u16string_view(*removed), inserted, cursorBefore, cursorAfter);
+        return;
     }
+
+    clearRedo();
+
+    auto &group = openGroup(cursorBefore, cursorAfter);
+    group.characters += removed->length() + inserted.length();
+    m_retained_characters += removed->length() + inserted.length();
+    const auto removed_span = m_arena.adopt(removed);
+    group.edits.emplace_back(Edit{.start = start, .removed = removed_span, .inserted = m_arena.append(inserted)});
     group.cursor_after = cursorAfter;
 
+    // Nothing may coalesce into the adopted span: growing it would copy it into the arena
+    m_at_boundary = true;
+
     trim();
 }
 
@@ -200,6 +554,7 @@ const UndoHistory::Group *UndoHistory::undo() {
     // The group only changes stacks, so the retained total is unchanged
     m_redo_stack.emplace_back(std::move(m_undo_stack.back()));
     m_undo_stack.pop_back();
+    refillUndo();
     trim();
 
     return &m_redo_stack.back();
@@ -212,16 +567,44 @@ const UndoHistory::Group *UndoHistory::redo() {
 
     m_undo_stack.emplace_back(std::move(m_redo_stack.back()));
     m_redo_stack.pop_back();
+    refillRedo();
     trim();
 
     return &m_undo_stack.back();
 }
 
+std::u16string_view UndoHistory::text(const UndoArena::Span &span) const {
+    return m_arena.view(span);
+}
+
+std::size_t UndoHistory::getRetainedCharacters() const {
+    return m_retained_characters;
+}
+
+std::size_t UndoHistory::getArenaMemory() const {
+    return m_arena.getMemoryUsage();
+}
+
+std::size_t UndoHistory::getCheckpointMemory() const {
+    auto memory = m_checkpoints.capacity() * sizeof(Checkpoint);
+    for (const auto &checkpoint : m_checkpoints) {
+        memory += checkpoint.text.capacity() * sizeof(char16_t);
+    }
+    return memory;
+}
+
 void UndoHistory::clear() {
     m_undo_stack.clear();
     m_redo_stack.clear();
+    m_arena.clear();
+    if (m_undo_journal) {
+        m_undo_journal->clear();
+        m_redo_journal->clear();
+    }
     m_retained_characters = 0;
     m_at_boundary = true;
+    m_checkpoints.clear();
+    m_groups_since_checkpoint = 0;
 
     // A wiped history describes a buffer that was just installed from disk, so the state it sits
     // in is the saved one until an edit says otherwise
@@ -23,11 +23,16 @@
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "buffer/BufferEdit.h"
 #include "../cvar/CVarInt.h"
+#include "SharedText.h"
+#include "UndoArena.h"
+#include "UndoJournal.h"
 
 
 /**
@@ -39,6 +44,21 @@
  *
  * Both stacks are capped at the live entry capacity, dropping the oldest group when full, and the
  * characters they retain together are capped by MAX_HISTORY_CHARACTERS.
+ *
+ * The text itself lives in an UndoArena, in the order it was recorded: the groups of the undo stack
+ * from the oldest, then those of the redo stack from the most recently undone. Dropping the oldest
+ * undo group frees the chunks only it used, and dropping redo groups cuts the arena back, so an
+ * entry holds spans rather than strings and a typed run extends its span in place. The text of a
+ * large deletion is not copied there at all: the arena adopts the copy the cursor took.
+ *
+ * Once a journal is enabled, the caps only bound what stays in memory: the groups they push out are
+ * spilled to an UndoJournal of their stack instead of being dropped, and paged back as soon as
+ * their stack runs empty, so the depth of the history is only limited by the disk. A stack is only
+ * ever empty when its journal is too. Should a journal fail, the history falls back to dropping.
+ *
+ * The history also keeps a few checkpoints: copies of the whole buffer at states it can still
+ * reach, taken every CHECKPOINT_INTERVAL groups. A long jump restores the nearest one and replays
+ * only the groups between it and the target, instead of every group on the way.
  */
 class UndoHistory final {
 public:
@@ -50,8 +70,8 @@ public:
      */
     struct Edit final {
         BufferEdit::Position start; ///< Where the replaced range begins.
-        std::u16string removed;     ///< Text present before the change, empty for a pure insert.
-        std::u16string inserted;    ///< Text present after the change, empty for a pure erase.
+        UndoArena::Span removed;    ///< Text present before the change, empty for a pure insert; read it with text().
+        UndoArena::Span inserted;   ///< Text present after the change, empty for a pure erase; read it with text().
     };
 
     /** @brief A run of edits undone and redone as a single step. */
@@ -60,9 +80,29 @@ public:
         BufferEdit::Position cursor_before; ///< Caret at the group's start, restored by undo.
         BufferEdit::Position cursor_after;  ///< Caret after the last edit, restored by redo.
         uint64_t id;                        ///< Identity of the state this group produces.
+        std::size_t characters;             ///< Number of characters its edits retain.
+        uint64_t arena_begin;               ///< Arena position its text starts at; older groups lie below it.
+    };
+
+    /** @brief A copy of the whole buffer in one state of the history. */
+    struct Checkpoint final {
+        uint64_t id;         ///< Identity of the state the copy was taken in.
+        std::u16string text; ///< The buffer in that state.
     };
 
 private:
+    /** Number of groups recorded between two checkpoints. */
+    static constexpr uint32_t CHECKPOINT_INTERVAL = 16u;
+
+    /** Maximum number of checkpoints kept; past it, they thin out. */
+    static constexpr std::size_t MAX_CHECKPOINTS = 4u;
+
+    /** Maximum number of characters the checkpoints hold together (32 MiB of char16_t). */
+    static constexpr std::size_t MAX_CHECKPOINT_CHARACTERS = 32u * 1024u * 1024u / sizeof(char16_t);
+
+    /** Length from which a removed text handed over as a SharedText is adopted rather than copied. */
+    static constexpr std::size_t ADOPT_MIN_UNITS = UndoArena::CHUNK_UNITS;
+
     /** Default maximum number of groups kept in each stack. */
     static constexpr uint32_t DEFAULT_MAX_HISTORY_DEPTH = 64u;
 
@@ -75,6 +115,15 @@ private:
     /** Groups available for redo. */
     std::deque<Group> m_redo_stack;
 
+    /** The text of the edits of both stacks. */
+    UndoArena m_arena;
+
+    /** Groups spilled from the bottom of the undo stack, the newest on top; null until enableJournal(). */
+    std::unique_ptr<UndoJournal> m_undo_journal;
+
+    /** Groups spilled from the top of the redo stack, the next to redo on top; null until enableJournal(). */
+    std::unique_ptr<UndoJournal> m_redo_journal;
+
     /** Shared CVar holding the maximum number of groups kept in each stack. */
     std::shared_ptr<CVarInt> m_max_undo;
 
@@ -87,7 +136,7 @@ private:
     /** Identity handed to the next group; 0 is reserved for the state below the oldest one. */
     uint64_t m_next_id;
 
-    /** Identity of the state below the oldest retained group, 0 until one is trimmed away. */
+    /** Identity of the state below the oldest reachable group, 0 until one is trimmed away; spilled groups stay reachable. */
     uint64_t m_floor_id;
 
     /** Identity of the state the buffer was last saved at. */
@@ -96,6 +145,18 @@ private:
     /** False once the saved state has been trimmed out of reach. */
     bool m_saved_reachable;
 
+    /** Checkpoints of reachable states, by ascending identity. */
+    std::vector<Checkpoint> m_checkpoints;
+
+    /** Number of groups opened since the last checkpoint was taken. */
+    uint32_t m_groups_since_checkpoint;
+
+    /** Set while holdGroup() keeps the boundaries from opening new groups. */
+    bool m_group_held;
+
+    /** Identity of the group opened since the hold began, 0 until the first edit opens it. */
+    uint64_t m_held_group_id;
+
 private:
     /**
      * @brief Returns the live group cap read from the shared CVar.
@@ -112,29 +173,75 @@ private:
     /**
      * @brief Drops the oldest group of a stack and discounts the characters it retained.
      *
+     * Leaves its text in the arena; the callers know which end of the arena it was at.
+     *
      * @param stack The stack to drop the front of; must not be empty.
      */
     void dropOldest(std::deque<Group> &stack);
 
     /**
-     * @brief Drops the oldest undo group and moves the floor up past it.
+     * @brief Spills the oldest undo group to the undo journal, or drops it and moves the floor up past it.
      *
-     * The state that disappears is the one below the dropped group, which is exactly the floor:
-     * if the buffer was saved there, it can no longer be undone back to.
+     * A dropped group takes with it the states below it: the floor, and those of the groups the
+     * journal held, which cannot be reached past the gap and are discarded. If the buffer was saved
+     * in one of them, it can no longer be undone back to.
      */
     void dropOldestUndo();
 
     /**
-     * @brief Drops the oldest redo group.
+     * @brief Spills the oldest redo group to the redo journal, or drops it.
      *
      * The front of the redo stack is the furthest-forward state, so dropping it is what puts a
-     * saved state out of reach on the redo side.
+     * saved state out of reach on the redo side, along with the states the journal held beyond it.
      */
     void dropOldestRedo();
 
+    /**
+     * @brief Writes a group to a journal.
+     *
+     * @param journal The journal of the stack the group leaves; may be null.
+     * @param group The group, whose text is still in the arena.
+     * @return true when the group is on disk and can be dropped from memory.
+     */
+    [[nodiscard]] bool spill(UndoJournal *journal, const Group &group) const;
+
+    /**
+     * @brief Reads the group on top of a journal back, storing its text in the arena.
+     *
+     * The groups of the undo journal are older than everything in memory, so their text goes in
+     * front of the arena; those of the redo journal are newer, so theirs goes at its back.
+     *
+     * @param journal The journal to read; must hold a record.
+     * @param inFront Whether the text goes in front of the arena rather than at its back.
+     * @return The group, or std::nullopt when the journal failed to read it.
+     */
+    [[nodiscard]] std::optional<Group> page(UndoJournal &journal, bool inFront);
+
+    /** @brief Pages the newest spilled undo group back once the undo stack ran empty. */
+    void refillUndo();
+
+    /** @brief Pages the next spilled redo group back once the redo stack ran empty. */
+    void refillRedo();
+
     /** @return The identity of the state the buffer is currently in. */
     [[nodiscard]] uint64_t currentState() const;
 
+    /**
+     * @brief Drops the checkpoints of the states that went out of reach.
+     *
+     * Identities grow along the history, so the reachable ones form a range.
+     *
+     * @param lowest The lowest identity still reachable.
+     * @param highest The highest identity still reachable.
+     */
+    void dropCheckpointsOutside(uint64_t lowest, uint64_t highest);
+
+    /**
+     * @brief Tells whether a state can be reached without reading a journal.
+     * @param state The identity of the state.
+     */
+    [[nodiscard]] bool holds(uint64_t state) const;
+
     /**
      * @brief Enforces both caps, dropping the oldest groups first.
      *
@@ -144,7 +251,7 @@ private:
      */
     void trim();
 
-    /** @brief Empties the redo stack and discounts the characters it retained. */
+    /** @brief Empties the redo stack and its journal, discounts the characters it retained and cuts its text off the arena. */
     void clearRedo();
 
     /**
@@ -152,13 +259,25 @@ private:
      *
      * Typing, backspacing and deleting forward each arrive one character at a time. Left as
      * separate entries they would cost one buffer operation and one tree-sitter edit apiece on
-     * undo, so a run that extends the previous edit is folded into it instead.
+     * undo, so a run that extends the previous edit is folded into it instead. The text it merges
+     * into is the last one stored, so it grows in place in the arena.
      *
      * @param group The group to merge into; its edits must not be empty.
-     * @param edit The edit to merge.
+     * @param start Where the replaced range of the edit begins.
+     * @param removed The text the edit removed.
+     * @param inserted The text the edit inserted.
      * @return true when the edit was merged, false when it must be appended on its own.
      */
-    [[nodiscard]] static bool coalesce(Group &group, const Edit &edit);
+    [[nodiscard]] bool coalesce(Group &group, const BufferEdit::Position &start, std::u16string_view removed, std::u16string_view inserted);
+
+    /**
+     * @brief Returns the group an edit being recorded goes to, opening one at a boundary.
+     *
+     * @param cursorBefore The caret position before the edit; the group's when it opens one.
+     * @param cursorAfter The caret position after the edit.
+     * @return The open group, the newest of the undo stack.
+     */
+    [[nodiscard]] Group &openGroup(const BufferEdit::Position &cursorBefore, const BufferEdit::Position &cursorAfter);
 
 public:
     /** @brief Deleted copy constructor. */
@@ -173,6 +292,28 @@ public:
     /** @brief Marks a boundary so that the next edit opens a new group. */
     void markBoundary();
 
+    /**
+     * @brief Keeps every edit recorded from now on in one group, until released.
+     *
+     * While held, a boundary still stops an edit from merging into the previous one, but no longer
+     * opens a group: the first edit after the hold opens one and all the following extend it. An
+     * undo in between moves that group away, and the next edit opens the one held from then on.
+     * Holding or releasing marks a boundary.
+     *
+     * @param hold Whether to hold the group or release it.
+     */
+    void holdGroup(bool hold);
+
+    /**
+     * @brief Spills the groups the caps push out to journal files rather than dropping them.
+     *
+     * Call once, before the first edit. The files are only created once a group is spilled, and
+     * removed with the history.
+     *
+     * @param directory The directory to create the journals in, trailing separator included. UTF-8.
+     */
+    void enableJournal(const std::string &directory);
+
     /**
      * @brief Shares the CVar that caps both stacks and trims them to its current value.
      *
@@ -188,15 +329,43 @@ public:
     /**
      * @brief Records an edit that was just applied to the buffer.
      *
-     * Opens a new group when the history is at a boundary, otherwise extends the open one, and
+     * Opens a new group when the history is at a boundary (unless it holds one), otherwise extends the open one, and
      * clears the redo stack: an edit makes whatever could be redone unreachable. An edit that
-     * replaces nothing with nothing consumes the boundary without being retained.
+     * replaces nothing with nothing consumes the boundary without being retained. The texts are
+     * copied into the arena.
      *
-     * @param edit The replacement the buffer just underwent.
+     * @param start Where the replaced range begins.
+     * @param removed Text present before the change, empty for a pure insert.
+     * @param inserted Text present after the change, empty for a pure erase.
      * @param cursorBefore The caret position before the group's first edit; used when it opens one.
      * @param cursorAfter The caret position after this edit.
      */
-    void record(Edit edit, const BufferEdit::Position &cursorBefore, const BufferEdit::Position &cursorAfter);
+    void record(const BufferEdit::Position &start, std::u16string_view removed, std::u16string_view inserted,
+                const BufferEdit::Position &cursorBefore, const BufferEdit::Position &cursorAfter);
+
+    /**
+     * @brief Records an edit like record(), its removed text handed over rather than copied.
+     *
+     * A removed text of at least ADOPT_MIN_UNITS is adopted by the arena as it is, so a deletion
+     * of most of a large buffer is held once, and weighs its length once against the caps. Such an
+     * edit closes its group: a later edit growing the same span would copy it after all. A shorter
+     * text is recorded by record().
+     *
+     * @param start Where the replaced range begins.
+     * @param removed Text present before the change; must not be null.
+     * @param inserted Text present after the change, empty for a pure erase.
+     * @param cursorBefore The caret position before the group's first edit; used when it opens one.
+     * @param cursorAfter The caret position after this edit.
+     */
+    void recordShared(const BufferEdit::Position &start, const SharedText &removed, std::u16string_view inserted,
+                      const BufferEdit::Position &cursorBefore, const BufferEdit::Position &cursorAfter);
+
+    /**
+     * @brief Returns the text of one side of an edit.
+     * @param span The removed or inserted span of an edit of a group still in the history.
+     * @return A view valid until the next call that mutates the history.
+     */
+    [[nodiscard]] std::u16string_view text(const UndoArena::Span &span) const;
 
     /**
      * @brief Moves the most recent group onto the redo stack and hands it back for reverting.
@@ -216,6 +385,55 @@ public:
      */
     [[nodiscard]] const Group *redo();
 
+    /** @return The identity of the state the buffer is currently in; states further back have lower ones. */
+    [[nodiscard]] uint64_t getState() const;
+
+    /** @return The identity of the saved state, or std::nullopt when it is out of reach. */
+    [[nodiscard]] std::optional<uint64_t> getSavedState() const;
+
+    /**
+     * @brief Returns the state a number of undo steps back, when the groups in between are in memory.
+     * @param steps The number of groups to undo.
+     * @return Its identity, or std::nullopt when the undo stack in memory is not that deep.
+     */
+    [[nodiscard]] std::optional<uint64_t> getStateBack(uint32_t steps) const;
+
+    /**
+     * @brief Tells whether the buffer is due for a checkpoint.
+     * @param characters The number of characters in the buffer.
+     * @return true when enough groups were recorded since the last one, and the buffer fits the budget.
+     */
+    [[nodiscard]] bool wantsCheckpoint(std::size_t characters) const;
+
+    /**
+     * @brief Takes a checkpoint of the current state.
+     *
+     * Thins the checkpoints out when over MAX_CHECKPOINTS or MAX_CHECKPOINT_CHARACTERS, dropping
+     * the one whose neighbours lie closest together.
+     *
+     * @param text The whole buffer, as it stands in the current state.
+     */
+    void addCheckpoint(std::u16string text);
+
+    /**
+     * @brief Finds the checkpoint that brings the buffer closest to a state.
+     *
+     * Only a checkpoint the history can walk to without reading a journal qualifies, and only when
+     * it lies closer to the target than the current state does.
+     *
+     * @param target The identity of the state to reach.
+     * @return The checkpoint, valid until the next call that mutates the history; nullptr when none helps.
+     */
+    [[nodiscard]] const Checkpoint *findCheckpoint(uint64_t target) const;
+
+    /**
+     * @brief Moves the history to a state without handing the groups out, for a buffer restored from its checkpoint.
+     *
+     * @param state The identity of the state; must be one holds() reaches.
+     * @return The caret of the last group moved: where it was before an undone group, after a redone one.
+     */
+    std::optional<BufferEdit::Position> walkTo(uint64_t state);
+
     /** @brief Records the current state as the saved one. */
     void markSaved();
 
@@ -231,7 +449,16 @@ public:
      */
     [[nodiscard]] bool isSaved() const;
 
-    /** @brief Wipes both stacks and resets the history to a boundary and to a saved state. */
+    /** @return The number of characters retained by both stacks together. */
+    [[nodiscard]] std::size_t getRetainedCharacters() const;
+
+    /** @return The bytes allocated by the arena holding the text of both stacks. */
+    [[nodiscard]] std::size_t getArenaMemory() const;
+
+    /** @return The bytes held by the checkpoints. */
+    [[nodiscard]] std::size_t getCheckpointMemory() const;
+
+    /** @brief Wipes both stacks, their journals and the checkpoints, and resets the history to a boundary and to a saved state. */
     void clear();
 };
 
@@ -0,0 +1,102 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "UndoJournal.h"
+
+#include <cstdio>
+#include <utility>
+
+
+UndoJournal::UndoJournal(std::string path)
+    : m_path(std::move(path)),
+      m_end(0),
+      m_failed(false) {}
+
+UndoJournal::~UndoJournal() {
+    if (m_file.is_open()) {
+        m_file.close();
+        std::remove(m_path.c_str());
+    }
+}
+
+bool UndoJournal::push(const std::span<const char> header, const std::span<const std::u16string_view> texts) {
+    if (m_failed) {
+        return false;
+    }
+
+    if (!m_file.is_open()) {
+        m_file.open(m_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!m_file) {
+            m_failed = true;
+            return false;
+        }
+    }
+
+    // The texts are written straight from where they are stored, so a spill copies nothing in memory
+    m_file.seekp(static_cast<std::streamoff>(m_end));
+    auto size = header.size();
+    m_file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    for (const auto text : texts) {
+        m_file.write(reinterpret_cast<const char *>(text.data()), static_cast<std::streamsize>(text.size() * sizeof(char16_t)));
+        size += text.size() * sizeof(char16_t);
+    }
+    if (!m_file) {
+        m_failed = true;
+        return false;
+    }
+
+    m_offsets.push_back(m_end);
+    m_end += size;
+    return true;
+}
+
+bool UndoJournal::pop(std::vector<char> &record) {
+    if (m_offsets.empty() || m_failed) {
+        return false;
+    }
+
+    const auto offset = m_offsets.back();
+    record.resize(m_end - offset);
+    m_file.seekg(static_cast<std::streamoff>(offset));
+    m_file.read(record.data(), static_cast<std::streamsize>(record.size()));
+    if (!m_file) {
+        m_failed = true;
+        return false;
+    }
+
+    m_offsets.pop_back();
+    m_end = offset;
+    return true;
+}
+
+void UndoJournal::clear() {
+    m_offsets.clear();
+    m_end = 0;
+}
+
+std::size_t UndoJournal::getCount() const {
+    return m_offsets.size();
+}
+
+uint64_t UndoJournal::getDiskUsage() const {
+    return m_end;
+}
+
+bool UndoJournal::isUsable() const {
+    return !m_failed;
+}
@@ -0,0 +1,107 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef UNDO_JOURNAL_H
+#define UNDO_JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief A stack of records kept in a scratch file, for the undo groups an UndoHistory pages out.
+ *
+ * Records are appended at the end of the file and read back from the end, last in first out, which
+ * is the order the history spills and pages groups: popping one cuts it off, and the next push
+ * writes over it. Only the offset of each record stays in memory.
+ *
+ * The file is created on the first push and removed when the journal is destroyed. It only lives as
+ * long as the process, so it is written in native byte order, with no versioning. Once a write fails
+ * the journal stops accepting records, so the history goes back to dropping the oldest groups.
+ */
+class UndoJournal final {
+private:
+    /** Path of the file. UTF-8. */
+    std::string m_path;
+
+    /** The file, open for both reading and writing once the first record is pushed. */
+    std::fstream m_file;
+
+    /** Offset of each record in the file, oldest first. */
+    std::vector<uint64_t> m_offsets;
+
+    /** Offset past the last record. */
+    uint64_t m_end;
+
+    /** Set once a write or a read failed; the journal then refuses new records. */
+    bool m_failed;
+
+public:
+    /** @brief Deleted copy constructor. */
+    UndoJournal(const UndoJournal &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    UndoJournal &operator=(const UndoJournal &) = delete;
+
+    /**
+     * @brief Constructs an empty journal, without creating its file yet.
+     * @param path The file to keep the records in; overwritten if it exists. UTF-8.
+     */
+    explicit UndoJournal(std::string path);
+
+    /** @brief Closes the file and removes it. */
+    ~UndoJournal();
+
+    /**
+     * @brief Writes a record on top of the stack.
+     *
+     * @param header The fixed-size fields of the record.
+     * @param texts The texts of the record, written back to back after the header.
+     * @return true when the record was written; false when the journal failed, the stack left as it was.
+     */
+    [[nodiscard]] bool push(std::span<const char> header, std::span<const std::u16string_view> texts);
+
+    /**
+     * @brief Reads the record on top of the stack back and removes it.
+     *
+     * @param record Receives the header and the text of the record, as pushed.
+     * @return true when a record was read; false when the stack is empty or the read failed, which
+     *         also fails the journal.
+     */
+    [[nodiscard]] bool pop(std::vector<char> &record);
+
+    /** @brief Forgets every record; the file is written over from its start. */
+    void clear();
+
+    /** @return The number of records on the stack. */
+    [[nodiscard]] std::size_t getCount() const;
+
+    /** @return The bytes the records take on disk. */
+    [[nodiscard]] uint64_t getDiskUsage() const;
+
+    /** @return true until a write or a read failed. */
+    [[nodiscard]] bool isUsable() const;
+};
+
+
+#endif //UNDO_JOURNAL_H
@@ -0,0 +1,38 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUFFER_MEMORY_H
+#define BUFFER_MEMORY_H
+
+#include <cstddef>
+
+
+/**
+ * @brief Bytes held by a text buffer, split by what they store.
+ *
+ * Counts allocated capacity rather than used size, so the figures match what the buffer keeps
+ * from the allocator.
+ */
+struct BufferMemory final {
+    std::size_t text;          ///< Bytes holding the characters.
+    std::size_t line_table;    ///< Bytes of the per-line position table.
+    std::size_t line_metrics;  ///< Bytes of the per-line metrics kept for the longest-line tracking.
+};
+
+
+#endif //BUFFER_MEMORY_H
@@ -0,0 +1,41 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BUFFER_SPLICE_H
+#define BUFFER_SPLICE_H
+
+#include <string_view>
+
+#include "BufferEdit.h"
+
+
+/**
+ * @brief One replacement among the many a text buffer applies in a single splice.
+ *
+ * Both positions are in the coordinates of the buffer before any replacement of the splice is
+ * applied, so a caller lists its changes as it finds them, without tracking how each one moves
+ * the next.
+ */
+struct BufferSplice final {
+    BufferEdit::Position start; ///< Where the replaced range begins.
+    BufferEdit::Position end;   ///< Where the replaced range ends; not before start.
+    std::u16string_view text;   ///< The text put in its place, line breaks included.
+};
+
+
+#endif //BUFFER_SPLICE_H
@@ -26,6 +26,28 @@ LineBuffer::LineBuffer() {
     // Push one empty line and make it the current line.
     m_line_data.push_back(LineData{.start = 0, .count = 0});
     m_current_line_index = 0;
+    m_gap = 0;
+}
+
+std::size_t LineBuffer::roomNeeded() const {
+    return m_buffer.length() - m_gap + m_current_line.length() + m_line_data.size();
+}
+
+void LineBuffer::releaseSlack() {
+    const auto kept = roomNeeded();
+    const auto slack = m_buffer.capacity() - std::min(kept, m_buffer.capacity());
+    if (slack >= SLACK_MIN_UNITS && slack > m_buffer.length()) {
+        auto shrunk = std::u16string{};
+        shrunk.reserve(kept);
+        shrunk.append(m_buffer);
+        m_buffer = std::move(shrunk);
+    }
+}
+
+void LineBuffer::reserveBreaks() {
+    if (const auto needed = roomNeeded(); m_buffer.capacity() < needed) {
+        m_buffer.reserve(needed);
+    }
 }
 
 uint32_t LineBuffer::lineLength(const uint32_t line) const {
@@ -40,21 +62,84 @@ void LineBuffer::commitCurrentLine() {
     auto &data = m_line_data[m_current_line_index];
 
     const auto length = static_cast<uint32_t>(m_current_line.length());
-    if (length == 0) {
+    if (length == 0 && m_gap == 0) {
         data.count = 0;
         return;
     }
 
-    // Re-insert the detached characters at the slot reserved for the current line.
-    m_buffer.insert(data.start, m_current_line);
+    // Re-insert the detached characters at the slot reserved for the current line, over the gap.
+    m_buffer.replace(data.start, m_gap, m_current_line);
     data.count = length;
 
-    // Shift the following lines now that "length" characters were inserted.
+    // Shift the following lines now that "length" characters took the place of the gap.
+    const auto shift = length - m_gap;
     for (auto it = m_line_data.begin() + m_current_line_index + 1; it != m_line_data.end(); ++it) {
-        it->start += length;
+        it->start += shift;
     }
 
     m_current_line.clear();
+    m_gap = 0;
+}
+
+void LineBuffer::detachLine(const uint32_t line) {
+    const auto previous = m_current_line_index;
+    if (line == previous) {
+        return;
+    }
+
+    // The gap takes the previous line back in and hands the new one out: it must be wide enough
+    // for the difference. Growing it is the one step that moves the rest of the buffer.
+    const auto previous_length = static_cast<uint32_t>(m_current_line.length());
+    const auto length = m_line_data[line].count;
+    if (previous_length > m_gap + length) {
+        const auto room = previous_length - m_gap - length + std::max(GAP_MIN_UNITS, static_cast<uint32_t>(m_buffer.length() / GAP_GROWTH_DIVISOR));
+        m_buffer.insert(m_line_data[previous].start + m_gap, room, u'\0');
+        for (auto it = m_line_data.begin() + previous + 1; it != m_line_data.end(); ++it) {
+            it->start += room;
+        }
+        m_gap += room;
+        reserveBreaks();
+    }
+    const auto gap = m_gap + length - previous_length;
+
+    // The new line's text is parked after the previous one's, as the text between them may shift over it
+    m_current_line.append(m_buffer, m_line_data[line].start, length);
+    auto *const data = m_buffer.data();
+    using traits = std::u16string::traits_type;
+
+    if (line > previous) {
+        // [previous][gap][between][line] becomes [previous][between][gap]
+        const auto slot = m_line_data[previous].start;
+        const auto between_start = slot + m_gap;
+        const auto between_length = m_line_data[line].start - between_start;
+        traits::move(data + slot + previous_length, data + between_start, between_length);
+        traits::copy(data + slot, m_current_line.data(), previous_length);
+
+        const auto shift = previous_length - m_gap;
+        for (auto index = previous + 1; index < line; ++index) {
+            m_line_data[index].start += shift;
+        }
+        m_line_data[previous].count = previous_length;
+        m_line_data[line].start = slot + previous_length + between_length;
+    } else {
+        // [line][between][gap] becomes [gap][between][previous]
+        const auto slot = m_line_data[line].start;
+        const auto between_start = slot + length;
+        const auto between_length = m_line_data[previous].start - between_start;
+        traits::move(data + slot + gap, data + between_start, between_length);
+        traits::copy(data + slot + gap + between_length, m_current_line.data(), previous_length);
+
+        const auto shift = gap - length;
+        for (auto index = line + 1; index < previous; ++index) {
+            m_line_data[index].start += shift;
+        }
+        m_line_data[previous] = LineData{.start = slot + gap + between_length, .count = previous_length};
+    }
+
+    m_line_data[line].count = 0;
+    m_current_line.erase(0, previous_length);
+    m_current_line_index = line;
+    m_gap = gap;
 }
 
 std::u16string_view LineBuffer::getString(const uint32_t line) const {
@@ -71,6 +156,17 @@ uint32_t LineBuffer::getStringCount() const {
     return static_cast<uint32_t>(m_line_data.size());
 }
 
+uint32_t LineBuffer::getContiguousLineCount(const uint32_t line) const {
+    // Every line is in m_buffer in order, except the current one, which lives apart in m_current_line
+    if (line < m_current_line_index) {
+        return m_current_line_index - line;
+    }
+    if (line == m_current_line_index) {
+        return 1;
+    }
+    return static_cast<uint32_t>(m_line_data.size()) - line;
+}
+
 uint32_t LineBuffer::getLongestLineLength(const uint32_t tabWeight) const {
     return m_longest_line.getLongestLineLength(tabWeight);
 }
@@ -80,7 +176,7 @@ uint32_t LineBuffer::getLineTabCount(const uint32_t line) const {
 }
 
 uint32_t LineBuffer::detachedLengthBefore(const uint32_t line) const {
-    return line > m_current_line_index ? static_cast<uint32_t>(m_current_line.length()) : 0;
+    return line > m_current_line_index ? static_cast<uint32_t>(m_current_line.length()) - m_gap : 0;
 }
 
 uint32_t LineBuffer::getByteOffset(const uint32_t line, const uint32_t column) const {
@@ -123,6 +219,11 @@ BufferEdit LineBuffer::insert(uint32_t line, uint32_t column, const std::u16stri
         };
     }
 
+    // An insert that keeps to another line, or only splits it, first moves the current line there
+    if (line != m_current_line_index && (characters.find(u'\n') == std::u16string_view::npos || characters == u"\n")) {
+        detachLine(line);
+    }
+
     // Fast path: single-line insert (no "\n") into the current line only touches m_current_line.
     if (line == m_current_line_index && characters.find(U'\n') == std::u16string_view::npos) {
         const auto start_byte = getByteOffset(line, column);
@@ -170,6 +271,7 @@ BufferEdit LineBuffer::insert(uint32_t line, uint32_t column, const std::u16stri
         // The tail is already detached: dropping the head in place makes it the new current line.
         m_current_line.erase(0, column);
         m_current_line_index = line + 1;
+        reserveBreaks();
 
         m_longest_line.onEdit(*this, edit);
         return edit;
@@ -260,6 +362,7 @@ BufferEdit LineBuffer::insert(uint32_t line, uint32_t column, const std::u16stri
     for (auto it = m_line_data.begin() + end_line + 1; it != m_line_data.end(); ++it) {
         it->start += inserted_total - length;
     }
+    reserveBreaks();
 
     m_longest_line.onEdit(*this, edit);
     return edit;
@@ -283,6 +386,13 @@ BufferEdit LineBuffer::erase(uint32_t line, uint32_t column, uint32_t lineEnd, u
         };
     }
 
+    // An erase that keeps to another line, or only joins it with the next one, first moves the
+    // current line there
+    const auto is_join = lineEnd == line + 1 && columnEnd == 0;
+    if ((line == lineEnd || is_join) && m_current_line_index != line && !(is_join && m_current_line_index == lineEnd)) {
+        detachLine(line);
+    }
+
     // Fast path: erase within the current line only touches m_current_line.
     if (line == lineEnd && line == m_current_line_index) {
         // Find start and end byte
@@ -308,7 +418,7 @@ BufferEdit LineBuffer::erase(uint32_t line, uint32_t column, uint32_t lineEnd, u
     // Fast path: the mirror of the bare-newline insert. Joining a line with the one right below it
     // only merges m_current_line with a single neighbouring slot, as long as the current line is one
     // of the two: backspace at column 0 detaches the lower line, delete at the end the upper one.
-    if (lineEnd == line + 1 && columnEnd == 0 && (m_current_line_index == line || m_current_line_index == line + 1)) {
+    if (is_join && (m_current_line_index == line || m_current_line_index == line + 1)) {
         // Both offsets are read before anything moves, where the slow path reads them after folding
         // the current line back. The two agree: committing does not move the current line's own
         // start, and detachedLengthBefore already accounts for it on the line below.
@@ -410,6 +520,208 @@ BufferEdit LineBuffer::erase(uint32_t line, uint32_t column, uint32_t lineEnd, u
     for (auto it = m_line_data.begin() + line + 1; it != m_line_data.end(); ++it) {
         it->start -= length + erase_length;
     }
+    releaseSlack();
+    reserveBreaks();
+
+    m_longest_line.onEdit(*this, edit);
+    return edit;
+}
+
+BufferEdit LineBuffer::extract(uint32_t line, uint32_t column, uint32_t lineEnd, uint32_t columnEnd, std::u16string &removed) {
+    if (std::tie(line, column) > std::tie(lineEnd, columnEnd)) {
+        // Invert coordinates (swapping equal lines is a no-op)
+        std::swap(line, lineEnd);
+        std::swap(column, columnEnd);
+    }
+
+    // A range that leaves most of the text in place is copied out, then erased as usual
+    const auto span = getByteCount(line, column, lineEnd, columnEnd) / sizeof(char16_t);
+    const auto text = roomNeeded() - 1;
+    if (span < SLACK_MIN_UNITS || span * 2 < text) {
+        removed.clear();
+        removed.reserve(span);
+        for (auto index = line; index <= lineEnd; ++index) {
+            const auto string = getString(index);
+            const auto from = index == line ? column : 0;
+            const auto to = index == lineEnd ? columnEnd : string.length();
+            if (index != line) {
+                removed.push_back(u'\n');
+            }
+            removed.append(string.substr(from, to - from));
+        }
+        return erase(line, column, lineEnd, columnEnd);
+    }
+
+    // Typing on the current line is the one edit that can use up the room kept for the breaks:
+    // growing m_buffer is then ordinary string growth, done before any text is handed out.
+    reserveBreaks();
+    commitCurrentLine();
+
+    const auto start_byte = getByteOffset(line, column);
+    const auto edit = BufferEdit{
+        .start_byte = start_byte,
+        .old_end_byte = getByteOffset(lineEnd, columnEnd),
+        .new_end_byte = start_byte,
+        .start = {.line = line, .column = column},
+        .old_end = {.line = lineEnd, .column = columnEnd},
+        .new_end = {.line = line, .column = column}
+    };
+
+    const auto start_offset = m_line_data[line].start + column;
+    const auto end_offset = m_line_data[lineEnd].start + columnEnd;
+    const auto erase_length = end_offset - start_offset;
+    const auto breaks = lineEnd - line;
+
+    // The text kept is the little part: it alone is copied, into a storage with room for its breaks
+    auto kept = std::u16string{};
+    kept.reserve(m_buffer.length() - erase_length + m_line_data.size() - breaks);
+    kept.append(m_buffer, 0, start_offset);
+    kept.append(m_buffer, end_offset);
+
+    // The erased range becomes the removed text in m_buffer's own storage: slid to its front, then
+    // opened from the back for the line breaks, which the capacity kept has room for.
+    auto *const data = m_buffer.data();
+    using traits = std::u16string::traits_type;
+    traits::move(data, data + start_offset, erase_length);
+    m_buffer.resize(erase_length + breaks);
+    for (auto index = lineEnd; index > line; --index) {
+        const auto from = m_line_data[index].start - start_offset;
+        const auto shift = index - line;
+        traits::move(data + from + shift, data + from, index == lineEnd ? columnEnd : m_line_data[index].count);
+        data[from + shift - 1] = u'\n';
+    }
+    removed = std::move(m_buffer);
+    m_buffer = std::move(kept);
+
+    auto &current = m_line_data[line];
+    if (line == lineEnd) {
+        current.count -= erase_length;
+    } else {
+        current.count = column + (m_line_data[lineEnd].count - columnEnd);
+        m_line_data.erase(m_line_data.begin() + line + 1, m_line_data.begin() + lineEnd + 1);
+    }
+
+    // The line the edit ends on is the new current line. Its slot is left as the gap rather than
+    // erased, so the following lines only move by the erased length.
+    m_current_line.assign(m_buffer, current.start, current.count);
+    m_current_line_index = line;
+    m_gap = current.count;
+    current.count = 0;
+
+    for (auto it = m_line_data.begin() + line + 1; it != m_line_data.end(); ++it) {
+        it->start -= erase_length;
+    }
+
+    m_longest_line.onEdit(*this, edit);
+    return edit;
+}
+
+BufferEdit LineBuffer::splice(const std::span<const BufferSplice> splices) {
+    // Fold everything back: the touched lines are rebuilt whole, and the last of them is detached
+    // again as the new current line.
+    commitCurrentLine();
+
+    const auto first = splices.front().start;
+    const auto last = splices.back().end;
+    const auto start_byte = getByteOffset(first.line, first.column);
+    const auto old_end_byte = getByteOffset(last.line, last.column);
+
+    // The rebuilt region covers the touched lines from their first character to their last one, so
+    // it replaces a single run of m_buffer. Its new text is assembled apart, flattened the way the
+    // buffer stores it, with the length of every line it ends up holding.
+    const auto region_start = m_line_data[first.line].start;
+    const auto region_end = m_line_data[last.line].start + m_line_data[last.line].count;
+
+    auto flattened = std::u16string{};
+    auto lengths = std::vector<uint32_t>{};
+    auto length = 0u;
+    auto copied = BufferEdit::Position{.line = first.line, .column = 0};
+    auto removed_bytes = 0u;
+    auto inserted_bytes = 0u;
+
+    // Copies the untouched text from where the previous copy stopped up to a position. The lines
+    // are read from m_buffer directly: for the line just committed, getString would still hand
+    // back the emptied m_current_line.
+    const auto line_text = [this](const uint32_t line) {
+        return std::u16string_view(m_buffer).substr(m_line_data[line].start, m_line_data[line].count);
+    };
+    const auto copy_up_to = [&](const BufferEdit::Position &to) {
+        for (; copied.line < to.line; ++copied.line, copied.column = 0) {
+            const auto rest = line_text(copied.line).substr(copied.column);
+            flattened.append(rest);
+            lengths.push_back(length + static_cast<uint32_t>(rest.length()));
+            length = 0;
+        }
+
+        const auto head = line_text(to.line).substr(copied.column, to.column - copied.column);
+        flattened.append(head);
+        length += static_cast<uint32_t>(head.length());
+        copied.column = to.column;
+    };
+
+    flattened.reserve(region_end - region_start);
+    for (const auto &[start, end, text] : splices) {
+        copy_up_to(start);
+        removed_bytes += getByteCount(start.line, start.column, end.line, end.column);
+        inserted_bytes += static_cast<uint32_t>(text.length() * sizeof(char16_t));
+
+        // Each line break of the replacement closes the line being built
+        auto rest = text;
+        for (auto i = rest.find(u'\n'); i != std::u16string_view::npos; i = rest.find(u'\n')) {
+            flattened.append(rest.substr(0, i));
+            lengths.push_back(length + static_cast<uint32_t>(i));
+            length = 0;
+            rest.remove_prefix(i + 1);
+        }
+        flattened.append(rest);
+        length += static_cast<uint32_t>(rest.length());
+        copied = end;
+    }
+
+    const auto edit = BufferEdit{
+        .start_byte = start_byte,
+        .old_end_byte = old_end_byte,
+        .new_end_byte = old_end_byte - removed_bytes + inserted_bytes,
+        .start = first,
+        .old_end = last,
+        .new_end = {.line = first.line + static_cast<uint32_t>(lengths.size()), .column = length}
+    };
+
+    copy_up_to({.line = last.line, .column = m_line_data[last.line].count});
+    lengths.push_back(length);
+
+    // The line the splice ends on is the last one of the region: it goes straight to the current
+    // line instead of passing through m_buffer.
+    m_current_line.assign(flattened, flattened.length() - length, length);
+    flattened.resize(flattened.length() - length);
+    m_buffer.replace(region_start, region_end - region_start, flattened);
+
+    // Reshape the metadata of the region in one shift, then lay its lines out back to back.
+    const auto old_line_count = last.line - first.line + 1;
+    const auto new_line_count = static_cast<uint32_t>(lengths.size());
+    const auto region_data = m_line_data.begin() + first.line + 1;
+    if (new_line_count > old_line_count) {
+        m_line_data.insert(region_data, new_line_count - old_line_count, LineData{});
+    } else if (new_line_count < old_line_count) {
+        m_line_data.erase(region_data, region_data + (old_line_count - new_line_count));
+    }
+
+    auto offset = region_start;
+    for (auto i = 0u; i < new_line_count; ++i) {
+        auto &data = m_line_data[first.line + i];
+        data.start = offset;
+        data.count = i + 1 < new_line_count ? lengths[i] : 0;
+        offset += data.count;
+    }
+
+    // Shift all the following line offsets; the region ended at region_end and now ends at offset
+    for (auto it = m_line_data.begin() + first.line + new_line_count; it != m_line_data.end(); ++it) {
+        it->start = it->start - region_end + offset;
+    }
+
+    m_current_line_index = edit.new_end.line;
+    releaseSlack();
+    reserveBreaks();
 
     m_longest_line.onEdit(*this, edit);
     return edit;
@@ -447,4 +759,13 @@ BufferEdit LineBuffer::clear() {
             .column = 0
         }
     };
-}
\ No newline at end of file
+}
+
+BufferMemory LineBuffer::getMemoryUsage() const {
+    // The detached current line is text too: it is only out of m_buffer while being edited
+    return {
+        .text = (m_buffer.capacity() + m_current_line.capacity()) * sizeof(char16_t),
+        .line_table = m_line_data.capacity() * sizeof(LineData),
+        .line_metrics = m_longest_line.getMemoryUsage()
+    };
+}
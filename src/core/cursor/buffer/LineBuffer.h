@@ -19,12 +19,14 @@
 #ifndef LINE_BUFFER_H
 #define LINE_BUFFER_H
 
+#include <span>
 #include <vector>
 #include <string>
 #include <string_view>
 
 #include "TextBuffer.h"
 #include "BufferEdit.h"
+#include "BufferSplice.h"
 #include "LongestLineTracker.h"
 
 
@@ -41,14 +43,20 @@
  * buffer before each rendering frame anyway (because the renderer expects contiguous data).
  *
  * While a line is the current line:
- *   - its characters are absent from m_buffer,
+ *   - its characters are absent from m_buffer, where its slot may hold a gap of m_gap unused units,
  *   - m_line_data[m_current_line_index].count is kept at 0,
  *   - m_line_data[m_current_line_index].start does not change (important to keep bytecount/offset for BufferEdits)
  *   - the source of truth for its content/length is m_current_line.
  *
  * Editing/erasing that stays on the current line only touches m_current_line and is cheap (no reflow of buffer).
- * The buffer is only modified when an edit happens on another line, at which point the current line is committed back
- * into the buffer and the current line is changed.
+ * An edit of another line that keeps to a line, or only splits or joins it, moves the current line there: its text
+ * fills the gap, the text between the two lines shifts, and the new current line leaves a gap of its own, so the rest
+ * of the buffer stays where it is. Any other edit commits the current line back, closing the gap, and reflows the
+ * buffer.
+ *
+ * m_buffer keeps room for the whole text with one line break per line. A range extracted that spans most of the text
+ * takes m_buffer's storage along, turned into the range's text in place, breaks included, while the little text left is copied into
+ * a new storage: a large deletion never holds the text twice.
  */
 class LineBuffer final : public TextBuffer {
 private:
@@ -63,6 +71,15 @@ private:
     };
 
 private:
+    /** Unused room, in code units, m_buffer must hold before an erase hands it back (128 KiB). */
+    static constexpr std::size_t SLACK_MIN_UNITS = std::size_t{1} << 16;
+
+    /** Smallest room, in code units, a gap too narrow for the line moving into it grows by. */
+    static constexpr uint32_t GAP_MIN_UNITS = 4096;
+
+    /** A gap too narrow grows by at least the text held divided by this, so it grows a few times only. */
+    static constexpr uint32_t GAP_GROWTH_DIVISOR = 64;
+
     /** Contiguous buffer storing every line except the current line. */
     std::u16string m_buffer;
 
@@ -72,6 +89,9 @@ private:
     /** Index of the line. */
     uint32_t m_current_line_index;
 
+    /** Unused code units at the current line's slot in m_buffer; the lines after it start past them. */
+    uint32_t m_gap;
+
     /** Metadata describing each line's position and length. */
     std::vector<LineData> m_line_data;
 
@@ -82,15 +102,45 @@ private:
     /**
      * @brief Commits m_current_line back into m_buffer at the current line slot.
      *
-     * Inserts m_current_line into m_buffer, restores
+     * Inserts m_current_line into m_buffer in place of the gap, restores
      * m_line_data[m_current_line_index].count and shifts the following lines' offsets.
      */
     void commitCurrentLine();
 
+    /**
+     * @brief Makes another line the current line without reflowing the buffer.
+     *
+     * The current line's text goes into the gap, growing it first when it is too narrow, and the
+     * text between the two lines shifts to leave the new current line's slot as the gap. Costs the
+     * distance between the two lines, not the size of the buffer.
+     *
+     * @param line The line to detach.
+     */
+    void detachLine(uint32_t line);
+
+    /**
+     * @brief Hands the unused room of m_buffer back to the allocator, once it is large.
+     *
+     * A string keeps its capacity when text is erased from it: after deleting most of a large
+     * buffer, the erased text would stay allocated here, on top of the copy the undo history
+     * keeps. The room is released once it exceeds SLACK_MIN_UNITS and the text still held; the
+     * room for the line breaks stays.
+     */
+    void releaseSlack();
+
+    /** @return The room m_buffer keeps: the whole text, the current line included, and one line break per line. */
+    [[nodiscard]] std::size_t roomNeeded() const;
+
+    /** @brief Grows m_buffer when it lacks the room extract() relies on, see roomNeeded(). */
+    void reserveBreaks();
+
     /** @return The real character count of a line (using m_current_line for the current one). */
     [[nodiscard]] uint32_t lineLength(uint32_t line) const;
 
-    /** @return The detached current line's length when it lies before the given line, 0 otherwise. */
+    /**
+     * @return What the offsets of the given line differ by from m_line_data when the current line lies before it:
+     * its detached length less the gap (modulo 2^32, so adding it to an offset lands back in range), 0 otherwise.
+     */
     [[nodiscard]] uint32_t detachedLengthBefore(uint32_t line) const;
 
 public:
@@ -99,13 +149,17 @@ public:
 
     [[nodiscard]] std::u16string_view getString(uint32_t line) const override;
     [[nodiscard]] uint32_t getStringCount() const override;
+    [[nodiscard]] uint32_t getContiguousLineCount(uint32_t line) const override;
     [[nodiscard]] uint32_t getLongestLineLength(uint32_t tabWeight) const override;
     [[nodiscard]] uint32_t getLineTabCount(uint32_t line) const override;
     [[nodiscard]] uint32_t getByteOffset(uint32_t line, uint32_t column) const override;
     [[nodiscard]] uint32_t getByteCount(uint32_t lineStart, uint32_t columnStart, uint32_t lineEnd, uint32_t columnEnd) const override;
     [[nodiscard]] BufferEdit insert(uint32_t line, uint32_t column, std::u16string_view characters) override;
     [[nodiscard]] BufferEdit erase(uint32_t line, uint32_t column, uint32_t lineEnd, uint32_t columnEnd) override;
+    [[nodiscard]] BufferEdit extract(uint32_t line, uint32_t column, uint32_t lineEnd, uint32_t columnEnd, std::u16string &removed) override;
+    [[nodiscard]] BufferEdit splice(std::span<const BufferSplice> splices) override;
     [[nodiscard]] BufferEdit clear() override;
+    [[nodiscard]] BufferMemory getMemoryUsage() const override;
 };
 
 
@@ -114,6 +114,10 @@ uint32_t LongestLineTracker::getLineTabCount(const uint32_t line) const {
     return m_metrics[line].tab_count;
 }
 
+std::size_t LongestLineTracker::getMemoryUsage() const {
+    return m_metrics.capacity() * sizeof(LineMetric);
+}
+
 void LongestLineTracker::rescan() const {
     m_max_line = 0;
     m_max_length = 0;
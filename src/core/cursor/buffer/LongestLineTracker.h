@@ -19,6 +19,7 @@
 #ifndef LONGEST_LINE_TRACKER_H
 #define LONGEST_LINE_TRACKER_H
 
+#include <cstddef>
 #include <cstdint>
 #include <string_view>
 #include <vector>
@@ -111,6 +112,9 @@ public:
      * @return The number of tab characters in the line.
      */
     [[nodiscard]] uint32_t getLineTabCount(uint32_t line) const;
+
+    /** @return The bytes held by the per-line metrics. */
+    [[nodiscard]] std::size_t getMemoryUsage() const;
 };
 
 
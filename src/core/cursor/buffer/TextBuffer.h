@@ -19,9 +19,13 @@
 #ifndef TEXT_BUFFER_H
 #define TEXT_BUFFER_H
 
+#include <span>
+#include <string>
 #include <string_view>
 
 #include "BufferEdit.h"
+#include "BufferMemory.h"
+#include "BufferSplice.h"
 
 
 /**
@@ -55,6 +59,17 @@ public:
     /** @return The total number of lines in the buffer. */
     [[nodiscard]] virtual uint32_t getStringCount() const = 0;
 
+    /**
+     * @brief Returns how many lines, starting at the given one, are stored back to back.
+     *
+     * The views getString returns for those lines then lie one right after the other in memory, so
+     * a search can scan all of them in one pass. Lines are not separated by any character.
+     *
+     * @param line The first line of the run.
+     * @return The number of lines in the run, at least 1.
+     */
+    [[nodiscard]] virtual uint32_t getContiguousLineCount(uint32_t line) const = 0;
+
     /**
      * @brief Returns the weighted character length of the longest line in the buffer.
      *
@@ -112,8 +127,37 @@ public:
      */
     [[nodiscard]] virtual BufferEdit erase(uint32_t lineStart, uint32_t columnStart, uint32_t lineEnd, uint32_t columnEnd) = 0;
 
+    /**
+     * @brief Removes text like erase(), handing the removed text over.
+     *
+     * A buffer may give up its own storage as the removed text rather than copy it out, so the
+     * text of a large deletion is never held twice.
+     *
+     * @param lineStart Starting line index.
+     * @param columnStart Starting column index.
+     * @param lineEnd Ending line index.
+     * @param columnEnd Ending column index.
+     * @param removed Receives the removed text, line breaks included; its previous content is lost.
+     */
+    [[nodiscard]] virtual BufferEdit extract(uint32_t lineStart, uint32_t columnStart, uint32_t lineEnd, uint32_t columnEnd, std::u16string &removed) = 0;
+
+    /**
+     * @brief Applies many replacements at once, as a single edit.
+     *
+     * The replacements must be sorted by position and must not overlap; two of them may touch.
+     * Every position is read against the buffer before the call. The edit returned spans from the
+     * start of the first replacement to the end of the last one.
+     *
+     * @param splices The replacements, at least one.
+     * @return A BufferEdit covering the whole touched range.
+     */
+    [[nodiscard]] virtual BufferEdit splice(std::span<const BufferSplice> splices) = 0;
+
     /** @brief Clears the entire content of the text buffer. */
     [[nodiscard]] virtual BufferEdit clear() = 0;
+
+    /** @return The bytes held by the buffer, split by what they store. */
+    [[nodiscard]] virtual BufferMemory getMemoryUsage() const = 0;
 };
 
 
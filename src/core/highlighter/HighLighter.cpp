@@ -35,6 +35,7 @@ HighLighter::HighLighter(Cursor &cursor)
       p_ts_tree(nullptr),
       p_ts_query_cursor(ts_query_cursor_new()),
       m_cache_start_line(0),
+      m_cache_miss_count(0),
       // TSInput is third-party and carries no in-class initializers: its trailing `decode` member
       // is spelled out. It only applies to TSInputEncodingCustom, so a UTF-16LE input has no
       // custom decoder and passes nullptr.
@@ -342,12 +343,42 @@ std::span<const TokenId> HighLighter::getHighLightLine(const uint32_t line) cons
     }
 
     if (line < m_cache_start_line || line >= m_cache_start_line + m_line_cache.size()) {
+        ++m_cache_miss_count;
         updateCache(line);
     }
 
     return m_line_cache[line - m_cache_start_line];
 }
 
+uint32_t HighLighter::getCacheStartLine() const {
+    return m_cache_start_line;
+}
+
+uint32_t HighLighter::getCacheLineCount() const {
+    return static_cast<uint32_t>(m_line_cache.size());
+}
+
+uint32_t HighLighter::getCacheMissCount() const {
+    return m_cache_miss_count;
+}
+
+std::size_t HighLighter::getCacheMemoryUsage() const {
+    auto bytes = m_line_cache.capacity() * sizeof(std::vector<TokenId>);
+    for (const auto &row : m_line_cache) {
+        bytes += row.capacity() * sizeof(TokenId);
+    }
+    return bytes;
+}
+
+std::size_t HighLighter::getTreeMemoryUsage() const {
+    if (p_ts_tree == nullptr) {
+        return 0;
+    }
+
+    const auto node_count = ts_node_descendant_count(ts_tree_root_node(p_ts_tree));
+    return static_cast<std::size_t>(node_count) * TREE_NODE_BYTES;
+}
+
 std::optional<std::u16string_view> HighLighter::readCallback(const uint32_t line, const uint32_t column) const {
     const auto line_count = m_cursor.getLineCount();
     if (line >= line_count) {
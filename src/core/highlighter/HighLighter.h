@@ -19,6 +19,7 @@
 #ifndef HIGH_LIGHTER_H
 #define HIGH_LIGHTER_H
 
+#include <cstddef>
 #include <functional>
 #include <optional>
 #include <span>
@@ -47,6 +48,12 @@ private:
     /** Number of lines covered by the highlight cache window. */
     static constexpr uint32_t CACHE_LINE_COUNT = 512;
 
+    /**
+     * Approximate bytes tree-sitter allocates per syntax node, used to estimate the tree size:
+     * the library does not expose its allocations.
+     */
+    static constexpr std::size_t TREE_NODE_BYTES = 80;
+
 private:
     /** Reference to the cursor giving the text data to this highlighter */
     const Cursor &m_cursor;
@@ -72,6 +79,9 @@ private:
     /** First line covered by m_line_cache. */
     mutable uint32_t m_cache_start_line;
 
+    /** Number of times a query fell outside the cache window and rebuilt it, since construction. */
+    mutable uint32_t m_cache_miss_count;
+
     /** Tree-sitter input wrapper for reading source text. */
     TSInput m_input;
 
@@ -200,6 +210,32 @@ public:
      */
     [[nodiscard]] std::span<const TokenId> getHighLightLine(uint32_t line) const;
 
+    /** @return The first line covered by the highlight cache window. */
+    [[nodiscard]] uint32_t getCacheStartLine() const;
+
+    /** @return The number of lines covered by the highlight cache window, 0 when nothing is cached. */
+    [[nodiscard]] uint32_t getCacheLineCount() const;
+
+    /**
+     * @brief Returns how many times a line query fell outside the cache window and rebuilt it.
+     *
+     * The count only grows: sample it around a frame to know the misses of that frame.
+     */
+    [[nodiscard]] uint32_t getCacheMissCount() const;
+
+    /** @return The bytes held by the highlight cache rows. */
+    [[nodiscard]] std::size_t getCacheMemoryUsage() const;
+
+    /**
+     * @brief Estimates the bytes held by the tree-sitter syntax tree.
+     *
+     * Derived from the node count of the tree times TREE_NODE_BYTES; the count is kept by
+     * tree-sitter, so no walk happens.
+     *
+     * @return The estimated tree size in bytes, 0 when there is no tree.
+     */
+    [[nodiscard]] std::size_t getTreeMemoryUsage() const;
+
     /** @return The current highlight mode name (e.g., "cpp", "json"). */
     [[nodiscard]] std::string_view getModeString() const;
 
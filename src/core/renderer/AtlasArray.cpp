@@ -135,6 +135,16 @@ uint8_t AtlasArray::getCurrentLayer() const {
     return m_character_layer;
 }
 
+uint8_t AtlasArray::getLayerCount() const {
+    return m_layer_count;
+}
+
+std::size_t AtlasArray::getMemoryUsage() const {
+    constexpr auto layer_bytes = static_cast<std::size_t>(UINT8_MAX) * UINT8_MAX;
+    const auto map_bytes = m_characters.bucket_count() * sizeof(void *) + m_characters.size() * sizeof(std::pair<const char16_t, AtlasEntry>);
+    return m_layer_count * layer_bytes + sizeof(m_ascii_characters) + sizeof(m_ascii_present) + map_bytes;
+}
+
 void AtlasArray::clearCharacters() {
     m_ascii_present.fill(false);
     m_characters.clear();
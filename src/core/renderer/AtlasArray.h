@@ -20,6 +20,7 @@
 #define ATLAS_ARRAY_H
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <unordered_map>
 
@@ -116,6 +117,17 @@ public:
     /** @brief Gets the current layer index used for character insertion. */
     [[nodiscard]] uint8_t getCurrentLayer() const;
 
+    /** @brief Gets the number of layers the atlas may fill. */
+    [[nodiscard]] uint8_t getLayerCount() const;
+
+    /**
+     * @brief Returns the bytes held for this atlas.
+     *
+     * Counts the 8-bit texture storage its layers span (allocated up front, filled or not) and the
+     * entries of the character map.
+     */
+    [[nodiscard]] std::size_t getMemoryUsage() const;
+
     /** @brief Clears all character entries and resets character layers. */
     void clearCharacters();
 };
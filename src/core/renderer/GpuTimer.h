@@ -0,0 +1,106 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <array>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+
+/**
+ * @brief Measures the GPU time spent between begin() and end() with GL_TIME_ELAPSED queries.
+ *
+ * Queries are issued in a small ring and read back only once the driver reports them available,
+ * a few frames later, so measuring never stalls the pipeline. The results are smoothed into a
+ * running average. When timer queries are unsupported, every method is a no-op and the average
+ * stays at zero.
+ *
+ * Only one GL_TIME_ELAPSED query can be active at a time: timers must not be nested.
+ */
+class GpuTimer final {
+public:
+    /** Number of queries in flight; a frame whose slot is still pending is simply not measured. */
+    static constexpr uint32_t QUERY_COUNT = 4;
+
+    /** Weight of a new sample in the running average. */
+    static constexpr float SMOOTHING = 0.1f;
+
+private:
+    /** Ring of OpenGL query objects. */
+    std::array<GLuint, QUERY_COUNT> m_queries;
+
+    /** Index of the oldest query waiting for its result. */
+    uint32_t m_pending_start;
+
+    /** Number of queries issued whose result was not read back yet. */
+    uint32_t m_pending_count;
+
+    /** Whether the context supports timer queries; decided in create(). */
+    bool m_available;
+
+    /** Whether a query is currently active (between begin() and end()). */
+    bool m_active;
+
+    /** Whether m_milliseconds holds at least one sample. */
+    bool m_has_sample;
+
+    /** Smoothed GPU time, in milliseconds. */
+    float m_milliseconds;
+
+public:
+    /** @brief Deleted copy constructor. */
+    GpuTimer(const GpuTimer &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    GpuTimer &operator=(const GpuTimer &) = delete;
+
+    /** @brief Constructs an uninitialized GpuTimer. */
+    explicit GpuTimer();
+
+    /**
+     * @brief Creates the query objects, when the context supports timer queries.
+     *
+     * Must be called after the OpenGL functions are loaded. Support is detected from the context
+     * version (timer queries are core since 3.3) and a non-zero counter precision.
+     */
+    void create();
+
+    /** @brief Releases the query objects. */
+    void destroy();
+
+    /** @brief Starts measuring; skipped when unsupported or when every query is still in flight. */
+    void begin();
+
+    /** @brief Stops measuring the span opened by begin(). */
+    void end();
+
+    /** @brief Folds the results that became available into the average, without waiting on the GPU. */
+    void collect();
+
+    /** @brief Returns whether the context supports timer queries. */
+    [[nodiscard]] bool isAvailable() const;
+
+    /** @brief Returns the smoothed GPU time, in milliseconds; zero until a first result arrives. */
+    [[nodiscard]] float getMilliseconds() const;
+};
+
+
+#endif //GPU_TIMER_H
@@ -19,6 +19,7 @@
 #ifndef QUAD_BUFFER_H
 #define QUAD_BUFFER_H
 
+#include <cstddef>
 #include <vector>
 
 #include <glad/glad.h>
@@ -160,6 +161,12 @@ public:
      * already closed by endBatch() must be sized with the count endBatch() returned.
      */
     [[nodiscard]] uint32_t getCount() const;
+
+    /** @return The number of quads committed by the batches closed since resetFrame(). */
+    [[nodiscard]] uint32_t getFrameCount() const;
+
+    /** @return The bytes held by the GPU buffer and the CPU-side staging storage. */
+    [[nodiscard]] std::size_t getMemoryUsage() const;
 };
 
 
@@ -39,6 +39,9 @@ private:
     /** Handle to the matrix uniform location used for transformations. */
     GLint m_matrix_uniform;
 
+    /** Number of draw calls issued since the last resetDrawCount(). */
+    uint32_t m_draw_count;
+
 public:
     /** @brief Deleted copy constructor. */
     QuadProgram(const QuadProgram &) = delete;
@@ -75,10 +78,18 @@ public:
     /**
      * @brief Issues a draw call to render a range of quads from the vertex buffer.
      *
+     * Every call is counted, see getDrawCount().
+     *
      * @param start First index of the vertex buffer.
      * @param count Number of quads to render.
      */
-    void draw(uint32_t start, uint32_t count) const;
+    void draw(uint32_t start, uint32_t count);
+
+    /** @brief Restarts the draw call count, once per frame. */
+    void resetDrawCount();
+
+    /** @return The number of draw calls issued since the last resetDrawCount(). */
+    [[nodiscard]] uint32_t getDrawCount() const;
 };
 
 
@@ -0,0 +1,110 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "../GpuTimer.h"
+
+
+GpuTimer::GpuTimer()
+    : m_queries{},
+      m_pending_start(0),
+      m_pending_count(0),
+      m_available(false),
+      m_active(false),
+      m_has_sample(false),
+      m_milliseconds(0.0f) {}
+
+void GpuTimer::create() {
+    // Timer queries are core since 3.3, but some drivers expose the entry points with a
+    // zero-bit counter: treat that as unsupported too.
+    m_available = false;
+    if (GLAD_GL_VERSION_3_3) {
+        auto counter_bits = GLint{0};
+        glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &counter_bits);
+        m_available = counter_bits > 0;
+    }
+
+    if (!m_available) {
+        return;
+    }
+
+    glGenQueries(QUERY_COUNT, m_queries.data());
+}
+
+void GpuTimer::destroy() {
+    if (m_available) {
+        glDeleteQueries(QUERY_COUNT, m_queries.data());
+    }
+
+    m_queries = {};
+    m_pending_start = 0;
+    m_pending_count = 0;
+    m_available = false;
+    m_active = false;
+    m_has_sample = false;
+    m_milliseconds = 0.0f;
+}
+
+void GpuTimer::begin() {
+    // Every slot still waiting on the GPU: drop this measure rather than wait for one
+    if (!m_available || m_pending_count == QUERY_COUNT) {
+        return;
+    }
+
+    const auto slot = (m_pending_start + m_pending_count) % QUERY_COUNT;
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[slot]);
+    m_active = true;
+}
+
+void GpuTimer::end() {
+    if (!m_active) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_active = false;
+    ++m_pending_count;
+}
+
+void GpuTimer::collect() {
+    // Results complete in submission order: stop at the first one not ready yet
+    while (m_pending_count > 0) {
+        const auto query = m_queries[m_pending_start];
+        auto available = GLint{0};
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0) {
+            break;
+        }
+
+        auto elapsed = GLuint64{0};
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        const auto milliseconds = static_cast<float>(static_cast<double>(elapsed) / 1'000'000.0);
+        m_milliseconds = m_has_sample ? m_milliseconds + (milliseconds - m_milliseconds) * SMOOTHING : milliseconds;
+        m_has_sample = true;
+
+        m_pending_start = (m_pending_start + 1) % QUERY_COUNT;
+        --m_pending_count;
+    }
+}
+
+bool GpuTimer::isAvailable() const {
+    return m_available;
+}
+
+float GpuTimer::getMilliseconds() const {
+    return m_milliseconds;
+}
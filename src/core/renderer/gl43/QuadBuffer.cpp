@@ -143,3 +143,11 @@ GLuint QuadBuffer::getBuffer() const {
 uint32_t QuadBuffer::getCount() const {
     return static_cast<uint32_t>(m_staging.size());
 }
+
+uint32_t QuadBuffer::getFrameCount() const {
+    return m_frame_count;
+}
+
+std::size_t QuadBuffer::getMemoryUsage() const {
+    return (static_cast<std::size_t>(m_capacity) + m_staging.capacity()) * sizeof(QuadVertex);
+}
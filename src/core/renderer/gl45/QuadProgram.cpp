@@ -102,7 +102,8 @@ static constexpr auto FRAGMENT_SRC = R"text(
 QuadProgram::QuadProgram()
     : m_vao(0),
       m_program(0),
-      m_matrix_uniform(-1) {}
+      m_matrix_uniform(-1),
+      m_draw_count(0) {}
 
 void QuadProgram::create() {
     // Create the fragment and vertex shader
@@ -190,6 +191,7 @@ void QuadProgram::destroy() {
     m_vao = 0;
     m_program = 0;
     m_matrix_uniform = -1;
+    m_draw_count = 0;
 }
 
 void QuadProgram::use() const {
@@ -205,7 +207,16 @@ void QuadProgram::setMatrix(const float* matrix) const {
     glUniformMatrix4fv(m_matrix_uniform, 1, GL_TRUE, matrix);
 }
 
-void QuadProgram::draw(const uint32_t start, const uint32_t count) const {
+void QuadProgram::draw(const uint32_t start, const uint32_t count) {
     const auto count_i = static_cast<int32_t>(count);
     glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, count_i, start);
+    ++m_draw_count;
+}
+
+void QuadProgram::resetDrawCount() {
+    m_draw_count = 0;
+}
+
+uint32_t QuadProgram::getDrawCount() const {
+    return m_draw_count;
 }
@@ -31,6 +31,7 @@ enum class ColorId {
     MarginBackground,       ///< Background color of the margin area (line number container).
     LineBackground,         ///< Background color for the current (at cursor position) text lines.
     SelectedTextBackground, ///< Background color for selected text range.
+    MatchBackground,        ///< Background color of the search matches in view.
     LineNumber,             ///< Color for the line numbers.
     InfoBarBackground,      ///< Background color of the info bar.
     EditorBackground,       ///< Background color of the editor area.
@@ -146,6 +146,7 @@ void Theme::registerThemeColorCVar(CVarRegistry &registry) {
     const auto &cvar_prompt_background_color         = m_colors[static_cast<size_t>(ColorId::PromptBackground)]       = std::make_shared<CVarColor>(210, 210, 210, 255);
     const auto &cvar_current_line_background_color   = m_colors[static_cast<size_t>(ColorId::LineBackground)]         = std::make_shared<CVarColor>(  0,   0,   0,  12);
     const auto &cvar_selected_text_background_color  = m_colors[static_cast<size_t>(ColorId::SelectedTextBackground)] = std::make_shared<CVarColor>(  0, 200, 255,  32);
+    const auto &cvar_match_background_color          = m_colors[static_cast<size_t>(ColorId::MatchBackground)]        = std::make_shared<CVarColor>(255, 190,   0,  72);
     const auto &cvar_line_number_color               = m_colors[static_cast<size_t>(ColorId::LineNumber)]             = std::make_shared<CVarColor>(  0,   0,   0, 220);
     const auto &cvar_info_bar_text_color             = m_colors[static_cast<size_t>(ColorId::InfoBarText)]            = std::make_shared<CVarColor>(  0,   0,   0, 220);
     const auto &cvar_prompt_text_color               = m_colors[static_cast<size_t>(ColorId::PromptText)]             = std::make_shared<CVarColor>(  0,   0,   0, 220);
@@ -167,6 +168,7 @@ void Theme::registerThemeColorCVar(CVarRegistry &registry) {
     registry.registerCvar(u"col_prompt_background",        cvar_prompt_background_color, nullptr);
     registry.registerCvar(u"col_current_line_background",  cvar_current_line_background_color, nullptr);
     registry.registerCvar(u"col_selected_text_background", cvar_selected_text_background_color, nullptr);
+    registry.registerCvar(u"col_match_background",         cvar_match_background_color, nullptr);
     registry.registerCvar(u"col_line_number",              cvar_line_number_color, nullptr);
     registry.registerCvar(u"col_info_bar_text",            cvar_info_bar_text_color, nullptr);
     registry.registerCvar(u"col_prompt_text",              cvar_prompt_text_color, nullptr);
@@ -335,6 +337,14 @@ const AtlasEntry &Theme::getCharacter(const char16_t character) {
     return *entry;
 }
 
+const AtlasArray &Theme::getAtlasArray() const {
+    return m_atlas_array;
+}
+
+std::size_t Theme::getAtlasMemoryUsage() const {
+    return m_atlas_array.getMemoryUsage() + m_label_atlas.getMemoryUsage();
+}
+
 const AtlasEntry &Theme::getLabelCharacter(const char16_t character) {
     const auto *entry = loadGlyph(m_label_font, m_label_atlas, m_label_texture, character);
     if (entry == nullptr) {
@@ -20,6 +20,7 @@
 #define THEME_H
 
 #include <array>
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -236,6 +237,12 @@ public:
      */
     [[nodiscard]] const AtlasEntry &getCharacter(char16_t character);
 
+    /** @return The atlas holding the glyphs of the main face. */
+    [[nodiscard]] const AtlasArray &getAtlasArray() const;
+
+    /** @return The bytes held by the glyph atlases of both faces, textures included. */
+    [[nodiscard]] std::size_t getAtlasMemoryUsage() const;
+
     /**
      * @brief Returns label glyph metadata for the given character, from the fixed-size label atlas.
      *
@@ -23,6 +23,7 @@
 #include <array>
 #include <limits>
 #include <ranges>
+#include <tuple>
 #include <utf8.h>
 
 #include "../core/theme/DimensionId.h"
@@ -46,6 +47,7 @@ Editor::Editor(GlobalRegistry<CursorContext> &commandController, Theme &theme, Q
     : View(commandController, theme, quadProgram),
       m_is_tab_to_space(std::make_shared<CVarBool>(true)),
       m_show_scrollbar(std::make_shared<CVarBool>(true)),
+      m_show_search_matches(std::make_shared<CVarBool>(true)),
       m_mouse_drag(MouseDrag::None),
       m_drag_grab(0),
       m_drag_scroll(0),
@@ -54,6 +56,7 @@ Editor::Editor(GlobalRegistry<CursorContext> &commandController, Theme &theme, Q
     // Register cvars
     registerTabToSpaceCVar();
     registerShowScrollbarCVar();
+    registerShowSearchMatchesCVar();
 }
 
 void Editor::render(CursorContext &context, ViewState &viewState, QuadBuffer &quadBuffer, const float dt) {
@@ -116,21 +119,31 @@ bool Editor::onKeyDown(CursorContext &context, ViewState &viewState, const SDL_K
     switch (keyCode) {
         case SDLK_RETURN: {
             context.scroll.follow_indicator = true;
+            if (context.cursor.getCaretCount() > 1) {
+                notifyCaretEdit(context, context.cursor.insertAtCarets(u"\n"));
+                return true;
+            }
+
             // Any new inputs deactivate the selection and cut the previously selected text before inserting the new input
             context.eraseSelectionIfAny();
 
             const auto &edit = context.cursor.newLine();
-            context.highlighter.edit(edit);
+            context.notifyEdit(edit);
             // Update stick to column index if we insert
             context.stick.index = context.cursor.getColumn();
         }
         return true;
         case SDLK_BACKSPACE: {
             context.scroll.follow_indicator = true;
+            if (context.cursor.getCaretCount() > 1) {
+                notifyCaretEdit(context, context.cursor.eraseAtCarets(false));
+                return true;
+            }
+
             // Any new inputs deactivate the selection and cut the previously selected text before inserting the new input
             if (!context.eraseSelectionIfAny()) {
                 if (const auto &edit = context.cursor.eraseLeft()) {
-                    context.highlighter.edit(edit.value());
+                    context.notifyEdit(edit.value());
                 }
             }
             // Do not update stick to column index if we remove
@@ -138,10 +151,15 @@ bool Editor::onKeyDown(CursorContext &context, ViewState &viewState, const SDL_K
         return true;
         case SDLK_DELETE: {
             context.scroll.follow_indicator = true;
+            if (context.cursor.getCaretCount() > 1) {
+                notifyCaretEdit(context, context.cursor.eraseAtCarets(true));
+                return true;
+            }
+
             // Any new inputs deactivate the selection and cut the previously selected text before inserting the new input
             if (!context.eraseSelectionIfAny()) {
                 if (const auto &edit = context.cursor.eraseRight()) {
-                    context.highlighter.edit(edit.value());
+                    context.notifyEdit(edit.value());
                 }
             }
             // Update stick to column index
@@ -150,6 +168,14 @@ bool Editor::onKeyDown(CursorContext &context, ViewState &viewState, const SDL_K
         return true;
         case SDLK_TAB: {
             context.scroll.follow_indicator = true;
+            if (context.cursor.getCaretCount() > 1) {
+                // Every caret gets the same text: a full tab width of spaces rather than the
+                // padding to a tab stop, which differs from caret to caret
+                const auto tab_width = static_cast<std::size_t>(std::max(m_theme.getDimension(DimensionId::TabToSpace), 1));
+                notifyCaretEdit(context, context.cursor.insertAtCarets(m_is_tab_to_space->m_value ? std::u16string(tab_width, u' ') : u"\t"));
+                return true;
+            }
+
             // Any new inputs deactivate the selection and cut the previously selected text before inserting the new input
             context.eraseSelectionIfAny();
 
@@ -169,10 +195,10 @@ bool Editor::onKeyDown(CursorContext &context, ViewState &viewState, const SDL_K
 
                 const uint32_t space_amount = tab_width - visual_column % tab_width;
                 const auto &edit = context.cursor.insert(std::u16string(space_amount, u' '));
-                context.highlighter.edit(edit);
+                context.notifyEdit(edit);
             } else {
                 const auto &edit = context.cursor.insert(u"\t");
-                context.highlighter.edit(edit);
+                context.notifyEdit(edit);
             }
             // Update stick to column index
             context.stick.index = context.cursor.getColumn();
@@ -194,14 +220,26 @@ void Editor::onTextInput(CursorContext &context, ViewState &viewState, const cha
         utf8_text = utf8::replace_invalid(utf8_text);
     }
 
+    const auto utf16_text = utf8::utf8to16(utf8_text);
+    context.scroll.follow_indicator = true;
+    if (context.cursor.getCaretCount() > 1) {
+        notifyCaretEdit(context, context.cursor.insertAtCarets(utf16_text));
+        return;
+    }
+
     // Any new inputs deactivate the selection and cut the previously selected text before inserting the new input
     context.eraseSelectionIfAny();
 
-    const auto utf16_text = utf8::utf8to16(utf8_text);
     const auto &edit = context.cursor.insert(utf16_text);
     context.stick.index = context.cursor.getColumn();
-    context.scroll.follow_indicator = true;
-    context.highlighter.edit(edit);
+    context.notifyEdit(edit);
+}
+
+void Editor::notifyCaretEdit(CursorContext &context, const std::optional<BufferEdit> &edit) {
+    if (edit) {
+        context.notifyEdit(*edit);
+    }
+    context.stick.index = context.cursor.getColumn();
 }
 
 void Editor::updateScroll(CursorContext &context, const ViewState &viewState, const int32_t marginWidth, const int32_t vBarWidth, const int32_t hBarHeight, const uint32_t longestLineLength) const {
@@ -366,6 +404,7 @@ void Editor::drawText(QuadBuffer &quadBuffer, const CursorContext &context, cons
     const auto cursor_line_count = context.cursor.getLineCount();
 
     const auto cursor_text_start_x = position_x + marginWidth + border_size;
+    const auto show_search_matches = m_show_search_matches->m_value && context.search.index.hasTerm();
 
     // Draw text. The scroll offset within the first line is bounded by the line height, so it is
     // the one place the 64-bit vertical scroll re-enters the 32-bit screen space.
@@ -392,28 +431,50 @@ void Editor::drawText(QuadBuffer &quadBuffer, const CursorContext &context, cons
                 drawQuad(quadBuffer, cursor_text_start_x, pen_position_y - line_height - font_descender, width, line_height, line_background_color);
             }
 
+            if (show_search_matches) {
+                // The matches of the search term, from the rows scanned for the lines in view. A
+                // tab-free line measures in O(1), so the ones scrolled out on the left are skipped
+                // by column before measuring any
+                const auto ranges = context.search.ranges.getRanges(context.cursor, context.search.index, line);
+                const auto hidden_columns = context.cursor.getLineTabCount(line) == 0 ? std::max<int64_t>(scrollX - marginWidth - border_size, 0) / font_advance : 0;
+                const auto first_range = std::ranges::lower_bound(ranges, hidden_columns, {}, [](const MatchRangeCache::Range &range) { return static_cast<int64_t>(range.column) + range.length; });
+                const auto &match_background_color = m_theme.getColor(ColorId::MatchBackground);
+                for (auto range = first_range; range != ranges.end(); ++range) {
+                    const auto match_start_x = measureLineText(context, line, string.substr(0, range->column));
+                    if (match_start_x - scrollX > width) {
+                        break;
+                    }
+                    if (range->length == 0) {
+                        // An empty pattern match has nothing to cover
+                        continue;
+                    }
+                    const auto match_width = measureLineText(context, line, string.substr(0, range->column + range->length)) - match_start_x;
+                    drawQuad(quadBuffer, projectToViewport(cursor_text_start_x - scrollX + match_start_x), pen_position_y - line_height - font_descender, projectToViewport(match_width), line_height, match_background_color);
+                }
+            }
+
+            const auto line_top = pen_position_y - line_height - font_descender;
             if (const auto &selected_range = context.cursor.getSelectedRange()) {
-                // Check if the selected range is in the viewport
-                const auto &selected_background_color = m_theme.getColor(ColorId::SelectedTextBackground);
-                if (selected_range->line_start == line && selected_range->line_end == line) {
-                    // The selection start / end on the same line. Select only a range of text.
-                    // Both bounds are measured as line prefixes: a mid-line slice has no tab-stop
-                    // origin of its own, so the width is the difference of the two prefixes.
-                    const auto selection_start_x = measureLineText(context, line, string.substr(0, selected_range->column_start));
-                    const auto selected_text_width = measureLineText(context, line, string.substr(0, selected_range->column_end)) - selection_start_x;
-                    drawQuad(quadBuffer, projectToViewport(cursor_text_start_x - scrollX + selection_start_x), pen_position_y - line_height - font_descender, projectToViewport(selected_text_width), line_height, selected_background_color);
-                } else if (line == selected_range->line_start) {
-                    // First line of selected text, the selection starts at column until the end of the text area.
-                    const auto selection_start_x = measureLineText(context, line, string.substr(0, selected_range->column_start));
-                    drawQuad(quadBuffer, projectToViewport(cursor_text_start_x - scrollX + selection_start_x), pen_position_y - line_height - font_descender, projectToViewport(width - selection_start_x), line_height, selected_background_color);
-                } else if (line == selected_range->line_end) {
-                    // Last line of selected text, the selection starts at the margin border, until the end column.
-                    const auto selected_text = string.substr(0, selected_range->column_end);
-                    const auto selected_text_width = measureLineText(context, line, selected_text);
-                    drawQuad(quadBuffer, projectToViewport(cursor_text_start_x - scrollX), pen_position_y - line_height - font_descender, projectToViewport(selected_text_width), line_height, selected_background_color);
-                } else if (line > selected_range->line_start && line < selected_range->line_end) {
-                    // In between two selected lines, the selection takes the whole width
-                    drawQuad(quadBuffer, cursor_text_start_x, pen_position_y - line_height - font_descender, width, line_height, selected_background_color);
+                drawSelectedRange(quadBuffer, context, line, *selected_range, cursor_text_start_x, scrollX, line_top, width);
+            }
+
+            // The extra carets around this line: sorted and apart, their selections end in the same
+            // order they start, so the ones ending before the line are skipped in one search
+            const auto &carets = context.cursor.getCarets();
+            const auto first_caret = std::ranges::lower_bound(carets, line, {}, [](const Cursor::Caret &caret) {
+                return std::max(caret.position.line, caret.anchor.line);
+            });
+            for (auto caret = first_caret; caret != carets.end() && std::min(caret->position.line, caret->anchor.line) <= line; ++caret) {
+                const auto &[start, end] = std::minmax(caret->anchor, caret->position, [](const auto &a, const auto &b) {
+                    return std::tie(a.line, a.column) < std::tie(b.line, b.column);
+                });
+                if (start.line != end.line || start.column != end.column) {
+                    const auto range = TextRange{.line_start = start.line, .column_start = start.column, .line_end = end.line, .column_end = end.column};
+                    drawSelectedRange(quadBuffer, context, line, range, cursor_text_start_x, scrollX, line_top, width);
+                }
+                if (caret->position.line == line) {
+                    const auto caret_x = measureLineText(context, line, string.substr(0, caret->position.column));
+                    drawQuad(quadBuffer, projectToViewport(cursor_text_start_x - scrollX + caret_x), line_top, indicator_width, line_height, m_theme.getColor(ColorId::CursorIndicator));
                 }
             }
 
@@ -495,6 +556,32 @@ void Editor::drawText(QuadBuffer &quadBuffer, const CursorContext &context, cons
     }
 }
 
+void Editor::drawSelectedRange(QuadBuffer &quadBuffer, const CursorContext &context, const uint32_t line, const TextRange &range, const int32_t textStartX, const int64_t scrollX, const int32_t lineTop, const int32_t width) const {
+    const auto line_height = m_theme.getLineHeight();
+    const auto &selected_background_color = m_theme.getColor(ColorId::SelectedTextBackground);
+    const auto string = context.cursor.getString(line);
+    if (range.line_start == line && range.line_end == line) {
+        // The selection start / end on the same line. Select only a range of text.
+        // Both bounds are measured as line prefixes: a mid-line slice has no tab-stop
+        // origin of its own, so the width is the difference of the two prefixes.
+        const auto selection_start_x = measureLineText(context, line, string.substr(0, range.column_start));
+        const auto selected_text_width = measureLineText(context, line, string.substr(0, range.column_end)) - selection_start_x;
+        drawQuad(quadBuffer, projectToViewport(textStartX - scrollX + selection_start_x), lineTop, projectToViewport(selected_text_width), line_height, selected_background_color);
+    } else if (line == range.line_start) {
+        // First line of selected text, the selection starts at column until the end of the text area.
+        const auto selection_start_x = measureLineText(context, line, string.substr(0, range.column_start));
+        drawQuad(quadBuffer, projectToViewport(textStartX - scrollX + selection_start_x), lineTop, projectToViewport(width - selection_start_x), line_height, selected_background_color);
+    } else if (line == range.line_end) {
+        // Last line of selected text, the selection starts at the margin border, until the end column.
+        const auto selected_text = string.substr(0, range.column_end);
+        const auto selected_text_width = measureLineText(context, line, selected_text);
+        drawQuad(quadBuffer, projectToViewport(textStartX - scrollX), lineTop, projectToViewport(selected_text_width), line_height, selected_background_color);
+    } else if (line > range.line_start && line < range.line_end) {
+        // In between two selected lines, the selection takes the whole width
+        drawQuad(quadBuffer, textStartX, lineTop, width, line_height, selected_background_color);
+    }
+}
+
 void Editor::computeScrollbarSizes(const CursorContext &context, const ViewState &viewState, const int32_t marginWidth, const uint32_t longestLineLength, int32_t &vBarWidth, int32_t &hBarHeight) const {
     vBarWidth = 0;
     hBarHeight = 0;
@@ -820,3 +907,7 @@ void Editor::registerTabToSpaceCVar() const {
 void Editor::registerShowScrollbarCVar() const {
     m_command_controller.registerCvar(u"show_scrollbar", m_show_scrollbar, nullptr);
 }
+
+void Editor::registerShowSearchMatchesCVar() const {
+    m_command_controller.registerCvar(u"show_search_matches", m_show_search_matches, nullptr);
+}
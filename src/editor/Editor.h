@@ -82,6 +82,9 @@ private:
     /** CVar for toggling the editor scrollbars visibility. */
     std::shared_ptr<CVarBool> m_show_scrollbar;
 
+    /** CVar for toggling the highlight of the search matches in view. */
+    std::shared_ptr<CVarBool> m_show_search_matches;
+
     /** Mouse drag interaction currently in progress, None outside a left-button press. */
     MouseDrag m_mouse_drag;
 
@@ -104,6 +107,9 @@ private:
     /** @brief Registers the show_scrollbar cvar into the command manager. */
     void registerShowScrollbarCVar() const;
 
+    /** @brief Registers the show_search_matches cvar into the command manager. */
+    void registerShowSearchMatchesCVar() const;
+
     /**
      * @brief Measures the whole buffer content height, in content-space pixels.
      *
@@ -282,6 +288,29 @@ private:
      */
     void drawText(QuadBuffer &quadBuffer, const CursorContext &context, const ViewState &viewState, int64_t scrollX, int64_t scrollY, int32_t marginWidth) const;
 
+    /**
+     * @brief Draws the part of a selected range lying on one line.
+     *
+     * Shared by the main selection and the selections of the extra carets.
+     *
+     * @param quadBuffer A reference to the quad buffer receiving the quads.
+     * @param context A reference to the cursor context.
+     * @param line The line being drawn.
+     * @param range The selected range, start before end.
+     * @param textStartX The x coordinate where the text area starts.
+     * @param scrollX The editor x scroll offset.
+     * @param lineTop The y coordinate of the top of the line.
+     * @param width The width of the view.
+     */
+    void drawSelectedRange(QuadBuffer &quadBuffer, const CursorContext &context, uint32_t line, const TextRange &range, int32_t textStartX, int64_t scrollX, int32_t lineTop, int32_t width) const;
+
+    /**
+     * @brief Relays an edit made at every caret, if any, and sticks to the column of the main caret.
+     * @param context A reference to the cursor context.
+     * @param edit The edit, as returned by the Cursor.
+     */
+    static void notifyCaretEdit(CursorContext &context, const std::optional<BufferEdit> &edit);
+
 public:
     /**
      * @brief Constructs the Editor view.
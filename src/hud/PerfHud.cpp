@@ -0,0 +1,116 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "PerfHud.h"
+
+#include <algorithm>
+#include <format>
+
+#include <utf8.h>
+
+#include "../core/theme/ColorId.h"
+#include "../core/theme/DimensionId.h"
+
+
+PerfHud::PerfHud(GlobalRegistry<CursorContext> &commandController, Theme &theme, QuadProgram &quadProgram)
+    : View(commandController, theme, quadProgram) {}
+
+std::array<std::u16string, PerfHud::LINE_COUNT> PerfHud::formatLines(const PerfHudState::FrameStats &stats) {
+    // Undo memory is shown in KiB: a typed session sits in the low hundreds, a paste in the thousands
+    const auto undo_kib = static_cast<double>(stats.undo_characters * sizeof(char16_t)) / 1024.0;
+    const auto cache_end_line = stats.cache_start_line + stats.cache_line_count;
+    return {
+        utf8::utf8to16(std::format("quads {} draws {}", stats.quad_count, stats.draw_count)),
+        utf8::utf8to16(std::format("frame {:.2f} ms parse {:.2f} ms", stats.frame_time * 1000.0f, stats.parse_time * 1000.0f)),
+        utf8::utf8to16(std::format("hl cache {}-{} miss {}", stats.cache_start_line + 1, cache_end_line, stats.cache_miss_count)),
+        utf8::utf8to16(std::format("atlas layer {}/{}", stats.atlas_layer + 1, stats.atlas_layer_count)),
+        utf8::utf8to16(std::format("undo {:.1f} KiB", undo_kib))
+    };
+}
+
+void PerfHud::render(CursorContext &context, PerfHudState &viewState, QuadBuffer &quadBuffer, const float dt) {
+    (void) context;
+    (void) dt;
+    const auto lines = formatLines(viewState.getStats());
+
+    // Need some variables
+    const auto &background_color = m_theme.getColor(ColorId::InfoBarBackground);
+    const auto &border_color = m_theme.getColor(ColorId::Border);
+    const auto &text_color = m_theme.getColor(ColorId::InfoBarText);
+    const auto border_size = m_theme.getDimension(DimensionId::BorderSize);
+    const auto padding_width = m_theme.getDimension(DimensionId::PaddingWidth);
+    const auto line_height = m_theme.getLineHeight();
+    const auto font_descender = m_theme.getFontDescender();
+    const auto font_advance = m_theme.getFontAdvance();
+
+    // The box is as wide as the longest line; the lines are short ASCII strings, a plain advance multiply measures them
+    auto longest_line = std::size_t{0};
+    for (const auto &line : lines) {
+        longest_line = std::max(longest_line, line.length());
+    }
+
+    const auto box_width = std::min(static_cast<int32_t>(longest_line) * font_advance + padding_width * 2 + border_size, viewState.getWidth());
+    const auto box_height = std::min(static_cast<int32_t>(LINE_COUNT) * line_height + border_size, viewState.getHeight());
+    const auto box_x = viewState.getPositionX() + viewState.getWidth() - box_width;
+    const auto box_y = viewState.getPositionY();
+    if (box_width <= 0 || box_height <= 0) {
+        // The editor area collapsed, there is nowhere to draw the box
+        return;
+    }
+
+    const auto batch_start = quadBuffer.beginBatch(DEFAULT_QUAD_COUNT);
+
+    // Border on the left and bottom edges, the two sides facing the text
+    drawQuad(quadBuffer, box_x, box_y, box_width, box_height, border_color);
+    drawQuad(quadBuffer, box_x + border_size, box_y, box_width - border_size, box_height - border_size, background_color);
+
+    auto pen_position_y = box_y + line_height + font_descender;
+    for (const auto &line : lines) {
+        auto pen_position_x = box_x + border_size + padding_width;
+        for (const auto c : line) {
+            if (c != u' ') {
+                const auto &character = m_theme.getCharacter(c);
+                drawCharacter(quadBuffer, pen_position_x, pen_position_y, character, text_color);
+            }
+            pen_position_x += font_advance;
+        }
+        pen_position_y += line_height;
+    }
+
+    const auto batch_count = quadBuffer.endBatch();
+
+    // Set the scissor area to the box and draw the buffer
+    glScissor(box_x, m_window_height - box_y - box_height, box_width, box_height);
+    m_quad_program.draw(batch_start, batch_count);
+}
+
+bool PerfHud::onKeyDown(CursorContext &context, PerfHudState &viewState, const SDL_Keycode keyCode, const uint16_t keyModifier) const {
+    // No-op
+    (void) context;
+    (void) viewState;
+    (void) keyCode;
+    (void) keyModifier;
+    return false;
+}
+
+void PerfHud::onTextInput(CursorContext &context, PerfHudState &viewState, const char *text) const {
+    // No-op
+    (void) context;
+    (void) viewState;
+    (void) text;
+}
@@ -0,0 +1,89 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include <array>
+#include <string>
+
+#include "../core/base/GlobalRegistry.h"
+#include "../core/renderer/QuadProgram.h"
+#include "../core/renderer/QuadBuffer.h"
+#include "../core/theme/Theme.h"
+#include "../core/View.h"
+#include "../core/CursorContext.h"
+#include "PerfHudState.h"
+
+
+/**
+ * @brief Overlay view displaying the measurements of the previous views of the frame.
+ *
+ * Drawn last, over the top right corner of the editor area, while the show_perf_hud CVar is
+ * set. It costs one batch and one draw call of its own, and reads a snapshot taken before it
+ * started: the numbers it shows never include itself.
+ */
+class PerfHud final : public View<PerfHudState> {
+private:
+    /** Number of text lines the HUD displays. */
+    static constexpr std::size_t LINE_COUNT = 5;
+
+    /** @brief Quads reserved in the staging vector when this view begins its batch; advisory only. */
+    static constexpr uint32_t DEFAULT_QUAD_COUNT = 256;
+
+    /**
+     * @brief Formats the snapshot into the lines displayed by the HUD.
+     *
+     * @param stats The snapshot to format.
+     * @return One string per HUD line.
+     */
+    [[nodiscard]] static std::array<std::u16string, LINE_COUNT> formatLines(const PerfHudState::FrameStats &stats);
+
+public:
+    /**
+     * @brief Constructs the PerfHud view.
+     *
+     * @param commandController Reference to the command controller.
+     * @param theme Reference to the Theme (fonts, colors, etc.).
+     * @param quadProgram Reference to the quad shader program.
+     */
+    explicit PerfHud(GlobalRegistry<CursorContext> &commandController, Theme &theme, QuadProgram &quadProgram);
+
+    /**
+     * @brief Renders the HUD box in the top right corner of the view rectangle.
+     *
+     * @param context Reference to the cursor context.
+     * @param viewState The PerfHudState holding the snapshot to display.
+     * @param quadBuffer Reference to the quad buffer used to build this frame's geometry.
+     * @param dt Time delta since the last frame.
+     */
+    void render(CursorContext &context, PerfHudState &viewState, QuadBuffer &quadBuffer, float dt) override;
+
+    /**
+     * @brief PerfHud does not handle key input.
+     *
+     * @return Always returns false.
+     */
+    bool onKeyDown(CursorContext &context, PerfHudState &viewState, SDL_Keycode keyCode, uint16_t keyModifier) const override;
+
+    /** @brief PerfHud does not handle text input. */
+    void onTextInput(CursorContext &context, PerfHudState &viewState, const char* text) const override;
+};
+
+
+#endif //PERF_HUD_H
@@ -0,0 +1,78 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PERF_HUD_STATE_H
+#define PERF_HUD_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../core/ViewState.h"
+
+
+/**
+ * @brief Stores the frame measurements the performance HUD displays.
+ *
+ * The application loop fills a new snapshot once the four regular views have rendered and
+ * before the HUD renders itself, so the numbers never account for the HUD's own quads, draw
+ * call or time. The view rectangle is the editor area; the HUD anchors its box in its top
+ * right corner.
+ */
+class PerfHudState final : public ViewState {
+public:
+    /** @brief The measurements of one frame, taken before the HUD drew anything. */
+    struct FrameStats final {
+        uint32_t quad_count = 0;          ///< Quads committed to the quad buffer by the regular views.
+        uint32_t draw_count = 0;          ///< Draw calls issued by the regular views.
+        float frame_time = 0.0f;          ///< Time spent building and submitting the frame, in seconds.
+        float parse_time = 0.0f;          ///< Time spent in the highlighter parse of this frame, in seconds.
+        uint32_t cache_start_line = 0;    ///< First line of the highlight cache window.
+        uint32_t cache_line_count = 0;    ///< Lines covered by the highlight cache window.
+        uint32_t cache_miss_count = 0;    ///< Highlight cache window rebuilds during this frame.
+        uint8_t atlas_layer = 0;          ///< Atlas layer receiving the next glyph.
+        uint8_t atlas_layer_count = 0;    ///< Atlas layers available.
+        std::size_t undo_characters = 0;  ///< Characters retained by the undo and redo stacks.
+    };
+
+private:
+    /** The last snapshot handed over by the application loop. */
+    FrameStats m_stats;
+
+public:
+    /** @brief Deleted copy constructor. */
+    PerfHudState(const PerfHudState &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    PerfHudState &operator=(const PerfHudState &) = delete;
+
+    /** @brief Constructs the state with an empty snapshot. */
+    explicit PerfHudState();
+
+    /**
+     * @brief Replaces the displayed snapshot.
+     *
+     * @param stats The measurements of the frame being rendered.
+     */
+    void setStats(const FrameStats &stats);
+
+    /** @return The snapshot to display. */
+    [[nodiscard]] const FrameStats &getStats() const;
+};
+
+
+#endif //PERF_HUD_STATE_H
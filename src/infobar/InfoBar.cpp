@@ -20,16 +20,23 @@
 
 #include <algorithm>
 #include <format>
+#include <limits>
 
 #include <utf8.h>
 
+#include "../core/base/ByteSize.h"
 #include "../core/theme/ColorId.h"
 #include "../core/theme/DimensionId.h"
 #include "../core/theme/TabStop.h"
 
 
 InfoBar::InfoBar(GlobalRegistry<CursorContext> &commandController, Theme &theme, QuadProgram &quadProgram)
-    : View(commandController, theme, quadProgram) {}
+    : View(commandController, theme, quadProgram),
+      m_buffer_memory(std::make_shared<CVarInt>(0, true)),
+      m_show_buffer_memory(std::make_shared<CVarBool>(false)) {
+    // Register cvars
+    registerBufferMemoryCVars();
+}
 
 void InfoBar::render(CursorContext &context, ViewState &viewState, QuadBuffer &quadBuffer, const float dt) {
     (void) dt;
@@ -110,7 +117,15 @@ void InfoBar::drawText(QuadBuffer &quadBuffer, const CursorContext &context, con
         // Several buffers are open: show the position of this one among them
         string_cursor_name.append(utf8::utf8to16(std::format(" [{}/{}]", context.buffer_index, context.buffer_count)));
     }
-    const auto string_info = utf8::utf8to16(std::format("{} • {} • {}:{} / {}", font_size, highlight_mode, cursor_line + 1, cursor_column + 1, cursor_line_count));
+    auto string_info = utf8::utf8to16(std::format("{} • {} • {}:{} / {}", font_size, highlight_mode, cursor_line + 1, cursor_column + 1, cursor_line_count));
+
+    // Publish the memory held by the displayed buffer, so it can be read back even when not shown.
+    // KiB keeps multi-gigabyte buffers within the int CVar.
+    const auto buffer_memory = context.getMemoryUsage().total();
+    m_buffer_memory->m_value = static_cast<int32_t>(std::min<std::size_t>(buffer_memory / 1024, std::numeric_limits<int32_t>::max()));
+    if (m_show_buffer_memory->m_value) {
+        string_info.insert(0, utf8::utf8to16(std::format("{} • ", formatByteSize(buffer_memory))));
+    }
     // The measure lives in 64-bit content space; a one-line info string always fits the screen
     const auto string_info_size = static_cast<int32_t>(m_theme.measure(string_info));
     const auto left_text_offset = padding_width;
@@ -150,3 +165,8 @@ void InfoBar::drawText(QuadBuffer &quadBuffer, const CursorContext &context, con
         }
     }
 }
+
+void InfoBar::registerBufferMemoryCVars() const {
+    m_command_controller.registerCvar(u"inf_buffer_memory", m_buffer_memory, nullptr);
+    m_command_controller.registerCvar(u"show_buffer_memory", m_show_buffer_memory, nullptr);
+}
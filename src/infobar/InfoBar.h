@@ -20,7 +20,11 @@
 #define INFO_BAR_H
 
 
+#include <memory>
+
 #include "../core/base/GlobalRegistry.h"
+#include "../core/cvar/CVarBool.h"
+#include "../core/cvar/CVarInt.h"
 #include "../core/renderer/QuadProgram.h"
 #include "../core/renderer/QuadBuffer.h"
 #include "../core/theme/Theme.h"
@@ -43,6 +47,15 @@ private:
     /** @brief Quads reserved in the staging vector when this view begins its batch; advisory only. */
     static constexpr uint32_t DEFAULT_QUAD_COUNT = 1024;
 
+    /** CVar publishing the memory held by the displayed buffer, in KiB; refreshed on every render. */
+    std::shared_ptr<CVarInt> m_buffer_memory;
+
+    /** CVar controlling whether the memory held by the displayed buffer is shown. */
+    std::shared_ptr<CVarBool> m_show_buffer_memory;
+
+    /** @brief Registers the inf_buffer_memory and show_buffer_memory cvars into the command manager. */
+    void registerBufferMemoryCVars() const;
+
     /**
      * @brief: Draw the background layer of the info bar.
      *
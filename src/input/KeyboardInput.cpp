@@ -21,41 +21,71 @@
 #include "../core/FocusTarget.h"
 
 
-KeyboardInput::KeyboardInput(CommandRunner &commandRunner, CursorContextManager &contextManager, Editor &editor, ViewState &editorState, Prompt &prompt, PromptState &promptState)
+KeyboardInput::KeyboardInput(CommandRunner &commandRunner, CursorContextManager &contextManager, Editor &editor, ViewState &editorState, Prompt &prompt, PromptState &promptState, MacroRecorder &macroRecorder)
     : m_command_runner(commandRunner),
       m_context_manager(contextManager),
       m_editor(editor),
       m_editor_state(editorState),
       m_prompt(prompt),
-      m_prompt_state(promptState) {}
+      m_prompt_state(promptState),
+      m_macro_recorder(macroRecorder) {}
+
+bool KeyboardInput::dispatchKey(const SDL_Keycode keycode, const uint16_t modifiers) {
+    // The prompt dispatches a command on Return, which can switch the active context
+    // or close (and destroy) this one: re-read active() before touching it afterwards.
+    auto &context = m_context_manager.active();
+    switch (context.focus_target) {
+        case FocusTarget::Editor:
+            if (m_editor.onKeyDown(context, m_editor_state, keycode, modifiers)) {
+                // If the view return true, the text changed: redraw the views
+                context.search.resetMatches();
+                context.wants_redraw = true;
+                m_macro_recorder.recordKey(keycode, modifiers);
+                return true;
+            }
+        break;
+        case FocusTarget::Prompt: {
+            // Only the prompt's answer to a question reaches the editor: cancelling that question
+            // is a step of a macro, the typing around it is not (the confirmed line is)
+            const auto cancels_feedback = keycode == SDLK_ESCAPE && context.command_feedback.has_value();
+            if (m_prompt.onKeyDown(context, m_prompt_state, keycode, modifiers)) {
+                // If the view return true, then redraw the views.
+                // `context` may be gone by now (the prompt ran "buffer close"): flag the new active one.
+                m_context_manager.active().wants_redraw = true;
+                if (cancels_feedback) {
+                    m_macro_recorder.recordKey(keycode, modifiers);
+                }
+                return true;
+            }
+        }
+        break;
+    }
+
+    return false;
+}
+
+void KeyboardInput::dispatchText(const char *text) {
+    // Redirect to input focus. We always redraw new characters.
+    auto &context = m_context_manager.active();
+    context.wants_redraw = true;
+    switch (context.focus_target) {
+        case FocusTarget::Editor:
+            m_editor.onTextInput(context, m_editor_state, text);
+            context.search.resetMatches();
+            m_macro_recorder.recordText(text);
+            break;
+        case FocusTarget::Prompt:
+            m_prompt.onTextInput(context, m_prompt_state, text);
+            break;
+    }
+}
 
 void KeyboardInput::onKeyDown(const SDL_KeyboardEvent &event) {
     // Chords are shortcuts, never editing keys: skip the focused view and go straight
     // to the bindings (same rationale as the onTextInput chord rule below)
     const auto is_chord = event.keysym.mod & (KMOD_CTRL | KMOD_LALT);
-
-    if (!is_chord) {
-        // The prompt dispatches a command on Return, which can switch the active context
-        // or close (and destroy) this one: re-read active() before touching it afterwards.
-        auto &context = m_context_manager.active();
-        switch (context.focus_target) {
-            case FocusTarget::Editor:
-                if (m_editor.onKeyDown(context, m_editor_state, event.keysym.sym, event.keysym.mod)) {
-                    // If the view return true, the text changed: redraw the views
-                    context.search.resetMatches();
-                    context.wants_redraw = true;
-                    return;
-                }
-            break;
-            case FocusTarget::Prompt:
-                if (m_prompt.onKeyDown(context, m_prompt_state, event.keysym.sym, event.keysym.mod)) {
-                    // If the view return true, then redraw the views.
-                    // `context` may be gone by now (the prompt ran "buffer close"): flag the new active one.
-                    m_context_manager.active().wants_redraw = true;
-                    return;
-                }
-            break;
-        }
+    if (!is_chord && dispatchKey(event.keysym.sym, event.keysym.mod)) {
+        return;
     }
 
     // Not consumed by the focused view: fall back to the key bindings
@@ -69,16 +99,13 @@ void KeyboardInput::onTextInput(const SDL_TextInputEvent &event) {
         return;
     }
 
-    // Redirect to input focus. We always redraw new characters.
-    auto &context = m_context_manager.active();
-    context.wants_redraw = true;
-    switch (context.focus_target) {
-        case FocusTarget::Editor:
-            m_editor.onTextInput(context, m_editor_state, event.text);
-            context.search.resetMatches();
-            break;
-        case FocusTarget::Prompt:
-            m_prompt.onTextInput(context, m_prompt_state, event.text);
-            break;
-    }
+    dispatchText(event.text);
+}
+
+void KeyboardInput::playKey(const SDL_Keycode keycode, const uint16_t modifiers) {
+    (void) dispatchKey(keycode, modifiers);
+}
+
+void KeyboardInput::playText(const char *text) {
+    dispatchText(text);
 }
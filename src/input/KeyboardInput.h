@@ -24,6 +24,7 @@
 #include "../core/base/AutoCompleteCallback.h"
 #include "../core/base/CommandRunner.h"
 #include "../core/CursorContextManager.h"
+#include "../core/MacroRecorder.h"
 #include "../core/ViewState.h"
 #include "../editor/Editor.h"
 #include "../prompt/Prompt.h"
@@ -35,6 +36,9 @@
  * Key presses go to the focused view first (unless the modifiers form a shortcut chord),
  * then fall back to the key bindings, run through CommandRunner::runBoundCommand.
  * Text input is routed to the focused view, with chords blocked.
+ *
+ * What reaches the editor is handed to the MacroRecorder on the way, and a playing macro sends its
+ * keys and text back through playKey() and playText(), which skip the bindings and the chord rule.
  */
 class KeyboardInput final {
 private:
@@ -56,6 +60,25 @@ private:
     /** State object tracking the prompt. */
     PromptState &m_prompt_state;
 
+    /** The macro recorder, fed the keys and text the editor consumes. */
+    MacroRecorder &m_macro_recorder;
+
+    /**
+     * @brief Hands a key to the focused view.
+     *
+     * @param keycode The key.
+     * @param modifiers The active key modifiers.
+     * @return true when the view consumed the key.
+     */
+    bool dispatchKey(SDL_Keycode keycode, uint16_t modifiers);
+
+    /**
+     * @brief Hands text to the focused view.
+     *
+     * @param text The text, UTF-8.
+     */
+    void dispatchText(const char *text);
+
 public:
     /** @brief Deleted copy constructor. */
     KeyboardInput(const KeyboardInput &) = delete;
@@ -72,8 +95,9 @@ public:
      * @param editorState State of the editor view.
      * @param prompt The prompt view.
      * @param promptState State of the prompt view.
+     * @param macroRecorder The macro recorder.
      */
-    explicit KeyboardInput(CommandRunner &commandRunner, CursorContextManager &contextManager, Editor &editor, ViewState &editorState, Prompt &prompt, PromptState &promptState);
+    explicit KeyboardInput(CommandRunner &commandRunner, CursorContextManager &contextManager, Editor &editor, ViewState &editorState, Prompt &prompt, PromptState &promptState, MacroRecorder &macroRecorder);
 
     /**
      * @brief Handles an SDL_KEYDOWN event.
@@ -94,6 +118,21 @@ public:
      * @param event The text input event.
      */
     void onTextInput(const SDL_TextInputEvent &event);
+
+    /**
+     * @brief Replays a key recorded by a macro: the focused view gets it, the bindings never do.
+     *
+     * @param keycode The key.
+     * @param modifiers The key modifiers recorded with it.
+     */
+    void playKey(SDL_Keycode keycode, uint16_t modifiers);
+
+    /**
+     * @brief Replays text recorded by a macro, whatever modifiers are held meanwhile.
+     *
+     * @param text The text, UTF-8.
+     */
+    void playText(const char *text);
 };
 
 
@@ -0,0 +1,116 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CHILD_PROCESS_H
+#define CHILD_PROCESS_H
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+
+/**
+ * @brief A shell command running as a child process, its standard streams piped to the editor.
+ *
+ * Part of the platform seam: ChildProcessDesktop.cpp runs the command with `/bin/sh -c` in a
+ * process group of its own, so kill reaches the whole pipeline; ChildProcessSwitch.cpp never starts
+ * one, as the console runs no other program. The input, the output and the error streams are meant
+ * to be served by one thread each: a write blocks until the child reads, a read until it writes.
+ * kill and wait may be called from any thread. Neither copyable nor movable.
+ */
+class ChildProcess final {
+private:
+    /** Process id of the child, also the id of its process group; -1 when it could not start. */
+    int m_pid;
+
+    /** Write end of the child's standard input, -1 once closed. */
+    int m_input;
+
+    /** Read end of the child's standard output, -1 once closed. */
+    int m_output;
+
+    /** Read end of the child's standard error, -1 once closed. */
+    int m_error;
+
+    /** Guards m_reaped, so kill never signals a process id the system may have handed out again. */
+    std::mutex m_mutex;
+
+    /** true once the child exited and was reaped. */
+    bool m_reaped;
+
+    /** Exit code of the child once reaped; -1 when a signal ended it. */
+    int m_exit_code;
+
+public:
+    /** @brief Deleted copy constructor. */
+    ChildProcess(const ChildProcess &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    ChildProcess &operator=(const ChildProcess &) = delete;
+
+    /**
+     * @brief Starts a shell command.
+     * @param command The command line, as typed in a shell. UTF-8.
+     */
+    explicit ChildProcess(const std::string &command);
+
+    /** @brief Kills the child if it still runs, reaps it and closes the pipes. */
+    ~ChildProcess();
+
+    /** @return true when the child could be started. */
+    [[nodiscard]] bool isStarted() const;
+
+    /**
+     * @brief Writes bytes to the child's standard input, blocking until they all went through.
+     * @param bytes The bytes to write.
+     * @return false when the child closed its input or exited.
+     */
+    bool writeInput(std::string_view bytes);
+
+    /** @brief Closes the child's standard input, which reads as the end of it. No-op once closed. */
+    void closeInput();
+
+    /**
+     * @brief Reads from the child's standard output, blocking until something comes.
+     * @param buffer The buffer to fill.
+     * @param size The size of the buffer.
+     * @return The number of bytes read; 0 at the end of the output, -1 on an error.
+     */
+    [[nodiscard]] std::ptrdiff_t readOutput(char *buffer, std::size_t size);
+
+    /**
+     * @brief Reads from the child's standard error, blocking until something comes.
+     * @param buffer The buffer to fill.
+     * @param size The size of the buffer.
+     * @return The number of bytes read; 0 at the end of the stream, -1 on an error.
+     */
+    [[nodiscard]] std::ptrdiff_t readError(char *buffer, std::size_t size);
+
+    /**
+     * @brief Waits for the child to exit, then reaps it.
+     * @return The exit code of the child, -1 when a signal ended it or it never started.
+     */
+    int wait();
+
+    /** @brief Kills the child and every process of its group. No-op once it was reaped. */
+    void kill();
+};
+
+
+#endif //CHILD_PROCESS_H
@@ -0,0 +1,192 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ChildProcess.h"
+
+#include <array>
+#include <cerrno>
+#include <csignal>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+
+/**
+ * @brief Reads from a descriptor, retrying when a signal interrupts the call.
+ * @param descriptor The descriptor to read from.
+ * @param buffer The buffer to fill.
+ * @param size The size of the buffer.
+ * @return The number of bytes read; 0 at the end of the stream, -1 on an error.
+ */
+static std::ptrdiff_t readRetrying(const int descriptor, char *buffer, const std::size_t size) {
+    if (descriptor < 0) {
+        return -1;
+    }
+
+    auto count = ::read(descriptor, buffer, size);
+    while (count < 0 && errno == EINTR) {
+        count = ::read(descriptor, buffer, size);
+    }
+    return count;
+}
+
+ChildProcess::ChildProcess(const std::string &command)
+    : m_pid(-1),
+      m_input(-1),
+      m_output(-1),
+      m_error(-1),
+      m_reaped(false),
+      m_exit_code(-1) {
+    // A child that exits before reading all its input must fail the write, not kill the editor
+    static const auto ignore_broken_pipe = std::signal(SIGPIPE, SIG_IGN);
+    (void) ignore_broken_pipe;
+
+    // Every end is close-on-exec: the child only keeps the copies dup2 puts on 0, 1 and 2, so no
+    // other child holds a pipe open past the end of this one
+    auto input = std::array<int, 2>{ -1, -1 };
+    auto output = std::array<int, 2>{ -1, -1 };
+    auto error = std::array<int, 2>{ -1, -1 };
+    if (pipe2(input.data(), O_CLOEXEC) != 0 || pipe2(output.data(), O_CLOEXEC) != 0 || pipe2(error.data(), O_CLOEXEC) != 0) {
+        for (const auto descriptor : { input[0], input[1], output[0], output[1], error[0], error[1] }) {
+            if (descriptor >= 0) {
+                close(descriptor);
+            }
+        }
+        return;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, input[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, error[1], STDERR_FILENO);
+
+    // A group of its own, led by the shell, so kill reaches every process of a pipeline
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attributes, 0);
+
+    char shell[] = "/bin/sh";
+    char flag[] = "-c";
+    auto line = command;
+    char *arguments[] = { shell, flag, line.data(), nullptr };
+    auto pid = pid_t{ -1 };
+    const auto spawned = posix_spawn(&pid, shell, &actions, &attributes, arguments, environ) == 0;
+
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+
+    // The child's ends are its own now
+    close(input[0]);
+    close(output[1]);
+    close(error[1]);
+    if (!spawned) {
+        close(input[1]);
+        close(output[0]);
+        close(error[0]);
+        return;
+    }
+
+    m_pid = pid;
+    m_input = input[1];
+    m_output = output[0];
+    m_error = error[0];
+}
+
+ChildProcess::~ChildProcess() {
+    if (m_pid >= 0) {
+        kill();
+        (void) wait();
+    }
+
+    closeInput();
+    for (const auto descriptor : { m_output, m_error }) {
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+    }
+}
+
+bool ChildProcess::isStarted() const {
+    return m_pid >= 0;
+}
+
+bool ChildProcess::writeInput(std::string_view bytes) {
+    if (m_input < 0) {
+        return false;
+    }
+
+    while (!bytes.empty()) {
+        const auto count = ::write(m_input, bytes.data(), bytes.size());
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes.remove_prefix(static_cast<std::size_t>(count));
+    }
+    return true;
+}
+
+void ChildProcess::closeInput() {
+    if (m_input >= 0) {
+        close(m_input);
+        m_input = -1;
+    }
+}
+
+std::ptrdiff_t ChildProcess::readOutput(char *buffer, const std::size_t size) {
+    return readRetrying(m_output, buffer, size);
+}
+
+std::ptrdiff_t ChildProcess::readError(char *buffer, const std::size_t size) {
+    return readRetrying(m_error, buffer, size);
+}
+
+int ChildProcess::wait() {
+    if (m_pid < 0) {
+        return -1;
+    }
+
+    // Wait without reaping first: until it is reaped, the exited child keeps its id, so a kill
+    // racing with the wait still signals the right group
+    auto info = siginfo_t{};
+    while (waitid(P_PID, static_cast<id_t>(m_pid), &info, WEXITED | WNOWAIT) != 0 && errno == EINTR) {}
+
+    const auto lock = std::scoped_lock(m_mutex);
+    if (!m_reaped) {
+        auto status = 0;
+        while (waitpid(m_pid, &status, 0) < 0 && errno == EINTR) {}
+        m_exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        m_reaped = true;
+    }
+    return m_exit_code;
+}
+
+void ChildProcess::kill() {
+    const auto lock = std::scoped_lock(m_mutex);
+    if (m_pid >= 0 && !m_reaped) {
+        (void) ::kill(-m_pid, SIGKILL);
+    }
+}
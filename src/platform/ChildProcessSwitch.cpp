@@ -0,0 +1,62 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ChildProcess.h"
+
+
+ChildProcess::ChildProcess(const std::string &command)
+    : m_pid(-1),
+      m_input(-1),
+      m_output(-1),
+      m_error(-1),
+      m_reaped(false),
+      m_exit_code(-1) {
+    // The console runs no other program: the child never starts
+    (void) command;
+}
+
+ChildProcess::~ChildProcess() = default;
+
+bool ChildProcess::isStarted() const {
+    return false;
+}
+
+bool ChildProcess::writeInput(const std::string_view bytes) {
+    (void) bytes;
+    return false;
+}
+
+void ChildProcess::closeInput() {}
+
+std::ptrdiff_t ChildProcess::readOutput(char *buffer, const std::size_t size) {
+    (void) buffer;
+    (void) size;
+    return -1;
+}
+
+std::ptrdiff_t ChildProcess::readError(char *buffer, const std::size_t size) {
+    (void) buffer;
+    (void) size;
+    return -1;
+}
+
+int ChildProcess::wait() {
+    return -1;
+}
+
+void ChildProcess::kill() {}
@@ -0,0 +1,89 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+
+/**
+ * @brief Read-only view of the whole content of a file, for as long as the object lives.
+ *
+ * Part of the platform seam: MappedFileDesktop.cpp maps the file with mmap, so reading a file
+ * that turns out to hold nothing of interest costs no copy; MappedFileSwitch.cpp reads it into
+ * memory, as newlib offers no mmap. Move-only.
+ */
+class MappedFile final {
+private:
+    /** First byte of the content, or nullptr when the file is empty or could not be read. */
+    const char *p_data;
+
+    /** Size of the content in bytes. */
+    size_t m_size;
+
+    /** Copy of the content, when the platform reads the file rather than mapping it. */
+    std::unique_ptr<char[]> m_copy;
+
+    /** @brief Releases the view, leaving the object empty. */
+    void release();
+
+public:
+    /** @brief Deleted copy constructor. */
+    MappedFile(const MappedFile &) = delete;
+
+    /** @brief Deleted copy assignment operator. */
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Takes over the view of another MappedFile, which is left empty.
+     * @param other The file to move from.
+     */
+    MappedFile(MappedFile &&other) noexcept;
+
+    /**
+     * @brief Releases the current view and takes over the one of another MappedFile.
+     * @param other The file to move from.
+     * @return This file.
+     */
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    /** @brief Releases the view. */
+    ~MappedFile();
+
+    /**
+     * @brief Opens a regular file and makes its content readable.
+     *
+     * An empty file opens fine and reads as empty.
+     *
+     * @param path Path of the file to open. UTF-8.
+     */
+    explicit MappedFile(const std::string &path);
+
+    /** @return true when the file could be opened and read. */
+    [[nodiscard]] bool isOpen() const;
+
+    /** @return The content of the file; empty when it is empty or could not be opened. */
+    [[nodiscard]] std::string_view getBytes() const;
+};
+
+
+#endif //MAPPED_FILE_H
@@ -0,0 +1,89 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "MappedFile.h"
+
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/** Stand-in for the data of an empty file, which mmap refuses to map. */
+static constexpr char EMPTY_CONTENT[] = "";
+
+MappedFile::MappedFile(const std::string &path)
+    : p_data(nullptr),
+      m_size(0) {
+    const auto descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0) {
+        return;
+    }
+
+    struct stat status {};
+    if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode)) {
+        if (status.st_size == 0) {
+            p_data = EMPTY_CONTENT;
+        } else if (const auto address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0); address != MAP_FAILED) {
+            // Read front to back exactly once: let the kernel read ahead generously
+            (void) madvise(address, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+            p_data = static_cast<const char *>(address);
+            m_size = static_cast<size_t>(status.st_size);
+        }
+    }
+
+    // The mapping holds its own reference to the file
+    close(descriptor);
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : p_data(std::exchange(other.p_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_copy(std::move(other.m_copy)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        release();
+        p_data = std::exchange(other.p_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_copy = std::move(other.m_copy);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+void MappedFile::release() {
+    if (m_size > 0) {
+        (void) munmap(const_cast<char *>(p_data), m_size);
+    }
+    p_data = nullptr;
+    m_size = 0;
+}
+
+bool MappedFile::isOpen() const {
+    return p_data != nullptr;
+}
+
+std::string_view MappedFile::getBytes() const {
+    return p_data ? std::string_view(p_data, m_size) : std::string_view();
+}
@@ -0,0 +1,91 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "MappedFile.h"
+
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+
+/** Stand-in for the data of an empty file, so it still reads as open. */
+static constexpr char EMPTY_CONTENT[] = "";
+
+MappedFile::MappedFile(const std::string &path)
+    : p_data(nullptr),
+      m_size(0) {
+    // No mmap in newlib: read the whole file instead
+    auto error_code = std::error_code{};
+    if (!std::filesystem::is_regular_file(path, error_code)) {
+        return;
+    }
+
+    const auto size = std::filesystem::file_size(path, error_code);
+    auto ifs = std::ifstream(path, std::ios::in | std::ios::binary);
+    if (error_code || !ifs) {
+        return;
+    }
+
+    if (size == 0) {
+        p_data = EMPTY_CONTENT;
+        return;
+    }
+
+    m_copy = std::make_unique<char[]>(static_cast<size_t>(size));
+    if (!ifs.read(m_copy.get(), static_cast<std::streamsize>(size))) {
+        m_copy.reset();
+        return;
+    }
+
+    p_data = m_copy.get();
+    m_size = static_cast<size_t>(size);
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : p_data(std::exchange(other.p_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)),
+      m_copy(std::move(other.m_copy)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        release();
+        p_data = std::exchange(other.p_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_copy = std::move(other.m_copy);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+void MappedFile::release() {
+    // The copy goes with m_copy
+    m_copy.reset();
+    p_data = nullptr;
+    m_size = 0;
+}
+
+bool MappedFile::isOpen() const {
+    return p_data != nullptr;
+}
+
+std::string_view MappedFile::getBytes() const {
+    return p_data ? std::string_view(p_data, m_size) : std::string_view();
+}
@@ -66,6 +66,14 @@ public:
      */
     [[nodiscard]] static std::optional<std::string> userConfigDir(std::string_view executablePath);
 
+    /**
+     * @brief Resolves the directory scratch files go to, such as the undo journals.
+     *
+     * @return The system temporary directory on desktop, trailing separator included; std::nullopt
+     *         on Switch, where the only writable storage is the SD card, and when it cannot be found.
+     */
+    [[nodiscard]] static std::optional<std::string> tempDir();
+
     /**
      * @brief Queries the system-wide light/dark preference.
      *
@@ -18,6 +18,9 @@
  */
 #include "Platform.h"
 
+#include <filesystem>
+#include <system_error>
+
 
 std::string Platform::assetPath(const std::string_view relative) {
     // Assets live in ./romfs relative to the working directory: the path is already correct.
@@ -30,6 +33,15 @@ std::optional<std::string> Platform::userConfigDir(const std::string_view execut
     return std::nullopt;
 }
 
+std::optional<std::string> Platform::tempDir() {
+    auto error_code = std::error_code();
+    const auto path = std::filesystem::temp_directory_path(error_code);
+    if (error_code || path.empty()) {
+        return std::nullopt;
+    }
+    return (path / "").string();
+}
+
 std::optional<Platform::ColorScheme> Platform::preferredColorScheme() {
     // No system-theme query wired up on desktop (SDL exposes none in 2.x).
     return std::nullopt;
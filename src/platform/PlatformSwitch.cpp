@@ -41,6 +41,12 @@ std::optional<std::string> Platform::userConfigDir(const std::string_view execut
     return std::string(executablePath.substr(0, separator + 1));
 }
 
+std::optional<std::string> Platform::tempDir() {
+    // The SD card is the only writable storage: spilling history to it would trade RAM for card
+    // wear and slow writes, so the history stays in memory, capped, on the console.
+    return std::nullopt;
+}
+
 std::string_view Platform::keyboardLayout() {
     // Same source the patched SDL keyboard driver reads; the name mapping mirrors its
     // GetLayoutTable(): layouts without a table (CJK, FrenchCa, UsInternational) use qwerty.
@@ -252,21 +252,20 @@ void Prompt::drawText(QuadBuffer &quadBuffer, const CursorContext &context, cons
 
     // Draw a right-aligned "index/total" counter. History and completion counters only exist while
     // the prompt is focused; the search counter persists so it stays visible with focus in the editor.
-    auto indicator_index = 0;
-    auto indicator_count = 0;
+    // A search counter still being counted reads "?/total+" until the ordinal is known, then "index/total+".
+    auto string_indicator = std::u16string{};
     if (viewState.isNavigatingHistory()) {
-        indicator_index = viewState.getHistoryIndex();
-        indicator_count = viewState.getHistoryCount();
+        string_indicator = utf8::utf8to16(std::format("{}/{}", viewState.getHistoryIndex() + 1, viewState.getHistoryCount()));
     } else if (viewState.getCompletionCount() > 0) {
-        indicator_index = viewState.getCompletionIndex();
-        indicator_count = viewState.getCompletionCount();
+        string_indicator = utf8::utf8to16(std::format("{}/{}", viewState.getCompletionIndex() + 1, viewState.getCompletionCount()));
+    } else if (context.search.match_pending) {
+        const auto index = context.search.match_index >= 0 ? std::to_string(context.search.match_index + 1) : std::string("?");
+        string_indicator = utf8::utf8to16(std::format("{}/{}+", index, context.search.match_count));
     } else if (context.search.match_count > 0) {
-        indicator_index = context.search.match_index;
-        indicator_count = context.search.match_count;
+        string_indicator = utf8::utf8to16(std::format("{}/{}", context.search.match_index + 1, context.search.match_count));
     }
 
-    if (indicator_count > 0) {
-        const auto string_indicator = utf8::utf8to16(std::format("{}/{}", indicator_index + 1, indicator_count));
+    if (!string_indicator.empty()) {
         // The measure lives in 64-bit content space; a short counter string always fits the screen
         const auto indicator_text_width = static_cast<int32_t>(m_theme.measure(string_indicator));
         pen_position_x = position_x + width - padding_width - indicator_text_width;
@@ -256,6 +256,194 @@ TEST_CASE("edits alternating between distant lines keep every observable straigh
     CHECK(joinLines(model) == std::u16string(u"Fzero\noneE\ntGwo\nCAAAree\nurD"));
 }
 
+TEST_CASE("random hops between lines agree with the model, across gap growths and commits") {
+    // Single-line edits, splits and joins move the detached line and the gap at its slot; the
+    // lines grow past the gap now and then, and a multi-line edit commits the gap away
+    auto random = std::mt19937(0x67617073);
+    auto buffer = LineBuffer();
+    auto model = seedBuffer(buffer, u"one\ntwo\nthree\nfour\nfive\nsix\nseven");
+
+    for (auto step = 0; step < 2000; ++step) {
+        CAPTURE(step);
+        const auto line = static_cast<uint32_t>(random() % model.size());
+        const auto column = static_cast<uint32_t>(random() % (model[line].length() + 1));
+        switch (random() % 8) {
+            case 0:
+            case 1:
+            case 2:
+                (void) applyInsert(buffer, model, line, column, std::u16string(1 + random() % 3000, u'a' + static_cast<char16_t>(step % 26)));
+                break;
+            case 3:
+                (void) applyErase(buffer, model, line, column, line, static_cast<uint32_t>(column + random() % (model[line].length() - column + 1)));
+                break;
+            case 4:
+                if (model.size() < 40) {
+                    (void) applyInsert(buffer, model, line, column, u"\n");
+                }
+                break;
+            case 5:
+                if (line + 1 < model.size()) {
+                    (void) applyErase(buffer, model, line, static_cast<uint32_t>(model[line].length()), line + 1, 0);
+                }
+                break;
+            case 6:
+                if (model.size() < 40) {
+                    (void) applyInsert(buffer, model, line, column, u"x\ny");
+                }
+                break;
+            default:
+                if (line + 1 < model.size()) {
+                    (void) applyErase(buffer, model, line, column, line + 1, static_cast<uint32_t>(random() % (model[line + 1].length() + 1)));
+                }
+                break;
+        }
+    }
+}
+
+TEST_CASE("an extract hands the removed text over, line breaks included") {
+    auto buffer = LineBuffer();
+    auto model = seedBuffer(buffer, u"zero\none\ntwo\nthree\nfour");
+
+    // Small ranges are copied out, on the detached line, across lines and given backwards
+    (void) applyExtract(buffer, model, 4, 1, 4, 3);
+    (void) applyExtract(buffer, model, 0, 2, 2, 1);
+    (void) applyExtract(buffer, model, 1, 4, 0, 1);
+    CHECK(joinLines(model) == std::u16string(u"ze\nfr"));
+}
+
+TEST_CASE("an extract of most of a large buffer leaves only the text kept allocated") {
+    auto buffer = LineBuffer();
+    auto text = std::u16string{};
+    for (auto line = 0; line < 2000; ++line) {
+        text.append(100, u'a' + static_cast<char16_t>(line % 26));
+        text.push_back(u'\n');
+    }
+    auto model = seedBuffer(buffer, text);
+
+    // Typing on the detached line eats into the room kept for the breaks
+    (void) applyInsert(buffer, model, 1000, 50, std::u16string(3000, u'x'));
+    (void) applyExtract(buffer, model, 1, 3, 1998, 7);
+    CHECK(buffer.getStringCount() == 4);
+    CHECK(buffer.getMemoryUsage().text < 16 * 1024);
+
+    // The line the extract ended on is detached with its slot as the gap: the edits after it agree
+    (void) applyInsert(buffer, model, 1, 2, u"yy");
+    (void) applyInsert(buffer, model, 0, 0, u"z");
+    (void) applyErase(buffer, model, 1, 0, 2, 1);
+    (void) applyInsert(buffer, model, 1, 1, u"\nw\n");
+}
+
+TEST_CASE("random extracts agree with the model, whichever way they take") {
+    auto random = std::mt19937(0x65787472);
+    auto buffer = LineBuffer();
+    auto text = std::u16string{};
+    for (auto line = 0; line < 400; ++line) {
+        text.append(1 + random() % 500, u'a' + static_cast<char16_t>(line % 26));
+        text.push_back(u'\n');
+    }
+    auto model = seedBuffer(buffer, text);
+
+    for (auto step = 0; step < 60; ++step) {
+        CAPTURE(step);
+        const auto line = static_cast<uint32_t>(random() % model.size());
+        const auto column = static_cast<uint32_t>(random() % (model[line].length() + 1));
+        const auto line_end = static_cast<uint32_t>(random() % model.size());
+        const auto column_end = static_cast<uint32_t>(random() % (model[line_end].length() + 1));
+        switch (random() % 3) {
+            case 0:
+                (void) applyExtract(buffer, model, line, column, line_end, column_end);
+                break;
+            case 1:
+                (void) applyInsert(buffer, model, line, column, std::u16string(1 + random() % 2000, u'a' + static_cast<char16_t>(step % 26)));
+                break;
+            default:
+                // Lines enough to make the next large extract worth taking the storage for
+                (void) applyInsert(buffer, model, line, column, text.substr(0, text.find(u'\n', random() % text.length())));
+                break;
+        }
+    }
+}
+
+TEST_CASE("a splice applies every replacement against the buffer before it") {
+    auto buffer = LineBuffer();
+    auto model = seedBuffer(buffer, u"one\ntwo\nthree\nfour");
+
+    // Line 3 is detached, outside the touched lines, and the replacements add and remove lines: the
+    // last one only lands right if none of the earlier ones moved it
+    const auto splices = std::vector<BufferSplice>{
+        {.start = {.line = 0, .column = 1}, .end = {.line = 0, .column = 2}, .text = u"N"},
+        {.start = {.line = 1, .column = 0}, .end = {.line = 2, .column = 2}, .text = u"x\ny\nz"},
+        {.start = {.line = 2, .column = 5}, .end = {.line = 2, .column = 5}, .text = u"!"}
+    };
+    const auto start_byte = modelByteOffset(model, 0, 1);
+    const auto old_end_byte = modelByteOffset(model, 2, 5);
+    const auto edit = buffer.splice(splices);
+    for (auto it = splices.rbegin(); it != splices.rend(); ++it) {
+        modelErase(model, it->start.line, it->start.column, it->end.line, it->end.column);
+        modelInsert(model, it->start.line, it->start.column, it->text);
+    }
+
+    CHECK(joinLines(model) == std::u16string(u"oNe\nx\ny\nzree!\nfour"));
+    checkEditIsConsistent(edit);
+    CHECK(edit.start.line == 0);
+    CHECK(edit.start.column == 1);
+    CHECK(edit.old_end.line == 2);
+    CHECK(edit.old_end.column == 5);
+    CHECK(edit.new_end.line == 3);
+    CHECK(edit.new_end.column == 5);
+    CHECK(edit.start_byte == start_byte);
+    CHECK(edit.old_end_byte == old_end_byte);
+    CHECK(edit.new_end_byte == modelByteOffset(model, 3, 5));
+    checkMatches(buffer, model);
+
+    // The buffer keeps working from the line the splice left detached
+    (void) applyInsert(buffer, model, 3, 0, u"\t");
+    (void) applyErase(buffer, model, 0, 0, 1, 1);
+}
+
+TEST_CASE("random splices agree with the same replacements applied one by one") {
+    auto random = std::mt19937(0x73706c63);
+    const auto pieces = std::vector<std::u16string_view>{u"", u"a", u"\t", u"bc", u"\n", u"d\ne", u"\n\n"};
+
+    for (auto round = 0; round < 300; ++round) {
+        CAPTURE(round);
+        auto buffer = LineBuffer();
+        auto model = seedBuffer(buffer, u"alpha\nbeta\n\ngamma\tdelta\nepsilon");
+
+        // Detach some line first, so the splice starts from any layout the buffer can be in
+        const auto detached = static_cast<uint32_t>(random() % model.size());
+        (void) applyInsert(buffer, model, detached, 0, u"-");
+
+        // Positions picked in increasing order over the flat text make sorted, non-overlapping ranges
+        const auto text = joinLines(model);
+        auto offsets = std::vector<uint32_t>{};
+        for (auto count = 1 + random() % 6; count > 0; --count) {
+            offsets.push_back(static_cast<uint32_t>(random() % (text.length() + 1)));
+            offsets.push_back(static_cast<uint32_t>(random() % (text.length() + 1)));
+        }
+        std::ranges::sort(offsets);
+
+        auto splices = std::vector<BufferSplice>{};
+        for (auto i = std::size_t{0}; i < offsets.size(); i += 2) {
+            const auto start = advancePosition({.line = 0, .column = 0}, std::u16string_view(text).substr(0, offsets[i]));
+            const auto end = advancePosition({.line = 0, .column = 0}, std::u16string_view(text).substr(0, offsets[i + 1]));
+            splices.push_back(BufferSplice{.start = start, .end = end, .text = pieces[random() % pieces.size()]});
+        }
+
+        const auto start_byte = modelByteOffset(model, splices.front().start.line, splices.front().start.column);
+        const auto edit = buffer.splice(splices);
+        for (auto it = splices.rbegin(); it != splices.rend(); ++it) {
+            modelErase(model, it->start.line, it->start.column, it->end.line, it->end.column);
+            modelInsert(model, it->start.line, it->start.column, it->text);
+        }
+
+        checkEditIsConsistent(edit);
+        CHECK(edit.start_byte == start_byte);
+        CHECK(edit.new_end_byte == modelByteOffset(model, edit.new_end.line, edit.new_end.column));
+        checkMatches(buffer, model);
+    }
+}
+
 TEST_CASE("byte offsets stay right while a middle line is detached") {
     auto buffer = LineBuffer();
     auto model = seedBuffer(buffer, u"aaa\nbbbb\nccccc\nd");
@@ -374,3 +562,14 @@ TEST_CASE("advancePosition counts every line of a multi-line text") {
     CHECK(empty_lines.line == 5);
     CHECK(empty_lines.column == 0);
 }
+
+TEST_CASE("the memory usage covers the text, the line table and the metrics") {
+    auto buffer = LineBuffer();
+    (void) seedBuffer(buffer, u"one\ntwo\nthree");
+
+    // Capacities, not sizes: each counter holds at least what the content needs
+    const auto usage = buffer.getMemoryUsage();
+    CHECK(usage.text >= std::u16string_view(u"onetwothree").size() * sizeof(char16_t));
+    CHECK(usage.line_table >= 3 * 2 * sizeof(uint32_t));
+    CHECK(usage.line_metrics >= 3 * 2 * sizeof(uint32_t));
+}
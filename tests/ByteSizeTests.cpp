@@ -0,0 +1,40 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TestSupport.h"
+
+#include "core/base/ByteSize.h"
+
+
+TEST_CASE("sizes under a kibibyte print as whole bytes") {
+    CHECK(formatByteSize(0) == "0 B");
+    CHECK(formatByteSize(1) == "1 B");
+    CHECK(formatByteSize(1023) == "1023 B");
+}
+
+TEST_CASE("larger sizes pick the largest unit keeping the value at or above one") {
+    CHECK(formatByteSize(1024) == "1.0 KiB");
+    CHECK(formatByteSize(1536) == "1.5 KiB");
+    CHECK(formatByteSize(std::size_t{ 1024 } * 1024) == "1.0 MiB");
+    CHECK(formatByteSize(std::size_t{ 3 } * 1024 * 1024 * 1024) == "3.0 GiB");
+}
+
+TEST_CASE("the largest unit keeps growing rather than overflowing the table") {
+    // 2^50 bytes is 1024 TiB: there is no larger unit, so the value grows instead
+    CHECK(formatByteSize(std::size_t{ 1 } << 50) == "1024.0 TiB");
+}
@@ -0,0 +1,244 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "TestSupport.h"
+
+
+/**
+ * @brief Returns the positions of every caret, the main one last.
+ * @param cursor The cursor.
+ * @return The positions, as line and column pairs.
+ */
+static std::vector<std::pair<uint32_t, uint32_t>> caretPositions(const Cursor &cursor) {
+    auto positions = std::vector<std::pair<uint32_t, uint32_t>>{};
+    for (const auto &caret : cursor.getCarets()) {
+        positions.emplace_back(caret.position.line, caret.position.column);
+    }
+    positions.emplace_back(cursor.getLine(), cursor.getColumn());
+    return positions;
+}
+
+TEST_CASE("a caret on each selected line types everywhere as one undo step") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"one\ntwo\nthree\nfour");
+
+    // The selection ends at the start of the last line, which is left out
+    select(cursor, 0, 1, 3, 0);
+    REQUIRE(cursor.addCaretsOnSelectedLines());
+    CHECK(cursor.getCaretCount() == 3);
+    CHECK(caretPositions(cursor) == std::vector<std::pair<uint32_t, uint32_t>>{{0, 3}, {1, 3}, {2, 5}});
+    CHECK(!cursor.getSelectedRange().has_value());
+
+    const auto before = cursor.getText();
+    const auto edit = cursor.insertAtCarets(u";");
+    REQUIRE(edit.has_value());
+    CHECK(cursor.getText() == u"one;\ntwo;\nthree;\nfour");
+    CHECK(describes(*edit, before, cursor.getText()));
+    CHECK(caretPositions(cursor) == std::vector<std::pair<uint32_t, uint32_t>>{{0, 4}, {1, 4}, {2, 6}});
+
+    // A line break splits every line, and the carets follow the lines pushed down
+    REQUIRE(cursor.insertAtCarets(u"\n").has_value());
+    CHECK(cursor.getText() == u"one;\n\ntwo;\n\nthree;\n\nfour");
+    CHECK(caretPositions(cursor) == std::vector<std::pair<uint32_t, uint32_t>>{{1, 0}, {3, 0}, {5, 0}});
+
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == u"one;\ntwo;\nthree;\nfour");
+    CHECK(cursor.getCaretCount() == 1);
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == u"one\ntwo\nthree\nfour");
+    CHECK(!undoStep(cursor));
+}
+
+TEST_CASE("carets on the next matches replace every occurrence") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"foo bar foo\nfoofoo\nbaz");
+
+    select(cursor, 0, 8, 0, 11);
+    // Wrapping around the end, the occurrences come in order from the main selection on
+    REQUIRE(cursor.addCaretAtNextMatch());
+    CHECK(cursor.getLine() == 1);
+    CHECK(cursor.getColumn() == 3);
+    REQUIRE(cursor.addCaretAtNextMatch());
+    REQUIRE(cursor.addCaretAtNextMatch());
+    CHECK(cursor.getLine() == 0);
+    CHECK(cursor.getColumn() == 3);
+    CHECK(cursor.getCaretCount() == 4);
+
+    // Every occurrence holds a caret now
+    CHECK(!cursor.addCaretAtNextMatch());
+    CHECK(cursor.getCaretCount() == 4);
+
+    REQUIRE(cursor.insertAtCarets(u"x").has_value());
+    CHECK(cursor.getText() == u"x bar x\nxx\nbaz");
+    CHECK(caretPositions(cursor) == std::vector<std::pair<uint32_t, uint32_t>>{{0, 7}, {1, 1}, {1, 2}, {0, 1}});
+
+    // The carets side by side erase one character each, and meet
+    REQUIRE(cursor.eraseAtCarets(false).has_value());
+    CHECK(cursor.getText() == u" bar \n\nbaz");
+    CHECK(caretPositions(cursor) == std::vector<std::pair<uint32_t, uint32_t>>{{0, 5}, {1, 0}, {0, 0}});
+
+    REQUIRE(undoStep(cursor));
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == u"foo bar foo\nfoofoo\nbaz");
+}
+
+TEST_CASE("a caret match needs a one-line selection") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"ab\nab");
+
+    CHECK(!cursor.addCaretAtNextMatch());
+    select(cursor, 0, 0, 1, 1);
+    CHECK(!cursor.addCaretAtNextMatch());
+    CHECK(cursor.getCaretCount() == 1);
+
+    // One line only: no line to add a caret on besides the main one
+    select(cursor, 0, 0, 0, 2);
+    CHECK(!cursor.addCaretsOnSelectedLines());
+}
+
+TEST_CASE("moves apply to every caret and merge the carets that meet") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"abc\nde\nfghi");
+
+    select(cursor, 0, 0, 2, 4);
+    REQUIRE(cursor.addCaretsOnSelectedLines());
+    cursor.moveLeft();
+    CHECK(caretPositions(cursor) == std::vector<std::pair<uint32_t, uint32_t>>{{0, 2}, {1, 1}, {2, 3}});
+
+    // Each caret keeps a selection of its own
+    cursor.activateSelection(true);
+    cursor.moveToStartOfLine();
+    REQUIRE(cursor.insertAtCarets(u"-").has_value());
+    CHECK(cursor.getText() == u"-c\n-e\n-i");
+
+    // Up from the first line slides to its start, where the caret from the line below lands next
+    cursor.moveUp();
+    CHECK(caretPositions(cursor) == std::vector<std::pair<uint32_t, uint32_t>>{{0, 0}, {0, 1}, {1, 1}});
+    cursor.moveUp();
+    CHECK(caretPositions(cursor) == std::vector<std::pair<uint32_t, uint32_t>>{{0, 0}, {0, 1}});
+
+    // A jump goes back to a single caret
+    cursor.setPosition(2, 0);
+    CHECK(cursor.getCaretCount() == 1);
+}
+
+TEST_CASE("erasing at carets joins lines and stops at the edges of the buffer") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"a\nb\nc");
+
+    select(cursor, 0, 0, 2, 1);
+    REQUIRE(cursor.addCaretsOnSelectedLines());
+    cursor.moveToStartOfLine();
+
+    // The caret at the origin has nothing to erase; the others join their line to the one above
+    const auto before = cursor.getText();
+    const auto edit = cursor.eraseAtCarets(false);
+    REQUIRE(edit.has_value());
+    CHECK(cursor.getText() == u"abc");
+    CHECK(describes(*edit, before, cursor.getText()));
+    CHECK(caretPositions(cursor) == std::vector<std::pair<uint32_t, uint32_t>>{{0, 0}, {0, 1}, {0, 2}});
+
+    cursor.moveToEndOfFile();
+    CHECK(cursor.getCaretCount() == 1);
+    CHECK(!cursor.eraseAtCarets(true).has_value());
+}
+
+TEST_CASE("ten thousand carets type as one splice per keystroke") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    auto content = std::u16string{};
+    for (auto line = 0; line < 10000; ++line) {
+        content.append(u"line\n");
+    }
+    seed(cursor, content);
+
+    select(cursor, 0, 0, 10000, 0);
+    REQUIRE(cursor.addCaretsOnSelectedLines());
+    REQUIRE(cursor.getCaretCount() == 10000);
+    for (const auto character : std::u16string_view(u"ab;")) {
+        const auto edit = cursor.insertAtCarets(std::u16string_view(&character, 1));
+        REQUIRE(edit.has_value());
+        CHECK(edit->start.line == 0);
+        CHECK(edit->new_end.line == 9999);
+    }
+    CHECK(cursor.getString(0) == u"lineab;");
+    CHECK(cursor.getString(9999) == u"lineab;");
+    CHECK(cursor.getString(10000).empty());
+
+    CHECK(undoAll(cursor) == 3);
+    CHECK(cursor.getText() == content);
+}
+
+TEST_CASE("random caret edits describe their change and undo exactly") {
+    auto random = std::mt19937(47);
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    auto content = std::u16string{};
+    for (auto line = 0; line < 40; ++line) {
+        content.append(std::u16string(random() % 8, static_cast<char16_t>(u'a' + line % 26))).append(u"\n");
+    }
+    seed(cursor, content);
+
+    // Deep enough for every step to stay in memory
+    cursor.shareMaxHistoryDepth(std::make_shared<CVarInt>(1000));
+
+    auto texts = std::vector<std::u16string>{cursor.getText()};
+    for (auto step = 0; step < 300; ++step) {
+        if (cursor.getCaretCount() == 1) {
+            const auto first = static_cast<uint32_t>(random() % 20);
+            select(cursor, first, 0, first + 1 + static_cast<uint32_t>(random() % 20), 0);
+            REQUIRE(cursor.addCaretsOnSelectedLines());
+        }
+
+        const auto before = cursor.getText();
+        auto edit = std::optional<BufferEdit>{};
+        switch (random() % 8) {
+            case 0: edit = cursor.insertAtCarets(u"xy"); break;
+            case 1: edit = cursor.insertAtCarets(u"\n"); break;
+            case 2: edit = cursor.eraseAtCarets(false); break;
+            case 3: edit = cursor.eraseAtCarets(true); break;
+            case 4: cursor.moveLeft(); break;
+            case 5: cursor.moveDown(); break;
+            case 6: cursor.activateSelection(random() % 2 == 0); cursor.moveRight(); break;
+            default: cursor.moveUp(); break;
+        }
+
+        // The carets stay in buffer order, none of them on the main one
+        const auto &carets = cursor.getCarets();
+        for (auto i = std::size_t{1}; i < carets.size(); ++i) {
+            CHECK(std::tie(carets[i - 1].position.line, carets[i - 1].position.column) < std::tie(carets[i].position.line, carets[i].position.column));
+        }
+        for (const auto &caret : carets) {
+            CHECK((caret.position.line != cursor.getLine() || caret.position.column != cursor.getColumn()));
+            CHECK(caret.position.column <= cursor.getString(caret.position.line).length());
+        }
+
+        if (edit) {
+            CHECK(describes(*edit, before, cursor.getText()));
+            texts.push_back(cursor.getText());
+        } else {
+            CHECK(cursor.getText() == before);
+        }
+    }
+
+    // Every fan-out is one step: walking back passes every state recorded on the way
+    cursor.clearCarets();
+    for (auto it = texts.rbegin() + 1; it != texts.rend(); ++it) {
+        REQUIRE(undoStep(cursor));
+        CHECK(cursor.getText() == *it);
+    }
+    CHECK(!undoStep(cursor));
+}
@@ -0,0 +1,120 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/base/CaseFold.h"
+
+
+TEST_CASE("the table agrees with the rules for every code unit") {
+    auto expected = std::vector<char16_t>(0x10000);
+    for (uint32_t unit = 0; unit < 0x10000; ++unit) {
+        expected[unit] = static_cast<char16_t>(unit);
+    }
+    for (const auto &rule : CaseFold::getRules()) {
+        for (auto unit = uint32_t{ rule.first }; unit <= rule.last; unit += rule.step) {
+            expected[unit] = static_cast<char16_t>(unit + rule.offset);
+        }
+    }
+
+    auto mismatches = 0;
+    for (uint32_t unit = 0; unit < 0x10000; ++unit) {
+        const auto folded = CaseFold::fold(static_cast<char16_t>(unit));
+        if (folded != expected[unit] && ++mismatches <= 5) {
+            CAPTURE(unit);
+            CHECK(folded == expected[unit]);
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST_CASE("the rules are sorted and a folded unit folds to itself") {
+    auto previous = uint32_t{ 0 };
+    for (const auto &rule : CaseFold::getRules()) {
+        CAPTURE(static_cast<uint32_t>(rule.first));
+        CHECK(rule.first >= previous);
+        CHECK(rule.first <= rule.last);
+        CHECK((rule.step == 1 || rule.step == 2));
+        previous = rule.last + 1u;
+    }
+
+    for (uint32_t unit = 0; unit < 0x10000; ++unit) {
+        const auto folded = CaseFold::fold(static_cast<char16_t>(unit));
+        if (CaseFold::fold(folded) != folded) {
+            CAPTURE(unit);
+            CHECK(CaseFold::fold(folded) == folded);
+        }
+    }
+}
+
+TEST_CASE("letters fold to their simple lower case") {
+    CHECK(CaseFold::fold(u'A') == u'a');
+    CHECK(CaseFold::fold(u'z') == u'z');
+    CHECK(CaseFold::fold(u'@') == u'@');
+    CHECK(CaseFold::fold(u'É') == u'é');
+    CHECK(CaseFold::fold(u'Я') == u'я');
+    CHECK(CaseFold::fold(u'Ё') == u'ё');
+    CHECK(CaseFold::fold(u'Σ') == u'σ');
+    CHECK(CaseFold::fold(u'ς') == u'σ');
+    CHECK(CaseFold::fold(u'Ա') == u'ա');
+    CHECK(CaseFold::fold(u'Ａ') == u'ａ');
+    CHECK(CaseFold::fold(u'K') == u'k');
+    CHECK(CaseFold::fold(u'ſ') == u's');
+    CHECK(CaseFold::fold(u'Ǆ') == u'ǆ');
+    CHECK(CaseFold::fold(u'ǅ') == u'ǆ');
+    CHECK(CaseFold::fold(u'ẞ') == u'ß');
+    // Full foldings are left out: one code unit always folds to one
+    CHECK(CaseFold::fold(u'ß') == u'ß');
+    CHECK(CaseFold::fold(u'İ') == u'İ');
+    // So are the halves of surrogate pairs
+    CHECK(CaseFold::fold(u'\xD801') == u'\xD801');
+    CHECK(CaseFold::fold(u'\xDC00') == u'\xDC00');
+    CHECK(CaseFold::fold(u'聁') == u'聁');
+}
+
+TEST_CASE("the cases of a unit are the units folding to it") {
+    auto expected = std::vector<std::vector<char16_t>>(0x10000);
+    for (uint32_t unit = 0; unit < 0x10000; ++unit) {
+        expected[CaseFold::fold(static_cast<char16_t>(unit))].push_back(static_cast<char16_t>(unit));
+    }
+
+    auto mismatches = 0;
+    for (uint32_t folded = 0; folded < 0x10000; ++folded) {
+        if (expected[folded].empty()) {
+            continue;
+        }
+        const auto cases = CaseFold::getCases(static_cast<char16_t>(folded));
+        auto actual = std::vector<char16_t>(cases.begin(), cases.end());
+        std::ranges::sort(actual);
+        actual.erase(std::unique(actual.begin(), actual.end()), actual.end());
+        if (cases.front() != folded || actual != expected[folded]) {
+            if (++mismatches <= 5) {
+                CAPTURE(folded);
+                CHECK(actual == expected[folded]);
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+
+    CHECK(CaseFold::getCases(u'k') == CaseFold::Cases{ u'k', u'K', u'\x212A', u'k' });
+    CHECK(CaseFold::getCases(u'1') == CaseFold::Cases{ u'1', u'1', u'1', u'1' });
+}
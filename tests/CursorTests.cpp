@@ -264,6 +264,37 @@ TEST_CASE("setPosition refuses coordinates outside the buffer") {
     CHECK(cursor.getColumn() == 5);
 }
 
+TEST_CASE("batchReplace refuses ranges out of order or outside the buffer") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"one\ntwo\nthree");
+
+    const auto range = [](const uint32_t lineStart, const uint32_t columnStart, const uint32_t lineEnd, const uint32_t columnEnd) {
+        return TextRange{.line_start = lineStart, .column_start = columnStart, .line_end = lineEnd, .column_end = columnEnd};
+    };
+
+    // Nothing is queued outside a batch
+    CHECK_THROWS_AS(cursor.batchReplace(range(0, 0, 0, 1), u"x"), std::runtime_error);
+
+    cursor.beginBatch();
+    cursor.batchReplace(range(1, 1, 1, 2), u"W");
+    CHECK_THROWS_AS(cursor.batchReplace(range(0, 0, 0, 1), u"x"), std::runtime_error);
+    CHECK_THROWS_AS(cursor.batchReplace(range(1, 0, 1, 3), u"x"), std::runtime_error);
+    CHECK_THROWS_AS(cursor.batchReplace(range(2, 3, 2, 1), u"x"), std::runtime_error);
+    CHECK_THROWS_AS(cursor.batchReplace(range(2, 0, 3, 0), u"x"), std::runtime_error);
+    CHECK_THROWS_AS(cursor.batchReplace(range(2, 0, 2, 6), u"x"), std::runtime_error);
+
+    // A refused range is not queued: the batch goes on with the ones that were, touching ones included
+    cursor.batchReplace(range(1, 2, 2, 0), u"!");
+    REQUIRE(cursor.commitBatch().has_value());
+    CHECK(cursor.getText() == std::u16string(u"one\ntW!three"));
+    CHECK(cursor.getLine() == 1);
+    CHECK(cursor.getColumn() == 3);
+
+    // An empty batch changes nothing
+    cursor.beginBatch();
+    CHECK_FALSE(cursor.commitBatch().has_value());
+}
+
 TEST_CASE("setPosition snaps a column landing inside a surrogate pair") {
     const auto grin = std::u16string(u"\U0001F600");
 
@@ -0,0 +1,190 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "TestSupport.h"
+
+#include "core/FilterJob.h"
+
+
+/**
+ * @brief Waits for a job to be over, then takes what it produced.
+ * @param job The job to wait for.
+ * @return The result of the job.
+ */
+static FilterJob::Result finish(FilterJob &job) {
+    while (job.isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return job.takeResult();
+}
+
+
+TEST_CASE("a filter pipes a range through a command and collects its output") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"keep\ncherry\napple\nbanana\nkeep");
+
+    auto job = FilterJob();
+    REQUIRE(job.start(cursor, TextRange{.line_start = 1, .column_start = 0, .line_end = 3, .column_end = 6}, "sort"));
+    CHECK(job.isStarted());
+    CHECK(job.getCursor() == &cursor);
+
+    // The line end added to the last line comes off the output
+    auto result = finish(job);
+    CHECK(result.output == u"apple\nbanana\ncherry");
+    CHECK(result.exit_code == 0);
+    CHECK_FALSE(result.cancelled);
+    CHECK_FALSE(result.edited);
+    CHECK_FALSE(job.isStarted());
+    CHECK(job.getCursor() == nullptr);
+
+    // A range ending at the start of a line already ends with a line end, kept in the output
+    REQUIRE(job.start(cursor, TextRange{.line_start = 0, .column_start = 2, .line_end = 2, .column_end = 0}, "tr a-z A-Z"));
+    result = finish(job);
+    CHECK(result.output == u"EP\nCHERRY\n");
+    CHECK(job.getStats().bytes_written == 10);
+
+    // An empty range still gets its line, and the job can start again
+    REQUIRE(job.start(cursor, TextRange{.line_start = 4, .column_start = 4, .line_end = 4, .column_end = 4}, "echo inserted"));
+    result = finish(job);
+    CHECK(result.output == u"inserted");
+    CHECK(job.getStats().bytes_read == 9);
+}
+
+TEST_CASE("a filter reports the exit code and the error stream of a failing command") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"text");
+
+    auto job = FilterJob();
+    REQUIRE(job.start(cursor, TextRange{.line_start = 0, .column_start = 0, .line_end = 0, .column_end = 4}, "echo partial; echo 'went wrong' >&2; exit 3"));
+    auto result = finish(job);
+    CHECK(result.exit_code == 3);
+    CHECK(result.error == "went wrong\n");
+    CHECK(result.output == u"partial");
+    CHECK_FALSE(result.cancelled);
+
+    // The error stream is read to its end, and only its start is kept
+    REQUIRE(job.start(cursor, TextRange{.line_start = 0, .column_start = 0, .line_end = 0, .column_end = 4}, "head -c 100000 /dev/zero >&2"));
+    result = finish(job);
+    CHECK(result.exit_code == 0);
+    CHECK(result.error.length() == FilterJob::MAX_ERROR_BYTES);
+
+    REQUIRE(job.start(cursor, TextRange{.line_start = 0, .column_start = 0, .line_end = 0, .column_end = 4}, "a_command_that_does_not_exist_anywhere"));
+    result = finish(job);
+    CHECK(result.exit_code == 127);
+    CHECK_FALSE(result.error.empty());
+}
+
+TEST_CASE("a filter round-trips a large text and decodes what the command writes") {
+    // Lines longer than a chunk, and characters of every UTF-8 length, some cut between chunks
+    auto content = std::u16string{};
+    for (auto line = 0; line < 64; ++line) {
+        for (auto repeat = 0; repeat < 1000 + line; ++repeat) {
+            content.append(u"aé€😀");
+        }
+        content.push_back(u'\n');
+    }
+    content.append(u"last");
+
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, content);
+    const auto last_line = cursor.getLineCount() - 1;
+    const auto whole = TextRange{.line_start = 0, .column_start = 0, .line_end = last_line, .column_end = 4};
+
+    auto job = FilterJob();
+    REQUIRE(job.start(cursor, whole, "cat"));
+    auto result = finish(job);
+    CHECK(result.exit_code == 0);
+    CHECK(result.output == content);
+    CHECK(job.getStats().bytes_written == job.getStats().bytes_read);
+    CHECK(job.getStats().bytes_written > FilterJob::CHUNK_BYTES * 4);
+
+    // Invalid bytes read as U+FFFD, a cut sequence at the end too, and CRLF line ends as LF
+    REQUIRE(job.start(cursor, whole, R"(printf 'a\377b\r\nc\r\n\342\202')"));
+    result = finish(job);
+    CHECK(result.output == u"a�b\nc\n�");
+
+    // A command that reads nothing still runs to its end
+    REQUIRE(job.start(cursor, whole, "echo done"));
+    result = finish(job);
+    CHECK(result.exit_code == 0);
+    CHECK(result.output == u"done");
+}
+
+TEST_CASE("a cancelled filter kills the command and everything it started") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"text");
+
+    auto job = FilterJob();
+    const auto started = std::chrono::steady_clock::now();
+    REQUIRE(job.start(cursor, TextRange{.line_start = 0, .column_start = 0, .line_end = 0, .column_end = 4}, "sleep 30 | sleep 30"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(job.isRunning());
+
+    job.cancel();
+    CHECK_FALSE(job.isRunning());
+    CHECK(job.isStarted());
+    const auto result = job.takeResult();
+    CHECK(result.cancelled);
+    CHECK(result.exit_code == -1);
+    CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(10));
+
+    // Cancelling an idle job does nothing
+    job.cancel();
+    CHECK_FALSE(job.isStarted());
+}
+
+TEST_CASE("a filter whose buffer is edited or closed stops reading it and says so") {
+    // More than the pipe holds, so the writer is still at it while the command sleeps
+    auto content = std::u16string{};
+    for (auto line = 0; line < 4096; ++line) {
+        content.append(100, u'a').push_back(u'\n');
+    }
+
+    auto cursor = std::make_unique<Cursor>(std::make_unique<LineBuffer>());
+    seed(*cursor, content);
+    const auto last_line = cursor->getLineCount() - 1;
+    const auto whole = TextRange{.line_start = 0, .column_start = 0, .line_end = last_line, .column_end = 0};
+
+    auto job = FilterJob();
+    REQUIRE(job.start(*cursor, whole, "sleep 0.2; cat"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    (void) cursor->insert(u"x");
+    auto result = finish(job);
+    CHECK(result.edited);
+    CHECK_FALSE(result.cancelled);
+    CHECK(job.getStats().bytes_written < content.length());
+
+    // An edit once the command is over still tells the output from the text it answers
+    REQUIRE(job.start(*cursor, whole, "cat"));
+    while (job.isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    (void) cursor->insert(u"y");
+    CHECK(job.takeResult().edited);
+
+    // Closing the buffer counts as an edit: the writer never reads it again
+    REQUIRE(job.start(*cursor, whole, "sleep 0.2; cat"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    cursor.reset();
+    result = finish(job);
+    CHECK(result.edited);
+}
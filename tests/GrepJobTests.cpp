@@ -0,0 +1,231 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/GrepJob.h"
+
+
+/** @brief A directory under the system temporary directory, removed with everything in it on destruction. */
+struct ScratchTree final {
+    std::filesystem::path root; ///< The directory.
+
+    ScratchTree()
+        : root(std::filesystem::temp_directory_path() / ("bbloc_grep_" + std::to_string(std::random_device()()))) {
+        std::filesystem::create_directories(root);
+    }
+
+    ~ScratchTree() {
+        auto error_code = std::error_code{};
+        std::filesystem::remove_all(root, error_code);
+    }
+
+    /**
+     * @brief Writes a file, creating its directories.
+     * @param relative The path of the file under the root.
+     * @param bytes The content of the file.
+     */
+    void write(const std::filesystem::path &relative, const std::string_view bytes) const {
+        const auto path = root / relative;
+        std::filesystem::create_directories(path.parent_path());
+        auto ofs = std::ofstream(path, std::ios::out | std::ios::binary);
+        ofs.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    /**
+     * @brief Builds the entry prefix a file gets in the listing.
+     * @param relative The path of the file under the root.
+     * @return The path, as the job lists it.
+     */
+    [[nodiscard]] std::u16string name(const std::filesystem::path &relative) const {
+        return utf8::utf8to16((root / relative).lexically_normal().string());
+    }
+};
+
+/**
+ * @brief Waits for a job to be over, then splits and sorts everything it listed.
+ *
+ * The files come in the order the workers finish them, so the entries are sorted to compare them.
+ *
+ * @param job The job to wait for.
+ * @return The entries, without their newlines.
+ */
+static std::vector<std::u16string> collect(GrepJob &job) {
+    auto output = std::u16string{};
+    while (job.isRunning()) {
+        (void) job.takeOutput(output);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    (void) job.takeOutput(output);
+    job.cancel();
+
+    auto entries = std::vector<std::u16string>{};
+    for (size_t start = 0; start < output.length();) {
+        const auto end = output.find(u'\n', start);
+        REQUIRE(end != std::u16string::npos);
+        entries.emplace_back(output.substr(start, end - start));
+        start = end + 1;
+    }
+    std::ranges::sort(entries);
+    return entries;
+}
+
+
+TEST_CASE("a search lists the matches of every text file under the directory") {
+    const auto tree = ScratchTree();
+    tree.write("a.txt", "alpha\nno\nbeta alpha alpha");
+    tree.write("sub/deep/b.txt", "Alpha\r\nalpha\r\n");
+    tree.write("sub/empty.txt", "");
+    tree.write("sub/none.txt", "nothing to see");
+    tree.write("binary.bin", std::string("alpha\0alpha", 11));
+    tree.write("latin1.txt", "alpha \xE9t\xE9");
+    tree.write(".hidden/c.txt", "alpha");
+    tree.write("sub/.dotfile", "alpha");
+
+    auto job = GrepJob();
+    for (const auto thread_count : {1u, 4u}) {
+        CAPTURE(thread_count);
+        job.start(tree.root, u"alpha", true, false, thread_count);
+        const auto entries = collect(job);
+
+        auto expected = std::vector<std::u16string>{
+            tree.name("a.txt") + u":1:1: alpha",
+            tree.name("a.txt") + u":3:6: beta alpha alpha",
+            tree.name("a.txt") + u":3:12: beta alpha alpha",
+            tree.name("sub/deep/b.txt") + u":2:1: alpha",
+            tree.name("sub/.dotfile") + u":1:1: alpha",
+        };
+        std::ranges::sort(expected);
+        CHECK(entries == expected);
+
+        const auto stats = job.getStats();
+        CHECK(stats.match_count == 5);
+        CHECK(stats.files_matched == 3);
+        CHECK(stats.files_scanned == 5);
+        CHECK(stats.files_skipped == 2);
+        CHECK_FALSE(job.isStarted());
+    }
+}
+
+TEST_CASE("a search folds case and runs patterns like the buffer search") {
+    const auto tree = ScratchTree();
+    tree.write("a.txt", "ALPHA 12\nalpha\nGamma 7");
+    tree.write("b.txt", "caf\xC3\xA9 Alpha");
+
+    auto job = GrepJob();
+    job.start(tree.root, u"alpha", false, false, 2);
+    CHECK(collect(job) == std::vector<std::u16string>{
+        tree.name("a.txt") + u":1:1: ALPHA 12",
+        tree.name("a.txt") + u":2:1: alpha",
+        tree.name("b.txt") + u":1:6: café Alpha",
+    });
+
+    // A prefix that is not in the bytes, and no prefix at all
+    job.start(tree.root, u"al?pha [0-9]+", false, true, 2);
+    CHECK(collect(job) == std::vector<std::u16string>{ tree.name("a.txt") + u":1:1: ALPHA 12" });
+
+    job.start(tree.root, u"[0-9]+", false, true, 2);
+    CHECK(collect(job) == std::vector<std::u16string>{
+        tree.name("a.txt") + u":1:7: ALPHA 12",
+        tree.name("a.txt") + u":3:7: Gamma 7",
+    });
+
+    // A non-ASCII term is not pre-filtered
+    job.start(tree.root, u"é", true, false, 2);
+    CHECK(collect(job) == std::vector<std::u16string>{ tree.name("b.txt") + u":1:4: café Alpha" });
+
+    job.start(tree.root, u"CAFÉ", false, false, 2);
+    CHECK(collect(job) == std::vector<std::u16string>{ tree.name("b.txt") + u":1:1: café Alpha" });
+
+    // Neither is an ASCII term a non-ASCII character folds into: the Kelvin sign is a k
+    tree.write("c.txt", "\xE2\x84\xAA" "elvin");
+    job.start(tree.root, u"kelvin", false, false, 2);
+    CHECK(collect(job) == std::vector<std::u16string>{ tree.name("c.txt") + u":1:1: \u212Aelvin" });
+}
+
+TEST_CASE("a search caps the matches of a file and the text of an entry") {
+    const auto tree = ScratchTree();
+    tree.write("many.txt", std::string(GrepJob::MAX_MATCHES_PER_FILE + 10, 'x'));
+    tree.write("long.txt", "y" + std::string(GrepJob::MAX_ENTRY_TEXT * 2, '-'));
+
+    auto job = GrepJob();
+    job.start(tree.root, u"x", true, false, 2);
+    CHECK(collect(job).size() == GrepJob::MAX_MATCHES_PER_FILE);
+
+    job.start(tree.root, u"y", true, false, 2);
+    const auto entries = collect(job);
+    REQUIRE(entries.size() == 1);
+    CHECK(entries[0] == tree.name("long.txt") + u":1:1: y" + std::u16string(GrepJob::MAX_ENTRY_TEXT - 1, u'-'));
+}
+
+TEST_CASE("a search reads a large file by chunks without losing what straddles them") {
+    // A two-byte character across the first chunk boundary, the needle across the second
+    auto bytes = std::string(GrepJob::CHUNK_BYTES - 1, 'a');
+    bytes.append("\xc3\xa9");
+    bytes.append(2 * GrepJob::CHUNK_BYTES - 3 - bytes.length(), 'b');
+    bytes.append("needle\n");
+    for (auto line = 0; line < 3 * static_cast<int>(GrepJob::CHUNK_LINES); ++line) {
+        bytes.append(line % 1000 == 999 ? "another needle\n" : "filler\n");
+    }
+
+    const auto tree = ScratchTree();
+    tree.write("large.txt", bytes);
+    tree.write("invalid.txt", std::string(GrepJob::CHUNK_BYTES + 7, 'c').append("\xc3needle"));
+
+    auto job = GrepJob();
+    job.start(tree.root, u"needle", true, false, 2);
+    const auto entries = collect(job);
+    REQUIRE(entries.size() == 50);
+    // The two-byte character is one code unit: the needle sits one column before its byte offset
+    const auto first = tree.name("large.txt") + u":1:" + utf8::utf8to16(std::to_string(2 * GrepJob::CHUNK_BYTES - 3)) + u": ";
+    CHECK(std::ranges::any_of(entries, [&](const std::u16string &entry) { return entry.starts_with(first); }));
+    CHECK(job.getStats().files_matched == 1);
+    CHECK(job.getStats().files_skipped == 1);
+}
+
+TEST_CASE("a cancelled search stops, and the job can start again") {
+    const auto tree = ScratchTree();
+    for (auto file = 0; file < 200; ++file) {
+        tree.write("dir" + std::to_string(file % 10) + "/f" + std::to_string(file) + ".txt", "needle\n");
+    }
+
+    auto job = GrepJob();
+    job.start(tree.root, u"needle", true, false, 4);
+    CHECK(job.isStarted());
+    job.cancel();
+    CHECK_FALSE(job.isRunning());
+    CHECK_FALSE(job.isStarted());
+    CHECK(job.getStats().match_count <= 200);
+
+    job.start(tree.root, u"needle", true, false, 4);
+    CHECK(collect(job).size() == 200);
+    CHECK(job.getStats().files_matched == 200);
+
+    // Not a directory: the walk ends at once
+    job.start(tree.root / "missing", u"needle", true, false, 4);
+    CHECK(collect(job).empty());
+}
@@ -0,0 +1,109 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/cursor/LineCounts.h"
+
+
+/**
+ * @brief Checks every lookup of the counts against a plain vector of them.
+ * @param counts The counts under test.
+ * @param model The expected count of every line.
+ */
+static void checkCounts(const LineCounts &counts, const std::vector<uint32_t> &model) {
+    REQUIRE(counts.size() == model.size());
+
+    auto sum = 0u;
+    for (uint32_t line = 0; line < model.size(); ++line) {
+        CAPTURE(line);
+        CHECK(counts.prefix(line) == sum);
+        CHECK(counts.get(line) == model[line]);
+        for (auto unit = 0u; unit < model[line]; ++unit) {
+            CHECK(counts.lineOf(sum + unit) == line);
+        }
+        sum += model[line];
+    }
+    CHECK(counts.prefix(static_cast<uint32_t>(model.size())) == sum);
+    CHECK(counts.lineOf(sum) == model.size());
+}
+
+
+TEST_CASE("line counts follow random insertions, erasures and updates across blocks") {
+    auto random = std::mt19937(0x62626c6f);
+    auto counts = LineCounts{};
+    auto model = std::vector<uint32_t>(LineCounts::BLOCK_LINES * 3 + 17, 0);
+    counts.assign(static_cast<uint32_t>(model.size()));
+    for (uint32_t line = 0; line < model.size(); line += 5) {
+        model[line] = line % 3;
+        counts.add(line, line % 3);
+    }
+    checkCounts(counts, model);
+
+    for (auto step = 0; step < 200; ++step) {
+        CAPTURE(step);
+        const auto line = static_cast<uint32_t>(random() % (model.size() + 1));
+        // Mostly a few lines, sometimes more than a block
+        const auto span = static_cast<uint32_t>(random() % 8 == 0 ? random() % (LineCounts::BLOCK_LINES * 3) : random() % 4 + 1);
+        switch (random() % 4) {
+            case 0:
+                counts.insert(line, span);
+                model.insert(model.begin() + line, span, 0u);
+                break;
+            case 1: {
+                const auto erased = std::min<uint32_t>(span, static_cast<uint32_t>(model.size()) - line);
+                counts.erase(line, erased);
+                model.erase(model.begin() + line, model.begin() + line + erased);
+                break;
+            }
+            case 2: {
+                const auto end = std::min<uint32_t>(line + span, static_cast<uint32_t>(model.size()));
+                counts.zero(line, end);
+                std::fill(model.begin() + line, model.begin() + end, 0u);
+                break;
+            }
+            default:
+                if (line < model.size()) {
+                    const auto delta = static_cast<uint32_t>(random() % 5);
+                    counts.add(line, delta);
+                    model[line] += delta;
+                }
+                break;
+        }
+
+        if (step % 20 == 0) {
+            checkCounts(counts, model);
+        }
+        CHECK(counts.prefix(static_cast<uint32_t>(model.size())) == std::accumulate(model.begin(), model.end(), 0u));
+    }
+    checkCounts(counts, model);
+
+    // Erasing everything leaves an empty set the next lines go into
+    counts.erase(0, counts.size());
+    model.clear();
+    checkCounts(counts, model);
+    counts.insert(0, 3);
+    counts.add(2, 4);
+    CHECK(counts.lineOf(3) == 2);
+    CHECK(counts.prefix(3) == 4);
+}
@@ -17,6 +17,7 @@
  * along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "TestSupport.h"
@@ -217,20 +218,38 @@ TEST_CASE("isSelfOverlapping runs on the folded term") {
     CHECK(!LineScanner(u"aA", true).isSelfOverlapping());
 }
 
-TEST_CASE("the fold is ASCII-only, with A and Z inside it and their neighbours outside") {
-    SUBCASE("accented letters never fold") {
+TEST_CASE("the fold covers the Unicode letters, with A and Z inside it and their neighbours outside") {
+    SUBCASE("accented letters fold") {
         auto scanner = LineScanner(u"É", false);
-        scanner.setLine(u"é");
-        CHECK(scanner.indexOf(0) == std::u16string_view::npos);
+        scanner.setLine(u"e é");
+        CHECK(scanner.indexOf(0) == 2);
+
+        CHECK(LineScanner(u"Àà", false).isSelfOverlapping());
+        CHECK(!LineScanner(u"Àà", true).isSelfOverlapping());
+    }
+
+    SUBCASE("Cyrillic and Greek letters fold, final sigma included") {
+        auto cyrillic_scanner = LineScanner(u"ПРИВЕТ", false);
+        cyrillic_scanner.setLine(u"Скажи привет");
+        CHECK(cyrillic_scanner.indexOf(0) == 6);
+
+        auto greek_scanner = LineScanner(u"ΛΟΓΟΣ", false);
+        greek_scanner.setLine(u"ο λόγος, ο λογος");
+        CHECK(greek_scanner.indexOf(0) == 11);
+    }
 
-        CHECK(!LineScanner(u"Àà", false).isSelfOverlapping());
-        CHECK(LineScanner(u"ÀÀ", false).isSelfOverlapping());
+    SUBCASE("characters outside ASCII may fold into it") {
+        // The Kelvin sign folds to k, the long s to s
+        auto scanner = LineScanner(u"ks", false);
+        scanner.setLine(u"\u212A\u017F");
+        CHECK(scanner.indexOf(0) == 0);
+        CHECK(scanner.lastIndexOf(2) == 0);
     }
 
-    SUBCASE("fullwidth letters never fold") {
+    SUBCASE("fullwidth letters fold among themselves only") {
         auto scanner = LineScanner(u"Ａ", false);
-        scanner.setLine(u"ａa");
-        CHECK(scanner.indexOf(0) == std::u16string_view::npos);
+        scanner.setLine(u"aａ");
+        CHECK(scanner.indexOf(0) == 1);
     }
 
     SUBCASE("the range boundaries hold") {
@@ -316,6 +335,25 @@ TEST_CASE("indexOf starts exactly at its from offset") {
     CHECK(overlapping.indexOf(3) == std::u16string_view::npos);
 }
 
+TEST_CASE("isMatchAt checks one position from an offset, folding when asked to") {
+    auto scanner = LineScanner(u"abc", false);
+    scanner.setLine(u"xABcab");
+
+    CHECK(scanner.isMatchAt(1, 0));
+    CHECK_FALSE(scanner.isMatchAt(0, 0));
+
+    // The units before the offset are taken as matching; only the others are compared
+    CHECK(scanner.isMatchAt(1, 2));
+    CHECK_FALSE(scanner.isMatchAt(4, 0));
+    CHECK_FALSE(scanner.isMatchAt(4, 2));
+    CHECK_FALSE(scanner.isMatchAt(7, 0));
+
+    auto exact = LineScanner(u"abc", true);
+    exact.setLine(u"xABcab");
+    CHECK_FALSE(exact.isMatchAt(1, 0));
+    CHECK(exact.isMatchAt(1, 2));
+}
+
 TEST_CASE("one scanner scans many lines in turn") {
     // searchForward walks a stateful scanner down the buffer, so a stale folded scratch would leak
     // one line's matches into the next
@@ -432,3 +470,113 @@ TEST_CASE("self-overlap agrees with building a witness of two overlapping occurr
     CHECK(forEachString(u"ab", 6, check_term) == 127);
     CHECK(forEachString(u"abA", 4, check_term) == 121);
 }
+
+/**
+ * @brief Lists the matches a line-by-line indexOf walk finds from a position, resuming past each.
+ *
+ * @param cursor The cursor whose buffer is scanned.
+ * @param scanner The scanner to walk with.
+ * @param startLine The line to start from.
+ * @param startColumn The column to start from on the first line.
+ * @return The line and column of every match, in text order.
+ */
+static std::vector<std::pair<uint32_t, uint32_t>> walkMatches(const Cursor &cursor, LineScanner &scanner, const uint32_t startLine, const uint32_t startColumn) {
+    auto matches = std::vector<std::pair<uint32_t, uint32_t>>{};
+    for (auto line = startLine; line < cursor.getLineCount(); ++line) {
+        scanner.setLine(cursor.getString(line));
+        for (auto position = scanner.indexOf(line == startLine ? startColumn : 0); position != std::u16string_view::npos; position = scanner.indexOf(scanner.nextFrom(position))) {
+            matches.emplace_back(line, static_cast<uint32_t>(position));
+        }
+    }
+
+    return matches;
+}
+
+TEST_CASE("forEachMatch finds what a line-by-line walk finds, across the detached line too") {
+    // Lines are stored back to back with no separator, so "ab" split over "xa" and "bx" must not
+    // match; the edit detaches line 3, splitting the storage in two runs
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"xa\nbx\nABab\naAb\n\naba\nb\nAb ab aB\nxa\nb");
+    cursor.setPosition(3, 0);
+    (void) cursor.insert(u"a");
+    REQUIRE(cursor.getContiguousLineCount(0) == 3);
+    REQUIRE(cursor.getContiguousLineCount(3) == 1);
+
+    for (const auto term : { u"ab", u"a", u"b", u"aba", u"xab" }) {
+        for (const auto case_sensitive : { false, true }) {
+            auto scanner = LineScanner(term, case_sensitive);
+            for (uint32_t start_line = 0; start_line < cursor.getLineCount(); ++start_line) {
+                for (uint32_t start_column = 0; start_column <= cursor.getString(start_line).length() + 1; ++start_column) {
+                    auto found = std::vector<std::pair<uint32_t, uint32_t>>{};
+                    scanner.forEachMatch(cursor, start_line, start_column, [&found](const uint32_t line, const uint32_t column) {
+                        found.emplace_back(line, column);
+                        return true;
+                    });
+
+                    CAPTURE(ascii(term));
+                    CAPTURE(case_sensitive);
+                    CAPTURE(start_line);
+                    CAPTURE(start_column);
+                    CHECK(found == walkMatches(cursor, scanner, start_line, start_column));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("a regex scanner finds what a line-by-line walk finds, with or without a prefix") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"xa\nbx\nABab\naAb\n\naba\nb\nAb ab aB\nxa\nb");
+    cursor.setPosition(3, 0);
+    (void) cursor.insert(u"a");
+
+    for (const auto pattern : { u"ab+", u"a[ab]*", u"[ab]b", u"b$", u"^a|x", u"a?" }) {
+        for (const auto case_sensitive : { false, true }) {
+            auto scanner = LineScanner(std::make_shared<Regex>(pattern, case_sensitive));
+            REQUIRE(scanner.getRegex()->isValid());
+            for (uint32_t start_line = 0; start_line < cursor.getLineCount(); ++start_line) {
+                for (uint32_t start_column = 0; start_column <= cursor.getString(start_line).length(); ++start_column) {
+                    auto found = std::vector<std::pair<uint32_t, uint32_t>>{};
+                    scanner.forEachMatch(cursor, start_line, start_column, [&found](const uint32_t line, const uint32_t column) {
+                        found.emplace_back(line, column);
+                        return true;
+                    });
+
+                    CAPTURE(ascii(pattern));
+                    CAPTURE(case_sensitive);
+                    CAPTURE(start_line);
+                    CAPTURE(start_column);
+                    CHECK(found == walkMatches(cursor, scanner, start_line, start_column));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("a regex scanner reports the length of each match") {
+    auto scanner = LineScanner(std::make_shared<Regex>(u"ERROR [0-9]+", true));
+    scanner.setLine(u"ok ERROR 42, ERROR 7");
+
+    CHECK(scanner.indexOf(0) == 3);
+    CHECK(scanner.matchLength() == 8);
+    CHECK(scanner.nextFrom(3) == 11);
+    CHECK(scanner.indexOf(11) == 13);
+    CHECK(scanner.matchLength() == 7);
+    CHECK(scanner.lastIndexOf(13) == 3);
+    CHECK(scanner.matchLength() == 8);
+    CHECK(scanner.isSelfOverlapping());
+}
+
+TEST_CASE("forEachMatch stops when the visitor returns false") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"ab ab\nab");
+
+    auto visits = 0;
+    LineScanner(u"ab", true).forEachMatch(cursor, 0, 1, [&visits](const uint32_t line, const uint32_t column) {
+        ++visits;
+        CHECK(line == 0);
+        CHECK(column == 3);
+        return false;
+    });
+    CHECK(visits == 1);
+}
@@ -0,0 +1,214 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/cursor/LineTransform.h"
+
+
+/**
+ * @brief Rewrites the lines of a model the obvious way, one thread and no views.
+ *
+ * @param model The lines to rewrite.
+ * @param kind The rewrite to apply.
+ * @return The rewritten lines.
+ */
+static BufferModel rewrite(BufferModel model, const LineTransform::Kind kind) {
+    switch (kind) {
+        case LineTransform::Kind::Sort:
+            std::ranges::stable_sort(model);
+            break;
+        case LineTransform::Kind::SortNumeric:
+            std::ranges::stable_sort(model, [](const std::u16string &left, const std::u16string &right) {
+                const auto left_number = LineTransform::leadingNumber(left);
+                const auto right_number = LineTransform::leadingNumber(right);
+                return right_number && (!left_number || *left_number < *right_number);
+            });
+            break;
+        case LineTransform::Kind::Unique: {
+            auto seen = std::unordered_set<std::u16string>{};
+            std::erase_if(model, [&seen](const std::u16string &line) { return !seen.insert(line).second; });
+            break;
+        }
+        case LineTransform::Kind::Reverse:
+            std::ranges::reverse(model);
+            break;
+        case LineTransform::Kind::Trim:
+            for (auto &line : model) {
+                while (!line.empty() && (line.back() == u' ' || line.back() == u'\t')) {
+                    line.pop_back();
+                }
+            }
+            break;
+    }
+    return model;
+}
+
+/** @brief Copies views into a model, to compare them by value. */
+static BufferModel toModel(const std::vector<std::u16string_view> &lines) {
+    return BufferModel(lines.begin(), lines.end());
+}
+
+
+TEST_CASE("leadingNumber reads the number a line starts with") {
+    CHECK(LineTransform::leadingNumber(u"42") == 42.0);
+    CHECK(LineTransform::leadingNumber(u"  \t-7 apples") == -7.0);
+    CHECK(LineTransform::leadingNumber(u"+3.25;") == 3.25);
+    CHECK(LineTransform::leadingNumber(u"007") == 7.0);
+    CHECK(LineTransform::leadingNumber(u"12.") == 12.0);
+    CHECK(LineTransform::leadingNumber(u"-.5") == -0.5);
+
+    CHECK_FALSE(LineTransform::leadingNumber(u"").has_value());
+    CHECK_FALSE(LineTransform::leadingNumber(u"   ").has_value());
+    CHECK_FALSE(LineTransform::leadingNumber(u"x12").has_value());
+    CHECK_FALSE(LineTransform::leadingNumber(u"-").has_value());
+    CHECK_FALSE(LineTransform::leadingNumber(u"-.").has_value());
+
+    // Past the range of a double, the sign and the integer part still order the lines
+    const auto huge = std::u16string(400, u'9');
+    CHECK(*LineTransform::leadingNumber(huge) > 1e300);
+    CHECK(*LineTransform::leadingNumber(u"-" + huge) < -1e300);
+    CHECK(LineTransform::leadingNumber(u"0." + std::u16string(400, u'0') + u"1") == 0.0);
+}
+
+TEST_CASE("transform rewrites the lines") {
+    const auto lines = std::vector<std::u16string_view>{ u"b 10", u"a", u"10 b", u"b 10", u"-2.5 x  ", u"\t", u"9 c" };
+    const auto transform = [&lines](const LineTransform::Kind kind) {
+        return toModel(LineTransform::transform(lines, kind, 1));
+    };
+
+    CHECK(transform(LineTransform::Kind::Sort) == BufferModel{ u"\t", u"-2.5 x  ", u"10 b", u"9 c", u"a", u"b 10", u"b 10" });
+    CHECK(transform(LineTransform::Kind::SortNumeric) == BufferModel{ u"b 10", u"a", u"b 10", u"\t", u"-2.5 x  ", u"9 c", u"10 b" });
+    CHECK(transform(LineTransform::Kind::Unique) == BufferModel{ u"b 10", u"a", u"10 b", u"-2.5 x  ", u"\t", u"9 c" });
+    CHECK(transform(LineTransform::Kind::Reverse) == BufferModel{ u"9 c", u"\t", u"-2.5 x  ", u"b 10", u"10 b", u"a", u"b 10" });
+    CHECK(transform(LineTransform::Kind::Trim) == BufferModel{ u"b 10", u"a", u"10 b", u"b 10", u"-2.5 x", u"", u"9 c" });
+}
+
+TEST_CASE("sorting on several threads gives the order of a stable sort") {
+    // Few distinct keys, so equal ones are everywhere and a merge that broke their order would show
+    auto random = std::mt19937(0x736f7274);
+    auto storage = BufferModel{};
+    for (auto line = 0u; line < LineTransform::SLICE_LINES * 5 + 123; ++line) {
+        auto text = std::u16string(1, static_cast<char16_t>(u'0' + random() % 10));
+        text.append(u" #").append(std::u16string(1 + random() % 3, u'a' + static_cast<char16_t>(random() % 3)));
+        storage.push_back(text);
+    }
+    const auto lines = std::vector<std::u16string_view>(storage.begin(), storage.end());
+
+    for (const auto kind : { LineTransform::Kind::Sort, LineTransform::Kind::SortNumeric }) {
+        const auto expected = rewrite(storage, kind);
+        for (const auto threads : { 1u, 2u, 3u, 4u, 8u }) {
+            CAPTURE(static_cast<int>(kind));
+            CAPTURE(threads);
+            const auto sorted = LineTransform::transform(lines, kind, threads);
+            REQUIRE(sorted.size() == lines.size());
+            CHECK(toModel(sorted) == expected);
+
+            // Stable down to the line itself: equal lines come out in the order they went in
+            for (size_t index = 1; index < sorted.size(); ++index) {
+                if (sorted[index - 1] == sorted[index]) {
+                    REQUIRE(sorted[index - 1].data() < sorted[index].data());
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("apply rewrites a run of lines as one undo step and one edit") {
+    auto random = std::mt19937(0x6c696e65);
+    const auto pieces = std::vector<std::u16string_view>{ u"b", u"a", u"1", u"20", u" ", u"\t", u"-3", u"x y" };
+    const auto kinds = std::vector<LineTransform::Kind>{
+        LineTransform::Kind::Sort, LineTransform::Kind::SortNumeric, LineTransform::Kind::Unique,
+        LineTransform::Kind::Reverse, LineTransform::Kind::Trim
+    };
+
+    for (auto round = 0; round < 400; ++round) {
+        auto model = BufferModel{};
+        for (auto line = 1 + random() % 8; line > 0; --line) {
+            auto text = std::u16string{};
+            for (auto piece = random() % 3; piece > 0; --piece) {
+                text.append(pieces[random() % pieces.size()]);
+            }
+            model.push_back(text);
+        }
+        const auto content = joinLines(model);
+        const auto first_line = static_cast<uint32_t>(random() % model.size());
+        const auto last_line = first_line + static_cast<uint32_t>(random() % (model.size() - first_line));
+        const auto kind = kinds[random() % kinds.size()];
+
+        CAPTURE(round);
+        CAPTURE(content);
+        CAPTURE(first_line);
+        CAPTURE(last_line);
+        CAPTURE(static_cast<int>(kind));
+
+        auto expected = BufferModel(model.begin(), model.begin() + first_line);
+        const auto run = rewrite(BufferModel(model.begin() + first_line, model.begin() + last_line + 1), kind);
+        expected.insert(expected.end(), run.begin(), run.end());
+        expected.insert(expected.end(), model.begin() + last_line + 1, model.end());
+
+        auto cursor = Cursor(std::make_unique<LineBuffer>());
+        seed(cursor, content);
+        const auto result = LineTransform::apply(cursor, first_line, last_line, kind, 2);
+        CHECK(cursor.getText() == joinLines(expected));
+        CHECK(result.line_count == run.size());
+        CHECK(result.edit.has_value() == (expected != model));
+        CHECK((result.changed > 0) == (expected != model));
+        if (!result.edit) {
+            CHECK_FALSE(undoStep(cursor));
+            continue;
+        }
+
+        checkEditIsConsistent(*result.edit);
+        CHECK(describes(*result.edit, content, cursor.getText()));
+
+        CHECK(undoStep(cursor));
+        CHECK(cursor.getText() == content);
+        CHECK_FALSE(undoStep(cursor));
+        CHECK(redoStep(cursor));
+        CHECK(cursor.getText() == joinLines(expected));
+    }
+}
+
+TEST_CASE("apply leaves the lines that stay in place out of the edit") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"a\nb\nd\nc\ne\nf");
+
+    const auto result = LineTransform::apply(cursor, 0, 5, LineTransform::Kind::Sort, 1);
+    REQUIRE(result.edit.has_value());
+    CHECK(cursor.getText() == u"a\nb\nc\nd\ne\nf");
+    CHECK(result.changed == 2);
+    CHECK(result.edit->start.line == 2);
+    CHECK(result.edit->start.column == 0);
+    CHECK(result.edit->old_end.line == 3);
+    CHECK(result.edit->old_end.column == 1);
+
+    // Already sorted: nothing to record
+    CHECK_FALSE(LineTransform::apply(cursor, 0, 5, LineTransform::Kind::Sort, 1).edit.has_value());
+    CHECK(undoStep(cursor));
+    CHECK(cursor.getText() == u"a\nb\nd\nc\ne\nf");
+}
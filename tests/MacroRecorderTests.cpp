@@ -0,0 +1,138 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/MacroRecorder.h"
+
+
+/**
+ * @brief Drains a playback, listing the text of each step handed over.
+ *
+ * @param recorder The recorder, playing.
+ * @return The text of the Command and Line steps, the input of the Text steps, and "key" for the others.
+ */
+static std::vector<std::string> drain(MacroRecorder &recorder) {
+    auto played = std::vector<std::string>{};
+    while (const auto *const step = recorder.nextStep()) {
+        switch (step->type) {
+            case MacroRecorder::StepType::Key:
+                played.emplace_back("key");
+            break;
+            case MacroRecorder::StepType::Text:
+                played.emplace_back(step->input);
+            break;
+            case MacroRecorder::StepType::Command:
+            case MacroRecorder::StepType::Line:
+                played.emplace_back(utf8::utf16to8(step->text));
+            break;
+        }
+    }
+    return played;
+}
+
+
+TEST_CASE("nothing is recorded outside a recording") {
+    auto recorder = MacroRecorder();
+    recorder.recordText("a");
+    recorder.recordCommand(u"move down");
+
+    CHECK(recorder.getState() == MacroRecorder::State::Idle);
+    CHECK(recorder.getStepCount() == 0);
+    CHECK_FALSE(recorder.stopRecording());
+    CHECK_FALSE(recorder.startPlayback(1));
+}
+
+TEST_CASE("a recording merges typed text and replays its steps in order") {
+    auto recorder = MacroRecorder();
+    REQUIRE(recorder.startRecording());
+    CHECK_FALSE(recorder.startRecording());
+    recorder.recordCommand(u"move bol");
+    recorder.recordText("h");
+    recorder.recordText("i");
+    recorder.recordKey(13, 0);
+    recorder.recordText("!");
+    recorder.recordLine(u"goto_line 3");
+
+    // The steps only become the macro once stopped
+    CHECK(recorder.getStepCount() == 0);
+    REQUIRE(recorder.stopRecording());
+    CHECK(recorder.getStepCount() == 5);
+
+    REQUIRE(recorder.startPlayback(2));
+    CHECK(recorder.isPlaying());
+    CHECK(drain(recorder) == std::vector<std::string>{
+        "move bol", "hi", "key", "!", "goto_line 3",
+        "move bol", "hi", "key", "!", "goto_line 3"
+    });
+    CHECK_FALSE(recorder.isPlaying());
+    CHECK(recorder.getPlayedCount() == 2);
+    CHECK(recorder.getPlayedStepCount() == 10);
+
+    // The macro stays, for the next playback
+    REQUIRE(recorder.startPlayback(1));
+    CHECK(drain(recorder).size() == 5);
+}
+
+TEST_CASE("a new recording replaces the macro only once stopped") {
+    auto recorder = MacroRecorder();
+    REQUIRE(recorder.startRecording());
+    recorder.recordText("old");
+    REQUIRE(recorder.stopRecording());
+
+    REQUIRE(recorder.startRecording());
+    recorder.recordText("new");
+    recorder.recordCommand(u"move down");
+    CHECK(recorder.getStepCount() == 1);
+    CHECK_FALSE(recorder.startPlayback(1));
+
+    REQUIRE(recorder.stopRecording());
+    REQUIRE(recorder.startPlayback(1));
+    CHECK(drain(recorder) == std::vector<std::string>{"new", "move down"});
+}
+
+TEST_CASE("a playback counts its progress and stops where asked") {
+    auto recorder = MacroRecorder();
+    REQUIRE(recorder.startRecording());
+    recorder.recordCommand(u"move down");
+    recorder.recordText("x");
+    REQUIRE(recorder.stopRecording());
+
+    CHECK_FALSE(recorder.startPlayback(0));
+    REQUIRE(recorder.startPlayback(1000));
+    CHECK_FALSE(recorder.startPlayback(1));
+    CHECK_FALSE(recorder.startRecording());
+
+    for (auto step = 0; step < 7; ++step) {
+        REQUIRE(recorder.nextStep() != nullptr);
+    }
+    CHECK(recorder.getPlayedCount() == 3);
+    CHECK(recorder.getPlayedStepCount() == 7);
+
+    // Nothing is played past a stop, and the next playback starts over
+    recorder.stopPlayback();
+    CHECK_FALSE(recorder.isPlaying());
+    CHECK(recorder.nextStep() == nullptr);
+    CHECK(recorder.getPlayCount() == 1000);
+    REQUIRE(recorder.startPlayback(MacroRecorder::MAX_PLAY_COUNT + 1));
+    CHECK(recorder.getPlayCount() == MacroRecorder::MAX_PLAY_COUNT);
+    CHECK(recorder.getPlayedStepCount() == 0);
+}
@@ -0,0 +1,485 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/cursor/MatchIndex.h"
+
+
+/**
+ * @brief Counts the non-overlapping matches on every line the obvious way.
+ *
+ * @param cursor The cursor whose buffer is scanned.
+ * @param term The term to look for.
+ * @param caseSensitive Whether the comparison is case-sensitive.
+ * @return The per-line counts.
+ */
+static std::vector<uint32_t> countLines(const Cursor &cursor, const std::u16string_view term, const bool caseSensitive) {
+    auto counts = std::vector<uint32_t>(cursor.getLineCount(), 0);
+    auto scanner = LineScanner(term, caseSensitive);
+    for (uint32_t line = 0; line < cursor.getLineCount(); ++line) {
+        scanner.setLine(cursor.getString(line));
+        for (auto position = scanner.indexOf(0); position != std::u16string_view::npos; position = scanner.indexOf(position + term.length())) {
+            ++counts[line];
+        }
+    }
+
+    return counts;
+}
+
+/**
+ * @brief Checks every lookup of the index against a fresh count of the buffer.
+ *
+ * A lookup finding most of the buffer dirty starts counting it over, so the count is run to
+ * completion first.
+ *
+ * @param index The index under test.
+ * @param cursor The cursor it indexes.
+ * @param term The indexed term.
+ * @param caseSensitive The indexed mode.
+ */
+static void checkIndex(MatchIndex &index, const Cursor &cursor, const std::u16string_view term, const bool caseSensitive) {
+    (void) index.rank(cursor, 0, 0);
+    while (index.step(cursor, 3)) {}
+
+    const auto counts = countLines(cursor, term, caseSensitive);
+    auto total = 0;
+    for (const auto count : counts) {
+        total += static_cast<int32_t>(count);
+    }
+
+    auto before = 0;
+    for (uint32_t line = 0; line < cursor.getLineCount(); ++line) {
+        CAPTURE(line);
+        const auto rank = index.rank(cursor, line, 0);
+        CHECK(rank.total == total);
+        CHECK(rank.before == before);
+
+        auto next = std::optional<uint32_t>{};
+        for (auto later = line + 1; later < counts.size() && !next; ++later) {
+            if (counts[later] > 0) {
+                next = later;
+            }
+        }
+        CHECK(index.nextLineWithMatch(cursor, line) == next);
+
+        auto previous = std::optional<uint32_t>{};
+        for (auto earlier = line; earlier-- > 0 && !previous;) {
+            if (counts[earlier] > 0) {
+                previous = earlier;
+            }
+        }
+        CHECK(index.previousLineWithMatch(cursor, line) == previous);
+
+        before += static_cast<int32_t>(counts[line]);
+    }
+}
+
+
+TEST_CASE("rank places a position among the matches of its line and of the lines before") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"ab ab\n\nxab\nAB");
+
+    auto index = MatchIndex{};
+    index.build(cursor, u"ab", true);
+
+    const auto on_match = index.rank(cursor, 0, 3);
+    CHECK(on_match.index == 1);
+    CHECK(on_match.before == 1);
+    CHECK(on_match.total == 3);
+
+    const auto between = index.rank(cursor, 0, 2);
+    CHECK(between.index == -1);
+    CHECK(between.before == 1);
+
+    const auto next_line = index.rank(cursor, 2, 1);
+    CHECK(next_line.index == 2);
+    CHECK(next_line.before == 2);
+
+    // The case-insensitive index counts the last line too
+    index.build(cursor, u"ab", false);
+    CHECK(index.rank(cursor, 3, 0).index == 3);
+    CHECK(index.rank(cursor, 3, 0).total == 4);
+}
+
+TEST_CASE("the index is reused only for the same term and mode") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"abc");
+
+    auto index = MatchIndex{};
+    CHECK(!index.isBuiltFor(u"ab", true));
+
+    index.build(cursor, u"ab", true);
+    CHECK(index.isBuiltFor(u"ab", true));
+    CHECK(!index.isBuiltFor(u"ab", false));
+    CHECK(!index.isBuiltFor(u"abc", true));
+
+    index.clear();
+    CHECK(!index.isBuiltFor(u"ab", true));
+    CHECK(index.getMemoryUsage() == 0);
+}
+
+TEST_CASE("the index follows random edits, one at a time and in undo batches") {
+    // Typing, line splits and joins, pastes of several lines and whole-selection erases, over an
+    // alphabet dense in matches of "ab" and "aba"; after every edit the lookups must agree with a
+    // fresh count, and the same after every undo and redo, whose edits reach the index only once
+    // the cursor applied all of them
+    auto random = std::mt19937(0x62626c6f);
+    const auto pieces = std::vector<std::u16string_view> { u"a", u"b", u"ab", u"A", u"\n", u"ab\nab", u"x\n\nba\n" };
+
+    for (const auto term : { std::u16string_view(u"ab"), std::u16string_view(u"aba") }) {
+        for (const auto case_sensitive : { false, true }) {
+            CAPTURE(case_sensitive);
+            auto cursor = Cursor(std::make_unique<LineBuffer>());
+            seed(cursor, u"ab\nxx ab aB\n\nabab\nb\naba");
+
+            auto index = MatchIndex{};
+            index.build(cursor, term, case_sensitive);
+            checkIndex(index, cursor, term, case_sensitive);
+
+            for (auto step = 0; step < 60; ++step) {
+                CAPTURE(step);
+                const auto line = static_cast<uint32_t>(random() % cursor.getLineCount());
+                const auto column = static_cast<uint32_t>(random() % (cursor.getString(line).length() + 1));
+                cursor.setPosition(line, column);
+                cursor.moveToStartOfLine();
+                cursor.setPosition(line, column);
+
+                switch (random() % 4) {
+                    case 0:
+                    case 1:
+                        index.edit(cursor.insert(pieces[random() % pieces.size()]));
+                        break;
+                    case 2:
+                        if (const auto edit = cursor.eraseLeft()) {
+                            index.edit(*edit);
+                        }
+                        break;
+                    default: {
+                        const auto end_line = std::min(line + static_cast<uint32_t>(random() % 3), cursor.getLineCount() - 1);
+                        cursor.activateSelection(true);
+                        cursor.setPosition(end_line, static_cast<uint32_t>(cursor.getString(end_line).length()));
+                        if (const auto edit = cursor.eraseSelection()) {
+                            index.edit(*edit);
+                        }
+                        cursor.activateSelection(false);
+                        break;
+                    }
+                }
+                checkIndex(index, cursor, term, case_sensitive);
+            }
+
+            for (auto step = 0; step < 20; ++step) {
+                CAPTURE(step);
+                index.edit(cursor.undo());
+                checkIndex(index, cursor, term, case_sensitive);
+            }
+            for (auto step = 0; step < 20; ++step) {
+                CAPTURE(step);
+                index.edit(cursor.redo());
+                checkIndex(index, cursor, term, case_sensitive);
+            }
+        }
+    }
+}
+
+TEST_CASE("a run of edits recorded at once shifts the counts like the edits one by one") {
+    // Runs of edits far apart and close together, adding and removing lines, recorded after the
+    // cursor applied all of them, over a buffer spanning several blocks of LineCounts
+    auto random = std::mt19937(0x62626c6f);
+    const auto pieces = std::vector<std::u16string_view> { u"ab", u"\n", u"ab\nab\n", u"x\n\nab\n" };
+
+    auto text = std::u16string{};
+    for (auto line = 0u; line < LineCounts::BLOCK_LINES * 3; ++line) {
+        text.append(line % 7 == 0 ? u"ab ab\n" : u"x\n");
+    }
+
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, text);
+
+    auto index = MatchIndex{};
+    index.build(cursor, u"ab", true);
+    for (auto step = 0; step < 12; ++step) {
+        CAPTURE(step);
+        auto edits = std::vector<BufferEdit>{};
+        for (auto count = random() % 4 + 1; count > 0; --count) {
+            const auto line = static_cast<uint32_t>(random() % cursor.getLineCount());
+            cursor.setPosition(line, 0);
+            if (random() % 2 == 0) {
+                edits.push_back(cursor.insert(pieces[random() % pieces.size()]));
+            } else {
+                const auto end_line = std::min(line + static_cast<uint32_t>(random() % 5), cursor.getLineCount() - 1);
+                cursor.activateSelection(true);
+                cursor.setPosition(end_line, static_cast<uint32_t>(cursor.getString(end_line).length()));
+                if (const auto edit = cursor.eraseSelection()) {
+                    edits.push_back(*edit);
+                }
+                cursor.activateSelection(false);
+            }
+        }
+
+        // Edits far apart dirty most of the buffer, which is then counted again
+        index.edit(edits);
+        (void) index.rank(cursor, 0, 0);
+        while (index.step(cursor, LineCounts::BLOCK_LINES)) {}
+
+        const auto counts = countLines(cursor, u"ab", true);
+        auto total = 0u;
+        for (const auto count : counts) {
+            total += count;
+        }
+        CHECK(index.rank(cursor, 0, 0).total == static_cast<int32_t>(total));
+        CHECK(index.rank(cursor, cursor.getLineCount() - 1, 0).before == static_cast<int32_t>(total - counts.back()));
+    }
+    checkIndex(index, cursor, u"ab", true);
+}
+
+TEST_CASE("loading new content rebuilds the index through its edits") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"ab\nab\nab");
+
+    auto index = MatchIndex{};
+    index.build(cursor, u"ab", true);
+    for (const auto &edit : cursor.loadContent(u"xx\nab ab\n\n\nab")) {
+        index.edit(edit);
+    }
+
+    // The lookup finds most of the buffer dirty and starts counting it over
+    CHECK(index.rank(cursor, 0, 0).total == 0);
+    CHECK(index.isCounting());
+    while (index.step(cursor, 2)) {}
+
+    checkIndex(index, cursor, u"ab", true);
+}
+
+TEST_CASE("a count run in steps gives exact figures for the lines it counted") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    auto text = std::u16string{};
+    for (auto line = 0; line < 40; ++line) {
+        text.append(line % 3 == 0 ? u"ab ab\n" : u"xx\n");
+    }
+    seed(cursor, text);
+    const auto counts = countLines(cursor, u"ab", true);
+
+    auto index = MatchIndex{};
+    index.start(cursor, u"ab", true);
+    CHECK(index.isBuiltFor(u"ab", true));
+    CHECK(index.getCountedLines() == 0);
+
+    while (index.isCounting()) {
+        index.step(cursor, 7);
+        const auto counted = index.getCountedLines();
+        CAPTURE(counted);
+
+        auto total = 0;
+        for (uint32_t line = 0; line < counted; ++line) {
+            total += static_cast<int32_t>(counts[line]);
+        }
+
+        auto before = 0;
+        for (uint32_t line = 0; line < cursor.getLineCount(); ++line) {
+            CAPTURE(line);
+            const auto rank = index.rank(cursor, line, 0);
+            CHECK(rank.total == total);
+            CHECK(rank.complete == !index.isCounting());
+            CHECK(rank.counted == (line <= counted));
+            if (rank.counted) {
+                CHECK(rank.before == before);
+                CHECK(rank.index == (counts[line] > 0 ? before : -1));
+            }
+
+            // Past the counted lines, every line is a candidate
+            const auto next = index.nextLineWithMatch(cursor, line);
+            if (line + 1 >= counted) {
+                CHECK(next == (line + 1 < cursor.getLineCount() ? std::optional(line + 1) : std::nullopt));
+            } else if (next) {
+                CHECK((*next == counted || counts[*next] > 0));
+                for (auto skipped = line + 1; skipped < *next; ++skipped) {
+                    CHECK(counts[skipped] == 0);
+                }
+            }
+            if (line > counted) {
+                CHECK(index.previousLineWithMatch(cursor, line) == line - 1);
+            }
+
+            before += static_cast<int32_t>(counts[line]);
+        }
+    }
+
+    checkIndex(index, cursor, u"ab", true);
+}
+
+TEST_CASE("a count run in steps follows the edits made between the steps") {
+    // Edits land before, across and after the counted lines, so the count moves with the lines
+    // it covers, and falls back to the first line of an edit running past it
+    auto random = std::mt19937(0x636f756e);
+    const auto pieces = std::vector<std::u16string_view> { u"ab", u"\n", u"ab\nab", u"x\n\nab\n" };
+
+    for (auto round = 0; round < 20; ++round) {
+        CAPTURE(round);
+        auto cursor = Cursor(std::make_unique<LineBuffer>());
+        seed(cursor, u"ab\nxx ab\n\nabab\nb\naba\nab\n\nab ab\nx");
+
+        auto index = MatchIndex{};
+        index.start(cursor, u"ab", true);
+        while (index.isCounting()) {
+            const auto line = static_cast<uint32_t>(random() % cursor.getLineCount());
+            cursor.setPosition(line, static_cast<uint32_t>(random() % (cursor.getString(line).length() + 1)));
+            if (random() % 2 == 0) {
+                index.edit(cursor.insert(pieces[random() % pieces.size()]));
+            } else {
+                const auto end_line = std::min(line + static_cast<uint32_t>(random() % 4), cursor.getLineCount() - 1);
+                cursor.activateSelection(true);
+                cursor.setPosition(end_line, static_cast<uint32_t>(cursor.getString(end_line).length()));
+                if (const auto edit = cursor.eraseSelection()) {
+                    index.edit(*edit);
+                }
+                cursor.activateSelection(false);
+            }
+            CHECK(index.getCountedLines() <= cursor.getLineCount());
+            index.step(cursor, 1 + static_cast<uint32_t>(random() % 3));
+        }
+
+        checkIndex(index, cursor, u"ab", true);
+    }
+}
+
+TEST_CASE("a pattern index counts and ranks matches of varying length") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"ERROR 1 ERROR 22\nok\nerror 333\n\nERROR x ERROR 4444");
+
+    auto index = MatchIndex{};
+    index.start(cursor, std::make_shared<Regex>(u"ERROR [0-9]+", true));
+    while (index.step(cursor, 2)) {}
+    CHECK(index.isBuiltFor(u"ERROR [0-9]+", true, true));
+    CHECK(!index.isBuiltFor(u"ERROR [0-9]+", true));
+
+    const auto second = index.rank(cursor, 0, 8);
+    CHECK(second.index == 1);
+    CHECK(second.length == 8);
+    CHECK(second.total == 3);
+    CHECK(index.rank(cursor, 4, 8).index == 2);
+    CHECK(index.rank(cursor, 4, 8).length == 10);
+    CHECK(index.nextLineWithMatch(cursor, 0) == 4u);
+
+    // Turning the third line into a match adds one
+    cursor.setPosition(2, 0);
+    cursor.activateSelection(true);
+    cursor.setPosition(2, 5);
+    index.edit(*cursor.eraseSelection());
+    cursor.activateSelection(false);
+    index.edit(cursor.insert(u"ERROR"));
+    CHECK(index.rank(cursor, 2, 0).index == 2);
+    CHECK(index.rank(cursor, 2, 0).total == 4);
+    CHECK(index.nextLineWithMatch(cursor, 0) == 2u);
+    CHECK(index.getScanner().getRegex() != nullptr);
+}
+
+TEST_CASE("a term extending the indexed one is narrowed down instead of counted again") {
+    // Terms grow one character at a time, the way an incremental search types them, over an
+    // alphabet dense in matches overlapping each other and differing only by case; every narrowed
+    // index must agree with a fresh count, without a line counted again
+    auto random = std::mt19937(0x6e617277);
+    const auto alphabet = std::u16string_view(u"aabABéÉ \n");
+
+    for (const auto case_sensitive : { false, true }) {
+        CAPTURE(case_sensitive);
+        for (auto round = 0; round < 20; ++round) {
+            CAPTURE(round);
+            auto text = std::u16string{};
+            for (auto character = 0; character < 400; ++character) {
+                text.push_back(alphabet[random() % alphabet.length()]);
+            }
+            auto cursor = Cursor(std::make_unique<LineBuffer>());
+            seed(cursor, text);
+
+            auto term = std::u16string(1, alphabet[random() % 6]);
+            auto index = MatchIndex{};
+            index.start(cursor, term, case_sensitive);
+            checkIndex(index, cursor, term, case_sensitive);
+            for (auto length = 2; length <= 6; ++length) {
+                term.push_back(alphabet[random() % 6]);
+                CAPTURE(term.length());
+                index.start(cursor, term, case_sensitive);
+                CHECK(index.isBuiltFor(term, case_sensitive));
+                CHECK(index.getCountedLines() == cursor.getLineCount());
+                checkIndex(index, cursor, term, case_sensitive);
+            }
+        }
+    }
+}
+
+TEST_CASE("a term narrowed down mid-count keeps its counted lines and counts the others") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    auto text = std::u16string{};
+    for (auto line = 0; line < 40; ++line) {
+        text.append(line % 3 == 0 ? u"abc ab abcd\n" : u"xab\n");
+    }
+    seed(cursor, text);
+
+    auto index = MatchIndex{};
+    index.start(cursor, u"ab", true);
+    index.step(cursor, 10);
+    CHECK(index.getCountedLines() == 10);
+
+    index.start(cursor, u"abc", true);
+    CHECK(index.getCountedLines() == 10);
+    CHECK(index.rank(cursor, 10, 0).total == 8);
+    index.step(cursor, 7);
+    index.start(cursor, u"abcd", true);
+    CHECK(index.getCountedLines() == 17);
+    checkIndex(index, cursor, u"abcd", true);
+}
+
+TEST_CASE("a term the occurrences cannot narrow down to is counted from the top") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"ab abc\nabcd\nAbc\nx");
+
+    auto index = MatchIndex{};
+    const auto count_again = [&](const std::u16string_view term, const bool caseSensitive) {
+        index.start(cursor, term, caseSensitive);
+        CHECK(index.getCountedLines() == 0);
+        checkIndex(index, cursor, term, caseSensitive);
+    };
+
+    count_again(u"ab", true);
+    // A shorter term, another mode, or a term not extending the indexed one
+    count_again(u"a", true);
+    count_again(u"ab", false);
+    count_again(u"bc", false);
+
+    // An edit drops the occurrences rather than moving them
+    cursor.setPosition(3, 0);
+    index.edit(cursor.insert(u"bcd"));
+    count_again(u"bcd", false);
+
+    // A pattern keeps none
+    index.start(cursor, std::make_shared<Regex>(u"bc", true));
+    while (index.step(cursor, 2)) {}
+    count_again(u"bcd", true);
+
+    // Neither does a term overlapping itself, whose enumeration skips some of them
+    count_again(u"aa", true);
+    count_again(u"aab", true);
+}
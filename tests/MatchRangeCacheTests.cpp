@@ -0,0 +1,188 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/cursor/MatchRangeCache.h"
+
+
+/**
+ * @brief Checks the ranges of a run of lines against a fresh scan of each.
+ *
+ * @param cache The cache under test.
+ * @param index The index whose term the cache follows.
+ * @param cursor The cursor both follow.
+ * @param term The indexed term.
+ * @param caseSensitive The indexed mode.
+ * @param first The first line to check.
+ * @param count The number of lines to check, clipped to the buffer.
+ */
+static void checkLines(const MatchRangeCache &cache, const MatchIndex &index, const Cursor &cursor, const std::u16string_view term, const bool caseSensitive, const uint32_t first, const uint32_t count) {
+    auto scanner = LineScanner(term, caseSensitive);
+    for (auto line = first; line < first + count && line < cursor.getLineCount(); ++line) {
+        CAPTURE(line);
+        auto expected = std::vector<uint32_t>{};
+        scanner.setLine(cursor.getString(line));
+        for (auto position = scanner.indexOf(0); position != std::u16string_view::npos; position = scanner.indexOf(position + term.length())) {
+            expected.push_back(static_cast<uint32_t>(position));
+        }
+
+        auto columns = std::vector<uint32_t>{};
+        for (const auto &range : cache.getRanges(cursor, index, line)) {
+            CHECK(range.length == term.length());
+            columns.push_back(range.column);
+        }
+        CHECK(columns == expected);
+    }
+}
+
+
+TEST_CASE("the ranges follow random edits and undo steps, in and around the window") {
+    // The buffer spans several windows and the checked view jumps around, so edits land above,
+    // across, inside and below the rows the cache holds
+    auto random = std::mt19937(0x72616e67);
+    const auto pieces = std::vector<std::u16string_view> { u"a", u"b", u"ab", u"\n", u"ab\nab", u"x\n\nba\n" };
+
+    for (const auto case_sensitive : { false, true }) {
+        CAPTURE(case_sensitive);
+        auto text = std::u16string{};
+        for (auto line = 0; line < 1500; ++line) {
+            text.append(line % 5 == 0 ? u"ab aB\n" : line % 7 == 0 ? u"\n" : u"xab\n");
+        }
+        auto cursor = Cursor(std::make_unique<LineBuffer>());
+        seed(cursor, text);
+
+        auto index = MatchIndex{};
+        index.build(cursor, u"ab", case_sensitive);
+        auto cache = MatchRangeCache{};
+        const auto apply = [&](const BufferEdit &edit) {
+            index.edit(edit);
+            cache.edit(edit);
+        };
+
+        auto view = 0u;
+        for (auto step = 0; step < 200; ++step) {
+            CAPTURE(step);
+            if (step % 10 == 0) {
+                view = static_cast<uint32_t>(random() % cursor.getLineCount());
+            }
+            checkLines(cache, index, cursor, u"ab", case_sensitive, view, 40);
+
+            const auto line = random() % 3 == 0 ? static_cast<uint32_t>(random() % cursor.getLineCount()) : std::min(view + static_cast<uint32_t>(random() % 40), cursor.getLineCount() - 1);
+            cursor.setPosition(line, static_cast<uint32_t>(random() % (cursor.getString(line).length() + 1)));
+            if (random() % 2 == 0) {
+                apply(cursor.insert(pieces[random() % pieces.size()]));
+            } else {
+                const auto end_line = std::min(line + static_cast<uint32_t>(random() % 600), cursor.getLineCount() - 1);
+                cursor.activateSelection(true);
+                cursor.setPosition(end_line, static_cast<uint32_t>(cursor.getString(end_line).length()));
+                if (const auto edit = cursor.eraseSelection()) {
+                    apply(*edit);
+                }
+                cursor.activateSelection(false);
+            }
+        }
+
+        for (auto step = 0; step < 30; ++step) {
+            CAPTURE(step);
+            for (const auto &edit : cursor.undo()) {
+                apply(edit);
+            }
+            checkLines(cache, index, cursor, u"ab", case_sensitive, view, 40);
+        }
+    }
+}
+
+TEST_CASE("scrolling back over unchanged lines scans none of them again") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    auto text = std::u16string{};
+    for (auto line = 0; line < 10000; ++line) {
+        text.append(u"ab x ab\n");
+    }
+    seed(cursor, text);
+
+    auto index = MatchIndex{};
+    index.start(cursor, u"ab", true);
+    auto cache = MatchRangeCache{};
+
+    // Nothing is scanned before a line is asked for, and only the lines asked for are
+    CHECK(cache.getScanCount() == 0);
+    for (uint32_t line = 5000; line < 5060; ++line) {
+        CHECK(cache.getRanges(cursor, index, line).size() == 2);
+    }
+    CHECK(cache.getScanCount() == 60);
+
+    // Scrolling down a line at a time, then back up, within the window
+    for (uint32_t top = 5000; top < 5100; ++top) {
+        (void) cache.getRanges(cursor, index, top + 59);
+    }
+    for (uint32_t top = 5100; top-- > 5000;) {
+        (void) cache.getRanges(cursor, index, top);
+    }
+    CHECK(cache.getScanCount() == 159);
+
+    // An edit rescans only the line it touched
+    cursor.setPosition(5010, 0);
+    cache.edit(cursor.insert(u"ab"));
+    CHECK(cache.getRanges(cursor, index, 5010).size() == 3);
+    CHECK(cache.getRanges(cursor, index, 5011).size() == 2);
+    CHECK(cache.getScanCount() == 160);
+
+    // A line break shifts the rows below it instead of dropping them
+    cache.edit(cursor.insert(u"\n"));
+    CHECK(cache.getRanges(cursor, index, 5011).size() == 2);
+    CHECK(cache.getRanges(cursor, index, 5059).size() == 2);
+    CHECK(cache.getScanCount() == 161);
+}
+
+TEST_CASE("a new term drops the rows, and no term has no ranges") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"ab abc\nABC");
+
+    auto index = MatchIndex{};
+    auto cache = MatchRangeCache{};
+    CHECK(cache.getRanges(cursor, index, 0).empty());
+    CHECK(cache.getScanCount() == 0);
+
+    index.start(cursor, u"ab", true);
+    CHECK(cache.getRanges(cursor, index, 0).size() == 2);
+    CHECK(cache.getRanges(cursor, index, 1).empty());
+
+    // Narrowed down to a longer term, or switched to another mode
+    index.start(cursor, u"abc", true);
+    checkLines(cache, index, cursor, u"abc", true, 0, 2);
+    index.start(cursor, u"abc", false);
+    checkLines(cache, index, cursor, u"abc", false, 0, 2);
+
+    // A pattern reports the length of each match
+    index.start(cursor, std::make_shared<Regex>(u"ab+c?", true));
+    const auto ranges = cache.getRanges(cursor, index, 0);
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].length == 2);
+    CHECK(ranges[1].column == 3);
+    CHECK(ranges[1].length == 3);
+
+    index.clear();
+    CHECK(cache.getRanges(cursor, index, 0).empty());
+    CHECK(cache.getMemoryUsage() == 0);
+}
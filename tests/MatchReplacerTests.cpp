@@ -0,0 +1,157 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/cursor/MatchReplacer.h"
+
+
+/**
+ * @brief Replaces every match one at a time, the way replace_all used to: select, erase, insert,
+ * then resume past the replacement, stepping over one code unit after an empty match.
+ *
+ * @param cursor The cursor to rewrite.
+ * @param scanner The scanner holding the term or the pattern.
+ * @param replacement The replacement, as given to the command.
+ * @return The number of matches replaced.
+ */
+static uint32_t replaceOneByOne(Cursor &cursor, LineScanner &scanner, const std::u16string_view replacement) {
+    auto count = 0u;
+    auto line = 0u;
+    auto column = size_t{ 0 };
+    while (line < cursor.getLineCount()) {
+        const auto text = cursor.getString(line);
+        scanner.setLine(text);
+        const auto position = scanner.indexOf(column);
+        if (position == std::u16string_view::npos) {
+            ++line;
+            column = 0;
+            continue;
+        }
+
+        const auto length = static_cast<uint32_t>(scanner.matchLength());
+        const auto expanded = MatchReplacer::expand(scanner, text, static_cast<uint32_t>(position), length, replacement);
+        select(cursor, line, static_cast<uint32_t>(position), line, static_cast<uint32_t>(position) + length);
+        (void) cursor.eraseSelection();
+        cursor.activateSelection(false);
+        cursor.setPosition(line, static_cast<uint32_t>(position));
+        (void) cursor.insert(expanded);
+        ++count;
+
+        line = cursor.getLine();
+        column = cursor.getColumn();
+        if (length == 0) {
+            if (column < cursor.getString(line).length()) {
+                ++column;
+            } else {
+                ++line;
+                column = 0;
+            }
+        }
+    }
+
+    return count;
+}
+
+
+TEST_CASE("replaceAll rewrites what replacing one match at a time rewrites") {
+    auto random = std::mt19937(0x72706c63);
+    const auto pieces = std::vector<std::u16string_view> { u"ab", u"a", u"b", u"x", u"\n", u"AB", u"aab" };
+    const auto terms = std::vector<std::pair<std::u16string_view, bool>> {
+        { u"ab", false }, { u"a", false }, { u"ab+", true }, { u"(a)(b)?", true }, { u"b$", true }, { u"x*", true }
+    };
+    const auto replacements = std::vector<std::u16string_view> { u"", u"ba", u"-\\1-", u"[\\0]", u"\\n" };
+
+    for (auto round = 0; round < 200; ++round) {
+        auto content = std::u16string{};
+        for (auto piece = random() % 12; piece > 0; --piece) {
+            content.append(pieces[random() % pieces.size()]);
+        }
+
+        const auto &[term, regex] = terms[random() % terms.size()];
+        const auto replacement = replacements[random() % replacements.size()];
+        const auto case_sensitive = random() % 2 == 0;
+        auto scanner = regex
+            ? LineScanner(std::make_shared<Regex>(term, case_sensitive))
+            : LineScanner(term, case_sensitive);
+
+        CAPTURE(round);
+        CAPTURE(content);
+        CAPTURE(std::u16string(term));
+        CAPTURE(std::u16string(replacement));
+
+        auto expected = Cursor(std::make_unique<LineBuffer>());
+        seed(expected, content);
+        const auto expected_count = replaceOneByOne(expected, scanner, replacement);
+
+        auto cursor = Cursor(std::make_unique<LineBuffer>());
+        seed(cursor, content);
+        const auto result = MatchReplacer::replaceAll(cursor, scanner, replacement);
+        CHECK(result.count == expected_count);
+        CHECK(result.edit.has_value() == (expected_count > 0));
+        CHECK(cursor.getText() == expected.getText());
+
+        if (result.edit) {
+            CHECK(result.edit->new_end.line == cursor.getLine());
+            CHECK(result.edit->new_end.column == cursor.getColumn());
+        }
+
+        // One step back to the original text, one step forward to the replaced one; replacing
+        // nothing with nothing records nothing
+        if (cursor.getText() != content) {
+            CHECK(undoStep(cursor));
+            CHECK(cursor.getText() == content);
+            CHECK_FALSE(undoStep(cursor));
+            CHECK(redoStep(cursor));
+            CHECK(cursor.getText() == expected.getText());
+        }
+    }
+}
+
+TEST_CASE("replaceAll covers only the lines from the first match to the last one") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"head\nab x ab\nmiddle\nx ab\ntail");
+
+    const auto result = MatchReplacer::replaceAll(cursor, LineScanner(u"ab", true), u"long\nab");
+    REQUIRE(result.edit.has_value());
+    CHECK(result.count == 3);
+    CHECK(result.edit->start.line == 1);
+    CHECK(result.edit->start.column == 0);
+    CHECK(result.edit->old_end.line == 3);
+    CHECK(result.edit->old_end.column == 4);
+    CHECK(cursor.getText() == std::u16string(u"head\nlong\nab x long\nab\nmiddle\nx long\nab\ntail"));
+    CHECK(cursor.getLine() == 6);
+    CHECK(cursor.getColumn() == 2);
+}
+
+TEST_CASE("replaceAll leaves a buffer without a match untouched") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"abc\ndef");
+
+    const auto result = MatchReplacer::replaceAll(cursor, LineScanner(u"xyz", true), u"-");
+    CHECK(result.count == 0);
+    CHECK_FALSE(result.edit.has_value());
+    CHECK(cursor.getText() == std::u16string(u"abc\ndef"));
+    CHECK_FALSE(undoStep(cursor));
+}
@@ -0,0 +1,37 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "TestSupport.h"
+
+#include "core/base/NumberText.h"
+
+
+TEST_CASE("numbers render as decimal digits, appended after the existing text") {
+    CHECK(formatNumber(0) == u"0");
+    CHECK(formatNumber(42) == u"42");
+    CHECK(formatNumber(std::numeric_limits<uint64_t>::max()) == u"18446744073709551615");
+
+    auto text = std::u16string(u"line ");
+    appendNumber(text, 1234);
+    appendNumber(text, 5);
+    CHECK(text == u"line 12345");
+}
@@ -0,0 +1,352 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/base/Regex.h"
+
+
+/**
+ * @brief Finds the leftmost-longest match the obvious way, trying every span with std::regex_match.
+ *
+ * Whole-span matching carries no leftmost rule of its own, so this is a reference for the POSIX
+ * semantics of Regex whatever the rules of the std::regex grammar. Patterns must not use anchors.
+ *
+ * @param pattern The pattern, in the common subset of both syntaxes.
+ * @param line The text to scan, ASCII only.
+ * @param from The column to start scanning from.
+ * @param caseSensitive Whether the comparison is case-sensitive.
+ * @return The match, or std::nullopt when none.
+ */
+static std::optional<Regex::Span> referenceFind(const std::string &pattern, const std::string &line, const size_t from, const bool caseSensitive) {
+    const auto flags = caseSensitive ? std::regex::ECMAScript : std::regex::ECMAScript | std::regex::icase;
+    const auto expression = std::regex(pattern, flags);
+    for (auto start = from; start <= line.length(); ++start) {
+        for (auto end = line.length() + 1; end-- > start;) {
+            if (std::regex_match(line.begin() + static_cast<std::ptrdiff_t>(start), line.begin() + static_cast<std::ptrdiff_t>(end), expression)) {
+                return Regex::Span{.start = start, .end = end};
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+/** @return The ASCII text as UTF-16. */
+static std::u16string widen(const std::string &text) {
+    return { text.begin(), text.end() };
+}
+
+
+TEST_CASE("matches are leftmost, then longest") {
+    auto regex = Regex(u"a|ab|abc", true);
+    REQUIRE(regex.isValid());
+
+    const auto match = regex.find(u"xxabcab", 0);
+    REQUIRE(match.has_value());
+    CHECK(match->start == 2);
+    CHECK(match->end == 5);
+
+    const auto next = regex.find(u"xxabcab", 5);
+    REQUIRE(next.has_value());
+    CHECK(next->start == 5);
+    CHECK(next->end == 7);
+
+    CHECK(!regex.find(u"xxabcab", 8).has_value());
+}
+
+TEST_CASE("the leftmost match wins over one ending first") {
+    // "f" ends first, inside the longer alternative that starts before it
+    auto regex = Regex(u"abcdefghij|f", true);
+    REQUIRE(regex.isValid());
+
+    const auto match = regex.find(u"xabcdefghij", 0);
+    REQUIRE(match.has_value());
+    CHECK(match->start == 1);
+    CHECK(match->end == 11);
+
+    const auto inner = regex.find(u"xabcdefghi", 0);
+    REQUIRE(inner.has_value());
+    CHECK(inner->start == 6);
+    CHECK(inner->end == 7);
+}
+
+TEST_CASE("long runs are matched in one pass, with or without a prefix") {
+    // Trying every start up to the first match end would take quadratic time on each of these
+    const auto run = std::u16string(100000, u' ');
+
+    auto trailing = Regex(u"\\s+$", true);
+    const auto spaces = trailing.find(u"x" + run, 0);
+    REQUIRE(spaces.has_value());
+    CHECK(spaces->start == 1);
+    CHECK(spaces->end == run.length() + 1);
+
+    auto word = Regex(u"[a-z]+\\d", true);
+    const auto letters = std::u16string(100000, u'q');
+    const auto digit = word.find(letters + u"7", 0);
+    REQUIRE(digit.has_value());
+    CHECK(digit->start == 0);
+    CHECK(digit->end == letters.length() + 1);
+
+    auto prefixed = Regex(u"a+b", true);
+    REQUIRE(prefixed.getPrefix() == u"a");
+    const auto as = std::u16string(100000, u'a');
+    CHECK(!prefixed.find(as, 0).has_value());
+    const auto ab = prefixed.find(u"x" + as + u"b", 0);
+    REQUIRE(ab.has_value());
+    CHECK(ab->start == 1);
+    CHECK(ab->end == as.length() + 2);
+}
+
+TEST_CASE("escapes, classes and counted repetitions") {
+    auto regex = Regex(u"ERROR \\d{3}", true);
+    REQUIRE(regex.isValid());
+    CHECK(regex.getPrefix() == u"ERROR ");
+
+    const auto match = regex.find(u"12:00 ERROR 12 ERROR 4042", 0);
+    REQUIRE(match.has_value());
+    CHECK(match->start == 15);
+    CHECK(match->end == 24);
+
+    auto word = Regex(u"[^\\s,]+", true);
+    REQUIRE(word.isValid());
+    CHECK(word.getPrefix().empty());
+    const auto token = word.find(u"  ab-c, d", 0);
+    REQUIRE(token.has_value());
+    CHECK(token->start == 2);
+    CHECK(token->end == 6);
+
+    auto range = Regex(u"x{2,3}", true);
+    const auto run = range.find(u"xxxxx", 0);
+    REQUIRE(run.has_value());
+    CHECK(run->end == 3);
+    CHECK(range.find(u"xxxxx", 3)->end == 5);
+    CHECK(!range.find(u"x", 0).has_value());
+
+    // A brace not opening a count is a literal brace
+    auto brace = Regex(u"a{b", true);
+    REQUIRE(brace.isValid());
+    CHECK(brace.find(u"xa{b", 0)->start == 1);
+}
+
+TEST_CASE("anchors only match at the ends of the line") {
+    auto start = Regex(u"^ab", true);
+    CHECK(start.find(u"abab", 0)->start == 0);
+    CHECK(!start.find(u"abab", 1).has_value());
+    CHECK(!start.matchAt(u"abab", 2).has_value());
+
+    auto end = Regex(u"ab$", true);
+    CHECK(end.find(u"abab", 0)->start == 2);
+    CHECK(!end.find(u"abax", 0).has_value());
+
+    auto empty_line = Regex(u"^$", true);
+    CHECK(empty_line.find(u"", 0).has_value());
+    CHECK(!empty_line.find(u"a", 0).has_value());
+
+    // Empty matches are found like any other
+    auto line_end = Regex(u"$", true);
+    const auto match = line_end.find(u"abc", 0);
+    REQUIRE(match.has_value());
+    CHECK(match->start == 3);
+    CHECK(match->end == 3);
+}
+
+TEST_CASE("case-insensitive patterns fold Unicode letters, in classes too") {
+    auto regex = Regex(u"error [a-c]+", false);
+    REQUIRE(regex.isValid());
+    CHECK(regex.getPrefix() == u"error ");
+    const auto match = regex.find(u"An ERROR BcA!", 0);
+    REQUIRE(match.has_value());
+    CHECK(match->start == 3);
+    CHECK(match->end == 12);
+
+    auto negated = Regex(u"[^a]", false);
+    CHECK(negated.find(u"aAb", 0)->start == 2);
+
+    // Every case of a character folds into the prefix, the final sigma included
+    auto greek = Regex(u"λόγος [α-ω]", false);
+    CHECK(greek.getPrefix() == u"λόγοσ ");
+    CHECK(greek.find(u"ΛΌΓΟΣ Ω", 0).has_value());
+
+    // The Kelvin sign is one of the cases of k
+    auto kelvin = Regex(u"k+", false);
+    CHECK(kelvin.getPrefix() == u"k");
+    const auto kelvin_match = kelvin.find(u"\u212AKk", 0);
+    REQUIRE(kelvin_match.has_value());
+    CHECK(kelvin_match->end == 3);
+
+    auto cyrillic_negated = Regex(u"[^я]", false);
+    CHECK(cyrillic_negated.find(u"яЯж", 0)->start == 2);
+}
+
+TEST_CASE("invalid patterns report why") {
+    for (const auto pattern : { u"(ab", u"ab)", u"*a", u"a**", u"[ab", u"a\\", u"\\q", u"x{3,2}", u"x{1001}", u"[z-a]" }) {
+        CAPTURE(std::u16string(pattern));
+        const auto regex = Regex(pattern, true);
+        CHECK(!regex.isValid());
+        CHECK(!regex.getError().empty());
+    }
+
+    // Counted repetitions multiply the program; past the cap the pattern is refused rather than built
+    CHECK(!Regex(u"((((a{1000}){1000}){1000}){1000})", true).isValid());
+}
+
+TEST_CASE("captures follow the priorities of the quantifiers within the match") {
+    auto regex = Regex(u"(\\w+)=(\\w*)(;)?", true);
+    REQUIRE(regex.isValid());
+    CHECK(regex.getGroupCount() == 3);
+
+    const auto line = std::u16string_view(u"set key=value;");
+    const auto match = regex.find(line, 0);
+    REQUIRE(match.has_value());
+    const auto groups = regex.capture(line, *match);
+    REQUIRE(groups.size() == 4);
+    REQUIRE(groups[1].has_value());
+    CHECK(line.substr(groups[1]->start, groups[1]->end - groups[1]->start) == u"key");
+    CHECK(line.substr(groups[2]->start, groups[2]->end - groups[2]->start) == u"value");
+    CHECK(groups[3].has_value());
+
+    CHECK(Regex::expand(u"\\2:\\1\\\\\\n", line, groups) == u"value:key\\\n");
+    CHECK(Regex::getHighestReference(u"\\2:\\1") == 2);
+    CHECK(Regex::getHighestReference(u"plain") == -1);
+
+    // Lazy and greedy groups split the same span differently
+    auto lazy = Regex(u"(a+?)(a*)", true);
+    const auto lazy_groups = lazy.capture(u"aaa", *lazy.find(u"aaa", 0));
+    CHECK(lazy_groups[1]->end == 1);
+    auto greedy = Regex(u"(a+)(a*)", true);
+    const auto greedy_groups = greedy.capture(u"aaa", *greedy.find(u"aaa", 0));
+    CHECK(greedy_groups[1]->end == 3);
+
+    // A group left out of the match is unset
+    auto optional = Regex(u"a(b)?c", true);
+    const auto unset = optional.capture(u"ac", *optional.find(u"ac", 0));
+    CHECK(!unset[1].has_value());
+}
+
+TEST_CASE("random patterns agree with a brute-force std::regex reference") {
+    auto random = std::mt19937(0x72656765);
+    const auto atoms = std::vector<std::string> { "a", "b", "c", ".", "[ab]", "[^a]", "(a|bc)", "(?:ab|a)", "\\w", "[a-b]" };
+    const auto quantifiers = std::vector<std::string> { "", "", "*", "+", "?", "{2}", "{1,2}", "*?" };
+
+    for (auto round = 0; round < 300; ++round) {
+        auto pattern = std::string{};
+        const auto atom_count = 1 + random() % 3;
+        for (auto index = 0u; index < atom_count; ++index) {
+            pattern.append(atoms[random() % atoms.size()]).append(quantifiers[random() % quantifiers.size()]);
+        }
+        if (random() % 5 == 0) {
+            pattern.append("|").append(atoms[random() % atoms.size()]);
+        }
+
+        auto line = std::string{};
+        const auto length = random() % 12;
+        for (auto index = 0u; index < length; ++index) {
+            line.push_back("abcAB x"[random() % 7]);
+        }
+
+        const auto case_sensitive = random() % 2 == 0;
+        CAPTURE(pattern);
+        CAPTURE(line);
+        CAPTURE(case_sensitive);
+
+        // A tiny cache forces flushes in the middle of the scans
+        auto regex = Regex(widen(pattern), case_sensitive, random() % 2 == 0 ? Regex::DEFAULT_CACHE_BYTES : 256);
+        REQUIRE(regex.isValid());
+        for (size_t from = 0; from <= line.length(); ++from) {
+            CAPTURE(from);
+            const auto expected = referenceFind(pattern, line, from, case_sensitive);
+            const auto actual = regex.find(widen(line), from);
+            REQUIRE(expected.has_value() == actual.has_value());
+            if (expected) {
+                CHECK(actual->start == expected->start);
+                CHECK(actual->end == expected->end);
+            }
+        }
+    }
+}
+
+TEST_CASE("random anchored patterns find the first start matchAt accepts") {
+    // std::regex has no POSIX reference for the anchors: the anchored matches of Regex itself,
+    // tried at every start, are the reference of the two-pass search
+    auto random = std::mt19937(0x616e6368);
+    const auto atoms = std::vector<std::string> { "a", "b", ".", "[ab]", "(a|bc)", "\\s", "(^a|b)", "(a$|b)" };
+    const auto quantifiers = std::vector<std::string> { "", "", "*", "+", "?", "*?" };
+
+    for (auto round = 0; round < 300; ++round) {
+        auto pattern = std::string(random() % 3 == 0 ? "^" : "");
+        const auto atom_count = 1 + random() % 3;
+        for (auto index = 0u; index < atom_count; ++index) {
+            pattern.append(atoms[random() % atoms.size()]).append(quantifiers[random() % quantifiers.size()]);
+        }
+        if (random() % 3 == 0) {
+            pattern.append("$");
+        }
+
+        auto line = std::string{};
+        const auto length = random() % 12;
+        for (auto index = 0u; index < length; ++index) {
+            line.push_back("abcb  "[random() % 6]);
+        }
+        CAPTURE(pattern);
+        CAPTURE(line);
+
+        auto regex = Regex(widen(pattern), true, random() % 2 == 0 ? Regex::DEFAULT_CACHE_BYTES : 256);
+        REQUIRE(regex.isValid());
+        const auto text = widen(line);
+        for (size_t from = 0; from <= line.length(); ++from) {
+            CAPTURE(from);
+            auto expected = std::optional<Regex::Span>{};
+            for (auto start = from; start <= line.length() && !expected; ++start) {
+                if (const auto end = regex.matchAt(text, start)) {
+                    expected = Regex::Span{.start = start, .end = *end};
+                }
+            }
+
+            const auto actual = regex.find(text, from);
+            REQUIRE(expected.has_value() == actual.has_value());
+            if (expected) {
+                CHECK(actual->start == expected->start);
+                CHECK(actual->end == expected->end);
+            }
+        }
+    }
+}
+
+TEST_CASE("the DFA cache stays within its budget") {
+    // (a|b)*a(a|b){8} needs a state per suffix of nine letters; a small budget keeps flushing
+    auto regex = Regex(u"(a|b)*a(a|b){8}", true, 4096);
+    REQUIRE(regex.isValid());
+
+    auto random = std::mt19937(0x63616368);
+    auto line = std::u16string{};
+    for (auto index = 0; index < 20000; ++index) {
+        line.push_back(random() % 2 == 0 ? u'a' : u'b');
+    }
+    line.append(u"a");
+
+    CHECK(regex.find(line, 0).has_value());
+    CHECK(regex.getCacheMemoryUsage() <= 4096);
+    CHECK(regex.getCacheFlushCount() > 0);
+}
@@ -0,0 +1,211 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/SearchAllJob.h"
+#include "core/base/LineScanner.h"
+#include "core/base/NumberText.h"
+#include "core/base/Regex.h"
+
+
+/**
+ * @brief Lists the matches of a term in a buffer with a single forEachMatch walk, the way a search
+ * run on that buffer alone enumerates them.
+ *
+ * @param name The name the entries start with.
+ * @param cursor The buffer to scan.
+ * @param scanner The scanner holding the term or the pattern.
+ * @param maxMatches The number of entries listed at most.
+ * @return The entries, in text order, each ending with a newline.
+ */
+static std::u16string walkEntries(const std::u16string_view name, const Cursor &cursor, const LineScanner &scanner, const uint64_t maxMatches = UINT64_MAX) {
+    auto entries = std::u16string{};
+    auto count = uint64_t{0};
+    scanner.forEachMatch(cursor, 0, 0, [&](const uint32_t line, const uint32_t column) {
+        if (count == maxMatches) {
+            return false;
+        }
+        entries.append(name).push_back(u':');
+        appendNumber(entries, line + 1);
+        entries.push_back(u':');
+        appendNumber(entries, column + 1);
+        entries.append(u": ").append(cursor.getString(line)).push_back(u'\n');
+        ++count;
+        return true;
+    });
+    return entries;
+}
+
+/**
+ * @brief Waits for a job to be over, then takes everything it listed.
+ * @param job The job to wait for.
+ * @return The entries.
+ */
+static std::u16string collect(SearchAllJob &job) {
+    auto output = std::u16string{};
+    while (job.isRunning()) {
+        (void) job.takeOutput(output);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    (void) job.takeOutput(output);
+    job.cancel();
+    return output;
+}
+
+/**
+ * @brief Builds a buffer text of many lines, a few of them holding the term.
+ * @param lineCount The number of lines.
+ * @return The text.
+ */
+static std::u16string makeLog(const uint32_t lineCount) {
+    auto text = std::u16string{};
+    for (uint32_t line = 0; line < lineCount; ++line) {
+        if (line % 997 == 0) {
+            text.append(u"x alpha y alpha");
+        } else if (line % 13 == 0) {
+            text.append(u"Alpha");
+        } else {
+            text.append(u"filler text");
+        }
+        text.push_back(u'\n');
+    }
+    return text;
+}
+
+
+TEST_CASE("a search lists in every buffer what a search of that buffer alone finds, in buffer order") {
+    auto small = Cursor(std::make_unique<LineBuffer>());
+    auto large = Cursor(std::make_unique<LineBuffer>());
+    auto empty = Cursor(std::make_unique<LineBuffer>());
+
+    seed(small, u"alpha beta\nno match here\nbeta beta\nALPHA");
+
+    // More lines than a slice, so this one buffer is split between workers
+    seed(large, makeLog(SearchAllJob::SLICE_LINES * 2 + 1000));
+
+    // An edit detaches a line from the storage the others share
+    large.setPosition(SearchAllJob::SLICE_LINES, 0);
+    (void) large.insert(u"alpha ");
+
+    const auto cursors = std::array<const Cursor *, 3>{&small, &large, &empty};
+    const auto names = std::array<std::u16string, 3>{u"small", u"large", u"empty"};
+
+    auto job = SearchAllJob();
+    for (const auto case_sensitive : {true, false}) {
+        for (const auto thread_count : {1u, 2u, 8u}) {
+            CAPTURE(case_sensitive);
+            CAPTURE(thread_count);
+
+            job.start(cursors, names, u"alpha", case_sensitive, false, UINT32_MAX, thread_count);
+            const auto scanner = LineScanner(u"alpha", case_sensitive);
+            CHECK(collect(job) == walkEntries(u"small", small, scanner) + walkEntries(u"large", large, scanner));
+
+            const auto stats = job.getStats();
+            CHECK(stats.buffers_matched == 2);
+            CHECK(stats.buffers_truncated == 0);
+            CHECK(stats.buffers_edited == 0);
+            CHECK_FALSE(job.isStarted());
+        }
+    }
+
+    // Each worker compiles its own copy of the pattern
+    for (const auto pattern : {u"al?pha", u"[0-9]+|x"}) {
+        job.start(cursors, names, pattern, false, true, UINT32_MAX, 4);
+        const auto scanner = LineScanner(std::make_shared<Regex>(pattern, false));
+        CHECK(collect(job) == walkEntries(u"small", small, scanner) + walkEntries(u"large", large, scanner));
+    }
+}
+
+TEST_CASE("a search lists the first matches of a buffer and counts the buffers holding more") {
+    auto many = Cursor(std::make_unique<LineBuffer>());
+    auto few = Cursor(std::make_unique<LineBuffer>());
+
+    auto text = std::u16string{};
+    for (uint32_t line = 0; line < SearchAllJob::SLICE_LINES * 3 + 10; ++line) {
+        text.append(u"ab ab\n");
+    }
+    seed(many, text);
+    seed(few, u"ab\nab");
+
+    const auto cursors = std::array<const Cursor *, 2>{&many, &few};
+    const auto names = std::array<std::u16string, 2>{u"many", u"few"};
+    const auto scanner = LineScanner(u"ab", true);
+    const auto match_count = static_cast<uint32_t>((SearchAllJob::SLICE_LINES * 3 + 10) * 2);
+
+    // Caps falling inside the first slice, on its last match, and past it
+    auto job = SearchAllJob();
+    const auto last_in_first_slice = SearchAllJob::SLICE_LINES * 2;
+    for (const auto cap : {3u, last_in_first_slice, last_in_first_slice + 5}) {
+        CAPTURE(cap);
+        job.start(cursors, names, u"ab", true, false, cap, 4);
+        CHECK(collect(job) == walkEntries(u"many", many, scanner, cap) + walkEntries(u"few", few, scanner));
+
+        const auto stats = job.getStats();
+        CHECK(stats.match_count == cap + 2);
+        CHECK(stats.buffers_truncated == 1);
+    }
+
+    // A cap equal to the number of matches lists them all without counting anything out
+    job.start(cursors, names, u"ab", true, false, match_count, 4);
+    CHECK(collect(job) == walkEntries(u"many", many, scanner) + walkEntries(u"few", few, scanner));
+    CHECK(job.getStats().buffers_truncated == 0);
+}
+
+TEST_CASE("a buffer edited or closed during a search is not read any further") {
+    auto edited = Cursor(std::make_unique<LineBuffer>());
+    auto closed = std::make_unique<Cursor>(std::make_unique<LineBuffer>());
+    const auto text = makeLog(SearchAllJob::SLICE_LINES * 16);
+    seed(edited, text);
+    seed(*closed, text);
+
+    const auto scanner = LineScanner(u"alpha", true);
+    const auto full = walkEntries(u"edited", edited, scanner);
+    const auto cursors = std::array<const Cursor *, 2>{&edited, closed.get()};
+    const auto names = std::array<std::u16string, 2>{u"edited", u"closed"};
+
+    auto job = SearchAllJob();
+    job.start(cursors, names, u"alpha", true, false, UINT32_MAX, 2);
+
+    // The edit waits for the slices in flight; the ones after it are skipped
+    edited.setPosition(0, 0);
+    (void) edited.insert(u"alpha ");
+    closed.reset();
+
+    // What was listed before the edit is the start of the listing the buffer had
+    const auto output = collect(job);
+    const auto listed = output.substr(0, output.find(u"closed:"));
+    CHECK(full.starts_with(listed));
+
+    const auto stats = job.getStats();
+    CHECK(stats.buffers_edited <= 2);
+    CHECK((stats.buffers_edited == 0) == (listed == full && output.length() == 2 * full.length()));
+
+    // The job starts over from the text as it is now
+    job.start(std::span(cursors).first(1), std::span(names).first(1), u"alpha", true, false, UINT32_MAX, 2);
+    CHECK(collect(job) == walkEntries(u"edited", edited, scanner));
+    CHECK(job.getStats().buffers_edited == 0);
+}
@@ -0,0 +1,165 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/base/CaseFold.h"
+#include "core/base/SubstringSearch.h"
+
+
+/** @return Every kernel the running CPU supports, slowest first. */
+static std::vector<SubstringSearch::Kernel> supportedKernels() {
+    auto kernels = std::vector { SubstringSearch::Kernel::Scalar };
+    if (SubstringSearch::getBestKernel() != SubstringSearch::Kernel::Scalar) {
+        kernels.push_back(SubstringSearch::Kernel::Sse2);
+    }
+    if (SubstringSearch::getBestKernel() == SubstringSearch::Kernel::Avx2) {
+        kernels.push_back(SubstringSearch::Kernel::Avx2);
+    }
+    return kernels;
+}
+
+/**
+ * @brief Finds a needle one candidate position at a time, folding at comparison time.
+ *
+ * @param haystack The text to scan.
+ * @param needle The text to look for, already folded when @p foldCase is set.
+ * @param from The position to start scanning from.
+ * @param foldCase Whether the haystack is folded.
+ * @return The starting position, or std::u16string_view::npos when absent.
+ */
+static size_t referenceFind(const std::u16string_view haystack, const std::u16string_view needle, const size_t from, const bool foldCase) {
+    for (auto position = from; position + needle.length() <= haystack.length(); ++position) {
+        auto matched = true;
+        for (size_t offset = 0; offset < needle.length() && matched; ++offset) {
+            const auto unit = haystack[position + offset];
+            matched = (foldCase ? CaseFold::fold(unit) : unit) == needle[offset];
+        }
+        if (matched) {
+            return position;
+        }
+    }
+
+    return std::u16string_view::npos;
+}
+
+
+TEST_CASE("every kernel agrees with a per-position scan on long haystacks") {
+    // Long enough for the vector loops to run many steps, over an alphabet dense enough for the
+    // two anchors to match often without the middle doing so, and mixing the ASCII and the table
+    // folds within a vector; every from, in both modes, for needles from one unit up to longer
+    // than a vector
+    auto random = std::mt19937(0x62626c6f);
+    const auto alphabet = std::u16string_view(u"abkAB@[`{éÉK\u212A");
+    auto mismatches = 0;
+
+    for (auto round = 0; round < 40; ++round) {
+        auto haystack = std::u16string(static_cast<size_t>(20 + random() % 80), u' ');
+        for (auto &unit : haystack) {
+            unit = alphabet[random() % alphabet.length()];
+        }
+
+        for (const auto needle_length : { 1u, 2u, 3u, 7u, 9u, 17u }) {
+            // Taking the needle from the haystack guarantees at least one occurrence
+            const auto start = random() % (haystack.length() - needle_length + 1);
+            const auto raw_needle = haystack.substr(start, needle_length);
+
+            for (const auto fold_case : { false, true }) {
+                auto needle = raw_needle;
+                if (fold_case) {
+                    for (auto &unit : needle) {
+                        unit = CaseFold::fold(unit);
+                    }
+                }
+
+                for (const auto kernel : supportedKernels()) {
+                    for (size_t from = 0; from <= haystack.length() + 1; ++from) {
+                        const auto actual = SubstringSearch::find(haystack, needle, from, fold_case, kernel);
+                        const auto expected = referenceFind(haystack, needle, from, fold_case);
+                        if (actual != expected && ++mismatches <= 5) {
+                            CAPTURE(round);
+                            CAPTURE(needle_length);
+                            CAPTURE(fold_case);
+                            CAPTURE(static_cast<int>(kernel));
+                            CAPTURE(from);
+                            CHECK(actual == expected);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    CHECK(mismatches == 0);
+}
+
+TEST_CASE("the vector fold agrees with the table for every code unit") {
+    // Every code unit from 0 to 0xFFFF, sixteen to a vector: a needle of one folded unit must find
+    // exactly the units whose scalar fold equals it, across the signed boundary of 0x8000 too; the
+    // first vectors are ASCII and take the branch-free fold, the others go through the table
+    for (const auto kernel : supportedKernels()) {
+        CAPTURE(static_cast<int>(kernel));
+        auto haystack = std::u16string(0x10000, u'\0');
+        for (uint32_t unit = 0; unit < 0x10000; ++unit) {
+            haystack[unit] = static_cast<char16_t>(unit);
+        }
+
+        for (const auto needle : { u'a', u'k', u's', u'z', u'@', u'[', u'`', u'{', u'é', u'σ', u'ǆ', u'聁', u'聡' }) {
+            auto found = std::vector<size_t>{};
+            for (auto position = SubstringSearch::find(haystack, std::u16string_view(&needle, 1), 0, true, kernel);
+                 position != std::u16string_view::npos;
+                 position = SubstringSearch::find(haystack, std::u16string_view(&needle, 1), position + 1, true, kernel)) {
+                found.push_back(position);
+            }
+
+            auto expected = std::vector<size_t>{};
+            for (uint32_t unit = 0; unit < 0x10000; ++unit) {
+                if (CaseFold::fold(static_cast<char16_t>(unit)) == needle) {
+                    expected.push_back(unit);
+                }
+            }
+            CAPTURE(static_cast<uint32_t>(needle));
+            CHECK(found == expected);
+        }
+    }
+}
+
+TEST_CASE("a needle longer than what is left after from is never found") {
+    for (const auto kernel : supportedKernels()) {
+        CAPTURE(static_cast<int>(kernel));
+        CHECK(SubstringSearch::find(u"abcdefghijklmnopqrstuvwxyz", u"xyz", 24, false, kernel) == std::u16string_view::npos);
+        CHECK(SubstringSearch::find(u"abcdefghijklmnopqrstuvwxyz", u"xyz", 23, false, kernel) == 23);
+        CHECK(SubstringSearch::find(u"ab", u"abc", 0, true, kernel) == std::u16string_view::npos);
+        CHECK(SubstringSearch::find(u"", u"", 0, true, kernel) == 0);
+        CHECK(SubstringSearch::find(u"", u"", 1, true, kernel) == std::u16string_view::npos);
+    }
+}
+
+TEST_CASE("findLast folds like find and keeps its limit exclusive") {
+    CHECK(SubstringSearch::findLast(u"xABxab", u"ab", 6, true) == 4);
+    CHECK(SubstringSearch::findLast(u"xABxab", u"ab", 4, true) == 1);
+    CHECK(SubstringSearch::findLast(u"xABxab", u"ab", 1, true) == std::u16string_view::npos);
+    CHECK(SubstringSearch::findLast(u"xABxab", u"ab", 4, false) == std::u16string_view::npos);
+    CHECK(SubstringSearch::findLast(u"xABxab", u"", 100, true) == 6);
+    CHECK(SubstringSearch::findLast(u"xABxab", u"ab", 0, true) == std::u16string_view::npos);
+}
@@ -0,0 +1,251 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "TestSupport.h"
+
+#include "core/cursor/Cursor.h"
+#include "core/cursor/SwapJournal.h"
+#include "core/cursor/buffer/LineBuffer.h"
+
+
+/**
+ * @brief Writes a file, standing for the file on disk a buffer was loaded from.
+ *
+ * @param path The file.
+ * @param content Its content.
+ */
+static void writeFile(const std::filesystem::path &path, const std::string &content) {
+    auto ofs = std::ofstream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs << content;
+}
+
+
+TEST_CASE("the swap file sits next to the file, hidden") {
+    CHECK(SwapJournal::pathFor("dir/notes.txt") == (std::filesystem::path("dir") / ".notes.txt.bbswp").string());
+    CHECK(SwapJournal::pathFor("notes.txt") == ".notes.txt.bbswp");
+}
+
+TEST_CASE("flushed edits replay over the file into the buffer they were made on") {
+    const auto directory = ScratchDirectory();
+    const auto swap_path = SwapJournal::pathFor(directory.prefix() + "file.txt");
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"first\nsecond");
+    cursor.attachSwap(std::make_unique<SwapJournal>(swap_path));
+
+    (void) cursor.insert(u"typed ");
+    (void) cursor.newLine();
+    cursor.setPosition(2, 6);
+    (void) cursor.eraseLeft();
+    (void) cursor.replace(TextRange{.line_start = 0, .column_start = 0, .line_end = 1, .column_end = 0}, u"héllo");
+    (void) cursor.undo();
+    (void) cursor.redo();
+    cursor.getSwap()->flush();
+
+    const auto recovery = SwapJournal::recover(swap_path, u"first\nsecond");
+    REQUIRE(recovery.has_value());
+    CHECK(recovery->complete);
+    CHECK(recovery->edit_count == 6);
+    CHECK(recovery->content == cursor.getText());
+}
+
+TEST_CASE("a batch replays from the swap file, and so do its undo and redo") {
+    const auto directory = ScratchDirectory();
+    const auto swap_path = SwapJournal::pathFor(directory.prefix() + "file.txt");
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"one\ntwo\nthree");
+    cursor.attachSwap(std::make_unique<SwapJournal>(swap_path));
+
+    cursor.beginBatch();
+    cursor.batchReplace(TextRange{.line_start = 0, .column_start = 0, .line_end = 0, .column_end = 1}, u"O\n");
+    cursor.batchReplace(TextRange{.line_start = 0, .column_start = 3, .line_end = 1, .column_end = 2}, u"");
+    cursor.batchReplace(TextRange{.line_start = 2, .column_start = 5, .line_end = 2, .column_end = 5}, u"!");
+    REQUIRE(cursor.commitBatch().has_value());
+    const auto replaced = cursor.getText();
+
+    for (const auto step : {0, 1, 2}) {
+        if (step == 1) {
+            REQUIRE(undoStep(cursor));
+        } else if (step == 2) {
+            REQUIRE(redoStep(cursor));
+        }
+        cursor.getSwap()->flush();
+
+        const auto recovery = SwapJournal::recover(swap_path, u"one\ntwo\nthree");
+        REQUIRE(recovery.has_value());
+        CHECK(recovery->complete);
+        CHECK(recovery->content == cursor.getText());
+    }
+    CHECK(cursor.getText() == replaced);
+}
+
+TEST_CASE("an undo_to through a checkpoint replays from the swap file") {
+    const auto directory = ScratchDirectory();
+    const auto swap_path = SwapJournal::pathFor(directory.prefix() + "file.txt");
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"head\nbase");
+    cursor.attachSwap(std::make_unique<SwapJournal>(swap_path));
+
+    for (auto index = 0; index < 40; ++index) {
+        appendAsNewGroup(cursor, index % 3 == 0 ? u"\nline" : u" word");
+        cursor.checkpointHistory();
+    }
+
+    for (const auto steps : {5u, 20u}) {
+        CAPTURE(steps);
+        REQUIRE(cursor.undoSteps(steps).has_value());
+        cursor.getSwap()->flush();
+
+        const auto recovery = SwapJournal::recover(swap_path, u"head\nbase");
+        REQUIRE(recovery.has_value());
+        CHECK(recovery->complete);
+        CHECK(recovery->content == cursor.getText());
+    }
+}
+
+TEST_CASE("a record cut short ends the replay, flagged incomplete") {
+    const auto directory = ScratchDirectory();
+    const auto swap_path = SwapJournal::pathFor(directory.prefix() + "file.txt");
+    {
+        auto cursor = Cursor(std::make_unique<LineBuffer>());
+        cursor.attachSwap(std::make_unique<SwapJournal>(swap_path));
+        (void) cursor.insert(u"ab");
+        (void) cursor.insert(u"cd");
+        cursor.getSwap()->flush();
+
+        // Copy the swap file aside before the journal removes it, minus the last byte
+        const auto size = std::filesystem::file_size(swap_path);
+        std::filesystem::copy_file(swap_path, swap_path + ".torn");
+        std::filesystem::resize_file(swap_path + ".torn", size - 1);
+    }
+
+    const auto recovery = SwapJournal::recover(swap_path + ".torn", u"");
+    REQUIRE(recovery.has_value());
+    CHECK_FALSE(recovery->complete);
+    CHECK(recovery->edit_count == 1);
+    CHECK(recovery->content == u"ab");
+}
+
+TEST_CASE("a range that does not fit the file stops the replay") {
+    const auto directory = ScratchDirectory();
+    const auto swap_path = SwapJournal::pathFor(directory.prefix() + "file.txt");
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"one\ntwo\nthree");
+    cursor.attachSwap(std::make_unique<SwapJournal>(swap_path));
+    cursor.setPosition(2, 5);
+    (void) cursor.insert(u"!");
+    cursor.getSwap()->flush();
+
+    // The file changed under the journal: it has a single line now
+    const auto recovery = SwapJournal::recover(swap_path, u"one");
+    REQUIRE(recovery.has_value());
+    CHECK_FALSE(recovery->complete);
+    CHECK(recovery->edit_count == 0);
+    CHECK(recovery->content == u"one");
+}
+
+TEST_CASE("a snapshot replaces the journaled edits and ignores the file") {
+    const auto directory = ScratchDirectory();
+    const auto swap_path = SwapJournal::pathFor(directory.prefix() + "file.txt");
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"base");
+    cursor.attachSwap(std::make_unique<SwapJournal>(swap_path));
+
+    for (auto count = 0; count < 64; ++count) {
+        (void) cursor.insert(u"x");
+    }
+    cursor.getSwap()->flush();
+    const auto journaled_size = std::filesystem::file_size(swap_path);
+
+    cursor.compactSwap(true);
+    (void) cursor.insert(u"y");
+    cursor.getSwap()->flush();
+    CHECK(std::filesystem::file_size(swap_path) < journaled_size);
+
+    const auto recovery = SwapJournal::recover(swap_path, u"unrelated");
+    REQUIRE(recovery.has_value());
+    CHECK(recovery->complete);
+    CHECK(recovery->edit_count == 1);
+    CHECK(recovery->content == cursor.getText());
+}
+
+TEST_CASE("only a journal that outgrew the buffer wants a snapshot") {
+    const auto directory = ScratchDirectory();
+    auto journal = SwapJournal(SwapJournal::pathFor(directory.prefix() + "file.txt"));
+    const auto edit = BufferEdit{};
+    const auto text = std::u16string(1024, u'a');
+    for (auto count = 0; count < 1024; ++count) {
+        journal.record(edit, text);
+    }
+
+    // About 2 MiB journaled
+    CHECK(journal.wantsSnapshot(512 * 1024));
+    CHECK_FALSE(journal.wantsSnapshot(2 * 1024 * 1024));
+
+    journal.rebase();
+    CHECK_FALSE(journal.wantsSnapshot(0));
+}
+
+TEST_CASE("saving removes the swap file, and so does closing the buffer") {
+    const auto directory = ScratchDirectory();
+    const auto swap_path = SwapJournal::pathFor(directory.prefix() + "file.txt");
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    cursor.attachSwap(std::make_unique<SwapJournal>(swap_path));
+
+    (void) cursor.insert(u"a");
+    cursor.getSwap()->flush();
+    CHECK(std::filesystem::exists(swap_path));
+
+    cursor.setModified(false);
+    cursor.getSwap()->flush();
+    CHECK_FALSE(std::filesystem::exists(swap_path));
+
+    (void) cursor.insert(u"b");
+    cursor.getSwap()->flush();
+    CHECK(std::filesystem::exists(swap_path));
+
+    cursor.attachSwap(nullptr);
+    CHECK_FALSE(std::filesystem::exists(swap_path));
+}
+
+TEST_CASE("a swap file newer than the file, or without it, has something to recover") {
+    const auto directory = ScratchDirectory();
+    const auto file_path = directory.prefix() + "file.txt";
+    const auto swap_path = SwapJournal::pathFor(file_path);
+    CHECK_FALSE(SwapJournal::hasRecovery(file_path));
+
+    writeFile(file_path, "text");
+    CHECK_FALSE(SwapJournal::hasRecovery(file_path));
+
+    writeFile(swap_path, "BBLOCSW1");
+    const auto file_time = std::filesystem::last_write_time(file_path);
+    std::filesystem::last_write_time(swap_path, file_time + std::chrono::seconds(1));
+    CHECK(SwapJournal::hasRecovery(file_path));
+
+    // Saved after the swap file was written: the edits are on disk already
+    std::filesystem::last_write_time(swap_path, file_time - std::chrono::seconds(1));
+    CHECK_FALSE(SwapJournal::hasRecovery(file_path));
+
+    std::filesystem::remove(file_path);
+    CHECK(SwapJournal::hasRecovery(file_path));
+}
@@ -21,8 +21,10 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <filesystem>
 #include <iterator>
 #include <memory>
+#include <random>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -64,6 +66,57 @@ struct StringMaker<std::u16string> {
 }
 
 
+/** @brief A fresh directory under the system temporary directory, removed with its content on destruction. */
+struct ScratchDirectory final {
+    std::filesystem::path path; ///< The directory.
+
+    ScratchDirectory()
+        : path(std::filesystem::temp_directory_path() / ("bbloc_test_" + std::to_string(std::random_device()()))) {
+        std::filesystem::create_directories(path);
+    }
+
+    ~ScratchDirectory() {
+        auto error_code = std::error_code{};
+        std::filesystem::remove_all(path, error_code);
+    }
+
+    /** @return The directory as the history takes it: UTF-8, trailing separator included. */
+    [[nodiscard]] std::string prefix() const {
+        return (path / "").string();
+    }
+
+    /** @return The number of files in the directory. */
+    [[nodiscard]] std::size_t countFiles() const {
+        return static_cast<std::size_t>(std::distance(std::filesystem::directory_iterator(path), std::filesystem::directory_iterator()));
+    }
+};
+
+
+/**
+ * @brief Tells whether an edit describes the change between two texts, the way the highlighter reads it.
+ *
+ * @param edit The edit.
+ * @param before The text before the change.
+ * @param after The text after the change.
+ * @return true when the text outside the edit is unchanged and its positions and offsets agree.
+ */
+inline bool describes(const BufferEdit &edit, const std::u16string_view before, const std::u16string_view after) {
+    const auto start = edit.start_byte / sizeof(char16_t);
+    const auto old_end = edit.old_end_byte / sizeof(char16_t);
+    const auto new_end = edit.new_end_byte / sizeof(char16_t);
+    if (old_end > before.size() || new_end > after.size() || before.substr(0, start) != after.substr(0, start)
+        || before.substr(old_end) != after.substr(new_end)) {
+        return false;
+    }
+
+    const auto same = [](const BufferEdit::Position &left, const BufferEdit::Position &right) {
+        return left.line == right.line && left.column == right.column;
+    };
+    const auto start_position = advancePosition({.line = 0, .column = 0}, before.substr(0, start));
+    return same(edit.start, start_position)
+        && same(edit.old_end, advancePosition(start_position, before.substr(start, old_end - start)))
+        && same(edit.new_end, advancePosition(start_position, after.substr(start, new_end - start)));
+}
 
 /**
  * @brief Fills a fresh cursor with text, then drops the history and returns the caret to the origin.
@@ -479,7 +532,7 @@ inline BufferEdit applyInsert(LineBuffer &buffer, BufferModel &model, const uint
 }
 
 /**
- * @brief Erases from the buffer and the model at once, then checks the edit and the agreement.
+ * @brief Removes a range from the buffer and the model at once, then checks the edit and the agreement.
  *
  * @param buffer The buffer to edit.
  * @param model The model to apply the same erase to.
@@ -487,9 +540,11 @@ inline BufferEdit applyInsert(LineBuffer &buffer, BufferModel &model, const uint
  * @param columnStart The column the erased range starts at.
  * @param lineEnd The line the erased range ends at.
  * @param columnEnd The column the erased range ends at.
+ * @param remove Removes the range from the buffer, returning the edit.
  * @return The edit the buffer reported.
  */
-inline BufferEdit applyErase(LineBuffer &buffer, BufferModel &model, const uint32_t lineStart, const uint32_t columnStart, const uint32_t lineEnd, const uint32_t columnEnd) {
+template<typename Remove>
+BufferEdit applyRemoval(LineBuffer &buffer, BufferModel &model, const uint32_t lineStart, const uint32_t columnStart, const uint32_t lineEnd, const uint32_t columnEnd, Remove remove) {
     auto first_line = lineStart;
     auto first_column = columnStart;
     auto last_line = lineEnd;
@@ -499,7 +554,7 @@ inline BufferEdit applyErase(LineBuffer &buffer, BufferModel &model, const uint3
     const auto start_byte = modelByteOffset(model, first_line, first_column);
     const auto old_end_byte = modelByteOffset(model, last_line, last_column);
 
-    const auto edit = buffer.erase(lineStart, columnStart, lineEnd, columnEnd);
+    const auto edit = remove();
     modelErase(model, lineStart, columnStart, lineEnd, columnEnd);
 
     checkEditIsConsistent(edit);
@@ -520,6 +575,49 @@ inline BufferEdit applyErase(LineBuffer &buffer, BufferModel &model, const uint3
     return edit;
 }
 
+/**
+ * @brief Erases from the buffer and the model at once, then checks the edit and the agreement.
+ *
+ * @param buffer The buffer to edit.
+ * @param model The model to apply the same erase to.
+ * @param lineStart The line the erased range starts at.
+ * @param columnStart The column the erased range starts at.
+ * @param lineEnd The line the erased range ends at.
+ * @param columnEnd The column the erased range ends at.
+ * @return The edit the buffer reported.
+ */
+inline BufferEdit applyErase(LineBuffer &buffer, BufferModel &model, const uint32_t lineStart, const uint32_t columnStart, const uint32_t lineEnd, const uint32_t columnEnd) {
+    return applyRemoval(buffer, model, lineStart, columnStart, lineEnd, columnEnd, [&] {
+        return buffer.erase(lineStart, columnStart, lineEnd, columnEnd);
+    });
+}
+
+/**
+ * @brief Extracts from the buffer and erases from the model at once, then checks the edit, the text
+ * handed over and the agreement.
+ *
+ * @param buffer The buffer to edit.
+ * @param model The model to apply the same erase to.
+ * @param lineStart The line the extracted range starts at.
+ * @param columnStart The column the extracted range starts at.
+ * @param lineEnd The line the extracted range ends at.
+ * @param columnEnd The column the extracted range ends at.
+ * @return The edit the buffer reported.
+ */
+inline BufferEdit applyExtract(LineBuffer &buffer, BufferModel &model, const uint32_t lineStart, const uint32_t columnStart, const uint32_t lineEnd, const uint32_t columnEnd) {
+    const auto text = joinLines(model);
+    const auto from = modelByteOffset(model, lineStart, columnStart) / sizeof(char16_t);
+    const auto to = modelByteOffset(model, lineEnd, columnEnd) / sizeof(char16_t);
+    const auto expected = text.substr(std::min(from, to), std::max(from, to) - std::min(from, to));
+
+    auto removed = std::u16string{u"stale"};
+    const auto edit = applyRemoval(buffer, model, lineStart, columnStart, lineEnd, columnEnd, [&] {
+        return buffer.extract(lineStart, columnStart, lineEnd, columnEnd, removed);
+    });
+    CHECK(removed == expected);
+    return edit;
+}
+
 
 
 #endif //TEST_SUPPORT_H
@@ -0,0 +1,207 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstddef>
+#include <string>
+
+#include "TestSupport.h"
+
+#include "core/cursor/UndoArena.h"
+
+
+TEST_CASE("an empty arena allocates nothing and reads back empty spans") {
+    auto arena = UndoArena();
+    CHECK(arena.getMemoryUsage() == 0);
+    CHECK(arena.end() == UndoArena::ORIGIN);
+
+    const auto span = arena.append(u"");
+    CHECK(span.length == 0);
+    CHECK(arena.view(span).empty());
+    CHECK(arena.getMemoryUsage() == 0);
+}
+
+TEST_CASE("appended texts sit back to back and read back intact") {
+    auto arena = UndoArena();
+    const auto first = arena.append(u"hello");
+    const auto second = arena.append(u"world");
+
+    CHECK(first.position == UndoArena::ORIGIN);
+    CHECK(second.position == UndoArena::ORIGIN + 5);
+    CHECK(arena.end() == UndoArena::ORIGIN + 10);
+    CHECK(arena.view(first) == u"hello");
+    CHECK(arena.view(second) == u"world");
+    CHECK(arena.getMemoryUsage() == UndoArena::CHUNK_UNITS * sizeof(char16_t));
+}
+
+TEST_CASE("only the span at the back grows in place") {
+    auto arena = UndoArena();
+    auto first = arena.append(u"ab");
+    CHECK(arena.isBack(first));
+
+    arena.extend(first, u"cd");
+    CHECK(arena.view(first) == u"abcd");
+
+    auto second = arena.append(u"xy");
+    CHECK_FALSE(arena.isBack(first));
+    CHECK(arena.isBack(second));
+
+    arena.prepend(second, u"uvw");
+    CHECK(arena.view(second) == u"uvwxy");
+    CHECK(arena.view(first) == u"abcd");
+}
+
+TEST_CASE("a span outgrowing its chunk moves along and keeps its position") {
+    auto arena = UndoArena();
+    const auto filler = arena.append(std::u16string(UndoArena::CHUNK_UNITS - 3, u'f'));
+    auto typed = arena.append(u"ab");
+
+    // One character at a time, as typing does, well past the end of the first chunk
+    auto expected = std::u16string(u"ab");
+    for (auto i = 0; i < 100; ++i) {
+        const auto character = static_cast<char16_t>(u'a' + i % 26);
+        arena.extend(typed, std::u16string(1, character));
+        expected.push_back(character);
+    }
+
+    CHECK(typed.position == UndoArena::ORIGIN + UndoArena::CHUNK_UNITS - 3);
+    CHECK(arena.view(typed) == expected);
+    CHECK(arena.view(filler) == std::u16string(UndoArena::CHUNK_UNITS - 3, u'f'));
+    CHECK(arena.end() == typed.position + typed.length);
+}
+
+TEST_CASE("a backspace run prepends across a chunk boundary in reading order") {
+    auto arena = UndoArena();
+    (void) arena.append(std::u16string(UndoArena::CHUNK_UNITS - 1, u'f'));
+    auto removed = arena.append(u"z");
+
+    auto expected = std::u16string(u"z");
+    for (auto i = 0; i < 10; ++i) {
+        const auto character = static_cast<char16_t>(u'a' + i);
+        arena.prepend(removed, std::u16string(1, character));
+        expected.insert(expected.begin(), character);
+    }
+
+    CHECK(arena.view(removed) == expected);
+}
+
+TEST_CASE("a text longer than a chunk gets a chunk of its own") {
+    auto arena = UndoArena();
+    const auto small = arena.append(u"small");
+    const auto large = arena.append(std::u16string(UndoArena::CHUNK_UNITS * 2, u'l'));
+
+    CHECK(arena.view(small) == u"small");
+    CHECK(arena.view(large) == std::u16string(UndoArena::CHUNK_UNITS * 2, u'l'));
+    CHECK(arena.getMemoryUsage() == UndoArena::CHUNK_UNITS * 3 * sizeof(char16_t));
+}
+
+TEST_CASE("an adopted text is read in place and never written to") {
+    auto arena = UndoArena();
+    const auto text = std::make_shared<const std::u16string>(UndoArena::CHUNK_UNITS * 2, u'a');
+    const auto before = arena.append(u"before");
+    auto adopted = arena.adopt(text);
+
+    // No copy: the span reads the very storage that was handed over, and weighs it once
+    CHECK(adopted.position == before.position + before.length);
+    CHECK(arena.view(adopted).data() == text->data());
+    CHECK(arena.getMemoryUsage() == UndoArena::CHUNK_UNITS * 3 * sizeof(char16_t));
+
+    // Text stored next goes to a chunk of its own, and growing the adopted span copies it along
+    const auto after = arena.append(u"after");
+    CHECK(arena.view(after) == u"after");
+    arena.truncate(after.position);
+    arena.extend(adopted, u"b");
+    CHECK(arena.view(adopted).data() != text->data());
+    CHECK(arena.view(adopted) == std::u16string(UndoArena::CHUNK_UNITS * 2, u'a') + u"b");
+    CHECK(*text == std::u16string(UndoArena::CHUNK_UNITS * 2, u'a'));
+    CHECK(text.use_count() == 1);
+    CHECK(arena.view(before) == u"before");
+
+    // Truncating into an adopted text must not open it to the next text either
+    const auto second = std::make_shared<const std::u16string>(UndoArena::CHUNK_UNITS, u'c');
+    const auto readopted = arena.adopt(second);
+    arena.truncate(readopted.position + 10);
+    (void) arena.append(u"next");
+    CHECK(*second == std::u16string(UndoArena::CHUNK_UNITS, u'c'));
+    arena.truncate(readopted.position);
+    CHECK(second.use_count() == 1);
+}
+
+TEST_CASE("releasing from the front frees only the chunks holding older text") {
+    auto arena = UndoArena();
+    const auto old_text = arena.append(std::u16string(UndoArena::CHUNK_UNITS, u'o'));
+    const auto kept = arena.append(u"kept");
+    const auto newest = arena.append(u"new");
+
+    // The chunk of the old text holds nothing else: it is kept as the spare, not freed
+    arena.releaseBefore(kept.position);
+    CHECK(arena.view(kept) == u"kept");
+    CHECK(arena.view(newest) == u"new");
+    CHECK(arena.getMemoryUsage() == UndoArena::CHUNK_UNITS * 2 * sizeof(char16_t));
+    CHECK(old_text.position == UndoArena::ORIGIN);
+
+    // A release inside a chunk leaves it in place
+    arena.releaseBefore(newest.position);
+    CHECK(arena.view(newest) == u"new");
+    CHECK(arena.getMemoryUsage() == UndoArena::CHUNK_UNITS * 2 * sizeof(char16_t));
+}
+
+TEST_CASE("text stored in front sorts below everything else") {
+    auto arena = UndoArena();
+    const auto front_of_empty = arena.storeFront(u"first");
+    CHECK(front_of_empty.position == UndoArena::ORIGIN);
+
+    const auto later = arena.append(u"later");
+    const auto older = arena.storeFront(u"older");
+    CHECK(older.position + older.length == front_of_empty.position);
+    CHECK(arena.view(older) == u"older");
+    CHECK(arena.view(front_of_empty) == u"first");
+    CHECK(arena.view(later) == u"later");
+
+    // Releasing up to the text that was there first frees the front chunk only
+    arena.releaseBefore(front_of_empty.position);
+    CHECK(arena.view(front_of_empty) == u"first");
+    CHECK(arena.view(later) == u"later");
+}
+
+TEST_CASE("truncating cuts the back off and stores the next text there") {
+    auto arena = UndoArena();
+    const auto kept = arena.append(u"kept");
+    const auto dropped = arena.append(std::u16string(UndoArena::CHUNK_UNITS, u'd'));
+
+    arena.truncate(dropped.position);
+    CHECK(arena.end() == dropped.position);
+    CHECK(arena.view(kept) == u"kept");
+
+    const auto next = arena.append(u"next");
+    CHECK(next.position == dropped.position);
+    CHECK(arena.view(next) == u"next");
+    CHECK(arena.view(kept) == u"kept");
+}
+
+TEST_CASE("a cleared arena reuses its spare chunk") {
+    auto arena = UndoArena();
+    (void) arena.append(u"first");
+    arena.clear();
+    CHECK(arena.end() == UndoArena::ORIGIN);
+    CHECK(arena.getMemoryUsage() == UndoArena::CHUNK_UNITS * sizeof(char16_t));
+
+    const auto span = arena.append(u"second");
+    CHECK(span.position == UndoArena::ORIGIN);
+    CHECK(arena.view(span) == u"second");
+    CHECK(arena.getMemoryUsage() == UndoArena::CHUNK_UNITS * sizeof(char16_t));
+}
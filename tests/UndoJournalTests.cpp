@@ -0,0 +1,130 @@
+/*
+* Copyright (C) 2026 Romain Graillot
+ *
+ * This file is part of bbloc.
+ *
+ * bbloc is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bbloc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "TestSupport.h"
+
+#include "core/cursor/UndoJournal.h"
+
+
+/**
+ * @brief Pushes a record made of a header and texts.
+ *
+ * @param journal The journal to push to.
+ * @param header The header bytes.
+ * @param first The first text.
+ * @param second The second text.
+ * @return What push returned.
+ */
+static bool pushRecord(UndoJournal &journal, const std::string_view header, const std::u16string_view first, const std::u16string_view second) {
+    const auto texts = std::array{first, second};
+    return journal.push(std::span(header.data(), header.size()), texts);
+}
+
+/**
+ * @brief Builds the bytes a record made of a header and texts is read back as.
+ *
+ * @param header The header bytes.
+ * @param text The texts, back to back.
+ * @return The bytes.
+ */
+static std::vector<char> recordBytes(const std::string_view header, const std::u16string_view text) {
+    auto bytes = std::vector<char>(header.begin(), header.end());
+    const auto *const units = reinterpret_cast<const char *>(text.data());
+    bytes.insert(bytes.end(), units, units + text.size() * sizeof(char16_t));
+    return bytes;
+}
+
+
+TEST_CASE("an unused journal creates no file") {
+    const auto directory = ScratchDirectory();
+    {
+        auto journal = UndoJournal(directory.prefix() + "journal");
+        auto record = std::vector<char>();
+        CHECK_FALSE(journal.pop(record));
+        CHECK(journal.getCount() == 0);
+        CHECK(directory.countFiles() == 0);
+    }
+    CHECK(directory.countFiles() == 0);
+}
+
+TEST_CASE("records come back last in first out, header and texts intact") {
+    const auto directory = ScratchDirectory();
+    auto journal = UndoJournal(directory.prefix() + "journal");
+
+    REQUIRE(pushRecord(journal, "first", u"ab", u"cd"));
+    REQUIRE(pushRecord(journal, "second", u"", u"efgh"));
+    CHECK(journal.getCount() == 2);
+    CHECK(journal.getDiskUsage() == 5 + 4 * sizeof(char16_t) + 6 + 4 * sizeof(char16_t));
+
+    auto record = std::vector<char>();
+    REQUIRE(journal.pop(record));
+    CHECK(record == recordBytes("second", u"efgh"));
+    REQUIRE(journal.pop(record));
+    CHECK(record == recordBytes("first", u"abcd"));
+    CHECK_FALSE(journal.pop(record));
+    CHECK(journal.getDiskUsage() == 0);
+}
+
+TEST_CASE("a record pushed after a pop is written over the popped one") {
+    const auto directory = ScratchDirectory();
+    auto journal = UndoJournal(directory.prefix() + "journal");
+
+    REQUIRE(pushRecord(journal, "kept", u"k", u""));
+    REQUIRE(pushRecord(journal, "popped and long", u"long text", u"more text"));
+    auto record = std::vector<char>();
+    REQUIRE(journal.pop(record));
+
+    REQUIRE(pushRecord(journal, "new", u"n", u""));
+    REQUIRE(journal.pop(record));
+    CHECK(record == recordBytes("new", u"n"));
+    REQUIRE(journal.pop(record));
+    CHECK(record == recordBytes("kept", u"k"));
+}
+
+TEST_CASE("a cleared journal starts over and its file goes with it") {
+    const auto directory = ScratchDirectory();
+    {
+        auto journal = UndoJournal(directory.prefix() + "journal");
+        REQUIRE(pushRecord(journal, "one", u"1", u""));
+        CHECK(directory.countFiles() == 1);
+
+        journal.clear();
+        CHECK(journal.getCount() == 0);
+        REQUIRE(pushRecord(journal, "two", u"2", u""));
+
+        auto record = std::vector<char>();
+        REQUIRE(journal.pop(record));
+        CHECK(record == recordBytes("two", u"2"));
+        CHECK_FALSE(journal.pop(record));
+    }
+    CHECK(directory.countFiles() == 0);
+}
+
+TEST_CASE("a journal that cannot create its file refuses records") {
+    const auto directory = ScratchDirectory();
+    auto journal = UndoJournal(directory.prefix() + "missing/journal");
+
+    CHECK_FALSE(pushRecord(journal, "header", u"text", u""));
+    CHECK_FALSE(journal.isUsable());
+    CHECK(journal.getCount() == 0);
+}
@@ -19,6 +19,23 @@
 #include "TestSupport.h"
 
 
+/**
+ * @brief Appends a number of groups, each one a line of its own, letting the history checkpoint between them.
+ *
+ * @param cursor The cursor to edit.
+ * @param count The number of groups.
+ * @param checkpoints Whether to take the checkpoints the main loop would.
+ */
+static void appendLines(Cursor &cursor, const uint32_t count, const bool checkpoints) {
+    for (auto index = 0u; index < count; ++index) {
+        appendAsNewGroup(cursor, u"\nline " + std::u16string(1, static_cast<char16_t>(u'a' + index % 26)));
+        if (checkpoints) {
+            cursor.checkpointHistory();
+        }
+    }
+}
+
+
 TEST_CASE("a seeded buffer holds its text and an empty history") {
     auto cursor = Cursor(std::make_unique<LineBuffer>());
     seed(cursor, u"hello");
@@ -212,6 +229,27 @@ TEST_CASE("a backspace run inside one line is a single undo step") {
     CHECK(cursor.getText() == std::u16string(u"abcdef"));
 }
 
+TEST_CASE("a typed run longer than an arena chunk is a single undo step") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"");
+
+    // A first group fills most of the first chunk, so the run moves to the next one mid-way
+    appendAsNewGroup(cursor, std::u16string(UndoArena::CHUNK_UNITS - 10, u'x'));
+    cursor.moveToEndOfLine();
+    auto typed = std::u16string();
+    for (auto i = 0; i < 100; ++i) {
+        typed.push_back(static_cast<char16_t>(u'a' + i % 26));
+    }
+    type(cursor, typed);
+
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(UndoArena::CHUNK_UNITS - 10, u'x'));
+    REQUIRE(redoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(UndoArena::CHUNK_UNITS - 10, u'x') + typed);
+    CHECK(undoAll(cursor) == 2);
+    CHECK(cursor.getText().empty());
+}
+
 TEST_CASE("erasing a non-BMP character takes the whole pair and undo restores it") {
     const auto grin = std::u16string(u"\U0001F600");
     REQUIRE(grin.length() == 2);
@@ -410,3 +448,558 @@ TEST_CASE("loading content starts the buffer clean") {
     REQUIRE(undoAll(cursor) == 1);
     CHECK_FALSE(cursor.isModified());
 }
+
+TEST_CASE("appended content stays out of the history") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    (void) cursor.loadContent(u"one");
+    type(cursor, u"x");
+    REQUIRE(cursor.getText() == std::u16string(u"xone"));
+
+    (void) cursor.appendContent(u"\ntwo");
+    (void) cursor.appendContent(u" three\n");
+    CHECK(cursor.getText() == std::u16string(u"xone\ntwo three\n"));
+    CHECK(cursor.getLine() == 0);
+    CHECK(cursor.getColumn() == 1);
+
+    // Undo takes the typing back and leaves the appended text alone
+    CHECK(undoAll(cursor) == 1);
+    CHECK(cursor.getText() == std::u16string(u"one\ntwo three\n"));
+    CHECK(redoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"xone\ntwo three\n"));
+}
+
+TEST_CASE("the retained character count follows the history") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"");
+    CHECK(cursor.getHistoryCharacters() == 0);
+
+    appendAsNewGroup(cursor, u"abc");
+    appendAsNewGroup(cursor, u"de");
+    CHECK(cursor.getHistoryCharacters() == 5);
+
+    // Undone steps stay retained on the redo side until an edit drops them
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getHistoryCharacters() == 5);
+    appendAsNewGroup(cursor, u"x");
+    CHECK(cursor.getHistoryCharacters() == 4);
+
+    (void) cursor.loadContent(u"fresh");
+    CHECK(cursor.getHistoryCharacters() == 0);
+}
+
+TEST_CASE("dropped history text is reclaimed rather than accumulated") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"");
+
+    auto max_undo = std::make_shared<CVarInt>(2);
+    cursor.shareMaxHistoryDepth(max_undo);
+
+    // Every group fills a chunk: only the ones still in the history, and one spare, stay allocated
+    const auto chunk = std::u16string(UndoArena::CHUNK_UNITS, u'c');
+    for (auto i = 0; i < 8; ++i) {
+        appendAsNewGroup(cursor, chunk);
+    }
+    CHECK(cursor.getHistoryMemory() <= UndoArena::CHUNK_UNITS * 3 * sizeof(char16_t));
+
+    // An edit after an undo cuts the undone text off the back
+    REQUIRE(undoStep(cursor));
+    appendAsNewGroup(cursor, u"x");
+    CHECK(cursor.getHistoryMemory() <= UndoArena::CHUNK_UNITS * 3 * sizeof(char16_t));
+    CHECK(undoAll(cursor) == 2);
+    CHECK(cursor.getText() == std::u16string(UndoArena::CHUNK_UNITS * 6, u'c'));
+}
+
+TEST_CASE("a large selection erase is held once and undoes on its own") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    auto content = std::u16string{};
+    for (auto line = 0; line < 20000; ++line) {
+        content.append(u"some line of text ").append(1, static_cast<char16_t>(u'a' + line % 26)).append(u"\n");
+    }
+    content.append(u"end");
+    seed(cursor, content);
+    const auto buffer_memory = cursor.getBufferMemory().text;
+
+    // Everything but the first and the last characters
+    select(cursor, 0, 1, 20000, 2);
+    REQUIRE(cursor.eraseSelection().has_value());
+    CHECK(cursor.getText() == std::u16string(u"sd"));
+
+    // The history holds the erased text once, and the buffer no longer keeps room for it
+    const auto erased = (content.length() - 2) * sizeof(char16_t);
+    CHECK(cursor.getHistoryCharacters() == content.length() - 2);
+    CHECK(cursor.getHistoryMemory() < erased + UndoArena::CHUNK_UNITS * 2 * sizeof(char16_t));
+    CHECK(cursor.getBufferMemory().text < buffer_memory / 2);
+
+    // A backspace right after it is a step of its own, not merged into the erased text
+    REQUIRE(cursor.eraseLeft().has_value());
+    CHECK(cursor.getText() == std::u16string(u"d"));
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"sd"));
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == content);
+    REQUIRE(redoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"sd"));
+}
+
+TEST_CASE("with a journal the entry cap only bounds memory, and undo reaches the first step") {
+    const auto directory = ScratchDirectory();
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"");
+    cursor.enableHistoryJournal(directory.prefix());
+
+    auto max_undo = std::make_shared<CVarInt>(2);
+    cursor.shareMaxHistoryDepth(max_undo);
+
+    for (const auto *const text : {u"a", u"b", u"c", u"d", u"e", u"f"}) {
+        appendAsNewGroup(cursor, text);
+    }
+    CHECK(cursor.getHistoryCharacters() == 2);
+
+    // Every step comes back, paged from the undo journal, then from the redo journal going forward
+    CHECK(undoAll(cursor) == 6);
+    CHECK(cursor.getText().empty());
+    CHECK(cursor.getLine() == 0);
+    CHECK(cursor.getColumn() == 0);
+
+    auto redone = 0;
+    while (redoStep(cursor)) {
+        ++redone;
+    }
+    CHECK(redone == 6);
+    CHECK(cursor.getText() == std::u16string(u"abcdef"));
+}
+
+TEST_CASE("a journaled typed run with backspaces pages back as one step") {
+    const auto directory = ScratchDirectory();
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"line");
+    cursor.enableHistoryJournal(directory.prefix());
+
+    auto max_undo = std::make_shared<CVarInt>(1);
+    cursor.shareMaxHistoryDepth(max_undo);
+
+    cursor.moveToEndOfLine();
+    for (auto i = 0; i < 2; ++i) {
+        (void) cursor.eraseLeft();
+    }
+    appendAsNewGroup(cursor, u" typed");
+    appendAsNewGroup(cursor, u"!");
+    REQUIRE(cursor.getText() == std::u16string(u"li typed!"));
+
+    REQUIRE(undoStep(cursor));
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"li"));
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"line"));
+    CHECK(cursor.getColumn() == 4);
+    CHECK_FALSE(undoStep(cursor));
+}
+
+TEST_CASE("a saved state spilled to the journal is reached again") {
+    const auto directory = ScratchDirectory();
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"");
+    cursor.enableHistoryJournal(directory.prefix());
+
+    auto max_undo = std::make_shared<CVarInt>(2);
+    cursor.shareMaxHistoryDepth(max_undo);
+
+    appendAsNewGroup(cursor, u"a");
+    cursor.setModified(false);
+    for (const auto *const text : {u"b", u"c", u"d", u"e"}) {
+        appendAsNewGroup(cursor, text);
+    }
+
+    for (auto i = 0; i < 4; ++i) {
+        REQUIRE(undoStep(cursor));
+    }
+    CHECK(cursor.getText() == std::u16string(u"a"));
+    CHECK_FALSE(cursor.isModified());
+
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.isModified());
+}
+
+TEST_CASE("an edit after undoing into the journal drops the spilled redo steps") {
+    const auto directory = ScratchDirectory();
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"");
+    cursor.enableHistoryJournal(directory.prefix());
+
+    auto max_undo = std::make_shared<CVarInt>(2);
+    cursor.shareMaxHistoryDepth(max_undo);
+
+    for (const auto *const text : {u"a", u"b", u"c", u"d", u"e", u"f"}) {
+        appendAsNewGroup(cursor, text);
+    }
+    for (auto i = 0; i < 5; ++i) {
+        REQUIRE(undoStep(cursor));
+    }
+    REQUIRE(cursor.getText() == std::u16string(u"a"));
+
+    appendAsNewGroup(cursor, u"x");
+    CHECK_FALSE(redoStep(cursor));
+    CHECK(undoAll(cursor) == 2);
+    CHECK(cursor.getText().empty());
+}
+
+TEST_CASE("a journal that cannot be written falls back to dropping the oldest steps") {
+    const auto directory = ScratchDirectory();
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"");
+    cursor.enableHistoryJournal(directory.prefix() + "missing/");
+
+    auto max_undo = std::make_shared<CVarInt>(3);
+    cursor.shareMaxHistoryDepth(max_undo);
+
+    for (const auto *const text : {u"a", u"b", u"c", u"d", u"e", u"f"}) {
+        appendAsNewGroup(cursor, text);
+    }
+    CHECK(undoAll(cursor) == 3);
+    CHECK(cursor.getText() == std::u16string(u"abc"));
+}
+
+TEST_CASE("a batch is one undo step keeping only the replaced pieces") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    auto content = std::u16string(u"line 0");
+    for (auto line = 1; line < 1000; ++line) {
+        content.append(u"\nline ").append(1, static_cast<char16_t>(u'0' + line % 10));
+    }
+    seed(cursor, content);
+
+    // Indent every line, the way a block indent would
+    cursor.beginBatch();
+    for (auto line = 0u; line < 1000; ++line) {
+        cursor.batchReplace(TextRange{.line_start = line, .column_start = 0, .line_end = line, .column_end = 0}, u"\t");
+    }
+    const auto edit = cursor.commitBatch();
+    REQUIRE(edit.has_value());
+    const auto indented = cursor.getText();
+    CHECK(indented.starts_with(u"\tline 0\n\tline 1"));
+    CHECK(describes(*edit, content, indented));
+    CHECK(cursor.getLine() == 999);
+    CHECK(cursor.getColumn() == 1);
+    CHECK(cursor.getHistoryCharacters() == 1000);
+
+    const auto undone = cursor.undo();
+    REQUIRE(undone.size() == 1);
+    CHECK(cursor.getText() == content);
+    CHECK(describes(undone.front(), indented, content));
+    CHECK_FALSE(undoStep(cursor));
+
+    const auto redone = cursor.redo();
+    REQUIRE(redone.size() == 1);
+    CHECK(cursor.getText() == indented);
+    CHECK(describes(redone.front(), content, indented));
+}
+
+TEST_CASE("random batches undo, redo and travel like the same replacements made one by one") {
+    auto random = std::mt19937(0x62617463);
+    const auto pieces = std::vector<std::u16string_view>{u"", u"x", u"yz", u"\n", u"a\nb", u"\n\n"};
+
+    for (auto round = 0; round < 200; ++round) {
+        CAPTURE(round);
+        auto cursor = Cursor(std::make_unique<LineBuffer>());
+        auto expected = Cursor(std::make_unique<LineBuffer>());
+        const auto content = std::u16string(u"first\nsecond\n\nthird line\nlast");
+        seed(cursor, content);
+        seed(expected, content);
+
+        auto offsets = std::vector<uint32_t>{};
+        for (auto count = 2 + random() % 6; count > 0; --count) {
+            offsets.push_back(static_cast<uint32_t>(random() % (content.length() + 1)));
+            offsets.push_back(static_cast<uint32_t>(random() % (content.length() + 1)));
+        }
+        std::ranges::sort(offsets);
+
+        // The same replacements through replace(), from the last to the first so none moves another
+        auto ranges = std::vector<std::pair<TextRange, std::u16string_view>>{};
+        cursor.beginBatch();
+        for (auto i = std::size_t{0}; i < offsets.size(); i += 2) {
+            const auto start = advancePosition({.line = 0, .column = 0}, std::u16string_view(content).substr(0, offsets[i]));
+            const auto end = advancePosition({.line = 0, .column = 0}, std::u16string_view(content).substr(0, offsets[i + 1]));
+            const auto range = TextRange{.line_start = start.line, .column_start = start.column, .line_end = end.line, .column_end = end.column};
+            ranges.emplace_back(range, pieces[random() % pieces.size()]);
+            cursor.batchReplace(range, ranges.back().second);
+        }
+        for (auto it = ranges.rbegin(); it != ranges.rend(); ++it) {
+            (void) expected.replace(it->first, it->second);
+        }
+
+        const auto edit = cursor.commitBatch();
+        REQUIRE(edit.has_value());
+        const auto replaced = cursor.getText();
+        CHECK(replaced == expected.getText());
+        CHECK(describes(*edit, content, replaced));
+
+        // A batch that changed nothing recorded nothing
+        if (replaced == content) {
+            CHECK_FALSE(undoStep(cursor));
+            continue;
+        }
+
+        REQUIRE(undoStep(cursor));
+        CHECK(cursor.getText() == content);
+        REQUIRE(redoStep(cursor));
+        CHECK(cursor.getText() == replaced);
+
+        // undo_to replays the group edit by edit rather than in one splice, and must agree
+        REQUIRE(cursor.undoToSaved().has_value());
+        CHECK(cursor.getText() == content);
+        REQUIRE(redoStep(cursor));
+        CHECK(cursor.getText() == replaced);
+    }
+}
+
+TEST_CASE("undo_to saved crosses every group as one edit") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"base");
+
+    const auto memory = cursor.getHistoryMemory();
+    appendLines(cursor, 50, true);
+    CHECK(cursor.getHistoryMemory() > memory);      // the checkpoints hold copies of the buffer
+
+    const auto before = cursor.getText();
+    const auto edit = cursor.undoToSaved();
+    REQUIRE(edit.has_value());
+    CHECK(cursor.getText() == std::u16string(u"base"));
+    CHECK_FALSE(cursor.isModified());
+    CHECK(describes(*edit, before, cursor.getText()));
+    CHECK(cursor.getLine() == 0);
+    CHECK(cursor.getColumn() == 4);
+
+    // The history is where a step-by-step undo would have left it
+    REQUIRE(redoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"base\nline a"));
+    REQUIRE(cursor.undoToSaved().has_value());
+    CHECK(cursor.getText() == std::u16string(u"base"));
+}
+
+TEST_CASE("undo_to saved redoes forward to a saved state ahead") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"");
+    appendLines(cursor, 30, true);
+    cursor.setModified(false);
+    const auto saved = cursor.getText();
+    appendLines(cursor, 10, true);
+
+    REQUIRE(undoAll(cursor) == 40);
+    const auto before = cursor.getText();
+    const auto edit = cursor.undoToSaved();
+    REQUIRE(edit.has_value());
+    CHECK(cursor.getText() == saved);
+    CHECK_FALSE(cursor.isModified());
+    CHECK(describes(*edit, before, saved));
+
+    // Already there: nothing to do
+    CHECK_FALSE(cursor.undoToSaved().has_value());
+}
+
+TEST_CASE("undo_to a number of steps matches as many undos, with or without checkpoints") {
+    for (const auto steps : {1u, 5u, 16u, 23u, 49u, 60u}) {
+        CAPTURE(steps);
+        auto checkpointed = Cursor(std::make_unique<LineBuffer>());
+        auto plain = Cursor(std::make_unique<LineBuffer>());
+        seed(checkpointed, u"start");
+        seed(plain, u"start");
+        appendLines(checkpointed, 50, true);
+        appendLines(plain, 50, false);
+
+        const auto before = checkpointed.getText();
+        const auto edit = checkpointed.undoSteps(steps);
+        for (auto step = 0u; step < steps && undoStep(plain); ++step) {}
+
+        REQUIRE(edit.has_value());
+        CHECK(checkpointed.getText() == plain.getText());
+        CHECK(checkpointed.getLine() == plain.getLine());
+        CHECK(checkpointed.getColumn() == plain.getColumn());
+        CHECK(describes(*edit, before, checkpointed.getText()));
+
+        // Both histories go on from the same state
+        CHECK(redoStep(checkpointed) == redoStep(plain));
+        CHECK(checkpointed.getText() == plain.getText());
+    }
+}
+
+TEST_CASE("undo_to spans only what the groups it crosses touched") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    auto header = std::u16string{};
+    for (auto index = 0; index < 200; ++index) {
+        header.append(u"header line\n");
+    }
+    seed(cursor, header + u"base");
+    cursor.setPosition(200, 0);
+    appendLines(cursor, 40, true);
+
+    // From a checkpoint or group by group, the untouched header stays out of the edit
+    for (const auto steps : {3u, 30u}) {
+        CAPTURE(steps);
+        const auto before = cursor.getText();
+        const auto edit = cursor.undoSteps(steps);
+        REQUIRE(edit.has_value());
+        CHECK(describes(*edit, before, cursor.getText()));
+        CHECK(edit->start.line == cursor.getLineCount() - 1);
+        CHECK(edit->start_byte > header.length() * sizeof(char16_t));
+    }
+
+    const auto before = cursor.getText();
+    const auto edit = cursor.undoToSaved();
+    REQUIRE(edit.has_value());
+    CHECK(cursor.getText() == header + u"base");
+    CHECK(describes(*edit, before, cursor.getText()));
+    CHECK(edit->start.line == 200);
+    CHECK(edit->start.column == 4);
+}
+
+TEST_CASE("random undo_to moves describe the change and match as many undos") {
+    auto random = std::mt19937(0x74726176);
+    const auto pieces = std::vector<std::u16string_view>{u"", u"x", u"yz", u"\n", u"a\nb", u"\n\n"};
+
+    for (auto round = 0; round < 100; ++round) {
+        CAPTURE(round);
+        auto cursor = Cursor(std::make_unique<LineBuffer>());
+        auto plain = Cursor(std::make_unique<LineBuffer>());
+        seed(cursor, u"first\nsecond\n\nthird line\nlast");
+        seed(plain, u"first\nsecond\n\nthird line\nlast");
+
+        // Groups anywhere in the text, some of them cancelling others, with checkpoints in between
+        const auto group_count = 10 + random() % 40;
+        const auto saved_at = random() % group_count;
+        for (auto group = 0u; group < group_count; ++group) {
+            const auto text = cursor.getText();
+            const auto [first, last] = std::minmax({random() % (text.length() + 1), random() % (text.length() + 1)});
+            const auto start = advancePosition({.line = 0, .column = 0}, std::u16string_view(text).substr(0, first));
+            const auto end = advancePosition({.line = 0, .column = 0}, std::u16string_view(text).substr(0, last));
+            const auto range = TextRange{.line_start = start.line, .column_start = start.column, .line_end = end.line, .column_end = end.column};
+            const auto piece = pieces[random() % pieces.size()];
+            for (auto *const target : {&cursor, &plain}) {
+                target->setPosition(start.line, start.column);
+                (void) target->replace(range, piece);
+            }
+            cursor.checkpointHistory();
+            if (group == saved_at) {
+                cursor.setModified(false);
+            }
+        }
+        REQUIRE(cursor.getText() == plain.getText());
+
+        const auto steps = 1 + random() % group_count;
+        auto before = cursor.getText();
+        if (const auto edit = cursor.undoSteps(steps)) {
+            CHECK(describes(*edit, before, cursor.getText()));
+        }
+        for (auto step = 0u; step < steps && undoStep(plain); ++step) {}
+        CHECK(cursor.getText() == plain.getText());
+
+        before = cursor.getText();
+        if (const auto edit = cursor.undoToSaved()) {
+            CHECK(describes(*edit, before, cursor.getText()));
+            CHECK_FALSE(cursor.isModified());
+        }
+    }
+}
+
+TEST_CASE("a checkpoint of a discarded branch is never restored") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"root");
+    appendLines(cursor, 32, true);
+
+    // The checkpoints past this point describe states the new branch replaces
+    const auto branch_point = cursor.getText();
+    REQUIRE(cursor.undoSteps(20).has_value());
+    const auto branch_text = cursor.getText();
+    appendAsNewGroup(cursor, u" branch");
+    const auto branched = cursor.getText();
+    appendLines(cursor, 3, true);
+
+    const auto edit = cursor.undoSteps(4);
+    REQUIRE(edit.has_value());
+    CHECK(cursor.getText() == branch_text);
+    REQUIRE(redoStep(cursor));
+    CHECK(cursor.getText() == branched);
+    CHECK(cursor.getText() != branch_point);
+}
+
+TEST_CASE("undo_to reports when the history cannot move") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"text");
+    CHECK_FALSE(cursor.undoToSaved().has_value());
+    CHECK_FALSE(cursor.undoSteps(3).has_value());
+
+    // A saved state stranded on a discarded branch is out of reach
+    appendAsNewGroup(cursor, u"1");
+    cursor.setModified(false);
+    REQUIRE(undoStep(cursor));
+    appendAsNewGroup(cursor, u"2");
+    CHECK_FALSE(cursor.undoToSaved().has_value());
+    CHECK(cursor.undoSteps(3).has_value());
+    CHECK(cursor.getText() == std::u16string(u"text"));
+}
+
+TEST_CASE("a held undo group gathers edits across moves into one step") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"a\nb\nc");
+    appendAsNewGroup(cursor, u"1");
+    const auto before_hold = cursor.getText();
+
+    // What a replayed macro does to every line: each move would otherwise close the group
+    cursor.holdUndoGroup(true);
+    for (auto line = 0u; line < 3; ++line) {
+        cursor.setPosition(line, 0);
+        type(cursor, u"> ");
+        cursor.moveToEndOfLine();
+        (void) cursor.eraseLeft();
+        type(cursor, u";");
+    }
+    cursor.holdUndoGroup(false);
+    CHECK(cursor.getText() == std::u16string(u"> a;\n> ;\n> ;"));
+
+    // The edits after the release open their own group again
+    appendAsNewGroup(cursor, u"!");
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"> a;\n> ;\n> ;"));
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == before_hold);
+    REQUIRE(redoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"> a;\n> ;\n> ;"));
+}
+
+TEST_CASE("an undo while a group is held moves it away, and the next edit holds a new one") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"text");
+
+    cursor.holdUndoGroup(true);
+    type(cursor, u"1");
+    cursor.moveToEndOfLine();
+    type(cursor, u"2");
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"text"));
+
+    type(cursor, u"3");
+    cursor.moveToStartOfLine();
+    type(cursor, u"4");
+    cursor.holdUndoGroup(false);
+    CHECK(cursor.getText() == std::u16string(u"43text"));
+
+    REQUIRE(undoStep(cursor));
+    CHECK(cursor.getText() == std::u16string(u"text"));
+    CHECK_FALSE(undoStep(cursor));
+}
+
+TEST_CASE("a checkpoint of a group that keeps growing is never restored") {
+    auto cursor = Cursor(std::make_unique<LineBuffer>());
+    seed(cursor, u"root");
+    appendLines(cursor, 20, false);
+
+    // The checkpoint is due while the held group is open, and the group grows past it
+    cursor.holdUndoGroup(true);
+    appendAsNewGroup(cursor, u" a");
+    cursor.checkpointHistory();
+    appendAsNewGroup(cursor, u" b");
+    cursor.holdUndoGroup(false);
+    const auto held = cursor.getText();
+
+    appendLines(cursor, 3, false);
+    REQUIRE(cursor.undoSteps(3).has_value());
+    CHECK(cursor.getText() == held);
+}